@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "QtCore/QString"
 
 #include "boost/bind.hpp"
@@ -32,8 +36,8 @@ ABTracker::ABTracker(Controller& controller, Logger::Log& log) :
     coastRotationCount_(
         Parameter::DoubleValue::Make("coastRotationCount", "Max Track Coast Rotations", kDefaultCoastRotationCount)),
     minRange_(Parameter::DoubleValue::Make("minRange", "Minimum Range", kDefaultMinRange)),
-    reset_(Parameter::NotificationValue::Make("reset", "Reset", 0)), trackIdGenerator_(), tracks_(), trackCount_(0),
-    initiatingCount_(0), coastingCount_(0)
+    reset_(Parameter::NotificationValue::Make("reset", "Reset", 0)), trackIdGenerator_(), pool_(), updated_(),
+    free_(), active_(), plots_(), found_(), grid_(), assignment_(), initiatingCount_(0), coastingCount_(0)
 {
     associationRadius2_ = associationRadius_->getValue();
     associationRadius2_ *= associationRadius2_;
@@ -63,14 +67,12 @@ ABTracker::shutdown()
 void
 ABTracker::resetTracker()
 {
-    while (trackCount_) {
-        Track* track = tracks_.back();
-        track->drop();
-        delete track;
-        tracks_.pop_back();
-        --trackCount_;
-    }
+    for (size_t index = 0; index < active_.size(); ++index) pool_[active_[index]].drop();
 
+    pool_.clear();
+    updated_.clear();
+    free_.clear();
+    active_.clear();
     initiatingCount_ = 0;
     coastingCount_ = 0;
 }
@@ -78,88 +80,180 @@ ABTracker::resetTracker()
 bool
 ABTracker::processInput(const Messages::Extractions::Ref& msg)
 {
-    Logger::ProcLog log("processInput", getLog());
-    LOGINFO << std::endl;
+    static Logger::ProcLog log("processInput", getLog());
+    LOGINFO << "plots: " << msg->size() << " tracks: " << active_.size() << std::endl;
 
-    // For each Extraction report in the message call updateTracks.
+    if (!msg->size()) return true;
+
+    // Collect the plots that may be associated, and the time span of the message.
     //
-    bool ok = true;
+    double earliest = std::numeric_limits<double>::max();
+    double latest = -earliest;
+    plots_.clear();
     for (size_t index = 0; index < msg->size(); ++index) {
-        if (!updateTracks(msg[index])) ok = false;
+        const Messages::Extraction& plot(msg[index]);
+        double when = plot.getWhen().asDouble();
+        LOGDEBUG << "when: " << when << " range: " << plot.getRange() << " az: " << plot.getAzimuth() << std::endl;
+        earliest = std::min(earliest, when);
+        latest = std::max(latest, when);
+        if (plot.getRange() >= minRange_->getValue()) {
+            plots_.push_back(Plot(when, Geometry::Vector(plot.getX(), plot.getY(), plot.getElevation())));
+        }
     }
 
-    return ok;
+    // Tracks that have timed out by the first plot do not take part in association. Those that time out by the
+    // last plot get dropped below.
+    //
+    ageTracks(earliest);
+    if (!plots_.empty()) associatePlots(earliest);
+    ageTracks(latest);
+
+    return emitAndPrune();
 }
 
-bool
-ABTracker::updateTracks(const Messages::Extraction& plot)
-{
-    Logger::ProcLog log("updateTracks", getLog());
-    double when = plot.getWhen().asDouble();
-
-    LOGINFO << "when: " << when << " range: " << plot.getRange() << " az: " << plot.getAzimuth() << std::endl;
-
-    Track* found = 0;
-    if (plot.getRange() >= minRange_->getValue()) {
-        // We only associate with something if it has a proximity value smaller
-        // than associationRadius. We use the squared variants to save us from
-        // the costly square root.
-        //
-        double best = associationRadius2_;
-        Geometry::Vector v(plot.getX(), plot.getY(), plot.getElevation());
-
-        // Visit all of the existing Track objects to find the one that best
-        // associates with the given Extraction plot.
-        //
-        TrackList::iterator pos = tracks_.begin();
-        TrackList::iterator end = tracks_.end();
-        while (pos != end) {
-            Track* track = *pos++;
-            double distance = track->getProximityTo(when, v);
-            if (distance < best) {
-                found = track;
-                best = distance;
-            }
-        }
+void
+ABTracker::ageTracks(double when)
+{
+    for (size_t index = 0; index < active_.size(); ++index) pool_[active_[index]].updateState(when);
+}
 
-        // None found, so create a new Track object that starts in the
-        // kInitiating state.
-        //
-        if (!found) {
-            found = new Track(*this, ++trackIdGenerator_, when, v);
-            LOGINFO << "created new track - " << found->getId() << std::endl;
-            tracks_.push_back(found);
-            ++trackCount_;
-        } else {
-            LOGINFO << "found existing track - " << found->getId() << std::endl;
-
-            // Apply the Extraction plot to the found track
-            //
-            found->updatePosition(when, v);
-        }
+void
+ABTracker::associatePlots(double when)
+{
+    static Logger::ProcLog log("associatePlots", getLog());
+
+    // Building the grid costs about as much as visiting every track for a handful of plots, so only use it when
+    // there are more plots than that.
+    //
+    static const size_t kMinPlotsForGrid = 16;
+
+    assignment_.reset(active_.size());
+    if (plots_.size() < kMinPlotsForGrid) {
+        findCandidatesLinear();
+    } else {
+        findCandidatesGrid(when);
+    }
+
+    assignment_.solve();
+
+    // Apply plots to their assigned tracks. Do this before creating new tracks, since growing the pool may move
+    // the existing Track objects.
+    //
+    for (size_t index = 0; index < plots_.size(); ++index) {
+        int slot = assignment_.getAssignment(index);
+        if (slot == Assignment::kUnassigned) continue;
+        size_t poolIndex = active_[slot];
+        Track& track(pool_[poolIndex]);
+        LOGINFO << "found existing track - " << track.getId() << std::endl;
+        track.updatePosition(plots_[index].when, plots_[index].position);
+        updated_[poolIndex] = 1;
     }
 
-    // Revisit all of the tracks, emitting TSPI messages for those that are
-    // dropping and the one that was updated above.
+    // None found, so create a new Track object that starts in the kInitiating state.
+    //
+    for (size_t index = 0; index < plots_.size(); ++index) {
+        if (assignment_.getAssignment(index) != Assignment::kUnassigned) continue;
+        size_t poolIndex = makeTrack(plots_[index].when, plots_[index].position);
+        LOGINFO << "created new track - " << pool_[poolIndex].getId() << std::endl;
+        updated_[poolIndex] = 1;
+    }
+}
+
+void
+ABTracker::findCandidatesLinear()
+{
+    for (size_t index = 0; index < plots_.size(); ++index) {
+        assignment_.addRow();
+        for (size_t slot = 0; slot < active_.size(); ++slot) addCandidate(slot, plots_[index]);
+    }
+}
+
+void
+ABTracker::findCandidatesGrid(double when)
+{
+    // Place the predicted position of each track at the given time into the grid, and record the fastest track
+    // speed so that queries for later plots can widen their search by the distance a track could have moved.
+    //
+    double radius = std::sqrt(associationRadius2_);
+    double maxSpeed = 0.0;
+    grid_.rebuild(radius);
+    for (size_t slot = 0; slot < active_.size(); ++slot) {
+        const Track& track(pool_[active_[slot]]);
+        if (!track.isAssociable()) continue;
+        Geometry::Vector position = track.getPredictedPosition(when);
+        grid_.add(slot, position.getX(), position.getY());
+        const Geometry::Vector& velocity = track.getVelocity();
+        maxSpeed = std::max(maxSpeed, std::sqrt(velocity.getX() * velocity.getX() + velocity.getY() * velocity.getY()));
+    }
+
+    grid_.sort();
+
+    for (size_t index = 0; index < plots_.size(); ++index) {
+        const Plot& plot(plots_[index]);
+        assignment_.addRow();
+        found_.clear();
+        grid_.find(plot.position.getX(), plot.position.getY(), radius + maxSpeed * (plot.when - when), found_);
+        for (size_t pos = 0; pos < found_.size(); ++pos) addCandidate(found_[pos], plot);
+    }
+}
+
+void
+ABTracker::addCandidate(size_t slot, const Plot& plot)
+{
+    // We only associate with something if it has a proximity value smaller than associationRadius. We use the
+    // squared variants to save us from the costly square root.
+    //
+    double distance = pool_[active_[slot]].getProximityTo(plot.when, plot.position);
+    if (distance < associationRadius2_) assignment_.addCandidate(slot, associationRadius2_ - distance);
+}
+
+size_t
+ABTracker::makeTrack(double when, const Geometry::Vector& pos)
+{
+    size_t poolIndex;
+    if (!free_.empty()) {
+        poolIndex = free_.back();
+        free_.pop_back();
+        pool_[poolIndex].reinitialize(++trackIdGenerator_, when, pos);
+    } else {
+        poolIndex = pool_.size();
+        pool_.push_back(Track(*this, ++trackIdGenerator_, when, pos));
+        updated_.push_back(0);
+    }
+
+    active_.push_back(poolIndex);
+    return poolIndex;
+}
+
+bool
+ABTracker::emitAndPrune()
+{
+    static Logger::ProcLog log("emitAndPrune", getLog());
+
+    // Visit all of the tracks, emitting TSPI messages for those that are dropping and those that were updated
+    // above. Dropped tracks and those that failed to initiate go back to the pool. Compact the active list in
+    // place so that tracks stay in creation order.
     //
     bool ok = true;
-    TrackList::iterator pos = tracks_.begin();
-    TrackList::iterator end = tracks_.end();
-    while (pos != end) {
-        Track* track = *pos;
-        if (track == found || track->isDropping()) {
-            if (!track->emitPosition()) ok = false;
-            if (track->isDropping()) {
-                LOGINFO << "dropping track " << track->getId() << std::endl;
-                delete track;
-                pos = tracks_.erase(pos);
-                --trackCount_;
-                continue;
-            }
+    size_t kept = 0;
+    for (size_t index = 0; index < active_.size(); ++index) {
+        size_t poolIndex = active_[index];
+        Track& track(pool_[poolIndex]);
+        if (updated_[poolIndex] || track.isDropping()) {
+            updated_[poolIndex] = 0;
+            if (!track.emitPosition()) ok = false;
         }
-        ++pos;
+
+        if (track.isDropping() || track.isUninitiating()) {
+            LOGINFO << "dropping track " << track.getId() << std::endl;
+            free_.push_back(poolIndex);
+            continue;
+        }
+
+        active_[kept++] = poolIndex;
     }
 
+    active_.resize(kept);
     return ok;
 }
 
@@ -169,7 +263,7 @@ ABTracker::setInfoSlots(IO::StatusBase& status)
     status.setSlot(kEnabled, enabled_->getValue());
     status.setSlot(kAlpha, alpha_->getValue());
     status.setSlot(kBeta, beta_->getValue());
-    status.setSlot(kTrackCount, int(trackCount_));
+    status.setSlot(kTrackCount, int(active_.size()));
 }
 
 void
@@ -1,20 +1,29 @@
 #ifndef SIDECAR_ALGORITHMS_ABTRACKER_H // -*- C++ -*-
 #define SIDECAR_ALGORITHMS_ABTRACKER_H
 
-#include <list>
+#include <vector>
 
 #include "Algorithms/Algorithm.h"
 #include "Messages/Extraction.h"
 #include "Parameter/Parameter.h"
 
+#include "Assignment.h"
+#include "Track.h"
+#include "TrackGrid.h"
+
 namespace SideCar {
 namespace Algorithms {
-namespace ABTrackerUtils {
-class Track;
-}
 
-/** Documentation for the algorithm ABTracker. Please describe what the algorithm does, in layman's terms and,
-    if possible, mathematical terms.
+/** Simple alpha-beta tracker. Each Extraction plot is associated with the track whose predicted position is
+    closest, provided it lies within associationRadius; unassociated plots start new tracks.
+
+    Association is done for all of the plots of an Extractions message at once. Track predictions are placed in
+    a uniform grid (ABTrackerUtils::TrackGrid) with cells the size of the association gate, so each plot only
+    checks the tracks in nearby cells. The gated plot/track pairs then go to ABTrackerUtils::Assignment, which
+    finds the global nearest-neighbour (GNN) assignment so that a track takes at most one plot per message and
+    the total squared distance is minimized.
+
+    Track objects live in a contiguous pool; dropped tracks are recycled without releasing their memory.
 */
 class ABTracker : public Algorithm {
     using Super = Algorithm;
@@ -99,8 +108,67 @@ public:
 
     double getScaledMaxCoastDuration() const { return scaledMaxCoastDuration_; }
 
+    /** \return number of tracks currently held by the tracker
+     */
+    size_t getTrackCount() const { return active_.size(); }
+
 private:
-    bool updateTracks(const Messages::Extraction& plot);
+    /** Plot information used during association.
+     */
+    struct Plot {
+        Plot(double w, const Geometry::Vector& p) : when(w), position(p) {}
+        double when;
+        Geometry::Vector position;
+    };
+
+    /** Update the state of all tracks for the given time.
+
+        \param when the time to use
+    */
+    void ageTracks(double when);
+
+    /** Associate the plots in plots_ with existing tracks, updating the tracks that received a plot and creating
+        new tracks for the rest.
+
+        \param when earliest plot time
+    */
+    void associatePlots(double when);
+
+    /** Gather the gated candidate tracks for all plots into assignment_ by visiting every track. Cheaper than
+        building the grid when there are few plots.
+    */
+    void findCandidatesLinear();
+
+    /** Gather the gated candidate tracks for all plots into assignment_ using the track grid.
+
+        \param when time used to place track predictions in the grid
+    */
+    void findCandidatesGrid(double when);
+
+    /** Determine the proximity of a plot to a track, and add the track as a candidate for the plot if it is
+        within the association gate.
+
+        \param slot index of the track in active_
+
+        \param plot the plot to check
+    */
+    void addCandidate(size_t slot, const Plot& plot);
+
+    /** Obtain a Track from the pool, creating a new one if necessary, and add it to the active list.
+
+        \param when time of creation
+
+        \param pos initial position of the track
+
+        \return pool index of the new track
+    */
+    size_t makeTrack(double when, const Geometry::Vector& pos);
+
+    /** Emit TSPI messages for updated and dropping tracks, and return dropped tracks to the pool.
+
+        \return true if successful
+    */
+    bool emitAndPrune();
 
     size_t getNumInfoSlots() const { return kNumSlots; }
 
@@ -140,9 +208,15 @@ private:
 
     double associationRadius2_;
     uint32_t trackIdGenerator_;
-    using TrackList = std::list<ABTrackerUtils::Track*>;
-    TrackList tracks_;
-    size_t trackCount_;
+
+    std::vector<ABTrackerUtils::Track> pool_; ///< Storage for all Track objects
+    std::vector<char> updated_;               ///< Flag for each pool entry set when the track gets a plot
+    std::vector<size_t> free_;                ///< Pool indices available for reuse
+    std::vector<size_t> active_;              ///< Pool indices of live tracks in creation order
+    std::vector<Plot> plots_;
+    std::vector<size_t> found_;
+    ABTrackerUtils::TrackGrid grid_;
+    ABTrackerUtils::Assignment assignment_;
     size_t initiatingCount_;
     size_t coastingCount_;
 
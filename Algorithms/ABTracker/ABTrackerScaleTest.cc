@@ -0,0 +1,160 @@
+#include "ace/Event_Handler.h"
+#include "ace/Reactor.h"
+
+#include "Algorithms/Controller.h"
+#include "IO/MessageManager.h"
+#include "IO/Stream.h"
+#include "Logger/Log.h"
+#include "Messages/Extraction.h"
+#include "Messages/TSPI.h"
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+#include "Utils/Utils.h"
+
+#include "ABTracker.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms;
+using namespace SideCar::IO;
+using namespace SideCar::Messages;
+
+/** Scaling test for the ABTracker. Maintains kNumRanges * kNumAzimuths simultaneous targets over kNumScans
+    scans, each scan delivering one Extractions message per azimuth. Targets are spaced well beyond the
+    association radius and move outward a little each scan, so every target must stay on its own track.
+*/
+enum {
+    kNumRanges = 100,
+    kNumAzimuths = 100,
+    kNumTargets = kNumRanges * kNumAzimuths,
+    kNumScans = 5,
+    kInitiationCount = 2,
+    kExpectedReports = kNumTargets * (kNumScans - kInitiationCount + 1)
+};
+
+struct WatchdogTimer : public ACE_Event_Handler {
+    WatchdogTimer();
+    int handle_timeout(const ACE_Time_Value&, const void*)
+    {
+        reactor()->end_reactor_event_loop();
+        return 0;
+    }
+};
+
+WatchdogTimer::WatchdogTimer() : ACE_Event_Handler(ACE_Reactor::instance())
+{
+    const ACE_Time_Value delay(120);
+    reactor()->schedule_timer(this, 0, delay);
+}
+
+/** Task that counts the TSPI messages emitted by the tracker.
+ */
+struct Sink : public Task {
+    using Ref = boost::shared_ptr<Sink>;
+
+    Sink() : Task(true), reports_(0), dropping_(0) {}
+
+    bool deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout);
+
+    size_t reports_;
+    size_t dropping_;
+};
+
+bool
+Sink::deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout)
+{
+    MessageManager mgr(data);
+    if (mgr.hasNative() && mgr.getNativeMessageType() == MetaTypeInfo::Value::kTSPI) {
+        TSPI::Ref msg(mgr.getNative<TSPI>());
+        if (msg->isDropping()) ++dropping_;
+        if (++reports_ == kExpectedReports) ACE_Reactor::instance()->end_reactor_event_loop();
+    }
+
+    return true;
+}
+
+struct Test : public UnitTest::TestObj {
+    Test() : UnitTest::TestObj("ABTrackerScale"), controller_() {}
+
+    void test();
+
+    void generateInput();
+
+    Controller::Ref controller_;
+};
+
+void
+Test::test()
+{
+    Logger::Log::Root().setPriorityLimit(Logger::Priority::kError);
+
+    Stream::Ref stream(Stream::Make("test"));
+
+    TModule<Sink>* ctm = new TModule<Sink>(stream);
+    assertEqual(0, stream->push(ctm));
+    Sink::Ref sink = ctm->getTask();
+    sink->setTaskName("Sink");
+    sink->setTaskIndex(1);
+
+    ControllerModule* controllerMod = new ControllerModule(stream);
+    assertEqual(0, stream->push(controllerMod));
+    controller_ = controllerMod->getTask();
+    controller_->setTaskIndex(0);
+
+    sink->addInputChannel(Channel("input", "TSPI"));
+    controller_->addOutputChannel(Channel("output", "TSPI", sink));
+    controller_->addInputChannel(Channel("input", "Extractions"));
+
+    assertTrue(controller_->openAndInit("ABTracker"));
+    assertTrue(controller_->injectProcessingStateChange(ProcessingState::kRun));
+    ABTracker* alg = dynamic_cast<ABTracker*>(controller_->getAlgorithm());
+
+    alg->setRotationDuration(1.0);
+    alg->setTimeScaling(1.0);
+    alg->setInitiationCount(kInitiationCount);
+    alg->setAssociationRadius(0.5);
+    alg->setCoastRotationCount(3.0);
+    alg->setMinRange(0.0);
+    alg->setAlpha(1.0);
+    alg->setBeta(0.0);
+
+    Time::TimeStamp begin(Time::TimeStamp::Now());
+    generateInput();
+
+    new WatchdogTimer;
+    ACE_Reactor::instance()->run_reactor_event_loop();
+
+    Time::TimeStamp delta(Time::TimeStamp::Now());
+    delta -= begin;
+
+    std::clog << "tracks: " << alg->getTrackCount() << " plots: " << kNumTargets * kNumScans
+              << " duration: " << delta.asDouble() << " seconds"
+              << " plots/sec: " << kNumTargets * kNumScans / delta.asDouble() << std::endl;
+
+    assertEqual(size_t(kNumTargets), alg->getTrackCount());
+    assertEqual(size_t(kExpectedReports), sink->reports_);
+    assertEqual(size_t(0), sink->dropping_);
+}
+
+void
+Test::generateInput()
+{
+    for (int scan = 0; scan < kNumScans; ++scan) {
+        for (int azimuthIndex = 0; azimuthIndex < kNumAzimuths; ++azimuthIndex) {
+            double when = scan + double(azimuthIndex) / kNumAzimuths;
+            double azimuth = Utils::degreesToRadians(360.0 * azimuthIndex / kNumAzimuths);
+            Extractions::Ref msg(Extractions::Make("test", Header::Ref()));
+            for (int rangeIndex = 0; rangeIndex < kNumRanges; ++rangeIndex) {
+                double range = 60.0 + 2.0 * rangeIndex + 0.1 * scan;
+                msg->push_back(Extraction(when, range, azimuth, 0.0));
+            }
+
+            assertTrue(controller_->putInChannel(msg, 0));
+        }
+    }
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return Test().mainRun();
+}
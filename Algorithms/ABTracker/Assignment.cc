@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <limits>
+
+#include "Assignment.h"
+
+using namespace SideCar::Algorithms::ABTrackerUtils;
+
+Assignment::Assignment() :
+    candidateBegin_(1, 0), candidateColumns_(), candidateBenefits_(), assignments_(), parents_(), clusterRows_(),
+    localColumns_(), clusterColumns_(), costs_(), u_(), v_(), minValues_(), matches_(), way_(), used_()
+{
+    ;
+}
+
+void
+Assignment::reset(size_t numColumns)
+{
+    candidateBegin_.resize(1);
+    candidateColumns_.clear();
+    candidateBenefits_.clear();
+    assignments_.clear();
+    parents_.resize(numColumns);
+    for (size_t index = 0; index < numColumns; ++index) parents_[index] = index;
+    localColumns_.assign(numColumns, -1);
+}
+
+size_t
+Assignment::addRow()
+{
+    assignments_.push_back(kUnassigned);
+    candidateBegin_.push_back(candidateColumns_.size());
+    return assignments_.size() - 1;
+}
+
+void
+Assignment::addCandidate(size_t column, double benefit)
+{
+    candidateColumns_.push_back(column);
+    candidateBenefits_.push_back(benefit);
+    candidateBegin_.back() = candidateColumns_.size();
+}
+
+size_t
+Assignment::findRoot(size_t column)
+{
+    while (parents_[column] != column) {
+        parents_[column] = parents_[parents_[column]];
+        column = parents_[column];
+    }
+
+    return column;
+}
+
+void
+Assignment::solve()
+{
+    // Join all of the candidate columns of a row into one cluster.
+    //
+    size_t numRows = assignments_.size();
+    for (size_t row = 0; row < numRows; ++row) {
+        size_t begin = candidateBegin_[row];
+        size_t end = candidateBegin_[row + 1];
+        if (begin == end) continue;
+        size_t root = findRoot(candidateColumns_[begin]);
+        for (size_t index = begin + 1; index < end; ++index) {
+            size_t other = findRoot(candidateColumns_[index]);
+            if (other != root) parents_[other] = root;
+        }
+    }
+
+    // Group the rows by cluster.
+    //
+    clusterRows_.clear();
+    for (size_t row = 0; row < numRows; ++row) {
+        if (candidateBegin_[row] == candidateBegin_[row + 1]) continue;
+        clusterRows_.push_back(std::make_pair(findRoot(candidateColumns_[candidateBegin_[row]]), row));
+    }
+
+    std::sort(clusterRows_.begin(), clusterRows_.end());
+
+    for (size_t begin = 0; begin < clusterRows_.size();) {
+        size_t end = begin + 1;
+        while (end < clusterRows_.size() && clusterRows_[end].first == clusterRows_[begin].first) ++end;
+        solveCluster(begin, end);
+        begin = end;
+    }
+}
+
+void
+Assignment::solveCluster(size_t begin, size_t end)
+{
+    // A lone row takes its best candidate.
+    //
+    if (end - begin == 1) {
+        size_t row = clusterRows_[begin].second;
+        size_t best = candidateBegin_[row];
+        for (size_t index = best + 1; index < candidateBegin_[row + 1]; ++index) {
+            if (candidateBenefits_[index] > candidateBenefits_[best]) best = index;
+        }
+
+        assignments_[row] = candidateColumns_[best];
+        return;
+    }
+
+    // Number the columns of the cluster.
+    //
+    clusterColumns_.clear();
+    double maxBenefit = 0.0;
+    for (size_t index = begin; index < end; ++index) {
+        size_t row = clusterRows_[index].second;
+        for (size_t pos = candidateBegin_[row]; pos < candidateBegin_[row + 1]; ++pos) {
+            size_t column = candidateColumns_[pos];
+            if (localColumns_[column] == -1) {
+                localColumns_[column] = clusterColumns_.size();
+                clusterColumns_.push_back(column);
+            }
+
+            maxBenefit = std::max(maxBenefit, candidateBenefits_[pos]);
+        }
+    }
+
+    // Build a dense cost matrix of n rows and m = columns + n columns. Column m - n + r is the 'unassigned'
+    // option for row r, which costs zero; candidates cost -benefit, and everything else costs more than any
+    // assignment could ever save.
+    //
+    size_t n = end - begin;
+    size_t numReal = clusterColumns_.size();
+    size_t m = numReal + n;
+    double forbidden = maxBenefit * (n + 1) + 1.0;
+    costs_.assign((n + 1) * (m + 1), forbidden);
+    for (size_t index = 0; index < n; ++index) {
+        size_t row = clusterRows_[begin + index].second;
+        double* costs = &costs_[(index + 1) * (m + 1)];
+        for (size_t pos = candidateBegin_[row]; pos < candidateBegin_[row + 1]; ++pos) {
+            costs[localColumns_[candidateColumns_[pos]] + 1] = -candidateBenefits_[pos];
+        }
+
+        costs[numReal + index + 1] = 0.0;
+    }
+
+    // Hungarian algorithm with row and column potentials (u_ and v_). Each iteration adds one row and finds the
+    // shortest augmenting path for it. Indices are 1-based; column 0 is a sentinel.
+    //
+    static const double kInfinity = std::numeric_limits<double>::max();
+    u_.assign(n + 1, 0.0);
+    v_.assign(m + 1, 0.0);
+    matches_.assign(m + 1, 0);
+    way_.assign(m + 1, 0);
+    for (size_t i = 1; i <= n; ++i) {
+        matches_[0] = i;
+        size_t j0 = 0;
+        minValues_.assign(m + 1, kInfinity);
+        used_.assign(m + 1, 0);
+        do {
+            used_[j0] = 1;
+            size_t i0 = matches_[j0];
+            double delta = kInfinity;
+            size_t j1 = 0;
+            const double* costs = &costs_[i0 * (m + 1)];
+            for (size_t j = 1; j <= m; ++j) {
+                if (used_[j]) continue;
+                double value = costs[j] - u_[i0] - v_[j];
+                if (value < minValues_[j]) {
+                    minValues_[j] = value;
+                    way_[j] = j0;
+                }
+
+                if (minValues_[j] < delta) {
+                    delta = minValues_[j];
+                    j1 = j;
+                }
+            }
+
+            for (size_t j = 0; j <= m; ++j) {
+                if (used_[j]) {
+                    u_[matches_[j]] += delta;
+                    v_[j] -= delta;
+                } else {
+                    minValues_[j] -= delta;
+                }
+            }
+
+            j0 = j1;
+        } while (matches_[j0] != 0);
+
+        do {
+            size_t j1 = way_[j0];
+            matches_[j0] = matches_[j1];
+            j0 = j1;
+        } while (j0);
+    }
+
+    // Record the assignments, and restore the column mapping for the next cluster.
+    //
+    for (size_t j = 1; j <= numReal; ++j) {
+        if (!matches_[j]) continue;
+        size_t row = clusterRows_[begin + matches_[j] - 1].second;
+        size_t column = clusterColumns_[j - 1];
+
+        // Never accept a forbidden pairing (only possible with degenerate inputs).
+        //
+        if (costs_[matches_[j] * (m + 1) + j] < 0.0) assignments_[row] = column;
+    }
+
+    for (size_t index = 0; index < numReal; ++index) localColumns_[clusterColumns_[index]] = -1;
+}
@@ -0,0 +1,98 @@
+#ifndef SIDECAR_ALGORITHMS_ABTRACKERUTILS_ASSIGNMENT_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_ABTRACKERUTILS_ASSIGNMENT_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace SideCar {
+namespace Algorithms {
+namespace ABTrackerUtils {
+
+/** Solver for the sparse assignment problem used to associate plots with tracks. Each row (plot) has a list of
+    candidate columns (tracks) with a positive benefit for each; a row may also remain unassigned for a benefit
+    of zero. solve() finds an assignment of rows to distinct columns that maximizes the total benefit, which for
+    benefit = gate^2 - distance^2 gives the global nearest-neighbour (GNN) association.
+
+    Rows are first split into clusters that share candidate columns. A cluster with one row simply takes its
+    best candidate; larger clusters are solved exactly with the Hungarian (Kuhn-Munkres) algorithm on a small
+    dense cost matrix. Since gated clusters are small, this is close to linear in the number of rows. All
+    working storage is kept between calls, so once it has grown to its working size, setting up and solving a
+    problem does no memory allocation.
+*/
+class Assignment {
+public:
+    enum { kUnassigned = -1 };
+
+    /** Constructor.
+     */
+    Assignment();
+
+    /** Start a new assignment problem.
+
+        \param numColumns number of columns that rows may be assigned to
+    */
+    void reset(size_t numColumns);
+
+    /** Start the candidate list of the next row. Rows are numbered in the order of the calls to addRow(),
+        starting from zero.
+
+        \return index of the new row
+    */
+    size_t addRow();
+
+    /** Add a candidate column for the last row added with addRow().
+
+        \param column index of the column
+
+        \param benefit value of the assignment. Must be greater than zero.
+    */
+    void addCandidate(size_t column, double benefit);
+
+    /** Solve the assignment problem.
+     */
+    void solve();
+
+    /** \return number of rows in the problem
+     */
+    size_t getNumRows() const { return assignments_.size(); }
+
+    /** Obtain the column assigned to a row after solve().
+
+        \param row index of the row to query
+
+        \return column index or kUnassigned
+    */
+    int getAssignment(size_t row) const { return assignments_[row]; }
+
+private:
+    size_t findRoot(size_t column);
+
+    /** Solve one cluster of rows.
+
+        \param begin index into clusterRows_ of the first row of the cluster
+
+        \param end index into clusterRows_ one past the last row of the cluster
+    */
+    void solveCluster(size_t begin, size_t end);
+
+    std::vector<size_t> candidateBegin_;
+    std::vector<size_t> candidateColumns_;
+    std::vector<double> candidateBenefits_;
+    std::vector<int> assignments_;
+
+    std::vector<size_t> parents_;                        ///< Union-find forest over the columns
+    std::vector<std::pair<size_t, size_t>> clusterRows_; ///< (cluster root, row) for rows with candidates
+    std::vector<int> localColumns_;                      ///< Column -> index in cluster matrix; -1 if none
+    std::vector<size_t> clusterColumns_;                 ///< Cluster matrix index -> column
+    std::vector<double> costs_;                          ///< Dense cluster cost matrix (1-based, row-major)
+    std::vector<double> u_, v_, minValues_;
+    std::vector<size_t> matches_, way_;
+    std::vector<char> used_;
+};
+
+} // end namespace ABTrackerUtils
+} // end namespace Algorithms
+} // end namespace SideCar
+
+#endif
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "UnitTest/UnitTest.h"
+
+#include "Assignment.h"
+#include "TrackGrid.h"
+
+using namespace SideCar::Algorithms::ABTrackerUtils;
+
+struct Test : public UnitTest::TestObj {
+    Test() : UnitTest::TestObj("Assignment") {}
+    void test();
+    void testSimple();
+    void testRandom();
+    void testGrid();
+    void testGridWideQuery();
+
+    /** Exhaustively find the best total benefit for a dense benefit table where 0 means 'not a candidate'.
+     */
+    static double BruteForce(const std::vector<std::vector<double>>& benefits, size_t row, std::vector<char>& used);
+};
+
+double
+Test::BruteForce(const std::vector<std::vector<double>>& benefits, size_t row, std::vector<char>& used)
+{
+    if (row == benefits.size()) return 0.0;
+    double best = BruteForce(benefits, row + 1, used);
+    for (size_t column = 0; column < used.size(); ++column) {
+        if (used[column] || benefits[row][column] <= 0.0) continue;
+        used[column] = 1;
+        best = std::max(best, benefits[row][column] + BruteForce(benefits, row + 1, used));
+        used[column] = 0;
+    }
+
+    return best;
+}
+
+void
+Test::testSimple()
+{
+    Assignment a;
+
+    // Greedy would give row 0 column 0 (benefit 10) and leave row 1 with nothing. GNN does better.
+    //
+    a.reset(2);
+    a.addRow();
+    a.addCandidate(0, 10.0);
+    a.addCandidate(1, 9.0);
+    a.addRow();
+    a.addCandidate(0, 8.0);
+    a.addRow(); // No candidates
+    a.solve();
+    assertEqual(1, a.getAssignment(0));
+    assertEqual(0, a.getAssignment(1));
+    assertEqual(int(Assignment::kUnassigned), a.getAssignment(2));
+
+    // Two rows wanting the same lone column: the better one wins.
+    //
+    a.reset(1);
+    a.addRow();
+    a.addCandidate(0, 1.0);
+    a.addRow();
+    a.addCandidate(0, 2.0);
+    a.solve();
+    assertEqual(int(Assignment::kUnassigned), a.getAssignment(0));
+    assertEqual(0, a.getAssignment(1));
+}
+
+void
+Test::testRandom()
+{
+    ::srand(1234);
+    Assignment a;
+    for (int trial = 0; trial < 500; ++trial) {
+        size_t numRows = 1 + ::rand() % 6;
+        size_t numColumns = 1 + ::rand() % 6;
+        std::vector<std::vector<double>> benefits(numRows, std::vector<double>(numColumns, 0.0));
+        a.reset(numColumns);
+        for (size_t row = 0; row < numRows; ++row) {
+            a.addRow();
+            for (size_t column = 0; column < numColumns; ++column) {
+                if (::rand() % 3 == 0) continue;
+                benefits[row][column] = 1 + ::rand() % 100;
+                a.addCandidate(column, benefits[row][column]);
+            }
+        }
+
+        a.solve();
+
+        // Assignments must be to distinct candidate columns, and the total must be optimal.
+        //
+        double total = 0.0;
+        std::vector<char> used(numColumns, 0);
+        for (size_t row = 0; row < numRows; ++row) {
+            int column = a.getAssignment(row);
+            if (column == Assignment::kUnassigned) continue;
+            assertFalse(used[column]);
+            assertTrue(benefits[row][column] > 0.0);
+            used[column] = 1;
+            total += benefits[row][column];
+        }
+
+        std::fill(used.begin(), used.end(), 0);
+        assertEqual(BruteForce(benefits, 0, used), total);
+    }
+}
+
+void
+Test::testGrid()
+{
+    TrackGrid grid;
+    grid.rebuild(10.0);
+    grid.add(0, 0.0, 0.0);
+    grid.add(1, 15.0, -5.0);
+    grid.add(2, -25.0, 0.0);
+    grid.add(3, 100.0, 100.0);
+    grid.sort();
+    assertEqual(size_t(4), grid.size());
+
+    std::vector<size_t> found;
+    grid.find(1.0, 1.0, 10.0, found);
+    std::sort(found.begin(), found.end());
+    assertEqual(size_t(2), found.size());
+    assertEqual(size_t(0), found[0]);
+    assertEqual(size_t(1), found[1]);
+
+    found.clear();
+    grid.find(-20.0, 0.0, 1.0, found);
+    assertEqual(size_t(1), found.size());
+    assertEqual(size_t(2), found[0]);
+
+    found.clear();
+    grid.find(50.0, 50.0, 5.0, found);
+    assertEqual(size_t(0), found.size());
+}
+
+void
+Test::testGridWideQuery()
+{
+    // A track with an absurd velocity places an item near the clamp limit and makes the query radius huge. The
+    // find() must finish promptly (it used to walk every column between the clamped limits) and still honor the
+    // Y range of the query.
+    //
+    TrackGrid grid;
+    grid.rebuild(1.0);
+    grid.add(0, 0.0, 0.0);
+    grid.add(1, 5000.0, 2.0);
+    grid.add(2, 2500.0, 4000.0);
+    grid.add(3, 1.0e12, -1.0);
+    grid.sort();
+
+    std::vector<size_t> found;
+    grid.find(0.0, 0.0, 1.0e15, found);
+    std::sort(found.begin(), found.end());
+    assertEqual(size_t(4), found.size());
+
+    found.clear();
+    grid.find(2500.0, 0.0, 2500.0, found);
+    std::sort(found.begin(), found.end());
+    assertEqual(size_t(2), found.size());
+    assertEqual(size_t(0), found[0]);
+    assertEqual(size_t(1), found[1]);
+
+    found.clear();
+    grid.find(0.0, 1.0e14, 1.0e13, found);
+    assertEqual(size_t(0), found.size());
+
+    found.clear();
+    grid.find(1.0e12, 0.0, 10.0, found);
+    assertEqual(size_t(1), found.size());
+    assertEqual(size_t(3), found[0]);
+}
+
+void
+Test::test()
+{
+    testSimple();
+    testRandom();
+    testGrid();
+    testGridWideQuery();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return Test().mainRun();
+}
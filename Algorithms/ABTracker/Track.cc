@@ -23,12 +23,21 @@ Track::Track(ABTracker& owner, uint32_t id, double when, const Geometry::Vector&
 {
     Logger::ProcLog log("Track", Log());
     LOGINFO << std::endl;
+    reinitialize(id, when, pos);
+}
 
+void
+Track::reinitialize(uint32_t id, double when, const Geometry::Vector& pos)
+{
     std::ostringstream os;
     os << id;
     id_ = os.str();
+    t0_ = Estimate();
     t0_.when_ = when;
     t0_.position_ = pos;
+    initialPosition_ = pos;
+    initiationTimeStamps_.clear();
+    state_ = kInitiating;
     checkIfInitiated(when);
 }
 
@@ -62,11 +71,10 @@ Track::checkIfInitiated(double when)
     }
 }
 
-double
-Track::getProximityTo(double when, const Geometry::Vector& pos)
+void
+Track::updateState(double when)
 {
-    static Logger::ProcLog log("getProximityTo", Log());
-    LOGINFO << id_ << " when: " << when << std::endl;
+    static Logger::ProcLog log("updateState", Log());
 
     // How much time has passed since the last update?
     //
@@ -85,17 +93,23 @@ Track::getProximityTo(double when, const Geometry::Vector& pos)
             state_ = kDropping;
         }
     }
+}
 
-    // If the track is not initiating or active, don't let it participate in plot association.
-    //
-    if (state_ == kDropping || state_ == kUninitiating) return std::numeric_limits<double>::max();
+double
+Track::getProximityTo(double when, const Geometry::Vector& pos)
+{
+    static Logger::ProcLog log("getProximityTo", Log());
+    LOGINFO << id_ << " when: " << when << std::endl;
 
-    // Predict track position assuming constant velocity. X1 = X0 + V0 * T
+    updateState(when);
+
+    // If the track is not initiating or active, don't let it participate in plot association.
     //
-    Geometry::Vector position = t0_.position_ + t0_.velocity_ * deltaTime;
+    if (!isAssociable()) return std::numeric_limits<double>::max();
 
     // Calculate proximity of given position to estimated position.
     //
+    Geometry::Vector position = getPredictedPosition(when);
     position -= pos;
     double value = position.getMagnitudeSquared();
 
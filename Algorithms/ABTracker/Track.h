@@ -47,6 +47,17 @@ public:
     */
     Track(ABTracker& owner, uint32_t id, double when, const Geometry::Vector& pos);
 
+    /** Reuse this object for a new track. Used by the ABTracker track pool so that dropped Track objects may be
+        recycled without any memory allocation.
+
+        \param id unique integer ID for the new track
+
+        \param when time of creation
+
+        \param pos initial position of the track
+    */
+    void reinitialize(uint32_t id, double when, const Geometry::Vector& pos);
+
     /** Obtain the track's unique ID tag
 
         \return track ID tag
@@ -64,6 +75,36 @@ public:
     */
     double getProximityTo(double when, const Geometry::Vector& pos);
 
+    /** Update the track state for the given time, moving it to kUninitiating or kDropping if too much time has
+        passed since the last update.
+
+        \param when time to check against
+    */
+    void updateState(double when);
+
+    /** Estimate the track's position at a given time, assuming constant velocity.
+
+        \param when time to use for estimation
+
+        \return estimated position
+    */
+    Geometry::Vector getPredictedPosition(double when) const
+    {
+        return t0_.position_ + t0_.velocity_ * (when - t0_.when_);
+    }
+
+    /** Obtain the current velocity estimate of the track.
+
+        \return velocity vector
+    */
+    const Geometry::Vector& getVelocity() const { return t0_.velocity_; }
+
+    /** Determine if the track may be associated with a new report (initiating or alive).
+
+        \return true if so
+    */
+    bool isAssociable() const { return state_ == kInitiating || state_ == kAlive; }
+
     /** Determine if the track is alive (not initiating and not dropping).
 
         \return true if so
@@ -76,6 +117,12 @@ public:
     */
     bool isDropping() const { return state_ == kDropping; }
 
+    /** Determine if the track failed to initiate.
+
+        \return true if so
+    */
+    bool isUninitiating() const { return state_ == kUninitiating; }
+
     /** Update the track with a new position report.
 
         \param when time associated with the new report
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "TrackGrid.h"
+
+using namespace SideCar::Algorithms::ABTrackerUtils;
+
+TrackGrid::TrackGrid() : entries_(), cellSize_(1.0)
+{
+    ;
+}
+
+void
+TrackGrid::rebuild(double cellSize)
+{
+    entries_.clear();
+    cellSize_ = cellSize > 0.0 ? cellSize : 1.0;
+}
+
+int32_t
+TrackGrid::getIndex(double value) const
+{
+    // Clamp so that wild values (eg. from a track with a bogus velocity) do not overflow the cell index.
+    //
+    static const double kLimit = std::numeric_limits<int32_t>::max() / 2;
+    double index = std::floor(value / cellSize_);
+    if (index > kLimit) return int32_t(kLimit);
+    if (index < -kLimit) return int32_t(-kLimit);
+    return int32_t(index);
+}
+
+uint64_t
+TrackGrid::MakeKey(int32_t xIndex, int32_t yIndex)
+{
+    // Bias the indices so that unsigned key order matches signed index order.
+    //
+    return (uint64_t(uint32_t(xIndex) ^ 0x80000000u) << 32) | uint64_t(uint32_t(yIndex) ^ 0x80000000u);
+}
+
+int32_t
+TrackGrid::GetXIndex(uint64_t key)
+{
+    return int32_t(uint32_t(key >> 32) ^ 0x80000000u);
+}
+
+int32_t
+TrackGrid::GetYIndex(uint64_t key)
+{
+    return int32_t(uint32_t(key) ^ 0x80000000u);
+}
+
+void
+TrackGrid::add(size_t item, double x, double y)
+{
+    entries_.push_back(Entry(MakeKey(getIndex(x), getIndex(y)), item));
+}
+
+void
+TrackGrid::sort()
+{
+    std::sort(entries_.begin(), entries_.end());
+}
+
+void
+TrackGrid::find(double x, double y, double radius, std::vector<size_t>& found) const
+{
+    if (entries_.empty()) return;
+
+    int32_t xMin = getIndex(x - radius);
+    int32_t xMax = getIndex(x + radius);
+    int32_t yMin = getIndex(y - radius);
+    int32_t yMax = getIndex(y + radius);
+
+    // Limit the column walk to the columns that actually hold items. A query with a huge radius (eg. from a track
+    // with a bogus velocity) would otherwise visit up to 2^31 empty columns.
+    //
+    xMin = std::max(xMin, GetXIndex(entries_.front().key));
+    xMax = std::min(xMax, GetXIndex(entries_.back().key));
+    if (xMin > xMax) return;
+
+    // If there are more columns to visit than there are items, a single pass over the items is cheaper than one
+    // binary search per column.
+    //
+    if (int64_t(xMax) - int64_t(xMin) >= int64_t(entries_.size())) {
+        uint64_t first = MakeKey(xMin, yMin);
+        uint64_t last = MakeKey(xMax, yMax);
+        std::vector<Entry>::const_iterator pos = std::lower_bound(entries_.begin(), entries_.end(), Entry(first, 0));
+        for (; pos != entries_.end() && pos->key <= last; ++pos) {
+            int32_t yIndex = GetYIndex(pos->key);
+            if (yIndex >= yMin && yIndex <= yMax) found.push_back(pos->item);
+        }
+        return;
+    }
+
+    for (int32_t xIndex = xMin; xIndex <= xMax; ++xIndex) {
+        uint64_t last = MakeKey(xIndex, yMax);
+        std::vector<Entry>::const_iterator pos =
+            std::lower_bound(entries_.begin(), entries_.end(), Entry(MakeKey(xIndex, yMin), 0));
+        for (; pos != entries_.end() && pos->key <= last; ++pos) found.push_back(pos->item);
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef SIDECAR_ALGORITHMS_ABTRACKERUTILS_TRACKGRID_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_ABTRACKERUTILS_TRACKGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SideCar {
+namespace Algorithms {
+namespace ABTrackerUtils {
+
+/** Uniform grid spatial index over 2-D (X/Y) positions. Items are added with rebuild() / add() / sort(), after
+    which find() returns all items that lie in grid cells overlapping a square around a query point. Results are
+    candidates only; the caller must still apply its own distance check.
+
+    The grid is stored as a single vector of (cell key, item) pairs sorted by key, so building the index and
+    querying it do no memory allocation once the vectors have grown to their working size. Cell keys order cells
+    by X index and then by Y index, so the cells of one grid column in a query are contiguous in the vector.
+*/
+class TrackGrid {
+public:
+    /** Constructor.
+     */
+    TrackGrid();
+
+    /** Forget all items, and set the size of a grid cell for the next set of items.
+
+        \param cellSize width and height of a grid cell
+    */
+    void rebuild(double cellSize);
+
+    /** Add an item to the grid. Must call sort() after the last add() and before any find().
+
+        \param item value to return from find()
+
+        \param x X coordinate of the item
+
+        \param y Y coordinate of the item
+    */
+    void add(size_t item, double x, double y);
+
+    /** Order the items by cell so that find() may locate them.
+     */
+    void sort();
+
+    /** Locate the items in the cells covered by the square centered at (x, y) with half-width radius. Items are
+        appended to the given container.
+
+        \param x X coordinate of the query point
+
+        \param y Y coordinate of the query point
+
+        \param radius half-width of the query square
+
+        \param found container to append to
+    */
+    void find(double x, double y, double radius, std::vector<size_t>& found) const;
+
+    /** \return number of items in the grid
+     */
+    size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        Entry(uint64_t k, size_t i) : key(k), item(i) {}
+        bool operator<(const Entry& rhs) const { return key < rhs.key; }
+        uint64_t key;
+        size_t item;
+    };
+
+    int32_t getIndex(double value) const;
+
+    static uint64_t MakeKey(int32_t xIndex, int32_t yIndex);
+
+    static int32_t GetXIndex(uint64_t key);
+
+    static int32_t GetYIndex(uint64_t key);
+
+    std::vector<Entry> entries_;
+    double cellSize_;
+};
+
+} // end namespace ABTrackerUtils
+} // end namespace Algorithms
+} // end namespace SideCar
+
+#endif
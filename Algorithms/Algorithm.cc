@@ -163,6 +163,12 @@ Algorithm::setAlarm(int timerSecs)
     controller_.setTimerSecs(timerSecs);
 }
 
+bool
+Algorithm::requestAlarm()
+{
+    return controller_.postAlarm();
+}
+
 void*
 Algorithm::FormatInfoValue(const QString& value)
 {
@@ -105,6 +105,14 @@ public:
     */
     Controller& getController() const { return controller_; }
 
+    /** Ask for a call to processAlarm() from the thread that processes the algorithm's messages. Unlike
+        setAlarm(), this is a one-shot request that may come from any thread, such as a worker thread of the
+        algorithm that has finished something the algorithm must emit.
+
+        \return true if successful
+    */
+    bool requestAlarm();
+
     /** Obtain the log device to use for by the algorithm for log messages.
 
         \return reference to Log device
@@ -392,6 +400,15 @@ protected:
     */
     virtual void processAlarm() {}
 
+    /** Determine if the algorithm may run as several replicas, each given a share of the PRIs (see
+        ReplicaSet). This is so if what the algorithm emits for a PRI depends only on that PRI, or on a fixed
+        number of the PRIs just before it, which the replicas obtain through the ReplicaConfig::overlap setting.
+        The default is false.
+
+        \return true if the algorithm may be replicated
+    */
+    virtual bool isReplicaSafe() const { return false; }
+
 private:
     /** Process a data message. Dispatches to the registered procedure for the given channel index.
 
@@ -123,6 +123,7 @@ CPIAlgorithm::processInput(const Messages::PRIMessage::Ref& msg)
     //
     buffer_.push_back(msg);
     if (msg->size() > maxMsgSize_) maxMsgSize_ = msg->size();
+    priBuffered(msg);
 
     return rc;
 }
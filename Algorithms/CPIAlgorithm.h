@@ -59,6 +59,13 @@ protected:
 
     virtual bool processCPI() = 0;
 
+    /** Notification that a PRI message was added to the end of buffer_. Derived classes may override to begin
+        working on a CPI before all of its PRIs have arrived. The default implementation does nothing.
+
+        \param msg the message that was added
+    */
+    virtual void priBuffered(const Messages::PRIMessage::Ref& msg) {}
+
 private:
     virtual bool cpiSpanChanged(const Parameter::PositiveIntValue& parameter) = 0;
 
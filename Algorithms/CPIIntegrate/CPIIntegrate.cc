@@ -33,9 +33,7 @@ CPIIntegrate::CPIIntegrate(Controller& controller, Logger::Log& log) :
 bool
 CPIIntegrate::startup()
 {
-    vals_.resize(cpiSpan_->getValue());
-    std::vector<std::vector<float>>::iterator itr;
-    for (itr = vals_.begin(); itr != vals_.end(); itr++) { (*itr).resize(1000, 0.0); }
+    vals_.reset(cpiSpan_->getValue(), 1000);
 
     return registerParameter(numCPIs_) && Super::startup();
 }
@@ -62,14 +60,9 @@ CPIIntegrate::numCPIsChanged(const Parameter::PositiveIntValue& parameter)
 bool
 CPIIntegrate::reset()
 {
-    size_t cpiSpan = cpiSpan_->getValue();
-    size_t msg_size = vals_[0].size();
-
     // Reset running averages
     //
-    vals_.clear();
-    vals_.resize(cpiSpan);
-    for (size_t i = 0; i < cpiSpan; i++) { vals_[i].resize(msg_size, 0.0); }
+    vals_.reset(cpiSpan_->getValue(), vals_.getCols());
 
     // Reset message buffers
     //
@@ -91,7 +84,7 @@ CPIIntegrate::shutdown()
     // Release memory and other resources here.
     //
     reset();
-    vals_.clear();
+    vals_.reset(0, 0);
 
     return Super::shutdown();
 }
@@ -125,9 +118,7 @@ CPIIntegrate::processCPI()
 
     // Resize the vals_ buffer if necessary adding default value of 0
     //
-    if (msg_size > vals_[0].size()) {
-        for (size_t i = 0; i < cpiSpan; i++) { vals_[i].resize(msg_size, 0.0); }
-    }
+    if (msg_size > vals_.getCols()) vals_.resize(msg_size);
 
     MessageQueue* cpi = new MessageQueue;
     uint32_t startingSequenceNumber_ = buffer_[0]->getRIUInfo().sequenceCounter;
@@ -137,14 +128,12 @@ CPIIntegrate::processCPI()
     for (itr = buffer_.begin(), cnt = 0; itr != buffer_.end() && cnt < cpiSpan; itr++, cnt++) {
         Messages::Video::Ref ref = boost::dynamic_pointer_cast<Messages::Video>(*itr);
         row = ref->getRIUInfo().sequenceCounter - startingSequenceNumber_;
-        // pad any message locations whose PRIs were dropped
+        // pad any message locations whose PRIs were dropped. A dropped PRI adds nothing to the sums, so its
+        // stand-in needs no samples.
         //
         for (size_t row_index = last_row + 1; row_index < row; row_index++) {
             LOGDEBUG << "Padding CPI(" << row_index << ") with zeroes" << std::endl;
-            Messages::Video::Ref msg(Messages::Video::Make(getName(), ref));
-            size_t N = vals_[0].size();
-            for (size_t i = 0; i < N; i++) { msg->push_back(0); }
-            cpi->push_back(msg);
+            cpi->push_back(Messages::Video::Make(getName(), ref));
         }
 
         cpi->push_back(ref);
@@ -154,14 +143,8 @@ CPIIntegrate::processCPI()
     // Add contribution of new CPI to running average
     //
     for (size_t i = 0; i < cpiSpan; i++) {
-        Messages::Video::Ref ref = boost::dynamic_pointer_cast<Messages::Video>(cpi->front());
-        size_t n = ref->size();
-        // Add this message's values to the running average
-        for (size_t j = 0; j < n; j++) { vals_[i][j] += ref[j]; }
-        // remove the message from the front of the queue and push it to the back of the queue
-        //
-        cpi->pop_front();
-        cpi->push_back(ref);
+        Messages::Video::Ref ref = boost::dynamic_pointer_cast<Messages::Video>((*cpi)[i]);
+        vals_.add(i, ref->getData().data(), ref->size());
     }
 
     cpis_.push_front(cpi);
@@ -176,9 +159,8 @@ CPIIntegrate::processCPI()
     cpis_.pop_back();
 
     for (size_t i = 0; i < cpiSpan; i++) {
-        Messages::Video::Ref ref = boost::dynamic_pointer_cast<Messages::Video>(cpi->front());
-        size_t n = ref->size();
-        for (size_t j = 0; j < n; j++) vals_[i][j] -= ref[j];
+        Messages::Video::Ref ref = boost::dynamic_pointer_cast<Messages::Video>((*cpi)[i]);
+        vals_.subtract(i, ref->getData().data(), ref->size());
     }
     // De-allocate memory used to hold this CPI
     //
@@ -195,11 +177,13 @@ CPIIntegrate::processCPI()
         Messages::Video::Ref parent = boost::dynamic_pointer_cast<Messages::Video>((*(cpis_[middle]))[i]);
         Messages::Video::Ref out(Messages::Video::Make(getName(), parent));
         Messages::Video::Container& outputData(out->getData());
-        size_t N = vals_[i].size();
+        size_t N = vals_.getCols();
+        const RunningSums::SumType* sums = vals_.getRow(i);
+        outputData.resize(N);
 
-        for (size_t j = 0; j < N; j++) {
-            outputData.push_back(Messages::Video::DatumType(::rint(vals_[i][j] / numCPIs)));
-        }
+        // NOTE: the division is done in single precision, as it was when the sums were kept as floats.
+        //
+        for (size_t j = 0; j < N; j++) { outputData[j] = Messages::Video::DatumType(::rint(float(sums[j]) / numCPIs)); }
 
         rc = rc && send(out);
     }
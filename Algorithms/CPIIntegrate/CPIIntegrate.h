@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "Algorithms/CPIAlgorithm.h"
+#include "Algorithms/RunningSums.h"
 #include "Messages/Video.h"
 #include "Parameter/Parameter.h"
 
@@ -60,7 +61,7 @@ private:
     std::deque<MessageQueue*> cpis_;
     /** Running 2D buffer of sums for computing the averages
      */
-    std::vector<std::vector<float>> vals_;
+    RunningSums vals_;
 };
 
 } // end namespace Algorithms
@@ -0,0 +1,162 @@
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "IO/MessageManager.h"
+#include "IO/ParametersChangeRequest.h"
+#include "IO/ProcessingStateChangeRequest.h"
+#include "IO/Stream.h"
+#include "Logger/Log.h"
+#include "Messages/Video.h"
+#include "Parameter/Parameter.h"
+#include "UnitTest/UnitTest.h"
+#include "XMLRPC/XmlRpcValue.h"
+
+#include "Algorithm.h"
+#include "Controller.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms;
+using namespace SideCar::Messages;
+
+/** Algorithm that takes a while with each PRI, and emits a PRI holding the value of its gain parameter.
+ */
+class Slow : public Algorithm {
+public:
+    Slow(Controller& controller, Logger::Log& log) :
+        Algorithm(controller, log), gain_(Parameter::IntValue::Make("gain", "Gain", 1))
+    {
+    }
+
+    bool startup()
+    {
+        registerProcessor<Slow, Video>("input", &Slow::process);
+        registerParameter(gain_);
+        return Algorithm::startup();
+    }
+
+    bool process(const Video::Ref& msg)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        Video::Ref out(Video::Make(getName(), msg));
+        out->push_back(gain_->getValue());
+        return send(out);
+    }
+
+    Parameter::IntValue::Ref gain_;
+};
+
+/** Task that collects the Video messages it receives.
+ */
+struct Sink : public IO::Task {
+    using Ref = boost::shared_ptr<Sink>;
+
+    static Ref Make()
+    {
+        Ref ref(new Sink);
+        return ref;
+    }
+
+    Sink() : Task(true), mutex_(), msgs_() {}
+
+    bool deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout)
+    {
+        IO::MessageManager mgr(data);
+        if (mgr.hasNative() && mgr.getNativeMessageType() == MetaTypeInfo::Value::kVideo) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            msgs_.push_back(mgr.getNative<Video>());
+        }
+
+        return true;
+    }
+
+    /** Wait for messages to arrive.
+
+        \param count number of messages to wait for
+
+        \return messages received
+    */
+    std::vector<Video::Ref> wait(size_t count)
+    {
+        for (int tries = 0; tries < 500; ++tries) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (msgs_.size() >= count) break;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return msgs_;
+    }
+
+    std::mutex mutex_;
+    std::vector<Video::Ref> msgs_;
+};
+
+class ControlLaneTest : public UnitTest::TestObj {
+public:
+    ControlLaneTest() : TestObj("ControlLane") {}
+
+    void test();
+};
+
+void
+ControlLaneTest::test()
+{
+    Logger::Log::Root().setPriorityLimit(Logger::Priority::kError);
+
+    IO::Stream::Ref stream(IO::Stream::Make("ControlLaneTest"));
+    auto sinkModule = new IO::TModule<Sink>(stream);
+    assertEqual(0, stream->push(sinkModule));
+    Sink::Ref sink = sinkModule->getTask();
+    sink->setTaskName("Sink");
+    sink->setTaskIndex(1);
+    sink->addInputChannel(IO::Channel("input", "Video"));
+
+    ControllerModule* module = new ControllerModule(stream);
+    assertEqual(0, stream->push(module));
+    Controller::Ref controller = module->getTask();
+    controller->setTaskIndex(0);
+    controller->addInputChannel(IO::Channel("input", "Video"));
+    controller->addOutputChannel(IO::Channel("output", "Video", sink));
+
+    assertTrue(controller->openAndInit("Slow", "Slow", new Slow(*controller, Logger::Log::Root())));
+    assertTrue(controller->injectProcessingStateChange(IO::ProcessingState::kRun));
+
+    // Build up a backlog of PRIs, and then change the gain.
+    //
+    VMEDataMessage vme;
+    vme.header.msgDesc = (VMEHeader::kPackedReal << 16) | VMEHeader::kPRIValidMask;
+    vme.header.timeStamp = 0;
+    vme.header.azimuth = 0;
+    vme.header.irigTime = 0.0;
+    for (uint32_t index = 0; index < 200; ++index) {
+        vme.header.pri = index;
+        assertTrue(controller->putInChannel(Video::Make("test", vme, 1), 0));
+    }
+
+    XmlRpc::XmlRpcValue change;
+    change.setSize(2);
+    change[0] = "gain";
+    change[1] = 2;
+    assertTrue(controller->injectControlMessage(IO::ParametersChangeRequest(change, false)));
+
+    // The change takes effect within a few PRIs instead of after the whole backlog.
+    //
+    std::vector<Video::Ref> outputs(sink->wait(200));
+    assertEqual(size_t(200), outputs.size());
+    size_t before = 0;
+    while (before < outputs.size() && outputs[before][0] == 1) ++before;
+    assertTrue(before < 20);
+    assertEqual(int16_t(2), outputs.back()[0]);
+
+    controller->close(1);
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return ControlLaneTest().mainRun();
+}
@@ -1,5 +1,6 @@
 #include "ace/ACE.h" // for ACE_DLL_PREFIX
 #include "ace/Notification_Strategy.h"
+#include "ace/OS_NS_sys_time.h"
 #include "ace/Reactor.h"
 
 #include "boost/date_time/posix_time/posix_time.hpp"
@@ -9,6 +10,7 @@
 #endif
 
 #include "IO/ControlMessage.h"
+#include "IO/Executor.h"
 #include "IO/MessageManager.h"
 #include "IO/Module.h"
 #include "IO/ProcessingStateChangeRequest.h"
@@ -84,6 +86,37 @@ struct Controller::IncomingNotifier : public ACE_Event_Handler, public ACE_Notif
     Controller* controller_;
 };
 
+/** Helper class for Controller objects that run on an IO::Executor (see Controller::setExecutor()). Each message
+    added to the Controller's message queue is one unit of work for the executor, which only runs one of them at
+    a time. Installed as the notification strategy of the message queue, so that it sees every message, even
+    those that go directly to the queue instead of through Controller::deliverDataMessage().
+*/
+struct Controller::ExecutorActor : public IO::Executor::Actor, public ACE_Notification_Strategy {
+    ExecutorActor(IO::Executor& executor, Controller* controller) :
+        Actor(executor), ACE_Notification_Strategy(0, ACE_Event_Handler::NULL_MASK), controller_(controller)
+    {
+    }
+
+    int notify() override
+    {
+        Actor::notify();
+        return 0;
+    }
+
+    int notify(ACE_Event_Handler*, ACE_Reactor_Mask) override { return notify(); }
+
+    void runOne() override
+    {
+        // The message is already in the queue, so do not wait for one. NOTE: ACE timeouts are absolute times.
+        //
+        ACE_Time_Value now(ACE_OS::gettimeofday());
+        ACE_Message_Block* data;
+        if (controller_->dequeue(data, &now) != -1) controller_->processOneMessage(data);
+    }
+
+    Controller* controller_;
+};
+
 Logger::Log&
 Controller::Log()
 {
@@ -103,11 +136,17 @@ Controller::Controller() :
     Super(), self_(), algorithmName_(""), algorithm_(), recorders_(),
     logLevel_(LogLevelParameter::Make("logLevel", "Log Level", Logger::Priority::kWarning)),
     recordingEnabled_(Parameter::BoolValue::Make("recordingEnabled", "Recording Enabled", false)), processingStat_(),
-    xmlConfiguration_(), recording_(false), statsManaged_(true), threaded_(true), timerThread_()
+    controlLatency_(100), xmlConfiguration_(), recording_(false), statsManaged_(true), threaded_(true), timerThread_(),
+    executor_(0), actor_(), replicaConfig_(), replicas_(), replicaSet_(0), replicaIndex_(0),
+    controlMutex_(), controlLane_()
 {
     Logger::ProcLog log("Controller", Log());
     LOGINFO << std::endl;
 
+    // Messages wait in the input queue, so time their processing, not their delivery.
+    //
+    setLatencyTracedOnProcess(true);
+
     // Make the log level runtime parameter an advanced setting, register it, and connect a method to receive
     // notification when the parameter changes.
     //
@@ -162,7 +201,29 @@ Controller::openAndInit(const std::string& algorithmName, const std::string& ser
         return false;
     }
 
-    if (threaded_) {
+    // Start any replicas of the algorithm. They do all of the data processing, so our own algorithm only sees
+    // control messages.
+    //
+    if (replicaConfig_.count > 1) {
+        if (!algorithm_->isReplicaSafe()) {
+            LOGWARNING << getTaskName() << " algorithm is not replica-safe - running one copy" << std::endl;
+        } else {
+            replicas_.reset(new ReplicaSet(*this, replicaConfig_));
+            if (!replicas_->open(threadFlags, threadPriority, threaded)) {
+                LOGERROR << "failed to start replicas" << std::endl;
+                setError("Failed to start replicas");
+                return false;
+            }
+        }
+    }
+
+    if (threaded_ && executor_) {
+        // Let the executor's worker threads do the algorithm processing.
+        //
+        LOGINFO << getTaskName() << " running in executor" << std::endl;
+        actor_.reset(new ExecutorActor(*executor_, this));
+        msg_queue()->notification_strategy(actor_.get());
+    } else if (threaded_) {
         // Start a consumer thread for algorithmm processing
         //
         if (activate(threadFlags, 1, 0, threadPriority) == -1) {
@@ -207,7 +268,14 @@ Controller::close(u_long flags)
         //
         LOGDEBUG << "deactivating message queue" << std::endl;
         msg_queue()->deactivate();
-        if (threaded_) {
+        if (actor_) {
+            // Wait for the executor to finish with us. Messages still in the queue are not processed.
+            //
+            LOGDEBUG << "stopping executor actor" << std::endl;
+            msg_queue()->notification_strategy(0);
+            actor_->stop();
+            actor_.reset();
+        } else if (threaded_) {
             LOGDEBUG << "joining algorithm service thread" << std::endl;
             if (wait() == -1) {
                 LOGERROR << "failed to join algorithm service thread" << std::endl;
@@ -225,6 +293,14 @@ Controller::close(u_long flags)
             }
         }
 
+        // Stop the replicas now that nothing more will be dispatched to them.
+        //
+        if (replicas_) {
+            LOGDEBUG << "closing replicas" << std::endl;
+            replicas_->close();
+            replicas_.reset();
+        }
+
         // Give the algorithm a chance to clean up, and then forget about it.
         //
         if (algorithm_) {
@@ -238,6 +314,14 @@ Controller::close(u_long flags)
             delete recorders_.back();
             recorders_.pop_back();
         }
+
+        // Discard any control messages that arrived too late to process.
+        //
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        while (!controlLane_.empty()) {
+            controlLane_.front().first->release();
+            controlLane_.pop_front();
+        }
     }
 
     LOGINFO << algorithmName_ << "- END" << std::endl;
@@ -323,6 +407,11 @@ Controller::send(const Messages::Header::Ref& message, size_t channelIndex)
 
     if (statsManaged_) { processingStat_.endProcessing(); }
 
+    // Replicas hand their output to their ReplicaSet, which puts it back in order before sending it out through
+    // the primary Controller.
+    //
+    if (replicaSet_) return replicaSet_->collect(replicaIndex_, message, channelIndex);
+
     // Manage the message reference and send the resulting data blocks down the processing stream.
     //
     IO::MessageManager manager(message);
@@ -341,22 +430,6 @@ Controller::send(const Messages::Header::Ref& message, size_t channelIndex)
     return Super::sendManaged(manager, channelIndex);
 }
 
-bool
-Controller::injectControlMessage(const IO::ControlMessage& msg)
-{
-    // Place the control message onto the input queue for the consumer thread to process. NOTE: we own data
-    // unless successfully placed in the queue.
-    //
-    ACE_Message_Block* data = msg.getWrapped();
-    if (!deliverControlMessage(data, 0)) {
-        data->release();
-        setError("Failed to enqueue control message");
-        return false;
-    }
-
-    return true;
-}
-
 bool
 Controller::injectProcessingStateChange(IO::ProcessingState::Value state)
 {
@@ -399,6 +472,10 @@ Controller::processDataMessage(ACE_Message_Block* data)
     static Logger::ProcLog log("processDataMessage", Log());
     LOGTIN << algorithmName_ << std::endl;
 
+    // If we are a replica, let our ReplicaSet know which dispatched message we are working on.
+    //
+    ReplicaSet::Scope scope(replicaSet_, replicaIndex_);
+
     if (!algorithm_) {
         LOGERROR << "algorithm is not loaded" << std::endl;
         return false;
@@ -413,6 +490,11 @@ Controller::processDataMessage(ACE_Message_Block* data)
         return true;
     }
 
+    if (replicas_) {
+        LOGTOUT << "dispatched" << std::endl;
+        return replicas_->dispatch(data);
+    }
+
     // Process the incoming message. If the algorithm reports a failure, we report an error and enter the
     // failure state. Otherwise, we update the processing stats.
     //
@@ -436,6 +518,7 @@ Controller::doClearStatsRequest()
 {
     if (!algorithm_) return Super::doClearStatsRequest();
     processingStat_.reset();
+    controlLatency_.reset();
     return Super::doClearStatsRequest() && algorithm_->clearStats();
 }
 
@@ -542,7 +625,7 @@ Controller::fetchAndProcessOneMessage()
     static Logger::ProcLog log("fetchAndProcessOneMessage", Log());
     LOGINFO << "message count: " << msg_queue()->message_count() << std::endl;
     ACE_Message_Block* data;
-    if (getq(data) == -1) return false;
+    if (dequeue(data) == -1) return false;
     processOneMessage(data);
     return true;
 }
@@ -552,6 +635,46 @@ Controller::processOneMessage(ACE_Message_Block* data)
 {
     static Logger::ProcLog log("processOneMessage", Log());
     LOGDEBUG << getTaskName() << " message: " << data << std::endl;
+
+    // Control messages go first, no matter how many data messages are waiting.
+    //
+    processControlLane();
+
+    if (data->msg_type() == ACE_Message_Block::MB_EVENT) {
+        data->release();
+        return;
+    }
+
+    dispatchMessage(data);
+}
+
+void
+Controller::processControlLane()
+{
+    static Logger::ProcLog log("processControlLane", Log());
+
+    while (1) {
+        ControlEntry entry;
+        {
+            std::lock_guard<std::mutex> lock(controlMutex_);
+            if (controlLane_.empty()) return;
+            entry = controlLane_.front();
+            controlLane_.pop_front();
+        }
+
+        Time::TimeStamp delta(Time::TimeStamp::Now());
+        delta -= entry.second;
+        controlLatency_.addSample(delta);
+        LOGDEBUG << getTaskName() << " control latency: " << delta.asDouble() << std::endl;
+        dispatchMessage(entry.first);
+    }
+}
+
+void
+Controller::dispatchMessage(ACE_Message_Block* data)
+{
+    static Logger::ProcLog log("dispatchMessage", Log());
+    if (replicas_ && IO::MessageManager::IsControlMessage(data)) replicas_->broadcast(data);
     if (!processMessage(data)) {
         LOGERROR << getTaskName() << " failed to process message" << std::endl;
         setError("Failed to process message");
@@ -569,7 +692,7 @@ Controller::svc()
     // Fetch messages from our input queue, process them, and repeat.
     //
     ACE_Message_Block* data;
-    while (getq(data) != -1) processOneMessage(data);
+    while (dequeue(data) != -1) processOneMessage(data);
 
     LOGINFO << thr_mgr()->thr_self() << ' ' << getTaskName() << " EXITING" << std::endl;
     return 0;
@@ -603,6 +726,8 @@ Controller::fillStatus(IO::StatusBase& status)
     status.setSlot(ControllerStatus::kAverageProcessingTime, processingStat_.getAverageProcessingTime());
     status.setSlot(ControllerStatus::kMinimumProcessingTime, processingStat_.getMinimumProcessingTime());
     status.setSlot(ControllerStatus::kMaximumProcessingTime, processingStat_.getMaximumProcessingTime());
+    status.setSlot(ControllerStatus::kAverageControlLatency, controlLatency_.getAverageProcessingTime());
+    status.setSlot(ControllerStatus::kMaximumControlLatency, controlLatency_.getMaximumProcessingTime());
 
     // If the algorithm says that it has some status slots, give it a chance to add them to the XML status
     // object.
@@ -619,7 +744,22 @@ Controller::getStatusSize() const
 bool
 Controller::deliverControlMessage(ACE_Message_Block* data, ACE_Time_Value* timeout)
 {
-    return deliverDataMessage(data, timeout);
+    static Logger::ProcLog log("deliverControlMessage", Log());
+    LOGINFO << algorithmName_ << ' ' << data << std::endl;
+
+    {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        controlLane_.push_back(ControlEntry(data, Time::TimeStamp::Now()));
+    }
+
+    // Wake up the processing thread in case it is waiting for a message. If the queue is too full to take the
+    // wake-up marker, the thread is busy and will get to the control lane before the next data message.
+    //
+    ACE_Message_Block* marker = new ACE_Message_Block(size_t(0), ACE_Message_Block::MB_EVENT);
+    ACE_Time_Value immediate(ACE_Time_Value::zero);
+    if (putq(marker, &immediate) == -1) marker->release();
+
+    return true;
 }
 
 bool
@@ -631,7 +771,7 @@ Controller::deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout)
     // Add the incoming message to our message queue for our algorithm consumer thread. NOTE: we only take
     // ownership of data if we can put it in the queue.
     //
-    if (putq(data, timeout) == -1) {
+    if (!enqueue(data, timeout)) {
         LOGERROR << "failed to add message to message queue for " << algorithmName_ << std::endl;
         setError("Failed to enqueue data message");
         return false;
@@ -674,8 +814,7 @@ Controller::alarmTimerProc()
         // Send control message to Task to let it know to invoke its alarm handler function in a thread-safe
         // manner.
         //
-        ACE_Message_Block* data = IO::MessageManager::MakeControlMessage(IO::ControlMessage::kTimeout, 0);
-        if (put(data, 0) == -1) {
+        if (!postAlarm()) {
             LOGINFO << getTaskName() << " failed to post control message" << std::endl;
             break;
         }
@@ -684,6 +823,13 @@ Controller::alarmTimerProc()
     LOGINFO << getTaskName() << " thread exiting" << std::endl;
 }
 
+bool
+Controller::postAlarm()
+{
+    ACE_Message_Block* data = IO::MessageManager::MakeControlMessage(IO::ControlMessage::kTimeout, 0);
+    return put(data, 0) != -1;
+}
+
 void
 Controller::setTimerSecs(int timerSecs)
 {
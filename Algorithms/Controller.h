@@ -2,6 +2,8 @@
 #define SIDECAR_ALGORITHMS_CONTROLLER_H
 
 #include "ace/DLL.h"
+#include <deque>
+#include <mutex>
 #include <string>
 
 #include "QtXml/QDomNode"
@@ -14,6 +16,7 @@
 
 #include "Algorithms/ControllerStatus.h"
 #include "Algorithms/ProcessingStat.h"
+#include "Algorithms/ReplicaSet.h"
 #include "IO/Module.h"
 #include "IO/ProcessingState.h"
 #include "IO/Task.h"
@@ -25,6 +28,9 @@ class Log;
 }
 
 namespace SideCar {
+namespace IO {
+class Executor;
+}
 namespace Algorithms {
 
 class Algorithm;
@@ -38,7 +44,12 @@ class Recorder;
     loadAlgorithm() to handle the DLL loading in a platform-neutral way. If the load was successful, the
     Controller initializes the Algorithm object by invoking Algorithm::startup(). If that step succeeds, the
     Controller starts a separate thread (which runs the svc() method) to handle message passing to the
-    algorithm's registered message processors.
+    algorithm's registered message processors. If given an IO::Executor with setExecutor(), the Controller
+    instead runs as an actor of the executor, sharing its worker threads with other Controllers. Either way, the
+    algorithm sees one message at a time.
+
+    A Controller configured with setReplicas() hands its data messages to a ReplicaSet, which runs several
+    copies of a replica-safe algorithm in parallel and puts their outputs back in order.
 
     <h2>Algorithm Output Recording</h2>
 
@@ -95,6 +106,20 @@ public:
                      long threadFlags = kDefaultThreadFlags, long threadPriority = ACE_DEFAULT_THREAD_PRIORITY,
                      bool threaded = true);
 
+    /** Run the controller on a shared pool of worker threads instead of in its own thread. Must be called before
+        openAndInit(), and only applies if openAndInit() is given a true \a threaded value.
+
+        \param executor the executor to run on
+    */
+    void setExecutor(IO::Executor* executor) { executor_ = executor; }
+
+    /** Run several copies of the algorithm in parallel (see ReplicaSet). Must be called before openAndInit().
+        Ignored if the algorithm is not replica-safe (see Algorithm::isReplicaSafe()).
+
+        \param config replica configuration
+    */
+    void setReplicas(const ReplicaConfig& config) { replicaConfig_ = config; }
+
     /** Shutdown the task. Override of ACE_Task method. This is the canonical way to stop an ACE task. The close
         method gets called in two distinct situations, indicated by the value of the the given \a flags
         argument:
@@ -127,14 +152,6 @@ public:
     */
     Algorithm* getAlgorithm() const { return algorithm_.get(); }
 
-    /** Post a control message to the internal processing queue.
-
-        \param msg control message to post
-
-        \return true if successful
-    */
-    bool injectControlMessage(const IO::ControlMessage& msg);
-
     /** Post a control message to change the run state
 
         \param msg control message to post
@@ -210,6 +227,13 @@ public:
     */
     int getTimerSecs() { return timerSecs_; }
 
+    /** Post a timeout control message to ourselves so that the processing thread invokes the algorithm's
+        processAlarm() method. Thread-safe.
+
+        \return true if successful
+    */
+    bool postAlarm();
+
 private:
     /** Constructor. Initializes the object, but does not load an algorithm; that is done in the open() method.
      */
@@ -293,6 +317,17 @@ private:
     */
     void processOneMessage(ACE_Message_Block* data);
 
+    /** Process the messages in the control lane (see deliverControlMessage()), and record how long each one
+        waited there.
+    */
+    void processControlLane();
+
+    /** Process a message taken from the input message queue or the control lane.
+
+        \param data opaque message to process
+    */
+    void dispatchMessage(ACE_Message_Block* data);
+
     /** Override of ACE Task method. Pulls messages from the internal queue and processes them. Forwards data
         messages to the managed algorithm. Runs in a separate thread. Only returns after the message queue is
         shutdown.
@@ -311,8 +346,8 @@ private:
     */
     bool deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout) override;
 
-    /** Override of IO::Task method. Treat the same as a data message -- place on the svc thread's message
-        queue.
+    /** Override of IO::Task method. Place the message in the control lane, which the processing thread empties
+        before it processes another data message, so that control messages do not wait behind a data backlog.
 
         \param data raw data to send
 
@@ -415,16 +450,31 @@ private:
     Parameter::BoolValue::Ref recordingEnabled_;
 
     ProcessingStat processingStat_; ///< Algorithm processing statistics
+    ProcessingStat controlLatency_; ///< Time control messages spend in the control lane
     QDomNode xmlConfiguration_;     ///< XML configuration for this algorithm
     bool recording_;                ///< True if currently recording data
     bool statsManaged_;             ///< True if managing stats
     bool threaded_;                 ///< If true algorithm processing is in separate thread
     int timerSecs_;                 ///< The number of seconds between each doTimeout call
     boost::thread timerThread_;     ///< Thread that runs alarmTimerProc
+    IO::Executor* executor_;        ///< If set, threaded processing happens in executor threads
+
+    struct ExecutorActor;
+    boost::scoped_ptr<ExecutorActor> actor_; ///< Runs message processing on executor_
+
+    ReplicaConfig replicaConfig_;            ///< Configuration for replicas_
+    boost::scoped_ptr<ReplicaSet> replicas_; ///< If set, copies of the algorithm that process the data
+    ReplicaSet* replicaSet_;                 ///< If set, the ReplicaSet this Controller is a replica of
+    size_t replicaIndex_;                    ///< Index of this Controller in replicaSet_
+
+    using ControlEntry = std::pair<ACE_Message_Block*, Time::TimeStamp>;
+    std::mutex controlMutex_;              ///< Guards controlLane_
+    std::deque<ControlEntry> controlLane_; ///< Control messages and their arrival times
 
     struct IncomingNotifier;
     friend class IncomingNotifier;
     friend class Algorithm;
+    friend class ReplicaSet;
 };
 
 using ControllerModule = IO::TModule<Controller>;
@@ -21,6 +21,8 @@ public:
         kAverageProcessingTime,
         kMinimumProcessingTime,
         kMaximumProcessingTime,
+        kAverageControlLatency,
+        kMaximumControlLatency,
         kNumSlots
     };
 
@@ -39,6 +41,13 @@ public:
     double getAverageProcessingTime() const { return getSlot(kAverageProcessingTime); }
     double getMinimumProcessingTime() const { return getSlot(kMinimumProcessingTime); }
     double getMaximumProcessingTime() const { return getSlot(kMaximumProcessingTime); }
+
+    /** Obtain the average time control messages waited before processing.
+
+        \return latency in seconds
+    */
+    double getAverageControlLatency() const { return getSlot(kAverageControlLatency); }
+    double getMaximumControlLatency() const { return getSlot(kMaximumControlLatency); }
 };
 
 } // end namespace Algorithms
@@ -0,0 +1,305 @@
+#include <algorithm>
+
+#include "Time/TimeStamp.h"
+
+#include "Convolver.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms;
+
+namespace {
+
+enum { kMinFFTShift = 4, kMaxFFTShift = 16 };
+
+double
+Elapsed(const Time::TimeStamp& begin)
+{
+    Time::TimeStamp delta(Time::TimeStamp::Now());
+    delta -= begin;
+    return delta.asDouble();
+}
+
+size_t
+NextPowerOfTwo(size_t value)
+{
+    size_t power = 1;
+    while (power < value) power <<= 1;
+    return power;
+}
+
+/** Time the inner loops of the two methods. This takes a few tens of milliseconds.
+ */
+Convolver::Calibration
+Calibrate()
+{
+    using ComplexType = Convolver::ComplexType;
+    using ComplexVector = vsip::Vector<ComplexType>;
+    using FwdFFT = vsip::Fft<vsip::const_Vector, ComplexType, ComplexType, vsip::fft_fwd, vsip::by_reference>;
+
+    Convolver::Calibration calibration;
+
+    // Time-domain multiply-adds, using a convolver so that the measurement covers the real loop.
+    //
+    {
+        enum { kSize = 4096, kTaps = 16, kReps = 8 };
+        Convolver convolver;
+        convolver.setKernel(std::vector<ComplexType>(kTaps, ComplexType(0.5, 0.25)), 1, kTaps / 2);
+        convolver.setMethod(Convolver::kTimeDomain);
+        std::vector<ComplexType> input(kSize, ComplexType(1.0, 2.0));
+        std::vector<ComplexType> output(kSize);
+        const ComplexType* inputs[] = {&input[0]};
+        convolver.convolve(inputs, kSize, &output[0]);
+        Time::TimeStamp begin(Time::TimeStamp::Now());
+        for (int rep = 0; rep < kReps; ++rep) convolver.convolve(inputs, kSize, &output[0]);
+        calibration.multiplyAddTime = Elapsed(begin) / (double(kReps) * kSize * kTaps);
+    }
+
+    // Spectrum multiply-adds
+    //
+    {
+        enum { kSize = 4096, kReps = 16 };
+        ComplexVector a(kSize, ComplexType(1.0, 2.0));
+        ComplexVector b(kSize, ComplexType(0.5, 0.25));
+        ComplexVector sum(kSize, ComplexType(0.0, 0.0));
+        Time::TimeStamp begin(Time::TimeStamp::Now());
+        for (int rep = 0; rep < kReps; ++rep) sum += a * b;
+        calibration.multiplyTime = Elapsed(begin) / (double(kReps) * kSize);
+    }
+
+    // FFTs of each power-of-two size
+    //
+    calibration.fftTime.resize(kMaxFFTShift + 1, 0.0);
+    for (int shift = kMinFFTShift; shift <= kMaxFFTShift; ++shift) {
+        size_t size = size_t(1) << shift;
+        int reps = std::max(4, int((size_t(1) << 18) / size));
+        ComplexVector in(size, ComplexType(1.0, 0.0));
+        ComplexVector out(size);
+        FwdFFT fft(vsip::Domain<1>(size), 1.0);
+        fft(in, out);
+        Time::TimeStamp begin(Time::TimeStamp::Now());
+        for (int rep = 0; rep < reps; ++rep) fft(in, out);
+        calibration.fftTime[shift] = Elapsed(begin) / reps;
+    }
+
+    return calibration;
+}
+
+} // namespace
+
+const Convolver::Calibration&
+Convolver::GetCalibration()
+{
+    // NOTE: C++11 guarantees thread-safe initialization of function-level statics.
+    //
+    static const Calibration calibration_ = Calibrate();
+    return calibration_;
+}
+
+const char*
+Convolver::GetMethodName(Method method)
+{
+    switch (method) {
+    case kTimeDomain: return "Time";
+    case kFrequencyDomain: return "FFT";
+    default: return "Auto";
+    }
+}
+
+Convolver::Convolver() :
+    taps_(1, ComplexType(1.0, 0.0)), rows_(1), cols_(1), offset_(0), method_(kAuto), blockSize_(0),
+    activeMethod_(kTimeDomain), activeBlockSize_(0), chosenForSize_(0), lastCost_(0.0), preparedBlockSize_(0),
+    fwdFFT_(), invFFT_(), kernelSpectra_(), block_(), spectrum_(), sum_()
+{
+    ;
+}
+
+void
+Convolver::setKernel(const std::vector<ComplexType>& taps, size_t rows, size_t offset)
+{
+    taps_ = taps;
+    rows_ = std::max(rows, size_t(1));
+    cols_ = std::max(taps_.size() / rows_, size_t(1));
+    taps_.resize(rows_ * cols_, ComplexType(0.0, 0.0));
+    offset_ = offset;
+    chosenForSize_ = 0;
+    preparedBlockSize_ = 0;
+    kernelSpectra_.clear();
+}
+
+size_t
+Convolver::getMinBlockSize() const
+{
+    return std::max(NextPowerOfTwo(2 * cols_), size_t(1) << kMinFFTShift);
+}
+
+double
+Convolver::estimateCost(Method method, size_t size, size_t blockSize) const
+{
+    const Calibration& calibration(GetCalibration());
+    if (method != kFrequencyDomain) return calibration.multiplyAddTime * rows_ * cols_ * size;
+
+    // Look up the FFT time, extrapolating as n log n beyond the calibrated sizes.
+    //
+    int shift = 0;
+    while ((size_t(1) << shift) < blockSize) ++shift;
+    double fftTime;
+    if (shift <= kMaxFFTShift) {
+        fftTime = calibration.fftTime[std::max(shift, int(kMinFFTShift))];
+    } else {
+        fftTime = calibration.fftTime[kMaxFFTShift] * double(size_t(1) << (shift - kMaxFFTShift)) * shift /
+                  kMaxFFTShift;
+    }
+
+    size_t outputsPerBlock = blockSize - cols_ + 1;
+    size_t blocks = (size + outputsPerBlock - 1) / outputsPerBlock;
+    return blocks * ((rows_ + 1) * fftTime + rows_ * blockSize * calibration.multiplyTime);
+}
+
+void
+Convolver::choose(size_t size)
+{
+    if (size == chosenForSize_) return;
+    chosenForSize_ = size;
+
+    if (method_ == kTimeDomain) {
+        activeMethod_ = kTimeDomain;
+        return;
+    }
+
+    // Find the cheapest block size, from the smallest that holds the kernel to the one that holds the whole
+    // input.
+    //
+    size_t minBlockSize = getMinBlockSize();
+    size_t first = minBlockSize;
+    size_t last = std::max(NextPowerOfTwo(size + cols_ - 1), minBlockSize);
+    if (blockSize_) first = last = std::max(NextPowerOfTwo(blockSize_), minBlockSize);
+
+    if (method_ == kFrequencyDomain && first == last) {
+        activeMethod_ = kFrequencyDomain;
+        activeBlockSize_ = first;
+        return;
+    }
+
+    double bestCost = -1.0;
+    for (size_t blockSize = first; blockSize <= last; blockSize *= 2) {
+        double cost = estimateCost(kFrequencyDomain, size, blockSize);
+        if (bestCost < 0.0 || cost < bestCost) {
+            bestCost = cost;
+            activeBlockSize_ = blockSize;
+        }
+    }
+
+    if (method_ == kFrequencyDomain || estimateCost(kTimeDomain, size, 0) > bestCost) {
+        activeMethod_ = kFrequencyDomain;
+    } else {
+        activeMethod_ = kTimeDomain;
+    }
+}
+
+void
+Convolver::convolve(const ComplexType* const* inputs, size_t size, ComplexType* output)
+{
+    Time::TimeStamp begin(Time::TimeStamp::Now());
+    if (size) {
+        choose(size);
+        if (activeMethod_ == kTimeDomain) {
+            convolveTime(inputs, size, output);
+        } else {
+            convolveFrequency(inputs, size, output);
+        }
+    }
+
+    lastCost_ = Elapsed(begin);
+}
+
+void
+Convolver::convolveTime(const ComplexType* const* inputs, size_t size, ComplexType* output)
+{
+    // Output sample i is full-convolution sample n = i + offset, the sum over k of h[k] * x[n - k] for the taps
+    // where n - k lies within the input. The arithmetic is spelled out to keep the compiler from calling out to
+    // the C99 complex multiply for its NaN handling.
+    //
+    for (size_t index = 0; index < size; ++index) {
+        size_t n = index + offset_;
+        size_t first = n >= size ? n - size + 1 : 0;
+        size_t last = std::min(cols_ - 1, n);
+        float re = 0.0f;
+        float im = 0.0f;
+        for (size_t row = 0; row < rows_; ++row) {
+            const ComplexType* h = &taps_[row * cols_];
+            const ComplexType* x = inputs[row] + n;
+            for (size_t k = first; k <= last; ++k) {
+                float hRe = h[k].real(), hIm = h[k].imag();
+                float xRe = x[-ptrdiff_t(k)].real(), xIm = x[-ptrdiff_t(k)].imag();
+                re += hRe * xRe - hIm * xIm;
+                im += hRe * xIm + hIm * xRe;
+            }
+        }
+
+        output[index] = ComplexType(re, im);
+    }
+}
+
+void
+Convolver::prepare(size_t blockSize)
+{
+    if (blockSize == preparedBlockSize_ && !kernelSpectra_.empty()) return;
+
+    preparedBlockSize_ = blockSize;
+    fwdFFT_.reset(new FwdFFT(vsip::Domain<1>(blockSize), 1.0));
+    invFFT_.reset(new InvFFT(vsip::Domain<1>(blockSize), 1.0 / blockSize));
+    block_.reset(new ComplexVector(blockSize, ComplexType(0.0, 0.0)));
+    spectrum_.reset(new ComplexVector(blockSize));
+    sum_.reset(new ComplexVector(blockSize));
+
+    // Compute and cache the spectrum of each kernel row.
+    //
+    kernelSpectra_.clear();
+    for (size_t row = 0; row < rows_; ++row) {
+        for (size_t index = 0; index < blockSize; ++index) {
+            block_->put(index, index < cols_ ? taps_[row * cols_ + index] : ComplexType(0.0, 0.0));
+        }
+
+        boost::shared_ptr<ComplexVector> spectrum(new ComplexVector(blockSize));
+        (*fwdFFT_)(*block_, *spectrum);
+        kernelSpectra_.push_back(spectrum);
+    }
+}
+
+void
+Convolver::convolveFrequency(const ComplexType* const* inputs, size_t size, ComplexType* output)
+{
+    // Overlap-save: each block holds cols - 1 samples of history followed by blockSize - cols + 1 new samples,
+    // and the last blockSize - cols + 1 samples of its circular convolution are valid linear convolution
+    // samples.
+    //
+    const size_t blockSize = activeBlockSize_;
+    prepare(blockSize);
+
+    const ptrdiff_t history = cols_ - 1;
+    const size_t outputsPerBlock = blockSize - history;
+    const size_t end = offset_ + size;
+    for (size_t first = offset_; first < end; first += outputsPerBlock) {
+        ptrdiff_t start = ptrdiff_t(first) - history;
+        for (size_t row = 0; row < rows_; ++row) {
+            const ComplexType* x = inputs[row];
+            for (size_t index = 0; index < blockSize; ++index) {
+                ptrdiff_t sample = start + ptrdiff_t(index);
+                block_->put(index, (sample >= 0 && sample < ptrdiff_t(size)) ? x[sample] : ComplexType(0.0, 0.0));
+            }
+
+            (*fwdFFT_)(*block_, *spectrum_);
+            if (row == 0) {
+                *sum_ = *spectrum_ * *kernelSpectra_[row];
+            } else {
+                *sum_ += *spectrum_ * *kernelSpectra_[row];
+            }
+        }
+
+        (*invFFT_)(*sum_, *block_);
+
+        size_t count = std::min(outputsPerBlock, end - first);
+        ComplexType* out = output + (first - offset_);
+        for (size_t index = 0; index < count; ++index) out[index] = block_->get(history + index);
+    }
+}
@@ -0,0 +1,185 @@
+#ifndef SIDECAR_ALGORITHMS_CONVOLVER_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_CONVOLVER_H
+
+#include <complex>
+#include <vector>
+
+#include "boost/scoped_ptr.hpp"
+#include "boost/shared_ptr.hpp"
+
+#include <vsip/signal.hpp>
+#include <vsip/vector.hpp>
+
+namespace SideCar {
+namespace Algorithms {
+
+/** Linear convolution engine shared by the filtering algorithms (Filter and LowPassFilter). A kernel has one or
+    more rows of taps; convolve() takes one input row per kernel row, convolves each with its kernel row, and
+    sums the results. A one-row kernel is an ordinary FIR filter; a multi-row kernel applied to the last few
+    PRIs is a 2-D filter over range and time.
+
+    Output sample i is full-convolution sample i + offset, where the offset is given with the kernel. Inputs are
+    treated as zero outside of their extent, so both methods give the same results:
+
+    - kTimeDomain evaluates the sums directly, costing rows * cols multiply-adds per output sample.
+
+    - kFrequencyDomain uses overlap-save with FFT blocks of a power-of-two size. Each block costs one forward
+      FFT per row, a multiply-accumulate of the spectra, and one inverse FFT. The spectra of the kernel rows are
+      computed once per block size and cached until the kernel changes.
+
+    With kAuto, the method and block size are chosen from the kernel and input sizes using a cost model whose
+    constants come from a one-time calibration micro-benchmark run by the first Convolver used in the process.
+*/
+class Convolver {
+public:
+    using ComplexType = std::complex<float>;
+
+    enum Method { kAuto, kTimeDomain, kFrequencyDomain };
+
+    /** Measured costs that drive the automatic choice of method.
+     */
+    struct Calibration {
+        double multiplyAddTime;      ///< Seconds per complex multiply-add in the time-domain loop
+        double multiplyTime;         ///< Seconds per complex spectrum multiply-add
+        std::vector<double> fftTime; ///< Seconds per FFT of size 2^index (0 if not measured)
+    };
+
+    /** Obtain the process-wide calibration, running the micro-benchmark on the first call.
+
+        \return calibration values
+    */
+    static const Calibration& GetCalibration();
+
+    /** \return printable name of a method
+     */
+    static const char* GetMethodName(Method method);
+
+    /** Constructor. The initial kernel is a single all-pass tap.
+     */
+    Convolver();
+
+    /** Install a new kernel. Discards cached kernel spectra.
+
+        \param taps kernel values in row-major order
+
+        \param rows number of kernel rows
+
+        \param offset index of the full convolution sample that becomes output sample 0. Use (cols - 1) / 2 for a
+        centered kernel and cols - 1 to have output sample i depend on input samples i and later.
+    */
+    void setKernel(const std::vector<ComplexType>& taps, size_t rows, size_t offset);
+
+    /** Set the method to use.
+
+        \param method kAuto to choose from the cost model
+    */
+    void setMethod(Method method)
+    {
+        method_ = method;
+        chosenForSize_ = 0;
+    }
+
+    /** Set the FFT block size for the frequency-domain method. Sizes are rounded up to a power of two large
+        enough to hold the kernel.
+
+        \param blockSize FFT size, or 0 to choose from the cost model
+    */
+    void setBlockSize(size_t blockSize)
+    {
+        blockSize_ = blockSize;
+        chosenForSize_ = 0;
+    }
+
+    /** Convolve one set of input rows.
+
+        \param inputs one pointer per kernel row to size input samples
+
+        \param size number of samples in each input row and in the output
+
+        \param output storage for size output samples
+    */
+    void convolve(const ComplexType* const* inputs, size_t size, ComplexType* output);
+
+    /** Estimate the time needed to convolve inputs of a given size.
+
+        \param method kTimeDomain or kFrequencyDomain
+
+        \param size number of samples in each input row
+
+        \param blockSize FFT size for kFrequencyDomain
+
+        \return estimated seconds
+    */
+    double estimateCost(Method method, size_t size, size_t blockSize) const;
+
+    /** \return the number of kernel rows
+     */
+    size_t getRows() const { return rows_; }
+
+    /** \return the number of taps in each kernel row
+     */
+    size_t getCols() const { return cols_; }
+
+    /** \return the method used by the last convolve() call
+     */
+    Method getActiveMethod() const { return activeMethod_; }
+
+    /** \return the FFT block size used by the last convolve() call, or 0 for the time-domain method
+     */
+    size_t getActiveBlockSize() const { return activeMethod_ == kFrequencyDomain ? activeBlockSize_ : 0; }
+
+    /** \return seconds spent in the last convolve() call
+     */
+    double getLastCost() const { return lastCost_; }
+
+private:
+    using ComplexVector = vsip::Vector<ComplexType>;
+    using FwdFFT = vsip::Fft<vsip::const_Vector, ComplexType, ComplexType, vsip::fft_fwd, vsip::by_reference>;
+    using InvFFT = vsip::Fft<vsip::const_Vector, ComplexType, ComplexType, vsip::fft_inv, vsip::by_reference>;
+
+    /** Choose the method and block size for an input size, updating activeMethod_ and activeBlockSize_.
+     */
+    void choose(size_t size);
+
+    /** \return smallest power-of-two FFT size that holds the kernel with room for output
+     */
+    size_t getMinBlockSize() const;
+
+    /** Prepare FFT objects and kernel spectra for a block size.
+     */
+    void prepare(size_t blockSize);
+
+    void convolveTime(const ComplexType* const* inputs, size_t size, ComplexType* output);
+
+    void convolveFrequency(const ComplexType* const* inputs, size_t size, ComplexType* output);
+
+    std::vector<ComplexType> taps_;
+    size_t rows_;
+    size_t cols_;
+    size_t offset_;
+    Method method_;
+    size_t blockSize_;
+
+    Method activeMethod_;
+    size_t activeBlockSize_;
+    size_t chosenForSize_; ///< Input size for which activeMethod_ and activeBlockSize_ were chosen
+    double lastCost_;
+
+    // Frequency-domain state for preparedBlockSize_
+    //
+    size_t preparedBlockSize_;
+    boost::scoped_ptr<FwdFFT> fwdFFT_;
+    boost::scoped_ptr<InvFFT> invFFT_;
+    std::vector<boost::shared_ptr<ComplexVector>> kernelSpectra_;
+    boost::scoped_ptr<ComplexVector> block_;
+    boost::scoped_ptr<ComplexVector> spectrum_;
+    boost::scoped_ptr<ComplexVector> sum_;
+};
+
+} // end namespace Algorithms
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
@@ -0,0 +1,190 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "Convolver.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms;
+
+using ComplexType = Convolver::ComplexType;
+
+class ConvolverTest : public UnitTest::TestObj {
+public:
+    ConvolverTest() : TestObj("Convolver") {}
+
+    void test();
+
+    static ComplexType Random() { return ComplexType(::rand() % 200 - 100, ::rand() % 200 - 100) * 0.01f; }
+
+    /** Direct evaluation of the sums, for comparison.
+     */
+    static void Reference(const std::vector<std::vector<ComplexType>>& inputs, const std::vector<ComplexType>& taps,
+                          size_t rows, size_t offset, std::vector<ComplexType>& output);
+
+    /** Run a random kernel and input through the time and frequency domain methods and compare the results with
+        Reference().
+    */
+    void compare(size_t rows, size_t cols, size_t size, size_t offset, size_t blockSize);
+
+    void testChoice();
+
+    void benchmark(size_t cols, size_t size);
+};
+
+void
+ConvolverTest::Reference(const std::vector<std::vector<ComplexType>>& inputs, const std::vector<ComplexType>& taps,
+                         size_t rows, size_t offset, std::vector<ComplexType>& output)
+{
+    size_t cols = taps.size() / rows;
+    size_t size = inputs[0].size();
+    output.assign(size, ComplexType(0.0, 0.0));
+    for (size_t index = 0; index < size; ++index) {
+        int n = int(index + offset);
+        for (size_t row = 0; row < rows; ++row) {
+            for (size_t k = 0; k < cols; ++k) {
+                int sample = n - int(k);
+                if (sample >= 0 && sample < int(size)) output[index] += taps[row * cols + k] * inputs[row][sample];
+            }
+        }
+    }
+}
+
+void
+ConvolverTest::compare(size_t rows, size_t cols, size_t size, size_t offset, size_t blockSize)
+{
+    std::vector<ComplexType> taps(rows * cols);
+    for (size_t index = 0; index < taps.size(); ++index) taps[index] = Random();
+
+    std::vector<std::vector<ComplexType>> inputs(rows, std::vector<ComplexType>(size));
+    std::vector<const ComplexType*> pointers;
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t index = 0; index < size; ++index) inputs[row][index] = Random();
+        pointers.push_back(&inputs[row][0]);
+    }
+
+    std::vector<ComplexType> expected;
+    Reference(inputs, taps, rows, offset, expected);
+
+    Convolver::Method methods[] = {Convolver::kTimeDomain, Convolver::kFrequencyDomain, Convolver::kAuto};
+    for (Convolver::Method method : methods) {
+        Convolver convolver;
+        convolver.setKernel(taps, rows, offset);
+        convolver.setMethod(method);
+        convolver.setBlockSize(blockSize);
+        assertEqual(rows, convolver.getRows());
+        assertEqual(cols, convolver.getCols());
+
+        // Run twice to exercise the cached kernel spectra.
+        //
+        std::vector<ComplexType> actual(size);
+        for (int pass = 0; pass < 2; ++pass) {
+            convolver.convolve(&pointers[0], size, &actual[0]);
+            if (method != Convolver::kAuto) assertEqual(int(method), int(convolver.getActiveMethod()));
+            for (size_t index = 0; index < size; ++index) {
+                assertEqualEpsilon(expected[index].real(), actual[index].real(), 1.0E-3);
+                assertEqualEpsilon(expected[index].imag(), actual[index].imag(), 1.0E-3);
+            }
+        }
+    }
+}
+
+void
+ConvolverTest::testChoice()
+{
+    // A few taps over a PRI is cheapest in the time domain, and a long kernel in the frequency domain.
+    //
+    std::vector<ComplexType> input(8192, ComplexType(1.0, 0.0));
+    std::vector<ComplexType> output(input.size());
+    const ComplexType* inputs[] = {&input[0]};
+
+    Convolver convolver;
+    convolver.setKernel(std::vector<ComplexType>(3, ComplexType(1.0, 0.0)), 1, 1);
+    convolver.convolve(inputs, input.size(), &output[0]);
+    assertEqual(int(Convolver::kTimeDomain), int(convolver.getActiveMethod()));
+    assertEqual(size_t(0), convolver.getActiveBlockSize());
+    assertEqual(3.0f, output[100].real());
+
+    convolver.setKernel(std::vector<ComplexType>(1024, ComplexType(1.0, 0.0)), 1, 512);
+    convolver.convolve(inputs, input.size(), &output[0]);
+    assertEqual(int(Convolver::kFrequencyDomain), int(convolver.getActiveMethod()));
+    assertTrue(convolver.getActiveBlockSize() >= 2048);
+    assertEqualEpsilon(1024.0f, output[4096].real(), 1.0E-2);
+    assertTrue(convolver.getLastCost() > 0.0);
+
+    // An explicit block size is honored, but rounded up to hold the kernel.
+    //
+    convolver.setMethod(Convolver::kFrequencyDomain);
+    convolver.setBlockSize(100);
+    convolver.convolve(inputs, input.size(), &output[0]);
+    assertEqual(size_t(2048), convolver.getActiveBlockSize());
+}
+
+void
+ConvolverTest::benchmark(size_t cols, size_t size)
+{
+    enum { kReps = 20 };
+    std::vector<ComplexType> taps(cols);
+    for (size_t index = 0; index < cols; ++index) taps[index] = Random();
+    std::vector<ComplexType> input(size);
+    for (size_t index = 0; index < size; ++index) input[index] = Random();
+    std::vector<ComplexType> output(size);
+    const ComplexType* inputs[] = {&input[0]};
+
+    std::clog << "taps: " << cols << " samples: " << size;
+    Convolver::Method methods[] = {Convolver::kTimeDomain, Convolver::kFrequencyDomain, Convolver::kAuto};
+    for (Convolver::Method method : methods) {
+        Convolver convolver;
+        convolver.setKernel(taps, 1, cols / 2);
+        convolver.setMethod(method);
+        convolver.convolve(inputs, size, &output[0]);
+        Time::TimeStamp begin(Time::TimeStamp::Now());
+        for (int rep = 0; rep < kReps; ++rep) convolver.convolve(inputs, size, &output[0]);
+        Time::TimeStamp delta(Time::TimeStamp::Now());
+        delta -= begin;
+        std::clog << ' ' << Convolver::GetMethodName(method) << ": " << delta.asDouble() / kReps;
+        if (method == Convolver::kAuto) {
+            std::clog << " (" << Convolver::GetMethodName(convolver.getActiveMethod()) << ' '
+                      << convolver.getActiveBlockSize() << ')';
+        }
+    }
+
+    std::clog << " sec/PRI" << std::endl;
+}
+
+void
+ConvolverTest::test()
+{
+    vsip::vsipl v;
+    ::srand(2718);
+
+    compare(1, 1, 100, 0, 0);
+    compare(1, 7, 100, 3, 0);
+    compare(1, 7, 100, 6, 0);
+    compare(1, 33, 1000, 16, 0);
+    compare(1, 33, 1000, 16, 64);
+    compare(1, 40, 20, 20, 0);
+    compare(3, 3, 500, 1, 0);
+    compare(5, 30, 2880, 15, 128);
+
+    const Convolver::Calibration& calibration(Convolver::GetCalibration());
+    std::clog << "multiply-add: " << calibration.multiplyAddTime << " spectrum multiply: " << calibration.multiplyTime
+              << " FFT 1024: " << calibration.fftTime[10] << " sec" << std::endl;
+
+    testChoice();
+
+    benchmark(4, 4096);
+    benchmark(32, 4096);
+    benchmark(128, 4096);
+    benchmark(512, 16384);
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return ConvolverTest().mainRun();
+}
@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "CorrelationGrid.h"
+
+using namespace SideCar::Algorithms;
+
+/** Number of slots in the expiry ring. Each slot covers one quarter of the expire age, so a slot is always
+    expired well before the ring wraps around to it again.
+*/
+static const size_t kNumBuckets = 8;
+static const size_t kBucketsPerExpireAge = 4;
+static const int64_t kNoBucket = std::numeric_limits<int64_t>::min();
+static const size_t kMinTableSize = 64;
+
+const CorrelationGrid::Index CorrelationGrid::kNone;
+const CorrelationGrid::Key CorrelationGrid::kUnusedKey;
+
+bool
+CorrelationGrid::Tile::isEmpty() const
+{
+    for (int index = 0; index < kCellsPerTile; ++index) {
+        if (head[index] != kNone) return false;
+    }
+
+    return true;
+}
+
+CorrelationGrid::CorrelationGrid() :
+    radius_(1.0), radius2_(1.0), minAge_(0.0), maxAge_(0.0), expireAge_(0.0), bucketWidth_(1.0), xs_(), ys_(),
+    whens_(), counts_(), cellXs_(), cellYs_(), prev_(), next_(), free_(), newIndices_(), scratch_(),
+    numEntries_(0), table_(), tiles_(), tileKeys_(), hashShift_(0), buckets_(kNumBuckets),
+    bucketIds_(kNumBuckets, kNoBucket)
+{
+    rehash(kMinTableSize);
+}
+
+void
+CorrelationGrid::setRadius(double radius)
+{
+    radius_ = radius > 0.0 ? radius : 1.0;
+    radius2_ = radius_ * radius_;
+    clear();
+}
+
+void
+CorrelationGrid::setAgeLimits(double minAge, double maxAge, double expireAge)
+{
+    minAge_ = minAge;
+    maxAge_ = maxAge;
+    expireAge_ = expireAge;
+    bucketWidth_ = expireAge > 0.0 ? expireAge / kBucketsPerExpireAge : 1.0;
+    clear();
+}
+
+void
+CorrelationGrid::clear()
+{
+    xs_.clear();
+    ys_.clear();
+    whens_.clear();
+    counts_.clear();
+    cellXs_.clear();
+    cellYs_.clear();
+    prev_.clear();
+    next_.clear();
+    free_.clear();
+    numEntries_ = 0;
+    for (size_t index = 0; index < kNumBuckets; ++index) {
+        buckets_[index].clear();
+        bucketIds_[index] = kNoBucket;
+    }
+
+    tiles_.clear();
+    tileKeys_.clear();
+    rehash(kMinTableSize);
+}
+
+int32_t
+CorrelationGrid::getCellIndex(double value) const
+{
+    // Clamp so that wild values do not overflow the cell index.
+    //
+    static const double kLimit = std::numeric_limits<int32_t>::max() / 2;
+    double index = std::floor(value / radius_);
+    if (index > kLimit) return int32_t(kLimit);
+    if (index < -kLimit) return int32_t(-kLimit);
+    return int32_t(index);
+}
+
+CorrelationGrid::Index
+CorrelationGrid::findTile(Key key) const
+{
+    size_t mask = table_.size() - 1;
+    for (size_t slot = getHash(key);; slot = (slot + 1) & mask) {
+        const Slot& entry(table_[slot]);
+        if (entry.key == key) return entry.tile;
+        if (entry.key == kUnusedKey) return kNone;
+    }
+}
+
+CorrelationGrid::Index
+CorrelationGrid::insertTile(Key key)
+{
+    Index found = findTile(key);
+    if (found != kNone) return found;
+
+    // Keep the load factor at or below 1/2 so that probe sequences stay short. When full, drop any empty tiles
+    // and size the table for what remains.
+    //
+    if ((tiles_.size() + 1) * 2 > table_.size()) {
+        size_t used = 0;
+        for (size_t index = 0; index < tiles_.size(); ++index) {
+            if (!tiles_[index].isEmpty()) ++used;
+        }
+
+        size_t capacity = kMinTableSize;
+        while (capacity < (used + 1) * 4) capacity *= 2;
+        rehash(capacity);
+    }
+
+    size_t mask = table_.size() - 1;
+    size_t slot = getHash(key);
+    while (table_[slot].key != kUnusedKey) slot = (slot + 1) & mask;
+    table_[slot].key = key;
+    table_[slot].tile = tiles_.size();
+    tiles_.push_back(Tile());
+    tileKeys_.push_back(key);
+    return table_[slot].tile;
+}
+
+void
+CorrelationGrid::rehash(size_t capacity)
+{
+    table_.assign(capacity, Slot());
+    hashShift_ = 64;
+    for (size_t size = capacity; size > 1; size >>= 1) --hashShift_;
+
+    // Squeeze out the tiles that no longer hold entries, and enter the rest into the new table.
+    //
+    size_t mask = capacity - 1;
+    size_t kept = 0;
+    for (size_t index = 0; index < tiles_.size(); ++index) {
+        if (tiles_[index].isEmpty()) continue;
+        tiles_[kept] = tiles_[index];
+        tileKeys_[kept] = tileKeys_[index];
+        size_t slot = getHash(tileKeys_[kept]);
+        while (table_[slot].key != kUnusedKey) slot = (slot + 1) & mask;
+        table_[slot].key = tileKeys_[kept];
+        table_[slot].tile = kept++;
+    }
+
+    tiles_.resize(kept);
+    tileKeys_.resize(kept);
+}
+
+int
+CorrelationGrid::find(double x, double y, double when) const
+{
+    // Visit the 3x3 block of cells around the position. The order matches that of the original correlators.
+    //
+    static const int kOffsets[9][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {1, -1}, {0, 0}, {0, 1}, {1, 0}, {1, 1}};
+
+    int32_t cx = getCellIndex(x);
+    int32_t cy = getCellIndex(y);
+    Key lastKey = kUnusedKey;
+    Index tile = kNone;
+    for (int index = 0; index < 9; ++index) {
+        int32_t ix = cx + kOffsets[index][0];
+        int32_t iy = cy + kOffsets[index][1];
+
+        // Neighbouring cells are usually in the same tile, so only look up the tile when it changes.
+        //
+        Key key = GetTileKey(ix, iy);
+        if (key != lastKey) {
+            lastKey = key;
+            tile = findTile(key);
+        }
+
+        if (tile == kNone) continue;
+        for (Index entry = tiles_[tile].head[GetCellInTile(ix, iy)]; entry != kNone; entry = next_[entry]) {
+            double age = when - whens_[entry];
+            if (age > maxAge_ || age < minAge_) continue;
+            double dx = x - xs_[entry];
+            double dy = y - ys_[entry];
+            if (dx * dx + dy * dy < radius2_) return entry;
+        }
+    }
+
+    return kNotFound;
+}
+
+size_t
+CorrelationGrid::add(double x, double y, double when, int count)
+{
+    Index entry;
+    if (!free_.empty()) {
+        entry = free_.back();
+        free_.pop_back();
+    } else {
+        entry = xs_.size();
+        xs_.push_back(0.0);
+        ys_.push_back(0.0);
+        whens_.push_back(0.0);
+        counts_.push_back(0);
+        cellXs_.push_back(0);
+        cellYs_.push_back(0);
+        prev_.push_back(kNone);
+        next_.push_back(kNone);
+    }
+
+    int32_t ix = getCellIndex(x);
+    int32_t iy = getCellIndex(y);
+    xs_[entry] = x;
+    ys_[entry] = y;
+    whens_[entry] = when;
+    counts_[entry] = count;
+    cellXs_[entry] = ix;
+    cellYs_[entry] = iy;
+    ++numEntries_;
+
+    // Append to the end of the cell's chain so that chains stay in arrival order.
+    //
+    Tile& tile(tiles_[insertTile(GetTileKey(ix, iy))]);
+    int cell = GetCellInTile(ix, iy);
+    prev_[entry] = tile.tail[cell];
+    next_[entry] = kNone;
+    if (tile.tail[cell] != kNone) {
+        next_[tile.tail[cell]] = entry;
+    } else {
+        tile.head[cell] = entry;
+    }
+
+    tile.tail[cell] = entry;
+
+    // File the entry in the expiry ring. A slot holding a bucket from an earlier pass around the ring only has
+    // entries that are long past their expire age, so empty it first.
+    //
+    int64_t bucketId = int64_t(std::floor(when / bucketWidth_));
+    size_t slot = size_t(((bucketId % int64_t(kNumBuckets)) + kNumBuckets) % kNumBuckets);
+    if (bucketIds_[slot] == kNoBucket || bucketIds_[slot] < bucketId) {
+        expireBucket(slot);
+        bucketIds_[slot] = bucketId;
+    }
+
+    buckets_[slot].push_back(entry);
+    return entry;
+}
+
+void
+CorrelationGrid::expire(double now)
+{
+    // A bucket may go once its newest possible time stamp is older than the expire age.
+    //
+    double limit = now - expireAge_;
+    bool expired = false;
+    for (size_t slot = 0; slot < kNumBuckets; ++slot) {
+        if (bucketIds_[slot] != kNoBucket && (bucketIds_[slot] + 1) * bucketWidth_ <= limit) {
+            expireBucket(slot);
+            expired = true;
+        }
+    }
+
+    // Entries arrive in time order, so the entries of a cell are scattered across the arrays. Gather them
+    // together once a good share of the arrays has been freed; this happens a few times per expire age, and the
+    // entries gathered are the ones that will be old enough to match.
+    //
+    if (expired && free_.size() * 4 > numEntries_) compact();
+}
+
+void
+CorrelationGrid::expireBucket(size_t slot)
+{
+    std::vector<Index>& bucket(buckets_[slot]);
+    for (size_t index = 0; index < bucket.size(); ++index) remove(bucket[index]);
+    bucket.clear();
+    bucketIds_[slot] = kNoBucket;
+}
+
+void
+CorrelationGrid::remove(Index entry)
+{
+    Tile& tile(tiles_[findTile(GetTileKey(cellXs_[entry], cellYs_[entry]))]);
+    int cell = GetCellInTile(cellXs_[entry], cellYs_[entry]);
+    if (prev_[entry] != kNone) {
+        next_[prev_[entry]] = next_[entry];
+    } else {
+        tile.head[cell] = next_[entry];
+    }
+
+    if (next_[entry] != kNone) {
+        prev_[next_[entry]] = prev_[entry];
+    } else {
+        tile.tail[cell] = prev_[entry];
+    }
+
+    free_.push_back(entry);
+    --numEntries_;
+}
+
+template <typename T>
+void
+CorrelationGrid::reorder(std::vector<T>& values)
+{
+    // Use the scratch byte buffer as temporary storage so that nothing is allocated once it is big enough.
+    //
+    scratch_.resize(numEntries_ * sizeof(T));
+    T* temp = reinterpret_cast<T*>(&scratch_[0]);
+    for (size_t index = 0; index < newIndices_.size(); ++index) {
+        if (newIndices_[index] != kNone) temp[newIndices_[index]] = values[index];
+    }
+
+    values.resize(numEntries_);
+    std::copy(temp, temp + numEntries_, values.begin());
+}
+
+void
+CorrelationGrid::compact()
+{
+    // Assign new indices by walking each cell's chain, and fix up the cell heads and tails.
+    //
+    newIndices_.assign(xs_.size(), kNone);
+    Index next = 0;
+    for (size_t index = 0; index < tiles_.size(); ++index) {
+        Tile& tile(tiles_[index]);
+        for (int cell = 0; cell < kCellsPerTile; ++cell) {
+            if (tile.head[cell] == kNone) continue;
+            Index first = next;
+            for (Index entry = tile.head[cell]; entry != kNone; entry = next_[entry]) newIndices_[entry] = next++;
+            tile.head[cell] = first;
+            tile.tail[cell] = next - 1;
+        }
+    }
+
+    if (numEntries_) {
+        reorder(xs_);
+        reorder(ys_);
+        reorder(whens_);
+        reorder(counts_);
+        reorder(cellXs_);
+        reorder(cellYs_);
+    } else {
+        xs_.clear();
+        ys_.clear();
+        whens_.clear();
+        counts_.clear();
+        cellXs_.clear();
+        cellYs_.clear();
+    }
+
+    // Chains are now runs of consecutive indices.
+    //
+    prev_.resize(numEntries_);
+    next_.resize(numEntries_);
+    for (size_t index = 0; index < tiles_.size(); ++index) {
+        const Tile& tile(tiles_[index]);
+        for (int cell = 0; cell < kCellsPerTile; ++cell) {
+            if (tile.head[cell] == kNone) continue;
+            for (Index entry = tile.head[cell]; entry <= tile.tail[cell]; ++entry) {
+                prev_[entry] = entry == tile.head[cell] ? kNone : entry - 1;
+                next_[entry] = entry == tile.tail[cell] ? kNone : entry + 1;
+            }
+        }
+    }
+
+    for (size_t slot = 0; slot < kNumBuckets; ++slot) {
+        std::vector<Index>& bucket(buckets_[slot]);
+        for (size_t index = 0; index < bucket.size(); ++index) bucket[index] = newIndices_[bucket[index]];
+    }
+
+    free_.clear();
+}
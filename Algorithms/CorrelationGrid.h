@@ -0,0 +1,234 @@
+#ifndef SIDECAR_ALGORITHMS_CORRELATIONGRID_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_CORRELATIONGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SideCar {
+namespace Algorithms {
+
+/** Spatial index of recent extraction reports, used by the scan-to-scan correlators (ScanCorrelator and
+    TrackInitiator). Each entry holds an X/Y position, a time stamp, and a correlation count. find() locates the
+    first entry within the search radius of a position whose age falls within a configured window.
+
+    The plane is divided into square cells the size of the search radius, so any match for a point lies in the
+    3x3 block of cells around it. Cells are grouped into 4x4 tiles that live in an open-addressing hash table
+    keyed by tile index, so the grid is unbounded, only occupied tiles cost memory, and a 3x3 neighbourhood
+    usually needs only one or two table lookups. Entry fields are kept in separate contiguous arrays
+    (structure of arrays), and the entries of a cell are chained in arrival order by index. Entries are also
+    filed in a ring of time buckets, so expiring old entries visits only the buckets that have aged out.
+
+    After the arrays have grown to their working size, add(), find() and expire() do no memory allocation.
+*/
+class CorrelationGrid {
+public:
+    enum { kNotFound = -1 };
+
+    /** Constructor.
+     */
+    CorrelationGrid();
+
+    /** Set the search radius. Removes all entries since the cell layout changes.
+
+        \param radius maximum distance between correlated entries
+    */
+    void setRadius(double radius);
+
+    /** Set the age window for matches and the age after which entries are removed. Removes all entries since
+        the expiry ring layout changes.
+
+        \param minAge minimum age of an entry (inclusive) for it to match
+
+        \param maxAge maximum age of an entry (inclusive) for it to match
+
+        \param expireAge age beyond which an entry is removed by expire()
+    */
+    void setAgeLimits(double minAge, double maxAge, double expireAge);
+
+    /** Remove all entries.
+     */
+    void clear();
+
+    /** Locate the first entry that correlates with the given position and time. Cells are searched in a fixed
+        order, and entries within a cell from oldest to newest.
+
+        \param x X coordinate of the position
+
+        \param y Y coordinate of the position
+
+        \param when time of the position
+
+        \return entry index, or kNotFound
+    */
+    int find(double x, double y, double when) const;
+
+    /** Add an entry.
+
+        \param x X coordinate of the position
+
+        \param y Y coordinate of the position
+
+        \param when time of the position
+
+        \param count correlation count to record
+
+        \return index of the new entry
+    */
+    size_t add(double x, double y, double when, int count);
+
+    /** Remove all entries whose age is greater than the expire age.
+
+        \param now the current time
+    */
+    void expire(double now);
+
+    /** \return number of entries in the grid
+     */
+    size_t size() const { return numEntries_; }
+
+    /** \return number of tiles in the hash table
+     */
+    size_t getNumTiles() const { return tiles_.size(); }
+
+    double getX(size_t entry) const { return xs_[entry]; }
+
+    double getY(size_t entry) const { return ys_[entry]; }
+
+    double getWhen(size_t entry) const { return whens_[entry]; }
+
+    int getCount(size_t entry) const { return counts_[entry]; }
+
+private:
+    using Key = int64_t;
+    using Index = uint32_t;
+
+    static const Index kNone = 0xFFFFFFFF;
+    static const Key kUnusedKey = INT64_MIN;
+
+    enum {
+        kTileShift = 2,
+        kTileSize = 1 << kTileShift,
+        kTileMask = kTileSize - 1,
+        kCellsPerTile = kTileSize * kTileSize
+    };
+
+    /** Hash table slot. The tile contents are kept apart from the keys so that probing touches as little memory
+        as possible.
+     */
+    struct Slot {
+        Slot() : key(kUnusedKey), tile(kNone) {}
+        Key key;    ///< Tile index, or kUnusedKey if the slot is unused
+        Index tile; ///< Index into tiles_
+    };
+
+    /** Entry chains for a tile of cells.
+     */
+    struct Tile {
+        Tile()
+        {
+            for (int index = 0; index < kCellsPerTile; ++index) head[index] = tail[index] = kNone;
+        }
+        bool isEmpty() const;
+        Index head[kCellsPerTile]; ///< First (oldest) entry in each cell, or kNone
+        Index tail[kCellsPerTile]; ///< Last (newest) entry in each cell, or kNone
+    };
+
+    int32_t getCellIndex(double value) const;
+
+    static Key MakeKey(int32_t x, int32_t y) { return Key((uint64_t(uint32_t(x)) << 32) | uint32_t(y)); }
+
+    static Key GetTileKey(int32_t x, int32_t y) { return MakeKey(x >> kTileShift, y >> kTileShift); }
+
+    static int GetCellInTile(int32_t x, int32_t y) { return ((x & kTileMask) << kTileShift) | (y & kTileMask); }
+
+    size_t getHash(Key key) const { return size_t((uint64_t(key) * 0x9E3779B97F4A7C15ULL) >> hashShift_); }
+
+    /** Locate a tile.
+
+        \param key the tile to look for
+
+        \return index into tiles_, or kNone if the tile is not in the table
+    */
+    Index findTile(Key key) const;
+
+    /** Locate a tile, adding it if necessary.
+
+        \param key the tile to look for
+
+        \return index into tiles_
+    */
+    Index insertTile(Key key);
+
+    /** Rebuild the hash table with the given capacity, dropping tiles that no longer hold any entries.
+
+        \param capacity new table size (power of 2)
+    */
+    void rehash(size_t capacity);
+
+    /** Unlink an entry from its cell and put it on the free list.
+
+        \param entry the entry to remove
+    */
+    void remove(Index entry);
+
+    /** Remove all entries in a ring bucket.
+
+        \param slot the ring slot to empty
+    */
+    void expireBucket(size_t slot);
+
+    /** Renumber the entries so that the entries of each cell are adjacent in the entry arrays, which makes the
+        chain walks in find() sequential memory accesses. Also drops the free list.
+    */
+    void compact();
+
+    /** Reorder one entry array using the mapping in newIndices_.
+
+        \param values the array to reorder
+    */
+    template <typename T>
+    void reorder(std::vector<T>& values);
+
+    double radius_;
+    double radius2_;
+    double minAge_;
+    double maxAge_;
+    double expireAge_;
+    double bucketWidth_;
+
+    // Entry storage (structure of arrays)
+    //
+    std::vector<double> xs_;
+    std::vector<double> ys_;
+    std::vector<double> whens_;
+    std::vector<int> counts_;
+    std::vector<int32_t> cellXs_;
+    std::vector<int32_t> cellYs_;
+    std::vector<Index> prev_;
+    std::vector<Index> next_;
+    std::vector<Index> free_;
+    std::vector<Index> newIndices_; ///< Scratch space for compact()
+    std::vector<char> scratch_;     ///< Scratch space for compact()
+    size_t numEntries_;
+
+    // Open-addressing tile table
+    //
+    std::vector<Slot> table_;
+    std::vector<Tile> tiles_;    ///< Tile contents (including tiles that became empty)
+    std::vector<Key> tileKeys_; ///< Key of each tile in tiles_
+    int hashShift_;
+
+    // Expiry ring
+    //
+    std::vector<std::vector<Index>> buckets_;
+    std::vector<int64_t> bucketIds_;
+};
+
+} // end namespace Algorithms
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
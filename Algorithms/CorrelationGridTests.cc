@@ -0,0 +1,234 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <vector>
+
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "CorrelationGrid.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms;
+
+/** Reference implementation of the correlation buffer formerly used by ScanCorrelator and TrackInitiator: a
+    fixed [x][y] array of cells sized by the maximum range, each holding a std::list of entries that are lazily
+    erased when visited.
+*/
+class ListGrid {
+public:
+    struct Data {
+        double x, y, when;
+        int count;
+    };
+
+    ListGrid(double rMax, double radius, double minAge, double maxAge, double expireAge) :
+        radius_(radius), radius2_(radius * radius), minAge_(minAge), maxAge_(maxAge), expireAge_(expireAge),
+        indexOffset_(int(::ceil(rMax / radius)) + 1), numBins_(2 * indexOffset_ + 2),
+        buffer_(numBins_, std::vector<Entry>(numBins_))
+    {
+    }
+
+    /** Correlate and add a new position. Returns the correlation count of the new entry, or -1 if no match.
+     */
+    int correlate(double x, double y, double when)
+    {
+        int binX = int(::floor(x / radius_)) + indexOffset_ + 1;
+        int binY = int(::floor(y / radius_)) + indexOffset_ + 1;
+        Data d = {x, y, when, 0};
+        int found = -1;
+        static const int kOffsets[9][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {1, -1},
+                                           {0, 0},   {0, 1},  {1, 0},  {1, 1}};
+        for (int index = 0; index < 9 && found == -1; ++index) {
+            found = corrCell(d, buffer_[binX + kOffsets[index][0]][binY + kOffsets[index][1]]);
+        }
+
+        d.count = found == -1 ? 0 : found + 1;
+        buffer_[binX][binY].push_back(d);
+        return found == -1 ? -1 : d.count;
+    }
+
+private:
+    using Entry = std::list<Data>;
+
+    int corrCell(const Data& d, Entry& candidates)
+    {
+        Entry::iterator ci = candidates.begin();
+        while (ci != candidates.end()) {
+            double delta = d.when - ci->when;
+            if (delta > maxAge_) {
+                if (delta > expireAge_) {
+                    ci = candidates.erase(ci);
+                } else {
+                    ++ci;
+                }
+                continue;
+            }
+
+            if (delta < minAge_) {
+                ++ci;
+                continue;
+            }
+
+            double dx = d.x - ci->x;
+            double dy = d.y - ci->y;
+            if (dx * dx + dy * dy < radius2_) return ci->count;
+            ++ci;
+        }
+
+        return -1;
+    }
+
+    double radius_, radius2_, minAge_, maxAge_, expireAge_;
+    int indexOffset_;
+    int numBins_;
+    std::vector<std::vector<Entry>> buffer_;
+};
+
+class CorrelationGridTest : public UnitTest::TestObj {
+public:
+    enum { kNumScans = 6 };
+
+    CorrelationGridTest() : TestObj("CorrelationGrid") {}
+
+    void test();
+
+    void testBasics();
+
+    /** Generate kNumScans scans of extractions from numTargets slowly-moving targets plus as many random
+        clutter points, and run them through both CorrelationGrid and ListGrid. Verifies that the results match
+        and reports the time per scan of each.
+    */
+    void compare(size_t numTargets);
+
+    static double Random(double range) { return (::rand() / (RAND_MAX + 1.0) * 2.0 - 1.0) * range; }
+};
+
+void
+CorrelationGridTest::testBasics()
+{
+    CorrelationGrid grid;
+    grid.setRadius(5.0);
+    grid.setAgeLimits(5.0, 15.0, 20.0);
+    assertEqual(size_t(0), grid.size());
+
+    // Too new to match itself.
+    //
+    size_t first = grid.add(1.0, 1.0, 0.0, 0);
+    assertEqual(int(CorrelationGrid::kNotFound), grid.find(1.0, 1.0, 1.0));
+
+    // Match across a cell boundary, but not beyond the radius.
+    //
+    assertEqual(int(first), grid.find(-2.0, 2.0, 10.0));
+    assertEqual(int(CorrelationGrid::kNotFound), grid.find(7.0, 1.0, 10.0));
+
+    // Negative coordinates and the count field.
+    //
+    size_t second = grid.add(-100.0, -100.0, 1.0, 3);
+    assertEqual(int(second), grid.find(-101.0, -99.0, 11.0));
+    assertEqual(3, grid.getCount(second));
+    assertEqual(size_t(2), grid.size());
+
+    // Too old to match, but not yet expired.
+    //
+    assertEqual(int(CorrelationGrid::kNotFound), grid.find(1.0, 1.0, 16.0));
+    grid.expire(16.0);
+    assertEqual(size_t(2), grid.size());
+
+    // Expired.
+    //
+    grid.expire(40.0);
+    assertEqual(size_t(0), grid.size());
+
+    // Entries are reused after expiry, and chains keep arrival order.
+    //
+    size_t a = grid.add(0.5, 0.5, 100.0, 1);
+    size_t b = grid.add(0.6, 0.6, 100.5, 2);
+    assertEqual(size_t(2), grid.size());
+    assertTrue(a < 2 && b < 2);
+    assertEqual(int(a), grid.find(0.5, 0.5, 110.0));
+}
+
+void
+CorrelationGridTest::compare(size_t numTargets)
+{
+    static const double kRangeMax = 300.0;
+    static const double kRadius = 2.0;
+    static const double kScanTime = 10.0;
+
+    ::srand(314159);
+    std::vector<double> xs(numTargets), ys(numTargets);
+    for (size_t index = 0; index < numTargets; ++index) {
+        xs[index] = Random(kRangeMax * 0.7);
+        ys[index] = Random(kRangeMax * 0.7);
+    }
+
+    // Build the scans up front so that only correlation is timed.
+    //
+    std::vector<ListGrid::Data> reports;
+    for (int scan = 0; scan < kNumScans; ++scan) {
+        for (size_t index = 0; index < numTargets; ++index) {
+            double when = scan * kScanTime + kScanTime * index / numTargets;
+            ListGrid::Data target = {xs[index] + scan * 0.1, ys[index], when, 0};
+            ListGrid::Data clutter = {Random(kRangeMax * 0.7), Random(kRangeMax * 0.7), when, 0};
+            reports.push_back(target);
+            reports.push_back(clutter);
+        }
+    }
+
+    std::vector<int> expected(reports.size());
+    ListGrid reference(kRangeMax, kRadius, kScanTime / 2, kScanTime * 1.5, kScanTime * 2);
+    Time::TimeStamp begin(Time::TimeStamp::Now());
+    for (size_t index = 0; index < reports.size(); ++index) {
+        const ListGrid::Data& d(reports[index]);
+        expected[index] = reference.correlate(d.x, d.y, d.when);
+    }
+
+    Time::TimeStamp listDelta(Time::TimeStamp::Now());
+    listDelta -= begin;
+
+    std::vector<int> actual(reports.size());
+    CorrelationGrid grid;
+    grid.setRadius(kRadius);
+    grid.setAgeLimits(kScanTime / 2, kScanTime * 1.5, kScanTime * 2);
+    begin = Time::TimeStamp::Now();
+    size_t perScan = numTargets * 2;
+    for (size_t index = 0; index < reports.size(); ++index) {
+        const ListGrid::Data& d(reports[index]);
+        if (index % (perScan / 10) == 0) grid.expire(d.when);
+        int found = grid.find(d.x, d.y, d.when);
+        int count = found == CorrelationGrid::kNotFound ? 0 : grid.getCount(found) + 1;
+        grid.add(d.x, d.y, d.when, count);
+        actual[index] = found == CorrelationGrid::kNotFound ? -1 : count;
+    }
+
+    Time::TimeStamp gridDelta(Time::TimeStamp::Now());
+    gridDelta -= begin;
+
+    size_t correlated = 0;
+    for (size_t index = 0; index < reports.size(); ++index) {
+        assertEqual(expected[index], actual[index]);
+        if (actual[index] > 0) ++correlated;
+    }
+
+    std::clog << "extractions/scan: " << perScan << " correlated: " << correlated
+              << " list: " << listDelta.asDouble() / kNumScans
+              << " grid: " << gridDelta.asDouble() / kNumScans << " sec/scan"
+              << " entries: " << grid.size() << " tiles: " << grid.getNumTiles() << std::endl;
+}
+
+void
+CorrelationGridTest::test()
+{
+    testBasics();
+    compare(500);
+    compare(5000);
+    compare(50000);
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return CorrelationGridTest().mainRun();
+}
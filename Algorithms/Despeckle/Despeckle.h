@@ -36,6 +36,13 @@ public:
 
     bool reset();
 
+    /** Replicas are safe as long as they are configured with an overlap of at least 2, the number of PRIs
+        before the one being filtered that Despeckle looks at.
+
+        \return true
+    */
+    bool isReplicaSafe() const { return true; }
+
     void setVarianceMultiplier(double value) { varianceMultiplier_->setValue(value); }
 
 private:
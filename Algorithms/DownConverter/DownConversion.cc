@@ -0,0 +1,181 @@
+#include <cmath>
+
+#include "DownConversion.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SIDECAR_DOWNCONVERSION_AVX2 1
+#endif
+
+using namespace SideCar::Algorithms::DownConverterUtils;
+
+DownConversion::DownConversion(Path path) : path_(path), products_()
+{
+    if (path_ == kAuto || (path_ == kAVX2 && !HasAVX2())) path_ = HasAVX2() ? kAVX2 : kScalar;
+}
+
+bool
+DownConversion::HasAVX2()
+{
+#ifdef SIDECAR_DOWNCONVERSION_AVX2
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return hasAVX2;
+#else
+    return false;
+#endif
+}
+
+void
+DownConversion::process(const int16_t* rx, const int16_t* coho, size_t numSamples, float alpha, int16_t* out)
+{
+    if (!numSamples) return;
+
+    products_.resize(numSamples * 2);
+
+    double power;
+#ifdef SIDECAR_DOWNCONVERSION_AVX2
+    if (path_ == kAVX2) {
+        power = filterAVX2(rx, coho, numSamples, alpha);
+    } else
+#endif
+    {
+        float yRe = rx[0];
+        float yIm = rx[1];
+        power = filterScalar(rx, coho, 0, numSamples, alpha, &yRe, &yIm);
+    }
+
+    // Scale by the RMS magnitude of the COHO. A dead COHO channel yields zeros rather than a division by zero.
+    //
+    float scale = power > 0.0 ? float(1.0 / ::sqrt(power / numSamples)) : 0.0f;
+
+#ifdef SIDECAR_DOWNCONVERSION_AVX2
+    if (path_ == kAVX2) {
+        packAVX2(numSamples, scale, out);
+        return;
+    }
+#endif
+
+    packScalar(0, numSamples, scale, out);
+}
+
+float
+DownConversion::filterScalar(const int16_t* rx, const int16_t* coho, size_t begin, size_t end, float alpha,
+                             float* yRe, float* yIm)
+{
+    float power = 0.0f;
+    float re = *yRe;
+    float im = *yIm;
+    float* product = products_.data() + 2 * begin;
+    for (size_t index = begin; index < end; ++index) {
+        re += alpha * (rx[2 * index] - re);
+        im += alpha * (rx[2 * index + 1] - im);
+        float cRe = coho[2 * index];
+        float cIm = coho[2 * index + 1];
+        power += cRe * cRe + cIm * cIm;
+        *product++ = re * cRe + im * cIm;
+        *product++ = im * cRe - re * cIm;
+    }
+
+    *yRe = re;
+    *yIm = im;
+    return power;
+}
+
+void
+DownConversion::packScalar(size_t begin, size_t end, float scale, int16_t* out) const
+{
+    for (size_t index = 2 * begin; index < 2 * end; ++index) {
+        float value = products_[index] * scale;
+        value = value < -32768.0f ? -32768.0f : (value > 32767.0f ? 32767.0f : value);
+        out[index] = int16_t(::lrintf(value));
+    }
+}
+
+#ifdef SIDECAR_DOWNCONVERSION_AVX2
+
+__attribute__((target("avx2,fma"))) float
+DownConversion::filterAVX2(const int16_t* rx, const int16_t* coho, size_t numSamples, float alpha)
+{
+    // Each vector holds four I/Q pairs. Within a block, z[k] = alpha * x[k] + beta * z[k - 1] is computed as a
+    // prefix scan in two steps (shift by one pair, then by two), and y[k] = z[k] + beta^(k+1) * y[-1] adds in the
+    // filter state from the previous block.
+    //
+    const float beta = 1.0f - alpha;
+    const float beta2 = beta * beta;
+    const __m256 alphas = _mm256_set1_ps(alpha);
+    const __m256 shift1Coeffs = _mm256_setr_ps(0.0f, 0.0f, beta, beta, beta, beta, beta, beta);
+    const __m256 shift2Coeffs = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 0.0f, beta2, beta2, beta2, beta2);
+    const __m256 carryCoeffs =
+        _mm256_setr_ps(beta, beta, beta2, beta2, beta2 * beta, beta2 * beta, beta2 * beta2, beta2 * beta2);
+    const __m256i shift1 = _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5);
+    const __m256i shift2 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3);
+    const __m256i lastPair = _mm256_setr_epi32(6, 7, 6, 7, 6, 7, 6, 7);
+    const __m256 conjSigns = _mm256_setr_ps(1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f);
+
+    // Start with y[-1] = x[0] so that y[0] = x[0].
+    //
+    __m256 carry = _mm256_setr_ps(rx[0], rx[1], rx[0], rx[1], rx[0], rx[1], rx[0], rx[1]);
+    __m256 power = _mm256_setzero_ps();
+    float* product = &products_[0];
+    size_t index = 0;
+    for (; index + 4 <= numSamples; index += 4) {
+        __m256 x = _mm256_cvtepi32_ps(
+            _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rx + 2 * index))));
+        __m256 c = _mm256_cvtepi32_ps(
+            _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(coho + 2 * index))));
+        power = _mm256_fmadd_ps(c, c, power);
+
+        __m256 z = _mm256_mul_ps(alphas, x);
+        z = _mm256_fmadd_ps(shift1Coeffs, _mm256_permutevar8x32_ps(z, shift1), z);
+        z = _mm256_fmadd_ps(shift2Coeffs, _mm256_permutevar8x32_ps(z, shift2), z);
+        __m256 y = _mm256_fmadd_ps(carryCoeffs, carry, z);
+        carry = _mm256_permutevar8x32_ps(y, lastPair);
+
+        // y * conj(c) = (yRe * cRe + yIm * cIm, yIm * cRe - yRe * cIm)
+        //
+        __m256 cRe = _mm256_moveldup_ps(c);
+        __m256 cIm = _mm256_mul_ps(_mm256_movehdup_ps(c), conjSigns);
+        __m256 ySwapped = _mm256_permute_ps(y, 0xB1);
+        __m256 p = _mm256_fmadd_ps(y, cRe, _mm256_mul_ps(ySwapped, cIm));
+        _mm256_storeu_ps(product + 2 * index, p);
+    }
+
+    // Horizontal sum of the power accumulator.
+    //
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(power), _mm256_extractf128_ps(power, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    float total = _mm_cvtss_f32(sum);
+
+    float yRe = _mm256_cvtss_f32(carry);
+    float yIm = _mm256_cvtss_f32(_mm256_permute_ps(carry, 0x01));
+    return total + filterScalar(rx, coho, index, numSamples, alpha, &yRe, &yIm);
+}
+
+__attribute__((target("avx2,fma"))) void
+DownConversion::packAVX2(size_t numSamples, float scale, int16_t* out) const
+{
+    const __m256 scales = _mm256_set1_ps(scale);
+    const __m256 lower = _mm256_set1_ps(-32768.0f);
+    const __m256 upper = _mm256_set1_ps(32767.0f);
+    const float* product = &products_[0];
+    size_t count = numSamples * 2;
+    size_t index = 0;
+    for (; index + 16 <= count; index += 16) {
+        __m256 v0 = _mm256_mul_ps(_mm256_loadu_ps(product + index), scales);
+        __m256 v1 = _mm256_mul_ps(_mm256_loadu_ps(product + index + 8), scales);
+        v0 = _mm256_min_ps(_mm256_max_ps(v0, lower), upper);
+        v1 = _mm256_min_ps(_mm256_max_ps(v1, lower), upper);
+
+        // Conversion rounds to nearest even like rint(). The pack works within 128-bit lanes, so put the 64-bit
+        // groups back in order afterwards.
+        //
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(v0), _mm256_cvtps_epi32(v1));
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + index), packed);
+    }
+
+    packScalar(index / 2, numSamples, scale, out);
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SIDECAR_ALGORITHMS_DOWNCONVERTER_DOWNCONVERSION_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_DOWNCONVERTER_DOWNCONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SideCar {
+namespace Algorithms {
+namespace DownConverterUtils {
+
+/** Fused down-conversion kernel for DownConverter. Takes interleaved int16 I/Q samples from the receive and COHO
+    channels and produces interleaved int16 I/Q samples of
+
+        out[i] = lpf(rx)[i] * conj(coho[i]) / sqrt(mean(|coho|^2))
+
+    where lpf is the single-pole low-pass filter y[i] = y[i-1] + alpha * (x[i] - y[i-1]), with y[0] = x[0].
+
+    The first pass reads both inputs once, converting, filtering, multiplying, and accumulating the COHO power
+    as it goes, and leaves the unscaled products in a scratch buffer that is reused from PRI to PRI. The second
+    pass scales, rounds, and saturates the products into the output. Both passes work on the interleaved layout,
+    so there is no separate de-interleave step.
+
+    The AVX2 path runs the filter four samples at a time: within a block the filter is a prefix scan done with
+    two shift-and-multiply steps, and the state carried in from the previous block is added back scaled by the
+    powers of (1 - alpha). It is chosen at runtime when the processor supports AVX2 and FMA. Its results can
+    differ from the scalar path by one count where the rounding of a product is close to a half.
+*/
+class DownConversion {
+public:
+    enum Path { kAuto, kScalar, kAVX2 };
+
+    /** Constructor.
+
+        \param path implementation to use. kAuto picks kAVX2 if the processor supports it.
+    */
+    DownConversion(Path path = kAuto);
+
+    /** \return the implementation in use
+     */
+    Path getPath() const { return path_; }
+
+    /** \return true if the processor (and compiler) support the AVX2 path
+     */
+    static bool HasAVX2();
+
+    /** Down-convert one PRI.
+
+        \param rx interleaved I/Q samples from the receive channel
+
+        \param coho interleaved I/Q samples from the COHO channel
+
+        \param numSamples number of I/Q pairs in each input
+
+        \param alpha low-pass filter coefficient
+
+        \param out storage for 2 * numSamples output values
+    */
+    void process(const int16_t* rx, const int16_t* coho, size_t numSamples, float alpha, int16_t* out);
+
+private:
+    float filterScalar(const int16_t* rx, const int16_t* coho, size_t begin, size_t end, float alpha, float* yRe,
+                       float* yIm);
+
+    void packScalar(size_t begin, size_t end, float scale, int16_t* out) const;
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    float filterAVX2(const int16_t* rx, const int16_t* coho, size_t numSamples, float alpha);
+
+    void packAVX2(size_t numSamples, float scale, int16_t* out) const;
+#endif
+
+    Path path_;
+    std::vector<float> products_;
+};
+
+} // end namespace DownConverterUtils
+} // end namespace Algorithms
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
@@ -0,0 +1,172 @@
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "DownConversion.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms::DownConverterUtils;
+
+struct Test : public UnitTest::TestObj {
+    Test() : UnitTest::TestObj("DownConversion") {}
+
+    void test();
+
+    /** The processing formerly done by DownConverter::process, one pass per step: de-interleave, low-pass
+        filter, mean-square of the COHO, conjugate multiply, and round.
+    */
+    static void Reference(const std::vector<int16_t>& rx, const std::vector<int16_t>& coho, float alpha,
+                          std::vector<int16_t>& out);
+
+    static void MakeInput(size_t numSamples, std::vector<int16_t>& rx, std::vector<int16_t>& coho);
+
+    /** Verify that the kernel output is within one count of the reference for all paths available.
+     */
+    void compare(size_t numSamples, float alpha);
+
+    void testEdges();
+
+    void benchmark(size_t numSamples);
+};
+
+void
+Test::Reference(const std::vector<int16_t>& rx, const std::vector<int16_t>& coho, float alpha,
+                std::vector<int16_t>& out)
+{
+    using ComplexType = std::complex<float>;
+    size_t numSamples = coho.size() / 2;
+    std::vector<ComplexType> rxVec(numSamples);
+    std::vector<ComplexType> cohoVec(numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+        rxVec[i] = ComplexType(rx[2 * i], rx[2 * i + 1]);
+        cohoVec[i] = ComplexType(coho[2 * i], coho[2 * i + 1]);
+    }
+
+    for (size_t i = 1; i < numSamples; ++i) rxVec[i] = rxVec[i - 1] + alpha * (rxVec[i] - rxVec[i - 1]);
+
+    float sum = 0.0;
+    for (size_t i = 0; i < numSamples; ++i) sum += std::norm(cohoVec[i]);
+    float avgMag = std::sqrt(sum / numSamples);
+
+    for (size_t i = 0; i < numSamples; ++i) rxVec[i] = rxVec[i] * (std::conj(cohoVec[i]) / avgMag);
+
+    out.clear();
+    for (size_t i = 0; i < numSamples; ++i) {
+        out.push_back(int16_t(::rint(rxVec[i].real())));
+        out.push_back(int16_t(::rint(rxVec[i].imag())));
+    }
+}
+
+void
+Test::MakeInput(size_t numSamples, std::vector<int16_t>& rx, std::vector<int16_t>& coho)
+{
+    // A COHO tone and a noisy received signal at a nearby frequency, both well inside the int16 range.
+    //
+    rx.resize(numSamples * 2);
+    coho.resize(numSamples * 2);
+    for (size_t i = 0; i < numSamples; ++i) {
+        double phase = 0.31 * i;
+        coho[2 * i] = int16_t(2000.0 * ::cos(phase));
+        coho[2 * i + 1] = int16_t(2000.0 * ::sin(phase));
+        rx[2 * i] = int16_t(1000.0 * ::cos(phase + 0.02 * i) + ::rand() % 200 - 100);
+        rx[2 * i + 1] = int16_t(1000.0 * ::sin(phase + 0.02 * i) + ::rand() % 200 - 100);
+    }
+}
+
+void
+Test::compare(size_t numSamples, float alpha)
+{
+    std::vector<int16_t> rx, coho, expected;
+    MakeInput(numSamples, rx, coho);
+    Reference(rx, coho, alpha, expected);
+
+    DownConversion::Path paths[] = {DownConversion::kScalar, DownConversion::kAVX2};
+    for (DownConversion::Path path : paths) {
+        if (path == DownConversion::kAVX2 && !DownConversion::HasAVX2()) continue;
+        DownConversion kernel(path);
+        assertEqual(int(path), int(kernel.getPath()));
+        std::vector<int16_t> actual(numSamples * 2);
+        kernel.process(&rx[0], &coho[0], numSamples, alpha, &actual[0]);
+        for (size_t index = 0; index < actual.size(); ++index) {
+            assertTrue(std::abs(int(expected[index]) - int(actual[index])) <= 1);
+        }
+    }
+}
+
+void
+Test::testEdges()
+{
+    // A dead COHO channel gives zeros.
+    //
+    std::vector<int16_t> rx(64, 1000), coho(64, 0), out(64, 1);
+    DownConversion kernel;
+    kernel.process(&rx[0], &coho[0], 32, 0.25, &out[0]);
+    for (size_t index = 0; index < out.size(); ++index) assertEqual(int16_t(0), out[index]);
+
+    // Large products saturate instead of wrapping. One strong COHO sample among weak ones makes the RMS small.
+    //
+    for (size_t index = 0; index < coho.size(); ++index) coho[index] = 1;
+    coho[0] = 2000;
+    for (size_t index = 0; index < rx.size(); ++index) rx[index] = index % 2 ? -32000 : 32000;
+    kernel.process(&rx[0], &coho[0], 32, 1.0, &out[0]);
+    assertEqual(int16_t(32767), out[0]);
+    assertEqual(int16_t(-32768), out[1]);
+}
+
+void
+Test::benchmark(size_t numSamples)
+{
+    enum { kNumPRIs = 2000 };
+    std::vector<int16_t> rx, coho, out;
+    MakeInput(numSamples, rx, coho);
+
+    Time::TimeStamp begin(Time::TimeStamp::Now());
+    for (int pri = 0; pri < kNumPRIs; ++pri) Reference(rx, coho, 0.25, out);
+    Time::TimeStamp referenceDelta(Time::TimeStamp::Now());
+    referenceDelta -= begin;
+
+    DownConversion scalar(DownConversion::kScalar);
+    begin = Time::TimeStamp::Now();
+    for (int pri = 0; pri < kNumPRIs; ++pri) scalar.process(&rx[0], &coho[0], numSamples, 0.25, &out[0]);
+    Time::TimeStamp scalarDelta(Time::TimeStamp::Now());
+    scalarDelta -= begin;
+
+    DownConversion best;
+    begin = Time::TimeStamp::Now();
+    for (int pri = 0; pri < kNumPRIs; ++pri) best.process(&rx[0], &coho[0], numSamples, 0.25, &out[0]);
+    Time::TimeStamp bestDelta(Time::TimeStamp::Now());
+    bestDelta -= begin;
+
+    std::clog << "samples: " << numSamples << " reference: " << referenceDelta.asDouble() / kNumPRIs
+              << " scalar: " << scalarDelta.asDouble() / kNumPRIs
+              << (best.getPath() == DownConversion::kAVX2 ? " avx2: " : " auto: ")
+              << bestDelta.asDouble() / kNumPRIs << " sec/PRI" << std::endl;
+}
+
+void
+Test::test()
+{
+    ::srand(8675309);
+    testEdges();
+    compare(1, 0.25);
+    compare(3, 0.25);
+    compare(4, 0.25);
+    compare(37, 0.5);
+    compare(4096, 0.25);
+    compare(4099, 0.05);
+    compare(1000, 1.0);
+
+    benchmark(1024);
+    benchmark(8192);
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return Test().mainRun();
+}
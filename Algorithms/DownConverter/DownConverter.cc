@@ -1,10 +1,8 @@
 #include "boost/bind.hpp"
 
-#include <algorithm>  // for std::transform
-#include <functional> // for std::bind* and std::mem_fun*
+#include <algorithm>
 
 #include "Logger/Log.h"
-#include <vsip/math.hpp>
 
 #include "Channel.h"
 #include "DownConverter.h"
@@ -18,8 +16,9 @@ using namespace SideCar::Algorithms::DownConverterUtils;
 // in the startup() method. NOTE: it is WRONG to call any virtual functions here...
 //
 DownConverter::DownConverter(Controller& controller, Logger::Log& log) :
-    Algorithm(controller, log), maxBufferSize_(Parameter::PositiveIntValue::Make(
-                                    "maxBufferSize", "Max channel buffer size", kDefaultMaxBufferSize)),
+    Algorithm(controller, log), kernel_(),
+    maxBufferSize_(
+        Parameter::PositiveIntValue::Make("maxBufferSize", "Max channel buffer size", kDefaultMaxBufferSize)),
     alpha_(Parameter::DoubleValue::Make("alpha", "Alpha value for low-pass filter", kDefaultAlpha)),
     enabled_(Parameter::BoolValue::Make("enabled", "Enabled", kDefaultEnabled))
 {
@@ -89,32 +88,11 @@ DownConverter::process()
     Messages::Video::Ref outMsg(Messages::Video::Make(getName(), rxMsg));
     Messages::Video::Container& out(outMsg->getData());
 
-    int num_samples = cohoMsg->size() / 2;
-
-    VsipComplexVector cohoVec(num_samples);
-    VsipComplexVector rxVec(num_samples);
-
-    // populate the vectors
-    for (int i = 0; i < num_samples; i++) {
-        rxVec.put(i, ComplexType(rxMsg[2 * i], rxMsg[2 * i + 1]));
-        cohoVec.put(i, ComplexType(cohoMsg[2 * i], cohoMsg[2 * i + 1]));
-    }
-
-    // apply a low pass filter
-    float alpha = alpha_->getValue();
-    for (int i = 1; i < num_samples; i++) { rxVec(i) = rxVec(i - 1) + alpha * (rxVec(i) - rxVec(i - 1)); }
-
-    // compute the average magnitude in the coho vector
-    float avg_mag = vsip::sqrt(vsip::meansqval(cohoVec));
-
-    // perform down conversion
-    rxVec = rxVec * (conj(cohoVec) / avg_mag);
-
-    // push the data back out
-    for (int i = 0; i < num_samples; i++) {
-        out.push_back(Messages::Video::DatumType(::rint(rxVec(i).real())));
-        out.push_back(Messages::Video::DatumType(::rint(rxVec(i).imag())));
-    }
+    // Down-convert in one fused pass over the two inputs, followed by a scale and pack pass over the products.
+    //
+    size_t numSamples = std::min(cohoMsg->size(), rxMsg->size()) / 2;
+    out.resize(numSamples * 2);
+    if (numSamples) kernel_.process(&rxMsg[0], &cohoMsg[0], numSamples, alpha_->getValue(), &out[0]);
 
     return send(outMsg);
 }
@@ -10,6 +10,8 @@
 #include "Messages/Video.h"
 #include "Parameter/Parameter.h"
 
+#include "DownConversion.h"
+
 namespace SideCar {
 namespace Algorithms {
 
@@ -53,6 +55,7 @@ private:
 
     DownConverterUtils::Channel* cohoChannel_;
     DownConverterUtils::Channel* rxChannel_;
+    DownConverterUtils::DownConversion kernel_;
 
     Parameter::PositiveIntValue::Ref maxBufferSize_;
     Parameter::DoubleValue::Ref alpha_;
@@ -1,8 +1,8 @@
 #include "boost/bind.hpp"
 
-#include <algorithm> // for std::transform
+#include <algorithm>
+#include <cmath>
 #include <fstream>
-#include <functional> // for std::bind* and std::mem_fun*
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -24,7 +24,7 @@ LowPassFilter::LowPassFilter(Controller& controller, Logger::Log& log) :
     Super(controller, log), enabled_(Parameter::BoolValue::Make("enabled", "Enabled", kDefaultEnabled)),
     fftSize_(Parameter::PositiveIntValue::Make("fftSize", "Size of FFT", kDefaultFftSize)),
     kernelFile_(Parameter::StringValue::Make("kernelFile", "Path and name to kernel file", kDefaultKernelFile)),
-    alphas_(), msg_(), filtered_data_(), kernel_()
+    alphas_(), convolver_(), input_(), output_()
 {
     fftSize_->connectChangedSignalTo(boost::bind(&LowPassFilter::fftSizeChanged, this, _1));
 }
@@ -39,12 +39,10 @@ LowPassFilter::startup()
     registerProcessor<LowPassFilter, Messages::Video>(&LowPassFilter::processInput);
     bool ok = true;
 
-    kernel_.reset(new VsipComplexVector(8, ComplexType(0.0, 0.0)));
-    filtered_data_.reset(new VsipComplexVector(128, ComplexType(0.0, 0.0)));
-    msg_.reset(new VsipComplexVector(128, ComplexType(0.0, 0.0)));
     ok = ok && registerParameter(enabled_) && registerParameter(kernelFile_) && registerParameter(fftSize_);
 
-    buildFFTs();
+    convolver_.setBlockSize(fftSize_->getValue());
+    loadKernel();
 
     return ok && Super::startup();
 }
@@ -76,17 +74,21 @@ LowPassFilter::loadKernel()
         }
     }
 
-    kernel_.reset(new VsipComplexVector(fftSize_->getValue(), ComplexType(0.0, 0.0)));
-
-    for (size_t i = 0; i < alphas.size(); i++) { kernel_->put(i, ComplexType(alphas[i], 0.0)); }
+    float scale = 0.0;
+    for (size_t i = 0; i < alphas.size(); i++) scale = std::max(scale, std::fabs(alphas[i]));
 
-    float scale;
-    vsip::Index<1> maxIndex;
-    scale = vsip::sqrt(vsip::maxmgsqval(*kernel_, maxIndex));
+    if (scale == 0.0) {
+        LOGERROR << "Empty kernel.  Using an all-pass filter." << std::endl;
+        alphas.assign(1, 1.0);
+        scale = 1.0;
+    }
 
-    *kernel_ /= scale;
-    *kernel_ = (*fwdFFT_)(*kernel_);
-    *kernel_ = vsip::conj(*kernel_);
+    // Correlating with the kernel is the same as convolving with the reversed kernel, with the output taken from
+    // the last tap.
+    //
+    std::vector<ComplexType> taps;
+    for (size_t i = alphas.size(); i > 0; --i) taps.push_back(ComplexType(alphas[i - 1] / scale, 0.0));
+    convolver_.setKernel(taps, 1, taps.size() - 1);
 
     return true;
 }
@@ -104,21 +106,7 @@ LowPassFilter::fftSizeChanged(const Parameter::PositiveIntValue& parameter)
 {
     Logger::ProcLog log("fftSizeChanged", getLog());
     LOGINFO << "fftSize: " << parameter.getValue() << std::endl;
-    buildFFTs();
-}
-
-void
-LowPassFilter::buildFFTs()
-{
-    Logger::ProcLog log("buildFFTs", getLog());
-    int fftSize = fftSize_->getValue();
-    LOGINFO << "rebuilding FFTW with size " << fftSize << std::endl;
-
-    fwdFFT_.reset(new FwdFFT(vsip::Domain<1>(fftSize), 1.0));
-    invFFT_.reset(new InvFFT(vsip::Domain<1>(fftSize), 1.0 / fftSize));
-    filtered_data_.reset(new VsipComplexVector(fftSize, ComplexType(0.0, 0.0)));
-
-    loadKernel();
+    convolver_.setBlockSize(parameter.getValue());
 }
 
 bool
@@ -134,40 +122,20 @@ LowPassFilter::processInput(const Messages::Video::Ref& msg)
     Messages::Video::Ref out(Messages::Video::Make("LowPassFilter::processInput", msg));
     Messages::Video::Container& outputData(out->getData());
 
-    // Fetch the FFT parameters. The number of windows is the number of FFTs we must execute in order to process
-    // the filter span. Using ::ceil to sure that numWindows covers the entire message.
-    //
-    const int fftSize = fftSize_->getValue();
-    const int numWindows = static_cast<int>(::ceil(static_cast<float>(msg_size) / fftSize));
-    const int totalFFTSize = fftSize * numWindows;
-    const int padding = totalFFTSize - msg_size;
-
-    // Process the RX buffer as windows of fftSize.
+    // Convert the I/Q samples to complex values, and filter the whole PRI in one go.
     //
-    for (int windowIndex = 0; windowIndex < numWindows; ++windowIndex) {
-        int offset = windowIndex * fftSize;
-
-        // Copy the appropriate portion of the input into the appropriate FFT buffer
-        //
-        for (int index = 0; index < fftSize; ++index) {
-            filtered_data_->put(index, ComplexType(msg[2 * (offset + index)], msg[2 * (offset + index) + 1]));
-        }
+    input_.resize(msg_size);
+    output_.resize(msg_size);
+    for (int index = 0; index < msg_size; ++index) input_[index] = ComplexType(msg[2 * index], msg[2 * index + 1]);
 
-        // Transform input data into frequency space, correlate, and translate result back into time space.
-        //
-        (*filtered_data_) = (*invFFT_)((*kernel_) * (*fwdFFT_)(*filtered_data_));
+    const ComplexType* inputs[] = {input_.data()};
+    convolver_.convolve(inputs, msg_size, output_.data());
 
-        // Copy filtered data into output message.
-        //
-        int limit = fftSize;
-        if (windowIndex == numWindows - 1) limit -= padding;
-
-        for (int index = 0; index < limit; ++index) {
-            outputData.push_back(Messages::Video::DatumType((*filtered_data_)(index).real()));
-            outputData.push_back(Messages::Video::DatumType((*filtered_data_)(index).imag()));
-        }
-
-    } // end for each window
+    outputData.reserve(2 * msg_size);
+    for (int index = 0; index < msg_size; ++index) {
+        outputData.push_back(Messages::Video::DatumType(output_[index].real()));
+        outputData.push_back(Messages::Video::DatumType(output_[index].imag()));
+    }
 
     // Send out on the default output device, and return the result to our Controller. NOTE: for multichannel
     // output, one must give a channel index to the send() method. Use getOutputChannelIndex() to obtain the
@@ -183,6 +151,9 @@ void
 LowPassFilter::setInfoSlots(IO::StatusBase& status)
 {
     status.setSlot(kEnabled, enabled_->getValue());
+    status.setSlot(kMethod, int(convolver_.getActiveMethod()));
+    status.setSlot(kBlockSize, int(convolver_.getActiveBlockSize()));
+    status.setSlot(kCost, convolver_.getLastCost());
 }
 
 extern "C" ACE_Svc_Export void*
@@ -190,7 +161,12 @@ FormatInfo(const IO::StatusBase& status, int role)
 {
     if (role != Qt::DisplayRole) return NULL;
     if (!status[LowPassFilter::kEnabled]) return Algorithm::FormatInfoValue("Disabled");
-    return NULL;
+    Convolver::Method method = Convolver::Method(int(status[LowPassFilter::kMethod]));
+    QString name(Convolver::GetMethodName(method));
+    if (method == Convolver::kFrequencyDomain) name += QString("(%1)").arg(int(status[LowPassFilter::kBlockSize]));
+    return Algorithm::FormatInfoValue(QString("Method: %1  Cost: %2 us/PRI")
+                                          .arg(name)
+                                          .arg(double(status[LowPassFilter::kCost]) * 1.0E6, 0, 'f', 1));
 }
 
 // Factory function for the DLL that will create a new instance of the LowPassFilter class. DO NOT CHANGE!
@@ -2,33 +2,29 @@
 #define SIDECAR_ALGORITHMS_LOWPASSFILTER_H
 
 #include "Algorithms/Algorithm.h"
+#include "Algorithms/Convolver.h"
 #include "Messages/Video.h"
 #include "Parameter/Parameter.h"
 
-#include <complex>
 #include <vector>
 
-#include <vsip/matrix.hpp>
-#include <vsip/signal.hpp>
-#include <vsip/vector.hpp>
-
 namespace SideCar {
 namespace Algorithms {
 
-/** Documentation for the algorithm LowPassFilter. Please describe what the algorithm does, in layman's terms
-    and, if possible, mathematical terms.
+/** Filters the I/Q samples of a PRI by correlating them with a kernel read from a file that holds one real value
+    per line. The kernel is normalized so that its largest value is 1, and output sample n is the sum over k of
+    kernel[k] * input[n + k], with input samples beyond the end of the PRI taken to be zero.
+
+    The correlation is done by a Convolver, which picks time-domain or FFT convolution from the kernel and PRI
+    sizes. The fftSize parameter sets the FFT block size; the method in use and the time spent per PRI are reported
+    in the status slots.
 */
 class LowPassFilter : public Algorithm {
     using Super = Algorithm;
-    using ComplexType = std::complex<float>;
-    using VsipFloatVector = vsip::Vector<float>;
-    using VsipComplexVector = vsip::Vector<ComplexType>;
-    using VsipFIR = vsip::Fir<ComplexType>;
-    using FwdFFT = vsip::Fft<vsip::Vector, ComplexType, ComplexType, vsip::fft_fwd>;
-    using InvFFT = vsip::Fft<vsip::Vector, ComplexType, ComplexType, vsip::fft_inv>;
+    using ComplexType = Convolver::ComplexType;
 
 public:
-    enum InfoSlots { kEnabled = ControllerStatus::kNumSlots, kNumSlots };
+    enum InfoSlots { kEnabled = ControllerStatus::kNumSlots, kMethod, kBlockSize, kCost, kNumSlots };
 
     /** Constructor.
 
@@ -54,7 +50,6 @@ public:
 private:
     void fftSizeChanged(const Parameter::PositiveIntValue& parameter);
     size_t getNumInfoSlots() const { return kNumSlots; }
-    void buildFFTs();
     void setInfoSlots(IO::StatusBase& status);
 
     /** Process messages from channel
@@ -74,13 +69,9 @@ private:
 
     std::vector<Parameter::DoubleValue::Ref> alphas_;
 
-    boost::scoped_ptr<VsipComplexVector> msg_;
-    boost::scoped_ptr<VsipComplexVector> filtered_data_;
-    boost::scoped_ptr<VsipComplexVector> kernel_;
-
-    boost::scoped_ptr<FwdFFT> fwdFFT_;
-    boost::scoped_ptr<InvFFT> invFFT_;
-    boost::scoped_ptr<VsipComplexVector> txPulseVec_;
+    Convolver convolver_;
+    std::vector<ComplexType> input_;
+    std::vector<ComplexType> output_;
 };
 
 } // end namespace Algorithms
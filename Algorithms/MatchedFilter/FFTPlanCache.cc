@@ -0,0 +1,211 @@
+#include <fftw3.h>
+
+#include "Logger/Log.h"
+
+#include "FFTPlanCache.h"
+
+using namespace SideCar::Algorithms::MatchedFilterUtils;
+
+Logger::Log&
+FFTPlanCache::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.Algorithms.MatchedFilter.FFTPlanCache");
+    return log_;
+}
+
+FFTPlanCache&
+FFTPlanCache::Instance()
+{
+    // NOTE: C++11 guarantees thread-safe initialization of function-level statics.
+    //
+    static FFTPlanCache instance_;
+    return instance_;
+}
+
+bool
+FFTPlanCache::Key::operator<(const Key& rhs) const
+{
+    if (fftSize != rhs.fftSize) return fftSize < rhs.fftSize;
+    if (rows != rhs.rows) return rows < rhs.rows;
+    if (numFFTThreads != rhs.numFFTThreads) return numFFTThreads < rhs.numFFTThreads;
+    return direction < rhs.direction;
+}
+
+FFTPlanCache::FFTPlanCache() :
+    mutex_(Threading::Mutex::Make()), idle_(), leased_(), numCreated_(0), numHits_(0), numIdle_(0), useCounter_(0)
+{
+#ifdef SIDECAR_FFTW3_THREADS
+    // Our FFT objects operate on single-precision complex values, so VSIPL uses the fftwf planner. Its thread
+    // support is separate from that of the double-precision fftw planner.
+    //
+    if (!fftwf_init_threads()) {
+        Logger::ProcLog log("FFTPlanCache", Log());
+        LOGERROR << "failed fftwf_init_threads" << std::endl;
+    }
+#endif
+}
+
+FFTPlanCache::~FFTPlanCache()
+{
+    clear();
+}
+
+FwdFFTM*
+FFTPlanCache::acquireForward(int fftSize, int rows, int numFFTThreads)
+{
+    return static_cast<FwdFFTM*>(acquire(Key(fftSize, rows, numFFTThreads, kForward)));
+}
+
+InvFFTM*
+FFTPlanCache::acquireInverse(int fftSize, int rows, int numFFTThreads)
+{
+    return static_cast<InvFFTM*>(acquire(Key(fftSize, rows, numFFTThreads, kInverse)));
+}
+
+void
+FFTPlanCache::release(FwdFFTM* fft)
+{
+    release(static_cast<void*>(fft));
+}
+
+void
+FFTPlanCache::release(InvFFTM* fft)
+{
+    release(static_cast<void*>(fft));
+}
+
+void*
+FFTPlanCache::acquire(const Key& key)
+{
+    static Logger::ProcLog log("acquire", Log());
+
+    // NOTE: we hold the lock while creating a new FFT object since the FFTW planner is not reentrant.
+    //
+    Threading::Locker lock(mutex_);
+
+    void* fft = 0;
+    IdleList& idle(idle_[key]);
+    idle.lastUse = ++useCounter_;
+    if (!idle.ffts.empty()) {
+        fft = idle.ffts.back();
+        idle.ffts.pop_back();
+        --numIdle_;
+        ++numHits_;
+    } else {
+        LOGINFO << "planning fftSize: " << key.fftSize << " rows: " << key.rows
+                << " threads: " << key.numFFTThreads << " direction: " << key.direction << std::endl;
+#ifdef SIDECAR_FFTW3_THREADS
+        fftwf_plan_with_nthreads(key.numFFTThreads);
+#endif
+        vsip::Domain<2> domain(key.rows, key.fftSize);
+        if (key.direction == kForward) {
+            fft = new FwdFFTM(domain, 1.0);
+        } else {
+            fft = new InvFFTM(domain, 1.0 / key.fftSize);
+        }
+#ifdef SIDECAR_FFTW3_THREADS
+        fftwf_plan_with_nthreads(1);
+#endif
+        ++numCreated_;
+    }
+
+    leased_.insert(LeaseMap::value_type(fft, key));
+    return fft;
+}
+
+void
+FFTPlanCache::release(void* fft)
+{
+    static Logger::ProcLog log("release", Log());
+    if (!fft) return;
+
+    Threading::Locker lock(mutex_);
+    LeaseMap::iterator pos = leased_.find(fft);
+    if (pos == leased_.end()) {
+        LOGERROR << "unknown FFT object " << fft << std::endl;
+        return;
+    }
+
+    idle_[pos->second].ffts.push_back(fft);
+    leased_.erase(pos);
+    ++numIdle_;
+    if (numIdle_ > kMaxIdle) evict();
+}
+
+void
+FFTPlanCache::evict()
+{
+    static Logger::ProcLog log("evict", Log());
+
+    while (numIdle_ > kMaxIdle) {
+        IdleMap::iterator oldest = idle_.end();
+        for (IdleMap::iterator pos = idle_.begin(); pos != idle_.end(); ++pos) {
+            if (!pos->second.ffts.empty() && (oldest == idle_.end() || pos->second.lastUse < oldest->second.lastUse)) {
+                oldest = pos;
+            }
+        }
+
+        LOGINFO << "disposing fftSize: " << oldest->first.fftSize << " rows: " << oldest->first.rows
+                << " count: " << oldest->second.ffts.size() << std::endl;
+        for (size_t index = 0; index < oldest->second.ffts.size(); ++index) {
+            Dispose(oldest->first, oldest->second.ffts[index]);
+        }
+
+        numIdle_ -= oldest->second.ffts.size();
+        idle_.erase(oldest);
+    }
+}
+
+void
+FFTPlanCache::Dispose(const Key& key, void* fft)
+{
+    if (key.direction == kForward) {
+        delete static_cast<FwdFFTM*>(fft);
+    } else {
+        delete static_cast<InvFFTM*>(fft);
+    }
+}
+
+void
+FFTPlanCache::clear()
+{
+    Threading::Locker lock(mutex_);
+    for (IdleMap::iterator pos = idle_.begin(); pos != idle_.end(); ++pos) {
+        for (size_t index = 0; index < pos->second.ffts.size(); ++index) Dispose(pos->first, pos->second.ffts[index]);
+    }
+
+    idle_.clear();
+    numIdle_ = 0;
+}
+
+bool
+FFTPlanCache::loadWisdom(const std::string& path)
+{
+    Logger::ProcLog log("loadWisdom", Log());
+    if (path.empty()) return true;
+
+    Threading::Locker lock(mutex_);
+    if (!fftwf_import_wisdom_from_filename(path.c_str())) {
+        LOGWARNING << "failed to import FFTW wisdom from " << path << std::endl;
+        return false;
+    }
+
+    LOGINFO << "imported FFTW wisdom from " << path << std::endl;
+    return true;
+}
+
+bool
+FFTPlanCache::saveWisdom(const std::string& path)
+{
+    Logger::ProcLog log("saveWisdom", Log());
+    if (path.empty()) return true;
+
+    Threading::Locker lock(mutex_);
+    if (!fftwf_export_wisdom_to_filename(path.c_str())) {
+        LOGERROR << "failed to export FFTW wisdom to " << path << std::endl;
+        return false;
+    }
+
+    LOGINFO << "exported FFTW wisdom to " << path << std::endl;
+    return true;
+}
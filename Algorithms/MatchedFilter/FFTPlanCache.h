@@ -0,0 +1,185 @@
+#ifndef SIDECAR_ALGORITHMS_MATCHEDFILTER_FFTPLANCACHE_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_MATCHEDFILTER_FFTPLANCACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Threading/Threading.h"
+
+#include "MatchedFilterTypes.h"
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace Algorithms {
+namespace MatchedFilterUtils {
+
+/** Process-wide cache of VSIPL multiple-FFT objects. Creating an FFT object causes FFTW to run its planner,
+    which is expensive and which must not run concurrently with another planning operation. The cache keeps
+    idle FFT objects keyed by FFT size, row count, FFT thread count, and direction so that a change in the
+    matched filter configuration, or a new WorkRequest object, reuses a previously planned transform.
+
+    FFT objects are leased: a caller obtains exclusive use of an object via one of the acquire methods, and
+    must return it via release() when done. VSIPL FFT objects carry internal work buffers, so they are not safe
+    to share between threads while in use.
+
+    The cache holds at most kMaxIdle idle FFT objects. When it has more, it disposes of the objects of the key
+    that was least recently acquired. Callers should therefore ask for a small, fixed set of row counts; the
+    WorkRequest class pads partial batches out to their full size for this reason.
+
+    The cache may also load and save FFTW wisdom files so that the planning cost is only paid once per host.
+*/
+class FFTPlanCache {
+public:
+    /** Maximum number of idle FFT objects kept by the cache.
+     */
+    static const size_t kMaxIdle = 32;
+
+    /** Obtain the log device for FFTPlanCache objects
+
+        \return Logger::Log reference
+    */
+    static Logger::Log& Log();
+
+    /** Obtain the process-wide cache.
+
+        \return FFTPlanCache reference
+    */
+    static FFTPlanCache& Instance();
+
+    /** Obtain a forward multiple-FFT object that transforms each row of a matrix.
+
+        \param fftSize number of samples in each FFT
+
+        \param rows number of FFTs (rows) to perform in one call
+
+        \param numFFTThreads number of threads FFTW may use for the transform (ignored without fftw3f_threads)
+
+        \return new or cached FFT object
+    */
+    FwdFFTM* acquireForward(int fftSize, int rows, int numFFTThreads);
+
+    /** Obtain an inverse multiple-FFT object that transforms each row of a matrix. The inverse transform scales
+        its results by 1 / fftSize.
+
+        \param fftSize number of samples in each FFT
+
+        \param rows number of FFTs (rows) to perform in one call
+
+        \param numFFTThreads number of threads FFTW may use for the transform (ignored without fftw3f_threads)
+
+        \return new or cached FFT object
+    */
+    InvFFTM* acquireInverse(int fftSize, int rows, int numFFTThreads);
+
+    /** Return a forward FFT object obtained from acquireForward().
+
+        \param fft object to return
+    */
+    void release(FwdFFTM* fft);
+
+    /** Return an inverse FFT object obtained from acquireInverse().
+
+        \param fft object to return
+    */
+    void release(InvFFTM* fft);
+
+    /** Dispose of all idle FFT objects. Objects currently leased out are not affected.
+     */
+    void clear();
+
+    /** Import FFTW wisdom from a file. Does nothing if the path is empty.
+
+        \param path location of the wisdom file
+
+        \return true if successful
+    */
+    bool loadWisdom(const std::string& path);
+
+    /** Export accumulated FFTW wisdom to a file. Does nothing if the path is empty.
+
+        \param path location of the wisdom file
+
+        \return true if successful
+    */
+    bool saveWisdom(const std::string& path);
+
+    /** \return number of FFT objects created by the cache since startup.
+     */
+    size_t getNumCreated() const { return numCreated_; }
+
+    /** \return number of acquire requests satisfied from the cache.
+     */
+    size_t getNumHits() const { return numHits_; }
+
+    /** \return number of idle FFT objects held by the cache.
+     */
+    size_t getNumIdle() const { return numIdle_; }
+
+private:
+    enum Direction { kForward, kInverse };
+
+    /** Key for the idle FFT collections.
+     */
+    struct Key {
+        Key(int f, int r, int t, Direction d) : fftSize(f), rows(r), numFFTThreads(t), direction(d) {}
+        bool operator<(const Key& rhs) const;
+        int fftSize;
+        int rows;
+        int numFFTThreads;
+        Direction direction;
+    };
+
+    /** Constructor. Use Instance() to obtain the process-wide object.
+     */
+    FFTPlanCache();
+
+    /** Destructor. Disposes of all idle FFT objects.
+     */
+    ~FFTPlanCache();
+
+    /** Idle FFT objects for one key, and when the key was last acquired.
+     */
+    struct IdleList {
+        IdleList() : ffts(), lastUse(0) {}
+        std::vector<void*> ffts;
+        size_t lastUse;
+    };
+
+    using IdleMap = std::map<Key, IdleList>;
+
+    /** Record of leased FFT objects, so that release() may locate the key used to create them.
+     */
+    using LeaseMap = std::map<void*, Key>;
+
+    void* acquire(const Key& key);
+
+    void release(void* fft);
+
+    static void Dispose(const Key& key, void* fft);
+
+    /** Dispose of idle FFT objects until there are no more than kMaxIdle of them. Takes from the least-recently
+        acquired keys first. NOTE: the mutex_ must be held.
+    */
+    void evict();
+
+    Threading::Mutex::Ref mutex_;
+    IdleMap idle_;
+    LeaseMap leased_;
+    size_t numCreated_;
+    size_t numHits_;
+    size_t numIdle_;
+    size_t useCounter_;
+};
+
+} // namespace MatchedFilterUtils
+} // namespace Algorithms
+} // namespace SideCar
+
+/** \file
+ */
+
+#endif
@@ -1,7 +1,7 @@
+#include "ace/Event_Handler.h"
+#include "ace/Reactor.h"
 #include "boost/bind.hpp"
 
-#include <fftw3.h>
-
 #include <algorithm>  // for std::transform
 #include <functional> // for std::bind* and std::mem_fun*
 
@@ -9,6 +9,7 @@
 #include "Algorithms/Utils.h"
 #include "Logger/Log.h"
 
+#include "FFTPlanCache.h"
 #include "MatchedFilter2.h"
 #include "MatchedFilter_defaults.h"
 #include "WorkRequestQueue.h"
@@ -29,6 +30,31 @@ MatchedFilter::DomainEnumTraits::GetEnumNames()
     return kDomainNames;
 }
 
+/** Reactor timer handler for partial batches. The reactor thread must not touch the algorithm's batches, so
+    the handler only records which batch is overdue and asks for a processAlarm() call from the processing
+    thread.
+*/
+struct MatchedFilter::BatchTimer : public ACE_Event_Handler {
+    BatchTimer(MatchedFilter& algorithm) : ACE_Event_Handler(), algorithm_(algorithm) {}
+
+    /** Override of ACE_Event_Handler method. Invoked by the reactor when a partial batch is due.
+
+        \param now current time (ignored)
+
+        \param act the dispatch sequence number of the batch, given to ACE_Reactor::schedule_timer()
+
+        \return 0 to keep the handler registered
+    */
+    int handle_timeout(const ACE_Time_Value& now, const void* act)
+    {
+        algorithm_.overdueBatch_ = reinterpret_cast<size_t>(act) + 1;
+        algorithm_.requestAlarm();
+        return 0;
+    }
+
+    MatchedFilter& algorithm_;
+};
+
 // Constructor. Do minimal initialization here. Registration of processors and runtime parameters should occur
 // in the startup() method. NOTE: it is WRONG to call any virtual functions here...
 //
@@ -62,6 +88,16 @@ MatchedFilter::MatchedFilter(Controller& controller, Logger::Log& logger) :
                                                 "Scale Tx pulse using sum of magnitudes instead of "
                                                 "just max value",
                                                 kDefaultScaleWithSumMag)),
+    batchSize_(Parameter::PositiveIntValue::Make("batchSize",
+                                                 "Number of PRIs filtered together in the frequency domain<br>"
+                                                 "(delays output by batchSize - 1 PRIs)",
+                                                 kDefaultBatchSize)),
+    maxBatchDelay_(Parameter::NonNegativeIntValue::Make("maxBatchDelay",
+                                                        "Max milliseconds a partial batch waits for more PRIs<br>"
+                                                        "(0 = no limit)",
+                                                        kDefaultMaxBatchDelay)),
+    fftwWisdomFile_(Parameter::StringValue::Make("fftwWisdomFile", "FFTW wisdom file to load and save",
+                                                 kDefaultFftwWisdomFile)),
     domain_(DomainParameter::Make("domain_", "Domain", Domain(kDefaultDomain))),
     txThreshold_(Parameter::IntValue::Make("txThreshold",
                                            "If no Tx pulse values pass threshold,<br>"
@@ -71,17 +107,15 @@ MatchedFilter::MatchedFilter(Controller& controller, Logger::Log& logger) :
                                                    kDefaultTxThresholdStartBin)),
     txThresholdSpan_(Parameter::IntValue::Make("txThresholdSpan", "Number of complex bins to search for Tx pulse",
                                                kDefaultTxThresholdSpan)),
-    fwdFFT_(), txPulseVec_(), workerThreads_(0), idleWorkRequests_(new WorkRequestQueue("idle")),
+    workerThreads_(0), idleWorkRequests_(new WorkRequestQueue("idle")),
     pendingWorkRequests_(new WorkRequestQueue("pending")), finishedWorkRequests_(new WorkRequestQueue("finished")),
-    noPulseDetected_(false), restartWorkerThreads_(true)
+    activeWorkRequest_(0), reorderBuffer_(), nextDispatchSequence_(0), nextEmitSequence_(0), numInFlight_(0),
+    batchTimer_(new BatchTimer(*this)), overdueBatch_(0), noPulseDetected_(false), restartWorkerThreads_(true)
 {
-    Logger::ProcLog log("MatchedFilter", logger);
-
-    if (!fftw_init_threads()) LOGERROR << "failed fftw_init_threads" << std::endl;
-
     numWorkers_->connectChangedSignalTo(boost::bind(&MatchedFilter::numWorkersChanged, this, _1));
     fftSize_->connectChangedSignalTo(boost::bind(&MatchedFilter::fftSizeChanged, this, _1));
     rxFilterSpan_->connectChangedSignalTo(boost::bind(&MatchedFilter::rxFilterSpanChanged, this, _1));
+    batchSize_->connectChangedSignalTo(boost::bind(&MatchedFilter::batchSizeChanged, this, _1));
 }
 
 // Startup routine. This is called right after the Controller loads our DLL and creates an instance of the
@@ -95,7 +129,9 @@ MatchedFilter::startup()
            registerParameter(rxFilterStartBin_) && registerParameter(rxFilterSpan_) && registerParameter(domain_) &&
            registerParameter(fftSize_) && registerParameter(scaleWithSumMag_) && registerParameter(numWorkers_) &&
            registerParameter(numFFTThreads_) && registerParameter(txThreshold_) &&
-           registerParameter(txThresholdStartBin_) && registerParameter(txThresholdSpan_) && Super::startup();
+           registerParameter(txThresholdStartBin_) && registerParameter(txThresholdSpan_) &&
+           registerParameter(batchSize_) && registerParameter(maxBatchDelay_) && registerParameter(fftwWisdomFile_) &&
+           Super::startup();
 }
 
 bool
@@ -103,6 +139,8 @@ MatchedFilter::shutdown()
 {
     // Note: at this point there is no algorithm thread running, so this is safe to do here.
     //
+    ACE_Reactor* reactor = getController().reactor();
+    if (reactor) reactor->cancel_timer(batchTimer_.get());
     stopThreads();
 
     // When stopThreads() returns, no worker threads will be running so we can safely delete all WorkRequest
@@ -114,6 +152,8 @@ MatchedFilter::shutdown()
         WorkRequest::Destroy(data);
     }
 
+    FFTPlanCache::Instance().saveWisdom(fftwWisdomFile_->getValue());
+
     return Super::shutdown();
 }
 
@@ -137,7 +177,7 @@ MatchedFilter::getWorkRequest()
     //
     ACE_Message_Block* data = 0;
     if (idleWorkRequests_->message_count() && idleWorkRequests_->dequeue_head(data) != -1) return data;
-    return WorkRequest::Make(txPulseVec_.get(), numFFTThreads_->getValue(), fftSize_->getValue());
+    return WorkRequest::Make(numFFTThreads_->getValue(), fftSize_->getValue(), batchSize_->getValue());
 }
 
 bool
@@ -170,6 +210,10 @@ MatchedFilter::startThreads()
 
     size_t numWorkers = numWorkers_->getValue();
 
+    // Load any previously saved FFTW planning results. Not fatal if missing -- it will be created at shutdown.
+    //
+    FFTPlanCache::Instance().loadWisdom(fftwWisdomFile_->getValue());
+
     // Visit existing WorkRequest objects, updating them with new parameter values.
     //
     for (size_t index = 0; index < idleWorkRequests_->message_count(); ++index) {
@@ -178,8 +222,8 @@ MatchedFilter::startThreads()
         //
         ACE_Message_Block* data;
         idleWorkRequests_->dequeue_head(data);
-        WorkRequest::FromMessageBlock(data)->reconfigure(txPulseVec_.get(), numFFTThreads_->getValue(),
-                                                         fftSize_->getValue());
+        WorkRequest::FromMessageBlock(data)->reconfigure(numFFTThreads_->getValue(), fftSize_->getValue(),
+                                                         batchSize_->getValue());
         idleWorkRequests_->enqueue_tail(data);
     }
 
@@ -220,13 +264,32 @@ MatchedFilter::stopThreads()
         idleWorkRequests_->enqueue_tail(data);
     }
 
-    // Move any finished requests back onto the idle queue.
+    // Move any finished, reordered, or partially-filled requests back onto the idle queue. NOTE: their output
+    // messages are dropped.
     //
+    std::vector<ACE_Message_Block*> unfinished;
     while (!finishedWorkRequests_->is_empty()) {
         ACE_Message_Block* data;
         finishedWorkRequests_->dequeue_head(data);
-        idleWorkRequests_->enqueue_tail(data);
+        unfinished.push_back(data);
+    }
+
+    for (auto pos = reorderBuffer_.begin(); pos != reorderBuffer_.end(); ++pos) unfinished.push_back(pos->second);
+    reorderBuffer_.clear();
+
+    if (activeWorkRequest_) {
+        unfinished.push_back(activeWorkRequest_);
+        activeWorkRequest_ = 0;
+    }
+
+    for (size_t index = 0; index < unfinished.size(); ++index) {
+        WorkRequest::FromMessageBlock(unfinished[index])->endRequest();
+        idleWorkRequests_->enqueue_tail(unfinished[index]);
     }
+
+    numInFlight_ = 0;
+    nextDispatchSequence_ = 0;
+    nextEmitSequence_ = 0;
 }
 
 void
@@ -252,17 +315,122 @@ MatchedFilter::rxFilterSpanChanged(const Parameter::IntValue& parameter)
 }
 
 void
-MatchedFilter::buildFFTs()
+MatchedFilter::batchSizeChanged(const Parameter::PositiveIntValue& parameter)
+{
+    Logger::ProcLog log("batchSizeChanged", getLog());
+    LOGINFO << "batchSize: " << parameter.getValue() << std::endl;
+    setRestartWorkerThreads();
+}
+
+bool
+MatchedFilter::addToBatch(const Messages::Video::Ref& txMsg, int txPulseStart, int txPulseSpan,
+                          const Messages::Video::Ref& rxMsg, const Messages::Video::Ref& out, int rxFilterStart,
+                          int rxFilterSpan)
 {
-    Logger::ProcLog log("buildFFTs", getLog());
-    int fftSize = fftSize_->getValue();
-    LOGINFO << "rebuilding FFTW with size " << fftSize << std::endl;
+    bool newBatch = !activeWorkRequest_;
+    if (newBatch) {
+        activeWorkRequest_ = getWorkRequest();
+        WorkRequest::FromMessageBlock(activeWorkRequest_)->beginRequest(scaleWithSumMag_->getValue());
+    }
+
+    WorkRequest* wr = WorkRequest::FromMessageBlock(activeWorkRequest_);
+    wr->add(txMsg, txPulseStart, txPulseSpan, rxMsg, out, rxFilterStart, rxFilterSpan);
+    if (wr->isFull()) return dispatchBatch();
 
-    fftw_plan_with_nthreads(numFFTThreads_->getValue());
-    fwdFFT_.reset(new FwdFFT(vsip::Domain<1>(fftSize), 1.0));
-    fftw_plan_with_nthreads(1);
+    // Bound the time that a new batch waits for more PRIs. The batch will carry the sequence number
+    // nextDispatchSequence_ when dispatched, which processAlarm() uses to tell if the timer is still relevant.
+    //
+    int maxBatchDelay = maxBatchDelay_->getValue();
+    ACE_Reactor* reactor = getController().reactor();
+    if (newBatch && maxBatchDelay > 0 && reactor) {
+        ACE_Time_Value delay(maxBatchDelay / 1000, (maxBatchDelay % 1000) * 1000);
+        reactor->schedule_timer(batchTimer_.get(), reinterpret_cast<const void*>(nextDispatchSequence_), delay);
+    }
 
-    txPulseVec_.reset(new VsipComplexVector(fftSize));
+    // Take the opportunity to emit anything that has finished without waiting.
+    //
+    return emitFinished(false);
+}
+
+bool
+MatchedFilter::dispatchBatch()
+{
+    if (!activeWorkRequest_) return true;
+
+    WorkRequest::FromMessageBlock(activeWorkRequest_)->setSequence(nextDispatchSequence_++);
+    pendingWorkRequests_->enqueue_tail(activeWorkRequest_);
+    activeWorkRequest_ = 0;
+    ++numInFlight_;
+
+    // Keep at most one batch per worker thread in flight. This bounds both the latency and the number of
+    // WorkRequest objects we allocate.
+    //
+    return emitFinished(numInFlight_ >= size_t(numWorkers_->getValue()));
+}
+
+bool
+MatchedFilter::emitFinished(bool block)
+{
+    static Logger::ProcLog log("emitFinished", getLog());
+
+    bool rc = true;
+    while (numInFlight_ && (block || !finishedWorkRequests_->is_empty())) {
+        ACE_Message_Block* data = 0;
+        if (finishedWorkRequests_->dequeue_head(data) == -1) break;
+        block = false;
+        --numInFlight_;
+
+        // Hold on to the batch until all batches dispatched before it have been emitted.
+        //
+        size_t sequence = WorkRequest::FromMessageBlock(data)->getSequence();
+        reorderBuffer_[sequence] = data;
+        LOGDEBUG << "finished: " << sequence << " expecting: " << nextEmitSequence_ << std::endl;
+
+        while (!reorderBuffer_.empty() && reorderBuffer_.begin()->first == nextEmitSequence_) {
+            data = reorderBuffer_.begin()->second;
+            reorderBuffer_.erase(reorderBuffer_.begin());
+            ++nextEmitSequence_;
+
+            WorkRequest* wr = WorkRequest::FromMessageBlock(data);
+            for (size_t index = 0; index < wr->size(); ++index) rc &= send(wr->getOutput(index));
+            wr->endRequest();
+            idleWorkRequests_->enqueue_tail(data);
+        }
+    }
+
+    return rc;
+}
+
+void
+MatchedFilter::processAlarm()
+{
+    static Logger::ProcLog log("processAlarm", getLog());
+
+    // Dispatch the partial batch if its timer expired. A timer for a batch that has since filled up and gone
+    // out does not match.
+    //
+    size_t overdue = overdueBatch_.exchange(0);
+    if (activeWorkRequest_ && overdue == nextDispatchSequence_ + 1) {
+        LOGDEBUG << "dispatching partial batch " << nextDispatchSequence_ << std::endl;
+        dispatchBatch();
+    }
+
+    emitFinished(false);
+}
+
+bool
+MatchedFilter::flushBatches()
+{
+    bool rc = dispatchBatch();
+    while (numInFlight_) rc &= emitFinished(true);
+    return rc;
+}
+
+bool
+MatchedFilter::sendInOrder(const Messages::Video::Ref& msg)
+{
+    bool rc = flushBatches();
+    return send(msg) && rc;
 }
 
 ChannelBuffer*
@@ -295,7 +463,7 @@ MatchedFilter::processChannels()
 
     if (!isEnabled()) {
         LOGDEBUG << "not enabled" << std::endl;
-        return send(rxMsg);
+        return sendInOrder(rxMsg);
     }
 
     // Since samples in the main and auxillary channels contain I,Q sample pairs, divide the message sizes by 2
@@ -331,7 +499,7 @@ MatchedFilter::processChannels()
     if (!txPulseDetected) {
         LOGWARNING << "no pulse detected" << std::endl;
         noPulseDetected_ = true;
-        return send(rxMsg);
+        return sendInOrder(rxMsg);
     }
 
     noPulseDetected_ = false;
@@ -340,8 +508,11 @@ MatchedFilter::processChannels()
     // our message processing thread that runs this method.
     //
     if (getRestartWorkerThreads()) {
-        if (workerThreads_) stopThreads();
-        buildFFTs();
+        if (workerThreads_) {
+            flushBatches();
+            stopThreads();
+        }
+
         startThreads();
     }
 
@@ -392,7 +563,7 @@ MatchedFilter::processChannels()
     if (domain_->getValue() == kFrequencyDomain) {
         LOGDEBUG << "processing in frequency domain" << std::endl;
 
-        // Since different threads will muck with their own part of the output buffer, we need it to be its full
+        // Since a worker thread will fill in the filtered part of the output buffer, we need it to be its full
         // size.
         //
         outputData.resize(rxMsg->size());
@@ -402,70 +573,17 @@ MatchedFilter::processChannels()
         size_t offset = (rxFilterStart + rxFilterSpan) * 2;
         std::copy(rxMsg->begin() + offset, rxMsg->end(), outputData.begin() + offset);
 
-        // Fetch the FFT parameters. The number of windows is the number of FFTs we must execute in order to
-        // process the filter span. Using ::ceil to sure that numWindows covers the entire message.
-        //
-        const int fftSize = fftSize_->getValue();
-        int numWindows = static_cast<int>(::ceil(static_cast<float>(rxFilterSpan) / fftSize));
-        const int totalFFTSize = fftSize * numWindows;
-        const int padding = totalFFTSize - rxFilterSpan;
-
-        // Get slice of the tx channel representing the transmit pulse.
+        // Overlap-save needs at least one valid output per FFT segment.
         //
-        Messages::Video::const_iterator pos(txMsg->begin());
-        pos += 2 * txPulseStart;
-        for (int index = 0; index < txPulseSpan; ++index) {
-            float i = *pos++;
-            float q = *pos++;
-            txPulseVec_->put(index, ComplexType(i, q));
-        }
-
-        // Pad the txPulseVec with zeroes so that it represents a length equal to fftSize
-        //
-        for (int index = txPulseSpan; index < fftSize; ++index) txPulseVec_->put(index, ComplexType(0.0, 0.0));
-
-        // Fetch the average magnitude found within the pulse. Since this value is always non-negative (sum of
-        // squares), we don't need to use a complex type to represent it.
-        //
-        float scale;
-        if (scaleWithSumMag_->getValue()) {
-            scale = vsip::sqrt(vsip::sumval(vsip::magsq(*txPulseVec_)));
-        } else {
-            vsip::Index<1> maxIndex;
-            scale = vsip::sqrt(vsip::maxmgsqval(*txPulseVec_, maxIndex));
-        }
-
-        // Convert xmit pulse into frequence domain.
-        //
-        *txPulseVec_ /= scale;
-        *txPulseVec_ = (*fwdFFT_)(*txPulseVec_);
-        *txPulseVec_ = vsip::conj(*txPulseVec_);
-
-        // Process the rx buffer as windows of fftSize, each window processed by a separate thread.
-        //
-        offset = 2 * rxFilterStart;
-        for (int windowIndex = 0; windowIndex < numWindows; ++windowIndex) {
-            // Fetch a new/existing WorkRequest object and fill it with the window values.
-            //
-            ACE_Message_Block* data = getWorkRequest();
-            WorkRequest* wr = WorkRequest::FromMessageBlock(data);
-            wr->beginRequest(rxMsg, out, offset);
-            offset += fftSize * 2;
-
-            // Add to the pending queue for the next available WorkerThread to process.
-            //
-            pendingWorkRequests_->enqueue_tail(data);
+        if (txPulseSpan > fftSize_->getValue()) {
+            getController().setError("txPulseSpan is larger than fftSize.");
+            return true;
         }
 
-        // Now that we've scheduled all of the work, we need to essentially perform a barrier wait until all of
-        // the threads have finished performing their calculations.
+        // Add to the batch being filled. The output message will be emitted once the worker thread that
+        // processes the batch is done with it.
         //
-        ACE_Message_Block* data = 0;
-        while (finishedWorkRequests_->dequeue_head(data) != -1) {
-            idleWorkRequests_->enqueue_tail(data);
-            --numWindows;
-            if (numWindows == 0) break;
-        }
+        return addToBatch(txMsg, txPulseStart, txPulseSpan, rxMsg, out, rxFilterStart, rxFilterSpan);
     } else {
         LOGDEBUG << "processing in time domain" << std::endl;
 
@@ -531,7 +649,7 @@ MatchedFilter::processChannels()
 
     if (outputData.size() > 30 * 1024) LOGERROR << "abnormally large size: " << outputData.size() << std::endl;
 
-    bool rc = send(out);
+    bool rc = sendInOrder(out);
 
     LOGDEBUG << "rc: " << rc << std::endl;
     return rc;
@@ -546,6 +664,7 @@ MatchedFilter::setInfoSlots(IO::StatusBase& status)
     status.setSlot(kFFTThreadCount, numFFTThreads_->getValue());
     status.setSlot(kDomain, domain_->getValue());
     status.setSlot(kNoPulseDetected, noPulseDetected_);
+    status.setSlot(kBatchSize, batchSize_->getValue());
 }
 
 extern "C" ACE_Svc_Export QVariant
@@ -555,10 +674,11 @@ FormatInfo(const IO::StatusBase& status, int role)
 
     if (!status[ManyInAlgorithm::kEnabled] || status[MatchedFilter::kNoPulseDetected]) return "Rx Passthrough";
 
-    return QString("Threads: %1/%2 FFT: %3 Domain: %4 ")
+    return QString("Threads: %1/%2 FFT: %3 Batch: %4 Domain: %5 ")
                .arg(int(status[MatchedFilter::kWorkerCount]))
                .arg(int(status[MatchedFilter::kFFTThreadCount]))
                .arg(int(status[MatchedFilter::kFFTSize]))
+               .arg(int(status[MatchedFilter::kBatchSize]))
                .arg(kDomainNames[int(status[MatchedFilter::kDomain])]) +
            ManyInAlgorithm::GetFormattedStats(status);
 }
@@ -1,7 +1,9 @@
 #ifndef SIDECAR_ALGORITHMS_MATCHEDFILTER_H // -*- C++ -*-
 #define SIDECAR_ALGORITHMS_MATCHEDFILTER_H
 
+#include <atomic>
 #include <complex>
+#include <map>
 
 #include "ace/Message_Queue_T.h"
 #include "boost/scoped_ptr.hpp"
@@ -21,12 +23,28 @@ namespace Algorithms {
 
 /** Documentation for the algorithm MatchedFilter. Please describe what the algorithm does, in layman's terms
     and, if possible, mathematical terms.
+
+    In the frequency domain, the filter gathers batchSize PRIs into one MatchedFilterUtils::WorkRequest object
+    before handing it to the worker thread pool. Each WorkRequest transforms all of its PRIs with a single
+    multiple-FFT call, using overlap-save segmentation for filter spans longer than the FFT size. Finished
+    batches are emitted in the order in which they were dispatched, regardless of which worker finished first.
+    Note that a batch size greater than 1 delays output by up to batchSize - 1 PRIs, or by maxBatchDelay
+    milliseconds when the input stops before a batch fills up. Worker threads ask for a processAlarm() call when
+    they finish a batch, so finished batches go out without waiting for more input.
 */
 class MatchedFilter : public ManyInAlgorithm {
     using Super = ManyInAlgorithm;
 
 public:
-    enum InfoSlot { kFFTSize = Super::kNumSlots, kWorkerCount, kFFTThreadCount, kDomain, kNoPulseDetected, kNumSlots };
+    enum InfoSlot {
+        kFFTSize = Super::kNumSlots,
+        kWorkerCount,
+        kFFTThreadCount,
+        kDomain,
+        kNoPulseDetected,
+        kBatchSize,
+        kNumSlots
+    };
 
     /** Domain options available via the Master GUI application.
      */
@@ -71,7 +89,15 @@ public:
 
     void setFFTSize(int size) { fftSize_->setValue(size); }
 
+    void setBatchSize(int size) { batchSize_->setValue(size); }
+
+    void setMaxBatchDelay(int msecs) { maxBatchDelay_->setValue(msecs); }
+
+    void setDomain(Domain domain) { domain_->setValue(domain); }
+
 private:
+    struct BatchTimer;
+
     ChannelBuffer* makeChannelBuffer(int index, const std::string& name, size_t maxBufferSize);
 
     /** Start required worker threads based on runtime parameter.
@@ -102,6 +128,12 @@ private:
     */
     bool processChannels();
 
+    /** Override of Algorithm::processAlarm(). Invoked when a worker thread finishes a batch, or when a partial
+        batch has waited maxBatchDelay milliseconds. Dispatches an overdue partial batch, and emits the finished
+        batches.
+    */
+    void processAlarm();
+
     /** Notification handler called when the numWorkers parameter changed. Restarts the worker threads so that
         there are the configured number
 
@@ -128,7 +160,48 @@ private:
     */
     void rxFilterSpanChanged(const Parameter::IntValue& parameter);
 
-    void buildFFTs();
+    /** Notification handler called when the batchSize parameter changed.
+
+        \param parameter reference to parameter that changed
+    */
+    void batchSizeChanged(const Parameter::PositiveIntValue& parameter);
+
+    /** Add a PRI to the batch being filled. Dispatches the batch to the worker threads when it is full.
+
+        \return true if successful
+    */
+    bool addToBatch(const Messages::Video::Ref& txMsg, int txPulseStart, int txPulseSpan,
+                    const Messages::Video::Ref& rxMsg, const Messages::Video::Ref& out, int rxFilterStart,
+                    int rxFilterSpan);
+
+    /** Post the batch being filled (if any) to the pending queue for the worker threads.
+
+        \return true if successful
+    */
+    bool dispatchBatch();
+
+    /** Collect finished batches from the worker threads, and emit their output messages in dispatch order.
+
+        \param block if true, wait for at least one batch to finish
+
+        \return true if successful
+    */
+    bool emitFinished(bool block);
+
+    /** Dispatch any partial batch and wait for all outstanding batches to be emitted. Invoked before emitting a
+        message that did not go through the worker threads so that output order is preserved.
+
+        \return true if successful
+    */
+    bool flushBatches();
+
+    /** Emit a message that did not go through the worker threads, after first emitting all outstanding batches.
+
+        \param msg the message to send
+
+        \return true if successful
+    */
+    bool sendInOrder(const Messages::Video::Ref& msg);
 
     /** Determine if we need to restart our worker threads due to a parameter change. We only do so from within
         the process() method in order to prevent any race conditions while doing so. NOTE: this is a one-shot
@@ -207,6 +280,20 @@ private:
      */
     Parameter::BoolValue::Ref scaleWithSumMag_;
 
+    /** Run-time parameter for the number of PRIs filtered together by one worker thread.
+     */
+    Parameter::PositiveIntValue::Ref batchSize_;
+
+    /** Run-time parameter for the number of milliseconds a partial batch may wait for more PRIs before it is
+        dispatched anyway. Zero disables the limit.
+    */
+    Parameter::NonNegativeIntValue::Ref maxBatchDelay_;
+
+    /** Run-time parameter for the location of an FFTW wisdom file to load at startup and save at shutdown.
+        Empty if no wisdom file is used.
+    */
+    Parameter::StringValue::Ref fftwWisdomFile_;
+
     /** Definition of the enum range for the domain_ parameter.
      */
     struct DomainEnumTraits : public Parameter::Defs::EnumTypeTraitsBase {
@@ -222,9 +309,6 @@ private:
      */
     DomainParameter::Ref domain_;
 
-    boost::scoped_ptr<MatchedFilterUtils::FwdFFT> fwdFFT_;
-    boost::scoped_ptr<VsipComplexVector> txPulseVec_;
-
     /** Worker thread pool generator.
      */
     boost::scoped_ptr<MatchedFilterUtils::WorkerThreads> workerThreads_;
@@ -243,6 +327,35 @@ private:
      */
     boost::scoped_ptr<WorkRequestQueue> finishedWorkRequests_;
 
+    /** The WorkRequest being filled with PRIs. NULL if there is none.
+     */
+    ACE_Message_Block* activeWorkRequest_;
+
+    /** Finished WorkRequest objects waiting for an earlier batch to finish, ordered by sequence number.
+     */
+    std::map<size_t, ACE_Message_Block*> reorderBuffer_;
+
+    /** Sequence number to assign to the next dispatched WorkRequest.
+     */
+    size_t nextDispatchSequence_;
+
+    /** Sequence number of the next WorkRequest to emit.
+     */
+    size_t nextEmitSequence_;
+
+    /** Number of WorkRequest objects dispatched but not yet taken from the finished queue.
+     */
+    size_t numInFlight_;
+
+    /** Reactor timer that requests a processAlarm() call when a partial batch is due.
+     */
+    boost::scoped_ptr<BatchTimer> batchTimer_;
+
+    /** One more than the dispatch sequence number of the partial batch whose maxBatchDelay timer expired, or 0
+        if none. Set by the reactor thread, cleared by processAlarm().
+    */
+    std::atomic<size_t> overdueBatch_;
+
     bool noPulseDetected_;
 
     bool restartWorkerThreads_;
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "ace/Reactor.h"
 
 #include "Algorithms/Controller.h"
@@ -23,7 +25,7 @@ struct TestData {
         kNumSamples = 8,                     // Number of samples in the test data
         kNumCopies = 1000,                   // Number of copies to make of the sample data
         kOutSize = kNumSamples * kNumCopies, // Expected size of output msg
-        kNumIterations = 800                 // Number times to use
+        kNumIterations = 768                 // Number times to use per batch size (multiple of largest batch)
     };
 
     int16_t inputs[kNumInputs][kNumSamples];
@@ -43,6 +45,10 @@ TestData data[] = {
     //
 };
 
+/** Batch sizes to exercise. The test reports throughput and latency for each one.
+ */
+int batchSizes[] = {1, 2, 4, 8, 16, 32, 64};
+
 struct Test : public UnitTest::TestObj {
     enum {
 
@@ -50,13 +56,23 @@ struct Test : public UnitTest::TestObj {
         //
         kNumTestDefinitions = sizeof(data) / sizeof(TestData),
         kNumTests = kNumTestDefinitions * TestData::kNumIterations,
+        kNumBatchSizes = sizeof(batchSizes) / sizeof(int),
+
+        // Final round with fewer PRIs than the batch holds.
+        //
+        kPartialBatchSize = 8,
+        kPartialCount = 3
     };
 
     static Logger::Log& Log();
 
     /** Constructor.
      */
-    Test() : UnitTest::TestObj("MatchedFilter"), controller_(), iteration_(0) {}
+    Test() :
+        UnitTest::TestObj("MatchedFilter"), controller_(), alg_(0), iteration_(0), batchIndex_(0), received_(0),
+        begin_(), roundBegin_(), latencySum_(0.0), maxLatency_(0.0), partial_(false)
+    {
+    }
 
     /** Implementation of TestObj interface. Creates the processing Stream object, its internal Task objects,
         properly initializes everything, and enters an ACE event loop, which does not return until testOutput()
@@ -68,6 +84,21 @@ struct Test : public UnitTest::TestObj {
      */
     void generateInput();
 
+    /** Generate one batch worth of input messages for the algorithm to consume, and note the time.
+     */
+    void generateRound();
+
+    /** Report the throughput and latency for the active batch size, and move to the next one.
+
+        \return true if there is another batch size to test
+    */
+    bool nextBatchSize();
+
+    /** Generate fewer input messages than a batch holds, and then no more. Only the maxBatchDelay timer of the
+        algorithm gets them out.
+    */
+    void generatePartialRound();
+
     /** Compare the output from the algorithm with the sample values defined in the TestData container above.
 
         \param counter the message counter
@@ -78,7 +109,15 @@ struct Test : public UnitTest::TestObj {
 
 private:
     Controller::Ref controller_;
+    MatchedFilter* alg_;
     int iteration_;
+    int batchIndex_;
+    int received_;
+    Time::TimeStamp begin_;
+    Time::TimeStamp roundBegin_;
+    double latencySum_;
+    double maxLatency_;
+    bool partial_;
 };
 
 Logger::Log&
@@ -201,23 +240,25 @@ Test::test()
 
     // Update the algorithm with the settings appropriate for this message set.
     //
-    MatchedFilter* alg = dynamic_cast<MatchedFilter*>(controller_->getAlgorithm());
-    assertTrue(alg);
+    alg_ = dynamic_cast<MatchedFilter*>(controller_->getAlgorithm());
+    assertTrue(alg_);
 
     // Configure the matched filter
     //
-    alg->setFFTSize(1024);
-    alg->setTxPulseStartBin(0);
-    alg->setTxPulseSpan(1);
-    alg->setTxThreshold(700);
-    alg->setTxThresholdStartBin(0);
-    alg->setTxThresholdSpan(1);
-    alg->setRxFilterStartBin(0);
-    alg->setRxFilterSpan(0);
+    alg_->setFFTSize(1024);
+    alg_->setTxPulseStartBin(0);
+    alg_->setTxPulseSpan(1);
+    alg_->setTxThreshold(700);
+    alg_->setTxThresholdStartBin(0);
+    alg_->setTxThresholdSpan(1);
+    alg_->setRxFilterStartBin(0);
+    alg_->setRxFilterSpan(0);
+    alg_->setBatchSize(batchSizes[batchIndex_]);
 
     // Generate our first input test messages.
     //
-    generateInput();
+    begin_ = Time::TimeStamp::Now();
+    generateRound();
 
     // Now run.
     //
@@ -228,7 +269,7 @@ Test::test()
 
     std::clog << "duration: " << delta.asDouble() << " seconds" << std::endl;
 
-    double timePerSample = delta.asDouble() / (kNumTests * TestData::kOutSize);
+    double timePerSample = delta.asDouble() / (kNumTests * kNumBatchSizes * TestData::kOutSize);
     std::clog << " time per sample: " << timePerSample << std::endl;
 
     // Uncomment the following to fail the test and see the log results. assertTrue(false);
@@ -271,6 +312,45 @@ Test::generateInput()
     }
 }
 
+void
+Test::generateRound()
+{
+    roundBegin_ = Time::TimeStamp::Now();
+    for (int count = 0; count < batchSizes[batchIndex_]; ++count) generateInput();
+}
+
+bool
+Test::nextBatchSize()
+{
+    Time::TimeStamp delta(Time::TimeStamp::Now());
+    delta -= begin_;
+
+    int batchSize = batchSizes[batchIndex_];
+    int numRounds = kNumTests / batchSize;
+    std::clog << "batchSize: " << batchSize << " PRIs/sec: " << kNumTests / delta.asDouble()
+              << " mean latency: " << latencySum_ / numRounds * 1000.0 << " ms"
+              << " max latency: " << maxLatency_ * 1000.0 << " ms" << std::endl;
+
+    if (++batchIndex_ == kNumBatchSizes) return false;
+
+    alg_->setBatchSize(batchSizes[batchIndex_]);
+    received_ = 0;
+    latencySum_ = 0.0;
+    maxLatency_ = 0.0;
+    begin_ = Time::TimeStamp::Now();
+    return true;
+}
+
+void
+Test::generatePartialRound()
+{
+    partial_ = true;
+    received_ = 0;
+    alg_->setBatchSize(kPartialBatchSize);
+    alg_->setMaxBatchDelay(5);
+    for (int count = 0; count < kPartialCount; ++count) generateInput();
+}
+
 void
 Test::testOutput(size_t counter, const Video::Ref& msg)
 {
@@ -293,12 +373,27 @@ Test::testOutput(size_t counter, const Video::Ref& msg)
 
     LOGDEBUG << "iteration: " << iteration_ << std::endl;
 
-    // See if we are done with the test.
+    if (partial_) {
+        if (++received_ == kPartialCount) ACE_Reactor::instance()->end_reactor_event_loop();
+        return;
+    }
+
+    // Wait for the rest of the batch. Latency is measured from the submission of the first PRI of the batch to
+    // the arrival of the last output, which is what a downstream consumer would see in the worst case.
+    //
+    if (++received_ % batchSizes[batchIndex_]) return;
+
+    Time::TimeStamp latency(Time::TimeStamp::Now());
+    latency -= roundBegin_;
+    latencySum_ += latency.asDouble();
+    maxLatency_ = std::max(maxLatency_, latency.asDouble());
+
+    // See if we are done with the batch size, and then with the test.
     //
-    if (iteration_ == kNumTests) {
-        ACE_Reactor::instance()->end_reactor_event_loop();
+    if (received_ == kNumTests && !nextBatchSize()) {
+        generatePartialRound();
     } else {
-        generateInput();
+        generateRound();
     }
 }
 
@@ -5,6 +5,7 @@
 
 #include "ace/Message_Queue_T.h"
 
+#include <vsip/matrix.hpp>
 #include <vsip/signal.hpp>
 #include <vsip/vector.hpp>
 
@@ -12,14 +13,18 @@ namespace SideCar {
 namespace Algorithms {
 namespace MatchedFilterUtils {
 
+class FFTPlanCache;
 class WorkRequest;
 class WorkerThreads;
 class WorkRequestQueue;
 
 using ComplexType = std::complex<float>;
 using VsipComplexVector = vsip::Vector<ComplexType>;
+using VsipComplexMatrix = vsip::Matrix<ComplexType>;
 using FwdFFT = vsip::Fft<vsip::Vector, ComplexType, ComplexType, vsip::fft_fwd>;
 using InvFFT = vsip::Fft<vsip::Vector, ComplexType, ComplexType, vsip::fft_inv>;
+using FwdFFTM = vsip::Fftm<ComplexType, ComplexType, vsip::row, vsip::fft_fwd, vsip::by_reference>;
+using InvFFTM = vsip::Fftm<ComplexType, ComplexType, vsip::row, vsip::fft_inv, vsip::by_reference>;
 
 } // namespace MatchedFilterUtils
 } // namespace Algorithms
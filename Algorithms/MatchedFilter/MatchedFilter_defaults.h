@@ -12,3 +12,6 @@ static const bool kDefaultScaleWithSumMag = 1;
 static const int kDefaultTxThreshold = 800;
 static const int kDefaultTxThresholdStartBin = 80;
 static const int kDefaultTxThresholdSpan = 10;
+static const int kDefaultBatchSize = 1;
+static const int kDefaultMaxBatchDelay = 10;
+static const char* const kDefaultFftwWisdomFile = "";
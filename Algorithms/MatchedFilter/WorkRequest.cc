@@ -1,7 +1,8 @@
-#include <fftw3.h>
+#include <algorithm>
 
 #include "Logger/Log.h"
 
+#include "FFTPlanCache.h"
 #include "WorkRequest.h"
 
 #include <vsip/domain.hpp>
@@ -26,7 +27,7 @@ WorkRequest::FromMessageBlock(ACE_Message_Block* data)
 }
 
 ACE_Message_Block*
-WorkRequest::Make(VsipComplexVector* txPulseVec, int numFFTThreads, int fftSize)
+WorkRequest::Make(int numFFTThreads, int fftSize, int batchSize)
 {
     Logger::ProcLog log("Make", Log());
 
@@ -41,7 +42,7 @@ WorkRequest::Make(VsipComplexVector* txPulseVec, int numFFTThreads, int fftSize)
     // doing this, we must manually call the WorkRequest destructor when we are done with the WorkRequest object
     // or else we will leak memory. See the Destroy() class method.
     //
-    WorkRequest* tmp = new (data->base()) WorkRequest(txPulseVec, numFFTThreads, fftSize);
+    new (data->base()) WorkRequest(numFFTThreads, fftSize, batchSize);
 
     return data;
 }
@@ -60,12 +61,13 @@ WorkRequest::Destroy(ACE_Message_Block* data)
     data->release();
 }
 
-WorkRequest::WorkRequest(VsipComplexVector* txPulseVec, int numFFTThreads, int fftSize) :
-    input_(), output_(), offset_(0), rxVec_(), fwdFFT_(), invFFT_()
+WorkRequest::WorkRequest(int numFFTThreads, int fftSize, int batchSize) :
+    numFFTThreads_(numFFTThreads), fftSize_(fftSize), batchSize_(batchSize), sequence_(0),
+    scaleWithSumMag_(true), numRows_(0), jobs_(), txMat_(), rxMat_()
 {
     Logger::ProcLog log("WorkRequest", Log());
     LOGDEBUG << this << std::endl;
-    reconfigure(txPulseVec, numFFTThreads, fftSize);
+    reconfigure(numFFTThreads, fftSize, batchSize);
 }
 
 WorkRequest::~WorkRequest()
@@ -75,31 +77,87 @@ WorkRequest::~WorkRequest()
 }
 
 void
-WorkRequest::reconfigure(VsipComplexVector* txPulseVec, int numFFTThreads, int fftSize)
+WorkRequest::reconfigure(int numFFTThreads, int fftSize, int batchSize)
 {
-    txPulseVec_ = txPulseVec;
+    numFFTThreads_ = numFFTThreads;
     fftSize_ = fftSize;
+    batchSize_ = batchSize;
 
-    rxVec_.reset(new VsipComplexVector(fftSize));
+    // Allocate enough rows for one overlap-save segment per PRI. The process() method will grow the receive
+    // matrix if a batch needs more. Rows that a batch does not fill still go through the FFTs (see process()), so
+    // start them out as zeros.
+    //
+    txMat_.reset(new VsipComplexMatrix(batchSize, fftSize, ComplexType(0.0, 0.0)));
+    rxMat_.reset(new VsipComplexMatrix(batchSize, fftSize, ComplexType(0.0, 0.0)));
 
-    fftw_plan_with_nthreads(numFFTThreads);
+    jobs_.clear();
+    jobs_.reserve(batchSize);
+    numRows_ = 0;
+    sequence_ = 0;
+}
 
-    fwdFFT_.reset(new FwdFFT(vsip::Domain<1>(fftSize), 1.0));
-    invFFT_.reset(new InvFFT(vsip::Domain<1>(fftSize), 1.0 / fftSize));
+void
+WorkRequest::reserveRows(int rows)
+{
+    if (rows <= int(rxMat_->size(0))) return;
 
-    fftw_plan_with_nthreads(1);
+    // Grow in multiples of the batch size so that the number of rows transformed, and thus the number of FFT
+    // plans, stays small.
+    //
+    rows = (rows + batchSize_ - 1) / batchSize_ * batchSize_;
+    Logger::ProcLog log("reserveRows", Log());
+    LOGINFO << "growing from " << rxMat_->size(0) << " to " << rows << " rows" << std::endl;
+    rxMat_.reset(new VsipComplexMatrix(rows, fftSize_, ComplexType(0.0, 0.0)));
+}
 
-    input_.reset();
-    output_.reset();
-    offset_ = 0;
+void
+WorkRequest::beginRequest(bool scaleWithSumMag)
+{
+    scaleWithSumMag_ = scaleWithSumMag;
+    jobs_.clear();
+    numRows_ = 0;
 }
 
 void
-WorkRequest::beginRequest(const Messages::Video::Ref& input, const Messages::Video::Ref& output, size_t offset)
+WorkRequest::add(const Messages::Video::Ref& tx, int txPulseStart, int txPulseSpan,
+                 const Messages::Video::Ref& input, const Messages::Video::Ref& output, int rxFilterStart,
+                 int rxFilterSpan)
 {
-    input_ = input;
-    output_ = output;
-    offset_ = offset;
+    int row = jobs_.size();
+
+    // Copy the transmit pulse into its row of the transmit matrix, padding with zeros out to fftSize.
+    //
+    Messages::Video::const_iterator pos(tx->begin() + 2 * txPulseStart);
+    int index = 0;
+    for (; index < txPulseSpan; ++index) {
+        float i = *pos++;
+        float q = *pos++;
+        txMat_->put(row, index, ComplexType(i, q));
+    }
+
+    for (; index < fftSize_; ++index) txMat_->put(row, index, ComplexType(0.0, 0.0));
+
+    // Each overlap-save segment yields (fftSize - txPulseSpan + 1) uncorrupted correlation values. Calculate
+    // the number of segments required to cover the filter span.
+    //
+    int step = fftSize_ - txPulseSpan + 1;
+    Job job;
+    job.input = input;
+    job.output = output;
+    job.txPulseSpan = txPulseSpan;
+    job.rxFilterStart = rxFilterStart;
+    job.rxFilterSpan = rxFilterSpan;
+    job.firstRow = numRows_;
+    job.numRows = (rxFilterSpan + step - 1) / step;
+    numRows_ += job.numRows;
+    jobs_.push_back(job);
+}
+
+void
+WorkRequest::endRequest()
+{
+    jobs_.clear();
+    numRows_ = 0;
 }
 
 void
@@ -107,42 +165,104 @@ WorkRequest::process()
 {
     static Logger::ProcLog log("process", Log());
 
-    LOGINFO << "offset: " << offset_ << std::endl;
+    LOGINFO << "sequence: " << sequence_ << " PRIs: " << jobs_.size() << " rows: " << numRows_ << std::endl;
+    if (jobs_.empty() || numRows_ == 0) return;
 
-    // Create complex values from our input message.
+    FFTPlanCache& cache(FFTPlanCache::Instance());
+    int numJobs = jobs_.size();
+
+    // Normalize each transmit pulse and convert them all into the frequency domain with one FFT call. Since we
+    // are correlating, we need the conjugate of the pulse spectrum.
     //
-    Messages::Video::const_iterator inputPos = input_->begin() + offset_;
-    Messages::Video::const_iterator inputEnd = input_->end();
-    size_t inputSize = inputEnd - inputPos;
-    if (inputSize > fftSize_ * 2) inputEnd = inputPos + fftSize_ * 2;
+    for (int row = 0; row < numJobs; ++row) {
+        VsipComplexMatrix::row_type pulse(txMat_->row(row));
+        float scale;
+        if (scaleWithSumMag_) {
+            scale = vsip::sqrt(vsip::sumval(vsip::magsq(pulse)));
+        } else {
+            vsip::Index<1> maxIndex;
+            scale = vsip::sqrt(vsip::maxmgsqval(pulse, maxIndex));
+        }
 
-    int index = 0;
-    while (inputPos < inputEnd) {
-        float i = *inputPos++;
-        float q = *inputPos++;
-        rxVec_->put(index++, ComplexType(i, q));
+        if (scale > 0.0) pulse /= scale;
     }
 
-    // If necessary, pad the end with zeros.
+    // NOTE: a partial batch still transforms all batchSize rows. The extra rows hold stale or zero values that
+    // no job reads, but this way the FFTPlanCache only needs one plan per batch size instead of one per PRI
+    // count.
+    //
+    VsipComplexMatrix::subview_type txView((*txMat_)(vsip::Domain<2>(batchSize_, fftSize_)));
+    FwdFFTM* txFFT = cache.acquireForward(fftSize_, batchSize_, numFFTThreads_);
+    (*txFFT)(txView);
+    cache.release(txFFT);
+    txView = vsip::conj(txView);
+
+    // Fill the receive matrix with the overlap-save segments of every PRI in the batch. Each segment begins
+    // where the previous one's valid output ended, and reads past the filter span (up to the end of the
+    // message) so that the last valid outputs see the same samples that a time-domain filter would.
     //
-    while (index < fftSize_) { rxVec_->put(index++, ComplexType(0.0, 0.0)); }
+    reserveRows(numRows_);
+    for (size_t jobIndex = 0; jobIndex < jobs_.size(); ++jobIndex) {
+        const Job& job(jobs_[jobIndex]);
+        int step = fftSize_ - job.txPulseSpan + 1;
+        Messages::Video::const_iterator inputBegin = job.input->begin();
+        Messages::Video::const_iterator inputEnd = job.input->end();
+        for (int segment = 0; segment < job.numRows; ++segment) {
+            int row = job.firstRow + segment;
+            Messages::Video::const_iterator pos = inputBegin + 2 * (job.rxFilterStart + segment * step);
+            Messages::Video::const_iterator end = inputEnd;
+            if (end - pos > fftSize_ * 2) end = pos + fftSize_ * 2;
+
+            int index = 0;
+            while (pos < end) {
+                float i = *pos++;
+                float q = *pos++;
+                rxMat_->put(row, index++, ComplexType(i, q));
+            }
+
+            // If necessary, pad the end with zeros.
+            //
+            while (index < fftSize_) rxMat_->put(row, index++, ComplexType(0.0, 0.0));
+        }
+    }
 
-    // Filter the data in-place.
+    // Filter all segments in-place: one forward FFT call, a row-wise multiply by the pulse spectrum of the
+    // segment's PRI, and one inverse FFT call. As above, transform every row of the matrix, not just those in
+    // use, to limit the number of plans.
     //
-    (*rxVec_) = (*invFFT_)((*txPulseVec_) * (*fwdFFT_)((*rxVec_)));
+    int numRows = rxMat_->size(0);
+    VsipComplexMatrix::subview_type rxView((*rxMat_)(vsip::Domain<2>(numRows, fftSize_)));
+    FwdFFTM* fwdFFT = cache.acquireForward(fftSize_, numRows, numFFTThreads_);
+    (*fwdFFT)(rxView);
+    cache.release(fwdFFT);
+
+    for (size_t jobIndex = 0; jobIndex < jobs_.size(); ++jobIndex) {
+        const Job& job(jobs_[jobIndex]);
+        VsipComplexMatrix::row_type pulse(txMat_->row(jobIndex));
+        for (int segment = 0; segment < job.numRows; ++segment) { rxView.row(job.firstRow + segment) *= pulse; }
+    }
+
+    InvFFTM* invFFT = cache.acquireInverse(fftSize_, numRows, numFFTThreads_);
+    (*invFFT)(rxView);
+    cache.release(invFFT);
 
-    // Replace the appropriate output message samples with the complex component values from the above filtering
-    // operation.
+    // Replace the appropriate output message samples with the complex component values from the above
+    // filtering operation. Only the first (fftSize - txPulseSpan + 1) values of a segment are free from
+    // circular wrap-around.
     //
-    Messages::Video::iterator outputPos = output_->begin() + offset_;
-    Messages::Video::iterator outputEnd = output_->end();
-    size_t outputSize = outputEnd - outputPos;
-    if (outputSize > fftSize_ * 2) outputEnd = outputPos + fftSize_ * 2;
-
-    index = 0;
-    while (outputPos < outputEnd) {
-        *outputPos++ = Messages::Video::DatumType(rxVec_->get(index).real());
-        *outputPos++ = Messages::Video::DatumType(rxVec_->get(index).imag());
-        ++index;
+    for (size_t jobIndex = 0; jobIndex < jobs_.size(); ++jobIndex) {
+        const Job& job(jobs_[jobIndex]);
+        int step = fftSize_ - job.txPulseSpan + 1;
+        for (int segment = 0; segment < job.numRows; ++segment) {
+            int row = job.firstRow + segment;
+            int first = segment * step;
+            int count = std::min(step, job.rxFilterSpan - first);
+            Messages::Video::iterator outputPos = job.output->begin() + 2 * (job.rxFilterStart + first);
+            for (int index = 0; index < count; ++index) {
+                ComplexType value(rxMat_->get(row, index));
+                *outputPos++ = Messages::Video::DatumType(value.real());
+                *outputPos++ = Messages::Video::DatumType(value.imag());
+            }
+        }
     }
 }
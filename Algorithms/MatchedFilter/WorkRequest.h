@@ -18,8 +18,14 @@ namespace SideCar {
 namespace Algorithms {
 namespace MatchedFilterUtils {
 
-/** Collection of data values that will be used for a windowed SLC processing. Encapsulates the values that must
-    not change while in use by a thread.
+/** Collection of PRIs that will be filtered together in the frequency domain. A WorkRequest holds up to
+    batchSize PRIs; each PRI contributes a transmit pulse and a span of receive samples to filter. The receive
+    span is cut into overlapping segments of fftSize samples (overlap-save), and the segments of all PRIs in the
+    batch become the rows of one matrix that is transformed with a single multiple-FFT call. FFT objects come
+    from the process-wide FFTPlanCache so that changing the batch population or the FFT size does not require
+    replanning after the first time a configuration is seen.
+
+    Encapsulates the values that must not change while in use by a thread.
 */
 class WorkRequest {
 public:
@@ -31,13 +37,15 @@ public:
 
     /** Create a new WorkRequest object with memory provided by an ACE_Message_Block.
 
-        \param enabledSize
+        \param numFFTThreads number of threads FFTW may use per transform
 
-        \param corrSpan
+        \param fftSize number of samples in each FFT
 
-        \return
+        \param batchSize maximum number of PRIs held by the request
+
+        \return new ACE_Message_Block holding the WorkRequest
     */
-    static ACE_Message_Block* Make(VsipComplexVector* txPulseVec, int numFFTThreads, int fftSize);
+    static ACE_Message_Block* Make(int numFFTThreads, int fftSize, int batchSize);
 
     /** Dispose of the WorkRequest object held within an ACE_Message_Block, and release the ACE_Message_Block
         memory.
@@ -56,19 +64,67 @@ public:
 
     /** Reconfigure the work request with new values. Reallocates some VSIPL objects.
      */
-    void reconfigure(VsipComplexVector* txPulseVec, int numFFTThreads, int fftSize);
+    void reconfigure(int numFFTThreads, int fftSize, int batchSize);
 
     /** Initialize a new work request
 
-        \param name the name of the algorithm
+        \param scaleWithSumMag if true, normalize transmit pulses by the sum of their magnitudes; otherwise, by
+        their largest magnitude
+    */
+    void beginRequest(bool scaleWithSumMag);
+
+    /** Add a PRI to the batch.
+
+        \param tx the transmit message holding the reference pulse
+
+        \param txPulseStart index of the first complex sample of the transmit pulse
+
+        \param txPulseSpan number of complex samples in the transmit pulse. Must not exceed the FFT size.
+
+        \param input the receive message to filter
+
+        \param output the message to receive the filtered samples
+
+        \param rxFilterStart index of the first complex sample to filter
+
+        \param rxFilterSpan number of complex samples to filter
+    */
+    void add(const Messages::Video::Ref& tx, int txPulseStart, int txPulseSpan, const Messages::Video::Ref& input,
+             const Messages::Video::Ref& output, int rxFilterStart, int rxFilterSpan);
+
+    /** \return true if the batch holds batchSize PRIs
+     */
+    bool isFull() const { return jobs_.size() == size_t(batchSize_); }
+
+    /** \return true if the batch holds no PRIs
+     */
+    bool isEmpty() const { return jobs_.empty(); }
+
+    /** \return number of PRIs in the batch
+     */
+    size_t size() const { return jobs_.size(); }
 
-        \param filterStart the first sample to filter
+    /** Obtain the output message for a given PRI in the batch
 
-        \param filterSpan the numbe of samples to filter
+        \param index which PRI to return
 
-        \param main the main message to process
+        \return output message
     */
-    void beginRequest(const Messages::Video::Ref& input, const Messages::Video::Ref& output, size_t offset);
+    const Messages::Video::Ref& getOutput(size_t index) const { return jobs_[index].output; }
+
+    /** Assign the dispatch sequence number used to restore output ordering.
+
+        \param sequence value to assign
+    */
+    void setSequence(size_t sequence) { sequence_ = sequence; }
+
+    /** \return the dispatch sequence number
+     */
+    size_t getSequence() const { return sequence_; }
+
+    /** Release references to all held messages.
+     */
+    void endRequest();
 
     /** Perform the work on the given data.
      */
@@ -77,21 +133,40 @@ public:
 private:
     /** Consturctor. Use the Make() factory method to create new WorkRequest objects.
      */
-    WorkRequest(VsipComplexVector* txPulseVec, int numFFTThreads, int fftSize);
+    WorkRequest(int numFFTThreads, int fftSize, int batchSize);
 
     /** Destructor. Here to keep someone from manually deleting a WorkRequest object; use the Destroy() class
         method instead.
     */
     ~WorkRequest();
 
-    VsipComplexVector* txPulseVec_;
+    /** Make sure that rxMat_ has at least the given number of rows.
+
+        \param rows minimum number of rows
+    */
+    void reserveRows(int rows);
+
+    /** Description of one PRI held by the batch.
+     */
+    struct Job {
+        Messages::Video::Ref input;
+        Messages::Video::Ref output;
+        int txPulseSpan;
+        int rxFilterStart;
+        int rxFilterSpan;
+        int firstRow;
+        int numRows;
+    };
+
+    int numFFTThreads_;
     int fftSize_;
-    Messages::Video::Ref input_;
-    Messages::Video::Ref output_;
-    size_t offset_;
-    boost::scoped_ptr<VsipComplexVector> rxVec_;
-    boost::scoped_ptr<FwdFFT> fwdFFT_;
-    boost::scoped_ptr<InvFFT> invFFT_;
+    int batchSize_;
+    size_t sequence_;
+    bool scaleWithSumMag_;
+    int numRows_;
+    std::vector<Job> jobs_;
+    boost::scoped_ptr<VsipComplexMatrix> txMat_;
+    boost::scoped_ptr<VsipComplexMatrix> rxMat_;
 };
 
 } // namespace MatchedFilterUtils
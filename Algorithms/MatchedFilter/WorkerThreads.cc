@@ -34,12 +34,13 @@ WorkerThreads::svc()
     LOGINFO << "starting" << std::endl;
 
     // Fetch the next WorkRequest object from the pending work request queue, process it, and then add it to the
-    // finished queue.
+    // finished queue. Wake up the algorithm so that it emits the batch even if no new input arrives.
     //
     ACE_Message_Block* data = 0;
     while (pendingQueue_.dequeue_head(data) != -1) {
         WorkRequest::FromMessageBlock(data)->process();
         finishedQueue_.enqueue_tail(data);
+        if (!algorithm_.requestAlarm()) LOGERROR << "failed to wake up the algorithm" << std::endl;
     }
 
     LOGWARNING << "exiting" << std::endl;
@@ -15,8 +15,12 @@ namespace MatchedFilterUtils {
 /** Thread pool that generates threads that perform the following in the overridden svc() method:
 
     - fetch the next WorkRequest object from the pending WorkRequest queue
-    - call the WorkRequest::process() method to process a slice of the data
+    - call the WorkRequest::process() method to filter a batch of PRIs
     - post the finished WorkRequest object onto the finished WorkRequest queue
+    - ask the algorithm for a processAlarm() call so that it emits the batch without waiting for more input
+
+    Since there may be more than one thread, batches may finish out of order. Each WorkRequest carries a
+    sequence number that the MatchedFilter algorithm uses to restore the original order before emitting.
 */
 class WorkerThreads : public ACE_Task<ACE_MT_SYNCH> {
     using Super = ACE_Task<ACE_MT_SYNCH>;
@@ -31,8 +35,7 @@ public:
     /** Constructor for the thread pool. Installs the pending and finished WorkRequest object queues. NOTE: does
         not create any threads; one must still invoke the ACE_Task::activate() method.
 
-        \param algorithm the thread will post output messages to the
-        Algorithm::send() method of this object
+        \param algorithm the threads wake up this object via Algorithm::requestAlarm() when a batch is finished
 
         \param pendingQueue thread-safe FIFO queue for pending WorkRequest
         objects
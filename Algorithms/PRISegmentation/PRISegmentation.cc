@@ -55,7 +55,7 @@ PRISegmentation::process(const Video::Ref& pri)
         out.merge(s);
     }
 
-    if (out.data().size()) {
+    if (!out.empty()) {
         busy_ = true;
         return send(output);
     } else if (busy_) {
@@ -0,0 +1,146 @@
+#include <algorithm>
+
+#include "CornerTurn.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms::RangeDopplerMapUtils;
+
+CornerTurn::CornerTurn() :
+    matrix_(), staging_(), stagedGates_(kTilePulses, 0), filled_(), numPulses_(0), numGates_(0), tileBegin_(0),
+    nextTile_(0), numFilled_(0)
+{
+    ;
+}
+
+void
+CornerTurn::reset(size_t numPulses, size_t numGates)
+{
+    numPulses_ = numPulses;
+    numGates_ = numGates;
+    matrix_.resize(numPulses * numGates);
+    staging_.resize(kTilePulses * numGates);
+    std::fill(stagedGates_.begin(), stagedGates_.end(), 0);
+    filled_.assign(numPulses, false);
+    tileBegin_ = 0;
+    nextTile_ = 0;
+    numFilled_ = 0;
+}
+
+void
+CornerTurn::add(size_t pulse, const Messages::Video::Ref& msg, float weight)
+{
+    if (pulse >= numPulses_) return;
+
+    size_t gates = msg->size() / 2;
+    if (gates > numGates_) growGates(gates);
+
+    Messages::Video::const_iterator pos = msg->begin();
+
+    // Only count a pulse the first time it is given a PRI.
+    //
+    if (!filled_[pulse]) {
+        filled_[pulse] = true;
+        ++numFilled_;
+    }
+
+    // Handle the rare case of a PRI that arrives after the staging tile moved past it: write directly into the
+    // range-major matrix. If the pulse lies in a tile that was skipped but not yet zero-filled, do the zero-fill
+    // now so that it does not later wipe out the PRI.
+    //
+    if (pulse < tileBegin_) {
+        if (pulse >= nextTile_) {
+            zeroPulses(nextTile_, tileBegin_);
+            nextTile_ = tileBegin_;
+        }
+
+        ComplexType* dst = &matrix_[pulse];
+        size_t gate = 0;
+        for (; gate < gates; ++gate, pos += 2, dst += numPulses_) {
+            *dst = ComplexType(pos[0] * weight, pos[1] * weight);
+        }
+
+        for (; gate < numGates_; ++gate, dst += numPulses_) *dst = ComplexType(0.0, 0.0);
+        return;
+    }
+
+    // If the PRI belongs to a later tile, transpose the current one first.
+    //
+    if (pulse >= tileBegin_ + kTilePulses) {
+        flushTile();
+        tileBegin_ = pulse - pulse % kTilePulses;
+    }
+
+    // Write the PRI into the staging tile, which is a contiguous, sequential write.
+    //
+    size_t row = pulse - tileBegin_;
+    ComplexType* dst = &staging_[row * numGates_];
+    for (size_t gate = 0; gate < gates; ++gate, pos += 2) dst[gate] = ComplexType(pos[0] * weight, pos[1] * weight);
+
+    stagedGates_[row] = gates;
+}
+
+void
+CornerTurn::finish()
+{
+    if (tileBegin_ >= nextTile_ && tileBegin_ < numPulses_) flushTile();
+    zeroPulses(nextTile_, numPulses_);
+    nextTile_ = numPulses_;
+    tileBegin_ = numPulses_;
+}
+
+void
+CornerTurn::flushTile()
+{
+    // Zero-fill any tiles that were skipped because none of their PRIs arrived.
+    //
+    zeroPulses(nextTile_, tileBegin_);
+
+    size_t tilePulses = std::min(size_t(kTilePulses), numPulses_ - tileBegin_);
+
+    // Transpose the staging tile one block of gates at a time. For each gate we write tilePulses contiguous
+    // values; the reads come from tilePulses staging rows that stay in the cache for the whole block.
+    //
+    for (size_t blockBegin = 0; blockBegin < numGates_; blockBegin += kTileGates) {
+        size_t blockEnd = std::min(blockBegin + kTileGates, numGates_);
+        for (size_t gate = blockBegin; gate < blockEnd; ++gate) {
+            ComplexType* dst = &matrix_[gate * numPulses_ + tileBegin_];
+            const ComplexType* src = &staging_[gate];
+            for (size_t row = 0; row < tilePulses; ++row, src += numGates_) {
+                dst[row] = gate < stagedGates_[row] ? *src : ComplexType(0.0, 0.0);
+            }
+        }
+    }
+
+    std::fill(stagedGates_.begin(), stagedGates_.end(), 0);
+    nextTile_ = tileBegin_ + tilePulses;
+}
+
+void
+CornerTurn::zeroPulses(size_t begin, size_t end)
+{
+    if (begin >= end) return;
+    for (size_t gate = 0; gate < numGates_; ++gate) {
+        ComplexType* row = &matrix_[gate * numPulses_];
+        std::fill(row + begin, row + end, ComplexType(0.0, 0.0));
+    }
+}
+
+void
+CornerTurn::growGates(size_t numGates)
+{
+    // Since the matrix is range-major, new gates are simply new rows at the end. Any pulses that were already
+    // transposed must appear as zeros in the new rows, which std::vector::resize() gives us.
+    //
+    matrix_.resize(numPulses_ * numGates, ComplexType(0.0, 0.0));
+
+    // The staging tile is pulse-major, so its rows must be spread out.
+    //
+    std::vector<ComplexType> staging(kTilePulses * numGates);
+    for (size_t row = 0; row < kTilePulses && numGates_; ++row) {
+        std::copy(&staging_[row * numGates_], &staging_[row * numGates_] + stagedGates_[row],
+                  &staging[row * numGates]);
+    }
+
+    staging_.swap(staging);
+    numGates_ = numGates;
+}
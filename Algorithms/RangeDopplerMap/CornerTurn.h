@@ -0,0 +1,124 @@
+#ifndef SIDECAR_ALGORITHMS_RANGEDOPPLERMAP_CORNERTURN_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_RANGEDOPPLERMAP_CORNERTURN_H
+
+#include <complex>
+#include <vector>
+
+#include "Messages/Video.h"
+
+namespace SideCar {
+namespace Algorithms {
+namespace RangeDopplerMapUtils {
+
+/** Cache-blocked corner turn (transpose) of a CPI. PRIs arrive one at a time in pulse-major order (all of the
+    gates of one pulse), but Doppler processing wants range-major order (all of the pulses of one gate) so that
+    each Doppler FFT runs over contiguous memory. Writing a PRI directly into a range-major matrix strides
+    through memory by the number of pulses for every sample, touching a new cache line each time.
+
+    Instead, arriving PRIs are copied (and weighted) into a small pulse-major staging tile of kTilePulses rows.
+    When the tile is full, or when a PRI arrives for a later tile, the staging tile is transposed into the
+    range-major matrix in blocks of kTileGates gates, so that both the reads and the writes of one block stay
+    within the cache.
+
+    Pulses for which no PRI arrived are zero-filled when their tile is flushed. A PRI for a pulse before the
+    staging tile goes straight into the range-major matrix.
+*/
+class CornerTurn {
+public:
+    using ComplexType = std::complex<float>;
+
+    enum { kTilePulses = 16, kTileGates = 64 };
+
+    /** Constructor.
+     */
+    CornerTurn();
+
+    /** Prepare for a new CPI. Does not release memory if the new CPI is not larger than the previous one.
+
+        \param numPulses number of pulses in the CPI
+
+        \param numGates initial number of gates (complex samples) per pulse
+    */
+    void reset(size_t numPulses, size_t numGates);
+
+    /** Add a PRI to the CPI. Increases the number of gates if the PRI holds more complex samples than the
+        current gate count.
+
+        \param pulse index of the pulse within the CPI. Values outside of the CPI are ignored.
+
+        \param msg the PRI holding I/Q sample pairs
+
+        \param weight value applied to every sample of the PRI (eg. a window function)
+    */
+    void add(size_t pulse, const Messages::Video::Ref& msg, float weight);
+
+    /** Flush any partially-filled tile. Must be called before using the range-major data.
+     */
+    void finish();
+
+    /** \return number of pulses in the CPI
+     */
+    size_t getNumPulses() const { return numPulses_; }
+
+    /** \return number of gates in the CPI
+     */
+    size_t getNumGates() const { return numGates_; }
+
+    /** \return number of distinct pulses that were given a PRI since the last reset()
+     */
+    size_t getNumFilled() const { return numFilled_; }
+
+    /** Obtain the range-major CPI data. The pulses for gate G start at getData() + G * getNumPulses().
+
+        \return pointer to the first element
+    */
+    ComplexType* getData() { return &matrix_[0]; }
+
+    /** Obtain one value from the range-major CPI data.
+
+        \param gate the gate index
+
+        \param pulse the pulse index
+
+        \return value
+    */
+    const ComplexType& get(size_t gate, size_t pulse) const { return matrix_[gate * numPulses_ + pulse]; }
+
+private:
+    /** Transpose the staging tile into the range-major matrix.
+     */
+    void flushTile();
+
+    /** Zero-fill a range of pulses for all gates.
+
+        \param begin first pulse to zero
+
+        \param end one past the last pulse to zero
+    */
+    void zeroPulses(size_t begin, size_t end);
+
+    /** Increase the number of gates in the CPI, moving any already-transposed data to its new location.
+
+        \param numGates new gate count
+    */
+    void growGates(size_t numGates);
+
+    std::vector<ComplexType> matrix_;  ///< Range-major CPI data
+    std::vector<ComplexType> staging_; ///< Pulse-major staging tile
+    std::vector<size_t> stagedGates_;  ///< Number of gates written into each staging row; 0 if none
+    std::vector<bool> filled_;         ///< True for each pulse that was given a PRI
+    size_t numPulses_;
+    size_t numGates_;
+    size_t tileBegin_; ///< Index of the first pulse of the staging tile
+    size_t nextTile_;  ///< Index of the first pulse not yet transposed into matrix_
+    size_t numFilled_;
+};
+
+} // namespace RangeDopplerMapUtils
+} // namespace Algorithms
+} // namespace SideCar
+
+/** \file
+ */
+
+#endif
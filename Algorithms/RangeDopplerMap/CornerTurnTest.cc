@@ -0,0 +1,267 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "Logger/Log.h"
+#include "Messages/Video.h"
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "CornerTurn.h"
+#include "DopplerProcessor.h"
+
+#include <vsip/initfin.hpp>
+
+using namespace SideCar;
+using namespace SideCar::Algorithms::RangeDopplerMapUtils;
+using namespace SideCar::Messages;
+
+using ComplexType = CornerTurn::ComplexType;
+
+struct Test : public UnitTest::TestObj {
+    enum { kBenchmarkGates = 4096, kBenchmarkIterations = 20 };
+
+    Test() : UnitTest::TestObj("CornerTurn") {}
+
+    void test();
+
+    /** Create a PRI message whose I/Q values encode the pulse and gate index so that we can verify placement.
+     */
+    static Video::Ref MakePRI(size_t pulse, size_t gates);
+
+    void testTranspose();
+    void testMissingAndLatePulses();
+    void testPulseInSkippedTile();
+    void testGrowingGates();
+    void testDoppler();
+    void benchmark();
+};
+
+Video::Ref
+Test::MakePRI(size_t pulse, size_t gates)
+{
+    VMEDataMessage vme;
+    vme.header.azimuth = 0;
+    vme.header.pri = pulse;
+    Video::Ref msg(Video::Make("test", vme, gates * 2));
+    for (size_t gate = 0; gate < gates; ++gate) {
+        msg->getData()[gate * 2] = pulse;
+        msg->getData()[gate * 2 + 1] = gate;
+    }
+
+    return msg;
+}
+
+void
+Test::testTranspose()
+{
+    CornerTurn ct;
+    const size_t kPulses = 37; // Not a multiple of the tile size
+    const size_t kGates = 150;
+    ct.reset(kPulses, kGates);
+    for (size_t pulse = 0; pulse < kPulses; ++pulse) ct.add(pulse, MakePRI(pulse, kGates), 2.0);
+    ct.finish();
+
+    assertEqual(kPulses, ct.getNumFilled());
+    for (size_t gate = 0; gate < kGates; ++gate) {
+        for (size_t pulse = 0; pulse < kPulses; ++pulse) {
+            assertEqual(ComplexType(pulse * 2.0, gate * 2.0), ct.get(gate, pulse));
+        }
+    }
+
+    // Reuse of the same object must not leak values from the previous CPI.
+    //
+    ct.reset(kPulses, kGates);
+    ct.add(3, MakePRI(3, kGates), 1.0);
+    ct.finish();
+    assertEqual(size_t(1), ct.getNumFilled());
+    for (size_t gate = 0; gate < kGates; ++gate) {
+        for (size_t pulse = 0; pulse < kPulses; ++pulse) {
+            assertEqual(pulse == 3 ? ComplexType(3, gate) : ComplexType(0.0, 0.0), ct.get(gate, pulse));
+        }
+    }
+}
+
+void
+Test::testMissingAndLatePulses()
+{
+    CornerTurn ct;
+    const size_t kPulses = 64;
+    const size_t kGates = 100;
+    ct.reset(kPulses, kGates);
+
+    // Skip an entire tile (16-31), drop pulse 5, and deliver pulse 2 after its tile was flushed.
+    //
+    for (size_t pulse = 0; pulse < kPulses; ++pulse) {
+        if (pulse == 2 || pulse == 5 || (pulse >= 16 && pulse < 32)) continue;
+        ct.add(pulse, MakePRI(pulse, kGates), 1.0);
+    }
+
+    ct.add(2, MakePRI(2, kGates), 1.0);
+    ct.finish();
+
+    assertEqual(kPulses - 17, ct.getNumFilled());
+    for (size_t gate = 0; gate < kGates; ++gate) {
+        for (size_t pulse = 0; pulse < kPulses; ++pulse) {
+            bool missing = pulse == 5 || (pulse >= 16 && pulse < 32);
+            assertEqual(missing ? ComplexType(0.0, 0.0) : ComplexType(pulse, gate), ct.get(gate, pulse));
+        }
+    }
+}
+
+void
+Test::testPulseInSkippedTile()
+{
+    CornerTurn ct;
+    const size_t kPulses = 64;
+    const size_t kGates = 128;
+    ct.reset(kPulses, kGates);
+
+    // Pulse 40 moves the staging tile past the unfilled tile 16-31, and then pulse 20 arrives late for it.
+    // Repeats of a pulse, before and after its tile was flushed, must not count twice.
+    //
+    for (size_t pulse = 0; pulse < 16; ++pulse) ct.add(pulse, MakePRI(pulse, kGates), 1.0);
+    ct.add(40, MakePRI(40, kGates), 1.0);
+    ct.add(20, MakePRI(20, kGates), 1.0);
+    ct.add(20, MakePRI(20, kGates), 1.0);
+    ct.add(3, MakePRI(3, kGates), 1.0);
+    ct.add(41, MakePRI(41, kGates), 1.0);
+    ct.add(41, MakePRI(41, kGates), 1.0);
+    ct.finish();
+
+    assertEqual(size_t(19), ct.getNumFilled());
+    for (size_t gate = 0; gate < kGates; ++gate) {
+        for (size_t pulse = 0; pulse < kPulses; ++pulse) {
+            bool present = pulse < 16 || pulse == 20 || pulse == 40 || pulse == 41;
+            assertEqual(present ? ComplexType(pulse, gate) : ComplexType(0.0, 0.0), ct.get(gate, pulse));
+        }
+    }
+}
+
+void
+Test::testGrowingGates()
+{
+    CornerTurn ct;
+    const size_t kPulses = 40;
+    ct.reset(kPulses, 10);
+
+    // PRIs get longer over the CPI, both within a tile and after earlier tiles were flushed. Gates beyond the
+    // end of a short PRI must be zero.
+    //
+    for (size_t pulse = 0; pulse < kPulses; ++pulse) ct.add(pulse, MakePRI(pulse, 10 + pulse), 1.0);
+    ct.finish();
+
+    assertEqual(size_t(10 + kPulses - 1), ct.getNumGates());
+    for (size_t gate = 0; gate < ct.getNumGates(); ++gate) {
+        for (size_t pulse = 0; pulse < kPulses; ++pulse) {
+            bool present = gate < 10 + pulse;
+            assertEqual(present ? ComplexType(pulse, gate) : ComplexType(0.0, 0.0), ct.get(gate, pulse));
+        }
+    }
+}
+
+void
+Test::testDoppler()
+{
+    // A constant signal has all of its energy in Doppler bin 0. Verify that each thread count gives the same
+    // result.
+    //
+    const size_t kPulses = 32;
+    const size_t kGates = 257;
+    for (int threads = 1; threads <= 4; ++threads) {
+        DopplerProcessor doppler;
+        doppler.setNumThreads(threads);
+        std::vector<ComplexType> data(kPulses * kGates);
+        for (size_t gate = 0; gate < kGates; ++gate) {
+            for (size_t pulse = 0; pulse < kPulses; ++pulse) data[gate * kPulses + pulse] = ComplexType(gate, 0.0);
+        }
+
+        doppler.process(&data[0], kGates, kPulses, 1.0 / kPulses);
+        for (size_t gate = 0; gate < kGates; ++gate) {
+            assertEqualEpsilon(float(gate), data[gate * kPulses].real(), 1.0E-3);
+            for (size_t pulse = 1; pulse < kPulses; ++pulse) {
+                assertEqualEpsilon(0.0f, data[gate * kPulses + pulse].real(), 1.0E-3);
+            }
+        }
+    }
+}
+
+void
+Test::benchmark()
+{
+    // Compare the tiled corner turn against a naive strided transpose of each PRI as it arrives, and the Doppler
+    // FFT stage with one and several threads.
+    //
+    const size_t kGates = kBenchmarkGates;
+    int cpiSpans[] = {16, 32, 64, 128, 256};
+    for (size_t index = 0; index < sizeof(cpiSpans) / sizeof(int); ++index) {
+        size_t pulses = cpiSpans[index];
+        std::vector<Video::Ref> pris;
+        for (size_t pulse = 0; pulse < pulses; ++pulse) pris.push_back(MakePRI(pulse, kGates));
+
+        std::vector<ComplexType> naive(pulses * kGates);
+        Time::TimeStamp begin(Time::TimeStamp::Now());
+        for (int iteration = 0; iteration < kBenchmarkIterations; ++iteration) {
+            for (size_t pulse = 0; pulse < pulses; ++pulse) {
+                Video::const_iterator pos = pris[pulse]->begin();
+                ComplexType* dst = &naive[pulse];
+                for (size_t gate = 0; gate < kGates; ++gate, pos += 2, dst += pulses) {
+                    *dst = ComplexType(pos[0], pos[1]);
+                }
+            }
+        }
+
+        Time::TimeStamp naiveDelta(Time::TimeStamp::Now());
+        naiveDelta -= begin;
+
+        CornerTurn ct;
+        begin = Time::TimeStamp::Now();
+        for (int iteration = 0; iteration < kBenchmarkIterations; ++iteration) {
+            ct.reset(pulses, kGates);
+            for (size_t pulse = 0; pulse < pulses; ++pulse) ct.add(pulse, pris[pulse], 1.0);
+            ct.finish();
+        }
+
+        Time::TimeStamp tiledDelta(Time::TimeStamp::Now());
+        tiledDelta -= begin;
+
+        std::clog << "cpiSpan: " << pulses << " gates: " << kGates
+                  << " naive: " << naiveDelta.asDouble() / kBenchmarkIterations
+                  << " tiled: " << tiledDelta.asDouble() / kBenchmarkIterations << " sec/CPI" << std::endl;
+
+        for (int threads = 1; threads <= 4; threads *= 2) {
+            DopplerProcessor doppler;
+            doppler.setNumThreads(threads);
+            std::vector<ComplexType> data(ct.getData(), ct.getData() + pulses * kGates);
+            doppler.process(&data[0], kGates, pulses, 1.0); // Create the FFT plans outside of the timing
+            begin = Time::TimeStamp::Now();
+            for (int iteration = 0; iteration < kBenchmarkIterations; ++iteration) {
+                doppler.process(&data[0], kGates, pulses, 1.0);
+            }
+
+            Time::TimeStamp delta(Time::TimeStamp::Now());
+            delta -= begin;
+            std::clog << "  doppler threads: " << threads << " " << delta.asDouble() / kBenchmarkIterations
+                      << " sec/CPI" << std::endl;
+        }
+    }
+}
+
+void
+Test::test()
+{
+    Logger::Log::Root().setPriorityLimit(Logger::Priority::kError);
+    testTranspose();
+    testMissingAndLatePulses();
+    testPulseInSkippedTile();
+    testGrowingGates();
+    testDoppler();
+    benchmark();
+}
+
+int
+main(int argc, char** argv)
+{
+    vsip::vsipl v;
+    return Test().mainRun();
+}
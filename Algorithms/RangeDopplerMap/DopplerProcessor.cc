@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Logger/Log.h"
+
+#include "DopplerProcessor.h"
+
+#include <vsip/dense.hpp>
+#include <vsip/domain.hpp>
+
+using namespace SideCar::Algorithms::RangeDopplerMapUtils;
+
+Logger::Log&
+DopplerProcessor::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.Algorithms.RangeDopplerMap.DopplerProcessor");
+    return log_;
+}
+
+DopplerProcessor::DopplerProcessor() : numThreads_(1), blocks_(), finished_(), workers_()
+{
+    ;
+}
+
+DopplerProcessor::~DopplerProcessor()
+{
+    stopThreads();
+    for (size_t index = 0; index < blocks_.size(); ++index) delete blocks_[index];
+}
+
+void
+DopplerProcessor::setNumThreads(int numThreads)
+{
+    Logger::ProcLog log("setNumThreads", Log());
+    LOGINFO << "numThreads: " << numThreads << std::endl;
+
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads == numThreads_) return;
+
+    stopThreads();
+    numThreads_ = numThreads;
+    if (numThreads_ == 1) return;
+
+    workers_.reset(new Workers(finished_));
+    if (workers_->activate(THR_NEW_LWP | THR_JOINABLE | THR_INHERIT_SCHED, numThreads_) == -1) {
+        LOGERROR << "failed to activate worker threads" << std::endl;
+        workers_.reset();
+        numThreads_ = 1;
+    }
+}
+
+void
+DopplerProcessor::stopThreads()
+{
+    if (!workers_) return;
+    workers_->msg_queue()->deactivate();
+    workers_->wait();
+    workers_.reset();
+}
+
+void
+DopplerProcessor::process(ComplexType* data, size_t numGates, size_t numPulses, float scale)
+{
+    static Logger::ProcLog log("process", Log());
+    LOGINFO << "numGates: " << numGates << " numPulses: " << numPulses << " threads: " << numThreads_ << std::endl;
+
+    if (!numGates || !numPulses) return;
+
+    // Use a couple of blocks per thread so that a slow thread does not hold up the rest.
+    //
+    size_t numBlocks = std::min(numThreads_ == 1 ? size_t(1) : size_t(numThreads_ * 2), numGates);
+    size_t gatesPerBlock = (numGates + numBlocks - 1) / numBlocks;
+    while (blocks_.size() < numBlocks) blocks_.push_back(new Block);
+
+    // Assign gate ranges to the blocks. Creating an FFT object runs the FFTW planner, which is not thread-safe,
+    // so we do it here before handing off any blocks to the worker threads.
+    //
+    size_t used = 0;
+    for (size_t gate = 0; gate < numGates; gate += gatesPerBlock, ++used) {
+        Block* block = blocks_[used];
+        size_t count = std::min(gatesPerBlock, numGates - gate);
+        if (!block->fft || block->numGates != count || block->numPulses != numPulses) {
+            LOGDEBUG << "creating FFT for block " << used << " gates: " << count << std::endl;
+            block->fft.reset(new ForwardFFTM(vsip::Domain<2>(count, numPulses), 1.0));
+        }
+
+        block->data = data + gate * numPulses;
+        block->numGates = count;
+        block->numPulses = numPulses;
+        block->scale = scale;
+    }
+
+    if (!workers_) {
+        for (size_t index = 0; index < used; ++index) blocks_[index]->process();
+        return;
+    }
+
+    for (size_t index = 0; index < used; ++index) {
+        workers_->putq(new ACE_Message_Block(reinterpret_cast<const char*>(blocks_[index]), sizeof(Block)));
+    }
+
+    // Wait for all of the blocks to finish.
+    //
+    for (size_t index = 0; index < used; ++index) {
+        ACE_Message_Block* finished = 0;
+        if (finished_.dequeue_head(finished) == -1) {
+            LOGERROR << "failed to fetch finished block" << std::endl;
+            break;
+        }
+
+        finished->release();
+    }
+}
+
+void
+DopplerProcessor::Block::process()
+{
+    // Wrap the block's rows in a VSIPL matrix that uses our memory, and transform each row.
+    //
+    vsip::Dense<2, ComplexType> storage(vsip::Domain<2>(numGates, numPulses), data);
+    storage.admit(true);
+    {
+        vsip::Matrix<ComplexType, vsip::Dense<2, ComplexType>> view(storage);
+        (*fft)(view);
+    }
+    storage.release(true);
+
+    // Convert to scaled magnitudes while the rows are still in the cache.
+    //
+    ComplexType* end = data + numGates * numPulses;
+    for (ComplexType* pos = data; pos < end; ++pos) *pos = ComplexType(std::abs(*pos) * scale, 0.0);
+}
+
+int
+DopplerProcessor::Workers::svc()
+{
+    ACE_Message_Block* data = 0;
+    while (getq(data) != -1) {
+        reinterpret_cast<Block*>(data->base())->process();
+        finished_.enqueue_tail(data);
+    }
+
+    return 0;
+}
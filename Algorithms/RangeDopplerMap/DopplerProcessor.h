@@ -0,0 +1,113 @@
+#ifndef SIDECAR_ALGORITHMS_RANGEDOPPLERMAP_DOPPLERPROCESSOR_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_RANGEDOPPLERMAP_DOPPLERPROCESSOR_H
+
+#include <complex>
+#include <vector>
+
+#include "ace/Message_Queue_T.h"
+#include "ace/Task.h"
+#include "boost/scoped_ptr.hpp"
+
+#include <vsip/matrix.hpp>
+#include <vsip/signal.hpp>
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace Algorithms {
+namespace RangeDopplerMapUtils {
+
+/** Performs the Doppler FFTs of a range-major CPI (see CornerTurn). Each gate's pulses are contiguous, so the
+    CPI is treated as a matrix with one row per gate, and a row-wise multiple-FFT transforms every gate. After
+    the FFT, each value is replaced by its scaled magnitude.
+
+    The rows are divided into contiguous blocks of gates. With more than one thread, each block is handed to a
+    pool of worker threads, and process() waits until all of the blocks are done. Each block owns its own FFT
+    object since VSIPL FFT objects are not safe to share between threads.
+*/
+class DopplerProcessor {
+public:
+    using ComplexType = std::complex<float>;
+
+    /** Obtain the log device for DopplerProcessor objects
+
+        \return Logger::Log reference
+    */
+    static Logger::Log& Log();
+
+    /** Constructor. Starts with one thread (the caller's).
+     */
+    DopplerProcessor();
+
+    /** Destructor. Stops any worker threads.
+     */
+    ~DopplerProcessor();
+
+    /** Change the number of threads that perform the FFTs. A value of 1 uses the caller's thread only.
+
+        \param numThreads number of threads to use
+    */
+    void setNumThreads(int numThreads);
+
+    /** \return number of threads in use
+     */
+    int getNumThreads() const { return numThreads_; }
+
+    /** Transform each row of a range-major CPI in place, leaving the scaled magnitude of the Doppler spectrum in
+        the real component of each value.
+
+        \param data address of the first value of the CPI
+
+        \param numGates number of rows in the CPI
+
+        \param numPulses number of values in each row
+
+        \param scale value to multiply each magnitude by
+    */
+    void process(ComplexType* data, size_t numGates, size_t numPulses, float scale);
+
+private:
+    using ForwardFFTM = vsip::Fftm<ComplexType, ComplexType, vsip::row, vsip::fft_fwd, vsip::by_reference>;
+
+    /** A contiguous range of rows to transform.
+     */
+    struct Block {
+        Block() : data(0), numGates(0), numPulses(0), scale(1.0), fft() {}
+        void process();
+        ComplexType* data;
+        size_t numGates;
+        size_t numPulses;
+        float scale;
+        boost::scoped_ptr<ForwardFFTM> fft;
+    };
+
+    /** Thread pool that processes Block objects taken from its message queue, and posts them to a finished
+        queue when done.
+    */
+    class Workers : public ACE_Task<ACE_MT_SYNCH> {
+    public:
+        Workers(ACE_Message_Queue<ACE_MT_SYNCH>& finished) : ACE_Task<ACE_MT_SYNCH>(0), finished_(finished) {}
+        int svc();
+
+    private:
+        ACE_Message_Queue<ACE_MT_SYNCH>& finished_;
+    };
+
+    void stopThreads();
+
+    int numThreads_;
+    std::vector<Block*> blocks_;
+    ACE_Message_Queue<ACE_MT_SYNCH> finished_;
+    boost::scoped_ptr<Workers> workers_;
+};
+
+} // namespace RangeDopplerMapUtils
+} // namespace Algorithms
+} // namespace SideCar
+
+/** \file
+ */
+
+#endif
@@ -4,32 +4,30 @@
 #include <deque>
 #include <vector>
 
-#include "boost/scoped_ptr.hpp"
-
-#include <vsip/math.hpp>
-#include <vsip/matrix.hpp>
-#include <vsip/signal.hpp>
-#include <vsip/support.hpp>
-#include <vsip/vector.hpp>
-
 #include "Algorithms/CPIAlgorithm.h"
 #include "Messages/Video.h"
 #include "Parameter/Parameter.h"
 
+#include "CornerTurn.h"
+#include "DopplerProcessor.h"
+
 namespace SideCar {
 namespace Algorithms {
 
-/** Documentation for the algorithm %s. Please describe what the algorithm does, in layman's terms and, if
-    possible, mathematical terms.
-*/
+/** Generates a range-Doppler map from a CPI of complex PRIs. Each PRI is weighted by a Hamming window value for
+    its position in the CPI, and an FFT across the pulses of each gate yields the Doppler spectrum for that
+    gate. The output message for PRI N of the CPI holds the magnitudes of Doppler bin N for all gates.
 
+    PRIs are corner-turned into range-major order as they arrive (see RangeDopplerMapUtils::CornerTurn), so the
+    Doppler FFTs run over contiguous memory. The FFTs are divided by blocks of gates among numThreads threads
+    (see RangeDopplerMapUtils::DopplerProcessor).
+*/
 class RangeDopplerMap : public CPIAlgorithm {
 public:
     using Super = CPIAlgorithm;
     using ComplexType = std::complex<float>;
-    using VsipComplexVector = vsip::Vector<ComplexType>;
-    using VsipComplexMatrix = vsip::Matrix<ComplexType>;
-    using ForwardFFTM = vsip::Fftm<ComplexType, ComplexType, vsip::col, vsip::fft_fwd, vsip::by_reference>;
+
+    enum InfoSlot { kNumThreads = Super::kNumSlots, kNumSlots };
 
     /** Constructor.
 
@@ -45,20 +43,36 @@ public:
     */
     bool startup();
 
+    void setNumThreads(int value) { numThreads_->setValue(value); }
+
 private:
+    size_t getNumInfoSlots() const { return kNumSlots; }
+
+    void setInfoSlots(IO::StatusBase& status);
+
     bool cpiSpanChanged(const Parameter::PositiveIntValue& parameter);
+
+    void numThreadsChanged(const Parameter::PositiveIntValue& parameter);
+
+    /** Override of CPIAlgorithm method. Corner-turn the new PRI into the CPI being built.
+
+        \param msg the message that was added
+    */
+    void priBuffered(const Messages::PRIMessage::Ref& msg);
+
     bool processCPI();
-    bool resize(int);
 
-    // Add attributes here
-    //
-    boost::scoped_ptr<VsipComplexMatrix> CPI_;
-    boost::scoped_ptr<VsipComplexMatrix> fft_output_;
-    boost::scoped_ptr<VsipComplexMatrix> HammingWindow_;
+    /** Regenerate the Hamming window weights for the given CPI span.
 
-    std::vector<float> hamming_;
+        \param cpiSpan number of PRIs in a CPI
+    */
+    void makeWindow(int cpiSpan);
 
-    size_t maxSpan_;
+    Parameter::PositiveIntValue::Ref numThreads_;
+    std::vector<float> hamming_;
+    RangeDopplerMapUtils::CornerTurn cornerTurn_;
+    RangeDopplerMapUtils::DopplerProcessor doppler_;
+    uint32_t startingSequenceNumber_;
 };
 
 } // end namespace Algorithms
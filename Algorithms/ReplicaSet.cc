@@ -0,0 +1,259 @@
+#include <sstream>
+
+#include "ace/Message_Block.h"
+
+#include "IO/MessageManager.h"
+#include "Logger/Log.h"
+#include "Messages/PRIMessage.h"
+
+#include "Algorithm.h"
+#include "Controller.h"
+#include "ReplicaSet.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms;
+
+Logger::Log&
+ReplicaSet::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.Algorithms.ReplicaSet");
+    return log_;
+}
+
+ReplicaSet::ReplicaSet(Controller& primary, const ReplicaConfig& config) :
+    primary_(primary), config_(config), replicas_(), history_(), last_(0), mutex_(), slots_(), firstOrdinal_(1),
+    posted_(config.count), current_(config.count, kIdle), sequenceNumbers_(primary.getNumOutputChannels(), 0)
+{
+    Logger::ProcLog log("ReplicaSet", Log());
+    LOGINFO << primary.getTaskName() << " count: " << config.count << " sharding: " << config.sharding
+            << " blockSize: " << config.blockSize << " sectors: " << config.sectors << " overlap: " << config.overlap
+            << std::endl;
+
+    if (!config_.blockSize) config_.blockSize = 1;
+    if (!config_.sectors) config_.sectors = config_.count;
+
+    for (size_t index = 0; index < config_.count; ++index) {
+        Controller::Ref replica(Controller::Make());
+        for (size_t channel = 0; channel < primary.getNumInputChannels(); ++channel) {
+            const IO::Channel& input(primary.getInputChannel(channel));
+            replica->addInputChannel(IO::Channel(input.getName(), input.getTypeName()));
+        }
+
+        for (size_t channel = 0; channel < primary.getNumOutputChannels(); ++channel) {
+            const IO::Channel& output(primary.getOutputChannel(channel));
+            replica->addOutputChannel(IO::Channel(output.getName(), output.getTypeName()));
+        }
+
+        replica->setXMLDefinition(primary.getXMLDefinition());
+        replica->setExecutor(primary.executor_);
+        replica->replicaSet_ = this;
+        replica->replicaIndex_ = index;
+        replicas_.push_back(replica);
+    }
+}
+
+ReplicaSet::~ReplicaSet()
+{
+    close();
+}
+
+bool
+ReplicaSet::open(long threadFlags, long threadPriority, bool threaded)
+{
+    Logger::ProcLog log("open", Log());
+
+    for (size_t index = 0; index < replicas_.size(); ++index) {
+        std::ostringstream os;
+        os << primary_.getTaskName() << '#' << index;
+        Controller& replica(*replicas_[index]);
+        Algorithm* algorithm = config_.maker ? config_.maker(replica) : 0;
+        if (!replica.openAndInit(primary_.getAlgorithmName(), os.str(), algorithm, threadFlags, threadPriority,
+                                 threaded)) {
+            LOGERROR << "failed to open replica " << os.str() << std::endl;
+            return false;
+        }
+    }
+
+    LOGINFO << primary_.getTaskName() << " opened " << replicas_.size() << " replicas" << std::endl;
+    return true;
+}
+
+void
+ReplicaSet::close()
+{
+    Logger::ProcLog log("close", Log());
+    LOGINFO << primary_.getTaskName() << std::endl;
+
+    for (size_t index = 0; index < replicas_.size(); ++index) replicas_[index]->close(1);
+    replicas_.clear();
+
+    while (!history_.empty()) {
+        history_.front()->release();
+        history_.pop_front();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    firstOrdinal_ += slots_.size();
+    slots_.clear();
+}
+
+size_t
+ReplicaSet::choose(const Messages::Header::Ref& msg) const
+{
+    Messages::PRIMessage::Ref pri(boost::dynamic_pointer_cast<Messages::PRIMessage>(msg));
+    if (!pri) return last_;
+
+    // Use the sequence counter instead of the order of arrival so that the messages for the same PRI on
+    // different input channels go to the same replica.
+    //
+    if (config_.sharding == ReplicaConfig::kRoundRobin) {
+        return (pri->getSequenceCounter() / config_.blockSize) % replicas_.size();
+    }
+
+    size_t sector = size_t(pri->getAzimuthStart() / Utils::kCircleRadians * config_.sectors) % config_.sectors;
+    return sector % replicas_.size();
+}
+
+bool
+ReplicaSet::dispatch(ACE_Message_Block* data)
+{
+    static Logger::ProcLog log("dispatch", Log());
+
+    IO::MessageManager mgr(data);
+    size_t index = choose(mgr.getNative());
+    LOGDEBUG << "replica: " << index << std::endl;
+
+    // When switching to another replica, first give it the recent history so that an algorithm that looks
+    // back at previous PRIs has what it needs for this one.
+    //
+    bool ok = true;
+    if (index != last_) {
+        for (auto pos = history_.begin(); pos != history_.end(); ++pos) ok = post(index, *pos, false) && ok;
+        last_ = index;
+    }
+
+    ok = post(index, data, true) && ok;
+
+    if (config_.overlap) {
+        history_.push_back(data->duplicate());
+        if (history_.size() > config_.overlap) {
+            history_.front()->release();
+            history_.pop_front();
+        }
+    }
+
+    return ok;
+}
+
+bool
+ReplicaSet::post(size_t index, ACE_Message_Block* data, bool keep)
+{
+    static Logger::ProcLog log("post", Log());
+
+    // Reserve a place in the reorder queue before the replica can see the message.
+    //
+    uint64_t ordinal;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_.push_back(Slot(keep));
+        ordinal = firstOrdinal_ + slots_.size() - 1;
+        posted_[index].push_back(ordinal);
+    }
+
+    ACE_Message_Block* dup = data->duplicate();
+    if (replicas_[index]->put(dup, 0) == -1) {
+        LOGERROR << "failed to give message to replica " << index << std::endl;
+        dup->release();
+        std::lock_guard<std::mutex> lock(mutex_);
+        posted_[index].pop_back();
+        getSlot(ordinal).done = true;
+        flush();
+        return false;
+    }
+
+    return true;
+}
+
+void
+ReplicaSet::broadcast(ACE_Message_Block* data)
+{
+    static Logger::ProcLog log("broadcast", Log());
+
+    // Timeout messages are only for the primary.
+    //
+    if (IO::MessageManager::GetControlMessageType(data) == IO::ControlMessage::kTimeout) return;
+
+    for (size_t index = 0; index < replicas_.size(); ++index) {
+        ACE_Message_Block* dup = data->duplicate();
+        if (replicas_[index]->put(dup, 0) == -1) {
+            LOGERROR << "failed to give control message to replica " << index << std::endl;
+            dup->release();
+        }
+    }
+}
+
+void
+ReplicaSet::begin(size_t index)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (posted_[index].empty()) {
+        current_[index] = kIdle;
+    } else {
+        current_[index] = posted_[index].front();
+        posted_[index].pop_front();
+    }
+}
+
+void
+ReplicaSet::end(size_t index)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t ordinal = current_[index];
+    current_[index] = kIdle;
+    if (ordinal != kIdle && ordinal >= firstOrdinal_) {
+        getSlot(ordinal).done = true;
+        flush();
+    }
+}
+
+bool
+ReplicaSet::collect(size_t index, const Messages::Header::Ref& msg, size_t channelIndex)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t ordinal = current_[index];
+
+    // Something emitted outside of message processing, such as from Algorithm::processAlarm(), has no place in
+    // the input order. Just send it out.
+    //
+    if (ordinal == kIdle || ordinal < firstOrdinal_) {
+        emit(msg, channelIndex);
+        return true;
+    }
+
+    Slot& slot(getSlot(ordinal));
+    if (slot.keep) slot.outputs.push_back(std::make_pair(msg, channelIndex));
+    return true;
+}
+
+void
+ReplicaSet::flush()
+{
+    while (!slots_.empty() && slots_.front().done) {
+        Slot& slot(slots_.front());
+        for (auto pos = slot.outputs.begin(); pos != slot.outputs.end(); ++pos) emit(pos->first, pos->second);
+        slots_.pop_front();
+        ++firstOrdinal_;
+    }
+}
+
+void
+ReplicaSet::emit(const Messages::Header::Ref& msg, size_t channelIndex)
+{
+    static Logger::ProcLog log("emit", Log());
+
+    // Each replica numbered its own outputs. Renumber them as one sequence.
+    //
+    while (channelIndex >= sequenceNumbers_.size()) sequenceNumbers_.push_back(0);
+    msg->setMessageSequenceNumber(++sequenceNumbers_[channelIndex]);
+    if (!primary_.send(msg, channelIndex)) LOGERROR << "failed to send output on channel " << channelIndex << std::endl;
+}
@@ -0,0 +1,237 @@
+#ifndef SIDECAR_ALGORITHMS_REPLICASET_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_REPLICASET_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "boost/shared_ptr.hpp"
+
+#include "Messages/Header.h"
+#include "Messages/MetaTypeInfo.h"
+#include "Utils/Utils.h"
+
+class ACE_Message_Block;
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace Algorithms {
+
+class Algorithm;
+class Controller;
+
+/** Configuration for a ReplicaSet, normally taken from the attributes of an <algorithm> element in a stream
+    XML configuration file.
+*/
+struct ReplicaConfig {
+    /** How the dispatcher chooses the replica for a PRI.
+     */
+    enum Sharding {
+        kRoundRobin, ///< Runs of blockSize PRIs by sequence counter
+        kAzimuth     ///< Azimuth sector of the PRI
+    };
+
+    /** Factory for the Algorithm object of a replica. Only used by unit tests; otherwise, each replica loads
+        the algorithm DLL just like its primary Controller does.
+    */
+    using Maker = std::function<Algorithm*(Controller&)>;
+
+    ReplicaConfig() : count(1), sharding(kRoundRobin), blockSize(1), sectors(0), overlap(0), maker() {}
+
+    size_t count;      ///< Number of replicas to run. No replicas if less than 2
+    Sharding sharding; ///< How to choose a replica for a PRI
+    size_t blockSize;  ///< Number of consecutive PRIs given to a replica in kRoundRobin mode
+    size_t sectors;    ///< Number of azimuth sectors in kAzimuth mode. If zero, use count
+    size_t overlap;    ///< Number of preceding PRIs to give a replica when it starts a new run of PRIs
+    Maker maker;       ///< If set, creates the replica algorithms
+};
+
+/** Data-parallel replicas of an algorithm. The primary Controller of an algorithm whose processing of a PRI does
+    not depend on the PRIs before it (see Algorithm::isReplicaSafe()) may hand its data messages to a ReplicaSet
+    instead of to its own algorithm. The ReplicaSet runs several child Controllers, each with its own copy of the
+    algorithm and its own thread, and gives each PRI to one of them, either in runs of consecutive PRIs
+    (ReplicaConfig::kRoundRobin) or by azimuth sector (ReplicaConfig::kAzimuth). Control messages go to every
+    replica, so they all see the same parameter values and processing state changes.
+
+    Replicas finish their PRIs out of order. The ReplicaSet holds on to what a replica emits for a PRI until the
+    replicas are done with all of the PRIs dispatched before it, and then sends it out through the primary
+    Controller with a new message sequence number, so that downstream tasks see the outputs in the order of the
+    inputs, exactly as if there were only one copy of the algorithm.
+
+    An algorithm that looks at a few PRIs before the current one, such as Despeckle, is still replica-safe if the
+    ReplicaConfig::overlap value covers that history: whenever a replica starts a new run of PRIs, the dispatcher
+    first gives it the last \c overlap PRIs of the previous run, and drops whatever the replica emits for them.
+*/
+class ReplicaSet : public Utils::Uncopyable {
+public:
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Constructor. Creates the replica Controllers, with the same channels and XML configuration as the
+        primary. Does not load their algorithms; that happens in open().
+
+        \param primary the Controller that owns the replicas
+
+        \param config replica configuration
+    */
+    ReplicaSet(Controller& primary, const ReplicaConfig& config);
+
+    /** Destructor. Closes the replicas if still open.
+     */
+    ~ReplicaSet();
+
+    /** Load and start the algorithm of each replica. Arguments are as for Controller::openAndInit().
+
+        \return true if successful
+    */
+    bool open(long threadFlags, long threadPriority, bool threaded);
+
+    /** Stop the replicas. Outputs still waiting for earlier PRIs are dropped.
+     */
+    void close();
+
+    /** \return number of replicas
+     */
+    size_t getCount() const { return replicas_.size(); }
+
+    /** Give a data message to one of the replicas. Only called from the processing thread of the primary
+        Controller.
+
+        \param data the message to process. Takes ownership of it.
+
+        \return true if successful
+    */
+    bool dispatch(ACE_Message_Block* data);
+
+    /** Give a control message to all of the replicas. Does not take ownership of the message.
+
+        \param data the control message to give
+    */
+    void broadcast(ACE_Message_Block* data);
+
+    /** Marks the processing of a dispatched message by a replica. Created by the replica Controller around its
+        call to the algorithm, so that the ReplicaSet knows which input the outputs of the replica belong to.
+    */
+    class Scope {
+    public:
+        Scope(ReplicaSet* replicaSet, size_t index) : replicaSet_(replicaSet), index_(index)
+        {
+            if (replicaSet_) replicaSet_->begin(index_);
+        }
+
+        ~Scope()
+        {
+            if (replicaSet_) replicaSet_->end(index_);
+        }
+
+    private:
+        ReplicaSet* replicaSet_;
+        size_t index_;
+    };
+
+    /** Accept a message emitted by the algorithm of a replica. Called by the replica Controller in place of
+        sending the message down the stream.
+
+        \param index the index of the replica
+
+        \param msg the emitted message
+
+        \param channelIndex the output channel of the message
+
+        \return true if successful
+    */
+    bool collect(size_t index, const Messages::Header::Ref& msg, size_t channelIndex);
+
+private:
+    /** A dispatched message, and what the replica emitted while processing it.
+     */
+    struct Slot {
+        Slot(bool keep) : keep(keep), done(false), outputs() {}
+        bool keep;
+        bool done;
+        std::vector<std::pair<Messages::Header::Ref, size_t>> outputs;
+    };
+
+    /** Ordinal given to a replica that is not processing a dispatched message.
+     */
+    static const uint64_t kIdle = 0;
+
+    /** Choose the replica for a message.
+
+        \param msg the message to look at
+
+        \return replica index
+    */
+    size_t choose(const Messages::Header::Ref& msg) const;
+
+    /** Add a message to the end of the reorder queue and hand it to a replica.
+
+        \param index the index of the replica
+
+        \param data the message to give. Does not take ownership of it.
+
+        \param keep false if the outputs for the message are to be dropped
+
+        \return true if successful
+    */
+    bool post(size_t index, ACE_Message_Block* data, bool keep);
+
+    /** Note that a replica is starting on the next message given to it.
+
+        \param index the index of the replica
+    */
+    void begin(size_t index);
+
+    /** Note that a replica is done with its current message, and send out any outputs that are now in order.
+
+        \param index the index of the replica
+    */
+    void end(size_t index);
+
+    /** Send out the outputs of all finished messages at the front of the reorder queue. Must be called with
+        mutex_ held.
+    */
+    void flush();
+
+    /** Send out a message through the primary Controller. Must be called with mutex_ held.
+
+        \param msg the message to send
+
+        \param channelIndex the output channel of the message
+    */
+    void emit(const Messages::Header::Ref& msg, size_t channelIndex);
+
+    Slot& getSlot(uint64_t ordinal) { return slots_[ordinal - firstOrdinal_]; }
+
+    Controller& primary_;
+    ReplicaConfig config_;
+    std::vector<boost::shared_ptr<Controller>> replicas_;
+    std::deque<ACE_Message_Block*> history_; ///< Last overlap messages dispatched
+    size_t last_;                            ///< Replica that was given the last message
+
+    std::mutex mutex_;                         ///< Guards the members below
+    std::deque<Slot> slots_;                   ///< Reorder queue of dispatched messages
+    uint64_t firstOrdinal_;                    ///< Ordinal of the Slot at the front of slots_
+    std::vector<std::deque<uint64_t>> posted_; ///< Ordinals of the messages waiting for each replica
+    std::vector<uint64_t> current_;            ///< Ordinal of the message each replica is processing
+
+    /** Last message sequence number sent on each output channel
+     */
+    std::vector<Messages::MetaTypeInfo::SequenceType> sequenceNumbers_;
+};
+
+} // end namespace Algorithms
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
@@ -0,0 +1,300 @@
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "IO/MessageManager.h"
+#include "IO/ProcessingStateChangeRequest.h"
+#include "IO/Stream.h"
+#include "Logger/Log.h"
+#include "Messages/RadarConfig.h"
+#include "Messages/Video.h"
+#include "UnitTest/UnitTest.h"
+
+#include "Algorithm.h"
+#include "Controller.h"
+#include "ReplicaSet.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms;
+using namespace SideCar::Messages;
+
+/** Replica-safe algorithm that emits a copy of each PRI. Takes longer on some PRIs than on others so that the
+    replicas finish out of order. Remembers which replica processed each PRI.
+*/
+class Copy : public Algorithm {
+public:
+    static std::mutex mutex_;
+    static std::map<uint32_t, std::string> processedBy_;
+
+    Copy(Controller& controller, Logger::Log& log) : Algorithm(controller, log) {}
+
+    bool startup()
+    {
+        registerProcessor<Copy, Video>("input", &Copy::process);
+        return Algorithm::startup();
+    }
+
+    bool isReplicaSafe() const { return true; }
+
+    bool process(const Video::Ref& msg)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            processedBy_[msg->getSequenceCounter()] = getController().getTaskName();
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(msg->getSequenceCounter() % 3));
+        Video::Ref out(Video::Make(getName(), msg));
+        out->getData() = msg->getData();
+        return send(out);
+    }
+};
+
+std::mutex Copy::mutex_;
+std::map<uint32_t, std::string> Copy::processedBy_;
+
+/** Replica-safe algorithm that emits a copy of the previous PRI, so it needs an overlap of one.
+ */
+class Lag : public Algorithm {
+public:
+    Lag(Controller& controller, Logger::Log& log) : Algorithm(controller, log), last_() {}
+
+    bool startup()
+    {
+        registerProcessor<Lag, Video>("input", &Lag::process);
+        return Algorithm::startup();
+    }
+
+    bool isReplicaSafe() const { return true; }
+
+    bool process(const Video::Ref& msg)
+    {
+        bool ok = true;
+        if (last_) {
+            Video::Ref out(Video::Make(getName(), last_));
+            out->getData() = last_->getData();
+            ok = send(out);
+        }
+
+        last_ = msg;
+        return ok;
+    }
+
+    Video::Ref last_;
+};
+
+/** Task that collects the Video messages it receives.
+ */
+struct Sink : public IO::Task {
+    using Ref = boost::shared_ptr<Sink>;
+
+    static Ref Make()
+    {
+        Ref ref(new Sink);
+        return ref;
+    }
+
+    Sink() : Task(true), mutex_(), msgs_() {}
+
+    bool deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout)
+    {
+        IO::MessageManager mgr(data);
+        if (mgr.hasNative() && mgr.getNativeMessageType() == MetaTypeInfo::Value::kVideo) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            msgs_.push_back(mgr.getNative<Video>());
+        }
+
+        return true;
+    }
+
+    /** Wait for messages to arrive.
+
+        \param count number of messages to wait for
+
+        \return messages received
+    */
+    std::vector<Video::Ref> wait(size_t count)
+    {
+        for (int tries = 0; tries < 500; ++tries) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (msgs_.size() >= count) break;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        // Give any extra messages a chance to show up.
+        //
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::lock_guard<std::mutex> lock(mutex_);
+        return msgs_;
+    }
+
+    std::mutex mutex_;
+    std::vector<Video::Ref> msgs_;
+};
+
+class ReplicaSetTest : public UnitTest::TestObj {
+public:
+    ReplicaSetTest() : TestObj("ReplicaSet") {}
+
+    void test();
+
+    /** Make a PRI with one sample holding its sequence counter.
+     */
+    static Video::Ref MakeVideo(uint32_t sequence, double azimuth);
+
+    /** Run PRIs through a replicated algorithm.
+
+        \param config replica configuration, including the algorithm maker
+
+        \param inputs the PRIs to process
+
+        \param expected number of outputs to wait for
+
+        \return outputs received
+    */
+    std::vector<Video::Ref> run(const ReplicaConfig& config, const std::vector<Video::Ref>& inputs, size_t expected);
+
+    void testOrder();
+
+    void testOverlap();
+
+    void testAzimuth();
+};
+
+Video::Ref
+ReplicaSetTest::MakeVideo(uint32_t sequence, double azimuth)
+{
+    VMEDataMessage vme;
+    vme.header.msgDesc = (VMEHeader::kPackedReal << 16) | VMEHeader::kAzimuthValidMask | VMEHeader::kPRIValidMask;
+    vme.header.timeStamp = 0;
+    vme.header.azimuth = uint32_t(::rint(azimuth / (M_PI * 2.0) * (RadarConfig::GetShaftEncodingMax() + 1)));
+    vme.header.pri = sequence;
+    vme.header.irigTime = 0.0;
+
+    Video::Ref msg(Video::Make("test", vme, 1));
+    msg->push_back(sequence);
+    return msg;
+}
+
+std::vector<Video::Ref>
+ReplicaSetTest::run(const ReplicaConfig& config, const std::vector<Video::Ref>& inputs, size_t expected)
+{
+    IO::Stream::Ref stream(IO::Stream::Make("ReplicaSetTest"));
+    auto sinkModule = new IO::TModule<Sink>(stream);
+    assertEqual(0, stream->push(sinkModule));
+    Sink::Ref sink = sinkModule->getTask();
+    sink->setTaskName("Sink");
+    sink->setTaskIndex(1);
+    sink->addInputChannel(IO::Channel("input", "Video"));
+
+    ControllerModule* module = new ControllerModule(stream);
+    assertEqual(0, stream->push(module));
+    Controller::Ref controller = module->getTask();
+    controller->setTaskIndex(0);
+    controller->addInputChannel(IO::Channel("input", "Video"));
+    controller->addOutputChannel(IO::Channel("output", "Video", sink));
+    controller->setReplicas(config);
+
+    assertTrue(controller->openAndInit("test", "test", config.maker(*controller)));
+    assertTrue(controller->injectProcessingStateChange(IO::ProcessingState::kRun));
+    for (size_t index = 0; index < inputs.size(); ++index) assertTrue(controller->putInChannel(inputs[index], 0));
+
+    std::vector<Video::Ref> outputs(sink->wait(expected));
+    controller->close(1);
+    return outputs;
+}
+
+void
+ReplicaSetTest::testOrder()
+{
+    ReplicaConfig config;
+    config.count = 3;
+    config.blockSize = 4;
+    config.maker = [](Controller& controller) { return new Copy(controller, Logger::Log::Root()); };
+
+    std::vector<Video::Ref> inputs;
+    for (uint32_t index = 0; index < 40; ++index) inputs.push_back(MakeVideo(index, 0.0));
+
+    // Outputs come out in input order, numbered as one sequence.
+    //
+    std::vector<Video::Ref> outputs(run(config, inputs, inputs.size()));
+    assertEqual(inputs.size(), outputs.size());
+    for (size_t index = 0; index < outputs.size(); ++index) {
+        assertEqual(uint32_t(index), outputs[index]->getSequenceCounter());
+        assertEqual(int16_t(index), outputs[index][0]);
+        assertEqual(uint32_t(index + 1), outputs[index]->getMessageSequenceNumber());
+    }
+
+    // Runs of 4 PRIs go to each replica in turn.
+    //
+    assertEqual(std::string("test#0"), Copy::processedBy_[0]);
+    assertEqual(std::string("test#0"), Copy::processedBy_[3]);
+    assertEqual(std::string("test#1"), Copy::processedBy_[4]);
+    assertEqual(std::string("test#2"), Copy::processedBy_[8]);
+    assertEqual(std::string("test#0"), Copy::processedBy_[12]);
+}
+
+void
+ReplicaSetTest::testOverlap()
+{
+    ReplicaConfig config;
+    config.count = 2;
+    config.blockSize = 5;
+    config.overlap = 1;
+    config.maker = [](Controller& controller) { return new Lag(controller, Logger::Log::Root()); };
+
+    std::vector<Video::Ref> inputs;
+    for (uint32_t index = 0; index < 30; ++index) inputs.push_back(MakeVideo(index, 0.0));
+
+    // Every PRI but the last comes out exactly once, and nothing emitted while a replica was being primed shows
+    // up.
+    //
+    std::vector<Video::Ref> outputs(run(config, inputs, inputs.size() - 1));
+    assertEqual(inputs.size() - 1, outputs.size());
+    for (size_t index = 0; index < outputs.size(); ++index) {
+        assertEqual(int16_t(index), outputs[index][0]);
+    }
+}
+
+void
+ReplicaSetTest::testAzimuth()
+{
+    ReplicaConfig config;
+    config.count = 2;
+    config.sharding = ReplicaConfig::kAzimuth;
+    config.sectors = 4;
+    config.maker = [](Controller& controller) { return new Copy(controller, Logger::Log::Root()); };
+
+    // Sectors 0 and 2 go to the first replica, sectors 1 and 3 to the second.
+    //
+    std::vector<Video::Ref> inputs;
+    for (uint32_t index = 0; index < 16; ++index) inputs.push_back(MakeVideo(100 + index, index * M_PI / 8.0 + 0.01));
+
+    std::vector<Video::Ref> outputs(run(config, inputs, inputs.size()));
+    assertEqual(inputs.size(), outputs.size());
+    for (uint32_t index = 0; index < 16; ++index) {
+        assertEqual(uint32_t(100 + index), outputs[index]->getSequenceCounter());
+        std::string replica((index / 4) % 2 ? "test#1" : "test#0");
+        assertEqual(replica, Copy::processedBy_[100 + index]);
+    }
+}
+
+void
+ReplicaSetTest::test()
+{
+    Logger::Log::Root().setPriorityLimit(Logger::Priority::kError);
+    testOrder();
+    testOverlap();
+    testAzimuth();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return ReplicaSetTest().mainRun();
+}
@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cstring>
+
+#include "RunningSums.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SIDECAR_RUNNINGSUMS_AVX2 1
+#endif
+
+using namespace SideCar::Algorithms;
+
+namespace {
+
+/** Number of sums in 32 bytes. Rows are padded to a multiple of this.
+ */
+const size_t kRowAlignment = 8;
+
+size_t
+Stride(size_t cols)
+{
+    return (cols + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+}
+
+} // namespace
+
+RunningSums::RunningSums(Path path) : path_(path), rows_(0), cols_(0), stride_(0), sums_()
+{
+    if (path_ == kAuto || (path_ == kAVX2 && !HasAVX2())) path_ = HasAVX2() ? kAVX2 : kScalar;
+}
+
+bool
+RunningSums::HasAVX2()
+{
+#ifdef SIDECAR_RUNNINGSUMS_AVX2
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    return hasAVX2;
+#else
+    return false;
+#endif
+}
+
+void
+RunningSums::reset(size_t rows, size_t cols)
+{
+    rows_ = rows;
+    cols_ = cols;
+    stride_ = Stride(cols);
+    sums_.resize(rows_ * stride_);
+    clear();
+}
+
+void
+RunningSums::resize(size_t cols)
+{
+    size_t stride = Stride(cols);
+    if (stride == stride_) {
+        // Zero any columns that were dropped earlier and now come back into use.
+        //
+        for (size_t row = 0; row < rows_; ++row) {
+            SumType* sums = getMutableRow(row);
+            std::fill(sums + std::min(cols_, cols), sums + stride_, 0);
+        }
+    } else {
+        std::vector<SumType> sums(rows_ * stride, 0);
+        size_t keep = std::min(cols_, cols);
+        for (size_t row = 0; row < rows_; ++row) {
+            const SumType* from = getRow(row);
+            std::copy(from, from + keep, &sums[row * stride]);
+        }
+
+        sums_.swap(sums);
+        stride_ = stride;
+    }
+
+    cols_ = cols;
+}
+
+void
+RunningSums::clear()
+{
+    if (!sums_.empty()) ::memset(&sums_[0], 0, sums_.size() * sizeof(SumType));
+}
+
+void
+RunningSums::add(size_t row, const DatumType* values, size_t count)
+{
+#ifdef SIDECAR_RUNNINGSUMS_AVX2
+    if (path_ == kAVX2) {
+        AddAVX2(getMutableRow(row), values, count);
+        return;
+    }
+#endif
+    AddScalar(getMutableRow(row), values, 0, count);
+}
+
+void
+RunningSums::subtract(size_t row, const DatumType* values, size_t count)
+{
+#ifdef SIDECAR_RUNNINGSUMS_AVX2
+    if (path_ == kAVX2) {
+        SubtractAVX2(getMutableRow(row), values, count);
+        return;
+    }
+#endif
+    SubtractScalar(getMutableRow(row), values, 0, count);
+}
+
+void
+RunningSums::update(size_t row, const DatumType* added, const DatumType* removed, size_t count)
+{
+#ifdef SIDECAR_RUNNINGSUMS_AVX2
+    if (path_ == kAVX2) {
+        UpdateAVX2(getMutableRow(row), added, removed, count);
+        return;
+    }
+#endif
+    UpdateScalar(getMutableRow(row), added, removed, 0, count);
+}
+
+void
+RunningSums::addPower(size_t row, const DatumType* iq, size_t count)
+{
+#ifdef SIDECAR_RUNNINGSUMS_AVX2
+    if (path_ == kAVX2) {
+        AddPowerAVX2(getMutableRow(row), iq, count);
+        return;
+    }
+#endif
+    AddPowerScalar(getMutableRow(row), iq, 0, count);
+}
+
+void
+RunningSums::subtractPower(size_t row, const DatumType* iq, size_t count)
+{
+#ifdef SIDECAR_RUNNINGSUMS_AVX2
+    if (path_ == kAVX2) {
+        SubtractPowerAVX2(getMutableRow(row), iq, count);
+        return;
+    }
+#endif
+    SubtractPowerScalar(getMutableRow(row), iq, 0, count);
+}
+
+void
+RunningSums::average(size_t row, int32_t divisor, size_t count, DatumType* out) const
+{
+#ifdef SIDECAR_RUNNINGSUMS_AVX2
+    if (path_ == kAVX2) {
+        AverageAVX2(getRow(row), divisor, count, out);
+        return;
+    }
+#endif
+    AverageScalar(getRow(row), divisor, 0, count, out);
+}
+
+void
+RunningSums::AddScalar(SumType* sums, const DatumType* values, size_t begin, size_t end)
+{
+    for (size_t index = begin; index < end; ++index) sums[index] += values[index];
+}
+
+void
+RunningSums::SubtractScalar(SumType* sums, const DatumType* values, size_t begin, size_t end)
+{
+    for (size_t index = begin; index < end; ++index) sums[index] -= values[index];
+}
+
+void
+RunningSums::UpdateScalar(SumType* sums, const DatumType* added, const DatumType* removed, size_t begin, size_t end)
+{
+    for (size_t index = begin; index < end; ++index) sums[index] += added[index] - removed[index];
+}
+
+// The powers are summed as unsigned values so that the one case that overflows wraps around the same way that
+// the AVX2 multiply-add does.
+//
+void
+RunningSums::AddPowerScalar(SumType* sums, const DatumType* iq, size_t begin, size_t end)
+{
+    for (size_t index = begin; index < end; ++index) {
+        int32_t i = iq[2 * index];
+        int32_t q = iq[2 * index + 1];
+        sums[index] = SumType(uint32_t(sums[index]) + uint32_t(i * i) + uint32_t(q * q));
+    }
+}
+
+void
+RunningSums::SubtractPowerScalar(SumType* sums, const DatumType* iq, size_t begin, size_t end)
+{
+    for (size_t index = begin; index < end; ++index) {
+        int32_t i = iq[2 * index];
+        int32_t q = iq[2 * index + 1];
+        sums[index] = SumType(uint32_t(sums[index]) - (uint32_t(i * i) + uint32_t(q * q)));
+    }
+}
+
+void
+RunningSums::AverageScalar(const SumType* sums, int32_t divisor, size_t begin, size_t end, DatumType* out)
+{
+    int32_t half = divisor / 2;
+    for (size_t index = begin; index < end; ++index) out[index] = DatumType((sums[index] + half) / divisor);
+}
+
+#ifdef SIDECAR_RUNNINGSUMS_AVX2
+
+__attribute__((target("avx2"))) void
+RunningSums::AddAVX2(SumType* sums, const DatumType* values, size_t count)
+{
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + index)));
+        __m256i* s = reinterpret_cast<__m256i*>(sums + index);
+        _mm256_storeu_si256(s, _mm256_add_epi32(_mm256_loadu_si256(s), v));
+    }
+
+    AddScalar(sums, values, index, count);
+}
+
+__attribute__((target("avx2"))) void
+RunningSums::SubtractAVX2(SumType* sums, const DatumType* values, size_t count)
+{
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + index)));
+        __m256i* s = reinterpret_cast<__m256i*>(sums + index);
+        _mm256_storeu_si256(s, _mm256_sub_epi32(_mm256_loadu_si256(s), v));
+    }
+
+    SubtractScalar(sums, values, index, count);
+}
+
+__attribute__((target("avx2"))) void
+RunningSums::UpdateAVX2(SumType* sums, const DatumType* added, const DatumType* removed, size_t count)
+{
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+        __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(added + index)));
+        __m256i r = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(removed + index)));
+        __m256i* s = reinterpret_cast<__m256i*>(sums + index);
+        _mm256_storeu_si256(s, _mm256_add_epi32(_mm256_loadu_si256(s), _mm256_sub_epi32(a, r)));
+    }
+
+    UpdateScalar(sums, added, removed, index, count);
+}
+
+// The multiply-add instruction forms I * I + Q * Q for eight I/Q pairs at once, giving the powers in the order
+// of the pairs.
+//
+__attribute__((target("avx2"))) void
+RunningSums::AddPowerAVX2(SumType* sums, const DatumType* iq, size_t count)
+{
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(iq + 2 * index));
+        __m256i* s = reinterpret_cast<__m256i*>(sums + index);
+        _mm256_storeu_si256(s, _mm256_add_epi32(_mm256_loadu_si256(s), _mm256_madd_epi16(v, v)));
+    }
+
+    AddPowerScalar(sums, iq, index, count);
+}
+
+__attribute__((target("avx2"))) void
+RunningSums::SubtractPowerAVX2(SumType* sums, const DatumType* iq, size_t count)
+{
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(iq + 2 * index));
+        __m256i* s = reinterpret_cast<__m256i*>(sums + index);
+        _mm256_storeu_si256(s, _mm256_sub_epi32(_mm256_loadu_si256(s), _mm256_madd_epi16(v, v)));
+    }
+
+    SubtractPowerScalar(sums, iq, index, count);
+}
+
+// There is no integer divide instruction, so divide in double precision and truncate. For 32-bit operands the
+// rounding error of the quotient is smaller than its distance to the next integer, so this matches integer
+// division exactly. The results keep the low 16 bits of each quotient like the scalar cast does, rather than
+// saturating.
+//
+__attribute__((target("avx2"))) void
+RunningSums::AverageAVX2(const SumType* sums, int32_t divisor, size_t count, DatumType* out)
+{
+    const __m256i half = _mm256_set1_epi32(divisor / 2);
+    const __m256d divisors = _mm256_set1_pd(divisor);
+    const __m256i lowBits = _mm256_set1_epi32(0xFFFF);
+    size_t index = 0;
+    for (; index + 16 <= count; index += 16) {
+        __m256i quotients[2];
+        for (int part = 0; part < 2; ++part) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + index + 8 * part));
+            v = _mm256_add_epi32(v, half);
+            __m128i lo = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), divisors));
+            __m128i hi =
+                _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), divisors));
+            quotients[part] = _mm256_and_si256(_mm256_set_m128i(hi, lo), lowBits);
+        }
+
+        // The pack works within 128-bit lanes, so put the 64-bit groups back in order afterwards.
+        //
+        __m256i packed = _mm256_packus_epi32(quotients[0], quotients[1]);
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + index), packed);
+    }
+
+    AverageScalar(sums, divisor, index, count, out);
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef SIDECAR_ALGORITHMS_RUNNINGSUMS_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_RUNNINGSUMS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SideCar {
+namespace Algorithms {
+
+/** Running sums of 16-bit sample values for the integrating algorithms (NCIntegrate and CPIIntegrate). Holds a
+    rows x columns block of 32-bit sums in one contiguous allocation, with each row padded to a multiple of eight
+    sums. Samples are widened to 32 bits as they are added or subtracted, so the sums are exact as long as they
+    fit in 32 bits.
+
+    The update routines work on a prefix of a row; columns beyond the given count are left alone. They use AVX2 to
+    work on eight or sixteen samples at a time when the processor supports it, and plain loops otherwise. Both
+    paths give identical results.
+*/
+class RunningSums {
+public:
+    using SumType = int32_t;
+    using DatumType = int16_t;
+
+    enum Path { kAuto, kScalar, kAVX2 };
+
+    /** Constructor.
+
+        \param path implementation to use. kAuto picks kAVX2 if the processor supports it.
+    */
+    RunningSums(Path path = kAuto);
+
+    /** \return the implementation in use
+     */
+    Path getPath() const { return path_; }
+
+    /** \return true if the processor (and compiler) support the AVX2 path
+     */
+    static bool HasAVX2();
+
+    /** Set the shape of the sums and zero them. Storage is only reallocated if it grows.
+
+        \param rows number of rows
+
+        \param cols number of columns
+    */
+    void reset(size_t rows, size_t cols);
+
+    /** Change the number of columns, keeping the existing sums. New columns start at zero.
+
+        \param cols new number of columns
+    */
+    void resize(size_t cols);
+
+    /** Set all sums to zero.
+     */
+    void clear();
+
+    /** \return number of rows
+     */
+    size_t getRows() const { return rows_; }
+
+    /** \return number of columns
+     */
+    size_t getCols() const { return cols_; }
+
+    /** \return pointer to the first sum of a row
+     */
+    const SumType* getRow(size_t row) const { return sums_.data() + row * stride_; }
+
+    /** Add samples to a row: sums[i] += values[i]
+
+        \param row row to update
+
+        \param values samples to add
+
+        \param count number of samples, no more than getCols()
+    */
+    void add(size_t row, const DatumType* values, size_t count);
+
+    /** Subtract samples from a row: sums[i] -= values[i]
+
+        \param row row to update
+
+        \param values samples to subtract
+
+        \param count number of samples, no more than getCols()
+    */
+    void subtract(size_t row, const DatumType* values, size_t count);
+
+    /** Add one set of samples to a row and subtract another in one pass: sums[i] += added[i] - removed[i]
+
+        \param row row to update
+
+        \param added samples to add
+
+        \param removed samples to subtract
+
+        \param count number of samples, no more than getCols()
+    */
+    void update(size_t row, const DatumType* added, const DatumType* removed, size_t count);
+
+    /** Add the powers of interleaved I/Q samples to a row: sums[i] += I[i]^2 + Q[i]^2. As with 32-bit integer
+        arithmetic, a power of 2^31 (both I and Q at -32768) wraps around.
+
+        \param row row to update
+
+        \param iq interleaved I/Q samples
+
+        \param count number of I/Q pairs, no more than getCols()
+    */
+    void addPower(size_t row, const DatumType* iq, size_t count);
+
+    /** Subtract the powers of interleaved I/Q samples from a row: sums[i] -= I[i]^2 + Q[i]^2.
+
+        \param row row to update
+
+        \param iq interleaved I/Q samples
+
+        \param count number of I/Q pairs, no more than getCols()
+    */
+    void subtractPower(size_t row, const DatumType* iq, size_t count);
+
+    /** Calculate rounded averages of the first count sums of a row: out[i] = DatumType((sums[i] + divisor / 2) /
+        divisor), using C++ integer division (which truncates towards zero).
+
+        \param row row to use
+
+        \param divisor number of values in each sum
+
+        \param count number of averages to calculate, no more than getCols()
+
+        \param out storage for count averages
+    */
+    void average(size_t row, int32_t divisor, size_t count, DatumType* out) const;
+
+private:
+    SumType* getMutableRow(size_t row) { return sums_.data() + row * stride_; }
+
+    static void AddScalar(SumType* sums, const DatumType* values, size_t begin, size_t end);
+    static void SubtractScalar(SumType* sums, const DatumType* values, size_t begin, size_t end);
+    static void UpdateScalar(SumType* sums, const DatumType* added, const DatumType* removed, size_t begin,
+                             size_t end);
+    static void AddPowerScalar(SumType* sums, const DatumType* iq, size_t begin, size_t end);
+    static void SubtractPowerScalar(SumType* sums, const DatumType* iq, size_t begin, size_t end);
+    static void AverageScalar(const SumType* sums, int32_t divisor, size_t begin, size_t end, DatumType* out);
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    static void AddAVX2(SumType* sums, const DatumType* values, size_t count);
+    static void SubtractAVX2(SumType* sums, const DatumType* values, size_t count);
+    static void UpdateAVX2(SumType* sums, const DatumType* added, const DatumType* removed, size_t count);
+    static void AddPowerAVX2(SumType* sums, const DatumType* iq, size_t count);
+    static void SubtractPowerAVX2(SumType* sums, const DatumType* iq, size_t count);
+    static void AverageAVX2(const SumType* sums, int32_t divisor, size_t count, DatumType* out);
+#endif
+
+    Path path_;
+    size_t rows_;
+    size_t cols_;
+    size_t stride_;
+    std::vector<SumType> sums_;
+};
+
+} // end namespace Algorithms
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
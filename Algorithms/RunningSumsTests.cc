@@ -0,0 +1,200 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "RunningSums.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms;
+
+using DatumType = RunningSums::DatumType;
+using SumType = RunningSums::SumType;
+
+class RunningSumsTest : public UnitTest::TestObj {
+public:
+    RunningSumsTest() : TestObj("RunningSums") {}
+
+    void test();
+
+    static void MakeSamples(std::vector<DatumType>& samples, size_t count);
+
+    void testShape();
+
+    /** Run the same updates through a RunningSums object and plain integer arithmetic, and compare.
+     */
+    void compare(RunningSums::Path path, size_t cols);
+
+    void benchmark(RunningSums::Path path);
+};
+
+void
+RunningSumsTest::MakeSamples(std::vector<DatumType>& samples, size_t count)
+{
+    // Include the extreme values, which are the ones most likely to trip up the widening and packing.
+    //
+    static const DatumType kExtremes[] = {-32768, 32767, -32768, -32768, -1, 0, 1, 32767};
+    samples.resize(count);
+    for (size_t index = 0; index < count; ++index) {
+        samples[index] = ::rand() % 8 == 0 ? kExtremes[::rand() % 8] : DatumType(::rand() % 65536 - 32768);
+    }
+}
+
+void
+RunningSumsTest::testShape()
+{
+    RunningSums sums;
+    sums.reset(3, 10);
+    assertEqual(size_t(3), sums.getRows());
+    assertEqual(size_t(10), sums.getCols());
+
+    std::vector<DatumType> values(10, 5);
+    sums.add(1, &values[0], 10);
+    assertEqual(5, sums.getRow(1)[9]);
+    assertEqual(0, sums.getRow(0)[9]);
+    assertEqual(0, sums.getRow(2)[0]);
+
+    // Growing keeps the sums and zeros the new columns, whether or not the row storage moves.
+    //
+    sums.resize(12);
+    assertEqual(5, sums.getRow(1)[9]);
+    assertEqual(0, sums.getRow(1)[10]);
+    sums.resize(100);
+    assertEqual(5, sums.getRow(1)[0]);
+    assertEqual(5, sums.getRow(1)[9]);
+    assertEqual(0, sums.getRow(1)[10]);
+    assertEqual(0, sums.getRow(2)[99]);
+
+    // Shrinking drops columns, and they come back as zeros.
+    //
+    sums.resize(4);
+    sums.resize(10);
+    assertEqual(5, sums.getRow(1)[3]);
+    assertEqual(0, sums.getRow(1)[4]);
+
+    sums.clear();
+    assertEqual(0, sums.getRow(1)[0]);
+}
+
+void
+RunningSumsTest::compare(RunningSums::Path path, size_t cols)
+{
+    enum { kRows = 3, kPasses = 20 };
+    RunningSums sums(path);
+    sums.reset(kRows, cols);
+    std::vector<std::vector<SumType>> expected(kRows, std::vector<SumType>(cols, 0));
+    std::vector<DatumType> added, removed;
+
+    for (int pass = 0; pass < kPasses; ++pass) {
+        // Keep the powers, which can wrap around, in their own row.
+        //
+        size_t row = pass % 5 < 3 ? pass % 2 : 2;
+        std::vector<SumType>& sum(expected[row]);
+        MakeSamples(added, 2 * cols);
+        MakeSamples(removed, 2 * cols);
+        switch (pass % 5) {
+        case 0:
+            sums.add(row, &added[0], cols);
+            for (size_t index = 0; index < cols; ++index) sum[index] += added[index];
+            break;
+        case 1:
+            sums.subtract(row, &removed[0], cols);
+            for (size_t index = 0; index < cols; ++index) sum[index] -= removed[index];
+            break;
+        case 2:
+            sums.update(row, &added[0], &removed[0], cols);
+            for (size_t index = 0; index < cols; ++index) sum[index] += added[index] - removed[index];
+            break;
+        case 3:
+            sums.addPower(row, &added[0], cols);
+            for (size_t index = 0; index < cols; ++index) {
+                int64_t i = added[2 * index];
+                int64_t q = added[2 * index + 1];
+                sum[index] = SumType(uint32_t(int64_t(sum[index]) + i * i + q * q));
+            }
+            break;
+        case 4:
+            sums.subtractPower(row, &removed[0], cols);
+            for (size_t index = 0; index < cols; ++index) {
+                int64_t i = removed[2 * index];
+                int64_t q = removed[2 * index + 1];
+                sum[index] = SumType(uint32_t(int64_t(sum[index]) - i * i - q * q));
+            }
+            break;
+        }
+
+        for (size_t index = 0; index < cols; ++index) assertEqual(sum[index], sums.getRow(row)[index]);
+    }
+
+    // Averages of sums of a few samples, which fit in a DatumType, including negative values that round
+    // towards zero.
+    //
+    for (int32_t divisor = 1; divisor < 8; ++divisor) {
+        sums.clear();
+        std::fill(expected[0].begin(), expected[0].end(), 0);
+        for (int32_t count = 0; count < divisor; ++count) {
+            MakeSamples(added, cols);
+            sums.add(0, &added[0], cols);
+            for (size_t index = 0; index < cols; ++index) expected[0][index] += added[index];
+        }
+
+        std::vector<DatumType> out(cols);
+        sums.average(0, divisor, cols, &out[0]);
+        for (size_t index = 0; index < cols; ++index) {
+            assertEqual(DatumType((expected[0][index] + divisor / 2) / divisor), out[index]);
+        }
+    }
+}
+
+void
+RunningSumsTest::benchmark(RunningSums::Path path)
+{
+    enum { kCols = 4096, kReps = 10000 };
+    RunningSums sums(path);
+    sums.reset(1, kCols);
+    std::vector<DatumType> added, removed, out(kCols);
+    MakeSamples(added, kCols);
+    MakeSamples(removed, kCols);
+
+    Time::TimeStamp begin(Time::TimeStamp::Now());
+    for (int rep = 0; rep < kReps; ++rep) {
+        sums.update(0, &added[0], &removed[0], kCols);
+        sums.average(0, 5, kCols, &out[0]);
+    }
+
+    Time::TimeStamp delta(Time::TimeStamp::Now());
+    delta -= begin;
+    std::clog << (sums.getPath() == RunningSums::kAVX2 ? "AVX2" : "scalar") << " update+average of " << kCols
+              << " samples: " << delta.asDouble() / kReps << " sec/PRI" << std::endl;
+}
+
+void
+RunningSumsTest::test()
+{
+    ::srand(31415);
+    testShape();
+
+    RunningSums::Path paths[] = {RunningSums::kScalar, RunningSums::kAVX2};
+    for (RunningSums::Path path : paths) {
+        if (path == RunningSums::kAVX2 && !RunningSums::HasAVX2()) {
+            std::clog << "AVX2 not supported -- skipping" << std::endl;
+            continue;
+        }
+
+        assertEqual(int(path), int(RunningSums(path).getPath()));
+        compare(path, 1);
+        compare(path, 15);
+        compare(path, 16);
+        compare(path, 37);
+        compare(path, 1000);
+        benchmark(path);
+    }
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return RunningSumsTest().mainRun();
+}
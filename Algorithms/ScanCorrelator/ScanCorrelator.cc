@@ -6,9 +6,6 @@
 #include "ScanCorrelator.h"
 #include "ScanCorrelator_defaults.h"
 
-using std::ceil;
-using std::floor;
-
 using namespace SideCar;
 using namespace SideCar::Algorithms;
 using namespace SideCar::Messages;
@@ -46,8 +43,7 @@ ScanCorrelator::startup()
 bool
 ScanCorrelator::reset()
 {
-    searchRadius = param_searchRadius->getValue();
-    searchRadius2 = searchRadius * searchRadius;
+    grid_.clear();
     return true;
 }
 
@@ -62,6 +58,10 @@ ScanCorrelator::process(const Messages::Extractions::Ref& msg)
     Extractions::const_iterator stop = msg->end();
     time_t time = msg->getCreatedTimeStamp().getSeconds();
 
+    // Drop the entries that are too old to match anything in this message.
+    //
+    grid_.expire(time);
+
     for (index = msg->begin(); index != stop; index++) {
         corr(*index, time);
 
@@ -81,148 +81,37 @@ ScanCorrelator::process(const Messages::Extractions::Ref& msg)
 void
 ScanCorrelator::init()
 {
-    double rMax = RadarConfig::GetRangeMax();
-
-    // Initialize the buffer
-    indexOffset = int(ceil(rMax / searchRadius)) + 1;
-    numBins = 2 * indexOffset + 2; // +2 is to allow for less code in corr()
-
-    buffer.resize(numBins);
-
-    for (size_t i = 0; i < numBins; i++) {
-        buffer[i].clear();
-        buffer[i].resize(numBins);
-    }
-}
-
-void
-ScanCorrelator::corrCell(Data& d, Entry& candidates)
-{
-    static Logger::ProcLog log("corrCell", getLog());
-    Extraction& ext = d.extraction;
-
-#ifdef SCAN_CORR_DEBUG
-    cerr << "Cell count: " << candidates.size() << endl;
-#endif
-
-    Entry::iterator ci;
-    Entry::const_iterator stop = candidates.end();
-
-    for (ci = candidates.begin(); ci != stop;) {
-        time_t deltat = d.time - ci->time;
-
-        // Ignore/discard old entries
-        if (deltat > t_old) {
-#ifdef SCAN_CORR_DEBUG
-            cerr << "too old." << endl;
-#endif
-
-            if (deltat > t_veryold) {
-#ifdef SCAN_CORR_DEBUG
-                cerr << "very old, erase." << endl;
-#endif
-
-                ci = candidates.erase(ci);
-            } else {
-                ci++;
-            }
-            continue;
-        }
-
-        // Ignore new entries
-        if (deltat < t_new) {
-#ifdef SCAN_CORR_DEBUG
-            cerr << "too new." << endl;
-#endif
-
-            ci++;
-            continue;
-        }
-
-        const Extraction& other = ci->extraction;
-        // Verify the exact cartesian distance
-        float dx = ext.getX() - other.getX();
-        float dy = ext.getY() - other.getY();
-
-        float dist2 = dx * dx + dy * dy;
-#ifdef SCAN_CORR_DEBUG
-        cerr << "too far? ";
-#endif
-
-        if (dist2 < searchRadius2) {
-#ifdef SCAN_CORR_DEBUG
-            cerr << "no.  correlating." << endl;
-#endif
-
-            // ext.correlate(other, sqrt(dist2));
-            ext.setCorrelated(true);
-            int num_scans = other.getNumCorrelations();
-            num_scans++;
-            ext.setNumCorrelations(num_scans);
-            return;
-        } else {
-#ifdef SCAN_CORR_DEBUG
-            cerr << "yes." << endl;
-#endif
-        }
-
-        ci++;
-    }
+    grid_.setRadius(param_searchRadius->getValue());
+    grid_.setAgeLimits(t_new, t_old, t_veryold);
 }
 
 void
 ScanCorrelator::corr(Extraction& ext, time_t time)
 {
-    // Determine which bin this extraction belongs to
-    // (add +1) to shift the logical data buffer within the larger buffer
-    int binX = int(floor(ext.getX() / searchRadius)) + indexOffset + 1;
-    int binY = int(floor(ext.getY() / searchRadius)) + indexOffset + 1;
-
-    ext.setCorrelated(false);
-
-    Data d = {time, ext};
-
-#ifdef SCAN_CORR_DEBUG
-    cerr << "Correlating extraction (" << ext.getX() << ", " << ext.getY() << ") into [" << binX << ", " << binY
-         << "] numBins=" << numBins << endl;
-#endif
+    // Look for an entry from an earlier scan within the search radius. Entries in the grid are in time order,
+    // so this finds the same entry as the former per-cell list search.
+    //
+    int found = grid_.find(ext.getX(), ext.getY(), time);
+    if (found != CorrelationGrid::kNotFound) {
+        ext.setCorrelated(true);
+        ext.setNumCorrelations(grid_.getCount(found) + 1);
+    } else {
+        ext.setCorrelated(false);
+        ext.setNumCorrelations(0);
+    }
 
-    if (((binX - 1) < 0) || ((binX + 1) >= numBins) || ((binY - 1) < 0) || ((binY + 1) >= numBins)) {
 #ifdef SCAN_CORR_DEBUG
-        cerr << "Bad bin #, bailing" << endl;
+    cerr << "Correlating extraction (" << ext.getX() << ", " << ext.getY() << ") found=" << found
+         << " grid size=" << grid_.size() << endl;
 #endif
 
-        return;
-    }
-
-    // Perform the correlations
-    // binX and binY are never = 0 or numBins - 1, so this code holds
-    // for all possible cases
-    corrCell(d, buffer[binX - 1][binY - 1]);
-    corrCell(d, buffer[binX - 1][binY]);
-    corrCell(d, buffer[binX - 1][binY + 1]);
-    corrCell(d, buffer[binX][binY - 1]);
-    corrCell(d, buffer[binX + 1][binY - 1]);
-    corrCell(d, buffer[binX][binY]);
-    corrCell(d, buffer[binX][binY + 1]);
-    corrCell(d, buffer[binX + 1][binY]);
-    corrCell(d, buffer[binX + 1][binY + 1]);
-
-    if (!d.extraction.getCorrelated()) d.extraction.setNumCorrelations(0);
-
-    // Add to buffer
-    buffer[binX][binY].push_back(d);
-
-    // set the result
-    ext = d.extraction;
+    grid_.add(ext.getX(), ext.getY(), time, ext.getNumCorrelations());
 }
 
 void
 ScanCorrelator::on_searchRadius_changed(const Parameter::DoubleValue& x)
 {
-    searchRadius = param_searchRadius->getValue();
-    searchRadius2 = searchRadius * searchRadius;
-    init();
+    grid_.setRadius(x.getValue());
 }
 
 void
@@ -232,6 +121,7 @@ ScanCorrelator::on_scanTime_changed(const Parameter::IntValue& x)
     t_new = scanRate / 2;
     t_old = scanRate + t_new;
     t_veryold = 2 * scanRate;
+    grid_.setAgeLimits(t_new, t_old, t_veryold);
 }
 
 // DLL support
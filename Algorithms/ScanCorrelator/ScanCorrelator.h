@@ -2,18 +2,17 @@
 #define SIDECAR_ALGORITHMS_SCAN_CORRELATOR_H
 
 #include "Algorithms/Algorithm.h"
+#include "Algorithms/CorrelationGrid.h"
 #include "Messages/Extraction.h"
 #include "Messages/Video.h"
 #include "Parameter/Parameter.h"
 
-#include <cmath>
-#include <list>
-#include <vector>
-
 namespace SideCar {
 namespace Algorithms {
 
-/**
+/** Marks extractions that lie within searchRadius of an extraction from roughly one scan earlier, and forwards
+    those that have been correlated over numScans scans. Recent extractions are held in a CorrelationGrid.
+
    \ingroup Algorithms
 */
 class ScanCorrelator : public Algorithm {
@@ -50,20 +49,9 @@ private:
     using time_t = long;
     using Extraction = SideCar::Messages::Extraction;
 
-    struct Data {
-        time_t time;
-        SideCar::Messages::Extraction extraction;
-    };
-
-    using Entry = std::list<Data>;
-    std::vector<std::vector<Entry>> buffer; // [x][y]
-    size_t indexOffset;
-
-    void corrCell(Data&, Entry& candidates);
     void corr(Extraction& ext, time_t t);
 
-    double rMax;
-    size_t numBins;
+    CorrelationGrid grid_;
 
     Parameter::DoubleValue::Ref param_searchRadius;
 
@@ -75,9 +63,6 @@ private:
 
     Parameter::IntValue::Ref param_numScans;
 
-    float searchRadius;  // the maximum gating size for correlation to occur
-    float searchRadius2; // = searchRadius^2
-
     time_t t_new, t_old, t_veryold;
 };
 
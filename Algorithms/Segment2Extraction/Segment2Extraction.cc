@@ -29,6 +29,7 @@ Segment2Extraction::process(const Messages::SegmentMessage::Ref& pri)
 {
     // Read in the message
     const SegmentList& ext = *pri->data();
+    if (ext.empty()) return true;
 
     if (powerF->getValue()) {
         // use the power centroid
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "Messages/RadarConfig.h"
 
 #include "SegmentConnector.h"
@@ -9,11 +11,17 @@ using namespace SideCar::Algorithms;
 static const char* kAlgorithmName = "SegmentConnector";
 
 SegmentConnector::SegmentConnector(Controller& controller, Logger::Log& log) :
-    Algorithm(controller, log), oldPRI(), oldTrees(new std::list<SegmentTree*>())
+    Algorithm(controller, log), blobs_(), freeBlobs_(), merged_(), roots_(), previous_(), current_(), priCount_(0),
+    started_(false), rangeMin_(0.0), rangeFactor_(0.0)
 {
     ;
 }
 
+SegmentConnector::~SegmentConnector()
+{
+    reset();
+}
+
 bool
 SegmentConnector::startup()
 {
@@ -24,129 +32,168 @@ SegmentConnector::startup()
 bool
 SegmentConnector::reset()
 {
-    oldPRI.reset();
-    oldTrees->clear();
+    for (size_t index = 0; index < blobs_.size(); ++index) delete blobs_[index].list;
+    blobs_.clear();
+    freeBlobs_.clear();
+    merged_.clear();
+    previous_.clear();
+    current_.clear();
+    started_ = false;
     return true;
 }
 
+int
+SegmentConnector::allocateBlob()
+{
+    if (freeBlobs_.empty()) {
+        blobs_.push_back(Blob());
+        return blobs_.size() - 1;
+    }
+
+    int index = freeBlobs_.back();
+    freeBlobs_.pop_back();
+    return index;
+}
+
+int
+SegmentConnector::find(int blob)
+{
+    while (blobs_[blob].parent != blob) {
+        int parent = blobs_[blob].parent;
+        blobs_[blob].parent = blobs_[parent].parent;
+        blob = parent;
+    }
+
+    return blob;
+}
+
+void
+SegmentConnector::touch(Blob& blob)
+{
+    if (blob.lastPRI != priCount_) {
+        blob.lastPRI = priCount_;
+        blob.list->setPRISpan(blob.list->PRISpan() + 1);
+    }
+}
+
+void
+SegmentConnector::connect(const Segment& segment, size_t& firstSpan)
+{
+    // Skip the segments of the previous PRI that end before this one begins, less one for the diagonal
+    // neighbour. The ones that remain may also touch the next segment, so leave firstSpan at the first of them.
+    //
+    while (firstSpan < previous_.size() && previous_[firstSpan].stop + 1 < segment.start) ++firstSpan;
+
+    roots_.clear();
+    for (size_t index = firstSpan; index < previous_.size() && previous_[index].start <= segment.stop + 1; ++index) {
+        int root = find(previous_[index].blob);
+        if (std::find(roots_.begin(), roots_.end(), root) == roots_.end()) roots_.push_back(root);
+    }
+
+    int master;
+    if (roots_.empty()) {
+        // Start a new blob.
+        //
+        master = allocateBlob();
+        Blob& b(blobs_[master]);
+        b.parent = master;
+        b.lastPRI = priCount_;
+        b.list = new SegmentList;
+    } else {
+        // Keep the blob with the most segments, and merge the others into it.
+        //
+        master = roots_[0];
+        for (size_t index = 1; index < roots_.size(); ++index) {
+            if (blobs_[roots_[index]].list->size() > blobs_[master].list->size()) master = roots_[index];
+        }
+
+        Blob& m(blobs_[master]);
+        touch(m);
+        for (size_t index = 0; index < roots_.size(); ++index) {
+            int other = roots_[index];
+            if (other == master) continue;
+            Blob& o(blobs_[other]);
+            touch(o);
+            m.list->merge(*o.list);
+            delete o.list;
+            o.list = 0;
+            o.parent = master;
+            merged_.push_back(other);
+        }
+    }
+
+    blobs_[master].list->merge(segment);
+    current_.push_back(Span{segment.start, segment.stop, master});
+}
+
+bool
+SegmentConnector::finish(int blob, const SegmentMessage::Ref& basis)
+{
+    SegmentList* list = blobs_[blob].list;
+    blobs_[blob].list = 0;
+    freeBlobs_.push_back(blob);
+    return send(SegmentMessage::Ref(new SegmentMessage(kAlgorithmName, basis, list, rangeMin_, rangeFactor_)));
+}
+
 bool
 SegmentConnector::process(Messages::SegmentMessage::Ref newPRI)
 {
     // Detect changes in runtime settings, resetting everything when they occur.
     //
-    if (oldPRI && (rangeMin_ != newPRI->getRangeMin() || rangeFactor_ != newPRI->getRangeFactor())) { reset(); }
+    if (started_ && (rangeMin_ != newPRI->getRangeMin() || rangeFactor_ != newPRI->getRangeFactor())) { reset(); }
 
-    if (!oldPRI) {
+    if (!started_) {
+        started_ = true;
         rangeMin_ = newPRI->getRangeMin();
         rangeFactor_ = newPRI->getRangeFactor();
-        oldPRI = boost::shared_ptr<SegmentMessage>(new SegmentMessage(kAlgorithmName, newPRI, rangeMin_, rangeFactor_));
     }
 
-    // pick a different flavor each month, but always chocolate or vanilla
-    bool flavor = false;
-    if (!oldTrees->empty()) {
-        flavor = oldTrees->front()->isOld(true); // toggles the flavor
-    }
+    ++priCount_;
+    current_.clear();
 
-    // Initialize the new list of trees
-    std::list<SegmentTree*>* newTrees = new std::list<SegmentTree*>(newPRI->data()->data().size());
-    { // initialize the new element flavors
-        std::list<SegmentTree*>::iterator i;
-        std::list<SegmentTree*>::const_iterator stop = newTrees->end();
-        for (i = newTrees->begin(); i != stop; i++) { *i = new SegmentTree(flavor); }
-    }
+    // Connect adjacent segments -- assumes that segments within a PRI are maximally connected, i.e. gaps separate
+    // all segments within a PRI, and that they are in range order.
+    //
+    size_t firstSpan = 0;
+    for (const Segment& segment : *newPRI->data()) connect(segment, firstSpan);
 
-    // Indices into both segment lists
-    std::list<Segment>::const_iterator oldSegment = oldPRI->data()->data().begin();
-    std::list<Segment>::const_iterator newSegment = newPRI->data()->data().begin();
-    std::list<Segment>::const_iterator stopOld = oldPRI->data()->data().end();
-    std::list<Segment>::const_iterator stopNew = newPRI->data()->data().end();
-
-    // Indices into both tree lists
-    std::list<SegmentTree*>::iterator oldTree = oldTrees->begin(); // previous connections
-    std::list<SegmentTree*>::iterator newTree = newTrees->begin(); // previous connections
-
-    // Connect adjacent segments -- assumes that segments within a layer are maximally connected
-    // i.e. gaps separate all segments within a layer
-    for (; oldSegment != stopOld; oldSegment++, oldTree++) {
-        for (; newSegment != stopNew; newSegment++, newTree++) {
-            if (newSegment->stop < oldSegment->start - 1) // -1 gives full 8-point connectivity
-            {
-                // new segment ends before old segment begins -- start a new extraction as needed
-                (*newTree)->seed(*newSegment);
-                continue;
-            }
-
-            if (newSegment->start > oldSegment->stop + 1) // +1 gives full 8-point connectivity
-            {
-                // new segment begins after old segment ends -- check the next old segment
-                break;
-            }
-
-            // the segments overlap -- merge
-            (*oldTree)->add(**newTree, *newSegment);
-
-            if (newSegment->stop > oldSegment->stop + 1) {
-                // new ends after old segment ends -- may touch the next segment
-                break;
-            }
-        }
+    // Resolve the labels of this PRI before any merged blob records are released.
+    //
+    for (size_t index = 0; index < current_.size(); ++index) current_[index].blob = find(current_[index].blob);
 
-        if (newSegment == stopNew) {
-            // no more segments to process
-            break;
-        }
-    }
-    // clean up any untouched new segments
-    for (; newSegment != stopNew; newSegment++, newTree++) { (*newTree)->seed(*newSegment); }
-
-    // Identify finished (not updated this PRI) extractions
-    std::list<SegmentTree*>::const_iterator stopTree = oldTrees->end();
-    for (oldTree = oldTrees->begin(); oldTree != stopTree; oldTree++) {
-        if ((*oldTree)->isRoot()) {
-            // extraction is complete
-            if (!send(SegmentMessage::Ref(
-                    new SegmentMessage(kAlgorithmName, newPRI, (*oldTree)->takeData(), rangeMin_, rangeFactor_))))
-                return false;
+    // Identify finished (not updated this PRI) extractions. Merged blobs have already given up their lists.
+    //
+    bool ok = true;
+    for (size_t index = 0; index < previous_.size(); ++index) {
+        int blob = previous_[index].blob;
+        if (blobs_[blob].list && blobs_[blob].lastPRI != priCount_) {
+            if (!finish(blob, newPRI)) ok = false;
         }
     }
 
-    // Identify rings
-    // anything over half a scan is "ring-like"
+    freeBlobs_.insert(freeBlobs_.end(), merged_.begin(), merged_.end());
+    merged_.clear();
+
+    // Identify rings -- anything over half a scan is "ring-like". Emit them now, and drop their segments so that
+    // nothing connects to them.
+    //
     const size_t halfScan = (RadarConfig::GetShaftEncodingMax() + 1) / 2;
-    stopTree = newTrees->end();
-    for (newTree = newTrees->begin(); newTree != stopTree; /* increment in the loop */) {
-        if ((*newTree)->isRoot() && ((*newTree)->data()->PRISpan() > halfScan)) {
-            // remove the corresponding segments
-            newPRI->data()->pop(*(*newTree)->data());
-            // extraction is complete
-            if (!send(SegmentMessage::Ref(
-                    new SegmentMessage(kAlgorithmName, newPRI, (*newTree)->takeData(), rangeMin_, rangeFactor_))))
-                return false;
-
-            // remove all traces of the extraction from newTrees
-            // get the name of the tree to remove
-            SegmentTree* dead = (*newTree)->root();
-            // perform the cut
-            std::list<SegmentTree*>::iterator cull;
-            for (cull = newTrees->begin(); cull != stopTree; cull++) {
-                if ((*cull)->root() == dead) {
-                    if (cull == newTree) newTree++;
-                    cull = newTrees->erase(cull);
-                }
-            }
-        } else {
-            newTree++;
+    size_t kept = 0;
+    for (size_t index = 0; index < current_.size(); ++index) {
+        int blob = current_[index].blob;
+        if (blobs_[blob].list && blobs_[blob].list->PRISpan() > halfScan) {
+            if (!finish(blob, newPRI)) ok = false;
         }
+
+        if (blobs_[blob].list) current_[kept++] = current_[index];
     }
 
+    current_.resize(kept);
+
     // Prepare for the next PRI
-    oldPRI = newPRI;
-    stopTree = oldTrees->end();
-    for (oldTree = oldTrees->begin(); oldTree != stopTree; oldTree++) { delete (*oldTree); }
-    delete (oldTrees);
-    oldTrees = newTrees;
-    return true;
+    //
+    previous_.swap(current_);
+    return ok;
 }
 
 // DLL support
@@ -1,27 +1,77 @@
 #ifndef SIDECAR_ALGORITHMS_SEGMENT_CONNECTOR_H // -*- C++ -*-
 #define SIDECAR_ALGORITHMS_SEGMENT_CONNECTOR_H
 
+#include <vector>
+
 #include "Algorithms/Algorithm.h"
 #include "Messages/Segments.h"
-#include "SegmentTree.h"
 
 namespace SideCar {
 namespace Algorithms {
 
 /** Takes a stream of PRISegments and outputs a stream of segments, each representing an extraction blob.
- */
+
+    The segments of each PRI are joined to the 8-connected segments of the previous PRI with a union-find over a
+    pool of blob records. A blob that gains no segments from a PRI is complete and is emitted. Blob records and
+    the span arrays are recycled, so the only per-PRI allocations are the SegmentList of each new blob (whose
+    storage comes from the SegmentList pool) and the output messages.
+*/
 class SegmentConnector : public Algorithm {
 public:
     SegmentConnector(Controller& controller, Logger::Log& log);
 
+    ~SegmentConnector();
+
     bool startup();
     bool reset();
 
 private:
+    enum { kNone = -1 };
+
+    /** Blob record. A blob merged into another during the current PRI points to it through parent; all other
+        blobs are their own parents and own a segment list.
+    */
+    struct Blob {
+        int parent;
+        uint64_t lastPRI;            ///< Last PRI that added segments to the blob
+        Messages::SegmentList* list; ///< Segments of the blob (roots only)
+    };
+
+    /** A segment of the previous or current PRI and the blob it belongs to.
+     */
+    struct Span {
+        size_t start;
+        size_t stop;
+        int blob;
+    };
+
     bool process(Messages::SegmentMessage::Ref newPRI);
 
-    Messages::SegmentMessage::Ref oldPRI;
-    std::list<SegmentTree*>* oldTrees;
+    int allocateBlob();
+
+    int find(int blob);
+
+    /** Add a segment of the current PRI to the blobs of the previous PRI that it touches, merging them if there
+        are more than one.
+    */
+    void connect(const Messages::Segment& segment, size_t& firstSpan);
+
+    /** Update the PRI span of a blob that gains segments from the current PRI.
+     */
+    void touch(Blob& blob);
+
+    /** Emit a finished blob and return its record to the pool.
+     */
+    bool finish(int blob, const Messages::SegmentMessage::Ref& basis);
+
+    std::vector<Blob> blobs_;
+    std::vector<int> freeBlobs_;
+    std::vector<int> merged_;
+    std::vector<int> roots_;
+    std::vector<Span> previous_;
+    std::vector<Span> current_;
+    uint64_t priCount_;
+    bool started_;
     double rangeMin_;
     double rangeFactor_;
 };
@@ -12,7 +12,8 @@ SegmentSplitter::SegmentSplitter(Controller& controller, Logger::Log& log) :
     Algorithm(controller, log), deltaRange(Parameter::IntValue::Make("range/2", "Range / 2", 3)),
     deltaAz(Parameter::IntValue::Make("azimuth/2", "Azimuth / 2", 6)),
     overlap(Parameter::NormalizedValue::Make("overlap", "Overlap", 0.1)),
-    buffer(RadarConfig::GetShaftEncodingMax() + 1, RadarConfig::GetGateCountMax(), 2, 2), row(buffer)
+    buffer(RadarConfig::GetShaftEncodingMax() + 1, RadarConfig::GetGateCountMax(), 2, 2), row(buffer), peaks_(),
+    extractions_()
 {
     overlap->connectChangedSignalTo(boost::bind(&SegmentSplitter::handle_overlap_change, this, _1));
     buffer.clearData();
@@ -33,33 +34,23 @@ SegmentSplitter::reset()
     return true;
 }
 
-// private struct for SegmentSplitter::process()
-struct Peak {
-    size_t range;
-    size_t azimuth;
-    Video::DatumType value;
-    float sum; // sum of the values for the 3x3 block centered about this peak
-};
-
 bool
 SegmentSplitter::processSegment(SegmentMessage::Ref pri)
 {
     // Read in the message
-    const std::list<Segment>& in = pri->data()->data();
+    const SegmentList& in = *pri->data();
 
     // identify the peaks in this extraction a peak is the highest value in its 9-cell region
     //
-    std::list<Segment>::const_iterator seg;
-    std::list<Segment>::const_iterator stop = in.end();
     Peak peak;
-    std::list<Peak> peaks;
-    for (seg = in.begin(); seg != stop; seg++) {
-        size_t azimuth = seg->azimuth;
-
-        Video::DatumType oldValue = buffer.get(azimuth, seg->start - 1);
-        Video::DatumType value = buffer.get(azimuth, seg->start);
-        Video::DatumType newValue = buffer.get(azimuth, seg->start + 1);
-        for (size_t i = seg->start; i <= seg->stop; i++) {
+    peaks_.clear();
+    for (const Segment& seg : in) {
+        size_t azimuth = seg.azimuth;
+
+        Video::DatumType oldValue = buffer.get(azimuth, seg.start - 1);
+        Video::DatumType value = buffer.get(azimuth, seg.start);
+        Video::DatumType newValue = buffer.get(azimuth, seg.start + 1);
+        for (size_t i = seg.start; i <= seg.stop; i++) {
             if (value >= newValue && value >= oldValue) {
                 // found a peak on this azimuth, check to either side
                 Video::DatumType tmp;
@@ -75,7 +66,7 @@ SegmentSplitter::processSegment(SegmentMessage::Ref pri)
                     peak.azimuth = azimuth;
                     peak.value = value;
                     peak.sum += oldValue + value + newValue;
-                    peaks.push_back(peak);
+                    peaks_.push_back(peak);
                 }
             }
 
@@ -95,76 +86,78 @@ SegmentSplitter::processSegment(SegmentMessage::Ref pri)
     const int scan = RadarConfig::GetShaftEncodingMax() + 1;
     const int scan_2 = scan / 2;
 
-    // Sort through the peaks, picking the highest peak "per object"
+    // Sort through the peaks, picking the highest peak "per object". Shadowed peaks are squeezed out of the
+    // array in place, which keeps the remaining peaks in order.
     //
-    std::list<Peak> extractions;
-    while (peaks.size()) {
+    extractions_.clear();
+    while (!peaks_.empty()) {
         // Find the highest peak
-        std::list<Peak>::iterator peak = peaks.begin();
-        std::list<Peak>::iterator max = peak; // start assuming the first peak is highest
-        std::list<Peak>::const_iterator stop = peaks.end();
-        for (peak++; peak != stop; peak++) // then check the other peaks
-        {
-            if ((peak->value > max->value) || ((peak->value == max->value) && (peak->sum > max->sum))) { max = peak; }
+        size_t max = 0; // start assuming the first peak is highest
+        for (size_t index = 1; index < peaks_.size(); ++index) {
+            const Peak& peak(peaks_[index]);
+            const Peak& highest(peaks_[max]);
+            if ((peak.value > highest.value) || ((peak.value == highest.value) && (peak.sum > highest.sum))) {
+                max = index;
+            }
         }
 
         // declare the extraction
-        Peak summit = *max;
-        extractions.push_back(summit);
-
-        // remove any peaks shadowed by max
-        peaks.erase(max);
-        for (peak = peaks.begin(); peak != stop; /* increment in the loop */) {
-            int dRange = wAz * (summit.range - peak->range); // cross-multiply instead of dividing
-            int dAz = summit.azimuth - peak->azimuth;
+        Peak summit = peaks_[max];
+        extractions_.push_back(summit);
+
+        // remove max and any peaks shadowed by it
+        size_t kept = 0;
+        for (size_t index = 0; index < peaks_.size(); ++index) {
+            if (index == max) continue;
+            const Peak& peak(peaks_[index]);
+            int dRange = wAz * (summit.range - peak.range); // cross-multiply instead of dividing
+            int dAz = summit.azimuth - peak.azimuth;
             if (dAz < -scan_2) dAz += scan;
             if (dAz > scan_2) dAz -= scan;
             dAz *= wRange;
 
-            if (dRange * dRange + dAz * dAz < close2) {
-                peak = peaks.erase(peak);
-            } else {
-                peak++;
-            }
+            if (dRange * dRange + dAz * dAz >= close2) peaks_[kept++] = peak;
         }
+
+        peaks_.resize(kept);
     }
 
     // Create a new SegmentMessage for each extraction
     //
-    std::list<Peak>::const_iterator ext;
-    std::list<Peak>::const_iterator stopExt = extractions.end();
     Segment s;
-    for (ext = extractions.begin(); ext != stopExt; ext++) {
+    for (const Peak& ext : extractions_) {
         // create a SegmentMessage
         SegmentMessage::Ref output(new SegmentMessage(kAlgorithmName, pri, pri->getRangeMin(), pri->getRangeFactor()));
         SegmentList& out = *output->data();
 
         // Set the peak
-        out.peakPower = ext->value;
-        out.peakRange = ext->range;
-        out.peakAzimuth = ext->azimuth;
+        out.peakPower = ext.value;
+        out.peakRange = ext.range;
+        out.peakAzimuth = ext.azimuth;
 
         // Specify the bounds for this extraction
-        size_t az0 = ext->azimuth;
-        size_t rangeMin = ext->range - wRange;
-        size_t rangeMax = ext->range + wRange;
+        size_t az0 = ext.azimuth;
+        size_t rangeMin = ext.range - wRange;
+        size_t rangeMax = ext.range + wRange;
 
         // scan over the original segments, and select segments which are close to this peak
         // this time, use the 1-norm
-        for (seg = in.begin(); seg != stop; seg++) {
-            s.azimuth = seg->azimuth;
+        for (const Segment& seg : in) {
+            s.azimuth = seg.azimuth;
 
             int dAz = az0 - s.azimuth;
             if (dAz < -scan_2) dAz += scan;
             if (dAz > scan_2) dAz -= scan;
 
             if (abs(dAz) <= wAz) {
-                s.start = seg->start;
+                s.start = seg.start;
                 if (s.start < rangeMin) s.start = rangeMin;
-                s.stop = seg->stop;
+                s.stop = seg.stop;
                 if (s.stop > rangeMax) s.stop = rangeMax;
 
-                out.merge(s);
+                // Skip segments that lie entirely outside of the range window.
+                //
+                if (s.start <= s.stop) out.merge(s);
             }
         }
 
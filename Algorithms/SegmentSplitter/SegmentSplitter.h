@@ -1,6 +1,8 @@
 #ifndef SIDECAR_ALGORITHMS_SEGMENT_SPLITTER_H // -*- C++ -*-
 #define SIDECAR_ALGORITHMS_SEGMENT_SPLITTER_H
 
+#include <vector>
+
 #include "Algorithms/Algorithm.h"
 #include "Messages/Segments.h"
 #include "Messages/Video.h"
@@ -57,6 +59,15 @@ public:
     bool reset();
 
 private:
+    /** A local maximum of an extraction.
+     */
+    struct Peak {
+        size_t range;
+        size_t azimuth;
+        Messages::Video::DatumType value;
+        float sum; // sum of the values for the 3x3 block centered about this peak
+    };
+
     bool processSegment(Messages::SegmentMessage::Ref pri);
     bool processVideo(Messages::Video::Ref msg);
 
@@ -74,6 +85,11 @@ private:
     Buffer<VideoT> buffer;
     int currentRow;
     Buffer<VideoT>::Row row;
+
+    // Scratch space for processSegment(), kept to avoid allocations
+    //
+    std::vector<Peak> peaks_;
+    std::vector<Peak> extractions_;
 };
 
 } // namespace Algorithms
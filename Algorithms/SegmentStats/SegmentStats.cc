@@ -68,14 +68,13 @@ SegmentStats::processSegmentMessage(SegmentMessage::Ref pri)
         peakAz = in.peakAzimuth;
     }
 
-    // The master loop
-    std::list<Segment>::const_iterator seg;
-    std::list<Segment>::const_iterator stop = in.data().end();
-    for (seg = in.data().begin(); seg != stop; seg++) {
-        out.merge(*seg); // Add this segment to the output
+    // Add the segments to the output
+    out.assign(in);
 
-        size_t azimuth = seg->azimuth;
-        for (size_t i = seg->start; i < seg->stop; i++) {
+    // The master loop
+    for (const Segment& seg : in) {
+        size_t azimuth = seg.azimuth;
+        for (size_t i = seg.start; i < seg.stop; i++) {
             VideoT p = buffer.get(azimuth, i);
             if (azimuth < pi) {
                 powerA += p;
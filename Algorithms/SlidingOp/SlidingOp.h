@@ -51,6 +51,12 @@ public:
 
     bool startup();
 
+    /** Each PRI is processed on its own, so replicas are safe.
+
+        \return true
+    */
+    bool isReplicaSafe() const { return true; }
+
     void setInitialOffset(int value) { initialOffset_->setValue(value); }
 
     void setWindowSize(size_t value) { windowSize_->setValue(value); }
@@ -25,7 +25,8 @@ TrackInitiator::TrackInitiator(Controller& controller, Logger::Log& log) :
                                                        kDefaultAssumedAltitude)),
 
     param_minRange(
-        Parameter::DoubleValue::Make("minRange", "Minimum Range, in km, for track initiation", kDefaultMinRange))
+        Parameter::DoubleValue::Make("minRange", "Minimum Range, in km, for track initiation", kDefaultMinRange)),
+    currentTrackNum_(0)
 {
     param_searchRadius->connectChangedSignalTo(boost::bind(&TrackInitiator::on_searchRadius_changed, this, _1));
     param_scanTime->connectChangedSignalTo(boost::bind(&TrackInitiator::on_scanTime_changed, this, _1));
@@ -36,6 +37,7 @@ bool
 TrackInitiator::startup()
 {
     registerProcessor<TrackInitiator, Messages::Extractions>(&TrackInitiator::process);
+    init();
     return registerParameter(param_searchRadius) && registerParameter(param_scanTime) &&
            registerParameter(param_numScans) && registerParameter(param_assumedAltitude) &&
            registerParameter(param_minRange) && Algorithm::startup();
@@ -44,8 +46,7 @@ TrackInitiator::startup()
 bool
 TrackInitiator::reset()
 {
-    searchRadius_ = param_searchRadius->getValue();
-    searchRadius2_ = searchRadius_ * searchRadius_;
+    grid_.clear();
     return Algorithm::reset();
 }
 
@@ -56,14 +57,19 @@ TrackInitiator::process(const Messages::Extractions::Ref& msg)
 
     int num_scans = param_numScans->getValue();
 
+    // Drop the entries that are too old to match anything in this message.
+    //
+    if (!msg->empty()) grid_.expire(msg->begin()->getWhen().asDouble());
+
+    bool ok = true;
     Extractions::const_iterator pos = msg->begin();
     Extractions::const_iterator end = msg->end();
 
     while (pos != end) {
-        Data d(*pos++);
-        corr(d);
+        Extraction ext(*pos++);
+        Track::Coord velocity;
+        corr(ext, velocity);
 
-        Extraction& ext(d.extraction_);
         LOGDEBUG << "correlated? " << ext.getCorrelated() << " at " << ext.getX() << ", " << ext.getY() << std::endl;
 
         if (ext.getCorrelated() && ext.getNumCorrelations() >= num_scans - 1) {
@@ -107,23 +113,23 @@ TrackInitiator::process(const Messages::Extractions::Ref& msg)
             // Velocity estimate should be a simple point-to-point velocity between last two measurements in the
             // hypothesis convert enu velocity to llh velocity
             //
-            Track::Coord xyz_vel(d.velocity_[0] * 1000, d.velocity_[1] * 1000);
+            Track::Coord xyz_vel(velocity[0] * 1000, velocity[1] * 1000);
             Track::Coord rae_vel;
             geoXyz2Rae(xyz_vel.tuple_, rae_vel.tuple_);
 
-            GEO_LOCATION* morigin = new GEO_LOCATION;
+            GEO_LOCATION morigin;
 
             //
             // geoInitLocation() expects lat/lon in degrees, height in meters.
             // geoInitLocation(measurement_origin,measurement[GEO_LAT],measurement[GEO_LON],measurement[GEO_HGT],
             // GEO_DATUM_DEFAULT,"Measurement");
 
-            geoInitLocation(morigin, Utils::radiansToDegrees(measurement[GEO_LAT]),
+            geoInitLocation(&morigin, Utils::radiansToDegrees(measurement[GEO_LAT]),
                             Utils::radiansToDegrees(measurement[GEO_LON]), measurement[GEO_HGT], GEO_DATUM_DEFAULT,
                             "Measurement");
 
             Track::Coord efg_vel;
-            geoRae2Efg(morigin, &rae_vel[0], efg_vel.tuple_);
+            geoRae2Efg(&morigin, &rae_vel[0], efg_vel.tuple_);
             Track::Coord llh_vel;
             geoEfg2Llh(GEO_DATUM_DEFAULT, efg_vel.tuple_, &llh_vel[GEO_LAT], &llh_vel[GEO_LON], &llh_vel[GEO_HGT]);
             llh_vel[GEO_LAT] -= measurement[GEO_LAT];
@@ -134,139 +140,52 @@ TrackInitiator::process(const Messages::Extractions::Ref& msg)
 
             LOGDEBUG << "sending new track report for track " << trk->getTrackNumber() << std::endl;
 
-            return send(trk);
+            ok &= send(trk);
         }
     }
 
-    return true;
+    return ok;
 }
 
 void
 TrackInitiator::init()
 {
-    double rMax = RadarConfig::GetRangeMax();
     currentTrackNum_ = 0;
-
-    // Initialize the buffer
-    //
-    indexOffset_ = int(ceil(rMax / searchRadius_)) + 1;
-    numBins_ = 2 * indexOffset_ + 2; // +2 is to allow for less code in corr()
-    buffer_.resize(numBins_);
-    for (size_t i = 0; i < numBins_; ++i) {
-        buffer_[i].clear();
-        buffer_[i].resize(numBins_);
-    }
+    grid_.setRadius(param_searchRadius->getValue());
+    grid_.setAgeLimits(t_new_, t_old_, t_veryold_);
 }
 
 void
-TrackInitiator::corrCell(Data& d, Entry& candidates)
+TrackInitiator::corr(Extraction& ext, Track::Coord& velocity)
 {
-    static Logger::ProcLog log("corrCell", getLog());
-
-    Extraction& ext = d.extraction_;
-
-    LOGDEBUG << "cell count: " << candidates.size() << endl;
-
-    Entry::iterator ci = candidates.begin();
-    Entry::iterator end = candidates.end();
-    while (ci != end) {
-        double delta = d.when_ - ci->when_;
-        if (delta > t_old_) {
-            LOGDEBUG << "too old. delta=" << delta << " threshold=" << t_old_ << endl;
-
-            if (delta > t_veryold_) {
-                LOGDEBUG << "very old, erase." << endl;
-                ci = candidates.erase(ci);
-            } else {
-                ++ci;
-            }
-            continue;
-        }
-
-        // Ignore new entries
-        //
-        if (delta < t_new_) {
-            LOGDEBUG << "too new." << endl;
-            ++ci;
-            continue;
-        }
+    static Logger::ProcLog log("corr", getLog());
 
-        const Extraction& other = ci->extraction_;
+    double when = ext.getWhen().asDouble();
+    int found = grid_.find(ext.getX(), ext.getY(), when);
+    if (found != CorrelationGrid::kNotFound) {
+        ext.setCorrelated(true);
+        ext.setNumCorrelations(grid_.getCount(found) + 1);
 
-        // Verify the exact cartesian distance
+        // Compute simple point-to-point velocity in enu coordinates
         //
-        float dx = ext.getX() - other.getX();
-        float dy = ext.getY() - other.getY();
-        float dist2 = dx * dx + dy * dy;
-        LOGDEBUG << "too far? ";
-
-        if (dist2 < searchRadius2_) {
-            LOGDEBUG << "no.  correlating." << endl;
-
-            ext.setCorrelated(true);
-            int num_scans = other.getNumCorrelations() + 1;
-            ext.setNumCorrelations(num_scans);
-
-            //
-            // Compute simple point-to-point velocity in enu coordinates
-            //
-            delta = ext.getWhen().asDouble() - other.getWhen().asDouble();
-            d.velocity_[0] = dx / delta;
-            d.velocity_[1] = dy / delta;
-            return;
-        }
-
-        LOGDEBUG << "yes." << endl;
-        ++ci;
+        double delta = when - grid_.getWhen(found);
+        velocity[0] = (ext.getX() - grid_.getX(found)) / delta;
+        velocity[1] = (ext.getY() - grid_.getY(found)) / delta;
+    } else {
+        ext.setCorrelated(false);
+        ext.setNumCorrelations(0);
     }
-}
 
-void
-TrackInitiator::corr(Data& d)
-{
-    static Logger::ProcLog log("corr", getLog());
-    LOGINFO << std::endl;
+    LOGDEBUG << "extraction (" << ext.getX() << ", " << ext.getY() << ") found: " << found
+             << " grid size: " << grid_.size() << std::endl;
 
-    // Determine which bin this extraction belongs to (add +1) to shift the logical data buffer within the
-    // larger buffer
-    //
-    int binX = int(floor(d.extraction_.getX() / searchRadius_)) + indexOffset_ + 1;
-    int binY = int(floor(d.extraction_.getY() / searchRadius_)) + indexOffset_ + 1;
-
-    d.extraction_.setCorrelated(false);
-
-    LOGDEBUG << "Correlating extraction (" << d.extraction_.getX() << ", " << d.extraction_.getY() << ") into [" << binX
-             << ", " << binY << "] numBins=" << numBins_ << std::endl;
-
-    if (binX < 1 || binX >= numBins_ - 1 || binY < 1 || binY >= numBins_ - 1) {
-        LOGERROR << "Bad bin #, bailing" << endl;
-        return;
-    }
-
-    // Perform the correlations binX and binY are never = 0 or numBins - 1, so this code holds for all possible
-    // cases
-    //
-    corrCell(d, buffer_[binX - 1][binY - 1]);
-    corrCell(d, buffer_[binX - 1][binY]);
-    corrCell(d, buffer_[binX - 1][binY + 1]);
-    corrCell(d, buffer_[binX][binY - 1]);
-    corrCell(d, buffer_[binX + 1][binY - 1]);
-    corrCell(d, buffer_[binX][binY]);
-    corrCell(d, buffer_[binX][binY + 1]);
-    corrCell(d, buffer_[binX + 1][binY]);
-    corrCell(d, buffer_[binX + 1][binY + 1]);
-
-    if (!d.extraction_.getCorrelated()) d.extraction_.setNumCorrelations(0);
-
-    buffer_[binX][binY].push_back(d);
+    grid_.add(ext.getX(), ext.getY(), when, ext.getNumCorrelations());
 }
 
 void
 TrackInitiator::on_searchRadius_changed(const Parameter::DoubleValue& x)
 {
-    searchRadius_ = param_searchRadius->getValue();
-    searchRadius2_ = searchRadius_ * searchRadius_;
-    init();
+    grid_.setRadius(x.getValue());
 }
 
 void
@@ -276,6 +195,7 @@ TrackInitiator::on_scanTime_changed(const Parameter::IntValue& x)
     t_new_ = scanRate / 2;
     t_old_ = scanRate + t_new_;
     t_veryold_ = 2 * scanRate;
+    grid_.setAgeLimits(t_new_, t_old_, t_veryold_);
 }
 
 // DLL support
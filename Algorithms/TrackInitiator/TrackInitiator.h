@@ -1,12 +1,10 @@
 #ifndef SIDECAR_ALGORITHMS_TRACK_INITIATOR_H // -*- C++ -*-
 #define SIDECAR_ALGORITHMS_TRACK_INITIATOR_H
 
-#include <cmath>
-#include <list>
 #include <time.h> // for time_t and friends
-#include <vector>
 
 #include "Algorithms/Algorithm.h"
+#include "Algorithms/CorrelationGrid.h"
 #include "Messages/Extraction.h"
 #include "Messages/Track.h"
 #include "Parameter/Parameter.h"
@@ -14,7 +12,10 @@
 namespace SideCar {
 namespace Algorithms {
 
-/**
+/** Emits a tentative Track message for each extraction that has been correlated over numScans scans. The
+    initial velocity is the point-to-point velocity from the correlated extraction of the previous scan. Recent
+    extractions are held in a CorrelationGrid.
+
    \ingroup Algorithms
 */
 class TrackInitiator : public Algorithm {
@@ -48,25 +49,15 @@ private:
 
     using Extraction = SideCar::Messages::Extraction;
 
-    struct Data {
-        Data(const Messages::Extraction& extraction) :
-            when_(extraction.getWhen().asDouble()), extraction_(extraction), velocity_()
-        {
-        }
-        double when_;
-        Messages::Extraction extraction_;
-        Messages::Track::Coord velocity_;
-    };
+    /** Correlate an extraction with those of earlier scans, and add it to the grid.
 
-    using Entry = std::list<Data>;
-    std::vector<std::vector<Entry>> buffer_; // [x][y]
-    size_t indexOffset_;
+        \param ext the extraction to correlate. Its correlation flag and count are updated.
 
-    void corrCell(Data&, Entry& candidates);
-    void corr(Data&);
+        \param velocity set to the point-to-point velocity from the matching extraction, if there was one
+    */
+    void corr(Extraction& ext, Messages::Track::Coord& velocity);
 
-    double rMax_;
-    size_t numBins_;
+    CorrelationGrid grid_;
 
     Parameter::DoubleValue::Ref param_searchRadius;
 
@@ -78,9 +69,6 @@ private:
 
     Parameter::IntValue::Ref param_numScans;
 
-    float searchRadius_;  // the maximum gating size for correlation to occur
-    float searchRadius2_; // = searchRadius^2
-
     Parameter::DoubleValue::Ref param_assumedAltitude;
     Parameter::DoubleValue::Ref param_minRange;
 
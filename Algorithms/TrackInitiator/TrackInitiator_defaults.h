@@ -0,0 +1,4 @@
+static const int kDefaultNumScans = 2;
+static const double kDefaultSearchRadius = 5;
+static const double kDefaultMinRange = 10;
+static const double kDefaultAssumedAltitude = 7620;
@@ -234,6 +234,10 @@
     insertion operations. As a result, log messages below the reporting level of the algorithm's log device
     incur very little overhead. Feel free to instrument your algorithm code with copious amounts of LOGDEBUG and
     LOGINFO statements without worry. Normal SideCar behavior is to only emit log messages at kWarning or above.
+    The procedural log device does not look up its own log device until the algorithm's log device (or one of
+    its children) accepts a message, so a non-static one costs almost nothing in a routine that runs for every
+    message. A build configured with \c -DSIDECAR_MIN_LOG_LEVEL=warning removes the more verbose statements
+    entirely.
 */
 
 namespace SideCar {
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cstring>
+
+#include "BlobLabeler.h"
+
+using namespace SideCar::Algorithms::ExtractWithCentroidingUtils;
+
+BlobLabeler::BlobLabeler() :
+    blobs_(), freeBlobs_(), runs_(), freeRuns_(), previous_(), current_(), open_(), closed_(), roots_(), row_(0),
+    az_(0.0), nextOrder_(0), maxRowDepth_(0)
+{
+}
+
+void
+BlobLabeler::reset()
+{
+    blobs_.clear();
+    freeBlobs_.clear();
+    runs_.clear();
+    freeRuns_.clear();
+    previous_.clear();
+    current_.clear();
+    open_.clear();
+    closed_.clear();
+    maxRowDepth_ = 0;
+}
+
+int
+BlobLabeler::allocateBlob()
+{
+    if (freeBlobs_.empty()) {
+        blobs_.push_back(Blob());
+        return blobs_.size() - 1;
+    }
+
+    int index = freeBlobs_.back();
+    freeBlobs_.pop_back();
+    return index;
+}
+
+int
+BlobLabeler::allocateRun()
+{
+    if (freeRuns_.empty()) {
+        runs_.push_back(Run());
+        return runs_.size() - 1;
+    }
+
+    int index = freeRuns_.back();
+    freeRuns_.pop_back();
+    return index;
+}
+
+int
+BlobLabeler::find(int blob)
+{
+    // Merges only happen within a PRI, and all labels are resolved at the end of each PRI, so the chains are
+    // short. Halve them anyway as we go.
+    //
+    while (blobs_[blob].parent != blob) {
+        int parent = blobs_[blob].parent;
+        blobs_[blob].parent = blobs_[parent].parent;
+        blob = parent;
+    }
+
+    return blob;
+}
+
+void
+BlobLabeler::addRun(int blob, RANGEBIN start, RANGEBIN stop)
+{
+    int index = allocateRun();
+    Run& run(runs_[index]);
+    run.start = start;
+    run.stop = stop;
+    run.row = row_;
+    run.az = az_;
+    run.next = kNone;
+
+    Blob& b(blobs_[blob]);
+    runs_[b.tail].next = index;
+    b.tail = index;
+    if (b.lastRow != row_) {
+        b.lastRow = row_;
+        b.lastAz = az_;
+        b.rowMin = start;
+        b.rowMax = stop;
+    } else {
+        b.rowMin = std::min(b.rowMin, start);
+        b.rowMax = std::max(b.rowMax, stop);
+    }
+
+    b.minRange = std::min(b.minRange, start);
+    b.maxRange = std::max(b.maxRange, stop);
+    current_.push_back(Span{start, stop, blob});
+}
+
+void
+BlobLabeler::labelRun(RANGEBIN start, RANGEBIN stop, size_t& firstSpan)
+{
+    // Skip the spans of the previous PRI that end before this run begins, less one for the diagonal neighbour.
+    // The spans that remain may also touch the next run, so leave firstSpan at the first of them.
+    //
+    while (firstSpan < previous_.size() && previous_[firstSpan].stop < start - 1) ++firstSpan;
+
+    roots_.clear();
+    for (size_t index = firstSpan; index < previous_.size() && previous_[index].start <= stop + 1; ++index) {
+        int root = find(previous_[index].blob);
+        if (std::find(roots_.begin(), roots_.end(), root) == roots_.end()) roots_.push_back(root);
+    }
+
+    if (roots_.empty()) {
+        // Start a new blob. Use the run itself as the chain head to avoid a special case in addRun().
+        //
+        int blob = allocateBlob();
+        int index = allocateRun();
+        Run& run(runs_[index]);
+        run.start = start;
+        run.stop = stop;
+        run.row = row_;
+        run.az = az_;
+        run.next = kNone;
+
+        Blob& b(blobs_[blob]);
+        b.parent = blob;
+        b.merged = false;
+        b.order = nextOrder_++;
+        b.firstRow = b.lastRow = row_;
+        b.firstAz = b.lastAz = az_;
+        b.minRange = b.rowMin = start;
+        b.maxRange = b.rowMax = stop;
+        b.head = b.tail = index;
+        open_.push_back(blob);
+        current_.push_back(Span{start, stop, blob});
+        return;
+    }
+
+    int master = roots_[0];
+    if (roots_.size() > 1) {
+        // Merge into the oldest blob, which is what ImageSegmentation keeps. The merged blob moves to the end of
+        // ImageSegmentation's open target list.
+        //
+        for (size_t index = 1; index < roots_.size(); ++index) {
+            if (blobs_[roots_[index]].firstRow < blobs_[master].firstRow) master = roots_[index];
+        }
+
+        Blob& m(blobs_[master]);
+        for (size_t index = 0; index < roots_.size(); ++index) {
+            int other = roots_[index];
+            if (other == master) continue;
+            Blob& o(blobs_[other]);
+            o.parent = master;
+            o.merged = true;
+            m.minRange = std::min(m.minRange, o.minRange);
+            m.maxRange = std::max(m.maxRange, o.maxRange);
+            if (o.lastRow == row_) {
+                if (m.lastRow == row_) {
+                    m.rowMin = std::min(m.rowMin, o.rowMin);
+                    m.rowMax = std::max(m.rowMax, o.rowMax);
+                } else {
+                    m.lastRow = row_;
+                    m.lastAz = az_;
+                    m.rowMin = o.rowMin;
+                    m.rowMax = o.rowMax;
+                }
+            }
+
+            runs_[m.tail].next = o.head;
+            m.tail = o.tail;
+        }
+
+        m.order = nextOrder_++;
+    }
+
+    addRun(master, start, stop);
+}
+
+void
+BlobLabeler::appendRow(const BINARYDATA* data, size_t size, AZIMUTH az, TargetSize discardSize)
+{
+    ++row_;
+    az_ = az;
+    current_.clear();
+
+    // Run-length encode the PRI and label each run as it is found.
+    //
+    size_t firstSpan = 0;
+    size_t index = 0;
+    while (index < size) {
+        while (index < size && !data[index]) ++index;
+        if (index == size) break;
+        size_t start = index;
+        while (index < size && data[index]) ++index;
+        labelRun(RANGEBIN(start), RANGEBIN(index - 1), firstSpan);
+    }
+
+    // Resolve the labels of this PRI before any merged blob records are released.
+    //
+    for (size_t span = 0; span < current_.size(); ++span) current_[span].blob = find(current_[span].blob);
+
+    // Finish the blobs that gained runs, and close the rest.
+    //
+    maxRowDepth_ = 0;
+    size_t closedBegin = closed_.size();
+    size_t kept = 0;
+    for (size_t pos = 0; pos < open_.size(); ++pos) {
+        int blob = open_[pos];
+        Blob& b(blobs_[blob]);
+        if (b.merged) {
+            freeBlobs_.push_back(blob);
+            continue;
+        }
+
+        if (b.lastRow != row_) {
+            closed_.push_back(blob);
+            continue;
+        }
+
+        if (makeSize(b) > discardSize) truncate(b);
+        maxRowDepth_ = std::max(maxRowDepth_, PRI_COUNT(row_ - b.firstRow + 1));
+        open_[kept++] = blob;
+    }
+
+    open_.resize(kept);
+    sortClosed(closedBegin);
+    previous_.swap(current_);
+}
+
+void
+BlobLabeler::closeAll()
+{
+    size_t closedBegin = closed_.size();
+    closed_.insert(closed_.end(), open_.begin(), open_.end());
+    open_.clear();
+    previous_.clear();
+    sortClosed(closedBegin);
+    maxRowDepth_ = 0;
+}
+
+void
+BlobLabeler::sortClosed(size_t begin)
+{
+    // ImageSegmentation appends closed targets in the order of its open target list, which is the order in which
+    // they were created or last merged.
+    //
+    struct ByOrder {
+        const std::vector<Blob>& blobs;
+        bool operator()(int lhs, int rhs) const { return blobs[lhs].order < blobs[rhs].order; }
+    };
+
+    std::sort(closed_.begin() + begin, closed_.end(), ByOrder{blobs_});
+}
+
+void
+BlobLabeler::truncate(Blob& b)
+{
+    int head = kNone;
+    int tail = kNone;
+    for (int index = b.head; index != kNone;) {
+        int next = runs_[index].next;
+        if (runs_[index].row == b.lastRow) {
+            runs_[index].next = kNone;
+            if (tail == kNone) {
+                head = index;
+            } else {
+                runs_[tail].next = index;
+            }
+
+            tail = index;
+        } else {
+            freeRuns_.push_back(index);
+        }
+
+        index = next;
+    }
+
+    b.head = head;
+    b.tail = tail;
+    b.firstRow = b.lastRow;
+    b.firstAz = b.lastAz;
+    b.minRange = b.rowMin;
+    b.maxRange = b.rowMax;
+}
+
+void
+BlobLabeler::release(int blob)
+{
+    for (int index = blobs_[blob].head; index != kNone; index = runs_[index].next) freeRuns_.push_back(index);
+    freeBlobs_.push_back(blob);
+}
+
+TargetSize
+BlobLabeler::makeSize(const Blob& b) const
+{
+    TargetSize size;
+    size.minRange = b.minRange;
+    size.maxRange = b.maxRange;
+    size.minAz = b.firstAz;
+    size.maxAz = b.lastAz;
+    size.priCount = PRI_COUNT(b.lastRow - b.firstRow + 1);
+    size.maxRangeValid = true;
+    size.minRangeValid = true;
+    size.minAzValid = true;
+    size.maxAzValid = true;
+    size.priValid = true;
+    return size;
+}
+
+TargetSize
+BlobLabeler::getClosedSize() const
+{
+    return makeSize(blobs_[closed_.back()]);
+}
+
+BinaryTargetImagePtr
+BlobLabeler::makeClosedImage(Logger::Log& log) const
+{
+    const Blob& b(blobs_[closed_.back()]);
+    RANGEBIN cols = b.maxRange - b.minRange + 1;
+    PRI_COUNT rows = PRI_COUNT(b.lastRow - b.firstRow + 1);
+
+    BINARYDATA* data = new BINARYDATA[rows * cols];
+    ::memset(data, 0x00, sizeof(BINARYDATA) * rows * cols);
+
+    AzimuthDataPtr az(new AzimuthData(rows));
+    for (int index = b.head; index != kNone; index = runs_[index].next) {
+        const Run& run(runs_[index]);
+        PRI_COUNT row = PRI_COUNT(run.row - b.firstRow);
+        ::memset(data + row * cols + run.start - b.minRange, 0x01, sizeof(BINARYDATA) * (run.stop - run.start + 1));
+        (*az)[row] = run.az;
+    }
+
+    return BinaryTargetImagePtr(new BinaryTargetImage(b.minRange, b.maxRange, az, data, log));
+}
+
+void
+BlobLabeler::popClosed()
+{
+    release(closed_.back());
+    closed_.pop_back();
+}
@@ -0,0 +1,172 @@
+#ifndef SIDECAR_ALGORITHMS_EXTRACTWITHCENTROIDINGUTILS_BLOBLABELER_H // -*- C++ -*-
+#define SIDECAR_ALGORITHMS_EXTRACTWITHCENTROIDINGUTILS_BLOBLABELER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ImageDataTypes.h"
+#include "TargetImage.h"
+#include "TargetSize.h"
+
+namespace SideCar {
+namespace Algorithms {
+namespace ExtractWithCentroidingUtils {
+
+/** Streaming connected-component labeller for binary video. Each PRI is run-length encoded as it arrives, and
+    its runs are joined to the 8-connected runs of the previous PRI with a union-find over blob records. A blob
+    that gains no runs from a PRI is closed and becomes available through the closed-blob interface below; its
+    extent is kept up to date as runs arrive, so closing it costs nothing extra.
+
+    Blobs and runs live in pools of contiguous records that are recycled as blobs close, so once the pools have
+    grown to their working size, appendRow() does no memory allocation.
+
+    This produces the same blobs, in the same order, as ImageSegmentation::AppendScanLine, including the
+    truncation of blobs that grow larger than a discard size.
+*/
+class BlobLabeler {
+public:
+    /** Constructor.
+     */
+    BlobLabeler();
+
+    /** Forget all open and closed blobs.
+     */
+    void reset();
+
+    /** Label the detections of the next PRI.
+
+        \param data binary values for each range bin of the PRI
+
+        \param size number of range bins
+
+        \param az azimuth of the PRI
+
+        \param discardSize blobs larger than this are truncated to their last row
+    */
+    void appendRow(const BINARYDATA* data, size_t size, AZIMUTH az, TargetSize discardSize = TargetSize());
+
+    /** Close all open blobs.
+     */
+    void closeAll();
+
+    /** \return true if there are no closed blobs
+     */
+    bool isClosedEmpty() const { return closed_.empty(); }
+
+    /** \return extent of the most recently closed blob
+     */
+    TargetSize getClosedSize() const;
+
+    /** Create a binary image of the most recently closed blob. Rows are in PRI order, and the image spans the
+        range extent of the blob.
+
+        \param log device used for log messages by the image
+
+        \return new image
+    */
+    BinaryTargetImagePtr makeClosedImage(Logger::Log& log) const;
+
+    /** Release the most recently closed blob.
+     */
+    void popClosed();
+
+    /** \return the number of PRIs spanned by the largest open blob
+     */
+    PRI_COUNT getMaxRowDepth() const { return maxRowDepth_; }
+
+    /** \return number of open blobs
+     */
+    size_t getOpenCount() const { return open_.size(); }
+
+private:
+    enum { kNone = -1 };
+
+    /** A run of detections in one PRI. Runs of a blob are chained together through next.
+     */
+    struct Run {
+        RANGEBIN start;
+        RANGEBIN stop;
+        int64_t row;
+        AZIMUTH az;
+        int next;
+    };
+
+    /** Blob record. A blob merged into another during the current PRI points to it through parent; all other
+        blobs are their own parents.
+    */
+    struct Blob {
+        int parent;
+        bool merged;
+        uint64_t order;   ///< Position in ImageSegmentation's open target list
+        int64_t firstRow; ///< First PRI of the blob
+        int64_t lastRow;  ///< Last PRI with a run in the blob
+        AZIMUTH firstAz;
+        AZIMUTH lastAz;
+        RANGEBIN minRange;
+        RANGEBIN maxRange;
+        RANGEBIN rowMin; ///< Minimum range of the runs in lastRow
+        RANGEBIN rowMax; ///< Maximum range of the runs in lastRow
+        int head;        ///< First run in the chain
+        int tail;        ///< Last run in the chain
+    };
+
+    /** A run in the previous or current PRI and the blob it belongs to.
+     */
+    struct Span {
+        RANGEBIN start;
+        RANGEBIN stop;
+        int blob;
+    };
+
+    int allocateBlob();
+
+    int allocateRun();
+
+    int find(int blob);
+
+    /** Add a run of the current PRI to a blob.
+     */
+    void addRun(int blob, RANGEBIN start, RANGEBIN stop);
+
+    /** Join the runs of the previous PRI that touch [start, stop] with a new run.
+     */
+    void labelRun(RANGEBIN start, RANGEBIN stop, size_t& firstSpan);
+
+    /** Keep only the runs of the last row of a blob.
+     */
+    void truncate(Blob& blob);
+
+    /** Return the runs and record of a blob to the pools.
+     */
+    void release(int blob);
+
+    /** Move blobs closed by the current PRI to closed_ in ImageSegmentation order.
+     */
+    void sortClosed(size_t begin);
+
+    TargetSize makeSize(const Blob& blob) const;
+
+    std::vector<Blob> blobs_;
+    std::vector<int> freeBlobs_;
+    std::vector<Run> runs_;
+    std::vector<int> freeRuns_;
+    std::vector<Span> previous_;
+    std::vector<Span> current_;
+    std::vector<int> open_;
+    std::vector<int> closed_;
+    std::vector<int> roots_;
+    int64_t row_;
+    AZIMUTH az_;
+    uint64_t nextOrder_;
+    PRI_COUNT maxRowDepth_;
+};
+
+} // end namespace ExtractWithCentroidingUtils
+} // end namespace Algorithms
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
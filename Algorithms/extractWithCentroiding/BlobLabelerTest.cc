@@ -0,0 +1,280 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "Logger/Log.h"
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "BlobLabeler.h"
+#include "ImageSegmentation.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms::ExtractWithCentroidingUtils;
+
+// Count heap allocations so that we can compare the allocation rates of ImageSegmentation and BlobLabeler.
+//
+static size_t allocations_ = 0;
+
+void*
+operator new(size_t size)
+{
+    ++allocations_;
+    void* ptr = ::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+    ::free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t) noexcept
+{
+    ::free(ptr);
+}
+
+struct Test : public UnitTest::TestObj {
+    enum { kNumGates = 2048, kNumPRIs = 4096 };
+
+    Test() : UnitTest::TestObj("BlobLabeler") {}
+
+    void test();
+
+    /** A shape that drifts in range from PRI to PRI.
+     */
+    struct Shape {
+        double center;
+        double drift;
+        int width;
+        int rowsLeft;
+    };
+
+    /** Generate a binary image with noise, drifting shapes that cross and merge, and wide clutter that exceeds the
+        discard size.
+    */
+    static void MakeImage(std::vector<std::vector<BINARYDATA>>& image);
+
+    void testExample();
+
+    /** Run an image through ImageSegmentation and BlobLabeler, and verify that they close the same targets in the
+        same order.
+
+        \param image rows of binary data
+
+        \param az0 azimuth of the first row
+
+        \param discardSize size beyond which targets are truncated
+    */
+    void compare(const std::vector<std::vector<BINARYDATA>>& image, AZIMUTH az0, const TargetSize& discardSize);
+
+    void compareClosed(ImageSegmentation& is, BlobLabeler& labeler, size_t& count);
+
+    void testWrap();
+};
+
+void
+Test::MakeImage(std::vector<std::vector<BINARYDATA>>& image)
+{
+    ::srand(271828);
+    std::vector<Shape> shapes;
+    image.assign(kNumPRIs, std::vector<BINARYDATA>(kNumGates, 0));
+    for (int row = 0; row < kNumPRIs; ++row) {
+        std::vector<BINARYDATA>& line(image[row]);
+        for (int gate = 0; gate < kNumGates; ++gate) {
+            if (::rand() % 100 < 3) line[gate] = 1;
+        }
+
+        if (::rand() % 4 == 0) {
+            Shape shape;
+            shape.center = ::rand() % kNumGates;
+            shape.drift = (::rand() % 5 - 2) * 0.5;
+            shape.width = ::rand() % 100 < 5 ? 300 : 1 + ::rand() % 12;
+            shape.rowsLeft = 1 + ::rand() % 80;
+            shapes.push_back(shape);
+        }
+
+        for (size_t index = 0; index < shapes.size();) {
+            Shape& shape(shapes[index]);
+            int begin = std::max(0, int(shape.center) - shape.width / 2);
+            int end = std::min(int(kNumGates), int(shape.center) + shape.width / 2 + 1);
+            for (int gate = begin; gate < end; ++gate) line[gate] = 1;
+            shape.center += shape.drift;
+            if (--shape.rowsLeft == 0 || shape.center < 0 || shape.center >= kNumGates) {
+                shapes[index] = shapes.back();
+                shapes.pop_back();
+            } else {
+                ++index;
+            }
+        }
+    }
+}
+
+void
+Test::compareClosed(ImageSegmentation& is, BlobLabeler& labeler, size_t& count)
+{
+    while (!is.IsClosedTargetsEmpty()) {
+        assertFalse(labeler.isClosedEmpty());
+        SegmentedTargetImagePtr target = is.PopClosedTarget();
+        TargetSize expected = target->GetSize();
+        TargetSize actual = labeler.getClosedSize();
+        assertEqual(expected.minRange, actual.minRange);
+        assertEqual(expected.maxRange, actual.maxRange);
+        assertEqual(expected.minAz, actual.minAz);
+        assertEqual(expected.maxAz, actual.maxAz);
+        assertEqual(expected.priCount, actual.priCount);
+
+        // Compare the images of the larger targets, which are the ones that get centroided.
+        //
+        if (expected.priCount > 2 || expected.RangeExtent() > 2) {
+            BinaryTargetImagePtr expectedImage = target->MakeBinaryTargetImage();
+            BinaryTargetImagePtr actualImage = labeler.makeClosedImage(Logger::Log::Root());
+            int size = expectedImage->GetRows() * expectedImage->GetCols();
+            assertEqual(size, actualImage->GetRows() * actualImage->GetCols());
+            bool same = std::equal(expectedImage->GetDataRef(), expectedImage->GetDataRef() + size,
+                                   actualImage->GetDataRef());
+            assertTrue(same);
+            assertTrue(*expectedImage->GetAzimuthData() == *actualImage->GetAzimuthData());
+        }
+
+        labeler.popClosed();
+        ++count;
+    }
+
+    assertTrue(labeler.isClosedEmpty());
+}
+
+void
+Test::compare(const std::vector<std::vector<BINARYDATA>>& image, AZIMUTH az0, const TargetSize& discardSize)
+{
+    ImageSegmentation is(Logger::Log::Root());
+    BlobLabeler labeler;
+    AZIMUTH azStep = 2.0 * M_PI / 4096;
+    size_t count = 0;
+    for (size_t row = 0; row < image.size(); ++row) {
+        AZIMUTH az = ::fmod(az0 + row * azStep, 2.0 * M_PI);
+        const std::vector<BINARYDATA>& line(image[row]);
+        is.AppendScanLine(BinaryScanLineArray(const_cast<BINARYDATA*>(&line[0]), line.size()), az, discardSize);
+        labeler.appendRow(&line[0], line.size(), az, discardSize);
+        assertEqual(is.GetMaxRowDepth(), labeler.getMaxRowDepth());
+        compareClosed(is, labeler, count);
+    }
+
+    is.CloseAllOpenTargets();
+    labeler.closeAll();
+    compareClosed(is, labeler, count);
+    assertTrue(count > 0);
+
+    // Time each implementation on its own, counting allocations while popping the closed targets as
+    // ExtractWithCentroiding does.
+    //
+    size_t before = allocations_;
+    Time::TimeStamp begin(Time::TimeStamp::Now());
+    {
+        ImageSegmentation is(Logger::Log::Root());
+        for (size_t row = 0; row < image.size(); ++row) {
+            const std::vector<BINARYDATA>& line(image[row]);
+            is.AppendScanLine(BinaryScanLineArray(const_cast<BINARYDATA*>(&line[0]), line.size()), az0,
+                              discardSize);
+            while (!is.IsClosedTargetsEmpty()) is.PopClosedTarget()->GetSize();
+        }
+    }
+
+    Time::TimeStamp oldDelta(Time::TimeStamp::Now());
+    oldDelta -= begin;
+    size_t oldAllocations = allocations_ - before;
+
+    before = allocations_;
+    begin = Time::TimeStamp::Now();
+    {
+        BlobLabeler labeler;
+        for (size_t row = 0; row < image.size(); ++row) {
+            const std::vector<BINARYDATA>& line(image[row]);
+            labeler.appendRow(&line[0], line.size(), az0, discardSize);
+            for (; !labeler.isClosedEmpty(); labeler.popClosed()) labeler.getClosedSize();
+        }
+    }
+
+    Time::TimeStamp newDelta(Time::TimeStamp::Now());
+    newDelta -= begin;
+    size_t newAllocations = allocations_ - before;
+
+    std::clog << "targets: " << count << " ImageSegmentation: " << oldDelta.asDouble() / image.size()
+              << " sec/PRI " << double(oldAllocations) / image.size() << " allocs/PRI"
+              << " BlobLabeler: " << newDelta.asDouble() / image.size() << " sec/PRI "
+              << double(newAllocations) / image.size() << " allocs/PRI" << std::endl;
+
+    assertTrue(newAllocations < oldAllocations);
+}
+
+void
+Test::testExample()
+{
+    // The image from blobDebug, which has merges, diagonal neighbours, and U-shaped targets.
+    //
+    static const int kRows = 14;
+    static const int kCols = 11;
+    static const BINARYDATA pris[kRows][kCols] = {
+        {0, 1, 0, 1, 1, 1, 0, 0, 0, 0, 0}, {0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 0}, {0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1},
+        {0, 0, 1, 1, 0, 0, 0, 0, 1, 0, 0}, {0, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0}, {0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0},
+        {0, 1, 1, 1, 1, 1, 1, 0, 0, 1, 0}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0}, {0, 1, 0, 1, 1, 1, 1, 1, 0, 1, 0},
+        {0, 1, 0, 1, 0, 0, 0, 1, 0, 1, 0}, {0, 1, 1, 1, 0, 1, 0, 1, 1, 1, 0}, {0, 1, 0, 0, 0, 0, 1, 0, 0, 1, 0},
+        {0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0}, {0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0}};
+
+    std::vector<std::vector<BINARYDATA>> image;
+    for (int row = 0; row < kRows; ++row) image.push_back(std::vector<BINARYDATA>(pris[row], pris[row] + kCols));
+    compare(image, 0.0, TargetSize());
+}
+
+void
+Test::testWrap()
+{
+    // A target that crosses north has its center on the correct side.
+    //
+    TargetSize size;
+    size.minAz = 2.0 * M_PI - 0.1;
+    size.maxAz = 0.05;
+    size.minRange = 10;
+    size.maxRange = 20;
+    TargetPosition pos = size.Center();
+    assertEqualEpsilon(2.0 * M_PI - 0.025, pos.az, 1.0E-5);
+    assertEqual(15, pos.range);
+
+    size.minAz = 0.1;
+    size.maxAz = 0.3;
+    assertEqualEpsilon(0.2, size.Center().az, 1.0E-6);
+}
+
+void
+Test::test()
+{
+    Logger::Log::Root().setPriorityLimit(Logger::Priority::kError);
+    testWrap();
+    testExample();
+
+    std::vector<std::vector<BINARYDATA>> image;
+    MakeImage(image);
+
+    // No discards, and then a discard size that truncates the wide clutter. Start just before north so that
+    // targets straddle the wrap.
+    //
+    compare(image, 2.0 * M_PI - 0.3, TargetSize());
+
+    TargetSize discardSize;
+    discardSize.maxRange = 150;
+    discardSize.maxRangeValid = true;
+    discardSize.maxAz = 0.02;
+    discardSize.maxAzValid = true;
+    compare(image, 2.0 * M_PI - 0.3, discardSize);
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return Test().mainRun();
+}
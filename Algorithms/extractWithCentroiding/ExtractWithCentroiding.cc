@@ -19,7 +19,7 @@ using namespace SideCar::Algorithms;
 using namespace SideCar::Messages;
 
 ExtractWithCentroiding::ExtractWithCentroiding(Controller& controller, Logger::Log& log) :
-    Algorithm(controller, log), m_is(log), m_videoHistory(log),
+    Algorithm(controller, log), m_labeler(), m_videoHistory(log),
     m_centroidRangeMin(Parameter::DoubleValue::Make("centroidRangeMin", "Centroid Range Min (km)", 7.0)),
     m_centroidAzMin(Parameter::DoubleValue::Make("centroidAzMin", "Centroid Az Min (rad)", 0.30)),
     m_discardRangeMin(Parameter::DoubleValue::Make("discardRangeMin", "Discard Range Min (km)", 120.0)),
@@ -63,21 +63,20 @@ ExtractWithCentroiding::process(const Messages::BinaryVideo::Ref& msg)
     // create a vector for extractions
     Messages::Extractions::Ref extractions;
 
-    // process the binary data to update image segmentation (i.e., target
-    // detection)
-    m_is.AppendScanLine(BinaryScanLineVector(&(msg->getData())), msg->getAzimuthStart(), minDiscardTargetSize);
+    // label the binary data (i.e., target detection)
+    const BinaryVideo::Container& binary(msg->getData());
+    m_labeler.appendRow(binary.empty() ? 0 : &binary[0], binary.size(), msg->getAzimuthStart(),
+                        minDiscardTargetSize);
 
     // process the video data (i.e., just store it for later use)
     m_videoHistory.Append(video->getData());
 
     // process every target that is complete (i.e., ready for extraction and
     // further processing)
-    while (!m_is.IsClosedTargetsEmpty()) {
+    for (; !m_labeler.isClosedEmpty(); m_labeler.popClosed()) {
         if (!extractions) extractions = Messages::Extractions::Make("Extract", msg);
 
-        SegmentedTargetImagePtr target = m_is.PopClosedTarget();
-
-        TargetSize size = target->GetSize();
+        TargetSize size = m_labeler.getClosedSize();
 
         if (!(size > minCentroidSize)) { // notice, this is not the same as size < minCentroidSize
 
@@ -97,7 +96,7 @@ ExtractWithCentroiding::process(const Messages::BinaryVideo::Ref& msg)
             LOGDEBUG << "centroiding a target:" << size << " dRange=" << msg->getRangeAt(size.RangeExtent())
                      << std::endl;
 
-            BinaryTargetImagePtr mask = target->MakeBinaryTargetImage();
+            BinaryTargetImagePtr mask = m_labeler.makeClosedImage(getLog());
             VideoTargetImagePtr video = m_videoHistory.GetWindow(size);
             video->SetAzimuthData(mask->GetAzimuthData());
 
@@ -120,7 +119,7 @@ ExtractWithCentroiding::process(const Messages::BinaryVideo::Ref& msg)
     }
 
     // discard any un-need video data
-    m_videoHistory.SetDepth(m_is.GetMaxRowDepth());
+    m_videoHistory.SetDepth(m_labeler.getMaxRowDepth());
 
     // publish the targets
     bool rc = true;
@@ -4,7 +4,7 @@
 #include "boost/shared_ptr.hpp"
 
 #include "Algorithms/Algorithm.h"
-#include "ImageSegmentation.h"
+#include "BlobLabeler.h"
 #include "Messages/BinaryVideo.h"
 #include "Parameter/Parameter.h"
 #include "VideoStorage.h"
@@ -12,6 +12,10 @@
 namespace SideCar {
 namespace Algorithms {
 
+/** Extracts targets from binary video. Connected groups of detections are found as PRIs arrive by an
+    ExtractWithCentroidingUtils::BlobLabeler. Small groups are reported at their center; larger ones are handed
+    to a Centroid object along with the matching window of video to locate the peaks within them.
+*/
 class ExtractWithCentroiding : public Algorithm {
 public:
     ExtractWithCentroiding(Controller& controller, Logger::Log& log);
@@ -21,7 +25,7 @@ public:
 private:
     bool process(const Messages::BinaryVideo::Ref& msg);
 
-    ImageSegmentation m_is;
+    ExtractWithCentroidingUtils::BlobLabeler m_labeler;
     VideoStorage m_videoHistory;
 
     Parameter::DoubleValue::Ref m_centroidRangeMin;
@@ -110,6 +110,11 @@ SegmentedTargetImage::Merge(TargetVector& mergers, RANGEBIN start, RANGEBIN stop
             }
             // if this is the "next" row, then update the references in teh nextMap
             masterIm->m_currentRow.Merge(mergers[i]->m_currentRow, &nextMap, &masterIm);
+
+            // the merged rows may extend beyond the master's range
+            if (mergers[i]->m_minRangeValid) {
+                masterIm->UpdateMinMaxRanges(mergers[i]->m_minRange, mergers[i]->m_maxRange);
+            }
         }
     }
 
@@ -69,9 +69,15 @@ public:
 
     TargetPosition Center() const
     {
-        // determine the geometric center of the target's size
+        // determine the geometric center of the target's size. a target that crosses north has minAz > maxAz,
+        //  so measure half the extent from minAz and wrap the result.
         TargetPosition pos;
-        pos.az = (minAz + maxAz) / (AZIMUTH)2;
+        if (minAz <= maxAz) {
+            pos.az = (minAz + maxAz) / (AZIMUTH)2;
+        } else {
+            pos.az = minAz + AZIMUTH_EXTENT(minAz, maxAz) / (AZIMUTH)2;
+            if (pos.az >= (AZIMUTH)(2 * M_PI)) pos.az -= (AZIMUTH)(2 * M_PI);
+        }
         pos.range = (minRange + maxRange) / (RANGEBIN)2;
         return pos;
     }
@@ -25,19 +25,32 @@ public:
 
     void Append(VideoScanLineVector& vid)
     {
-        // the front of the deque has the most recent scan
-        m_video.push_front(vid);
+        // the front of the deque has the most recent scan. reuse the storage of a released scan if there is one.
+        m_video.push_front(VideoScanLineVector());
+        if (!m_spare.empty()) {
+            m_video.front().swap(m_spare.back());
+            m_spare.pop_back();
+        }
+        m_video.front().assign(vid.begin(), vid.end());
     }
 
     void SetDepth(PRI_COUNT maxNeededDepth)
     {
-        // remove the least recent scans
-        m_video.resize(maxNeededDepth);
+        // remove the least recent scans, keeping their storage for Append
+        while ((PRI_COUNT)m_video.size() > maxNeededDepth) {
+            m_spare.push_back(VideoScanLineVector());
+            m_spare.back().swap(m_video.back());
+            m_video.pop_back();
+        }
     }
 
     PRI_COUNT GetDepth() { return m_video.size(); }
 
-    void Clear() { m_video.clear(); }
+    void Clear()
+    {
+        m_video.clear();
+        m_spare.clear();
+    }
 
     VideoScanLineVector* GetPRI(PRI_COUNT pri)
     {
@@ -82,6 +95,9 @@ private:
     Logger::Log& log;
 
     std::deque<VideoScanLineVector> m_video;
+
+    // m_spare holds the storage of released scans
+    std::vector<VideoScanLineVector> m_spare;
 };
 
 /** \file
@@ -1,50 +1,36 @@
 #ifndef SIDECAR_ALGORITHMS_FILTER_H // -*- C++ -*-
 #define SIDECAR_ALGORITHMS_FILTER_H
 
-#include "boost/shared_ptr.hpp"
-#include <complex>
 #include <istream>
 #include <vector>
 
-#define VSIP_IMPL_FFTW3 1
-#include <vsip/math.hpp>
-#include <vsip/signal.hpp>
-#include <vsip/vector.hpp>
-
 #include "Algorithms/Algorithm.h"
+#include "Algorithms/Convolver.h"
 #include "Algorithms/extractWithCentroiding/ImageDataTypes.h"
 #include "Messages/PRIMessage.h"
 #include "Parameter/Parameter.h"
 
-#define USE_FAST_CONVOLUTION
-
 namespace SideCar {
 namespace Algorithms {
 
-/** Filter algorithm.
- */
+/** Filter algorithm. Applies a 2-D kernel over range and time, read from a CSV file whose first line holds the
+    number of rows and columns of the kernel, followed by one line of values per row.
+
+    The filter keeps the last N PRIs, where N is the number of kernel rows. The output for a PRI is the sum over
+    the kernel rows of the range convolution of a row with one of the kept PRIs: the last kernel row applies to
+    the newest PRI, the one before it to the previous PRI, and so on. The range convolution is centered on the
+    middle column of the kernel, and samples outside of a PRI are taken to be zero. Until N PRIs have arrived,
+    the missing ones are also zero.
 
+    The convolution is done by a Convolver, which picks time-domain or FFT convolution from the kernel and PRI
+    sizes. The method in use and the time spent per PRI are reported in the status slots.
+*/
 class Filter : public Algorithm {
-    // Generally speaking, the filter class updates the m_priData
-    //  matrix in a ring buffer (fifo) that is dynamically sized
-    //  to match the kernel.  if USE_FAST_CONVOLUTION is not defined,
-    //  the convolution is done in the time domain.  because the m_priData
-    //  is "wrapped", the convolution is done with a similarlly wrapped kernel.
-    //  if USE_FAST_CONVOLUTION is defined, then the convolution
-    //  is done in the frequency domain via multiplication. since this
-    //  is actually circular convolution, the wrapping of the m_priData
-    //  is irrelevant.
-
-    // Notes on boundaries:
-    // 1) USE_FAST_CONVOLUTION not defined: only valid data is reported. the
-    //    output vector is the same size as the largest input pri, but zero
-    //    padded.
-    // 2) USE_FAST_CONVOLUTION is defined: the output vector is the same size
-    //    as the largest pri. however, because circular convolution is used,
-    //    the first and last portions of the vector (depending on the number of
-    //    columns in the kernel) depend on the last and first (respectively)
-    //    portions of the pri data.
 public:
+    using ComplexType = Convolver::ComplexType;
+
+    enum InfoSlots { kMethod = ControllerStatus::kNumSlots, kBlockSize, kCost, kNumSlots };
+
     Filter(Controller& controller, Logger::Log& log);
 
     void setKernelFilePath(const std::string& value) { m_kernelCSVFilename->setValue(value); }
@@ -58,59 +44,23 @@ public:
     RANGEBIN m_maxRangeBin;
     bool m_maxRangeBinValid;
 
-    using VideoMatrix = vsip::Matrix<VIDEODATA>;
-    using VideoMatrixPtr = boost::shared_ptr<VideoMatrix>;
-    using D2 = vsip::Domain<2>;
-    using D1 = vsip::Domain<1>;
-    using VideoDense = vsip::Dense<2, VIDEODATA>;
-    using VideoDensePtr = boost::shared_ptr<VideoDense>;
-
-#ifndef USE_FAST_CONVOLUTION
-public:
-    using ConvolveMatrix =
-        vsip::Convolution<vsip::const_Matrix, vsip::nonsym, vsip::support_min, float, 0, vsip::alg_space>;
-
-    using DataVector = vsip::Vector<float>;
-    using DataMatrix = vsip::Matrix<float>;
-    using DataMatrixPtr = boost::shared_ptr<DataMatrix>;
-    using DataMatrixPtrVector = std::vector<DataMatrixPtr>;
-
-private:
-    DataMatrixPtrVector m_wrappedKernels;
-    DataMatrixPtr m_scratch;
-
-#else
-public:
-    using FFTDATA = float;
-    using COMPLEXFFTDATA = std::complex<FFTDATA>;
-    using DataVector = vsip::Vector<COMPLEXFFTDATA>;
-    using DataMatrix = vsip::Matrix<COMPLEXFFTDATA>;
-    using DataMatrixPtr = boost::shared_ptr<DataMatrix>;
-    using FFT = vsip::Fft<vsip::const_Matrix, COMPLEXFFTDATA, COMPLEXFFTDATA, vsip::fft_fwd, vsip::by_reference>;
-    using IFFT = vsip::Fft<vsip::const_Matrix, COMPLEXFFTDATA, COMPLEXFFTDATA, vsip::fft_inv, vsip::by_reference>;
-    using FFTPtr = boost::shared_ptr<FFT>;
-    using IFFTPtr = boost::shared_ptr<IFFT>;
-
 private:
-    DataMatrixPtr m_kernel;
-    DataMatrixPtr m_fftKernel;
-    DataMatrixPtr m_scratch;
-    FFTPtr m_fft;
-    IFFTPtr m_ifft;
+    size_t getNumInfoSlots() const { return kNumSlots; }
 
-#endif
+    void setInfoSlots(IO::StatusBase& status);
 
-private:
     bool process(const Messages::Video::Ref& inMsg);
 
     void loadKernel();
     void kernelCSVFilenameChanged(const Parameter::ReadPathValue& value);
-    DataMatrixPtr readCSV(std::istream& is);
+    bool readCSV(std::istream& is, std::vector<ComplexType>& taps, size_t& rows);
     void resizePriData();
-    void doInternalSetup(DataMatrixPtr kernel);
 
     Parameter::ReadPathValue::Ref m_kernelCSVFilename;
-    DataMatrixPtr m_priData;
+    Convolver m_convolver;
+    std::vector<std::vector<ComplexType>> m_priData;
+    std::vector<const ComplexType*> m_inputs;
+    std::vector<ComplexType> m_output;
     PRI_COUNT m_insertRow;
 };
 
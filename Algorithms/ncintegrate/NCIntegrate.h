@@ -5,6 +5,7 @@
 
 #include "Algorithms/Algorithm.h"
 #include "Algorithms/PastBuffer.h"
+#include "Algorithms/RunningSums.h"
 #include "Messages/Video.h"
 #include "Parameter/Parameter.h"
 
@@ -15,11 +16,12 @@ namespace Algorithms {
     It waits until it receives 'numPulses' pri's, after which it returns the average of the last 'numPulses'
     pri's at the output.
 
+    The sums of the retained PRIs are kept in a RunningSums object: each new PRI is added and the PRI that falls
+    out of the window is subtracted in the same pass, and the average is formed from the sums.
 */
 class NCIntegrate : public Algorithm {
 public:
     using DatumType = Messages::Video::DatumType;
-    using RunningAverageVector = std::vector<int32_t>;
 
     enum InfoSlot { kNumPRIs = ControllerStatus::kNumSlots, kIQValues, kNumSlots };
 
@@ -87,7 +89,7 @@ private:
     Parameter::BoolValue::Ref iqValues_;
     Parameter::PositiveIntValue::Ref numPulses_;
     PastBuffer<Messages::Video> in_;
-    RunningAverageVector runningAverage_;
+    RunningSums runningAverage_;
 };
 
 } // end namespace Algorithms
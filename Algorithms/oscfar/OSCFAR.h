@@ -50,6 +50,12 @@ public:
     */
     void setAlpha(double alpha) { alpha_->setValue(alpha); }
 
+    /** Each PRI is processed on its own, so replicas are safe.
+
+        \return true
+    */
+    bool isReplicaSafe() const { return true; }
+
 private:
     /** Obtain the number of info slots found in status messages from this algorithm.
 
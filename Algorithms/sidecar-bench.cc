@@ -0,0 +1,497 @@
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Algorithms/Controller.h"
+#include "IO/ClearStatsRequest.h"
+#include "IO/LatencyStats.h"
+#include "IO/MessageManager.h"
+#include "IO/ParametersChangeRequest.h"
+#include "IO/Stream.h"
+#include "Logger/Log.h"
+#include "Messages/BinaryVideo.h"
+#include "Messages/Complex.h"
+#include "Messages/Extraction.h"
+#include "Messages/RadarConfig.h"
+#include "Messages/Video.h"
+#include "Utils/CmdLineArgs.h"
+#include "Utils/HdrHistogram.h"
+#include "Utils/Utils.h"
+#include "XMLRPC/XmlRpcValue.h"
+
+using namespace SideCar;
+using namespace SideCar::Algorithms;
+using namespace SideCar::Messages;
+
+const std::string about = "Measure how fast an algorithm processes synthetic PRI messages, sweeping over gate counts "
+                          "and parameter sets. Writes throughput, processing time and latency percentiles, and "
+                          "allocation counts as JSON.";
+
+const Utils::CmdLineArgs::OptionDef options[] = {
+    {'t', "type", "input type: Video, BinaryVideo, Complex, or Extractions (Video)", "TYPE"},
+    {'g', "gates", "comma-separated gate counts, or extractions per message (1024,4096)", "LIST"},
+    {'c', "count", "number of messages to time in each run (10000)", "COUNT"},
+    {'w', "warmup", "number of messages to send before timing (500)", "COUNT"},
+    {'q', "queue", "input queue capacity; the sender waits when it is full (256)", "COUNT"},
+    {'o', "output", "write JSON to FILE instead of standard output", "FILE"},
+};
+
+const Utils::CmdLineArgs::ArgumentDef args[] = {
+    {"ALGORITHM", "name of the algorithm DLL to load"}, {0, 0}, {"PARAMS", "parameter set NAME=VALUE[,NAME=VALUE]"}};
+
+// Count every heap allocation in the process, and separately those of each thread. The difference between the
+// total and the count of the sending thread is what the algorithm thread allocated.
+//
+static std::atomic<uint64_t> allocations_(0);
+static thread_local uint64_t threadAllocations_ = 0;
+
+void*
+operator new(size_t size)
+{
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    ++threadAllocations_;
+    void* ptr = ::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+    ::free(ptr);
+}
+
+/** Source of synthetic input messages. Rows of sample values are made once up front so that the sending thread
+    spends as little time as possible making messages. Video rows hold a few sine waves plus noise, like the
+    output of the sines tool; BinaryVideo rows are those values after a threshold; Complex rows hold I and Q
+    sine waves. Extractions messages hold \a gates targets at random ranges.
+*/
+class Generator {
+public:
+    enum { kRows = 16 };
+
+    Generator(const std::string& type, size_t gates) : type_(type), gates_(gates), video_(), complex_(), pri_(0)
+    {
+        vme_.header.msgDesc = ((type == "Complex" ? VMEHeader::kPackedIQ : VMEHeader::kPackedReal) << 16) |
+                              VMEHeader::kAzimuthValidMask | VMEHeader::kIRIGValidMask | VMEHeader::kPRIValidMask;
+        vme_.header.timeStamp = 0;
+        vme_.rangeMin = 0.0;
+        vme_.rangeFactor = RadarConfig::GetRangeMax() / gates;
+
+        for (int row = 0; row < kRows; ++row) {
+            std::vector<Video::DatumType> video;
+            std::vector<Complex::DatumType> complex;
+            for (size_t gate = 0; gate < gates; ++gate) {
+                double phase = 2.0 * M_PI * gate / 64.0 + row * 0.4;
+                double noise = ::drand48() * 512 - 256;
+                video.push_back(Video::DatumType(::sin(phase) * 4096 + ::sin(phase * 7.3) * 1024 + noise));
+                complex.push_back(Complex::DatumType(int16_t(::cos(phase) * 4096 + noise),
+                                                     int16_t(::sin(phase) * 4096 + noise)));
+            }
+
+            video_.push_back(video);
+            complex_.push_back(complex);
+        }
+    }
+
+    static bool IsValidType(const std::string& type)
+    {
+        return type == "Video" || type == "BinaryVideo" || type == "Complex" || type == "Extractions";
+    }
+
+    /** \return number of bytes of sample data in each message
+     */
+    size_t getMessageBytes() const
+    {
+        if (type_ == "Video") return gates_ * sizeof(Video::DatumType);
+        if (type_ == "BinaryVideo") return gates_ * sizeof(BinaryVideo::DatumType);
+        if (type_ == "Complex") return gates_ * sizeof(Complex::DatumType);
+        return gates_ * sizeof(Extraction);
+    }
+
+    Header::Ref make()
+    {
+        size_t row = pri_ % kRows;
+        ++pri_;
+        vme_.header.pri = pri_;
+        vme_.header.azimuth = (pri_ * 16) % RadarConfig::GetShaftEncodingMax();
+        vme_.header.irigTime = pri_ / 1000.0;
+
+        if (type_ == "Video") return Video::Make("bench", vme_, &video_[row][0], &video_[row][0] + gates_);
+
+        if (type_ == "Complex") return Complex::Make("bench", vme_, &complex_[row][0], &complex_[row][0] + gates_);
+
+        if (type_ == "BinaryVideo") {
+            BinaryVideo::Ref msg(BinaryVideo::Make("bench", vme_, gates_));
+            for (Video::DatumType value : video_[row]) msg->push_back(value > 2048);
+            return msg;
+        }
+
+        Extractions::Ref msg(Extractions::Make("bench", Header::Ref()));
+        msg->reserve(gates_);
+        Time::TimeStamp when(vme_.header.irigTime);
+        for (size_t index = 0; index < gates_; ++index) {
+            msg->push_back(Extraction(when, ::drand48() * RadarConfig::GetRangeMax(), ::drand48() * 2.0 * M_PI, 0.0));
+        }
+
+        return msg;
+    }
+
+private:
+    std::string type_;
+    size_t gates_;
+    std::vector<std::vector<Video::DatumType>> video_;
+    std::vector<std::vector<Complex::DatumType>> complex_;
+    VMEDataMessage vme_;
+    uint32_t pri_;
+};
+
+/** Settings that apply to every run.
+ */
+struct Settings {
+    std::string algorithm;
+    std::string type;
+    size_t count;
+    size_t warmup;
+    size_t queueCapacity;
+};
+
+/** Percentiles of a histogram of nanosecond values, in microseconds.
+ */
+struct Percentiles {
+    Percentiles() : p50(0.0), p99(0.0), p999(0.0), max(0.0) {}
+
+    Percentiles(const Utils::HdrHistogram& histogram) :
+        p50(histogram.getValueAtPercentile(50.0) / 1000.0), p99(histogram.getValueAtPercentile(99.0) / 1000.0),
+        p999(histogram.getValueAtPercentile(99.9) / 1000.0), max(histogram.getMax() / 1000.0)
+    {
+    }
+
+    double p50;
+    double p99;
+    double p999;
+    double max;
+};
+
+/** Outcome of one run.
+ */
+struct Result {
+    Result(size_t g, const std::string& p) :
+        gates(g), parameters(p), error(), seconds(0.0), messageBytes(0), allocations(0), processing(), latency()
+    {
+    }
+
+    size_t gates;
+    std::string parameters;
+    std::string error;
+    double seconds;
+    size_t messageBytes;
+    uint64_t allocations;
+    Percentiles processing;
+    Percentiles latency;
+};
+
+/** Write a string as a JSON string literal.
+ */
+static void
+WriteString(std::ostream& os, const std::string& value)
+{
+    os << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            char buffer[8];
+            ::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            os << buffer;
+        } else {
+            os << c;
+        }
+    }
+
+    os << '"';
+}
+
+static void
+WritePercentiles(std::ostream& os, const Percentiles& percentiles)
+{
+    os << "{\"p50\": " << percentiles.p50 << ", \"p99\": " << percentiles.p99 << ", \"p999\": " << percentiles.p999
+       << ", \"max\": " << percentiles.max << '}';
+}
+
+/** Convert parameter settings of the form NAME=VALUE[,NAME=VALUE] into a ParametersChangeRequest array, using
+    the types the controller reports for its parameters.
+
+    \return true if all of the settings are valid
+*/
+static bool
+MakeParameterChanges(const Controller& controller, const std::string& spec, XmlRpc::XmlRpcValue& changes,
+                     std::string& error)
+{
+    XmlRpc::XmlRpcValue definitions;
+    controller.getCurrentParameters(definitions);
+    changes.setSize(0);
+
+    std::istringstream is(spec);
+    std::string setting;
+    while (std::getline(is, setting, ',')) {
+        size_t split = setting.find('=');
+        if (split == std::string::npos) {
+            error = "invalid parameter setting '" + setting + "'";
+            return false;
+        }
+
+        std::string name(setting.substr(0, split));
+        std::string value(setting.substr(split + 1));
+        std::string type;
+        for (int index = 0; index < definitions.size(); ++index) {
+            if (std::string(definitions[index]["name"]) == name) type = std::string(definitions[index]["type"]);
+        }
+
+        changes.push_back(name);
+        if (type == "int") {
+            int converted = 0;
+            if (!(value >> converted)) type.clear();
+            changes.push_back(converted);
+        } else if (type == "double") {
+            double converted = 0.0;
+            if (!(value >> converted)) type.clear();
+            changes.push_back(converted);
+        } else if (type == "bool") {
+            changes.push_back(value == "1" || value == "true" || value == "yes");
+        } else if (!type.empty()) {
+            changes.push_back(value);
+        }
+
+        if (type.empty()) {
+            error = "unknown parameter or invalid value '" + setting + "'";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void
+Sleep(int msecs)
+{
+    timespec delay = {msecs / 1000, (msecs % 1000) * 1000000L};
+    ::nanosleep(&delay, 0);
+}
+
+/** Wait for the controller to finish processing a number of messages.
+
+    \return true if successful, false if the controller reported an error or stopped making progress
+*/
+static bool
+WaitForProcessed(const Controller& controller, uint64_t count)
+{
+    uint64_t last = 0;
+    int idle = 0;
+    while (!controller.hasError()) {
+        uint64_t processed = controller.getLatencyStats().getProcessing().getCount();
+        if (processed >= count) return true;
+        idle = processed == last ? idle + 1 : 0;
+        if (idle == 10000) return false;
+        last = processed;
+        Sleep(1);
+    }
+
+    return false;
+}
+
+/** Load the algorithm into a new stream, apply the parameter settings, and time it.
+ */
+static void
+Run(const Settings& settings, Result& result)
+{
+    Generator generator(settings.type, result.gates);
+    result.messageBytes = generator.getMessageBytes();
+
+    IO::Stream::Ref stream(IO::Stream::Make("bench"));
+    ControllerModule* module = new ControllerModule(stream);
+    Controller::Ref controller = module->getTask();
+    controller->setTaskIndex(0);
+    controller->setQueuePolicy(IO::Task::QueuePolicy(IO::Task::QueuePolicy::kBlock, settings.queueCapacity));
+    controller->addInputChannel(IO::Channel("input", settings.type));
+    if (stream->push(module) == -1 || !controller->openAndInit(settings.algorithm)) {
+        result.error = "failed to load algorithm " + settings.algorithm;
+        return;
+    }
+
+    if (!result.parameters.empty()) {
+        XmlRpc::XmlRpcValue changes;
+        if (!MakeParameterChanges(*controller, result.parameters, changes, result.error)) {
+            stream->close();
+            return;
+        }
+
+        controller->injectControlMessage(IO::ParametersChangeRequest(changes, false));
+    }
+
+    controller->injectProcessingStateChange(IO::ProcessingState::kRun);
+
+    // Warm up caches and let the algorithm settle, then clear the statistics. The clear request goes through
+    // the control lane, so it takes effect before the first timed message.
+    //
+    for (size_t index = 0; index < settings.warmup; ++index) {
+        IO::MessageManager manager(generator.make());
+        stream->put(manager.getMessage(), 0);
+    }
+
+    if (!WaitForProcessed(*controller, settings.warmup)) {
+        result.error = controller->hasError() ? controller->getError() : "algorithm stopped processing";
+        stream->close();
+        return;
+    }
+
+    controller->injectControlMessage(IO::ClearStatsRequest());
+
+    uint64_t allocations = allocations_.load();
+    uint64_t threadAllocations = threadAllocations_;
+    auto start = IO::LatencyStats::Now();
+    for (size_t index = 0; index < settings.count; ++index) {
+        Header::Ref msg(generator.make());
+        msg->setTraceOrigin(IO::LatencyStats::Now());
+        IO::MessageManager manager(msg);
+        stream->put(manager.getMessage(), 0);
+    }
+
+    if (!WaitForProcessed(*controller, settings.count)) {
+        result.error = controller->hasError() ? controller->getError() : "algorithm stopped processing";
+    }
+
+    result.seconds = (IO::LatencyStats::Now() - start) / 1.0E9;
+    result.allocations = (allocations_.load() - allocations) - (threadAllocations_ - threadAllocations);
+
+    result.processing = Percentiles(controller->getLatencyStats().getProcessing());
+    result.latency = Percentiles(controller->getLatencyStats().getLatency());
+
+    stream->close();
+}
+
+static void
+WriteResult(std::ostream& os, const Settings& settings, const Result& result)
+{
+    double rate = result.seconds > 0.0 ? settings.count / result.seconds : 0.0;
+    os << "    {\"gates\": " << result.gates << ", \"parameters\": ";
+    WriteString(os, result.parameters);
+    if (!result.error.empty()) {
+        os << ", \"error\": ";
+        WriteString(os, result.error);
+        os << '}';
+        return;
+    }
+
+    os << ", \"messages\": " << settings.count << ", \"seconds\": " << result.seconds
+       << ", \"messagesPerSecond\": " << rate
+       << ", \"megabytesPerSecond\": " << rate * result.messageBytes / (1024.0 * 1024.0)
+       << ", \"allocationsPerMessage\": " << double(result.allocations) / settings.count;
+    os << ",\n     \"processingUsec\": ";
+    WritePercentiles(os, result.processing);
+    os << ",\n     \"latencyUsec\": ";
+    WritePercentiles(os, result.latency);
+    os << '}';
+}
+
+int
+main(int argc, char** argv)
+{
+    Utils::CmdLineArgs cla(argc, argv, about, options, sizeof(options), args, sizeof(args));
+    std::string value;
+
+    Settings settings;
+    settings.algorithm = cla.arg(0);
+    settings.type = "Video";
+    settings.count = 10000;
+    settings.warmup = 500;
+    settings.queueCapacity = 256;
+
+    if (cla.hasOpt("type", settings.type) && !Generator::IsValidType(settings.type)) {
+        cla.usage("invalid 'type' value");
+    }
+
+    if (cla.hasOpt("count", value))
+        if (!(value >> settings.count) || settings.count < 1) cla.usage("invalid 'count' value");
+
+    if (cla.hasOpt("warmup", value))
+        if (!(value >> settings.warmup)) cla.usage("invalid 'warmup' value");
+
+    if (cla.hasOpt("queue", value))
+        if (!(value >> settings.queueCapacity) || settings.queueCapacity < 1) cla.usage("invalid 'queue' value");
+
+    std::vector<size_t> gateCounts;
+    std::string gates("1024,4096");
+    cla.hasOpt("gates", gates);
+    std::istringstream is(gates);
+    while (std::getline(is, value, ',')) {
+        size_t count;
+        if (!(value >> count) || count < 1) cla.usage("invalid 'gates' value");
+        gateCounts.push_back(count);
+    }
+
+    std::vector<std::string> parameterSets;
+    size_t index = 1;
+    while (cla.hasArg(index++, value)) parameterSets.push_back(value);
+    if (parameterSets.empty()) parameterSets.push_back("");
+
+    // Only report problems. Turn on latency tracing so that the controller times each message.
+    //
+    Logger::Log::Root().setPriorityLimit(Logger::Priority::kError);
+    IO::LatencyStats::SetEnabled(true);
+
+    std::ofstream file;
+    if (cla.hasOpt("output", value)) {
+        file.open(value.c_str());
+        if (!file) cla.usage("failed to open output file");
+    }
+
+    std::ostream& os(file.is_open() ? file : std::cout);
+
+    char host[256];
+    if (::gethostname(host, sizeof(host)) == -1) host[0] = 0;
+    host[sizeof(host) - 1] = 0;
+
+    os << "{\"algorithm\": ";
+    WriteString(os, settings.algorithm);
+    os << ", \"type\": ";
+    WriteString(os, settings.type);
+    os << ", \"host\": ";
+    WriteString(os, host);
+    os << ", \"processors\": " << ::sysconf(_SC_NPROCESSORS_ONLN) << ", \"queueCapacity\": " << settings.queueCapacity
+       << ",\n \"runs\": [\n";
+
+    int failures = 0;
+    bool first = true;
+    for (size_t gateCount : gateCounts) {
+        for (const std::string& parameters : parameterSets) {
+            Result result(gateCount, parameters);
+
+            std::clog << settings.algorithm << " gates: " << gateCount << " parameters: '" << parameters << "'"
+                      << std::endl;
+            Run(settings, result);
+            if (!result.error.empty()) {
+                std::clog << "*** " << result.error << std::endl;
+                ++failures;
+            }
+
+            if (!first) os << ",\n";
+            first = false;
+            WriteResult(os, settings, result);
+        }
+    }
+
+    os << "\n]}" << std::endl;
+
+    return failures ? 1 : 0;
+}
@@ -36,6 +36,25 @@ include("CMakeStuff/UnitTests.cmake")
 
 add_definitions(-DSIDECAR_VERSION="${SIDECAR_VERSION}")
 
+# Remove LOGINFO, LOGDEBUG, etc. statements more verbose than a given level at compile time. For instance, to
+# keep only warning, error, and fatal log statements:
+#
+# %  cmake -DSIDECAR_MIN_LOG_LEVEL=warning ..
+#
+set(SIDECAR_LOG_LEVELS fatal error warning info traceIn traceOut debug1 debug2 debug3)
+set(SIDECAR_MIN_LOG_LEVEL "debug3" CACHE STRING "Most verbose log statement level to compile")
+set_property(CACHE SIDECAR_MIN_LOG_LEVEL PROPERTY STRINGS ${SIDECAR_LOG_LEVELS})
+list(FIND SIDECAR_LOG_LEVELS "${SIDECAR_MIN_LOG_LEVEL}" SIDECAR_MIN_LOG_LEVEL_INDEX)
+if(SIDECAR_MIN_LOG_LEVEL_INDEX EQUAL -1)
+    message(FATAL_ERROR "invalid SIDECAR_MIN_LOG_LEVEL '${SIDECAR_MIN_LOG_LEVEL}' - use one of ${SIDECAR_LOG_LEVELS}")
+endif()
+
+# Priority::Level values start with kNone = 0, so kFatal is 1.
+#
+math(EXPR SIDECAR_MIN_LOG_LEVEL_VALUE "${SIDECAR_MIN_LOG_LEVEL_INDEX} + 1")
+add_definitions(-DSIDECAR_MIN_LOG_LEVEL=${SIDECAR_MIN_LOG_LEVEL_VALUE})
+message(STATUS "SIDECAR_MIN_LOG_LEVEL: ${SIDECAR_MIN_LOG_LEVEL}")
+
 # Specify versions of dependencies (if desired)
 #
 set(ACE_VERSION "")
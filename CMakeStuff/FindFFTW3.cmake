@@ -1,11 +1,13 @@
 # -*- Mode: CMake -*-
 #
-# Attempt to find the FFTW3 installation.
+# Attempt to find the FFTW3 installation. The fftw3f_threads library is optional: when found, FFTW3_THREADS_FOUND
+# is TRUE and FFTW3_LIBRARIES includes it.
 #
 
 find_path(FFTW3_INCLUDE_DIR fftw3.h PATH_SUFFIXES include HINTS ${SIDECAR_DEPS}/fftw PATHS /usr/local /usr)
 find_library(FFTW3_LIB1 fftw3 PATH_SUFFIXES lib64 lib HINTS ${SIDECAR_DEPS}/fftw PATHS /usr/local /usr)
 find_library(FFTW3_LIB2 fftw3f PATH_SUFFIXES lib64 lib HINTS ${SIDECAR_DEPS}/fftw PATHS /usr/local /usr)
+find_library(FFTW3_LIB3 fftw3f_threads PATH_SUFFIXES lib64 lib HINTS ${SIDECAR_DEPS}/fftw PATHS /usr/local /usr)
 
 include(FindPackageHandleStandardArgs)
 find_package_handle_standard_args(FFTW3 DEFAULT_MSG FFTW3_INCLUDE_DIR FFTW3_LIB1 FFTW3_LIB2)
@@ -13,9 +15,17 @@ find_package_handle_standard_args(FFTW3 DEFAULT_MSG FFTW3_INCLUDE_DIR FFTW3_LIB1
 if(FFTW3_FOUND)
     set(FFTW3_INCLUDE_DIRS ${FFTW3_INCLUDE_DIR})
     set(FFTW3_LIBRARIES ${FFTW3_LIB1} ${FFTW3_LIB2})
+    if(FFTW3_LIB3)
+        set(FFTW3_THREADS_FOUND TRUE)
+        set(FFTW3_LIBRARIES ${FFTW3_LIB3} ${FFTW3_LIBRARIES})
+    else(FFTW3_LIB3)
+        set(FFTW3_THREADS_FOUND FALSE)
+        message(STATUS "fftw3f_threads not found - FFTW plans will be single-threaded")
+    endif(FFTW3_LIB3)
 else(FFTW3_FOUND)
     set(FFTW3_INCLUDE_DIRS)
     set(FFTW3_LIBRARIES)
+    set(FFTW3_THREADS_FOUND FALSE)
 endif(FFTW3_FOUND)
 
-mark_as_advanced(FFTW3_INCLUDE_DIR FFTW3_LIB1 FFTW3_LIB2)
+mark_as_advanced(FFTW3_INCLUDE_DIR FFTW3_LIB1 FFTW3_LIB2 FFTW3_LIB3)
@@ -37,6 +37,12 @@ ControllerItem::getRecordingDataValue(int role) const
 QVariant
 ControllerItem::getRateDataValue(int role) const
 {
+    if (role == Qt::ToolTipRole) {
+        return QString("Control latency: %1 avg, %2 max")
+            .arg(getFormattedProcessingTime(getStatus().getAverageControlLatency()))
+            .arg(getFormattedProcessingTime(getStatus().getMaximumControlLatency()));
+    }
+
     if (role != Qt::DisplayRole) return Super::getRateDataValue(role);
 
     if (!isUsingData()) return "---";
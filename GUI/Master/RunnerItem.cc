@@ -79,6 +79,11 @@ RunnerItem::getInfoDataValue(int role) const
 
     if (role == Qt::DisplayRole) return QString("Mem: ") + ByteAmountToString(memoryUsed, 1);
 
+    if (role == Qt::ToolTipRole) {
+        std::string placement(getStatus().getThreadPlacement());
+        if (!placement.empty()) return QString("Threads: %1").arg(QString::fromStdString(placement));
+    }
+
     return Super::getInfoDataValue(role);
 }
 
@@ -43,8 +43,15 @@ TaskItem::getStateDataValue(int role) const
 QVariant
 TaskItem::getPendingCountValue(int role) const
 {
+    int queueDropCount = getQueueDropCount();
+    if (role == Qt::ForegroundRole && queueDropCount) return GetFailureColor();
+    if (role == Qt::ToolTipRole && queueDropCount) {
+        return QString("%1 messages shed due to a full input queue").arg(queueDropCount);
+    }
+
     if (role != Qt::DisplayRole) return Super::getPendingCountValue(role);
     if (!isUsingData()) return "---";
+    if (queueDropCount) return QString("%1 (shed %2)").arg(getPendingQueueCount()).arg(queueDropCount);
     return getPendingQueueCount();
 }
 
@@ -82,6 +82,12 @@ public:
 
     int getPendingQueueCount() const { return getStatus().getPendingQueueCount(); }
 
+    /** Obtain the number of messages the task shed because its input queue was full.
+
+        \return queue drop count
+    */
+    int getQueueDropCount() const { return getStatus().getQueueDropCount(); }
+
     bool isUsingData() const { return getStatus().isUsingData(); }
 
     StreamItem* getParent() const;
@@ -43,7 +43,8 @@ MessageReader::Make(const ServiceEntry* serviceEntry)
     return reader;
 }
 
-MessageReader::MessageReader(const Messages::MetaTypeInfo* metaTypeInfo) : Super(), metaTypeInfo_(metaTypeInfo)
+MessageReader::MessageReader(const Messages::MetaTypeInfo* metaTypeInfo) :
+    Super(), metaTypeInfo_(metaTypeInfo), request_()
 {
     ;
 }
@@ -4,6 +4,7 @@
 #include "QtCore/QObject"
 #include "QtCore/QString"
 
+#include "IO/SubscriptionRequest.h"
 #include "Messages/Header.h"
 #include "Messages/MetaTypeInfo.h"
 
@@ -55,6 +56,19 @@ public:
     */
     const Messages::MetaTypeInfo* getMetaTypeInfo() const { return metaTypeInfo_; }
 
+    /** Ask the publisher for less than all of its data. Must be called before the reader connects to the
+        publisher.
+
+        \param request the data to ask for
+    */
+    void setSubscriptionRequest(const IO::SubscriptionRequest& request) { request_ = request; }
+
+    /** Obtain the data reduction asked of the publisher.
+
+        \return SubscriptionRequest reference
+    */
+    const IO::SubscriptionRequest& getSubscriptionRequest() const { return request_; }
+
 signals:
 
     /** Notification that the reader has connected to a publisher
@@ -86,6 +100,7 @@ protected:
 
 private:
     const Messages::MetaTypeInfo* metaTypeInfo_;
+    IO::SubscriptionRequest request_;
 };
 
 } // end namespace GUI
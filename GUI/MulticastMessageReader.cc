@@ -39,7 +39,7 @@ MulticastMessageReader::Make(const ServiceEntry* service)
 }
 
 MulticastMessageReader::MulticastMessageReader(const Messages::MetaTypeInfo* metaTypeInfo) :
-    Super(metaTypeInfo), proxy_(0), heartBeatWriter_(0), timer_(0), reader_(), connected_(false)
+    Super(metaTypeInfo), proxy_(0), heartBeatWriter_(0), timer_(0), reader_(), connected_(false), reduce_(false)
 {
     static Logger::ProcLog log("MulticastMessageReader", Log());
     LOGINFO << std::endl;
@@ -104,6 +104,7 @@ MulticastMessageReader::open(const ServiceEntry* service)
 
     QString portText = service->getTextEntry("HeartBeatPort");
     heartBeatPort_ = portText.toUShort();
+    reduce_ = !service->getTextEntry("Reduce").isEmpty();
     LOGDEBUG << "heartBeatHost: " << heartBeatHost_.toString() << " port: " << heartBeatPort_ << std::endl;
 
     timer_ = new QTimer(this);
@@ -172,7 +173,8 @@ MulticastMessageReader::socketReadyRead()
         }
 
         raw->wr_ptr(size);
-        addRawData(raw);
+        raw = SubscriptionReducer::ReduceReceived(getSubscriptionRequest(), raw, getMetaTypeInfo());
+        if (raw) addRawData(raw);
         raw = 0;
 
     } while (proxy_->hasPendingDatagrams());
@@ -210,5 +212,9 @@ MulticastMessageReader::socketError(QAbstractSocket::SocketError err)
 void
 MulticastMessageReader::beatHeart()
 {
-    sendHeartBeat("HI");
+    if (!reduce_ || getSubscriptionRequest().isEmpty()) {
+        sendHeartBeat("HI");
+    } else {
+        sendHeartBeat(("HI " + getSubscriptionRequest().format()).c_str());
+    }
 }
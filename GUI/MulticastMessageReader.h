@@ -27,6 +27,10 @@ namespace GUI {
     puts complete datagrams into new ACE_Message_Block objects, which the
     method hands off to the MessageReader::addRawData() method to add to the
     active message list.
+
+    If the publisher accepts data reduction requests, the heart-beat messages carry our SubscriptionRequest.
+    The publisher only reduces its stream to cover the requests of all of its subscribers, so socketReadyRead()
+    applies our own request to what it receives.
 */
 class MulticastMessageReader : public MessageReader, public IO::ZeroconfTypes::Subscriber {
     Q_OBJECT
@@ -106,6 +110,7 @@ private:
     QTimer* timer_;
     IO::MulticastSocketReader reader_;
     bool connected_;
+    bool reduce_;
 };
 
 } // namespace GUI
@@ -15,7 +15,7 @@ ReaderThread::Log()
     return log_;
 }
 
-ReaderThread::ReaderThread() : QThread(), serviceEntry_(0), messages_(), active_(0), mutex_()
+ReaderThread::ReaderThread() : QThread(), serviceEntry_(0), request_(), messages_(), active_(0), mutex_()
 {
     Logger::ProcLog log("ReaderThread", Log());
     LOGINFO << std::endl;
@@ -120,6 +120,7 @@ ReaderThread::run()
     // our ServiceEntry object.
     //
     boost::scoped_ptr<MessageReader> reader(MessageReader::Make(serviceEntry_.get()));
+    if (reader) reader->setSubscriptionRequest(request_);
 
     // The reader belongs to our thread, so we can connect to it without queuing signals. Also, we must delete
     // it before we and our thread exits.
@@ -8,6 +8,7 @@
 #include "QtCore/QThread"
 
 #include "GUI/MessageList.h"
+#include "IO/SubscriptionRequest.h"
 
 namespace Logger {
 class Log;
@@ -51,6 +52,12 @@ public:
     */
     void useServiceEntry(const ServiceEntry* serviceEntry);
 
+    /** Set the data reduction to ask of the publisher. Takes effect on the next useServiceEntry() call.
+
+        \param request the data to ask for
+    */
+    void setSubscriptionRequest(const IO::SubscriptionRequest& request) { request_ = request; }
+
     /** Obtain the Zeroconf sub-type last assigned in useServiceEntry()
 
         \return sub-type value
@@ -94,6 +101,7 @@ protected:
 private:
     boost::scoped_ptr<ServiceEntry> serviceEntry_;
     const Messages::MetaTypeInfo* metaTypeInfo_;
+    IO::SubscriptionRequest request_;
     MessageList messages_[2];
     volatile size_t active_;
     QMutex mutex_;
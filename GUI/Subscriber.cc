@@ -73,6 +73,14 @@ Subscriber::useServiceEntry(ServiceEntry* serviceEntry)
     }
 }
 
+void
+Subscriber::setSubscriptionRequest(const IO::SubscriptionRequest& request)
+{
+    static Logger::ProcLog log("setSubscriptionRequest", Log());
+    LOGINFO << request.format() << std::endl;
+    reader_->setSubscriptionRequest(request);
+}
+
 void
 Subscriber::resolvedServiceEntry(ServiceEntry* serviceEntry)
 {
@@ -8,6 +8,9 @@ class Log;
 }
 
 namespace SideCar {
+namespace IO {
+struct SubscriptionRequest;
+}
 namespace GUI {
 
 class MessageList;
@@ -43,6 +46,12 @@ public:
     */
     void useServiceEntry(ServiceEntry* serviceEntry);
 
+    /** Ask the publisher for less than all of its data. Takes effect on the next connection to a publisher.
+
+        \param request the data to ask for
+    */
+    void setSubscriptionRequest(const IO::SubscriptionRequest& request);
+
     /** Obtain the connection state of the subscriber.
 
         \return true if connected
@@ -17,7 +17,7 @@ TCPMessageReader::Make(const ServiceEntry* service)
 {
     static Logger::ProcLog log("Make", Log());
     QTcpSocket* socket = new QTcpSocket;
-    socket->connectToHost(service->getHost(), service->getPort(), QIODevice::ReadOnly);
+    socket->connectToHost(service->getHost(), service->getPort(), QIODevice::ReadWrite);
     return new TCPMessageReader(service->getMetaTypeInfo(), socket);
 }
 
@@ -25,7 +25,7 @@ TCPMessageReader::TCPMessageReader(const Messages::MetaTypeInfo* metaTypeInfo, Q
     Super(metaTypeInfo), reader_(), socket_(socket)
 {
     reader_.setDevice(socket_);
-    connect(socket, SIGNAL(connected()), this, SIGNAL(connected()));
+    connect(socket, SIGNAL(connected()), this, SLOT(socketConnected()));
     connect(socket, SIGNAL(disconnected()), this, SIGNAL(disconnected()));
     connect(socket, SIGNAL(readyRead()), this, SLOT(socketReadyRead()));
 }
@@ -35,6 +35,21 @@ TCPMessageReader::~TCPMessageReader()
     delete socket_;
 }
 
+void
+TCPMessageReader::socketConnected()
+{
+    static Logger::ProcLog log("socketConnected", Log());
+    if (!getSubscriptionRequest().isEmpty()) {
+        std::string line("SUB " + getSubscriptionRequest().format() + "\n");
+        LOGINFO << line;
+        if (socket_->write(line.c_str(), line.size()) != qint64(line.size())) {
+            LOGERROR << "failed to send subscription request - " << socket_->errorString() << std::endl;
+        }
+    }
+
+    emit connected();
+}
+
 void
 TCPMessageReader::socketReadyRead()
 {
@@ -56,6 +56,11 @@ public:
 
 private slots:
 
+    /** Notification from QTcpSocket that it has connected to the publisher. Sends the publisher our
+        SubscriptionRequest if there is one.
+    */
+    void socketConnected();
+
     void socketReadyRead();
 
 private:
@@ -123,7 +123,7 @@ ClientSocketWriterTask::OutputHandler::svc()
             // the connection to the server has gone down. This will continue until our open() method is invoked
             // after a new connection has been established.
             //
-            if (getq(data) == -1) {
+            if (dequeue(data) == -1) {
                 if (msg_queue()->state() == ACE_Message_Queue_Base::PULSED) {
                     if (!connector_->reconnect()) break;
                 } else {
@@ -280,7 +280,7 @@ ClientSocketWriterTask::openAndInit(const std::string& key, const std::string& h
 bool
 ClientSocketWriterTask::deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout)
 {
-    return putq(data, timeout) != -1;
+    return enqueue(data, timeout);
 }
 
 int
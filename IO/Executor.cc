@@ -0,0 +1,195 @@
+#include <pthread.h>
+
+#include <algorithm>
+
+#include "Logger/Log.h"
+
+#include "Executor.h"
+
+using namespace SideCar::IO;
+
+/** The executor and worker index of the calling thread, if it is a worker thread.
+ */
+static thread_local Executor* tExecutor = 0;
+static thread_local size_t tWorkerIndex = 0;
+
+Executor::Actor::Actor(Executor& executor) : executor_(executor), pending_(0), mutex_(), idle_()
+{
+    ;
+}
+
+Executor::Actor::~Actor()
+{
+    stop();
+}
+
+void
+Executor::Actor::notify()
+{
+    size_t previous = pending_.fetch_add(1);
+    if (previous & kStopped) {
+        finished(1);
+    } else if (!previous) {
+        executor_.schedule(this);
+    }
+}
+
+void
+Executor::Actor::stop()
+{
+    pending_.fetch_or(kStopped);
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return getPendingCount() == 0; });
+}
+
+bool
+Executor::Actor::run()
+{
+    size_t count = std::min(getPendingCount(), size_t(kBatchSize));
+    for (size_t index = 0; index < count; ++index) runOne();
+    return finished(count);
+}
+
+bool
+Executor::Actor::finished(size_t count)
+{
+    // Hold the mutex so that stop() cannot return, and the actor go away, until we are done with it.
+    //
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t left = (pending_.fetch_sub(count) - count) & ~kStopped;
+    if (!left) idle_.notify_all();
+    return left != 0;
+}
+
+Logger::Log&
+Executor::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.Executor");
+    return log_;
+}
+
+Executor&
+Executor::Instance()
+{
+    static Executor executor;
+    return executor;
+}
+
+Executor::Executor(size_t workerCount, bool pinned) :
+    workers_(), queued_(0), next_(0), runs_(0), steals_(0), sleepers_(0), sleepMutex_(), wakeup_(), stopping_(false)
+{
+    static Logger::ProcLog log("Executor", Log());
+
+    size_t processorCount = std::max(std::thread::hardware_concurrency(), 1U);
+    if (!workerCount) workerCount = processorCount;
+    LOGINFO << "workers: " << workerCount << " pinned: " << pinned << std::endl;
+
+    for (size_t index = 0; index < workerCount; ++index) workers_.push_back(new Worker);
+    for (size_t index = 0; index < workerCount; ++index) {
+        std::thread& thread(workers_[index]->thread);
+        thread = std::thread([this, index] { workerMain(index); });
+
+#ifdef linux
+        if (pinned) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(index % processorCount, &cpus);
+            if (::pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus)) {
+                LOGWARNING << "failed to pin worker " << index << std::endl;
+            }
+        }
+#endif
+    }
+}
+
+Executor::~Executor()
+{
+    static Logger::ProcLog log("~Executor", Log());
+    LOGINFO << "runs: " << runs_ << " steals: " << steals_ << std::endl;
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+
+    wakeup_.notify_all();
+    for (size_t index = 0; index < workers_.size(); ++index) {
+        workers_[index]->thread.join();
+        delete workers_[index];
+    }
+}
+
+void
+Executor::schedule(Actor* actor)
+{
+    size_t index = tExecutor == this ? tWorkerIndex : next_++ % workers_.size();
+    {
+        Worker& worker(*workers_[index]);
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(actor);
+    }
+
+    // Only bother with the sleep mutex if a worker may be asleep. A worker counts itself as a sleeper before it
+    // looks at queued_ for the last time, so one of us always sees the other.
+    //
+    ++queued_;
+    if (sleepers_) {
+        { std::lock_guard<std::mutex> lock(sleepMutex_); }
+        wakeup_.notify_one();
+    }
+}
+
+Executor::Actor*
+Executor::take(size_t index)
+{
+    {
+        Worker& worker(*workers_[index]);
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.queue.empty()) {
+            Actor* actor = worker.queue.front();
+            worker.queue.pop_front();
+            --queued_;
+            return actor;
+        }
+    }
+
+    // Steal from the back of another worker's queue, leaving the work it is about to do to it.
+    //
+    for (size_t offset = 1; offset < workers_.size(); ++offset) {
+        Worker& victim(*workers_[(index + offset) % workers_.size()]);
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.queue.empty()) {
+            Actor* actor = victim.queue.back();
+            victim.queue.pop_back();
+            --queued_;
+            ++steals_;
+            return actor;
+        }
+    }
+
+    return 0;
+}
+
+void
+Executor::workerMain(size_t index)
+{
+    tExecutor = this;
+    tWorkerIndex = index;
+
+    while (true) {
+        Actor* actor = take(index);
+        if (actor) {
+            ++runs_;
+            if (actor->run()) schedule(actor);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        ++sleepers_;
+        wakeup_.wait(lock, [this] { return stopping_ || queued_ != 0; });
+        --sleepers_;
+        if (stopping_ && !queued_) break;
+    }
+
+    tExecutor = 0;
+}
@@ -0,0 +1,180 @@
+#ifndef SIDECAR_IO_EXECUTOR_H // -*- C++ -*-
+#define SIDECAR_IO_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Utils/Utils.h"
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace IO {
+
+/** Fixed pool of worker threads that runs many Actor objects, so that a stream with many tasks does not need a
+    thread for each one. Each worker has its own run queue of actors with work to do. A worker takes actors from
+    the front of its own queue, and when that is empty, it steals from the back of the queues of the other
+    workers. Workers with nothing to run or steal sleep until an actor has work.
+
+    An actor is in at most one run queue at a time, and only one worker runs it at a time, so an actor sees its
+    units of work one at a time and in order, just as if it had its own thread. A worker runs an actor for up to
+    kBatchSize units of work before putting it back at the end of the run queue, so that a busy actor does not
+    starve the others.
+
+    There is one executor for the whole process, obtained with Instance(). Other instances are only for testing.
+*/
+class Executor : public Utils::Uncopyable {
+public:
+    enum { kBatchSize = 16 };
+
+    /** Something that an Executor runs. Derived classes implement runOne() to do one unit of work, and call
+        notify() each time a unit of work becomes available, typically after adding a message to a queue.
+    */
+    class Actor : public Utils::Uncopyable {
+    public:
+        /** Constructor.
+
+            \param executor the executor that runs the actor
+        */
+        Actor(Executor& executor);
+
+        /** Destructor. Stops the actor if it is not already stopped.
+         */
+        virtual ~Actor();
+
+        /** Notify the executor that there is another unit of work for the actor. Thread-safe. Does nothing if
+            the actor is stopped.
+        */
+        void notify();
+
+        /** Stop the actor. Further notify() calls do nothing. Waits for the executor to finish running the
+            actor, after which it will never run it again.
+        */
+        void stop();
+
+        /** \return number of units of work waiting to be run
+         */
+        size_t getPendingCount() const { return pending_ & ~kStopped; }
+
+    protected:
+        /** Perform one unit of work. Only ever called from one worker thread at a time.
+         */
+        virtual void runOne() = 0;
+
+    private:
+        static const size_t kStopped = size_t(1) << (sizeof(size_t) * 8 - 1);
+
+        /** Run up to kBatchSize units of work. Called by an Executor worker thread.
+
+            \return true if there is more work to do
+        */
+        bool run();
+
+        /** Remove units of work from the pending count, waking up any thread waiting in stop() if there are no
+            more.
+
+            \param count number of units to remove
+
+            \return true if there are still units pending
+        */
+        bool finished(size_t count);
+
+        Executor& executor_;
+        std::atomic<size_t> pending_;
+        std::mutex mutex_;
+        std::condition_variable idle_;
+
+        friend class Executor;
+    };
+
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Obtain the executor shared by all of the tasks in the process. Created the first time it is used, with
+        one worker per processor.
+
+        \return executor reference
+    */
+    static Executor& Instance();
+
+    /** Constructor. Starts the worker threads.
+
+        \param workerCount number of worker threads. If zero, use one per processor.
+
+        \param pinned if true, bind each worker to its own processor
+    */
+    Executor(size_t workerCount = 0, bool pinned = true);
+
+    /** Destructor. Stops and joins the worker threads. All actors must have been stopped.
+     */
+    ~Executor();
+
+    /** \return number of worker threads
+     */
+    size_t getWorkerCount() const { return workers_.size(); }
+
+    /** \return number of times an actor was run
+     */
+    size_t getRunCount() const { return runs_; }
+
+    /** \return number of times a worker took an actor from the run queue of another worker
+     */
+    size_t getStealCount() const { return steals_; }
+
+private:
+    struct Worker {
+        Worker() : mutex(), queue(), thread() {}
+        std::mutex mutex;
+        std::deque<Actor*> queue;
+        std::thread thread;
+    };
+
+    /** Add an actor to a run queue. Uses the queue of the calling worker thread if there is one, so that the
+        next stage of a stream tends to run on the same processor as the stage that fed it.
+
+        \param actor the actor to schedule
+    */
+    void schedule(Actor* actor);
+
+    /** Obtain an actor to run, from the worker's own queue or from another.
+
+        \param index index of the worker looking for work
+
+        \return actor to run, or NULL if there is none
+    */
+    Actor* take(size_t index);
+
+    /** Main loop of a worker thread.
+
+        \param index index of the worker
+    */
+    void workerMain(size_t index);
+
+    std::vector<Worker*> workers_;
+    std::atomic<size_t> queued_;
+    std::atomic<size_t> next_;
+    std::atomic<size_t> runs_;
+    std::atomic<size_t> steals_;
+    std::atomic<size_t> sleepers_;
+    std::mutex sleepMutex_;
+    std::condition_variable wakeup_;
+    bool stopping_;
+};
+
+} // end namespace IO
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
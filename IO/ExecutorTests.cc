@@ -0,0 +1,262 @@
+#include <sys/resource.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "Executor.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+
+/** Queue of integer messages shared by the two pipeline models in the benchmark.
+ */
+struct MessageQueue {
+    MessageQueue() : mutex(), ready(), messages(), closed(false) {}
+
+    void push(int value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            messages.push_back(value);
+        }
+
+        ready.notify_one();
+    }
+
+    bool pop(int& value)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return closed || !messages.empty(); });
+        if (messages.empty()) return false;
+        value = messages.front();
+        messages.pop_front();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+
+        ready.notify_all();
+    }
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<int> messages;
+    bool closed;
+};
+
+/** Pipeline stage run by an Executor. Checks that it only ever runs in one thread at a time, and that it sees
+    its messages in order.
+*/
+struct Stage : public Executor::Actor {
+    Stage(Executor& executor, Stage* next) :
+        Actor(executor), next(next), queue(), inside(false), overlaps(0), disorders(0), last(-1), count(0)
+    {
+    }
+
+    void post(int value)
+    {
+        queue.push(value);
+        notify();
+    }
+
+    void runOne()
+    {
+        if (inside.exchange(true)) ++overlaps;
+        int value;
+        if (queue.pop(value)) {
+            if (value <= last) ++disorders;
+            last = value;
+            ++count;
+            if (next) next->post(value);
+        }
+
+        inside = false;
+    }
+
+    Stage* next;
+    MessageQueue queue;
+    std::atomic<bool> inside;
+    std::atomic<int> overlaps;
+    int disorders;
+    int last;
+    std::atomic<int> count;
+};
+
+class ExecutorTest : public UnitTest::TestObj {
+public:
+    ExecutorTest() : TestObj("Executor") {}
+
+    void test();
+
+    /** \return number of context switches of the process so far
+     */
+    static long GetContextSwitches();
+
+    void testPipeline();
+
+    void testFanIn();
+
+    void testStop();
+
+    void testBenchmark();
+};
+
+long
+ExecutorTest::GetContextSwitches()
+{
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+void
+ExecutorTest::testPipeline()
+{
+    Executor executor(4, false);
+    enum { kStages = 10, kCount = 20000 };
+    std::vector<Stage*> stages(kStages, 0);
+    for (int index = kStages - 1; index >= 0; --index) {
+        stages[index] = new Stage(executor, index == kStages - 1 ? 0 : stages[index + 1]);
+    }
+
+    for (int value = 0; value < kCount; ++value) stages[0]->post(value);
+    while (stages.back()->count != kCount) std::this_thread::yield();
+
+    for (int index = 0; index < kStages; ++index) {
+        assertEqual(kCount, int(stages[index]->count));
+        assertEqual(0, int(stages[index]->overlaps));
+        assertEqual(0, stages[index]->disorders);
+        delete stages[index];
+    }
+
+    assertTrue(executor.getRunCount() > 0);
+}
+
+void
+ExecutorTest::testFanIn()
+{
+    // Many threads feeding one actor must not make it run in more than one worker at a time.
+    //
+    Executor executor(4, false);
+    Stage sink(executor, 0);
+    std::vector<std::thread> threads;
+    std::mutex order;
+    int next = 0;
+    for (int index = 0; index < 4; ++index) {
+        threads.emplace_back([&]() {
+            for (int count = 0; count < 10000; ++count) {
+                std::lock_guard<std::mutex> lock(order);
+                sink.post(next++);
+            }
+        });
+    }
+
+    for (auto& thread : threads) thread.join();
+    while (sink.count != 40000) std::this_thread::yield();
+    assertEqual(0, int(sink.overlaps));
+    assertEqual(0, sink.disorders);
+}
+
+void
+ExecutorTest::testStop()
+{
+    Executor executor(2, false);
+    Stage stage(executor, 0);
+    for (int value = 0; value < 1000; ++value) stage.post(value);
+    stage.stop();
+    assertEqual(size_t(0), stage.getPendingCount());
+    int count = stage.count;
+
+    // Once stopped, the actor never runs again.
+    //
+    stage.post(1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    assertEqual(count, int(stage.count));
+    assertEqual(size_t(0), stage.getPendingCount());
+}
+
+void
+ExecutorTest::testBenchmark()
+{
+    // Pass messages down a 40 stage pipeline, first with a thread per stage, the way threaded Controllers run,
+    // and then with a pool of 4 workers.
+    //
+    enum { kStages = 40, kCount = 20000, kWorkers = 4 };
+
+    long switches = GetContextSwitches();
+    Time::TimeStamp start(Time::TimeStamp::Now());
+    {
+        std::vector<MessageQueue> queues(kStages + 1);
+        std::vector<std::thread> threads;
+        for (int index = 0; index < kStages; ++index) {
+            threads.emplace_back([&queues, index]() {
+                int value;
+                while (queues[index].pop(value)) queues[index + 1].push(value);
+                queues[index + 1].close();
+            });
+        }
+
+        for (int value = 0; value < kCount; ++value) queues[0].push(value);
+        queues[0].close();
+        int value, count = 0;
+        while (queues[kStages].pop(value)) ++count;
+        assertEqual(int(kCount), count);
+        for (auto& thread : threads) thread.join();
+    }
+
+    Time::TimeStamp threadedDelta(Time::TimeStamp::Now());
+    threadedDelta -= start;
+    long threadedSwitches = GetContextSwitches() - switches;
+
+    switches = GetContextSwitches();
+    start = Time::TimeStamp::Now();
+    {
+        Executor executor(kWorkers);
+        std::vector<Stage*> stages(kStages, 0);
+        for (int index = kStages - 1; index >= 0; --index) {
+            stages[index] = new Stage(executor, index == kStages - 1 ? 0 : stages[index + 1]);
+        }
+
+        for (int value = 0; value < kCount; ++value) stages[0]->post(value);
+        while (stages.back()->count != kCount) std::this_thread::yield();
+        for (int index = 0; index < kStages; ++index) delete stages[index];
+    }
+
+    Time::TimeStamp pooledDelta(Time::TimeStamp::Now());
+    pooledDelta -= start;
+    long pooledSwitches = GetContextSwitches() - switches;
+
+    std::clog << kStages << " stages, " << kCount << " messages\n"
+              << "thread per stage: " << threadedDelta.asDouble() << " s, " << kCount / threadedDelta.asDouble()
+              << " msgs/s, " << threadedSwitches << " context switches\n"
+              << kWorkers << " workers: " << pooledDelta.asDouble() << " s, " << kCount / pooledDelta.asDouble()
+              << " msgs/s, " << pooledSwitches << " context switches" << std::endl;
+}
+
+void
+ExecutorTest::test()
+{
+    testPipeline();
+    testFanIn();
+    testStop();
+    testBenchmark();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return ExecutorTest().mainRun();
+}
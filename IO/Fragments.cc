@@ -0,0 +1,182 @@
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "ace/CDR_Base.h"
+#include "ace/Message_Block.h"
+
+#include "Logger/Log.h"
+
+#include "Fragments.h"
+#include "MessageManager.h"
+
+using namespace SideCar::IO;
+
+void
+FragmentHeader::write(char* buffer) const
+{
+    uint32_t words[5] = {htonl(kMagic), htonl(sender), htonl(messageId), htonl(totalSize), htonl(offset)};
+    uint16_t shorts[2] = {htons(index), htons(count)};
+    ::memcpy(buffer, words, sizeof(words));
+    ::memcpy(buffer + sizeof(words), shorts, sizeof(shorts));
+}
+
+bool
+FragmentHeader::read(const char* buffer, size_t size)
+{
+    if (size <= kSize) return false;
+    uint32_t words[5];
+    uint16_t shorts[2];
+    ::memcpy(words, buffer, sizeof(words));
+    if (ntohl(words[0]) != kMagic) return false;
+    ::memcpy(shorts, buffer + sizeof(words), sizeof(shorts));
+    sender = ntohl(words[1]);
+    messageId = ntohl(words[2]);
+    totalSize = ntohl(words[3]);
+    offset = ntohl(words[4]);
+    index = ntohs(shorts[0]);
+    count = ntohs(shorts[1]);
+    return true;
+}
+
+DatagramFragmenter::DatagramFragmenter(size_t maxDatagramSize) :
+    maxDatagramSize_(), sender_(), nextMessageId_(0), fragmented_(0), parts_()
+{
+    setMaxDatagramSize(maxDatagramSize);
+
+    // The sender tag only needs to differ between the writers that send to one reader.
+    //
+    static uint32_t counter = 0;
+    sender_ = (uint32_t(::getpid()) << 12) ^ (uint32_t(Time::TimeStamp::Now().getMicro()) << 8) ^ ++counter;
+}
+
+void
+DatagramFragmenter::setMaxDatagramSize(size_t maxDatagramSize)
+{
+    maxDatagramSize_ = std::max(maxDatagramSize, size_t(kMinDatagramSize));
+}
+
+Logger::Log&
+DatagramAssembler::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.DatagramAssembler");
+    return log_;
+}
+
+DatagramAssembler::DatagramAssembler(double timeout, size_t maxPending, size_t maxBytes) :
+    timeout_(timeout), maxPending_(std::max(maxPending, size_t(1))), maxBytes_(maxBytes), pendingBytes_(0),
+    pending_(), completed_(0), incomplete_(0), invalid_(0)
+{
+    ;
+}
+
+DatagramAssembler::~DatagramAssembler()
+{
+    for (auto pos = pending_.begin(); pos != pending_.end(); ++pos) pos->second.data->release();
+}
+
+ACE_Message_Block*
+DatagramAssembler::add(const FragmentHeader& header, const char* data, size_t size, const Time::TimeStamp& now)
+{
+    static Logger::ProcLog log("add", Log());
+
+    if (!header.count || header.index >= header.count || !header.totalSize ||
+        header.totalSize > kMaxMessageSize || header.offset > header.totalSize ||
+        size > header.totalSize - header.offset) {
+        LOGWARNING << "invalid fragment - index: " << header.index << " count: " << header.count
+                   << " offset: " << header.offset << " size: " << size << " total: " << header.totalSize
+                   << std::endl;
+        ++invalid_;
+        return 0;
+    }
+
+    Key key(header.sender, header.messageId);
+    PartialMap::iterator pos = pending_.find(key);
+    if (pos == pending_.end()) {
+        // Make room for the new message by dropping the oldest ones.
+        //
+        while (!pending_.empty() &&
+               (pending_.size() >= maxPending_ || pendingBytes_ + header.totalSize > maxBytes_)) {
+            PartialMap::iterator oldest = pending_.begin();
+            for (PartialMap::iterator scan = pending_.begin(); scan != pending_.end(); ++scan) {
+                if (scan->second.firstSeen < oldest->second.firstSeen) oldest = scan;
+            }
+
+            LOGWARNING << "no room for message " << header.messageId << " - dropping message "
+                       << oldest->first.second << std::endl;
+            drop(oldest);
+        }
+
+        if (header.totalSize > maxBytes_) {
+            ++incomplete_;
+            return 0;
+        }
+
+        // The message gets its own aligned block, ready for CDR decoding.
+        //
+        Partial partial;
+        partial.data = MessageManager::MakeMessageBlock(header.totalSize + ACE_CDR::MAX_ALIGNMENT);
+        ACE_CDR::mb_align(partial.data);
+        partial.seen.resize(header.count, false);
+        partial.totalSize = header.totalSize;
+        partial.received = 0;
+        partial.remaining = header.count;
+        partial.firstSeen = now.asDouble();
+        pos = pending_.insert(std::make_pair(key, partial)).first;
+        pendingBytes_ += header.totalSize;
+    }
+
+    Partial& partial(pos->second);
+    if (partial.totalSize != header.totalSize || partial.seen.size() != header.count || partial.seen[header.index]) {
+        ++invalid_;
+        return 0;
+    }
+
+    ::memcpy(partial.data->wr_ptr() + header.offset, data, size);
+    partial.seen[header.index] = true;
+    partial.received += size;
+    if (--partial.remaining) return 0;
+
+    ACE_Message_Block* message = partial.data;
+    if (partial.received != partial.totalSize) {
+        LOGWARNING << "fragments of message " << header.messageId << " hold " << partial.received
+                   << " bytes instead of " << partial.totalSize << std::endl;
+        drop(pos);
+        return 0;
+    }
+
+    message->wr_ptr(partial.totalSize);
+    pendingBytes_ -= partial.totalSize;
+    pending_.erase(pos);
+    ++completed_;
+    return message;
+}
+
+void
+DatagramAssembler::expire(const Time::TimeStamp& now)
+{
+    static Logger::ProcLog log("expire", Log());
+    if (pending_.empty()) return;
+
+    double limit = now.asDouble() - timeout_;
+    PartialMap::iterator pos = pending_.begin();
+    while (pos != pending_.end()) {
+        if (pos->second.firstSeen > limit) {
+            ++pos;
+        } else {
+            LOGWARNING << "timed out waiting for message " << pos->first.second << " - missing "
+                       << pos->second.remaining << " of " << pos->second.seen.size() << " fragments" << std::endl;
+            drop(pos++);
+        }
+    }
+}
+
+void
+DatagramAssembler::drop(PartialMap::iterator pos)
+{
+    pos->second.data->release();
+    pendingBytes_ -= pos->second.totalSize;
+    pending_.erase(pos);
+    ++incomplete_;
+}
@@ -0,0 +1,282 @@
+#ifndef SIDECAR_IO_FRAGMENTS_H // -*- C++ -*-
+#define SIDECAR_IO_FRAGMENTS_H
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "Time/TimeStamp.h"
+
+class ACE_Message_Block;
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace IO {
+
+/** Header found at the start of each datagram that carries part of a message too big for one datagram. The
+    header is kSize bytes long, in network byte order:
+
+    - magic value 'SCFR'
+    - sender tag, which keeps apart messages from different writers that share a reader socket
+    - message ID, which increases with every fragmented message from a sender
+    - total size of the message in bytes
+    - byte offset of the fragment within the message
+    - fragment index and fragment count (16 bits each)
+
+    The magic value does not look like the start of a SideCar Preamble, so a reader can tell fragments and
+    whole messages apart.
+*/
+struct FragmentHeader {
+    enum { kSize = 24, kMagic = 0x53434652 };
+
+    /** Write the header into a buffer.
+
+        \param buffer location to write kSize bytes
+    */
+    void write(char* buffer) const;
+
+    /** Read a header from the start of a datagram. Only checks the magic value and the datagram size; see
+        DatagramAssembler for the rest of the checks.
+
+        \param buffer start of the datagram
+
+        \param size number of bytes in the datagram
+
+        \return true if the datagram starts with a fragment header
+    */
+    bool read(const char* buffer, size_t size);
+
+    uint32_t sender;
+    uint32_t messageId;
+    uint32_t totalSize;
+    uint32_t offset;
+    uint16_t index;
+    uint16_t count;
+};
+
+/** Splits messages that are larger than a maximum datagram size into fragments, each with a FragmentHeader.
+    Smaller messages go out unchanged. The default size fills a standard 1500 byte Ethernet frame (less 28
+    bytes of IP and UDP headers), so that the IP layer never has to fragment, since losing one IP fragment
+    loses the whole datagram, and some switches and firewalls drop IP fragments outright.
+*/
+class DatagramFragmenter {
+public:
+    enum { kDefaultMaxDatagramSize = 1500 - 28, kMinDatagramSize = 256 };
+
+    /** Constructor.
+
+        \param maxDatagramSize largest datagram to send
+    */
+    DatagramFragmenter(size_t maxDatagramSize = kDefaultMaxDatagramSize);
+
+    /** Change the largest datagram to send. Use 9000 - 28 for networks with jumbo frames.
+
+        \param maxDatagramSize new value
+    */
+    void setMaxDatagramSize(size_t maxDatagramSize);
+
+    /** \return largest datagram to send
+     */
+    size_t getMaxDatagramSize() const { return maxDatagramSize_; }
+
+    /** \return number of messages that were fragmented
+     */
+    size_t getFragmentedCount() const { return fragmented_; }
+
+    /** Send a message, fragmenting it if necessary.
+
+        \param iov first of the iovec structures that hold the message
+
+        \param count number of iovec structures
+
+        \param sender functor invoked as sender(const iovec*, int) to send one datagram. It must return the number
+        of bytes sent, or -1 if error.
+
+        \return number of message bytes sent, or -1 if error
+    */
+    template <typename Sender>
+    ssize_t send(const iovec* iov, int count, Sender sender);
+
+private:
+    size_t maxDatagramSize_;
+    uint32_t sender_;
+    uint32_t nextMessageId_;
+    size_t fragmented_;
+    std::vector<iovec> parts_;
+};
+
+/** Rebuilds messages from the fragments made by a DatagramFragmenter. Fragments may arrive in any order.
+    Memory is bounded: there is a limit on the number of partial messages, and on the bytes they hold. When a
+    limit is reached, the oldest partial message is dropped. Partial messages that do not complete within a
+    timeout are dropped too. Dropped messages show up in getIncompleteCount(). Not thread-safe.
+*/
+class DatagramAssembler {
+public:
+    enum {
+        kDefaultMaxPending = 32,
+        kDefaultMaxBytes = 64 * 1024 * 1024,
+        kMaxMessageSize = 64 * 1024 * 1024,
+    };
+
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Constructor.
+
+        \param timeout seconds to wait for the rest of a message after its first fragment arrives
+
+        \param maxPending maximum number of partial messages
+
+        \param maxBytes maximum number of bytes held by partial messages
+    */
+    DatagramAssembler(double timeout = 0.25, size_t maxPending = kDefaultMaxPending,
+                      size_t maxBytes = kDefaultMaxBytes);
+
+    /** Destructor. Releases any partial messages.
+     */
+    ~DatagramAssembler();
+
+    /** Add a fragment.
+
+        \param header fragment header, as read from the datagram
+
+        \param data fragment data that follows the header
+
+        \param size number of bytes of fragment data
+
+        \param now current time
+
+        \return the completed message if this was the last fragment missing (caller takes ownership), or NULL
+    */
+    ACE_Message_Block* add(const FragmentHeader& header, const char* data, size_t size,
+                           const Time::TimeStamp& now);
+
+    /** Drop partial messages that have waited longer than the timeout.
+
+        \param now current time
+    */
+    void expire(const Time::TimeStamp& now);
+
+    /** \return number of partial messages
+     */
+    size_t getPendingCount() const { return pending_.size(); }
+
+    /** \return number of messages rebuilt from fragments
+     */
+    size_t getCompletedCount() const { return completed_; }
+
+    /** \return number of messages dropped before all of their fragments arrived
+     */
+    size_t getIncompleteCount() const { return incomplete_; }
+
+    /** \return number of fragments that did not make sense, or that arrived more than once
+     */
+    size_t getInvalidCount() const { return invalid_; }
+
+private:
+    using Key = std::pair<uint32_t, uint32_t>;
+
+    struct Partial {
+        ACE_Message_Block* data;
+        std::vector<bool> seen;
+        uint32_t totalSize;
+        uint32_t received;
+        uint16_t remaining;
+        double firstSeen;
+    };
+
+    using PartialMap = std::map<Key, Partial>;
+
+    void drop(PartialMap::iterator pos);
+
+    double timeout_;
+    size_t maxPending_;
+    size_t maxBytes_;
+    size_t pendingBytes_;
+    PartialMap pending_;
+    size_t completed_;
+    size_t incomplete_;
+    size_t invalid_;
+};
+
+template <typename Sender>
+ssize_t
+DatagramFragmenter::send(const iovec* iov, int count, Sender sender)
+{
+    size_t total = 0;
+    for (int index = 0; index < count; ++index) total += iov[index].iov_len;
+    if (total <= maxDatagramSize_) return sender(iov, count);
+
+    size_t chunk = maxDatagramSize_ - FragmentHeader::kSize;
+    size_t fragmentCount = (total + chunk - 1) / chunk;
+    if (fragmentCount > 0xFFFF || total > DatagramAssembler::kMaxMessageSize) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    ++fragmented_;
+    FragmentHeader header;
+    header.sender = sender_;
+    header.messageId = nextMessageId_++;
+    header.totalSize = uint32_t(total);
+    header.count = uint16_t(fragmentCount);
+
+    char buffer[FragmentHeader::kSize];
+    int source = 0;
+    size_t sourceOffset = 0;
+    for (size_t offset = 0, index = 0; offset < total; offset += chunk, ++index) {
+        header.offset = uint32_t(offset);
+        header.index = uint16_t(index);
+        header.write(buffer);
+
+        // Gather the next chunk of the message behind the header without copying it.
+        //
+        parts_.clear();
+        iovec part;
+        part.iov_base = buffer;
+        part.iov_len = FragmentHeader::kSize;
+        parts_.push_back(part);
+
+        size_t needed = std::min(chunk, total - offset);
+        while (needed) {
+            size_t available = iov[source].iov_len - sourceOffset;
+            size_t taken = std::min(needed, available);
+            if (taken) {
+                part.iov_base = static_cast<char*>(iov[source].iov_base) + sourceOffset;
+                part.iov_len = taken;
+                parts_.push_back(part);
+                sourceOffset += taken;
+                needed -= taken;
+            }
+
+            if (sourceOffset == iov[source].iov_len) {
+                ++source;
+                sourceOffset = 0;
+            }
+        }
+
+        if (sender(&parts_[0], int(parts_.size())) == -1) return -1;
+    }
+
+    return total;
+}
+
+} // end namespace IO
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ace/Message_Block.h"
+
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "Fragments.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+
+class FragmentsTest : public UnitTest::TestObj {
+public:
+    FragmentsTest() : TestObj("Fragments") {}
+
+    void test();
+
+    /** Send a message through a fragmenter, capturing the datagrams it would send.
+     */
+    static std::vector<std::string> Send(DatagramFragmenter& fragmenter, const std::string& message);
+
+    /** Give a datagram to an assembler, returning the message if it completed one.
+     */
+    std::string add(DatagramAssembler& assembler, const std::string& datagram, double when);
+
+    static std::string MakeMessage(size_t size, char seed);
+
+    void testSmall();
+
+    void testFragments();
+
+    void testLoss();
+
+    void testLimits();
+};
+
+std::vector<std::string>
+FragmentsTest::Send(DatagramFragmenter& fragmenter, const std::string& message)
+{
+    // Split the message over a few iovec entries the way a preamble and CDR body chain would be.
+    //
+    std::vector<iovec> iovs;
+    size_t offset = 0;
+    size_t sizes[] = {8, 100, 3000, 7};
+    for (size_t index = 0; offset < message.size(); ++index) {
+        size_t size = index < 4 ? std::min(sizes[index], message.size() - offset) : message.size() - offset;
+        iovec iov;
+        iov.iov_base = const_cast<char*>(message.data() + offset);
+        iov.iov_len = size;
+        iovs.push_back(iov);
+        offset += size;
+    }
+
+    std::vector<std::string> datagrams;
+    ssize_t rc = fragmenter.send(&iovs[0], int(iovs.size()), [&](const iovec* parts, int count) {
+        std::string datagram;
+        for (int index = 0; index < count; ++index) {
+            datagram.append(static_cast<const char*>(parts[index].iov_base), parts[index].iov_len);
+        }
+
+        datagrams.push_back(datagram);
+        return ssize_t(datagram.size());
+    });
+
+    if (rc != ssize_t(message.size())) datagrams.clear();
+    return datagrams;
+}
+
+std::string
+FragmentsTest::add(DatagramAssembler& assembler, const std::string& datagram, double when)
+{
+    FragmentHeader header;
+    assertTrue(header.read(datagram.data(), datagram.size()));
+    ACE_Message_Block* data = assembler.add(header, datagram.data() + FragmentHeader::kSize,
+                                            datagram.size() - FragmentHeader::kSize, Time::TimeStamp(when));
+    if (!data) return "";
+    std::string message(data->rd_ptr(), data->length());
+    data->release();
+    return message;
+}
+
+std::string
+FragmentsTest::MakeMessage(size_t size, char seed)
+{
+    std::string message(size, 0);
+    for (size_t index = 0; index < size; ++index) message[index] = char(seed + index * 7 + index / 251);
+    return message;
+}
+
+void
+FragmentsTest::testSmall()
+{
+    // Messages that fit go out as is, and are not mistaken for fragments.
+    //
+    DatagramFragmenter fragmenter;
+    std::string message(MakeMessage(DatagramFragmenter::kDefaultMaxDatagramSize, 'a'));
+    std::vector<std::string> datagrams(Send(fragmenter, message));
+    assertEqual(size_t(1), datagrams.size());
+    assertTrue(datagrams[0] == message);
+    assertEqual(size_t(0), fragmenter.getFragmentedCount());
+
+    FragmentHeader header;
+    assertFalse(header.read(datagrams[0].data(), datagrams[0].size()));
+}
+
+void
+FragmentsTest::testFragments()
+{
+    DatagramFragmenter fragmenter;
+    DatagramAssembler assembler;
+    size_t chunk = DatagramFragmenter::kDefaultMaxDatagramSize - FragmentHeader::kSize;
+
+    // A message one byte too big for a datagram, and a large one.
+    //
+    for (size_t size : {size_t(DatagramFragmenter::kDefaultMaxDatagramSize) + 1, size_t(200000)}) {
+        std::string message(MakeMessage(size, 'x'));
+        std::vector<std::string> datagrams(Send(fragmenter, message));
+        assertEqual((size + chunk - 1) / chunk, datagrams.size());
+        for (size_t index = 0; index < datagrams.size(); ++index) {
+            assertTrue(datagrams[index].size() <= DatagramFragmenter::kDefaultMaxDatagramSize);
+        }
+
+        // Deliver them in reverse order, with a duplicate in the middle.
+        //
+        std::string rebuilt;
+        for (size_t index = datagrams.size(); index > 0; --index) {
+            if (index == datagrams.size() / 2) assertEqual(std::string(), add(assembler, datagrams[index], 1.0));
+            rebuilt = add(assembler, datagrams[index - 1], 1.0);
+            if (index > 1) assertEqual(std::string(), rebuilt);
+        }
+
+        assertTrue(rebuilt == message);
+    }
+
+    assertEqual(size_t(2), fragmenter.getFragmentedCount());
+    assertEqual(size_t(2), assembler.getCompletedCount());
+    assertEqual(size_t(0), assembler.getPendingCount());
+    assertEqual(size_t(0), assembler.getIncompleteCount());
+
+    // Interleaved fragments from two senders with the same message ID.
+    //
+    DatagramFragmenter other;
+    std::string first(MakeMessage(5000, '1'));
+    std::string second(MakeMessage(5000, '2'));
+    std::vector<std::string> one(Send(other, first));
+    DatagramFragmenter another;
+    std::vector<std::string> two(Send(another, second));
+    assertEqual(one.size(), two.size());
+    for (size_t index = 0; index + 1 < one.size(); ++index) {
+        assertEqual(std::string(), add(assembler, one[index], 2.0));
+        assertEqual(std::string(), add(assembler, two[index], 2.0));
+    }
+
+    assertTrue(add(assembler, two.back(), 2.0) == second);
+    assertTrue(add(assembler, one.back(), 2.0) == first);
+}
+
+void
+FragmentsTest::testLoss()
+{
+    DatagramFragmenter fragmenter(1000);
+    DatagramAssembler assembler(0.1);
+
+    // Lose one fragment; the message times out and the next one still gets through.
+    //
+    std::vector<std::string> lost(Send(fragmenter, MakeMessage(10000, 'l')));
+    for (size_t index = 1; index < lost.size(); ++index) add(assembler, lost[index], 5.0);
+    assertEqual(size_t(1), assembler.getPendingCount());
+    assembler.expire(Time::TimeStamp(5.05));
+    assertEqual(size_t(1), assembler.getPendingCount());
+    assembler.expire(Time::TimeStamp(5.2));
+    assertEqual(size_t(0), assembler.getPendingCount());
+    assertEqual(size_t(1), assembler.getIncompleteCount());
+
+    std::string message(MakeMessage(10000, 'm'));
+    std::vector<std::string> datagrams(Send(fragmenter, message));
+    std::string rebuilt;
+    for (size_t index = 0; index < datagrams.size(); ++index) rebuilt = add(assembler, datagrams[index], 5.3);
+    assertTrue(rebuilt == message);
+
+    // A late fragment of the lost message starts a new partial message that also times out.
+    //
+    add(assembler, lost[0], 5.4);
+    assembler.expire(Time::TimeStamp(6.0));
+    assertEqual(size_t(2), assembler.getIncompleteCount());
+
+    // Fragments that do not add up are rejected.
+    //
+    FragmentHeader header;
+    assertTrue(header.read(datagrams[0].data(), datagrams[0].size()));
+    header.offset = header.totalSize - 10;
+    assertTrue(assembler.add(header, datagrams[0].data() + FragmentHeader::kSize, 100, Time::TimeStamp(6.0)) == 0);
+    header.offset = 0;
+    header.index = header.count;
+    assertTrue(assembler.add(header, datagrams[0].data() + FragmentHeader::kSize, 100, Time::TimeStamp(6.0)) == 0);
+    assertEqual(size_t(2), assembler.getInvalidCount());
+}
+
+void
+FragmentsTest::testLimits()
+{
+    // Only four partial messages, or 50000 bytes, at a time. The oldest goes first.
+    //
+    DatagramFragmenter fragmenter(1000);
+    DatagramAssembler assembler(1.0, 4, 50000);
+    std::vector<std::vector<std::string>> messages;
+    for (int index = 0; index < 6; ++index) {
+        messages.push_back(Send(fragmenter, MakeMessage(10000, char('A' + index))));
+        add(assembler, messages.back()[0], 10.0 + index * 0.01);
+        assertTrue(assembler.getPendingCount() <= 4);
+    }
+
+    assertEqual(size_t(4), assembler.getPendingCount());
+    assertEqual(size_t(2), assembler.getIncompleteCount());
+
+    std::string rebuilt;
+    for (size_t index = 1; index < messages[5].size(); ++index) rebuilt = add(assembler, messages[5][index], 10.1);
+    assertTrue(rebuilt == MakeMessage(10000, 'F'));
+
+    std::vector<std::string> big(Send(fragmenter, MakeMessage(40000, 'B')));
+    add(assembler, big[0], 10.2);
+    assertEqual(size_t(2), assembler.getPendingCount());
+    assertEqual(size_t(4), assembler.getIncompleteCount());
+}
+
+void
+FragmentsTest::test()
+{
+    testSmall();
+    testFragments();
+    testLoss();
+    testLimits();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return FragmentsTest().mainRun();
+}
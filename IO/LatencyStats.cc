@@ -0,0 +1,72 @@
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+#include "Logger/Log.h"
+
+#include "LatencyStats.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+
+std::atomic<bool> LatencyStats::enabled_(false);
+
+Logger::Log&
+LatencyStats::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.LatencyStats");
+    return log_;
+}
+
+void
+LatencyStats::SetEnabled(bool enabled)
+{
+    Logger::ProcLog log("SetEnabled", Log());
+    LOGWARNING << "latency tracing: " << enabled << std::endl;
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+int64_t
+LatencyStats::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void
+LatencyStats::record(int64_t origin, int64_t delivered, int64_t start, int64_t end)
+{
+    if (delivered) queueWait_.record(start - delivered);
+    processing_.record(end - start);
+    if (origin) latency_.record(end - origin);
+}
+
+void
+LatencyStats::reset()
+{
+    queueWait_.reset();
+    processing_.reset();
+    latency_.reset();
+}
+
+/** Write the 50th, 99th, and 99.9th percentiles of a histogram of nanosecond values as microseconds.
+ */
+static void
+FormatPercentiles(std::ostream& os, const char* name, const Utils::HdrHistogram& histogram)
+{
+    os << name << ' ' << histogram.getValueAtPercentile(50.0) / 1000.0 << '/'
+       << histogram.getValueAtPercentile(99.0) / 1000.0 << '/' << histogram.getValueAtPercentile(99.9) / 1000.0;
+}
+
+std::string
+LatencyStats::format() const
+{
+    if (!processing_.getCount()) return "";
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(1) << "msgs " << processing_.getCount() << " us p50/p99/p999 ";
+    FormatPercentiles(os, "wait", queueWait_);
+    FormatPercentiles(os << ' ', "proc", processing_);
+    FormatPercentiles(os << ' ', "latency", latency_);
+    return os.str();
+}
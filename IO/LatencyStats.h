@@ -0,0 +1,91 @@
+#ifndef SIDECAR_IO_LATENCYSTATS_H // -*- C++ -*-
+#define SIDECAR_IO_LATENCYSTATS_H
+
+#include <atomic>
+#include <string>
+
+#include "Utils/HdrHistogram.h"
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace IO {
+
+/** Latency statistics of the messages processed by an IO::Task. Tracing is off until SetEnabled() turns it on
+    for the whole process. When on, a task that sends a message without a trace origin (see
+    Messages::Header::getTraceOrigin()) gives it one, so the origin is the time the data entered the process,
+    such as at a VME or network reader. A task notes when each message is delivered to it, and then records
+    three values:
+
+    - queue wait: from the time the message was delivered to the time the task started on it
+    - processing: how long the task took with the message
+    - latency: from the origin of the message to the time the task finished with it
+*/
+class LatencyStats {
+public:
+    /** Obtain the log device to use for LatencyStats objects.
+
+        \return Log device
+    */
+    static Logger::Log& Log();
+
+    /** Turn latency tracing on or off for all tasks.
+
+        \param enabled true to turn on
+    */
+    static void SetEnabled(bool enabled);
+
+    /** \return true if latency tracing is on
+     */
+    static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /** \return current time from a monotonic clock in nanoseconds
+     */
+    static int64_t Now();
+
+    /** Record the timing of one message. The caller must fetch the origin of the message before it processes
+        it, since a task that forwards the message it received may change it.
+
+        \param origin when the message entered the process (see Messages::Header::getTraceOrigin()), or 0
+
+        \param delivered when the message was delivered to the task, or 0 if not known
+
+        \param start when the task started on the message (see Now())
+
+        \param end when the task finished with the message
+    */
+    void record(int64_t origin, int64_t delivered, int64_t start, int64_t end);
+
+    /** Forget all recorded values.
+     */
+    void reset();
+
+    const Utils::HdrHistogram& getQueueWait() const { return queueWait_; }
+
+    const Utils::HdrHistogram& getProcessing() const { return processing_; }
+
+    const Utils::HdrHistogram& getLatency() const { return latency_; }
+
+    /** Obtain a one-line summary of the 50th, 99th, and 99.9th percentiles of each value.
+
+        \return text, or an empty string if nothing was recorded
+    */
+    std::string format() const;
+
+private:
+    static std::atomic<bool> enabled_;
+
+    Utils::HdrHistogram queueWait_;
+    Utils::HdrHistogram processing_;
+    Utils::HdrHistogram latency_;
+};
+
+} // end namespace IO
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
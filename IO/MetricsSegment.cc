@@ -0,0 +1,230 @@
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <new>
+
+#include "Logger/Log.h"
+#include "Utils/Format.h"
+
+#include "MetricsSegment.h"
+
+using namespace SideCar::IO;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory metrics need lock-free 64-bit atomics");
+
+/** Layout of the shared memory segment. The creator fills in a slot before it advances taskCount, so a reader
+    that sees the new count also sees the slot name.
+*/
+struct MetricsSegment::Header {
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t slotSize;
+    int32_t pid;
+    std::atomic<uint32_t> taskCount;
+    TaskMetrics tasks[MetricsSegment::kMaxTasks];
+};
+
+namespace {
+
+const uint32_t kMagic = 0x53434D54; // "SCMT"
+const uint32_t kVersion = 1;
+
+} // namespace
+
+MetricsSegment::Ref MetricsSegment::instance_;
+
+void
+MetricsSegment::TaskMetrics::addProcessingTime(uint64_t elapsed)
+{
+    processed.fetch_add(1, std::memory_order_relaxed);
+    processingTime.fetch_add(elapsed, std::memory_order_relaxed);
+
+    // A task without its own thread records from whichever upstream thread calls its put() method, so several
+    // threads may race to raise the maximum.
+    //
+    uint64_t max = maxProcessingTime.load(std::memory_order_relaxed);
+    while (elapsed > max && !maxProcessingTime.compare_exchange_weak(max, elapsed, std::memory_order_relaxed))
+        ;
+}
+
+void
+MetricsSegment::TaskMetrics::reset()
+{
+    messages.store(0, std::memory_order_relaxed);
+    bytes.store(0, std::memory_order_relaxed);
+    drops.store(0, std::memory_order_relaxed);
+    dupes.store(0, std::memory_order_relaxed);
+    queueDrops.store(0, std::memory_order_relaxed);
+    processed.store(0, std::memory_order_relaxed);
+    processingTime.store(0, std::memory_order_relaxed);
+    maxProcessingTime.store(0, std::memory_order_relaxed);
+}
+
+Logger::Log&
+MetricsSegment::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.MetricsSegment");
+    return log_;
+}
+
+std::string
+MetricsSegment::MakeName(const std::string& runnerName)
+{
+    // Segment names may not hold any more '/' characters.
+    //
+    std::string name("/SideCar.metrics.");
+    for (char c : runnerName) name += (c == '/' || ::isspace(c)) ? '_' : c;
+    return name;
+}
+
+MetricsSegment::Ref
+MetricsSegment::Create(const std::string& name)
+{
+    static Logger::ProcLog log("Create", Log());
+    LOGINFO << "name: " << name << std::endl;
+
+    // Remove any segment left behind by an earlier process with the same name.
+    //
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0664);
+    if (fd == -1) {
+        LOGERROR << "failed to create segment " << name << " - " << Utils::showErrno() << std::endl;
+        return Ref();
+    }
+
+    size_t mapped = sizeof(Header);
+    void* base = MAP_FAILED;
+    if (::ftruncate(fd, mapped) == 0) base = ::mmap(0, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        LOGERROR << "failed to map segment " << name << " - " << Utils::showErrno() << std::endl;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return Ref();
+    }
+
+    ::close(fd);
+
+    // The new segment is all zeros, which is a valid starting value for every slot. Write the magic value last
+    // so that a reader that attaches early does not see a partial header.
+    //
+    Header* header = new (base) Header;
+    header->version = kVersion;
+    header->slotSize = sizeof(TaskMetrics);
+    header->pid = ::getpid();
+    header->taskCount = 0;
+    header->magic.store(kMagic, std::memory_order_release);
+
+    return Ref(new MetricsSegment(name, base, mapped, true));
+}
+
+MetricsSegment::Ref
+MetricsSegment::Attach(const std::string& name)
+{
+    static Logger::ProcLog log("Attach", Log());
+    LOGINFO << "name: " << name << std::endl;
+
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        LOGERROR << "failed to open segment " << name << " - " << Utils::showErrno() << std::endl;
+        return Ref();
+    }
+
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && size_t(st.st_size) == sizeof(Header)) {
+        base = ::mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        LOGERROR << "failed to map segment " << name << " - " << Utils::showErrno() << std::endl;
+        return Ref();
+    }
+
+    Header* header = static_cast<Header*>(base);
+    if (header->magic.load(std::memory_order_acquire) != kMagic || header->version != kVersion ||
+        header->slotSize != sizeof(TaskMetrics)) {
+        LOGERROR << "segment " << name << " has an unknown layout - version: " << header->version << std::endl;
+        ::munmap(base, st.st_size);
+        return Ref();
+    }
+
+    return Ref(new MetricsSegment(name, base, st.st_size, false));
+}
+
+void
+MetricsSegment::SetInstance(const Ref& segment)
+{
+    instance_ = segment;
+}
+
+const MetricsSegment::Ref&
+MetricsSegment::GetInstance()
+{
+    return instance_;
+}
+
+MetricsSegment::MetricsSegment(const std::string& name, void* base, size_t mapped, bool owner) :
+    name_(name), header_(static_cast<Header*>(base)), mapped_(mapped), owner_(owner)
+{
+    ;
+}
+
+MetricsSegment::~MetricsSegment()
+{
+    ::munmap(header_, mapped_);
+    if (owner_) ::shm_unlink(name_.c_str());
+}
+
+int
+MetricsSegment::getOwnerPid() const
+{
+    return header_->pid;
+}
+
+bool
+MetricsSegment::isOwnerAlive() const
+{
+    return ::kill(header_->pid, 0) == 0 || errno == EPERM;
+}
+
+MetricsSegment::TaskMetrics*
+MetricsSegment::addTask(const std::string& name)
+{
+    static Logger::ProcLog log("addTask", Log());
+    LOGINFO << "name: " << name << std::endl;
+
+    if (!owner_) {
+        LOGERROR << "only the creator of " << name_ << " may add tasks" << std::endl;
+        return 0;
+    }
+
+    uint32_t index = header_->taskCount.load(std::memory_order_relaxed);
+    if (index == kMaxTasks) {
+        LOGERROR << "no free slots in " << name_ << " for " << name << std::endl;
+        return 0;
+    }
+
+    TaskMetrics* task = &header_->tasks[index];
+    ::strncpy(task->name, name.c_str(), kNameSize - 1);
+    header_->taskCount.store(index + 1, std::memory_order_release);
+    return task;
+}
+
+size_t
+MetricsSegment::getTaskCount() const
+{
+    return header_->taskCount.load(std::memory_order_acquire);
+}
+
+const MetricsSegment::TaskMetrics&
+MetricsSegment::getTask(size_t index) const
+{
+    return header_->tasks[index];
+}
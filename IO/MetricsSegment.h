@@ -0,0 +1,159 @@
+#ifndef SIDECAR_IO_METRICSSEGMENT_H // -*- C++ -*-
+#define SIDECAR_IO_METRICSSEGMENT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "boost/shared_ptr.hpp"
+
+#include "Utils/Utils.h"
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace IO {
+
+/** Live task metrics held in a POSIX shared memory segment, so that tools such as sidecar-top may watch a runner
+    at a high rate without asking it for anything. The runner creates the segment, and each of its tasks claims a
+    fixed-size slot of counters and gauges that it updates with relaxed atomic operations as it works. Readers
+    only ever load values; they never take a lock or wake a processing thread.
+
+    The segment header holds a layout version. A reader built against a different layout refuses to attach
+    rather than misread the values. Counters only go up, except that a clear-stats request sets them back to
+    zero; readers that compute rates should treat a smaller value as a fresh start.
+*/
+class MetricsSegment : public Utils::Uncopyable {
+    struct Header;
+
+public:
+    using Ref = boost::shared_ptr<MetricsSegment>;
+
+    enum { kMaxTasks = 256, kNameSize = 64 };
+
+    /** Metrics for one task. Each slot starts on its own cache line so that tasks do not slow each other down.
+        All times are in nanoseconds.
+    */
+    struct TaskMetrics {
+        char name[kNameSize];                       ///< Stream and task name, set once when claimed
+        alignas(64) std::atomic<uint64_t> messages; ///< Data messages received
+        std::atomic<uint64_t> bytes;                ///< Bytes of data messages received
+        std::atomic<uint64_t> drops;                ///< Gaps in the sequence numbers of received messages
+        std::atomic<uint64_t> dupes;                ///< Repeated sequence numbers of received messages
+        std::atomic<uint64_t> queueDrops;           ///< Messages shed by the input queue policy
+        std::atomic<uint64_t> processed;            ///< Data messages processed
+        std::atomic<uint64_t> processingTime;       ///< Total time spent processing data messages
+        std::atomic<uint64_t> maxProcessingTime;    ///< Longest time spent on one data message
+        std::atomic<uint32_t> pendingQueueCount;    ///< Messages waiting in the input queue
+        std::atomic<uint32_t> processingState;      ///< Current ProcessingState::Value
+        std::atomic<uint32_t> usingData;            ///< Non-zero if a downstream task wants the output
+
+        /** Record the processing of one data message. Safe to call from several threads at once.
+
+            \param elapsed processing time in nanoseconds
+        */
+        void addProcessingTime(uint64_t elapsed);
+
+        /** Set all counters to zero. Gauges keep their values.
+         */
+        void reset();
+    };
+
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Obtain the name of the segment of a runner.
+
+        \param runnerName name of the runner
+
+        \return segment name
+    */
+    static std::string MakeName(const std::string& runnerName);
+
+    /** Create a new segment. Any existing segment with the same name is removed first. The segment is removed
+        when the returned object is destroyed.
+
+        \param name name of the segment. Should start with a '/' character
+
+        \return new MetricsSegment object, or NULL on failure
+    */
+    static Ref Create(const std::string& name);
+
+    /** Attach to a segment created by another process (or this one) for reading.
+
+        \param name name of the segment
+
+        \return new MetricsSegment object, or NULL if the segment does not exist or has a different layout
+    */
+    static Ref Attach(const std::string& name);
+
+    /** Install the segment that tasks of this process publish to.
+
+        \param segment the segment to use, or NULL to stop publishing
+    */
+    static void SetInstance(const Ref& segment);
+
+    /** \return segment that tasks of this process publish to, or NULL if there is none
+     */
+    static const Ref& GetInstance();
+
+    /** Destructor. Unmaps the segment, and removes it if this object created it.
+     */
+    ~MetricsSegment();
+
+    /** \return name of the shared memory segment
+     */
+    const std::string& getName() const { return name_; }
+
+    /** \return process ID of the creator of the segment
+     */
+    int getOwnerPid() const;
+
+    /** \return true if the process that created the segment still exists
+     */
+    bool isOwnerAlive() const;
+
+    /** Claim the next free slot for a task. Only the process that created the segment may add tasks.
+
+        \param name stream and task name. Truncated to fit
+
+        \return new slot, or NULL if all slots are taken
+    */
+    TaskMetrics* addTask(const std::string& name);
+
+    /** \return number of slots claimed
+     */
+    size_t getTaskCount() const;
+
+    /** Obtain a claimed slot.
+
+        \param index slot to get. Must be less than getTaskCount()
+
+        \return slot reference
+    */
+    const TaskMetrics& getTask(size_t index) const;
+
+private:
+    MetricsSegment(const std::string& name, void* base, size_t mapped, bool owner);
+
+    std::string name_;
+    Header* header_;
+    size_t mapped_;
+    bool owner_;
+
+    static Ref instance_;
+};
+
+} // end namespace IO
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
@@ -0,0 +1,136 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "UnitTest/UnitTest.h"
+
+#include "MetricsSegment.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+
+class MetricsSegmentTest : public UnitTest::TestObj {
+public:
+    MetricsSegmentTest() : TestObj("MetricsSegment") {}
+
+    void test();
+
+    static std::string MakeName(const char* tag);
+
+    void testSlots();
+
+    void testCounters();
+};
+
+std::string
+MetricsSegmentTest::MakeName(const char* tag)
+{
+    std::ostringstream os;
+    os << "sidecar test " << tag << '/' << ::getpid();
+    return MetricsSegment::MakeName(os.str());
+}
+
+void
+MetricsSegmentTest::testSlots()
+{
+    std::string name(MakeName("slots"));
+    assertEqual(std::string::npos, name.find('/', 1));
+    assertEqual(std::string::npos, name.find(' '));
+
+    MetricsSegment::Ref segment(MetricsSegment::Create(name));
+    assertTrue(segment.get() != 0);
+    assertEqual(::getpid(), segment->getOwnerPid());
+    assertTrue(segment->isOwnerAlive());
+    assertEqual(size_t(0), segment->getTaskCount());
+
+    MetricsSegment::Ref reader(MetricsSegment::Attach(name));
+    assertTrue(reader.get() != 0);
+    assertTrue(!MetricsSegment::Attach(MakeName("missing")));
+    assertFalse(reader->addTask("reader"));
+
+    MetricsSegment::TaskMetrics* task = segment->addTask("stream/task");
+    assertTrue(task);
+    assertEqual(size_t(1), reader->getTaskCount());
+    assertEqual(std::string("stream/task"), std::string(reader->getTask(0).name));
+
+    // Long names are cut short, and slots run out.
+    //
+    assertTrue(segment->addTask(std::string(200, 'x')));
+    assertEqual(size_t(MetricsSegment::kNameSize - 1), std::string(reader->getTask(1).name).size());
+    while (segment->getTaskCount() < MetricsSegment::kMaxTasks) assertTrue(segment->addTask("filler"));
+    assertFalse(segment->addTask("extra"));
+
+    // The creator removes the segment.
+    //
+    segment.reset();
+    assertTrue(!MetricsSegment::Attach(name));
+}
+
+void
+MetricsSegmentTest::testCounters()
+{
+    std::string name(MakeName("counters"));
+    MetricsSegment::Ref segment(MetricsSegment::Create(name));
+    assertTrue(segment.get() != 0);
+    MetricsSegment::TaskMetrics* task = segment->addTask("stream/task");
+    MetricsSegment::Ref reader(MetricsSegment::Attach(name));
+    assertTrue(reader.get() != 0);
+    const MetricsSegment::TaskMetrics& view(reader->getTask(0));
+
+    task->addProcessingTime(300);
+    task->addProcessingTime(100);
+    task->pendingQueueCount.store(7);
+    assertEqual(uint64_t(2), view.processed.load());
+    assertEqual(uint64_t(400), view.processingTime.load());
+    assertEqual(uint64_t(300), view.maxProcessingTime.load());
+    assertEqual(uint32_t(7), view.pendingQueueCount.load());
+
+    task->reset();
+    assertEqual(uint64_t(0), view.processed.load());
+    assertEqual(uint64_t(0), view.maxProcessingTime.load());
+    assertEqual(uint32_t(7), view.pendingQueueCount.load());
+
+    // Time the hot path with a reader polling as fast as it can.
+    //
+    enum { kCount = 10000000 };
+    std::atomic<bool> done(false);
+    std::thread poller([&view, &done]() {
+        uint64_t last = 0;
+        while (!done) {
+            uint64_t value = view.messages.load(std::memory_order_relaxed);
+            if (value < last) std::cerr << "counter went backwards" << std::endl;
+            last = value;
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < kCount; ++index) {
+        task->messages.fetch_add(1, std::memory_order_relaxed);
+        task->bytes.fetch_add(100, std::memory_order_relaxed);
+    }
+
+    std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+    done = true;
+    poller.join();
+
+    assertEqual(uint64_t(kCount), view.messages.load());
+    assertEqual(uint64_t(kCount) * 100, view.bytes.load());
+    std::clog << "update: " << elapsed.count() / kCount * 1E9 << " ns with a polling reader" << std::endl;
+}
+
+void
+MetricsSegmentTest::test()
+{
+    testSlots();
+    testCounters();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return MetricsSegmentTest().mainRun();
+}
@@ -1,5 +1,7 @@
 #include <sstream>
+#include <vector>
 
+#include "ace/Guard_T.h"
 #include "ace/Reactor.h"
 
 #include "Logger/Log.h"
@@ -27,7 +29,9 @@ MulticastDataPublisher::Make()
     return ref;
 }
 
-MulticastDataPublisher::MulticastDataPublisher() : Super(), writer_(), heartBeatReader_(), timer_(-1), heartBeats_()
+MulticastDataPublisher::MulticastDataPublisher() :
+    Super(), writer_(), writerMutex_(), retransmits_(), heartBeatReader_(), timer_(-1), heartBeats_(),
+    coveringMutex_(), covering_()
 {
     ;
 }
@@ -37,6 +41,14 @@ MulticastDataPublisher::~MulticastDataPublisher()
     ;
 }
 
+void
+MulticastDataPublisher::setReliable(size_t bufferCount, size_t maxRetransmitsPerSecond)
+{
+    Logger::ProcLog log("setReliable", Log());
+    LOGINFO << "bufferCount: " << bufferCount << " maxRetransmitsPerSecond: " << maxRetransmitsPerSecond << std::endl;
+    retransmits_.reset(new RetransmitRing(bufferCount, maxRetransmitsPerSecond));
+}
+
 void
 MulticastDataPublisher::setServiceName(const std::string& serviceName)
 {
@@ -140,6 +152,18 @@ MulticastDataPublisher::openAndInit(const std::string& key, const std::string& s
     os << address.get_port_number();
     getConnectionPublisher()->setTextData("HeartBeatPort", os.str());
 
+    // Let subscribers know that they may put a SubscriptionRequest in their heart-beat messages.
+    //
+    getConnectionPublisher()->setTextData("Reduce", "1");
+
+    // Let subscribers know that they may NAK missing messages.
+    //
+    if (retransmits_) {
+        os.str("");
+        os << retransmits_->getCapacity();
+        getConnectionPublisher()->setTextData("Reliable", os.str());
+    }
+
     // Now we are ready to publish our connection information.
     //
     if (!publish(serviceName)) {
@@ -201,6 +225,7 @@ MulticastDataPublisher::close(u_long flags)
         }
 
         heartBeats_.clear();
+        updateCovering();
     }
 
     return Super::close(flags);
@@ -212,20 +237,26 @@ MulticastDataPublisher::handle_input(ACE_HANDLE handle)
     static Logger::ProcLog log("handle_input", Log());
     LOGINFO << std::endl;
 
-    // Fetch the heart-beat message. Should be 'HI' or 'BYE'. Actually, this whole routine should be refactored
-    // into another class.
+    // Fetch the heart-beat message. Should be 'HI' with an optional SubscriptionRequest, 'BYE', or 'NAK'.
+    // Actually, this whole routine should be refactored into another class.
     //
-    ACE_TCHAR buffer[16];
+    ACE_TCHAR buffer[256];
     ACE_INET_Addr address;
-    ssize_t count = heartBeatReader_.recv(buffer, sizeof(buffer), address);
+    ssize_t count = heartBeatReader_.recv(buffer, sizeof(buffer) - 1, address);
     if (count < 1) {
         LOGERROR << "failed recv - " << errno << ' ' << strerror(errno) << std::endl;
         return 0;
     }
 
+    buffer[count] = 0;
     std::string msg(buffer);
     LOGDEBUG << "msg: " << msg << std::endl;
 
+    if (msg.compare(0, 4, "NAK ") == 0) {
+        handleNAK(msg);
+        return 0;
+    }
+
     // Convert the client address into a string to be used as a key into the HeartBeatMap container.
     //
     std::string key(Utils::INETAddrToString(address));
@@ -235,15 +266,28 @@ MulticastDataPublisher::handle_input(ACE_HANDLE handle)
     }
 
     LOGDEBUG << "key: " << key << std::endl;
-    if (msg == "HI") {
+    if (msg.compare(0, 2, "HI") == 0) {
+        SubscriptionRequest request;
+        if (!SubscriptionRequest::Parse(msg.substr(2), request)) {
+            LOGWARNING << getTaskName() << " invalid request from " << key << " - " << msg << std::endl;
+        }
+
         // Update the timestamp for the client address. This also works for first-time additions.
         //
-        heartBeats_[key] = Time::TimeStamp::Now();
+        HeartBeat& heartBeat(heartBeats_[key]);
+        heartBeat.when = Time::TimeStamp::Now();
+        if (heartBeat.request != request) {
+            heartBeat.request = request;
+            updateCovering();
+        }
     } else if (msg == "BYE") {
         // Remove the entry for the client address.
         //
         HeartBeatMap::iterator pos = heartBeats_.find(key);
-        if (pos != heartBeats_.end()) heartBeats_.erase(pos);
+        if (pos != heartBeats_.end()) {
+            heartBeats_.erase(pos);
+            updateCovering();
+        }
     }
 
     updateUsingDataValue();
@@ -252,6 +296,49 @@ MulticastDataPublisher::handle_input(ACE_HANDLE handle)
     return 0;
 }
 
+void
+MulticastDataPublisher::handleNAK(const std::string& msg)
+{
+    static Logger::ProcLog log("handleNAK", Log());
+    LOGINFO << msg << std::endl;
+
+    uint32_t first, count;
+    if (!retransmits_ || !ReliableMulticast::ParseNAK(msg, first, count)) {
+        LOGWARNING << getTaskName() << " ignoring '" << msg << "'" << std::endl;
+        return;
+    }
+
+    std::vector<ACE_Message_Block*> datagrams;
+    retransmits_->fetch(first, count, Time::TimeStamp::Now(), datagrams);
+
+    // The writer thread may be sending at the same time.
+    //
+    ACE_Guard<ACE_Thread_Mutex> guard(writerMutex_);
+    for (size_t index = 0; index < datagrams.size(); ++index) {
+        if (!writer_.writeEncoded(1, datagrams[index])) {
+            LOGERROR << getTaskName() << " failed to resend message" << std::endl;
+        }
+    }
+}
+
+void
+MulticastDataPublisher::updateCovering()
+{
+    static Logger::ProcLog log("updateCovering", Log());
+
+    std::vector<SubscriptionRequest> requests;
+    for (HeartBeatMap::const_iterator pos = heartBeats_.begin(); pos != heartBeats_.end(); ++pos) {
+        requests.push_back(pos->second.request);
+    }
+
+    SubscriptionRequest covering(SubscriptionRequest::Covering(requests));
+    ACE_Guard<ACE_Thread_Mutex> guard(coveringMutex_);
+    if (covering != covering_) {
+        LOGINFO << getTaskName() << " covering request: '" << covering.format() << "'" << std::endl;
+        covering_ = covering;
+    }
+}
+
 int
 MulticastDataPublisher::handle_timeout(const ACE_Time_Value& duration, const void* arg)
 {
@@ -260,6 +347,13 @@ MulticastDataPublisher::handle_timeout(const ACE_Time_Value& duration, const voi
 
     if (arg != &timer_) return Super::handle_timeout(duration, arg);
 
+    if (retransmits_) {
+        std::ostringstream os;
+        os << "Resent: " << retransmits_->getRetransmitCount() << " Gone: " << retransmits_->getUnavailableCount()
+           << " Limited: " << retransmits_->getLimitedCount();
+        setConnectionInfo(os.str());
+    }
+
     if (heartBeats_.empty()) return 0;
 
     // Calculate a time that is 60 seconds ago. If a timestamp is older than that, assume the connection is
@@ -271,7 +365,7 @@ MulticastDataPublisher::handle_timeout(const ACE_Time_Value& duration, const voi
     HeartBeatMap::iterator pos = heartBeats_.begin();
     HeartBeatMap::iterator end = heartBeats_.end();
     while (pos != end) {
-        if (pos->second > limit) {
+        if (pos->second.when > limit) {
             ++pos;
         } else {
             // !!! Erasing an item from std::map affects only affects iterators pointing to the item. So, we
@@ -283,6 +377,7 @@ MulticastDataPublisher::handle_timeout(const ACE_Time_Value& duration, const voi
         }
     }
 
+    updateCovering();
     updateUsingDataValue();
 
     return 0;
@@ -308,7 +403,28 @@ MulticastDataPublisher::svc()
     ACE_Message_Block* data;
     while (getq(data) != -1) {
         MessageManager mgr(data);
-        if (!writer_.write(mgr)) { LOGERROR << "failed to send the message" << std::endl; }
+        SubscriptionRequest covering;
+        {
+            ACE_Guard<ACE_Thread_Mutex> guard(coveringMutex_);
+            covering = covering_;
+        }
+
+        if (!retransmits_ && covering.isEmpty()) {
+            if (!writer_.write(mgr)) { LOGERROR << "failed to send the message" << std::endl; }
+            continue;
+        }
+
+        // Trim the message down to what the subscribers asked for.
+        //
+        ACE_Message_Block* encoded =
+            covering.isEmpty() ? mgr.getEncoded() : SubscriptionReducer(mgr).getEncoded(covering);
+        if (!encoded) continue;
+
+        // Number the message and keep a copy of it for any NAKs.
+        //
+        if (retransmits_) encoded = retransmits_->add(encoded);
+        ACE_Guard<ACE_Thread_Mutex> guard(writerMutex_);
+        if (!writer_.writeEncoded(1, encoded)) { LOGERROR << "failed to send the message" << std::endl; }
     }
 
     return 0;
@@ -2,12 +2,16 @@
 #define SIDECAR_IO_MULTICASTDATAPUBLISHER_H
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include "ace/SOCK_Dgram.h"
+#include "ace/Thread_Mutex.h"
 
 #include "IO/DataPublisher.h"
 #include "IO/Module.h"
+#include "IO/ReliableMulticast.h"
+#include "IO/SubscriptionRequest.h"
 #include "IO/Writers.h"
 #include "IO/ZeroconfRegistry.h"
 #include "Time/TimeStamp.h"
@@ -36,6 +40,11 @@ namespace IO {
     subscriber closes the multicast connection, it sends a 'BYE' heart-beat so that the publisher will know
     immediately that it has one less subscriber. If for some reason, the 'BYE' does not make it through to the
     publisher, the periodic scan mentioned above will take care of it.
+
+    If setReliable() is called before openAndInit(), the publisher numbers the messages it sends and keeps the
+    most recent ones in a RetransmitRing. Subscribers that see a gap in the numbers send a 'NAK' heart-beat with
+    the range they are missing, and the publisher sends those messages out again if it still has them. See
+    ReliableMulticast for the details.
 */
 class MulticastDataPublisher : public DataPublisher, public ZeroconfTypes::Publisher {
     using Super = DataPublisher;
@@ -44,6 +53,8 @@ public:
     using Ref = boost::shared_ptr<MulticastDataPublisher>;
     using ServiceEntryVector = Zeroconf::Browser::ServiceEntryVector;
 
+    enum { kDefaultRetransmitRate = 1000 };
+
     /** Log device for objects of this type.
 
         \return log device
@@ -79,6 +90,26 @@ public:
     */
     int close(u_long flags = 0);
 
+    /** Enable retransmission of lost messages. Must be called before openAndInit() so that subscribers learn
+        about it from the published TXT record.
+
+        \param bufferCount number of sent messages to keep for retransmission
+
+        \param maxRetransmitsPerSecond limit on the number of messages resent per second
+    */
+    void setReliable(size_t bufferCount, size_t maxRetransmitsPerSecond = kDefaultRetransmitRate);
+
+    /** \return true if setReliable() was called
+     */
+    bool isReliable() const { return retransmits_.get() != 0; }
+
+    /** Set the size of the largest datagram to send. Messages that are bigger go out in fragments. See
+        DatagramFragmenter.
+
+        \param maxDatagramSize largest datagram size in bytes
+    */
+    void setMaxDatagramSize(size_t maxDatagramSize) { writer_.getFragmenter().setMaxDatagramSize(maxDatagramSize); }
+
 protected:
     /** Constructor. Does nothing -- like most ACE classes, all initialization is done in the init and open
         methods.
@@ -123,6 +154,17 @@ private:
     */
     int handle_input(ACE_HANDLE handle);
 
+    /** Resend the messages requested by a subscriber.
+
+        \param msg text of the 'NAK' heart-beat message
+    */
+    void handleNAK(const std::string& msg);
+
+    /** Recalculate the data reduction that covers the requests of all of the subscribers. Only reduces the
+        stream if every subscriber asked for less than everything.
+    */
+    void updateCovering();
+
     /** Override of DataPublisher method. Starts a new thread to handle messages added to our input message
         queue.
     */
@@ -136,12 +178,22 @@ private:
     int svc();
 
     UDPSocketWriter writer_;
+    ACE_Thread_Mutex writerMutex_;
+    std::unique_ptr<RetransmitRing> retransmits_;
     long threadFlags_;
     long threadPriority_;
     ACE_SOCK_Dgram heartBeatReader_;
     long timer_;
-    using HeartBeatMap = std::map<std::string, Time::TimeStamp>;
+
+    struct HeartBeat {
+        Time::TimeStamp when;        ///< When the last heart-beat arrived
+        SubscriptionRequest request; ///< Data reduction asked for by the subscriber
+    };
+
+    using HeartBeatMap = std::map<std::string, HeartBeat>;
     HeartBeatMap heartBeats_;
+    ACE_Thread_Mutex coveringMutex_;
+    SubscriptionRequest covering_; ///< Reduction applied to all messages, guarded by coveringMutex_
 };
 
 using MulticastDataPublisherModule = TModule<MulticastDataPublisher>;
@@ -1,6 +1,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <sstream>
 
 #include "ace/Event_Handler.h"
@@ -8,12 +9,14 @@
 #include "ace/Reactor.h"
 
 #include "Logger/Log.h"
+#include "Time/TimeStamp.h"
 #include "Utils/Format.h"
 #include "Zeroconf/ACEMonitor.h"
 
 #include "MessageManager.h"
 #include "MulticastDataSubscriber.h"
 #include "Readers.h"
+#include "ReliableMulticast.h"
 
 static int kHeartBeatInterval = 2;         // seconds
 static int kAttemptConnectionInterval = 1; // seconds
@@ -34,7 +37,11 @@ public:
 
         \param owner
     */
-    ReaderThread(MulticastDataSubscriber* owner) : Super(), owner_(owner), reader_(), active_(false) {}
+    ReaderThread(MulticastDataSubscriber* owner) :
+        Super(), owner_(owner), reader_(), active_(false), reliable_(false), request_(), recovered_(0),
+        unrecovered_(0), incomplete_(0)
+    {
+    }
 
     /** Initialize the ReaderThread. Attempt to join a multicast broadcast, and if successful, start a new
         thread to read data from the socket.
@@ -43,9 +50,14 @@ public:
 
         \param bufferSize value to give to SO_RCVBUF socket setting
 
+        \param reliable true if the publisher numbers its messages and accepts NAKs
+
+        \param request data reduction to apply to received messages
+
         \return true if successful, false otherwise
     */
-    bool openAndInit(const ACE_INET_Addr& remoteAddress, int bufferSize, long threadFlags, long threadPriority)
+    bool openAndInit(const ACE_INET_Addr& remoteAddress, int bufferSize, long threadFlags, long threadPriority,
+                     bool reliable, const SubscriptionRequest& request)
     {
         static Logger::ProcLog log("open", Log());
         LOGINFO << "remoteAddress: " << remoteAddress.get_host_addr() << '/' << remoteAddress.get_port_number()
@@ -80,6 +92,9 @@ public:
             }
         }
 
+        reliable_ = reliable;
+        request_ = request;
+
         // Activate the message queue before we create a new thread, since the thread uses the queue
         // deactivation state as a signal to quit.
         //
@@ -119,6 +134,18 @@ public:
         return Super::close(flags);
     }
 
+    /** \return number of lost messages that were resent by the publisher
+     */
+    size_t getRecoveredCount() const { return recovered_; }
+
+    /** \return number of lost messages that were never resent
+     */
+    size_t getUnrecoveredCount() const { return unrecovered_; }
+
+    /** \return number of messages lost because some of their fragments never arrived
+     */
+    size_t getIncompleteCount() const { return incomplete_; }
+
 private:
     /** Method run in a separate thread due to ACE_Task::activate() being invoked. Read data from a multicast
         UDP socket, and if fetched a valid datagram, place onto internal message queue. The read attempt has a
@@ -130,9 +157,14 @@ private:
     int svc()
     {
         static Logger::ProcLog log("svc", Log());
-        LOGINFO << owner_->getTaskName() << std::endl;
+        LOGINFO << owner_->getTaskName() << " reliable: " << reliable_ << std::endl;
+
+        // When waiting on lost messages, wake up often enough to send NAKs and to give up on time.
+        //
         ACE_Time_Value timeout(1, 0);
+        ACE_Time_Value shortTimeout(0, 10000);
         reader_.setFetchTimeout(&timeout);
+        GapTracker tracker;
 
         while (active_) {
             if (!reader_.fetchInput()) {
@@ -142,16 +174,63 @@ private:
 
             if (!active_) break;
 
-            if (reader_.isMessageAvailable()) { owner_->acquireExternalMessage(reader_.getMessage()); }
+            incomplete_ = reader_.getAssembler().getIncompleteCount();
+            if (!reliable_) {
+                if (reader_.isMessageAvailable()) { deliver(reader_.getMessage()); }
+                continue;
+            }
+
+            Time::TimeStamp now = Time::TimeStamp::Now();
+            if (reader_.isMessageAvailable()) {
+                ACE_Message_Block* data = reader_.getMessage();
+                uint32_t sequence;
+                if (ReliableMulticast::StripHeader(data, sequence)) {
+                    tracker.add(sequence, data, now);
+                } else {
+                    LOGWARNING << owner_->getTaskName() << " datagram without sequence number" << std::endl;
+                    data->release();
+                }
+            }
+
+            tracker.expire(now);
+            while (ACE_Message_Block* data = tracker.pop()) deliver(data);
+
+            uint32_t first, count;
+            while (tracker.nextNAK(now, first, count)) owner_->sendNAK(first, count);
+
+            if (tracker.getUnrecoveredCount() != unrecovered_) {
+                LOGWARNING << owner_->getTaskName() << " lost messages: " << tracker.getUnrecoveredCount()
+                           << std::endl;
+            }
+
+            recovered_ = tracker.getRecoveredCount();
+            unrecovered_ = tracker.getUnrecoveredCount();
+            reader_.setFetchTimeout(tracker.isWaiting() ? &shortTimeout : &timeout);
         }
 
         LOGINFO << owner_->getTaskName() << " exiting" << std::endl;
         return 0;
     }
 
+    /** Give a received message to the owner, after applying our subscription request to it. The publisher
+        only applies a request that covers all of its subscribers.
+
+        \param data the received message
+    */
+    void deliver(ACE_Message_Block* data)
+    {
+        data = SubscriptionReducer::ReduceReceived(request_, data, owner_->getMetaTypeInfo());
+        if (data) owner_->acquireExternalMessage(data);
+    }
+
     MulticastDataSubscriber* owner_;
     MulticastSocketReader reader_;
     volatile bool active_;
+    bool reliable_;
+    SubscriptionRequest request_;
+    std::atomic<size_t> recovered_;
+    std::atomic<size_t> unrecovered_;
+    std::atomic<size_t> incomplete_;
 };
 
 } // namespace IO
@@ -183,7 +262,8 @@ MulticastDataSubscriber::Make()
 
 MulticastDataSubscriber::MulticastDataSubscriber() :
     Super(), address_(), reader_(0), bufferSize_(0), timer_(-1), heartBeatAddress_(),
-    heartBeatWriter_(ACE_INET_Addr(uint16_t(0))), closing_(false)
+    heartBeatWriter_(ACE_INET_Addr(uint16_t(0))), closing_(false), reliable_(false), reduce_(false),
+    request_()
 {
     ;
 }
@@ -259,6 +339,10 @@ MulticastDataSubscriber::resolvedService(const Zeroconf::ServiceEntry::Ref& serv
             LOGERROR << "invalid address: " << resolved.getHost() << '/' << resolved.getPort() << std::endl;
             return;
         }
+
+        reliable_ = resolved.hasTextEntry("Reliable");
+        reduce_ = resolved.hasTextEntry("Reduce");
+        LOGINFO << "reliable: " << reliable_ << " reduce: " << reduce_ << std::endl;
     }
 
     // Obtain the heart-beat port for us to send heart-beat messages to.
@@ -318,7 +402,7 @@ MulticastDataSubscriber::attemptConnection()
     //
     reader_ = new ReaderThread(this);
 
-    if (!reader_->openAndInit(address_, bufferSize_, threadFlags_, threadPriority_)) {
+    if (!reader_->openAndInit(address_, bufferSize_, threadFlags_, threadPriority_, reliable_, request_)) {
         LOGERROR << getTaskName() << " failed to start reader thread" << std::endl;
 
         // Clean up anything left over from trying to open the reader.
@@ -334,7 +418,7 @@ MulticastDataSubscriber::attemptConnection()
     // Notify our parent class that we are now connected.
     //
     establishedConnection();
-    sendHeartBeat("HI");
+    sendHello();
 
     // Revise the timer to use the heart-beat interval and send the publisher our first heart-beat message.
     //
@@ -381,7 +465,15 @@ MulticastDataSubscriber::handle_timeout(const ACE_Time_Value& duration, const vo
         ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
         attemptConnection();
     } else {
-        sendHeartBeat("HI");
+        sendHello();
+        std::ostringstream os;
+        if (reliable_) {
+            os << "Recovered: " << reader_->getRecoveredCount() << " Lost: " << reader_->getUnrecoveredCount()
+               << ' ';
+        }
+
+        os << "Incomplete: " << reader_->getIncompleteCount();
+        setConnectionInfo(os.str());
     }
 
     return 0;
@@ -400,6 +492,30 @@ MulticastDataSubscriber::sendHeartBeat(const char* msg) const
     }
 }
 
+void
+MulticastDataSubscriber::sendHello() const
+{
+    if (!reduce_ || request_.isEmpty()) {
+        sendHeartBeat("HI");
+    } else {
+        sendHeartBeat(("HI " + request_.format()).c_str());
+    }
+}
+
+void
+MulticastDataSubscriber::setSubscriptionRequest(const SubscriptionRequest& request)
+{
+    static Logger::ProcLog log("setSubscriptionRequest", Log());
+    LOGINFO << getTaskName() << ' ' << request.format() << std::endl;
+    request_ = request;
+}
+
+void
+MulticastDataSubscriber::sendNAK(uint32_t first, uint32_t count) const
+{
+    sendHeartBeat(ReliableMulticast::FormatNAK(first, count).c_str());
+}
+
 void
 MulticastDataSubscriber::setUsingData(bool state)
 {
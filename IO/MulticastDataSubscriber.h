@@ -6,6 +6,7 @@
 
 #include "IO/DataSubscriber.h"
 #include "IO/Module.h"
+#include "IO/SubscriptionRequest.h"
 #include "IO/ZeroconfRegistry.h"
 #include "Zeroconf/Publisher.h"
 
@@ -18,6 +19,14 @@ namespace IO {
 
 /** Subscriber of data using the UDP multicast transport. Relies on a MulticastSocketReader object to do the
     receiving. This class manages the connection state based on Zeroconf information.
+
+    If the publisher advertises that it is reliable (see MulticastDataPublisher::setReliable()), the reader thread
+    passes the incoming datagrams through a GapTracker, and sends the publisher a 'NAK' heart-beat for any
+    messages that it has not seen.
+
+    If the publisher advertises that it accepts data reduction requests, the heart-beat messages carry the
+    subscriber's SubscriptionRequest. The publisher reduces its stream to cover the requests of all of its
+    subscribers, so the reader thread applies the subscriber's own request to what it receives.
 */
 class MulticastDataSubscriber : public DataSubscriber, public ZeroconfTypes::Subscriber {
     using Super = DataSubscriber;
@@ -69,6 +78,14 @@ public:
     */
     void setUsingData(bool state);
 
+    /** Ask the publisher for less than all of its data.
+
+        \param request the data to ask for
+    */
+    void setSubscriptionRequest(const SubscriptionRequest& request);
+
+    const SubscriptionRequest& getSubscriptionRequest() const { return request_; }
+
 protected:
     /** Constructor.
      */
@@ -117,6 +134,18 @@ private:
 
     void sendHeartBeat(const char* msg) const;
 
+    /** Send the publisher a 'HI' heart-beat, with our SubscriptionRequest if the publisher accepts one.
+     */
+    void sendHello() const;
+
+    /** Ask the publisher to resend missing messages.
+
+        \param first first missing sequence number
+
+        \param count number of missing messages
+    */
+    void sendNAK(uint32_t first, uint32_t count) const;
+
     void startTimer(int intervalSeconds);
 
     void stopTimer();
@@ -132,6 +161,9 @@ private:
     long threadFlags_;
     long threadPriority_;
     bool closing_;
+    bool reliable_;
+    bool reduce_;
+    SubscriptionRequest request_;
 };
 
 using MulticastDataSubscriberModule = TModule<MulticastDataSubscriber>;
@@ -201,7 +201,7 @@ DatagramReader::Log()
     return log_;
 }
 
-DatagramReader::DatagramReader(size_t maxSize) : building_(0)
+DatagramReader::DatagramReader(size_t maxSize) : building_(0), assembler_()
 {
     makeIncomingBuffer(maxSize);
 }
@@ -239,7 +239,10 @@ DatagramReader::fetchInput()
     case -1: // device err
         switch (errno) {
         case EWOULDBLOCK:
-        case ETIME: LOGINFO << "nothing available - " << Utils::showErrno() << std::endl; return true;
+        case ETIME:
+            LOGINFO << "nothing available - " << Utils::showErrno() << std::endl;
+            assembler_.expire(Time::TimeStamp::Now());
+            return true;
         }
         LOGERROR << "failed to fetch data - " << Utils::showErrno() << std::endl;
         return false;
@@ -251,6 +254,18 @@ DatagramReader::fetchInput()
         break;
     }
 
+    // A fragment goes to the assembler, and the buffer is reused for the next datagram.
+    //
+    FragmentHeader header;
+    if (header.read(building_->rd_ptr(), fetched)) {
+        Time::TimeStamp now = Time::TimeStamp::Now();
+        ACE_Message_Block* message = assembler_.add(header, building_->rd_ptr() + FragmentHeader::kSize,
+                                                    fetched - FragmentHeader::kSize, now);
+        assembler_.expire(now);
+        if (message) setAvailable(message);
+        return true;
+    }
+
     building_->wr_ptr(fetched);
     setAvailable(building_);
     makeIncomingBuffer(building_->size());
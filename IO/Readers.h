@@ -10,6 +10,7 @@
 
 #include "boost/shared_ptr.hpp"
 
+#include "IO/Fragments.h"
 #include "IO/Preamble.h"
 #include "IO/Stats.h"
 
@@ -327,6 +328,9 @@ private:
     complete message. All SideCar messages have a header (see SideCar::Messages::Header class) which contains a
     size in bytes. A reader simply adds incoming bytes to an ACE_Message_Block until the
     ACE_Message_Block::length() == Header::getSize().
+
+    Messages too big for one datagram arrive in fragments (see DatagramFragmenter). The reader hands them to a
+    DatagramAssembler, and makes the message available once all of its fragments are in.
 */
 class DatagramReader : public Reader {
 public:
@@ -354,11 +358,17 @@ public:
     */
     bool fetchInput();
 
-    /** Reset the stream by discarding any partially-read messages. This is a NOP for this class since datagrams
-        are always read whole.
+    /** Reset the stream by discarding any partially-read messages. This is a NOP for this class; partial
+        messages built from fragments time out on their own.
     */
     void reset() {}
 
+    /** Obtain the object that rebuilds messages from fragments, for its counters.
+
+        \return assembler
+    */
+    const DatagramAssembler& getAssembler() const { return assembler_; }
+
 protected:
     /** Prototype of method that fetches data from a device and places it into a specific location.
 
@@ -378,6 +388,7 @@ protected:
     void makeIncomingBuffer(size_t size);
 
     ACE_Message_Block* building_; ///< Message being built
+    DatagramAssembler assembler_; ///< Messages being rebuilt from fragments
 };
 
 /** Template class for device-specific readers. The template argument _D is a device to use to actually read in
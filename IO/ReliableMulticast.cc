@@ -0,0 +1,298 @@
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "ace/Guard_T.h"
+#include "ace/Message_Block.h"
+
+#include "Logger/Log.h"
+
+#include "ReliableMulticast.h"
+
+using namespace SideCar::IO;
+
+/** Value found at the start of every datagram sent by a reliable publisher ('SCRM').
+ */
+static const uint32_t kMagic = 0x5343524D;
+
+/** Do not resend a message if it went out less than this many seconds ago.
+ */
+static const double kResendHoldOff = 0.005;
+
+/** Maximum number of messages in one NAK range.
+ */
+static const uint32_t kMaxNAKCount = 1024;
+
+ACE_Message_Block*
+ReliableMulticast::MakeDatagram(uint32_t sequence, ACE_Message_Block* encoded)
+{
+    ACE_Message_Block* header = new ACE_Message_Block(kHeaderSize);
+    uint32_t values[2] = {htonl(kMagic), htonl(sequence)};
+    ::memcpy(header->wr_ptr(), values, kHeaderSize);
+    header->wr_ptr(kHeaderSize);
+    header->cont(encoded);
+    return header;
+}
+
+bool
+ReliableMulticast::StripHeader(ACE_Message_Block* data, uint32_t& sequence)
+{
+    if (data->length() < kHeaderSize) return false;
+    uint32_t values[2];
+    ::memcpy(values, data->rd_ptr(), kHeaderSize);
+    if (ntohl(values[0]) != kMagic) return false;
+    sequence = ntohl(values[1]);
+    data->rd_ptr(kHeaderSize);
+    return true;
+}
+
+std::string
+ReliableMulticast::FormatNAK(uint32_t first, uint32_t count)
+{
+    std::ostringstream os;
+    os << "NAK " << first << ' ' << count;
+    return os.str();
+}
+
+bool
+ReliableMulticast::ParseNAK(const std::string& text, uint32_t& first, uint32_t& count)
+{
+    std::istringstream is(text);
+    std::string tag;
+    is >> tag >> first >> count;
+    return !is.fail() && tag == "NAK" && count > 0;
+}
+
+Logger::Log&
+RetransmitRing::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.RetransmitRing");
+    return log_;
+}
+
+RetransmitRing::RetransmitRing(size_t capacity, size_t maxPerSecond) :
+    mutex_(), entries_(std::max(capacity, size_t(1))), nextSequence_(0), maxPerSecond_(maxPerSecond),
+    tokens_(maxPerSecond), lastRefill_(0.0), retransmitted_(0), unavailable_(0), limited_(0)
+{
+    ;
+}
+
+RetransmitRing::~RetransmitRing()
+{
+    for (size_t index = 0; index < entries_.size(); ++index) {
+        if (entries_[index].data) entries_[index].data->release();
+    }
+}
+
+ACE_Message_Block*
+RetransmitRing::add(ACE_Message_Block* encoded)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+    uint32_t sequence = nextSequence_++;
+    Entry& entry(entries_[sequence % entries_.size()]);
+    if (entry.data) entry.data->release();
+    entry.data = encoded;
+    entry.sequence = sequence;
+    entry.lastSent = 0.0;
+    return ReliableMulticast::MakeDatagram(sequence, encoded->duplicate());
+}
+
+void
+RetransmitRing::fetch(uint32_t first, uint32_t count, const Time::TimeStamp& now,
+                      std::vector<ACE_Message_Block*>& datagrams)
+{
+    static Logger::ProcLog log("fetch", Log());
+    LOGINFO << "first: " << first << " count: " << count << std::endl;
+
+    ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+
+    // Refill the token bucket for the time since the last request. The bucket holds at most one second's worth.
+    //
+    double when = now.asDouble();
+    if (lastRefill_ != 0.0) tokens_ = std::min(maxPerSecond_, tokens_ + (when - lastRefill_) * maxPerSecond_);
+    lastRefill_ = when;
+
+    count = std::min(count, uint32_t(entries_.size()));
+    for (uint32_t index = 0; index < count; ++index) {
+        uint32_t sequence = first + index;
+        Entry& entry(entries_[sequence % entries_.size()]);
+        if (!entry.data || entry.sequence != sequence) {
+            ++unavailable_;
+            continue;
+        }
+
+        // Another subscriber may have asked for the same message a moment ago.
+        //
+        if (when - entry.lastSent < kResendHoldOff) continue;
+
+        if (tokens_ < 1.0) {
+            ++limited_;
+            continue;
+        }
+
+        tokens_ -= 1.0;
+        entry.lastSent = when;
+        datagrams.push_back(ReliableMulticast::MakeDatagram(sequence, entry.data->duplicate()));
+        ++retransmitted_;
+    }
+
+    LOGDEBUG << "resending: " << datagrams.size() << " tokens: " << tokens_ << std::endl;
+}
+
+GapTracker::GapTracker(double holdTime, double nakInterval, int maxNAKs, size_t window) :
+    holdTime_(holdTime), nakInterval_(nakInterval), maxNAKs_(maxNAKs), window_(std::max(window, size_t(1))),
+    started_(false), next_(0), highest_(0), held_(), missing_(), ready_(), recovered_(0), unrecovered_(0),
+    duplicates_(0), naks_(0)
+{
+    ;
+}
+
+GapTracker::~GapTracker()
+{
+    for (auto pos = held_.begin(); pos != held_.end(); ++pos) pos->second->release();
+    for (auto pos = ready_.begin(); pos != ready_.end(); ++pos) (*pos)->release();
+}
+
+void
+GapTracker::add(uint32_t sequence, ACE_Message_Block* data, const Time::TimeStamp& now)
+{
+    if (!started_) {
+        started_ = true;
+        next_ = highest_ = sequence;
+    }
+
+    // Extend the sequence number to 64 bits using the one we expect next, so that wrapping is not an issue.
+    //
+    int64_t delta = int32_t(sequence - uint32_t(next_));
+    if (delta < 0) {
+        if (uint64_t(-delta) <= window_) {
+            ++duplicates_;
+            data->release();
+            return;
+        }
+
+        // Too far back to be a late arrival -- the publisher must have restarted.
+        //
+        resync(sequence);
+        delta = 0;
+    }
+
+    uint64_t value = next_ + delta;
+
+    // Do not wait on anything that is too far behind the new message.
+    //
+    while (value - next_ >= window_) {
+        if (!missing_.empty()) {
+            giveUp(missing_.begin()->first);
+        } else {
+            uint64_t skipTo = value - window_ + 1;
+            unrecovered_ += skipTo - next_;
+            next_ = highest_ = skipTo;
+        }
+    }
+
+    if (value >= highest_) {
+        double when = now.asDouble();
+        for (; highest_ < value; ++highest_) missing_.insert(std::make_pair(highest_, Missing(when)));
+        highest_ = value + 1;
+    } else {
+        auto pos = missing_.find(value);
+        if (pos == missing_.end()) {
+            ++duplicates_;
+            data->release();
+            return;
+        }
+
+        missing_.erase(pos);
+        ++recovered_;
+    }
+
+    if (value == next_) {
+        ready_.push_back(data);
+        ++next_;
+        drain();
+    } else {
+        held_[value] = data;
+    }
+}
+
+void
+GapTracker::expire(const Time::TimeStamp& now)
+{
+    double limit = now.asDouble() - holdTime_;
+    while (!missing_.empty() && missing_.begin()->second.firstSeen <= limit) giveUp(missing_.begin()->first);
+}
+
+ACE_Message_Block*
+GapTracker::pop()
+{
+    if (ready_.empty()) return 0;
+    ACE_Message_Block* data = ready_.front();
+    ready_.pop_front();
+    return data;
+}
+
+bool
+GapTracker::nextNAK(const Time::TimeStamp& now, uint32_t& first, uint32_t& count)
+{
+    double when = now.asDouble();
+    auto pos = missing_.begin();
+    auto end = missing_.end();
+    for (; pos != end; ++pos) {
+        const Missing& missing(pos->second);
+        if (missing.naks < maxNAKs_ && (missing.naks == 0 || when - missing.lastNAK >= nakInterval_)) break;
+    }
+
+    if (pos == end) return false;
+
+    // Collect a run of consecutive sequence numbers that are all due.
+    //
+    uint64_t start = pos->first;
+    uint64_t expected = start;
+    for (; pos != end && pos->first == expected && expected - start < kMaxNAKCount; ++pos, ++expected) {
+        Missing& missing(pos->second);
+        if (missing.naks >= maxNAKs_ || (missing.naks != 0 && when - missing.lastNAK < nakInterval_)) break;
+        missing.lastNAK = when;
+        ++missing.naks;
+    }
+
+    first = uint32_t(start);
+    count = uint32_t(expected - start);
+    ++naks_;
+    return true;
+}
+
+void
+GapTracker::giveUp(uint64_t sequence)
+{
+    missing_.erase(sequence);
+    ++unrecovered_;
+    if (sequence == next_) {
+        ++next_;
+        drain();
+    }
+}
+
+void
+GapTracker::drain()
+{
+    while (!held_.empty() && held_.begin()->first == next_) {
+        ready_.push_back(held_.begin()->second);
+        held_.erase(held_.begin());
+        ++next_;
+    }
+}
+
+void
+GapTracker::resync(uint32_t sequence)
+{
+    // Deliver what we have in order, and forget about what is missing.
+    //
+    for (auto pos = held_.begin(); pos != held_.end(); ++pos) ready_.push_back(pos->second);
+    held_.clear();
+    unrecovered_ += missing_.size();
+    missing_.clear();
+    next_ = highest_ = sequence;
+}
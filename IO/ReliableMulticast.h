@@ -0,0 +1,276 @@
+#ifndef SIDECAR_IO_RELIABLEMULTICAST_H // -*- C++ -*-
+#define SIDECAR_IO_RELIABLEMULTICAST_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ace/Thread_Mutex.h"
+
+#include "Time/TimeStamp.h"
+
+class ACE_Message_Block;
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace IO {
+
+/** Pieces of the optional NAK-based reliability layer for multicast data. When enabled, the publisher puts a small
+    header with a sequence number in front of each encoded message it sends, and keeps the most recent messages
+    in a RetransmitRing. A subscriber feeds the datagrams it receives to a GapTracker, which holds on to messages
+    that arrive after a gap so that they can be delivered in order, and tells the subscriber which sequence numbers
+    to ask for again. The requests (NAKs) go to the publisher over the heart-beat socket, and the publisher sends
+    the messages it still has back out to the multicast group.
+*/
+class ReliableMulticast {
+public:
+    enum { kHeaderSize = 8 };
+
+    /** Create a header block for a message. The header is kHeaderSize bytes, so it keeps the message data aligned
+        for CDR decoding.
+
+        \param sequence sequence number of the message
+
+        \param encoded encoded message data. The header takes ownership of the block, and sends it as its
+        continuation.
+
+        \return new header block
+    */
+    static ACE_Message_Block* MakeDatagram(uint32_t sequence, ACE_Message_Block* encoded);
+
+    /** Remove the header from a datagram.
+
+        \param data datagram read from a socket. On success, the read pointer is moved past the header.
+
+        \param sequence storage for the sequence number
+
+        \return true if the datagram had a valid header
+    */
+    static bool StripHeader(ACE_Message_Block* data, uint32_t& sequence);
+
+    /** Create the text of a NAK heart-beat message.
+
+        \param first first missing sequence number
+
+        \param count number of missing messages, starting with first
+
+        \return text to send
+    */
+    static std::string FormatNAK(uint32_t first, uint32_t count);
+
+    /** Parse the text of a NAK heart-beat message.
+
+        \param text message text
+
+        \param first storage for the first missing sequence number
+
+        \param count storage for the number of missing messages
+
+        \return true if the text is a valid NAK message
+    */
+    static bool ParseNAK(const std::string& text, uint32_t& first, uint32_t& count);
+};
+
+/** Bounded ring of the most recent messages sent by a publisher, indexed by sequence number. Retransmissions are
+    rate limited with a token bucket, and a message is not sent again if it went out only a moment ago, which
+    happens when several subscribers lose the same datagram. Thread-safe: the publisher adds messages in its
+    writer thread, and handles NAKs in the reactor thread.
+*/
+class RetransmitRing {
+public:
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Constructor.
+
+        \param capacity number of messages to keep
+
+        \param maxPerSecond maximum number of messages to resend per second
+    */
+    RetransmitRing(size_t capacity, size_t maxPerSecond);
+
+    /** Destructor. Releases the kept messages.
+     */
+    ~RetransmitRing();
+
+    /** \return number of messages kept
+     */
+    size_t getCapacity() const { return entries_.size(); }
+
+    /** Assign the next sequence number to a message and keep it.
+
+        \param encoded encoded message data. Takes ownership.
+
+        \return datagram to send, as made by ReliableMulticast::MakeDatagram()
+    */
+    ACE_Message_Block* add(ACE_Message_Block* encoded);
+
+    /** Obtain the datagrams to resend for a NAK.
+
+        \param first first missing sequence number
+
+        \param count number of missing messages
+
+        \param now current time
+
+        \param datagrams storage for the datagrams to send. Caller takes ownership.
+    */
+    void fetch(uint32_t first, uint32_t count, const Time::TimeStamp& now,
+               std::vector<ACE_Message_Block*>& datagrams);
+
+    /** \return number of messages resent
+     */
+    size_t getRetransmitCount() const { return retransmitted_; }
+
+    /** \return number of requested messages that were no longer in the ring
+     */
+    size_t getUnavailableCount() const { return unavailable_; }
+
+    /** \return number of requested messages not resent due to the rate limit
+     */
+    size_t getLimitedCount() const { return limited_; }
+
+private:
+    struct Entry {
+        Entry() : data(0), sequence(0), lastSent(0.0) {}
+        ACE_Message_Block* data;
+        uint32_t sequence;
+        double lastSent;
+    };
+
+    ACE_Thread_Mutex mutex_;
+    std::vector<Entry> entries_;
+    uint32_t nextSequence_;
+    double maxPerSecond_;
+    double tokens_;
+    double lastRefill_;
+    size_t retransmitted_;
+    size_t unavailable_;
+    size_t limited_;
+};
+
+/** Tracks the sequence numbers of the messages a subscriber receives. Messages that arrive after a gap are held
+    until the gap fills or the hold time runs out, so that messages are always delivered in order. Missing
+    messages are NAKed when first seen missing, and again after a retry interval, up to a limit. Not thread-safe;
+    meant to be used by one reader thread.
+*/
+class GapTracker {
+public:
+    /** Constructor.
+
+        \param holdTime seconds to wait for a missing message before giving up on it
+
+        \param nakInterval seconds between NAKs for the same missing message
+
+        \param maxNAKs maximum number of NAKs for a missing message
+
+        \param window maximum distance in sequence numbers between the oldest missing message and the newest
+        message received. The tracker gives up on older missing messages, which bounds the number of messages
+        it holds.
+    */
+    GapTracker(double holdTime = 0.05, double nakInterval = 0.01, int maxNAKs = 3, size_t window = 1024);
+
+    /** Destructor. Releases any held messages.
+     */
+    ~GapTracker();
+
+    /** Record the arrival of a message.
+
+        \param sequence sequence number of the message
+
+        \param data message data. Takes ownership.
+
+        \param now current time
+    */
+    void add(uint32_t sequence, ACE_Message_Block* data, const Time::TimeStamp& now);
+
+    /** Give up on missing messages that have waited longer than the hold time.
+
+        \param now current time
+    */
+    void expire(const Time::TimeStamp& now);
+
+    /** Obtain the next message to deliver, in sequence order.
+
+        \return message data (caller takes ownership), or NULL if none is ready
+    */
+    ACE_Message_Block* pop();
+
+    /** Obtain the next range of missing messages that should be NAKed now. Call repeatedly until it returns
+        false.
+
+        \param now current time
+
+        \param first storage for the first sequence number of the range
+
+        \param count storage for the number of messages in the range
+
+        \return true if there is a range to NAK
+    */
+    bool nextNAK(const Time::TimeStamp& now, uint32_t& first, uint32_t& count);
+
+    /** \return true if there are missing messages being waited on
+     */
+    bool isWaiting() const { return !missing_.empty(); }
+
+    /** \return number of missing messages that later arrived
+     */
+    size_t getRecoveredCount() const { return recovered_; }
+
+    /** \return number of missing messages that never arrived
+     */
+    size_t getUnrecoveredCount() const { return unrecovered_; }
+
+    /** \return number of messages received more than once, or after they were given up on
+     */
+    size_t getDuplicateCount() const { return duplicates_; }
+
+    /** \return number of NAK ranges generated
+     */
+    size_t getNAKCount() const { return naks_; }
+
+private:
+    struct Missing {
+        Missing(double when) : firstSeen(when), lastNAK(0.0), naks(0) {}
+        double firstSeen;
+        double lastNAK;
+        int naks;
+    };
+
+    void giveUp(uint64_t sequence);
+
+    void drain();
+
+    void resync(uint32_t sequence);
+
+    double holdTime_;
+    double nakInterval_;
+    int maxNAKs_;
+    uint64_t window_;
+    bool started_;
+    uint64_t next_;
+    uint64_t highest_;
+    std::map<uint64_t, ACE_Message_Block*> held_;
+    std::map<uint64_t, Missing> missing_;
+    std::deque<ACE_Message_Block*> ready_;
+    size_t recovered_;
+    size_t unrecovered_;
+    size_t duplicates_;
+    size_t naks_;
+};
+
+} // end namespace IO
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
@@ -0,0 +1,344 @@
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "ace/INET_Addr.h"
+#include "ace/Message_Block.h"
+#include "ace/SOCK_Dgram.h"
+
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "ReliableMulticast.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+
+class ReliableMulticastTest : public UnitTest::TestObj {
+public:
+    ReliableMulticastTest() : TestObj("ReliableMulticast") {}
+
+    void test();
+
+    /** Create a message whose payload is its own index.
+     */
+    static ACE_Message_Block* MakeMessage(uint32_t index);
+
+    /** Obtain the payload of a message made by MakeMessage(), or -1 if the message is not valid.
+     */
+    static int64_t GetIndex(ACE_Message_Block* data);
+
+    /** Pop all of the ready messages from a tracker, checking that they are in order.
+     */
+    size_t popAll(GapTracker& tracker, int64_t& last);
+
+    void testHeader();
+
+    void testGapTracker();
+
+    void testRetransmitRing();
+
+    void testLoopback();
+};
+
+ACE_Message_Block*
+ReliableMulticastTest::MakeMessage(uint32_t index)
+{
+    ACE_Message_Block* data = new ACE_Message_Block(sizeof(index));
+    ::memcpy(data->wr_ptr(), &index, sizeof(index));
+    data->wr_ptr(sizeof(index));
+    return data;
+}
+
+int64_t
+ReliableMulticastTest::GetIndex(ACE_Message_Block* data)
+{
+    if (data->length() != sizeof(uint32_t)) return -1;
+    uint32_t index;
+    ::memcpy(&index, data->rd_ptr(), sizeof(index));
+    return index;
+}
+
+size_t
+ReliableMulticastTest::popAll(GapTracker& tracker, int64_t& last)
+{
+    size_t count = 0;
+    while (ACE_Message_Block* data = tracker.pop()) {
+        int64_t index = GetIndex(data);
+        assertTrue(index > last);
+        last = index;
+        data->release();
+        ++count;
+    }
+
+    return count;
+}
+
+void
+ReliableMulticastTest::testHeader()
+{
+    ACE_Message_Block* datagram = ReliableMulticast::MakeDatagram(12345, MakeMessage(7));
+    assertEqual(size_t(ReliableMulticast::kHeaderSize + sizeof(uint32_t)), datagram->total_length());
+
+    // Flatten the chain, as it would be after going through a socket.
+    //
+    ACE_Message_Block flat(datagram->total_length());
+    for (ACE_Message_Block* block = datagram; block; block = block->cont()) flat.copy(block->rd_ptr(), block->length());
+    datagram->release();
+
+    uint32_t sequence = 0;
+    assertTrue(ReliableMulticast::StripHeader(&flat, sequence));
+    assertEqual(uint32_t(12345), sequence);
+    assertEqual(int64_t(7), GetIndex(&flat));
+
+    // Data from a publisher that is not reliable has no header.
+    //
+    ACE_Message_Block* plain = MakeMessage(7);
+    assertFalse(ReliableMulticast::StripHeader(plain, sequence));
+    plain->release();
+
+    uint32_t first = 0, count = 0;
+    assertTrue(ReliableMulticast::ParseNAK(ReliableMulticast::FormatNAK(4000000000u, 12), first, count));
+    assertEqual(uint32_t(4000000000u), first);
+    assertEqual(uint32_t(12), count);
+    assertFalse(ReliableMulticast::ParseNAK("HI", first, count));
+    assertFalse(ReliableMulticast::ParseNAK("NAK 1", first, count));
+}
+
+void
+ReliableMulticastTest::testGapTracker()
+{
+    GapTracker tracker(0.05, 0.01, 3, 16);
+    int64_t last = -1;
+    uint32_t first, count;
+
+    // In-order messages go right through, starting from whatever sequence comes first.
+    //
+    Time::TimeStamp now(100.0);
+    tracker.add(10, MakeMessage(10), now);
+    tracker.add(11, MakeMessage(11), now);
+    assertEqual(size_t(2), popAll(tracker, last));
+    assertFalse(tracker.nextNAK(now, first, count));
+
+    // A gap holds later messages, and asks for the missing ones right away.
+    //
+    tracker.add(14, MakeMessage(14), now);
+    tracker.add(15, MakeMessage(15), now);
+    assertEqual(size_t(0), popAll(tracker, last));
+    assertTrue(tracker.isWaiting());
+    assertTrue(tracker.nextNAK(now, first, count));
+    assertEqual(uint32_t(12), first);
+    assertEqual(uint32_t(2), count);
+    assertFalse(tracker.nextNAK(now, first, count));
+
+    // Nothing more until the retry interval passes.
+    //
+    assertFalse(tracker.nextNAK(Time::TimeStamp(100.005), first, count));
+    assertTrue(tracker.nextNAK(Time::TimeStamp(100.011), first, count));
+    assertEqual(uint32_t(12), first);
+
+    // Filling the gap releases everything in order. A second copy is a duplicate.
+    //
+    tracker.add(13, MakeMessage(13), now);
+    assertEqual(size_t(0), popAll(tracker, last));
+    tracker.add(12, MakeMessage(12), now);
+    tracker.add(12, MakeMessage(12), now);
+    assertEqual(size_t(4), popAll(tracker, last));
+    assertEqual(int64_t(15), last);
+    assertEqual(size_t(2), tracker.getRecoveredCount());
+    assertEqual(size_t(1), tracker.getDuplicateCount());
+    assertFalse(tracker.isWaiting());
+
+    // A message that never shows up is given up on after the hold time.
+    //
+    tracker.add(17, MakeMessage(17), now);
+    tracker.expire(Time::TimeStamp(100.02));
+    assertEqual(size_t(0), popAll(tracker, last));
+    tracker.expire(Time::TimeStamp(100.06));
+    assertEqual(size_t(1), popAll(tracker, last));
+    assertEqual(size_t(1), tracker.getUnrecoveredCount());
+
+    // Giving up is final: the late copy is ignored.
+    //
+    tracker.add(16, MakeMessage(16), now);
+    assertEqual(size_t(0), popAll(tracker, last));
+    assertEqual(size_t(2), tracker.getDuplicateCount());
+
+    // A jump beyond the window immediately gives up on the oldest missing messages, and the rest are waited on as
+    // usual.
+    //
+    tracker.add(40, MakeMessage(40), now);
+    assertEqual(size_t(0), popAll(tracker, last));
+    assertEqual(size_t(1 + 7), tracker.getUnrecoveredCount());
+    tracker.expire(Time::TimeStamp(100.2));
+    assertEqual(size_t(1), popAll(tracker, last));
+    assertEqual(size_t(1 + 22), tracker.getUnrecoveredCount());
+
+    // Sequence numbers wrap.
+    //
+    GapTracker wrapped;
+    last = -1;
+    wrapped.add(0xFFFFFFFE, MakeMessage(1), now);
+    wrapped.add(0, MakeMessage(3), now);
+    assertTrue(wrapped.nextNAK(now, first, count));
+    assertEqual(uint32_t(0xFFFFFFFF), first);
+    assertEqual(uint32_t(1), count);
+    wrapped.add(0xFFFFFFFF, MakeMessage(2), now);
+    assertEqual(size_t(3), popAll(wrapped, last));
+
+    // A publisher restart starts over from zero.
+    //
+    GapTracker restarted;
+    last = -1;
+    restarted.add(5000, MakeMessage(1), now);
+    restarted.add(0, MakeMessage(2), now);
+    assertEqual(size_t(2), popAll(restarted, last));
+    assertEqual(size_t(0), restarted.getDuplicateCount());
+}
+
+void
+ReliableMulticastTest::testRetransmitRing()
+{
+    RetransmitRing ring(8, 4);
+    for (uint32_t index = 0; index < 20; ++index) {
+        ACE_Message_Block* datagram = ring.add(MakeMessage(index));
+        datagram->release();
+    }
+
+    // Only the last 8 are available, and only 4 may go out right away.
+    //
+    std::vector<ACE_Message_Block*> datagrams;
+    ring.fetch(10, 8, Time::TimeStamp(50.0), datagrams);
+    assertEqual(size_t(4), datagrams.size());
+    assertEqual(size_t(2), ring.getUnavailableCount());
+    assertEqual(size_t(2), ring.getLimitedCount());
+    assertEqual(int64_t(12), GetIndex(datagrams[0]->cont()));
+    for (size_t index = 0; index < datagrams.size(); ++index) datagrams[index]->release();
+    datagrams.clear();
+
+    // Half a second later there are two more tokens. A message just resent is not sent again.
+    //
+    ring.fetch(15, 3, Time::TimeStamp(50.5), datagrams);
+    assertEqual(size_t(2), datagrams.size());
+    ring.fetch(16, 1, Time::TimeStamp(50.501), datagrams);
+    assertEqual(size_t(2), datagrams.size());
+    for (size_t index = 0; index < datagrams.size(); ++index) datagrams[index]->release();
+    assertEqual(size_t(6), ring.getRetransmitCount());
+}
+
+void
+ReliableMulticastTest::testLoopback()
+{
+    // Publisher data socket, subscriber data socket, and the publisher heart-beat socket that receives NAKs.
+    //
+    ACE_INET_Addr any(uint16_t(0), "127.0.0.1");
+    ACE_SOCK_Dgram sender(any), receiver(any), nakReader(any);
+    ACE_INET_Addr receiverAddress, nakAddress;
+    receiver.get_local_addr(receiverAddress);
+    nakReader.get_local_addr(nakAddress);
+
+    const uint32_t kCount = 2000;
+    const uint32_t kDropEvery = 7;
+
+    RetransmitRing ring(256, 100000);
+    GapTracker tracker;
+    int64_t last = -1;
+    size_t delivered = 0;
+    size_t dropped = 0;
+    char buffer[1024];
+    ACE_Time_Value noWait(0, 0);
+    ACE_Time_Value shortWait(0, 1000);
+
+    Time::TimeStamp start = Time::TimeStamp::Now();
+    for (uint32_t index = 0; index < kCount + 100; ++index) {
+        // Publisher: send the next message, losing every kDropEvery one.
+        //
+        if (index < kCount) {
+            ACE_Message_Block* datagram = ring.add(MakeMessage(index));
+            if (index % kDropEvery == 3) {
+                ++dropped;
+            } else {
+                ACE_Message_Block flat(datagram->total_length());
+                for (ACE_Message_Block* block = datagram; block; block = block->cont()) {
+                    flat.copy(block->rd_ptr(), block->length());
+                }
+
+                sender.send(flat.rd_ptr(), flat.length(), receiverAddress);
+            }
+
+            datagram->release();
+        }
+
+        // Subscriber: take in everything available, and NAK what is missing.
+        //
+        ACE_INET_Addr from;
+        ssize_t size;
+        while ((size = receiver.recv(buffer, sizeof(buffer), from, 0, index < kCount ? &noWait : &shortWait)) > 0) {
+            ACE_Message_Block* data = new ACE_Message_Block(size);
+            data->copy(buffer, size);
+            uint32_t sequence;
+            assertTrue(ReliableMulticast::StripHeader(data, sequence));
+            assertEqual(int64_t(sequence), GetIndex(data));
+            tracker.add(sequence, data, Time::TimeStamp::Now());
+        }
+
+        Time::TimeStamp now = Time::TimeStamp::Now();
+        tracker.expire(now);
+        delivered += popAll(tracker, last);
+
+        uint32_t first, count;
+        while (tracker.nextNAK(now, first, count)) {
+            std::string nak(ReliableMulticast::FormatNAK(first, count));
+            receiver.send(nak.c_str(), nak.size() + 1, nakAddress);
+        }
+
+        // Publisher: resend what was asked for.
+        //
+        while ((size = nakReader.recv(buffer, sizeof(buffer) - 1, from, 0, &noWait)) > 0) {
+            buffer[size] = 0;
+            assertTrue(ReliableMulticast::ParseNAK(buffer, first, count));
+            std::vector<ACE_Message_Block*> datagrams;
+            ring.fetch(first, count, Time::TimeStamp::Now(), datagrams);
+            for (size_t offset = 0; offset < datagrams.size(); ++offset) {
+                ACE_Message_Block flat(datagrams[offset]->total_length());
+                for (ACE_Message_Block* block = datagrams[offset]; block; block = block->cont()) {
+                    flat.copy(block->rd_ptr(), block->length());
+                }
+
+                sender.send(flat.rd_ptr(), flat.length(), receiverAddress);
+                datagrams[offset]->release();
+            }
+        }
+    }
+
+    Time::TimeStamp elapsed = Time::TimeStamp::Now();
+    elapsed -= start;
+    std::clog << "sent: " << kCount << " dropped: " << dropped << " delivered: " << delivered
+              << " recovered: " << tracker.getRecoveredCount() << " unrecovered: " << tracker.getUnrecoveredCount()
+              << " NAKs: " << tracker.getNAKCount() << " resent: " << ring.getRetransmitCount()
+              << " elapsed: " << elapsed.asDouble() << std::endl;
+
+    // Every lost message comes back, and everything is delivered once and in order.
+    //
+    assertEqual(size_t(kCount), delivered);
+    assertEqual(int64_t(kCount - 1), last);
+    assertEqual(dropped, tracker.getRecoveredCount());
+    assertEqual(size_t(0), tracker.getUnrecoveredCount());
+    assertEqual(dropped, ring.getRetransmitCount());
+    assertEqual(size_t(0), ring.getUnavailableCount());
+}
+
+void
+ReliableMulticastTest::test()
+{
+    testHeader();
+    testGapTracker();
+    testRetransmitRing();
+    testLoopback();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return ReliableMulticastTest().mainRun();
+}
@@ -1,9 +1,12 @@
+#include <algorithm>
 #include <sstream>
 
+#include "ace/Guard_T.h"
 #include "ace/Message_Block.h"
 #include "ace/Reactor.h"
 
 #include "Logger/Log.h"
+#include "Utils/IO.h"
 
 #include "GatherWriter.h"
 #include "MessageManager.h"
@@ -59,6 +62,16 @@ ServerSocketWriterTask::OutputHandler::open(void* arg)
     //
     writer_.getDevice().set_handle(get_handle());
 
+    ACE_INET_Addr address;
+    if (peer().get_remote_addr(address) != -1) peer_ = Utils::INETAddrToString(address);
+
+    // The queue limit is a message count that offer() enforces, so the queue itself must never block on its
+    // byte count.
+    //
+    policy_ = task_->getOverflowPolicy();
+    msg_queue()->high_water_mark(~size_t(0) >> 1);
+    msg_queue()->low_water_mark(~size_t(0) >> 1);
+
     task_->addOutputHandler(this);
 
     return activate(task_->threadFlags_, 1, 0, task_->threadPriority_);
@@ -68,14 +81,56 @@ int
 ServerSocketWriterTask::OutputHandler::handle_input(ACE_HANDLE handle)
 {
     Logger::ProcLog log("handle_input", Log());
-    LOGINFO << "remote connection closed" << std::endl;
 
-    // Disable the input queue so that the svc thread will exit.
+    char buffer[256];
+    ssize_t count = peer().recv(buffer, sizeof(buffer));
+    if (count <= 0) {
+        LOGINFO << "remote connection closed" << std::endl;
+
+        // Disable the input queue so that the svc thread will exit.
+        //
+        msg_queue()->deactivate();
+        return 0;
+    }
+
+    input_.append(buffer, count);
+    std::string::size_type pos;
+    while ((pos = input_.find('\n')) != std::string::npos) {
+        handleRequest(input_.substr(0, pos));
+        input_.erase(0, pos + 1);
+    }
+
+    // Requests are short. Do not let a misbehaving client make us hold on to more.
     //
-    msg_queue()->deactivate();
+    if (input_.size() > sizeof(buffer)) input_.clear();
+
     return 0;
 }
 
+void
+ServerSocketWriterTask::OutputHandler::handleRequest(const std::string& line)
+{
+    Logger::ProcLog log("handleRequest", Log());
+    LOGINFO << peer_ << ' ' << line << std::endl;
+
+    SubscriptionRequest request;
+    if (line.compare(0, 3, "SUB") != 0 || !SubscriptionRequest::Parse(line.substr(3), request)) {
+        LOGWARNING << task_->getTaskName() << " ignoring invalid request from " << peer_ << " - " << line
+                   << std::endl;
+        return;
+    }
+
+    ACE_Guard<ACE_Thread_Mutex> guard(requestMutex_);
+    request_ = request;
+}
+
+SubscriptionRequest
+ServerSocketWriterTask::OutputHandler::getRequest() const
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(requestMutex_);
+    return request_;
+}
+
 int
 ServerSocketWriterTask::OutputHandler::close(u_long flags)
 {
@@ -105,6 +160,70 @@ ServerSocketWriterTask::OutputHandler::close(u_long flags)
     return 0;
 }
 
+bool
+ServerSocketWriterTask::OutputHandler::offer(ACE_Message_Block* encoded)
+{
+    static Logger::ProcLog log("offer", Log());
+
+    size_t queued = msg_queue()->message_count();
+    if (queued >= policy_.queueLimit) {
+        if (overflowCount_++ == 0) {
+            LOGWARNING << task_->getTaskName() << " client " << peer_ << " is falling behind - queued: " << queued
+                       << std::endl;
+        }
+
+        switch (policy_.action) {
+        case OverflowPolicy::kDropNewest:
+            encoded->release();
+            ++dropped_;
+            return true;
+
+        case OverflowPolicy::kDropOldest: {
+            // The writer thread may empty the queue first, in which case there is nothing to drop.
+            //
+            ACE_Message_Block* oldest = 0;
+            ACE_Time_Value immediate(ACE_Time_Value::zero);
+            if (msg_queue()->dequeue_head(oldest, &immediate) != -1) {
+                oldest->release();
+                ++dropped_;
+            }
+            break;
+        }
+
+        case OverflowPolicy::kDecimate:
+            // Keep the first message to overflow, and every Nth one after that.
+            //
+            if (queued >= 2 * policy_.queueLimit ||
+                (policy_.decimation > 1 && (overflowCount_ - 1) % policy_.decimation)) {
+                encoded->release();
+                ++dropped_;
+                return true;
+            }
+            break;
+        }
+    } else {
+        overflowCount_ = 0;
+    }
+
+    if (putq(encoded) == -1) {
+        encoded->release();
+        return false;
+    }
+
+    if (++queued > maxQueued_) maxQueued_ = queued;
+    return true;
+}
+
+void
+ServerSocketWriterTask::OutputHandler::getStats(ClientStats& stats)
+{
+    stats.peer = peer_;
+    stats.queued = msg_queue()->message_count();
+    stats.maxQueued = maxQueued_;
+    stats.sent = sent_;
+    stats.dropped = dropped_;
+}
+
 int
 ServerSocketWriterTask::OutputHandler::svc()
 {
@@ -114,15 +233,12 @@ ServerSocketWriterTask::OutputHandler::svc()
     GatherWriter gatherWriter(writer_);
     gatherWriter.setCountLimit(1);
 
+    // Messages in the queue are already encoded (see ServerSocketWriterTask::distribute()).
+    //
     ACE_Message_Block* data = 0;
     while (getq(data) != -1) {
-        MessageManager mgr(data);
-        if (!mgr.hasNativeMessageType(task_->getMetaTypeInfoKey())) {
-            LOGFATAL << "invalid message type in queue - " << mgr.getMessageType() << std::endl;
-            ::abort();
-        }
-
-        gatherWriter.add(mgr.getEncoded());
+        gatherWriter.add(data);
+        ++sent_;
     }
 
     gatherWriter.flush();
@@ -174,7 +290,24 @@ ServerSocketWriterTask::Make()
     return ref;
 }
 
-ServerSocketWriterTask::ServerSocketWriterTask() : IOTask(), acceptor_(0), clients_()
+bool
+ServerSocketWriterTask::OverflowPolicy::GetAction(const std::string& name, Action& action)
+{
+    if (name == "dropOldest") {
+        action = kDropOldest;
+    } else if (name == "dropNewest") {
+        action = kDropNewest;
+    } else if (name == "decimate") {
+        action = kDecimate;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+ServerSocketWriterTask::ServerSocketWriterTask() :
+    IOTask(), acceptor_(0), clients_(), clientsMutex_(), overflowPolicy_()
 {
     Logger::ProcLog log("ServerSocketWriterTask", Log());
     LOGINFO << std::endl;
@@ -272,14 +405,19 @@ ServerSocketWriterTask::close(u_long flags)
 
         // Now, close any remaining client output threads
         //
-        for (size_t index = 0; index < clients_.size(); ++index) {
-            OutputHandler* handler = clients_[index];
+        OutputHandlerVector clients;
+        {
+            ACE_Guard<ACE_Thread_Mutex> guard(clientsMutex_);
+            clients.swap(clients_);
+        }
+
+        for (size_t index = 0; index < clients.size(); ++index) {
+            OutputHandler* handler = clients[index];
             LOGDEBUG << "closing output handler: " << handler << std::endl;
             handler->close(1);
             delete handler;
         }
 
-        clients_.clear();
         connectionCountChangedSignal_(0);
     }
 
@@ -354,15 +492,18 @@ ServerSocketWriterTask::updateClients(ACE_Message_Block* data)
 
     if (data->msg_type() == ACE_Message_Block::MB_START) {
         LOGDEBUG << "added new output handler" << std::endl;
+        ACE_Guard<ACE_Thread_Mutex> guard(clientsMutex_);
         clients_.push_back(outputHandler);
     } else if (data->msg_type() == ACE_Message_Block::MB_HANGUP) {
+        ACE_Guard<ACE_Thread_Mutex> guard(clientsMutex_);
         OutputHandlerVector::iterator pos = std::find(clients_.begin(), clients_.end(), outputHandler);
         if (pos == clients_.end()) {
             LOGERROR << "did not find client to remove" << std::endl;
         } else {
-            (*pos)->close(1);
-            delete *pos;
             clients_.erase(pos);
+            guard.release();
+            outputHandler->close(1);
+            delete outputHandler;
         }
 
         LOGDEBUG << "removed output handler" << std::endl;
@@ -384,16 +525,32 @@ ServerSocketWriterTask::distribute(ACE_Message_Block* data)
     static Logger::ProcLog log("distribute", Log());
 
     MessageManager mgr(data);
+    if (!mgr.hasNativeMessageType(getMetaTypeInfoKey())) {
+        LOGFATAL << "invalid message type in queue - " << mgr.getMessageType() << std::endl;
+        ::abort();
+    }
 
+    // Encode once here, and give each client a reference to the same encoded data, or to a reduced encoding
+    // shared by the clients that asked for the same reduction.
+    //
+    SubscriptionReducer reducer(mgr);
     OutputHandlerVector::const_iterator pos = clients_.begin();
     OutputHandlerVector::const_iterator end = clients_.end();
     for (; pos != end; ++pos) {
+        ACE_Message_Block* encoded = reducer.getEncoded((*pos)->getRequest());
+        if (!encoded) continue;
         LOGDEBUG << "adding to client output queue" << std::endl;
-        ACE_Message_Block* dup = mgr.getMessage();
-        if ((*pos)->put(dup) == -1) {
+        if (!(*pos)->offer(encoded)) {
             LOGERROR << "failed to write to client output queue - flushing" << std::endl;
-            dup->release();
             (*pos)->close(1);
         }
     }
 }
+
+void
+ServerSocketWriterTask::getClientStats(ClientStatsVector& stats) const
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(clientsMutex_);
+    stats.resize(clients_.size());
+    for (size_t index = 0; index < clients_.size(); ++index) clients_[index]->getStats(stats[index]);
+}
@@ -1,12 +1,18 @@
 #ifndef SIDECAR_IO_SERVERSOCKETWRITERTASK_H // -*- C++ -*-
 #define SIDECAR_IO_SERVERSOCKETWRITERTASK_H
 
+#include <atomic>
+#include <string>
+#include <vector>
+
 #include "ace/Acceptor.h"
 #include "ace/SOCK_Acceptor.h"
 #include "ace/Svc_Handler.h"
+#include "ace/Thread_Mutex.h"
 #include "boost/signals2.hpp"
 
 #include "IO/IOTask.h"
+#include "IO/SubscriptionRequest.h"
 #include "IO/Writers.h"
 
 namespace Logger {
@@ -19,6 +25,14 @@ namespace IO {
 /** An ACE service / task that sets up a server-side socket for client connections, managers client connect
     requests, and send data to clients using a SocketWriter object. Outgoing messages are given to the services'
     put() method, where they are queued for transmission.
+
+    Each message is encoded once, and every client queue holds a reference to the same encoded data. The client
+    queues are bounded so that a client that cannot keep up never blocks the task, and through it the processing
+    stream. What happens to a message for a full queue depends on the OverflowPolicy, which each client gets a
+    copy of when it connects.
+
+    A client may ask for less than the full data stream by sending a line of text to the server: "SUB" followed
+    by a SubscriptionRequest in text form. Clients with identical requests share the same reduced encoding.
 */
 class ServerSocketWriterTask : public IOTask {
     using Super = IOTask;
@@ -28,6 +42,50 @@ public:
     using ConnectionCountChanged = boost::signals2::signal<void(int)>;
     using ConnectionCountChangedProc = ConnectionCountChanged::slot_function_type;
 
+    /** What to do with a message for a client whose queue is full.
+     */
+    struct OverflowPolicy {
+        enum Action {
+            kDropOldest, ///< Make room by dropping the oldest queued message
+            kDropNewest, ///< Drop the new message
+            kDecimate    ///< Only queue every Nth new message, up to twice the queue limit
+        };
+
+        enum { kDefaultQueueLimit = 2000, kDefaultDecimation = 4 };
+
+        OverflowPolicy(Action a = kDropOldest, size_t limit = kDefaultQueueLimit,
+                       size_t n = kDefaultDecimation) :
+            action(a), queueLimit(limit), decimation(n)
+        {
+        }
+
+        /** Convert an action name ('dropOldest', 'dropNewest', or 'decimate') into an Action value.
+
+            \param name the name to convert
+
+            \param action storage for the result
+
+            \return true if the name is valid
+        */
+        static bool GetAction(const std::string& name, Action& action);
+
+        Action action;
+        size_t queueLimit; ///< Maximum number of messages queued for a client
+        size_t decimation; ///< Keep every Nth message when decimating
+    };
+
+    /** Snapshot of the state of one client connection.
+     */
+    struct ClientStats {
+        std::string peer; ///< Address of the client
+        size_t queued;    ///< Number of messages waiting to go out
+        size_t maxQueued; ///< Most messages ever waiting to go out
+        size_t sent;      ///< Number of messages sent
+        size_t dropped;   ///< Number of messages dropped due to the overflow policy
+    };
+
+    using ClientStatsVector = std::vector<ClientStats>;
+
     /** Log device for objects of this type.
 
         \return log device
@@ -69,6 +127,10 @@ public:
     */
     uint16_t getServerPort() const { return port_; }
 
+    /** \return true if the task is accepting client connections
+     */
+    bool isListening() const { return acceptor_ != 0; }
+
     /** Obtain the number of active connections to the server.
 
         \return connection count
@@ -77,6 +139,22 @@ public:
 
     int getBufferSize() const { return bufferSize_; }
 
+    /** Set the overflow policy for clients that connect after this call.
+
+        \param policy new policy
+    */
+    void setOverflowPolicy(const OverflowPolicy& policy) { overflowPolicy_ = policy; }
+
+    /** \return the overflow policy for new clients
+     */
+    const OverflowPolicy& getOverflowPolicy() const { return overflowPolicy_; }
+
+    /** Obtain the state of all client connections. Safe to call from any thread.
+
+        \param stats container to fill
+    */
+    void getClientStats(ClientStatsVector& stats) const;
+
     /** Hand a data message to the task to process. Note that since it circumvents the normal message routing
         framework found in Task, this should be used with care.
 
@@ -122,7 +200,11 @@ private:
         */
         static Logger::Log& Log();
 
-        OutputHandler() : Super(), task_(0), writer_() {}
+        OutputHandler() :
+            Super(), task_(0), writer_(), policy_(), peer_(), overflowCount_(0), sent_(0), dropped_(0), maxQueued_(0),
+            requestMutex_(), request_(), input_()
+        {
+        }
 
         ~OutputHandler();
 
@@ -135,14 +217,51 @@ private:
         */
         int open(void* arg = 0);
         int close(u_long flags);
-        int put(ACE_Message_Block* data, ACE_Time_Value* timeout = 0) { return putq(data, timeout); }
+
+        /** Override of ACE_Event_Handler method. Reads subscription requests from the client, or notices that
+            the client closed the connection.
+
+            \param handle socket connection (ignored)
+
+            \return 0 always
+        */
         int handle_input(ACE_HANDLE handle = ACE_INVALID_HANDLE);
 
+        /** Queue an encoded message for the client, applying the overflow policy if the queue is full. Never
+            blocks.
+
+            \param encoded encoded message to send. Takes ownership.
+
+            \return false if the queue is no longer active
+        */
+        bool offer(ACE_Message_Block* encoded);
+
+        /** Obtain a snapshot of the connection state.
+
+            \param stats storage for the snapshot
+        */
+        void getStats(ClientStats& stats);
+
+        /** \return the data reduction the client asked for
+         */
+        SubscriptionRequest getRequest() const;
+
     private:
         int svc();
 
+        void handleRequest(const std::string& line);
+
         ServerSocketWriterTask* task_; ///< Task to receive message objects
         TCPSocketWriter writer_;       ///< Reader of message objects
+        OverflowPolicy policy_;        ///< What to do when the queue is full
+        std::string peer_;             ///< Address of the client
+        size_t overflowCount_;         ///< Number of messages that found the queue full
+        std::atomic<size_t> sent_;
+        std::atomic<size_t> dropped_;
+        std::atomic<size_t> maxQueued_;
+        mutable ACE_Thread_Mutex requestMutex_; ///< Guards request_, which the reactor thread changes
+        SubscriptionRequest request_;           ///< Data reduction asked for by the client
+        std::string input_;                     ///< Partial request line from the client
     };
 
     friend class OutputHandler;
@@ -193,6 +312,8 @@ private:
     uint16_t port_;
     using OutputHandlerVector = std::vector<OutputHandler*>;
     OutputHandlerVector clients_;
+    mutable ACE_Thread_Mutex clientsMutex_; ///< Guards changes to clients_ against getClientStats()
+    OverflowPolicy overflowPolicy_;
     int bufferSize_;
     long threadFlags_;
     long threadPriority_;
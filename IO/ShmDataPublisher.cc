@@ -0,0 +1,159 @@
+#include <unistd.h>
+
+#include <cstring>
+#include <sstream>
+
+#include "ace/Reactor.h"
+
+#include "Logger/Log.h"
+
+#include "MessageManager.h"
+#include "ShmDataPublisher.h"
+
+using namespace SideCar::IO;
+
+Logger::Log&
+ShmDataPublisher::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.ShmDataPublisher");
+    return log_;
+}
+
+ShmDataPublisher::Ref
+ShmDataPublisher::Make()
+{
+    Ref ref(new ShmDataPublisher);
+    return ref;
+}
+
+ShmDataPublisher::ShmDataPublisher() : Super(), ring_(), readerCount_(0), timer_(-1)
+{
+    ;
+}
+
+bool
+ShmDataPublisher::openAndInit(const std::string& key, const std::string& serviceName, uint16_t port,
+                              int bufferSize, size_t ringSize, long threadFlags, long threadPriority)
+{
+    static Logger::ProcLog log("openAndInit", Log());
+    LOGINFO << "key: " << key << " serviceName: " << serviceName << " ringSize: " << ringSize << std::endl;
+
+    // Segment names must be unique on the host, and may not hold any more '/' characters, so do not use the
+    // service name.
+    //
+    static int counter = 0;
+    std::ostringstream os;
+    os << "/SideCar." << ::getpid() << '.' << ++counter;
+
+    ring_ = ShmRing::Create(os.str(), ringSize);
+    if (!ring_) {
+        setError("Failed to create shared memory ring");
+        return false;
+    }
+
+    // Add the ring to the TXT record before the TCP publisher publishes the service.
+    //
+    char host[256];
+    if (::gethostname(host, sizeof(host)) == -1) host[0] = 0;
+    host[sizeof(host) - 1] = 0;
+    getConnectionPublisher()->setTextData("shm", ring_->getName(), false);
+    getConnectionPublisher()->setTextData("shmHost", host, false);
+
+    if (!Super::openAndInit(key, serviceName, port, bufferSize, threadFlags, threadPriority)) {
+        ring_.reset();
+        return false;
+    }
+
+    if (!reactor()) reactor(ACE_Reactor::instance());
+    const ACE_Time_Value delay(1);
+    const ACE_Time_Value repeatInterval(1);
+    timer_ = reactor()->schedule_timer(this, &timer_, delay, repeatInterval);
+    if (timer_ == -1) LOGERROR << getTaskName() << " failed to schedule timer for ring readers" << std::endl;
+
+    return true;
+}
+
+int
+ShmDataPublisher::close(u_long flags)
+{
+    Logger::ProcLog log("close", Log());
+    LOGINFO << "flags: " << flags << std::endl;
+
+    if (timer_ != -1) {
+        reactor()->cancel_timer(timer_);
+        timer_ = -1;
+    }
+
+    int rc = Super::close(flags);
+    ring_.reset();
+    readerCount_ = 0;
+    return rc;
+}
+
+bool
+ShmDataPublisher::deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout)
+{
+    static Logger::ProcLog log("deliverDataMessage", Log());
+
+    if (ring_ && ring_->getReaderCount()) {
+        // The encoded data stays with the message, so the TCP writer threads will not have to encode it again.
+        //
+        MessageManager mgr(data->duplicate());
+        ACE_Message_Block* encoded = mgr.getEncoded();
+        if (encoded) {
+            char* ptr = static_cast<char*>(ring_->reserve(encoded->total_length()));
+            if (ptr) {
+                for (ACE_Message_Block* block = encoded; block; block = block->cont()) {
+                    ::memcpy(ptr, block->rd_ptr(), block->length());
+                    ptr += block->length();
+                }
+
+                ring_->commit();
+            } else {
+                LOGWARNING << getTaskName() << " message too big for ring - " << encoded->total_length()
+                           << std::endl;
+            }
+
+            encoded->release();
+        }
+    }
+
+    return Super::deliverDataMessage(data, timeout);
+}
+
+void
+ShmDataPublisher::updateReaders()
+{
+    static Logger::ProcLog log("updateReaders", Log());
+    if (!ring_) return;
+
+    ring_->releaseDeadReaders();
+    size_t readerCount = ring_->getReaderCount();
+    if (readerCount != readerCount_) {
+        LOGINFO << getTaskName() << " readers: " << readerCount << std::endl;
+        readerCount_ = readerCount;
+        updateUsingDataValue();
+    }
+}
+
+void
+ShmDataPublisher::describeConnections(std::ostream& os) const
+{
+    Super::describeConnections(os);
+    os << " Local: " << readerCount_;
+    if (readerCount_ && ring_) os << " Lag: " << ring_->getMaxReaderLag();
+}
+
+int
+ShmDataPublisher::handle_timeout(const ACE_Time_Value& duration, const void* arg)
+{
+    if (arg != &timer_) return Super::handle_timeout(duration, arg);
+    updateReaders();
+    return 0;
+}
+
+bool
+ShmDataPublisher::calculateUsingDataValue() const
+{
+    return readerCount_ > 0 || Super::calculateUsingDataValue();
+}
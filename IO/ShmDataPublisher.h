@@ -0,0 +1,112 @@
+#ifndef SIDECAR_IO_SHMDATAPUBLISHER_H // -*- C++ -*-
+#define SIDECAR_IO_SHMDATAPUBLISHER_H
+
+#include "IO/ShmRing.h"
+#include "IO/TCPDataPublisher.h"
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace IO {
+
+/** Publisher of data that serves subscribers on the same host from a ShmRing, and everyone else over TCP. The
+    ring name and the host name go into the Zeroconf TXT record of the TCP service, under the "shm" and "shmHost"
+    keys, so a ShmDataSubscriber can tell that it is local and attach to the ring instead of connecting. Other
+    subscribers see a normal TCP publisher.
+
+    Each message is encoded once and copied into the ring; local subscribers decode it straight from their own
+    copy, without going through the kernel. A timer checks the ring for new or departed readers, and releases the
+    slots of reader processes that died without detaching.
+*/
+class ShmDataPublisher : public TCPDataPublisher {
+    using Super = TCPDataPublisher;
+
+public:
+    using Self = ShmDataPublisher;
+    using Ref = boost::shared_ptr<Self>;
+
+    enum { kDefaultRingSize = 32 * 1024 * 1024 };
+
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Factory method for creating new ShmDataPublisher objects
+
+        \return reference to new ShmDataPublisher object
+    */
+    static Ref Make();
+
+    /** Create the shared memory ring and open a server connection on a particular port.
+
+        \param key message type key of published data
+
+        \param serviceName Zeroconf name of service publishing the data
+
+        \param ringSize number of bytes in the shared memory ring
+
+        \return true if successful, false otherwise
+    */
+    bool openAndInit(const std::string& key, const std::string& serviceName, uint16_t port = 0, int bufferSize = 0,
+                     size_t ringSize = kDefaultRingSize, long threadFlags = kDefaultThreadFlags,
+                     long threadPriority = ACE_DEFAULT_THREAD_PRIORITY);
+
+    /** Override of TCPDataPublisher method. Removes the shared memory ring.
+
+        \param flags if 1 module is shutting down
+
+        \return 0 if successful, -1 otherwise.
+    */
+    int close(u_long flags = 0);
+
+    /** \return number of subscribers reading from the shared memory ring
+     */
+    size_t getLocalReaderCount() const { return readerCount_; }
+
+protected:
+    /** Constructor.
+     */
+    ShmDataPublisher();
+
+    bool deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout = 0);
+
+    /** Override of TCPDataPublisher method. Adds the number of shared memory readers and the lag of the
+        slowest one.
+
+        \param os stream to write to
+    */
+    void describeConnections(std::ostream& os) const;
+
+private:
+    bool calculateUsingDataValue() const;
+
+    /** Override of DataPublisher method. Checks the ring readers when our timer fires.
+
+        \param duration the timer period
+
+        \param arg the timer that fired
+
+        \return 0 always
+    */
+    int handle_timeout(const ACE_Time_Value& duration, const void* arg);
+
+    void updateReaders();
+
+    ShmRing::Ref ring_;
+    size_t readerCount_;
+    long timer_;
+};
+
+using ShmDataPublisherModule = TModule<ShmDataPublisher>;
+
+} // end namespace IO
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
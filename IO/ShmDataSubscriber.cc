@@ -0,0 +1,257 @@
+#include <unistd.h>
+
+#include <sstream>
+
+#include "ace/CDR_Base.h"
+#include "ace/Guard_T.h"
+#include "ace/Task.h"
+
+#include "Logger/Log.h"
+
+#include "MessageManager.h"
+#include "ShmDataSubscriber.h"
+#include "ShmRing.h"
+
+namespace SideCar {
+namespace IO {
+
+/** Internal class used by ShmDataSubscriber to read from a ShmRing in a separate thread.
+ */
+class ShmDataSubscriber::ReaderThread : public ACE_Task<ACE_MT_SYNCH> {
+    using Super = ACE_Task<ACE_MT_SYNCH>;
+
+public:
+    static Logger::Log& Log();
+
+    /** Constructor.
+
+        \param owner the subscriber to give messages to
+
+        \param ring the ring to read from
+    */
+    ReaderThread(ShmDataSubscriber* owner, const ShmRing::Ref& ring) :
+        Super(), owner_(owner), reader_(ring), active_(false)
+    {
+    }
+
+    /** Start a new thread to read from the ring.
+
+        \return true if successful, false otherwise
+    */
+    bool openAndInit(long threadFlags, long threadPriority)
+    {
+        static Logger::ProcLog log("openAndInit", Log());
+        if (!reader_.isValid()) {
+            owner_->setError("No free slot in shared memory ring");
+            return false;
+        }
+
+        active_ = true;
+        if (activate(threadFlags, 1, 0, threadPriority) == -1) {
+            active_ = false;
+            LOGERROR << owner_->getTaskName() << " failed to start reader thread" << std::endl;
+            owner_->setError("Failed to start reader thread");
+            return false;
+        }
+
+        return true;
+    }
+
+    /** Stop the reader thread. Also called when the service thread exits the svc() method.
+
+        \param flags if non-zero, called by an external entity to shut down the reader
+
+        \return -1 if error
+    */
+    int close(u_long flags = 0)
+    {
+        static Logger::ProcLog log("close", Log());
+        LOGINFO << "flags: " << flags << std::endl;
+        if (flags && active_) {
+            active_ = false;
+            wait();
+        }
+
+        return Super::close(flags);
+    }
+
+private:
+    /** Method run in a separate thread due to ACE_Task::activate() being invoked. Copies records from the ring
+        into new message blocks and hands them to the owner. The wait on the ring has a timeout, which allows the
+        thread to periodically check for shutdown notification.
+
+        \return 0
+    */
+    int svc()
+    {
+        static Logger::ProcLog log("svc", Log());
+        LOGINFO << owner_->getTaskName() << std::endl;
+        uint64_t dropped = 0;
+        const SubscriptionRequest request(owner_->getSubscriptionRequest());
+        while (active_) {
+            if (!reader_.wait(250)) continue;
+            while (active_) {
+                size_t size = reader_.peek();
+                if (!size) break;
+
+                ACE_Message_Block* data = MessageManager::MakeMessageBlock(size + ACE_CDR::MAX_ALIGNMENT);
+                ACE_CDR::mb_align(data);
+                if (!reader_.read(data->wr_ptr())) {
+                    data->release();
+                    continue;
+                }
+
+                data->wr_ptr(size);
+
+                // The ring holds everything the publisher sends, so apply our subscription request here.
+                //
+                data = SubscriptionReducer::ReduceReceived(request, data, owner_->getMetaTypeInfo());
+                if (data) owner_->acquireExternalMessage(data);
+            }
+
+            if (reader_.getDropCount() != dropped) {
+                dropped = reader_.getDropCount();
+                LOGWARNING << owner_->getTaskName() << " fell behind publisher - dropped: " << dropped << std::endl;
+            }
+        }
+
+        LOGINFO << owner_->getTaskName() << " exiting" << std::endl;
+        return 0;
+    }
+
+    ShmDataSubscriber* owner_;
+    ShmRing::Reader reader_;
+    volatile bool active_;
+};
+
+} // namespace IO
+} // namespace SideCar
+
+using namespace SideCar::IO;
+
+Logger::Log&
+ShmDataSubscriber::ReaderThread::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.ShmDataSubscriber.ReaderThread");
+    return log_;
+}
+
+Logger::Log&
+ShmDataSubscriber::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.ShmDataSubscriber");
+    return log_;
+}
+
+ShmDataSubscriber::Ref
+ShmDataSubscriber::Make()
+{
+    Ref ref(new ShmDataSubscriber);
+    return ref;
+}
+
+ShmDataSubscriber::ShmDataSubscriber() :
+    Super(), reader_(0), threadFlags_(kDefaultThreadFlags), threadPriority_(ACE_DEFAULT_THREAD_PRIORITY)
+{
+    ;
+}
+
+bool
+ShmDataSubscriber::openAndInit(const std::string& key, const std::string& serviceName, int bufferSize, int interface,
+                               long threadFlags, long threadPriority)
+{
+    threadFlags_ = threadFlags;
+    threadPriority_ = threadPriority;
+    return Super::openAndInit(key, serviceName, bufferSize, interface);
+}
+
+int
+ShmDataSubscriber::close(u_long flags)
+{
+    static Logger::ProcLog log("close", Log());
+    LOGINFO << getTaskName() << " flags: " << flags << std::endl;
+    if (flags) {
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        stopReader();
+    }
+
+    return Super::close(flags);
+}
+
+void
+ShmDataSubscriber::resolvedService(const Zeroconf::ServiceEntry::Ref& serviceEntry)
+{
+    static Logger::ProcLog log("resolvedService", Log());
+    const Zeroconf::ResolvedEntry& resolved = serviceEntry->getResolvedEntry();
+
+    // Only use the ring if the publisher is on this host. Otherwise, or if the ring is gone, use TCP.
+    //
+    char host[256];
+    if (::gethostname(host, sizeof(host)) == -1) host[0] = 0;
+    host[sizeof(host) - 1] = 0;
+
+    std::string name;
+    bool local = resolved.hasTextEntry("shm", &name) && resolved.getTextEntry("shmHost") == host;
+    LOGINFO << getTaskName() << " ring: " << name << " local: " << local << std::endl;
+
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        stopReader();
+        if (local && startReader(name)) {
+            Super::lostService();
+            std::ostringstream os;
+            os << "Ring: " << name;
+            setConnectionInfo(os.str());
+            guard.release();
+            establishedConnection();
+            return;
+        }
+    }
+
+    Super::resolvedService(serviceEntry);
+}
+
+void
+ShmDataSubscriber::lostService()
+{
+    static Logger::ProcLog log("lostService", Log());
+    LOGINFO << getTaskName() << std::endl;
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
+        stopReader();
+    }
+
+    Super::lostService();
+}
+
+bool
+ShmDataSubscriber::startReader(const std::string& name)
+{
+    static Logger::ProcLog log("startReader", Log());
+    ShmRing::Ref ring(ShmRing::Attach(name));
+    if (!ring) {
+        LOGWARNING << getTaskName() << " failed to attach to ring " << name << " - using TCP" << std::endl;
+        return false;
+    }
+
+    reader_ = new ReaderThread(this, ring);
+    if (!reader_->openAndInit(threadFlags_, threadPriority_)) {
+        LOGWARNING << getTaskName() << " failed to start ring reader - using TCP" << std::endl;
+        stopReader();
+        return false;
+    }
+
+    return true;
+}
+
+void
+ShmDataSubscriber::stopReader()
+{
+    static Logger::ProcLog log("stopReader", Log());
+    LOGINFO << getTaskName() << " reader: " << reader_ << std::endl;
+    if (reader_) {
+        reader_->close(1);
+        delete reader_;
+        reader_ = 0;
+    }
+}
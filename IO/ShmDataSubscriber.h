@@ -0,0 +1,104 @@
+#ifndef SIDECAR_IO_SHMDATASUBSCRIBER_H // -*- C++ -*-
+#define SIDECAR_IO_SHMDATASUBSCRIBER_H
+
+#include "ace/Thread_Mutex.h"
+
+#include "IO/TCPDataSubscriber.h"
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace IO {
+
+/** Subscriber of data from a TCPDataPublisher or ShmDataPublisher. If the resolved service advertises a ShmRing
+    on this host, the subscriber attaches to the ring and reads messages from it in a separate thread. Otherwise,
+    it behaves just like a TCPDataSubscriber.
+*/
+class ShmDataSubscriber : public TCPDataSubscriber {
+    using Super = TCPDataSubscriber;
+
+public:
+    using Ref = boost::shared_ptr<ShmDataSubscriber>;
+
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Factory method for creating new ShmDataSubscriber objects
+
+        \return reference to new ShmDataSubscriber object
+    */
+    static Ref Make();
+
+    /** Prepare to subscribe to a data publisher with a given service name. See TCPDataSubscriber::openAndInit().
+
+        \param key message type key of data coming in
+
+        \param serviceName Zeroconf name of service publishing the data
+
+        \param threadFlags flags for the thread that reads from a shared memory ring
+
+        \param threadPriority priority of the thread that reads from a shared memory ring
+
+        \return true if successful, false otherwise
+    */
+    bool openAndInit(const std::string& key, const std::string& serviceName, int bufferSize = 0, int interface = 0,
+                     long threadFlags = kDefaultThreadFlags, long threadPriority = ACE_DEFAULT_THREAD_PRIORITY);
+
+    /** Override of TCPDataSubscriber method. Stops any ring reader.
+
+        \param flags if 1 module is shutting down
+
+        \return 0 if successful, -1 otherwise.
+    */
+    int close(u_long flags = 0);
+
+protected:
+    /** Constructor.
+     */
+    ShmDataSubscriber();
+
+private:
+    /** Override of TCPDataSubscriber method. Attach to the publisher's ring if it is on this host, or connect
+        with TCP if not.
+
+        \param service the service that was resolved
+    */
+    void resolvedService(const Zeroconf::ServiceEntry::Ref& service);
+
+    /** Override of TCPDataSubscriber method. Shuts down the ring reader or TCP connection.
+     */
+    void lostService();
+
+    /** Attach to a shared memory ring and start a thread to read from it.
+
+        \param name name of the ring
+
+        \return true if successful
+    */
+    bool startReader(const std::string& name);
+
+    /** Shut down any active ring reader.
+     */
+    void stopReader();
+
+    ACE_Thread_Mutex mutex_;
+    class ReaderThread;
+    ReaderThread* reader_;
+    long threadFlags_;
+    long threadPriority_;
+};
+
+using ShmDataSubscriberModule = TModule<ShmDataSubscriber>;
+
+} // end namespace IO
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
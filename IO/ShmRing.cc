@@ -0,0 +1,465 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "Logger/Log.h"
+#include "Utils/Format.h"
+
+#include "ShmRing.h"
+
+using namespace SideCar::IO;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory ring needs lock-free 64-bit atomics");
+
+/** Reader state kept in the segment header. The pid value is zero when the slot is free.
+ */
+struct ShmRing::Slot {
+    alignas(64) std::atomic<uint32_t> pid;
+    std::atomic<uint64_t> position;
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> reads;
+    std::atomic<uint64_t> drops;
+};
+
+/** Layout of the start of the shared memory segment. The ring data follows. Positions are byte offsets that
+    only ever increase; the ring offset is the position modulo the capacity. The writer advances reservePos
+    before it overwrites anything, and writePos after a record is complete. The lastPos value is the start of the
+    newest record.
+*/
+struct ShmRing::Header {
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint64_t capacity;
+    alignas(64) std::atomic<uint64_t> reservePos;
+    std::atomic<uint64_t> writePos;
+    std::atomic<uint64_t> lastPos;
+    std::atomic<uint64_t> writeCount;
+    std::atomic<uint32_t> doorbell;
+    std::atomic<uint32_t> waiters;
+    Slot slots[ShmRing::kMaxReaders];
+};
+
+namespace {
+
+const uint32_t kMagic = 0x53434852; // "SCHR"
+const uint32_t kVersion = 1;
+
+/** Each record starts with its size and the low 32 bits of its sequence number, and is padded to a multiple of
+    8 bytes.
+*/
+struct RecordHeader {
+    uint32_t size;
+    uint32_t sequence;
+};
+
+const uint32_t kWrapMarker = 0xFFFFFFFF;
+
+size_t
+RecordSpan(size_t size)
+{
+    return sizeof(RecordHeader) + (size + 7) / 8 * 8;
+}
+
+/** Sleep until the doorbell value changes from expected, or the timeout passes. Without futexes, just sleep
+    for a short while and let the caller check again.
+*/
+void
+WaitForDoorbell(std::atomic<uint32_t>& doorbell, uint32_t expected, int msecs)
+{
+#ifdef __linux__
+    timespec timeout;
+    timeout.tv_sec = msecs / 1000;
+    timeout.tv_nsec = (msecs % 1000) * 1000000L;
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&doorbell), FUTEX_WAIT, expected, &timeout, 0, 0);
+#else
+    if (doorbell.load() == expected) {
+        timespec delay = {0, std::min(msecs, 1) * 1000000L};
+        ::nanosleep(&delay, 0);
+    }
+#endif
+}
+
+void
+RingDoorbell(std::atomic<uint32_t>& doorbell)
+{
+#ifdef __linux__
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&doorbell), FUTEX_WAKE, INT_MAX, 0, 0, 0);
+#endif
+}
+
+} // namespace
+
+Logger::Log&
+ShmRing::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.ShmRing");
+    return log_;
+}
+
+ShmRing::Ref
+ShmRing::Create(const std::string& name, size_t capacity)
+{
+    static Logger::ProcLog log("Create", Log());
+    LOGINFO << "name: " << name << " capacity: " << capacity << std::endl;
+
+    capacity = (capacity + 7) / 8 * 8;
+    if (capacity < 1024) {
+        LOGERROR << "capacity too small - " << capacity << std::endl;
+        return Ref();
+    }
+
+    // Remove any segment left behind by an earlier process with the same name.
+    //
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd == -1) {
+        LOGERROR << "failed to create segment " << name << " - " << Utils::showErrno() << std::endl;
+        return Ref();
+    }
+
+    size_t mapped = sizeof(Header) + capacity;
+    void* base = MAP_FAILED;
+    if (::ftruncate(fd, mapped) == 0) base = ::mmap(0, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        LOGERROR << "failed to map segment " << name << " - " << Utils::showErrno() << std::endl;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return Ref();
+    }
+
+    ::close(fd);
+
+    // The new segment is all zeros. Fill in the rest of the header, and write the magic value last so that a
+    // reader that attaches early does not see a partial header.
+    //
+    Header* header = new (base) Header;
+    header->version = kVersion;
+    header->capacity = capacity;
+    header->reservePos = 0;
+    header->writePos = 0;
+    header->lastPos = 0;
+    header->writeCount = 0;
+    header->doorbell = 0;
+    header->waiters = 0;
+    for (Slot& slot : header->slots) slot.pid = 0;
+    header->magic.store(kMagic, std::memory_order_release);
+
+    return Ref(new ShmRing(name, base, mapped, true));
+}
+
+ShmRing::Ref
+ShmRing::Attach(const std::string& name)
+{
+    static Logger::ProcLog log("Attach", Log());
+    LOGINFO << "name: " << name << std::endl;
+
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1) {
+        LOGERROR << "failed to open segment " << name << " - " << Utils::showErrno() << std::endl;
+        return Ref();
+    }
+
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && size_t(st.st_size) > sizeof(Header)) {
+        base = ::mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        LOGERROR << "failed to map segment " << name << " - " << Utils::showErrno() << std::endl;
+        return Ref();
+    }
+
+    Header* header = static_cast<Header*>(base);
+    if (header->magic.load(std::memory_order_acquire) != kMagic || header->version != kVersion ||
+        sizeof(Header) + header->capacity != size_t(st.st_size)) {
+        LOGERROR << "segment " << name << " does not hold a ring" << std::endl;
+        ::munmap(base, st.st_size);
+        return Ref();
+    }
+
+    return Ref(new ShmRing(name, base, st.st_size, false));
+}
+
+ShmRing::ShmRing(const std::string& name, void* base, size_t mapped, bool owner) :
+    name_(name), header_(static_cast<Header*>(base)), data_(static_cast<char*>(base) + sizeof(Header)),
+    capacity_(header_->capacity), mapped_(mapped), owner_(owner), reserveBegin_(0), reserveEnd_(0), reserveSize_(0)
+{
+    ;
+}
+
+ShmRing::~ShmRing()
+{
+    ::munmap(header_, mapped_);
+    if (owner_) ::shm_unlink(name_.c_str());
+}
+
+size_t
+ShmRing::getMaxRecordSize() const
+{
+    return capacity_ / 4 - sizeof(RecordHeader);
+}
+
+size_t
+ShmRing::getReaderCount() const
+{
+    size_t count = 0;
+    for (const Slot& slot : header_->slots) {
+        if (slot.pid.load() != 0) ++count;
+    }
+
+    return count;
+}
+
+uint64_t
+ShmRing::getWriteCount() const
+{
+    return header_->writeCount.load();
+}
+
+uint64_t
+ShmRing::getMaxReaderLag() const
+{
+    uint64_t writeCount = header_->writeCount.load();
+    uint64_t lag = 0;
+    for (const Slot& slot : header_->slots) {
+        if (slot.pid.load() != 0) lag = std::max(lag, writeCount - std::min(writeCount, slot.sequence.load()));
+    }
+
+    return lag;
+}
+
+size_t
+ShmRing::releaseDeadReaders()
+{
+    static Logger::ProcLog log("releaseDeadReaders", Log());
+    size_t count = 0;
+    for (Slot& slot : header_->slots) {
+        uint32_t pid = slot.pid.load();
+        if (pid != 0 && ::kill(pid, 0) == -1 && errno == ESRCH && slot.pid.compare_exchange_strong(pid, 0)) {
+            LOGWARNING << name_ << " released slot of reader " << pid << std::endl;
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+void*
+ShmRing::reserve(size_t size)
+{
+    if (size > getMaxRecordSize()) return 0;
+
+    // Start the record over at the beginning of the ring if it would run past the end. There is always room for
+    // the wrap marker, since positions and the capacity are multiples of 8.
+    //
+    uint64_t begin = header_->writePos.load(std::memory_order_relaxed);
+    size_t span = RecordSpan(size);
+    size_t remaining = capacity_ - begin % capacity_;
+    uint64_t record = span > remaining ? begin + remaining : begin;
+
+    // Claim the space before touching it. Readers check reservePos after copying out a record, and the fence
+    // guarantees that a reader that sees any of the new bytes also sees the new reservePos value.
+    //
+    header_->reservePos.store(record + span, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (record != begin) {
+        RecordHeader marker = {kWrapMarker, 0};
+        ::memcpy(getRecord(begin), &marker, sizeof(marker));
+    }
+
+    reserveBegin_ = record;
+    reserveEnd_ = record + span;
+    reserveSize_ = size;
+    return getRecord(record) + sizeof(RecordHeader);
+}
+
+void
+ShmRing::commit()
+{
+    uint64_t sequence = header_->writeCount.load(std::memory_order_relaxed);
+    RecordHeader recordHeader = {reserveSize_, uint32_t(sequence)};
+    ::memcpy(getRecord(reserveBegin_), &recordHeader, sizeof(recordHeader));
+
+    header_->writeCount.store(sequence + 1);
+    header_->lastPos.store(reserveBegin_);
+    header_->writePos.store(reserveEnd_);
+
+    // Only make the system call if a reader is (or is about to be) asleep. See Reader::wait().
+    //
+    header_->doorbell.fetch_add(1);
+    if (header_->waiters.load() != 0) RingDoorbell(header_->doorbell);
+}
+
+bool
+ShmRing::write(const void* data, size_t size)
+{
+    void* ptr = reserve(size);
+    if (!ptr) return false;
+    ::memcpy(ptr, data, size);
+    commit();
+    return true;
+}
+
+ShmRing::Reader::Reader(const Ref& ring) : ring_(ring), slot_(0), position_(0), pending_(0)
+{
+    static Logger::ProcLog log("Reader", Log());
+    uint32_t pid = ::getpid();
+    for (Slot& slot : ring_->header_->slots) {
+        uint32_t free = 0;
+        if (slot.pid.compare_exchange_strong(free, pid)) {
+            slot_ = &slot;
+            break;
+        }
+    }
+
+    if (!slot_) {
+        LOGERROR << ring_->getName() << " has no free reader slots" << std::endl;
+        return;
+    }
+
+    // Start with the next record written. The writer updates the write count before the write position, so the
+    // count may include one record before the starting position. The first read() takes care of that.
+    //
+    position_ = ring_->header_->writePos.load();
+    slot_->position = position_;
+    slot_->sequence = ring_->header_->writeCount.load();
+    slot_->reads = 0;
+    slot_->drops = 0;
+}
+
+ShmRing::Reader::~Reader()
+{
+    if (slot_) slot_->pid.store(0);
+}
+
+void
+ShmRing::Reader::skipAhead()
+{
+    position_ = ring_->header_->lastPos.load();
+    pending_ = 0;
+}
+
+size_t
+ShmRing::Reader::peek()
+{
+    if (!slot_) return 0;
+    const Header* header = ring_->header_;
+    uint64_t capacity = ring_->capacity_;
+    while (true) {
+        uint64_t writePos = header->writePos.load(std::memory_order_acquire);
+        if (position_ == writePos) return 0;
+        if (writePos - position_ > capacity) {
+            skipAhead();
+            continue;
+        }
+
+        RecordHeader recordHeader;
+        ::memcpy(&recordHeader, ring_->getRecord(position_), sizeof(recordHeader));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->reservePos.load(std::memory_order_relaxed) - position_ > capacity) {
+            skipAhead();
+            continue;
+        }
+
+        if (recordHeader.size == kWrapMarker) {
+            position_ += capacity - position_ % capacity;
+            continue;
+        }
+
+        pending_ = recordHeader.size;
+        return pending_;
+    }
+}
+
+bool
+ShmRing::Reader::read(void* buffer)
+{
+    const Header* header = ring_->header_;
+    const char* record = ring_->getRecord(position_);
+    RecordHeader recordHeader;
+    ::memcpy(&recordHeader, record, sizeof(recordHeader));
+    ::memcpy(buffer, record + sizeof(recordHeader), pending_);
+
+    // If the writer claimed any of the space we just copied, the copy may hold a mix of old and new bytes.
+    //
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->reservePos.load(std::memory_order_relaxed) - position_ > ring_->capacity_ ||
+        recordHeader.size != pending_) {
+        skipAhead();
+        return false;
+    }
+
+    // Recover the full sequence number of the record from its low 32 bits and the one we expected. Any gap is
+    // the number of records that were overwritten before we could get to them.
+    //
+    uint64_t expected = slot_->sequence.load(std::memory_order_relaxed);
+    uint64_t sequence = expected + int32_t(recordHeader.sequence - uint32_t(expected));
+    if (sequence > expected) slot_->drops.fetch_add(sequence - expected, std::memory_order_relaxed);
+
+    position_ += RecordSpan(pending_);
+    pending_ = 0;
+    slot_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    slot_->position.store(position_, std::memory_order_relaxed);
+    slot_->reads.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool
+ShmRing::Reader::wait(int msecs)
+{
+    if (!slot_) return false;
+    Header* header = ring_->header_;
+
+    // Register as a waiter before the last check for data, so that the writer either sees us waiting or we see
+    // its new record. If the writer rings the doorbell after we read its value, the futex call returns at once.
+    //
+    uint32_t doorbell = header->doorbell.load();
+    if (header->writePos.load() != position_) return true;
+    header->waiters.fetch_add(1);
+    if (header->writePos.load() == position_) WaitForDoorbell(header->doorbell, doorbell, msecs);
+    header->waiters.fetch_sub(1);
+    return header->writePos.load() != position_;
+}
+
+uint64_t
+ShmRing::Reader::getLag() const
+{
+    if (!slot_) return 0;
+    uint64_t writeCount = ring_->header_->writeCount.load();
+    return writeCount - std::min(writeCount, slot_->sequence.load());
+}
+
+uint64_t
+ShmRing::Reader::getLagBytes() const
+{
+    return slot_ ? ring_->header_->writePos.load() - position_ : 0;
+}
+
+uint64_t
+ShmRing::Reader::getReadCount() const
+{
+    return slot_ ? slot_->reads.load() : 0;
+}
+
+uint64_t
+ShmRing::Reader::getDropCount() const
+{
+    return slot_ ? slot_->drops.load() : 0;
+}
@@ -0,0 +1,214 @@
+#ifndef SIDECAR_IO_SHMRING_H // -*- C++ -*-
+#define SIDECAR_IO_SHMRING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "boost/shared_ptr.hpp"
+
+#include "Utils/Utils.h"
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace IO {
+
+/** Ring buffer of variable-sized records held in a POSIX shared memory segment, for passing messages between
+    processes on the same host without going through the kernel. There is one writer, the process that created
+    the segment, and up to kMaxReaders readers, each with its own cursor into the ring.
+
+    The writer never waits for readers. Each record is copied into the ring once, and then the writer rings a
+    doorbell, a futex word in the segment header that sleeping readers wait on. A reader that falls more than the
+    ring capacity behind has records overwritten before it can copy them out. The reader detects this after the
+    copy, by checking how far the writer has claimed space, and then skips ahead to the newest record. Records
+    carry sequence numbers, so each reader knows exactly how many records it missed. Each reader also keeps how
+    far it lags behind the writer, in records and in bytes, in its slot in the segment header, where the writer
+    can see it.
+
+    Records are kept contiguous in the ring: one that would run past the end of the ring starts over at the
+    beginning, and a marker in the header slot left behind tells readers to do the same. Records are limited to
+    a quarter of the ring capacity.
+*/
+class ShmRing : public Utils::Uncopyable {
+    struct Header;
+    struct Slot;
+
+public:
+    using Ref = boost::shared_ptr<ShmRing>;
+
+    enum { kMaxReaders = 16 };
+
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Create a new shared memory segment and initialize an empty ring in it. Any existing segment with the same
+        name is removed first. The segment is removed when the returned object is destroyed.
+
+        \param name name of the segment. Should start with a '/' character
+
+        \param capacity number of bytes to hold in the ring. Rounded up to a multiple of 8
+
+        \return new ShmRing object, or NULL on failure
+    */
+    static Ref Create(const std::string& name, size_t capacity);
+
+    /** Attach to a ring created by another process (or this one).
+
+        \param name name of the segment
+
+        \return new ShmRing object, or NULL if the segment does not exist or does not hold a ring
+    */
+    static Ref Attach(const std::string& name);
+
+    /** Destructor. Unmaps the segment, and removes it if this object created it.
+     */
+    ~ShmRing();
+
+    /** \return name of the shared memory segment
+     */
+    const std::string& getName() const { return name_; }
+
+    /** \return number of bytes in the ring
+     */
+    size_t getCapacity() const { return capacity_; }
+
+    /** \return largest record size that write() will accept
+     */
+    size_t getMaxRecordSize() const;
+
+    /** \return number of readers attached to the ring
+     */
+    size_t getReaderCount() const;
+
+    /** \return number of records written to the ring
+     */
+    uint64_t getWriteCount() const;
+
+    /** \return largest lag in records of the attached readers
+     */
+    uint64_t getMaxReaderLag() const;
+
+    /** Release the reader slots of processes that no longer exist.
+
+        \return number of slots released
+    */
+    size_t releaseDeadReaders();
+
+    /** Obtain space for a record of a given size. Follow with commit() after filling in the space. Only the
+        process that created the ring may write to it.
+
+        \param size number of bytes in the record
+
+        \return pointer to the space for the record, or NULL if the record is too big
+    */
+    void* reserve(size_t size);
+
+    /** Make the record obtained by the last reserve() call visible to readers, and wake any that are waiting.
+     */
+    void commit();
+
+    /** Add one record to the ring. Calls reserve() and commit().
+
+        \param data record contents
+
+        \param size number of bytes in the record
+
+        \return true if successful, false if the record is too big
+    */
+    bool write(const void* data, size_t size);
+
+    /** Consumer of records in a ShmRing. Holds one of the reader slots in the segment header.
+     */
+    class Reader : public Utils::Uncopyable {
+    public:
+        /** Constructor. Claims a free reader slot, and positions the reader after the last record written.
+
+            \param ring the ring to read from
+        */
+        Reader(const Ref& ring);
+
+        /** Destructor. Releases the reader slot.
+         */
+        ~Reader();
+
+        /** \return true if the reader obtained a slot in the ring
+         */
+        bool isValid() const { return slot_ != 0; }
+
+        /** Obtain the size of the next record, skipping over any that have been overwritten. Follow with
+            read() to fetch the record contents.
+
+            \return size of the next record, or 0 if there are none
+        */
+        size_t peek();
+
+        /** Copy out the record found by the last peek() call, and move to the next one.
+
+            \param buffer storage for at least peek() bytes
+
+            \return true if successful, false if the writer overwrote the record during the copy
+        */
+        bool read(void* buffer);
+
+        /** Wait for the writer to add a record.
+
+            \param msecs maximum number of milliseconds to wait
+
+            \return true if there is a record to read
+        */
+        bool wait(int msecs);
+
+        /** \return number of records written but not yet read
+         */
+        uint64_t getLag() const;
+
+        /** \return number of bytes written but not yet read
+         */
+        uint64_t getLagBytes() const;
+
+        /** \return number of records read
+         */
+        uint64_t getReadCount() const;
+
+        /** \return number of records that were overwritten before they could be read
+         */
+        uint64_t getDropCount() const;
+
+    private:
+        void skipAhead();
+
+        Ref ring_;
+        Slot* slot_;
+        uint64_t position_;
+        uint32_t pending_;
+    };
+
+private:
+    ShmRing(const std::string& name, void* base, size_t mapped, bool owner);
+
+    char* getRecord(uint64_t position) const { return data_ + position % capacity_; }
+
+    std::string name_;
+    Header* header_;
+    char* data_;
+    size_t capacity_;
+    size_t mapped_;
+    bool owner_;
+    uint64_t reserveBegin_;
+    uint64_t reserveEnd_;
+    uint32_t reserveSize_;
+};
+
+} // end namespace IO
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
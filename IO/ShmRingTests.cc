@@ -0,0 +1,275 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "Time/TimeStamp.h"
+#include "UnitTest/UnitTest.h"
+
+#include "ShmRing.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+
+class ShmRingTest : public UnitTest::TestObj {
+public:
+    ShmRingTest() : TestObj("ShmRing") {}
+
+    void test();
+
+    static std::string MakeName(const char* tag);
+
+    /** Fill a record with values derived from its index so that a reader can check it.
+     */
+    static size_t MakeRecord(std::vector<uint32_t>& record, uint32_t index);
+
+    bool checkRecord(const std::vector<uint32_t>& record, size_t size, uint32_t* index);
+
+    void testReaders();
+
+    void testOverrun();
+
+    void testThreads();
+
+    void testDeadReader();
+};
+
+std::string
+ShmRingTest::MakeName(const char* tag)
+{
+    std::ostringstream os;
+    os << "/sidecar.test." << tag << '.' << ::getpid();
+    return os.str();
+}
+
+size_t
+ShmRingTest::MakeRecord(std::vector<uint32_t>& record, uint32_t index)
+{
+    size_t count = 1 + index % 37;
+    record.resize(count);
+    for (size_t offset = 0; offset < count; ++offset) record[offset] = index * 1000 + offset;
+    return count * sizeof(uint32_t);
+}
+
+bool
+ShmRingTest::checkRecord(const std::vector<uint32_t>& record, size_t size, uint32_t* index)
+{
+    *index = record[0] / 1000;
+    if (size != (1 + *index % 37) * sizeof(uint32_t)) return false;
+    for (size_t offset = 0; offset < size / sizeof(uint32_t); ++offset) {
+        if (record[offset] != *index * 1000 + offset) return false;
+    }
+
+    return true;
+}
+
+void
+ShmRingTest::testReaders()
+{
+    ShmRing::Ref ring(ShmRing::Create(MakeName("readers"), 8192));
+    assertTrue(ring.get() != 0);
+    assertEqual(size_t(8192), ring->getCapacity());
+    assertFalse(ring->write(0, ring->getMaxRecordSize() + 1));
+
+    ShmRing::Ref attached(ShmRing::Attach(ring->getName()));
+    assertTrue(attached.get() != 0);
+    assertTrue(!ShmRing::Attach(MakeName("missing")));
+
+    // One reader keeps up with the writer, and the other only reads at the end. The ring wraps around several
+    // times, but is large enough for the slow reader to see everything.
+    //
+    ShmRing::Reader fast(attached);
+    ShmRing::Reader slow(ring);
+    assertTrue(fast.isValid());
+    assertEqual(size_t(2), ring->getReaderCount());
+    assertEqual(size_t(0), fast.peek());
+    assertFalse(fast.wait(10));
+
+    std::vector<uint32_t> record, got(64);
+    uint32_t index = 0;
+    for (int round = 0; round < 50; ++round) {
+        uint32_t first = index;
+        for (int count = 0; count < 5; ++count, ++index) {
+            size_t size = MakeRecord(record, index);
+            assertTrue(ring->write(&record[0], size));
+        }
+
+        assertEqual(uint64_t(index - first), fast.getLag());
+        for (uint32_t expected = first; expected < index; ++expected) {
+            assertTrue(fast.wait(10));
+            size_t size = fast.peek();
+            assertTrue(fast.read(&got[0]));
+            uint32_t found;
+            assertTrue(checkRecord(got, size, &found));
+            assertEqual(expected, found);
+        }
+
+        assertEqual(uint64_t(0), fast.getLag());
+        assertEqual(uint64_t(0), fast.getLagBytes());
+
+        // Drain the slow reader every 10 rounds, which is still within the ring capacity.
+        //
+        if (round % 10 == 9) {
+            assertEqual(uint64_t(50), slow.getLag());
+            for (uint32_t expected = index - 50; expected < index; ++expected) {
+                size_t size = slow.peek();
+                assertTrue(slow.read(&got[0]));
+                uint32_t found;
+                assertTrue(checkRecord(got, size, &found));
+                assertEqual(expected, found);
+            }
+
+            assertEqual(size_t(0), slow.peek());
+        }
+    }
+
+    assertEqual(uint64_t(index), ring->getWriteCount());
+    assertEqual(uint64_t(index), fast.getReadCount());
+    assertEqual(uint64_t(0), fast.getDropCount());
+    assertEqual(uint64_t(0), slow.getDropCount());
+    assertEqual(uint64_t(0), ring->getMaxReaderLag());
+
+    // Readers attached to the writer's process see records written after they attach.
+    //
+    ShmRing::Reader late(attached);
+    assertEqual(size_t(0), late.peek());
+    MakeRecord(record, index);
+    ring->write(&record[0], 4);
+    assertEqual(size_t(4), late.peek());
+}
+
+void
+ShmRingTest::testOverrun()
+{
+    ShmRing::Ref ring(ShmRing::Create(MakeName("overrun"), 1024));
+    ShmRing::Reader reader(ring);
+    std::vector<uint32_t> record, got(64);
+
+    // Write much more than the ring holds. The reader finds some of the newest records, and counts the rest as
+    // dropped.
+    //
+    enum { kCount = 1000 };
+    for (uint32_t index = 0; index < kCount; ++index) {
+        size_t size = MakeRecord(record, index);
+        ring->write(&record[0], size);
+    }
+
+    assertEqual(uint64_t(kCount), reader.getLag());
+    assertEqual(uint64_t(kCount), ring->getMaxReaderLag());
+
+    uint32_t last = 0;
+    while (size_t size = reader.peek()) {
+        assertTrue(reader.read(&got[0]));
+        assertTrue(checkRecord(got, size, &last));
+    }
+
+    assertEqual(uint32_t(kCount - 1), last);
+    assertTrue(reader.getDropCount() > 0);
+    assertEqual(uint64_t(kCount), reader.getReadCount() + reader.getDropCount());
+    assertEqual(uint64_t(0), reader.getLag());
+}
+
+void
+ShmRingTest::testThreads()
+{
+    ShmRing::Ref ring(ShmRing::Create(MakeName("threads"), 64 * 1024));
+    enum { kReaders = 3, kCount = 200000 };
+
+    // Readers wait on the doorbell and check every record they get, until the writer is done and there is
+    // nothing left to read. A reader that falls behind skips ahead to the newest record, so every record must be
+    // read, counted as dropped, or (at the very end) still counted in the reader lag.
+    //
+    std::vector<std::thread> threads;
+    std::vector<int> failures(kReaders, 0);
+    std::vector<uint64_t> reads(kReaders, 0), drops(kReaders, 0), lags(kReaders, 0);
+    std::atomic<bool> done(false);
+    for (int index = 0; index < kReaders; ++index) {
+        threads.emplace_back([&, index]() {
+            ShmRing::Reader reader(ShmRing::Attach(ring->getName()));
+            std::vector<uint32_t> got(64);
+            uint32_t last = 0;
+            bool first = true;
+            while (true) {
+                bool ready = reader.wait(10);
+                while (size_t size = reader.peek()) {
+                    if (!reader.read(&got[0])) continue;
+                    uint32_t found;
+                    if (!checkRecord(got, size, &found) || (!first && found <= last)) ++failures[index];
+                    first = false;
+                    last = found;
+                }
+
+                if (!ready && done) break;
+            }
+
+            reads[index] = reader.getReadCount();
+            drops[index] = reader.getDropCount();
+            lags[index] = reader.getLag();
+        });
+    }
+
+    // Give the readers time to attach.
+    //
+    while (ring->getReaderCount() != kReaders) std::this_thread::yield();
+
+    Time::TimeStamp begin(Time::TimeStamp::Now());
+    std::vector<uint32_t> record;
+    for (uint32_t index = 0; index < kCount; ++index) {
+        size_t size = MakeRecord(record, index);
+        ring->write(&record[0], size);
+    }
+
+    Time::TimeStamp delta(Time::TimeStamp::Now());
+    delta -= begin;
+    done = true;
+
+    for (auto& thread : threads) thread.join();
+    for (int index = 0; index < kReaders; ++index) {
+        assertEqual(0, failures[index]);
+        assertEqual(uint64_t(kCount), reads[index] + drops[index] + lags[index]);
+        std::clog << "reader " << index << " read " << reads[index] << " dropped " << drops[index] << std::endl;
+    }
+
+    std::clog << "wrote " << kCount << " records: " << delta.asDouble() / kCount * 1.0E6 << " usec/record"
+              << std::endl;
+    assertEqual(size_t(0), ring->getReaderCount());
+}
+
+void
+ShmRingTest::testDeadReader()
+{
+    ShmRing::Ref ring(ShmRing::Create(MakeName("dead"), 4096));
+
+    // A child process takes a reader slot and exits without giving it back.
+    //
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        new ShmRing::Reader(ShmRing::Attach(ring->getName()));
+        ::_exit(0);
+    }
+
+    int status;
+    ::waitpid(pid, &status, 0);
+    assertEqual(size_t(1), ring->getReaderCount());
+    assertEqual(size_t(1), ring->releaseDeadReaders());
+    assertEqual(size_t(0), ring->getReaderCount());
+}
+
+void
+ShmRingTest::test()
+{
+    testReaders();
+    testOverrun();
+    testThreads();
+    testDeadReader();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return ShmRingTest().mainRun();
+}
@@ -32,6 +32,7 @@ Stats::resetDropDupeCounts()
 {
     drops_ = 0;
     dupes_ = 0;
+    queueDrops_ = 0;
     lastSequenceNumber_ = 0;
 }
 
@@ -76,6 +76,17 @@ public:
     */
     size_t getDupeCount() const { return dupes_; }
 
+    /** Record a message that the task shed because its input queue was full (see Task::QueuePolicy).
+     */
+    void addQueueDrop() { ++queueDrops_; }
+
+    /** Obtain the total number of messages shed because the input queue was full. Unlike getDropCount(), these
+        are messages that arrived but were never processed.
+
+        \return queue drop count
+    */
+    size_t getQueueDropCount() const { return queueDrops_; }
+
     /** Update the message and byte rates based on the elapsed time since the last update.
      */
     void calculateRates();
@@ -88,6 +99,7 @@ private:
     size_t messageTotal_;
     size_t drops_;
     size_t dupes_;
+    size_t queueDrops_;
     uint32_t lastSequenceNumber_;
     size_t lastMessageTotal_;
     Time::TimeStamp lastRateCalcTime_;
@@ -1,3 +1,5 @@
+#include <ostream>
+
 #include "IO/ProcessingState.h"
 #include "IO/StatusEmitterBase.h"
 #include "IO/StreamStatus.h"
@@ -104,6 +106,29 @@ Stream::getChangedParameters(XmlRpc::XmlRpcValue& value) const
     }
 }
 
+void
+Stream::writeLatencyReport(std::ostream& os) const
+{
+    ACE_Stream_Iterator<ACE_MT_SYNCH> iter(*this);
+
+    // Skip over the stream head.
+    //
+    iter.advance();
+    while (!iter.done()) {
+        const ACE_Module<ACE_MT_SYNCH>* module;
+        iter.next(module);
+        iter.advance();
+
+        // If we were just pointing at the tail, then quit.
+        //
+        if (iter.done()) break;
+
+        Task::Ref task(static_cast<const Module*>(module)->getTask());
+        std::string report(task->getLatencyStats().format());
+        os << getName() << '/' << task->getTaskName() << ": " << (report.empty() ? "no messages" : report) << '\n';
+    }
+}
+
 void
 Stream::emitStatus() const
 {
@@ -1,6 +1,7 @@
 #ifndef SIDECAR_IO_STREAM_H // -*- C++ -*-
 #define SIDECAR_IO_STREAM_H
 
+#include <iosfwd>
 #include <string>
 
 #include "ace/Stream.h"
@@ -66,6 +67,13 @@ public:
     */
     void getChangedParameters(XmlRpc::XmlRpcValue& value) const;
 
+    /** Write the latency statistics of each task in the stream, one line per task, in stream order (see
+        LatencyStats::format()).
+
+        \param os stream to write to
+    */
+    void writeLatencyReport(std::ostream& os) const;
+
     /** Force a status emission for the stream.
      */
     void emitStatus() const;
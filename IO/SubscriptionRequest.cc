@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#include "ace/CDR_Base.h"
+#include "ace/Message_Block.h"
+
+#include "Logger/Log.h"
+#include "Messages/MetaTypeInfo.h"
+#include "Utils/Utils.h"
+
+#include "Decoder.h"
+#include "MessageManager.h"
+#include "SubscriptionRequest.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+
+/** Tolerance in gates when deciding if a sample lies within a range window. Keeps the result stable when the
+    window is applied to a message that has already been trimmed.
+*/
+static const double kGateTolerance = 1.0E-6;
+
+static uint32_t
+GCD(uint32_t a, uint32_t b)
+{
+    while (b) {
+        uint32_t tmp = a % b;
+        a = b;
+        b = tmp;
+    }
+
+    return a;
+}
+
+SubscriptionRequest::SubscriptionRequest() :
+    azimuthMin(0.0), azimuthMax(0.0), rangeMin(0.0), rangeMax(0.0), priDecimation(1), sampleDecimation(1)
+{
+    ;
+}
+
+bool
+SubscriptionRequest::Parse(const std::string& text, SubscriptionRequest& request)
+{
+    SubscriptionRequest tmp;
+    std::istringstream is(text);
+    std::string token;
+    while (is >> token) {
+        std::string::size_type pos = token.find('=');
+        if (pos == std::string::npos) return false;
+        std::string key(token.substr(0, pos));
+        std::istringstream value(token.substr(pos + 1));
+        char comma = 0;
+        if (key == "az") {
+            value >> tmp.azimuthMin >> comma >> tmp.azimuthMax;
+            tmp.azimuthMin = Utils::normalizeRadians(tmp.azimuthMin);
+            tmp.azimuthMax = Utils::normalizeRadians(tmp.azimuthMax);
+        } else if (key == "range") {
+            value >> tmp.rangeMin >> comma >> tmp.rangeMax;
+            if (tmp.rangeMax <= tmp.rangeMin) return false;
+        } else if (key == "pri") {
+            value >> tmp.priDecimation;
+            if (!tmp.priDecimation) return false;
+        } else if (key == "samples") {
+            value >> tmp.sampleDecimation;
+            if (!tmp.sampleDecimation) return false;
+        } else {
+            return false;
+        }
+
+        if (value.fail() || (comma && comma != ',') || value.peek() != EOF) return false;
+    }
+
+    request = tmp;
+    return true;
+}
+
+SubscriptionRequest
+SubscriptionRequest::Covering(const std::vector<SubscriptionRequest>& requests)
+{
+    SubscriptionRequest covering;
+    if (requests.empty()) return covering;
+
+    bool sectors = true;
+    bool windows = true;
+    covering.priDecimation = 0;
+    for (size_t index = 0; index < requests.size(); ++index) {
+        const SubscriptionRequest& request(requests[index]);
+        sectors = sectors && request.hasSector();
+        windows = windows && request.hasRangeWindow();
+        covering.priDecimation = GCD(covering.priDecimation, std::max(request.priDecimation, uint32_t(1)));
+    }
+
+    if (windows) {
+        covering.rangeMin = requests[0].rangeMin;
+        covering.rangeMax = requests[0].rangeMax;
+        for (size_t index = 1; index < requests.size(); ++index) {
+            covering.rangeMin = std::min(covering.rangeMin, requests[index].rangeMin);
+            covering.rangeMax = std::max(covering.rangeMax, requests[index].rangeMax);
+        }
+    }
+
+    // The smallest sector that covers a set of sectors starts where one of them starts. For each start, find
+    // how far clockwise the sector must extend to cover the rest, and keep the smallest one.
+    //
+    if (sectors) {
+        double bestWidth = Utils::kCircleRadians;
+        for (size_t outer = 0; outer < requests.size(); ++outer) {
+            double start = requests[outer].azimuthMin;
+            double width = 0.0;
+            for (size_t inner = 0; inner < requests.size(); ++inner) {
+                const SubscriptionRequest& request(requests[inner]);
+                double offset = inner == outer ? 0.0 : Utils::normalizeRadians(request.azimuthMin - start);
+                width = std::max(width, offset + Utils::normalizeRadians(request.azimuthMax - request.azimuthMin));
+            }
+
+            if (width < bestWidth) {
+                bestWidth = width;
+                covering.azimuthMin = start;
+                covering.azimuthMax = Utils::normalizeRadians(start + width);
+            }
+        }
+
+        if (bestWidth >= Utils::kCircleRadians) covering.azimuthMin = covering.azimuthMax = 0.0;
+    }
+
+    return covering;
+}
+
+std::string
+SubscriptionRequest::format() const
+{
+    std::ostringstream os;
+    os.precision(8);
+    if (hasSector()) os << " az=" << azimuthMin << ',' << azimuthMax;
+    if (hasRangeWindow()) os << " range=" << rangeMin << ',' << rangeMax;
+    if (priDecimation > 1) os << " pri=" << priDecimation;
+    if (sampleDecimation > 1) os << " samples=" << sampleDecimation;
+    std::string text(os.str());
+    return text.empty() ? text : text.substr(1);
+}
+
+bool
+SubscriptionRequest::accepts(const Messages::PRIMessage& msg) const
+{
+    if (priDecimation > 1 && msg.getSequenceCounter() % priDecimation) return false;
+    if (!hasSector()) return true;
+    double offset = Utils::normalizeRadians(msg.getAzimuthStart() - azimuthMin);
+    return offset <= Utils::normalizeRadians(azimuthMax - azimuthMin);
+}
+
+bool
+SubscriptionRequest::getSampleSpan(const Messages::PRIMessage& msg, size_t& first, size_t& count,
+                                   size_t& stride) const
+{
+    size_t size = msg.size();
+    size_t last = size;
+    first = 0;
+    stride = std::max(sampleDecimation, uint32_t(1));
+
+    double factor = msg.getRangeFactor();
+    if (hasRangeWindow() && factor > 0.0) {
+        double low = std::ceil((rangeMin - msg.getRangeMin()) / factor - kGateTolerance);
+        double high = std::floor((rangeMax - msg.getRangeMin()) / factor + kGateTolerance) + 1.0;
+        first = low <= 0.0 ? 0 : std::min(size_t(low), size);
+        last = high <= 0.0 ? 0 : std::min(size_t(high), size);
+        last = std::max(first, last);
+    }
+
+    count = last - first;
+    return first != 0 || count != size || (stride > 1 && count > 1);
+}
+
+bool
+SubscriptionRequest::apply(Messages::PRIMessage& msg) const
+{
+    if (!accepts(msg)) return false;
+    size_t first, count, stride;
+    if (getSampleSpan(msg, first, count, stride)) msg.trimSamples(first, count, stride);
+    return true;
+}
+
+bool
+SubscriptionRequest::operator==(const SubscriptionRequest& rhs) const
+{
+    return azimuthMin == rhs.azimuthMin && azimuthMax == rhs.azimuthMax && rangeMin == rhs.rangeMin &&
+           rangeMax == rhs.rangeMax && priDecimation == rhs.priDecimation && sampleDecimation == rhs.sampleDecimation;
+}
+
+bool
+SubscriptionRequest::operator<(const SubscriptionRequest& rhs) const
+{
+    return std::tie(azimuthMin, azimuthMax, rangeMin, rangeMax, priDecimation, sampleDecimation) <
+           std::tie(rhs.azimuthMin, rhs.azimuthMax, rhs.rangeMin, rhs.rangeMax, rhs.priDecimation,
+                    rhs.sampleDecimation);
+}
+
+Logger::Log&
+SubscriptionReducer::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.IO.SubscriptionReducer");
+    return log_;
+}
+
+SubscriptionReducer::SubscriptionReducer(const MessageManager& mgr) :
+    pri_(boost::dynamic_pointer_cast<Messages::PRIMessage>(mgr.getNative())), full_(mgr.getEncoded()), reduced_()
+{
+    ;
+}
+
+SubscriptionReducer::~SubscriptionReducer()
+{
+    if (full_) full_->release();
+    for (auto pos = reduced_.begin(); pos != reduced_.end(); ++pos) {
+        if (pos->second) pos->second->release();
+    }
+}
+
+ACE_Message_Block*
+SubscriptionReducer::getEncoded(const SubscriptionRequest& request)
+{
+    static Logger::ProcLog log("getEncoded", Log());
+
+    if (!full_) return 0;
+    if (!pri_ || request.isEmpty()) return full_->duplicate();
+    if (!request.accepts(*pri_)) return 0;
+
+    size_t first, count, stride;
+    if (!request.getSampleSpan(*pri_, first, count, stride)) return full_->duplicate();
+
+    SampleSpan span(first, count, stride);
+    ReducedMap::iterator pos = reduced_.find(span);
+    if (pos == reduced_.end()) {
+        // The native message is shared, so trim a copy of it. The Decoder needs one contiguous block.
+        //
+        ACE_Message_Block* flat = MessageManager::MakeMessageBlock(full_->total_length() + ACE_CDR::MAX_ALIGNMENT);
+        ACE_CDR::mb_align(flat);
+        for (ACE_Message_Block* block = full_; block; block = block->cont()) {
+            ::memcpy(flat->wr_ptr(), block->rd_ptr(), block->length());
+            flat->wr_ptr(block->length());
+        }
+
+        Decoder decoder(flat);
+        Messages::PRIMessage::Ref copy(
+            boost::dynamic_pointer_cast<Messages::PRIMessage>(pri_->getMetaTypeInfo().getCDRLoader()(decoder)));
+        ACE_Message_Block* encoded = 0;
+        if (copy) {
+            copy->trimSamples(first, count, stride);
+            encoded = MessageManager(copy).getEncoded();
+        } else {
+            LOGERROR << "failed to copy message " << pri_->getMetaTypeInfo().getName() << std::endl;
+        }
+
+        pos = reduced_.insert(ReducedMap::value_type(span, encoded)).first;
+    }
+
+    return pos->second ? pos->second->duplicate() : 0;
+}
+
+ACE_Message_Block*
+SubscriptionReducer::ReduceReceived(const SubscriptionRequest& request, ACE_Message_Block* data,
+                                    const Messages::MetaTypeInfo* metaTypeInfo)
+{
+    if (request.isEmpty()) return data;
+
+    MessageManager mgr(data, metaTypeInfo);
+    Messages::PRIMessage::Ref pri(boost::dynamic_pointer_cast<Messages::PRIMessage>(mgr.getNative()));
+    if (!pri) return mgr.getMessage();
+    if (!request.accepts(*pri)) return 0;
+
+    size_t first, count, stride;
+    if (!request.getSampleSpan(*pri, first, count, stride)) return mgr.getMessage();
+
+    // The message was just decoded, so no one else has it yet. Trim it in place, and give it a new manager
+    // without the now stale encoding of the received data.
+    //
+    pri->trimSamples(first, count, stride);
+    return MessageManager(mgr.getNative()).getMessage();
+}
@@ -0,0 +1,187 @@
+#ifndef SIDECAR_IO_SUBSCRIPTIONREQUEST_H // -*- C++ -*-
+#define SIDECAR_IO_SUBSCRIPTIONREQUEST_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Messages/PRIMessage.h"
+
+class ACE_Message_Block;
+
+namespace Logger {
+class Log;
+}
+
+namespace SideCar {
+namespace Messages {
+class MetaTypeInfo;
+}
+namespace IO {
+
+class MessageManager;
+
+/** Description of the PRI data a subscriber wants from a publisher. Display clients often only show an azimuth
+    sector or a range window, or they draw fewer PRIs or samples than the radar produces. Sending them just what
+    they need saves the network, and the work of decoding data that would only be thrown away. A request has
+    four parts, all optional:
+
+    - an azimuth sector, from azimuthMin clockwise to azimuthMax (radians). PRIs that start outside of the
+      sector are dropped.
+    - a range window, from rangeMin to rangeMax (kilometers). Samples outside of the window are dropped.
+    - a PRI decimation factor N. Only PRIs whose sequence counter is a multiple of N are kept.
+    - a sample decimation factor N. Only every Nth sample of the range window is kept.
+
+    Non-PRI messages are never reduced. The text form of a request, as sent by subscribers, is a list of
+    key=value pairs, such as "az=5.5,0.8 range=10,60 pri=2 samples=4".
+
+    The first three parts select the same data no matter how often they are applied, so a subscriber may
+    apply them to what it receives, even if the publisher already did. The sample decimation must only be
+    applied once, which is why covering requests never have it.
+*/
+struct SubscriptionRequest {
+    /** Constructor. The request is for everything.
+     */
+    SubscriptionRequest();
+
+    /** Obtain a request from its text form.
+
+        \param text the text to parse
+
+        \param request storage for the result
+
+        \return true if the text is valid
+    */
+    static bool Parse(const std::string& text, SubscriptionRequest& request);
+
+    /** Obtain the smallest request that covers everything in a set of requests. Used to reduce a stream that
+        goes to more than one subscriber. The result has no sample decimation.
+
+        \param requests the requests to cover
+
+        \return covering request
+    */
+    static SubscriptionRequest Covering(const std::vector<SubscriptionRequest>& requests);
+
+    /** \return text form of the request, empty if the request is for everything
+     */
+    std::string format() const;
+
+    /** \return true if the request is for everything
+     */
+    bool isEmpty() const { return !hasSector() && !hasRangeWindow() && priDecimation < 2 && sampleDecimation < 2; }
+
+    /** \return true if the request limits the azimuth
+     */
+    bool hasSector() const { return azimuthMin != azimuthMax; }
+
+    /** \return true if the request limits the range
+     */
+    bool hasRangeWindow() const { return rangeMax > rangeMin; }
+
+    /** Determine if a PRI message is wanted.
+
+        \param msg the message to check
+
+        \return true if wanted
+    */
+    bool accepts(const Messages::PRIMessage& msg) const;
+
+    /** Determine the samples of a PRI message that are wanted.
+
+        \param msg the message to check
+
+        \param first index of the first wanted sample
+
+        \param count number of samples from first that span all of the wanted samples
+
+        \param stride distance between wanted samples
+
+        \return true if there are samples that are not wanted
+    */
+    bool getSampleSpan(const Messages::PRIMessage& msg, size_t& first, size_t& count, size_t& stride) const;
+
+    /** Apply the request to a PRI message.
+
+        \param msg the message to change
+
+        \return false if the message is not wanted at all
+    */
+    bool apply(Messages::PRIMessage& msg) const;
+
+    bool operator==(const SubscriptionRequest& rhs) const;
+
+    bool operator!=(const SubscriptionRequest& rhs) const { return !operator==(rhs); }
+
+    bool operator<(const SubscriptionRequest& rhs) const;
+
+    double azimuthMin;         ///< Start of the azimuth sector in radians
+    double azimuthMax;         ///< End of the azimuth sector in radians
+    double rangeMin;           ///< Start of the range window in kilometers
+    double rangeMax;           ///< End of the range window in kilometers
+    uint32_t priDecimation;    ///< Keep every Nth PRI
+    uint32_t sampleDecimation; ///< Keep every Nth sample
+};
+
+/** Publisher-side reduction of one message for many subscribers. Encodes each distinct reduction of the message
+    once, so subscribers with identical requests (or just ones that keep the same samples) share the same
+    encoded data. Subscribers whose request does not change the samples share the original encoding.
+*/
+class SubscriptionReducer {
+public:
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Constructor.
+
+        \param mgr the message to reduce. Must hold a native message.
+    */
+    SubscriptionReducer(const MessageManager& mgr);
+
+    /** Destructor. Releases the encoded data held by the reducer.
+     */
+    ~SubscriptionReducer();
+
+    /** Obtain the encoded message for a subscriber.
+
+        \param request what the subscriber wants
+
+        \return encoded message (caller takes ownership) or NULL if the subscriber does not want the message
+    */
+    ACE_Message_Block* getEncoded(const SubscriptionRequest& request);
+
+    /** Apply a request to a message received from a publisher. For subscribers of streams that the publisher
+        can only reduce with a covering request (see SubscriptionRequest::Covering()), such as multicast.
+
+        \param request what the subscriber wants
+
+        \param data the received message. Takes ownership.
+
+        \param metaTypeInfo type of the message
+
+        \return message to use (caller takes ownership), or NULL if not wanted
+    */
+    static ACE_Message_Block* ReduceReceived(const SubscriptionRequest& request, ACE_Message_Block* data,
+                                             const Messages::MetaTypeInfo* metaTypeInfo);
+
+private:
+    using SampleSpan = std::tuple<size_t, size_t, size_t>;
+    using ReducedMap = std::map<SampleSpan, ACE_Message_Block*>;
+
+    Messages::PRIMessage::Ref pri_;
+    ACE_Message_Block* full_;
+    ReducedMap reduced_; ///< Encodings of the message for each distinct set of samples
+};
+
+} // end namespace IO
+} // end namespace SideCar
+
+/** \file
+ */
+
+#endif
@@ -0,0 +1,249 @@
+#include <cmath>
+#include <stdexcept>
+
+#include "ace/Message_Block.h"
+
+#include "Messages/Video.h"
+#include "UnitTest/UnitTest.h"
+
+#include "MessageManager.h"
+#include "SubscriptionRequest.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+using namespace SideCar::Messages;
+
+class SubscriptionRequestTest : public UnitTest::TestObj {
+public:
+    SubscriptionRequestTest() : TestObj("SubscriptionRequest") {}
+
+    void test();
+
+    /** Make a PRI with 100 samples whose values are their gate index, 0.5 km apart starting at 10 km.
+     */
+    static Video::Ref MakeVideo(uint32_t sequence, double azimuth);
+
+    static SubscriptionRequest MakeRequest(const std::string& text);
+
+    /** Copy an encoded message into one block, as a reader would deliver it.
+     */
+    static ACE_Message_Block* Flatten(const ACE_Message_Block* encoded);
+
+    void testText();
+
+    void testAccepts();
+
+    void testApply();
+
+    void testCovering();
+
+    void testReducer();
+};
+
+Video::Ref
+SubscriptionRequestTest::MakeVideo(uint32_t sequence, double azimuth)
+{
+    VMEDataMessage vme;
+    vme.header.msgDesc = (VMEHeader::kPackedReal << 16) | VMEHeader::kAzimuthValidMask | VMEHeader::kPRIValidMask;
+    vme.header.timeStamp = 0;
+    vme.header.azimuth = uint32_t(::rint(azimuth / (M_PI * 2.0) * (RadarConfig::GetShaftEncodingMax() + 1)));
+    vme.header.pri = sequence;
+    vme.header.irigTime = 0.0;
+
+    Video::Ref msg(Video::Make("test", vme, 100));
+    msg->getRIUInfo().rangeMin = 10.0;
+    msg->getRIUInfo().rangeFactor = 0.5;
+    for (int index = 0; index < 100; ++index) msg->push_back(index);
+    return msg;
+}
+
+SubscriptionRequest
+SubscriptionRequestTest::MakeRequest(const std::string& text)
+{
+    SubscriptionRequest request;
+    if (!SubscriptionRequest::Parse(text, request)) throw std::runtime_error("invalid request " + text);
+    return request;
+}
+
+ACE_Message_Block*
+SubscriptionRequestTest::Flatten(const ACE_Message_Block* encoded)
+{
+    ACE_Message_Block* data = MessageManager::MakeMessageBlock(encoded->total_length());
+    for (const ACE_Message_Block* block = encoded; block; block = block->cont()) {
+        data->copy(block->rd_ptr(), block->length());
+    }
+
+    return data;
+}
+
+void
+SubscriptionRequestTest::testText()
+{
+    SubscriptionRequest request;
+    assertTrue(request.isEmpty());
+    assertEqual(std::string(""), request.format());
+
+    request = MakeRequest("az=5.5,0.75 range=12,30.5 pri=2 samples=4");
+    assertFalse(request.isEmpty());
+    assertEqual(5.5, request.azimuthMin);
+    assertEqual(0.75, request.azimuthMax);
+    assertEqual(12.0, request.rangeMin);
+    assertEqual(30.5, request.rangeMax);
+    assertEqual(uint32_t(2), request.priDecimation);
+    assertEqual(uint32_t(4), request.sampleDecimation);
+    assertEqual(std::string("az=5.5,0.75 range=12,30.5 pri=2 samples=4"), request.format());
+    assertTrue(MakeRequest(request.format()) == request);
+
+    assertTrue(MakeRequest("samples=3") < request);
+    assertTrue(MakeRequest("") == SubscriptionRequest());
+
+    SubscriptionRequest bad;
+    assertFalse(SubscriptionRequest::Parse("az=1", bad));
+    assertFalse(SubscriptionRequest::Parse("range=30,12", bad));
+    assertFalse(SubscriptionRequest::Parse("pri=0", bad));
+    assertFalse(SubscriptionRequest::Parse("pri=2x", bad));
+    assertFalse(SubscriptionRequest::Parse("gates=1,2", bad));
+    assertFalse(SubscriptionRequest::Parse("samples", bad));
+}
+
+void
+SubscriptionRequestTest::testAccepts()
+{
+    // A sector that wraps through north.
+    //
+    SubscriptionRequest request(MakeRequest("az=6,0.5"));
+    assertTrue(request.accepts(*MakeVideo(1, 6.1)));
+    assertTrue(request.accepts(*MakeVideo(1, 0.0)));
+    assertTrue(request.accepts(*MakeVideo(1, 0.4)));
+    assertFalse(request.accepts(*MakeVideo(1, 0.6)));
+    assertFalse(request.accepts(*MakeVideo(1, 5.9)));
+
+    request = MakeRequest("pri=3");
+    assertTrue(request.accepts(*MakeVideo(9, 1.0)));
+    assertFalse(request.accepts(*MakeVideo(10, 1.0)));
+}
+
+void
+SubscriptionRequestTest::testApply()
+{
+    // Samples 4 through 20 cover 12 km to 20 km. Every 4th one starting at sample 4.
+    //
+    SubscriptionRequest request(MakeRequest("range=12,20 samples=4"));
+    Video::Ref msg(MakeVideo(1, 1.0));
+    assertTrue(request.apply(*msg));
+    assertEqual(size_t(5), msg->size());
+    assertEqual(int16_t(4), msg[0]);
+    assertEqual(int16_t(8), msg[1]);
+    assertEqual(int16_t(20), msg[4]);
+    assertEqual(12.0, msg->getRangeMin());
+    assertEqual(2.0, msg->getRangeFactor());
+    assertEqual(16.0, msg->getRangeAt(2));
+
+    // The range window does not change what is left.
+    //
+    request = MakeRequest("range=12,20");
+    size_t first, count, stride;
+    assertFalse(request.getSampleSpan(*msg, first, count, stride));
+
+    // A window outside of the samples leaves none. A window larger than the samples leaves all of them.
+    //
+    msg = MakeVideo(1, 1.0);
+    assertTrue(MakeRequest("range=100,200").apply(*msg));
+    assertEqual(size_t(0), msg->size());
+    msg = MakeVideo(1, 1.0);
+    assertTrue(MakeRequest("range=1,200").apply(*msg));
+    assertEqual(size_t(100), msg->size());
+
+    msg = MakeVideo(2, 1.0);
+    assertFalse(MakeRequest("pri=4").apply(*msg));
+}
+
+void
+SubscriptionRequestTest::testCovering()
+{
+    std::vector<SubscriptionRequest> requests;
+    assertTrue(SubscriptionRequest::Covering(requests).isEmpty());
+
+    requests.push_back(MakeRequest("az=6,0.5 range=20,30 pri=4 samples=2"));
+    requests.push_back(MakeRequest("az=0.25,1 range=10,25 pri=6"));
+    SubscriptionRequest covering(SubscriptionRequest::Covering(requests));
+    assertEqual(6.0, covering.azimuthMin);
+    assertEqualEpsilon(1.0, covering.azimuthMax, 1.0E-9);
+    assertEqual(10.0, covering.rangeMin);
+    assertEqual(30.0, covering.rangeMax);
+    assertEqual(uint32_t(2), covering.priDecimation);
+    assertEqual(uint32_t(1), covering.sampleDecimation);
+
+    // Sectors on opposite sides are covered by the shorter way around.
+    //
+    requests.push_back(MakeRequest("az=3,3.5"));
+    covering = SubscriptionRequest::Covering(requests);
+    assertEqual(6.0, covering.azimuthMin);
+    assertEqualEpsilon(3.5, covering.azimuthMax, 1.0E-9);
+    assertFalse(covering.hasRangeWindow());
+
+    // Anyone that wants everything gets it.
+    //
+    requests.push_back(SubscriptionRequest());
+    assertTrue(SubscriptionRequest::Covering(requests).isEmpty());
+}
+
+void
+SubscriptionRequestTest::testReducer()
+{
+    MessageManager mgr(MakeVideo(4, 1.0));
+    SubscriptionReducer reducer(mgr);
+
+    // Requests that keep all of the samples share the original encoding.
+    //
+    ACE_Message_Block* full = reducer.getEncoded(SubscriptionRequest());
+    ACE_Message_Block* same = reducer.getEncoded(MakeRequest("az=0.5,1.5 pri=2"));
+    assertTrue(full->cont()->data_block() == same->cont()->data_block());
+    assertTrue(reducer.getEncoded(MakeRequest("pri=3")) == 0);
+
+    // Requests that keep the same samples share one reduced encoding.
+    //
+    ACE_Message_Block* reduced = reducer.getEncoded(MakeRequest("range=12,20 samples=4"));
+    ACE_Message_Block* shared = reducer.getEncoded(MakeRequest("az=0.5,1.5 range=12,20 samples=4"));
+    assertTrue(reduced->cont()->data_block() == shared->cont()->data_block());
+    assertTrue(reduced->total_length() < full->total_length());
+
+    // The reduced encoding decodes to the reduced message.
+    //
+    MessageManager decoded(Flatten(reduced), &Video::GetMetaTypeInfo());
+    Video::Ref msg(decoded.getNative<Video>());
+    assertEqual(size_t(5), msg->size());
+    assertEqual(int16_t(8), msg[1]);
+    assertEqual(2.0, msg->getRangeFactor());
+
+    // Reduction on the subscriber side.
+    //
+    ACE_Message_Block* data =
+        SubscriptionReducer::ReduceReceived(MakeRequest("range=30,35"), Flatten(full), &Video::GetMetaTypeInfo());
+    assertTrue(data != 0);
+    MessageManager local(data);
+    msg = local.getNative<Video>();
+    assertEqual(size_t(11), msg->size());
+    assertEqual(int16_t(40), msg[0]);
+
+    full->release();
+    same->release();
+    reduced->release();
+    shared->release();
+}
+
+void
+SubscriptionRequestTest::test()
+{
+    testText();
+    testAccepts();
+    testApply();
+    testCovering();
+    testReducer();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return SubscriptionRequestTest().mainRun();
+}
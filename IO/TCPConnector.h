@@ -1,6 +1,8 @@
 #ifndef SIDECAR_IO_TCPCONNECTOR_H // -*- C++ -*-
 #define SIDECAR_IO_TCPCONNECTOR_H
 
+#include <string>
+
 #include "ace/Connector.h"
 #include "ace/SOCK_Connector.h"
 
@@ -30,7 +32,7 @@ public:
     */
     TCPConnector(IOTask* task, int maxSocketBufferSize = 0) :
         Super(task->reactor()), task_(task), remoteAddress_(), inputHandler_(task),
-        maxSocketBufferSize_(maxSocketBufferSize), timer_(-1)
+        maxSocketBufferSize_(maxSocketBufferSize), timer_(-1), subscriptionRequest_()
     {
     }
 
@@ -46,6 +48,14 @@ public:
 
     int getMaxSocketBufferSize() const { return maxSocketBufferSize_; }
 
+    /** Set the data reduction to ask the publisher for when a connection is made. See SubscriptionRequest.
+
+        \param text request in text form. If empty, no request is sent.
+    */
+    void setSubscriptionRequest(const std::string& text) { subscriptionRequest_ = text; }
+
+    const std::string& getSubscriptionRequest() const { return subscriptionRequest_; }
+
     /** Shut down the output handler. Override of ACE_Connector method.
 
         \return 0 if successful, -1 otherwise
@@ -77,6 +87,7 @@ private:
     TCPInputHandler inputHandler_;
     int maxSocketBufferSize_;
     long timer_;
+    std::string subscriptionRequest_;
 };
 
 } // end namespace IO
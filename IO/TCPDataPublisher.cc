@@ -1,3 +1,5 @@
+#include <sstream>
+
 #include "boost/bind/bind.hpp"
 #include "Logger/Log.h"
 
@@ -69,7 +71,7 @@ TCPDataPublisher::openAndInit(const std::string& key, const std::string& service
     }
 
     std::ostringstream os;
-    os << "Port: " << port;
+    describeConnections(os);
     setConnectionInfo(os.str());
 
     return true;
@@ -98,6 +100,38 @@ TCPDataPublisher::getConnectionCount() const
     return writer_->getConnectionCount();
 }
 
+void
+TCPDataPublisher::setOverflowPolicy(const ServerSocketWriterTask::OverflowPolicy& policy)
+{
+    writer_->setOverflowPolicy(policy);
+}
+
+void
+TCPDataPublisher::fillStatus(StatusBase& status)
+{
+    if (writer_->isListening()) {
+        std::ostringstream os;
+        describeConnections(os);
+        setConnectionInfo(os.str());
+    }
+
+    Super::fillStatus(status);
+}
+
+void
+TCPDataPublisher::describeConnections(std::ostream& os) const
+{
+    os << "Port: " << getPort();
+
+    ServerSocketWriterTask::ClientStatsVector clients;
+    writer_->getClientStats(clients);
+    for (size_t index = 0; index < clients.size(); ++index) {
+        const ServerSocketWriterTask::ClientStats& client(clients[index]);
+        os << ' ' << client.peer << " Q: " << client.queued << '/' << client.maxQueued;
+        if (client.dropped) os << " Drop: " << client.dropped;
+    }
+}
+
 void
 TCPDataPublisher::connectionCountChanged(size_t count)
 {
@@ -1,8 +1,11 @@
 #ifndef SIDECAR_IO_TCPDATAPUBLISHER_H // -*- C++ -*-
 #define SIDECAR_IO_TCPDATAPUBLISHER_H
 
+#include <iosfwd>
+
 #include "IO/DataPublisher.h"
 #include "IO/Module.h"
+#include "IO/ServerSocketWriterTask.h"
 #include "IO/ZeroconfRegistry.h"
 
 namespace Logger {
@@ -15,8 +18,6 @@ class Publisher;
 }
 namespace IO {
 
-class ServerSocketWriterTask;
-
 /** Publisher of data using TCP transport. Relies on a ServerSocketWriterTask to do the heady lifing.
  */
 class TCPDataPublisher : public DataPublisher, public ZeroconfTypes::Publisher {
@@ -59,6 +60,20 @@ public:
 
     size_t getConnectionCount() const;
 
+    /** Set what to do with messages for a subscriber that cannot keep up. Applies to subscribers that connect
+        after the call.
+
+        \param policy new policy
+    */
+    void setOverflowPolicy(const ServerSocketWriterTask::OverflowPolicy& policy);
+
+    /** Override of Task method. Updates the connection info with the state of each subscriber before
+        reporting.
+
+        \param status status object to fill in
+    */
+    void fillStatus(StatusBase& status);
+
 protected:
     /** Constructor.
      */
@@ -68,9 +83,17 @@ protected:
 
     void setServiceName(const std::string& serviceName);
 
-private:
     bool calculateUsingDataValue() const;
 
+    /** Write a summary of the connections for the connection info status value. Each subscriber shows its
+        address, the number of messages in its queue and the most there has ever been, and the number of
+        messages dropped for it.
+
+        \param os stream to write to
+    */
+    virtual void describeConnections(std::ostream& os) const;
+
+private:
     void connectionCountChanged(size_t value);
 
     using ServerSocketWriterTaskRef = boost::shared_ptr<ServerSocketWriterTask>;
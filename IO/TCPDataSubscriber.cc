@@ -20,7 +20,7 @@ TCPDataSubscriber::Make()
     return ref;
 }
 
-TCPDataSubscriber::TCPDataSubscriber() : Super(), connector_(0)
+TCPDataSubscriber::TCPDataSubscriber() : Super(), connector_(0), request_()
 {
     static Logger::ProcLog log("TCPDataSubscriber", Log());
     LOGINFO << std::endl;
@@ -38,6 +38,7 @@ TCPDataSubscriber::openAndInit(const std::string& key, const std::string& servic
     setError("Not connected to publisher");
 
     connector_ = new TCPConnector(this, bufferSize);
+    connector_->setSubscriptionRequest(request_.format());
     LOGDEBUG << "connector: " << connector_ << std::endl;
 
     return Super::openAndInit(key, serviceName, MakeTwinZeroconfType(key), interface);
@@ -57,6 +58,15 @@ TCPDataSubscriber::close(u_long flags)
     return Super::close(flags);
 }
 
+void
+TCPDataSubscriber::setSubscriptionRequest(const SubscriptionRequest& request)
+{
+    static Logger::ProcLog log("setSubscriptionRequest", Log());
+    LOGINFO << getTaskName() << ' ' << request.format() << std::endl;
+    request_ = request;
+    if (connector_) connector_->setSubscriptionRequest(request_.format());
+}
+
 void
 TCPDataSubscriber::setServiceName(const std::string& serviceName)
 {
@@ -90,6 +100,7 @@ TCPDataSubscriber::resolvedService(const Zeroconf::ServiceEntry::Ref& serviceEnt
     std::ostringstream os;
     os << "Host: " << host << " Port: " << resolved.getPort() << " Interface: " << serviceEntry->getInterfaceName();
     if (connector_->getMaxSocketBufferSize()) os << " Buffer Size: " << connector_->getMaxSocketBufferSize();
+    if (!request_.isEmpty()) os << " Request: " << request_.format();
     setConnectionInfo(os.str());
 }
 
@@ -3,6 +3,7 @@
 
 #include "IO/DataSubscriber.h"
 #include "IO/Module.h"
+#include "IO/SubscriptionRequest.h"
 #include "IO/ZeroconfRegistry.h"
 
 namespace Logger {
@@ -46,6 +47,14 @@ public:
 
     int close(u_long flags = 0);
 
+    /** Ask the publisher for less than all of its data. Takes effect on the next connection to the publisher.
+
+        \param request the data to ask for
+    */
+    void setSubscriptionRequest(const SubscriptionRequest& request);
+
+    const SubscriptionRequest& getSubscriptionRequest() const { return request_; }
+
 protected:
     /** Constructor. Does nothing -- like most ACE classes, all initialization is done in the init and open
         methods.
@@ -54,12 +63,13 @@ protected:
 
     void setServiceName(const std::string& serviceName);
 
-private:
     void resolvedService(const Zeroconf::ServiceEntry::Ref& service);
 
     void lostService();
 
+private:
     TCPConnector* connector_;
+    SubscriptionRequest request_;
 };
 
 using TCPDataSubscriberModule = TModule<TCPDataSubscriber>;
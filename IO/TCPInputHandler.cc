@@ -43,6 +43,17 @@ TCPInputHandler::open(void* arg)
         return -1;
     }
 
+    // Ask the publisher for just the data we want.
+    //
+    if (!connector_->getSubscriptionRequest().empty()) {
+        std::string line("SUB ");
+        line += connector_->getSubscriptionRequest();
+        line += '\n';
+        if (peer().send_n(line.data(), line.size()) != ssize_t(line.size())) {
+            LOGERROR << "failed to send subscription request - " << Utils::showErrno() << std::endl;
+        }
+    }
+
     LOGDEBUG << "EXIT" << std::endl;
     return 0;
 }
@@ -1,3 +1,6 @@
+#include <pthread.h>
+
+#include <chrono>
 #include <sstream>
 #include <typeinfo>
 
@@ -5,6 +8,7 @@
 
 #include "ace/Guard_T.h"
 #include "ace/Message_Queue_T.h"
+#include "ace/OS_NS_sys_time.h"
 #include "ace/Reactor.h"
 
 #include "Logger/Log.h"
@@ -22,6 +26,49 @@ using namespace SideCar;
 using namespace SideCar::IO;
 using namespace SideCar::Messages;
 
+/** Default byte limit for the input queue of a task.
+ */
+static const size_t kQueueSize = 10 * 1024 * 1024; // 10M
+
+namespace {
+
+/** Message block that also holds the time it was delivered to a task, for latency tracing. It shares the data
+    block and continuation of the message it copies, so it looks like any other data message to the rest of the
+    task, and it carries the delivery time through the input queue without any shared bookkeeping.
+*/
+struct DeliveredBlock : public ACE_Message_Block {
+    DeliveredBlock(const ACE_Message_Block* data, int64_t when) :
+        ACE_Message_Block(data->data_block()->duplicate()), delivered(when)
+    {
+        rd_ptr(data->rd_ptr());
+        wr_ptr(data->wr_ptr());
+        msg_priority(data->msg_priority());
+        if (data->cont()) cont(data->cont()->duplicate());
+    }
+
+    int64_t delivered; ///< When the message was given to Task::put() (see LatencyStats::Now())
+};
+
+} // namespace
+
+bool
+Task::QueuePolicy::GetAction(const std::string& name, Action& action)
+{
+    if (name == "block") {
+        action = kBlock;
+    } else if (name == "dropOldest") {
+        action = kDropOldest;
+    } else if (name == "dropNewest") {
+        action = kDropNewest;
+    } else if (name == "keepNth") {
+        action = kKeepNth;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
 const char* const*
 Task::ProcessingStateEnumTraits::GetEnumNames()
 {
@@ -43,7 +90,8 @@ Task::Task(bool usingData) :
     editingEnabled_(Parameter::BoolValue::Make("editingEnabled", "Editing Enabled", true)), connectionInfo_(""),
     processingState_(ProcessingState::kInvalid), lastProcessingState_(ProcessingState::kInvalid),
     alwaysUsingData_(Parameter::BoolValue::Make("alwaysUsingData", "Always Using Data", false)), threadParams_(),
-    usingData_(usingData)
+    queuePolicy_(), overflowCount_(0), queueMutex_(), queueSpace_(), latencyStats_(),
+    latencyTracedOnProcess_(false), metricsSegment_(), metrics_(0), usingData_(usingData)
 {
     static Logger::ProcLog log("Task", Log());
     LOGINFO << this << std::endl;
@@ -76,7 +124,6 @@ Task::Task(bool usingData) :
     //
     ACE_Message_Queue<ACE_MT_SYNCH>* queue = msg_queue();
     if (queue) {
-        static const int kQueueSize = 10 * 1024 * 1024; // 10M
         queue->high_water_mark(kQueueSize);
         queue->low_water_mark(kQueueSize - 1);
     }
@@ -290,6 +337,7 @@ Task::enterProcessingState(ProcessingState::Value goalState)
     }
 
     LOGDEBUG << "new state: " << ProcessingState::GetName(processingState_) << std::endl;
+    if (metrics_) metrics_->processingState.store(processingState_, std::memory_order_relaxed);
 
     updateUsingDataValue();
 
@@ -416,15 +464,35 @@ Task::put(ACE_Message_Block* data, ACE_Time_Value* timeout)
         Header::Ref msg = mgr.getNative();
         updateInputStats(channelIndex, msg->getSize(), msg->getMessageSequenceNumber());
 
+        // Fetch the trace origin now, since the task may forward the message and so alter its header. A task that
+        // queues its input gets a copy of the message block that holds the delivery time for processMessage().
+        //
+        bool traced = LatencyStats::IsEnabled();
+        int64_t origin = traced ? msg->getTraceOrigin() : 0;
+        int64_t start = (traced || (metrics_ && !latencyTracedOnProcess_)) ? LatencyStats::Now() : 0;
+        ACE_Message_Block* delivered = data;
+        if (traced && latencyTracedOnProcess_) delivered = new DeliveredBlock(data, start);
+
         // Attempt to deliver the message to the task. For threaded tasks, this will insert the message into a
         // work queue for the thread to process.
         //
-        if (!deliverDataMessage(data, timeout)) {
+        if (!deliverDataMessage(delivered, timeout)) {
+            if (delivered != data) delivered->release();
             LOGWARNING << "failed deliverDataMessage()" << std::endl;
             setError("Failed to deliver message to task");
             return -1;
         }
 
+        if (delivered != data) data->release();
+
+        if (start && !latencyTracedOnProcess_) {
+            // The message did not wait in a queue, so its delivery time is the start time.
+            //
+            int64_t end = LatencyStats::Now();
+            if (traced) latencyStats_.record(origin, start, start, end);
+            if (metrics_) metrics_->addProcessingTime(end - start);
+        }
+
         data = 0;
     } else {
         LOGERROR << "unknown messsage type - " << data->msg_type() << std::endl;
@@ -435,6 +503,21 @@ Task::put(ACE_Message_Block* data, ACE_Time_Value* timeout)
     return 0;
 }
 
+bool
+Task::injectControlMessage(const ControlMessage& msg)
+{
+    // NOTE: we own data unless deliverControlMessage() accepts it.
+    //
+    ACE_Message_Block* data = msg.getWrapped();
+    if (!deliverControlMessage(data, 0)) {
+        data->release();
+        setError("Failed to deliver control message");
+        return false;
+    }
+
+    return true;
+}
+
 bool
 Task::deliverControlMessage(ACE_Message_Block* data, ACE_Time_Value* timeout)
 {
@@ -456,7 +539,27 @@ Task::processMessage(ACE_Message_Block* data)
 
     bool ok = false;
     if (type == MessageManager::kMetaData) {
-        ok = processDataMessage(data);
+        bool traced = latencyTracedOnProcess_ && LatencyStats::IsEnabled();
+        if (traced || (metrics_ && latencyTracedOnProcess_)) {
+            // Fetch the trace origin before processing, since the task may forward the message and so alter its
+            // header.
+            //
+            int64_t origin = 0;
+            int64_t delivered = 0;
+            if (traced) {
+                origin = MessageManager(data->duplicate()).getNative()->getTraceOrigin();
+                const DeliveredBlock* block = dynamic_cast<const DeliveredBlock*>(data);
+                if (block) delivered = block->delivered;
+            }
+
+            int64_t start = LatencyStats::Now();
+            ok = processDataMessage(data);
+            int64_t end = LatencyStats::Now();
+            if (traced) latencyStats_.record(origin, delivered, start, end);
+            if (metrics_) metrics_->addProcessingTime(end - start);
+        } else {
+            ok = processDataMessage(data);
+        }
     } else if (MessageManager::IsControlMessage(data)) {
         ok = processControlMessage(data);
     } else {
@@ -609,6 +712,8 @@ Task::doClearStatsRequest()
     static Logger::ProcLog log("doClearStatsRequest", Log());
     LOGINFO << taskName_ << std::endl;
     resetProcessedStats();
+    latencyStats_.reset();
+    if (metrics_) metrics_->reset();
     return true;
 }
 
@@ -628,6 +733,13 @@ Task::sendManaged(MessageManager& manager, size_t channelIndex)
     //
     if (!next()) return true;
 
+    // Stamp the message for latency tracing. A message without an origin is entering the process here.
+    //
+    if (LatencyStats::IsEnabled() && manager.hasNative()) {
+        const Header::Ref& msg(manager.getNative());
+        if (!msg->getTraceOrigin()) msg->setTraceOrigin(LatencyStats::Now());
+    }
+
     // If the channel is a valid index, then have its recipient list handle delivery.
     //
     if (channelIndex < outputs_.size()) {
@@ -677,6 +789,7 @@ Task::fillStatus(StatusBase& status)
     size_t messageRate = 0;
     size_t dropCount = 0;
     size_t dupeCount = 0;
+    size_t queueDropCount = 0;
     size_t inputCount = inputStats_.size();
     for (size_t index = 0; index < inputCount; ++index) {
         Stats& s(inputStats_[index]);
@@ -686,6 +799,7 @@ Task::fillStatus(StatusBase& status)
         messageRate += s.getMessageRate();
         dropCount += s.getDropCount();
         dupeCount += s.getDupeCount();
+        queueDropCount += s.getQueueDropCount();
     }
 
     status.setSlot(TaskStatus::kMessageCount, int(messageCount / inputCount));
@@ -693,6 +807,8 @@ Task::fillStatus(StatusBase& status)
     status.setSlot(TaskStatus::kMessageRate, int(messageRate / inputCount));
     status.setSlot(TaskStatus::kDropCount, int(dropCount / inputCount));
     status.setSlot(TaskStatus::kDupeCount, int(dupeCount / inputCount));
+    status.setSlot(TaskStatus::kQueueDropCount, int(queueDropCount));
+    status.setSlot(TaskStatus::kLatencyReport, latencyStats_.format());
 }
 
 namespace {
@@ -788,7 +904,35 @@ Task::addInputChannel(const Channel& channel)
 void
 Task::updateInputStats(size_t channelIndex, size_t size, uint32_t sequenceCounter)
 {
-    inputStats_[channelIndex].updateInputCounters(size, sequenceCounter);
+    Stats& stats(inputStats_[channelIndex]);
+    if (!metrics_) {
+        stats.updateInputCounters(size, sequenceCounter);
+        return;
+    }
+
+    size_t drops = stats.getDropCount();
+    size_t dupes = stats.getDupeCount();
+    stats.updateInputCounters(size, sequenceCounter);
+    metrics_->messages.fetch_add(1, std::memory_order_relaxed);
+    metrics_->bytes.fetch_add(size, std::memory_order_relaxed);
+    drops = stats.getDropCount() - drops;
+    dupes = stats.getDupeCount() - dupes;
+    if (drops) metrics_->drops.fetch_add(drops, std::memory_order_relaxed);
+    if (dupes) metrics_->dupes.fetch_add(dupes, std::memory_order_relaxed);
+}
+
+void
+Task::setMetricsSegment(const MetricsSegment::Ref& segment, const std::string& name)
+{
+    Logger::ProcLog log("setMetricsSegment", Log());
+    LOGINFO << taskName_ << " name: " << name << std::endl;
+
+    metrics_ = segment ? segment->addTask(name) : 0;
+    metricsSegment_ = metrics_ ? segment : MetricsSegment::Ref();
+    if (metrics_) {
+        metrics_->processingState.store(processingState_, std::memory_order_relaxed);
+        metrics_->usingData.store(usingData_, std::memory_order_relaxed);
+    }
 }
 
 bool
@@ -810,6 +954,7 @@ Task::setUsingData(bool value)
     //
     if (value != usingData_) {
         usingData_ = value;
+        if (metrics_) metrics_->usingData.store(value, std::memory_order_relaxed);
         if (value) resetProcessedStats();
 
         // Notify our input senders that our data-pulling state has changed.
@@ -840,12 +985,168 @@ Task::activateThreads(int count)
 
     if (rc == -1) return false;
 
-    if (threadParams_.cpuAffinity != -1) {
-        for (int index = 0; index < count; ++index) {
-            ACE_thread_t tid = tids[index];
-            LOGINFO << "tid: " << tid << std::endl;
+    return applyCpuAffinity();
+}
+
+void
+Task::setThreadParams(const ThreadParams& threadParams)
+{
+    threadParams_ = threadParams;
+    applyCpuAffinity();
+}
+
+void
+Task::setQueuePolicy(const QueuePolicy& queuePolicy)
+{
+    Logger::ProcLog log("setQueuePolicy", Log());
+    LOGINFO << taskName_ << " action: " << queuePolicy.action << " capacity: " << queuePolicy.capacity
+            << " keepEvery: " << queuePolicy.keepEvery << std::endl;
+
+    queuePolicy_ = queuePolicy;
+    overflowCount_.store(0, std::memory_order_relaxed);
+
+    // With a capacity, enqueue() enforces a message count limit, so the queue itself must never block on its byte
+    // count. Otherwise, fall back to the byte limit.
+    //
+    size_t limit = queuePolicy_.capacity ? ~size_t(0) >> 1 : kQueueSize;
+    msg_queue()->high_water_mark(limit);
+    msg_queue()->low_water_mark(limit - 1);
+}
+
+bool
+Task::enqueue(ACE_Message_Block* data, ACE_Time_Value* timeout)
+{
+    static Logger::ProcLog log("enqueue", Log());
+
+    if (!queuePolicy_.capacity || MessageManager::IsControlMessage(data)) return append(data, timeout);
+
+    // Check for room and add the message while holding queueMutex_, so that several upstream threads putting at
+    // once cannot push the queue past its capacity. With a capacity, the queue has no byte limit (see
+    // setQueuePolicy()), so append() never blocks while holding the lock.
+    //
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    size_t queued = msg_queue()->message_count();
+    if (queued >= queuePolicy_.capacity) {
+        size_t overflow = overflowCount_.fetch_add(1, std::memory_order_relaxed);
+        if (overflow == 0) {
+            LOGWARNING << taskName_ << " input queue is full - queued: " << queued << std::endl;
         }
+
+        switch (queuePolicy_.action) {
+        case QueuePolicy::kBlock:
+            while (msg_queue()->message_count() >= queuePolicy_.capacity) {
+                if (msg_queue()->deactivated() || (timeout && ACE_OS::gettimeofday() >= *timeout)) return false;
+
+                // Wake up now and then to check for deactivation and the timeout.
+                //
+                queueSpace_.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            break;
+
+        case QueuePolicy::kDropNewest: shed(data); return true;
+
+        case QueuePolicy::kDropOldest:
+            if (!shedOldest()) {
+                shed(data);
+                return true;
+            }
+            break;
+
+        case QueuePolicy::kKeepNth:
+            // Keep the first message to overflow, and every Nth one after that, dropping the oldest message to
+            // make room for it.
+            //
+            if ((queuePolicy_.keepEvery > 1 && overflow % queuePolicy_.keepEvery) || !shedOldest()) {
+                shed(data);
+                return true;
+            }
+            break;
+        }
+    } else if (overflowCount_.load(std::memory_order_relaxed)) {
+        overflowCount_.store(0, std::memory_order_relaxed);
     }
 
+    return append(data, timeout);
+}
+
+bool
+Task::shedOldest()
+{
+    // The task thread may empty the queue first, in which case there is nothing to drop. Never drop anything but a
+    // data message: put it back and report failure.
+    //
+    ACE_Message_Block* oldest = 0;
+    ACE_Time_Value immediate(ACE_Time_Value::zero);
+    if (msg_queue()->dequeue_head(oldest, &immediate) == -1) return true;
+    if (!MessageManager::IsDataMessage(oldest)) {
+        if (msg_queue()->enqueue_head(oldest) == -1) oldest->release();
+        return false;
+    }
+
+    shed(oldest);
+    return true;
+}
+
+bool
+Task::append(ACE_Message_Block* data, ACE_Time_Value* timeout)
+{
+    int count = putq(data, timeout);
+    if (count == -1) return false;
+    if (metrics_) metrics_->pendingQueueCount.store(count, std::memory_order_relaxed);
+    return true;
+}
+
+int
+Task::dequeue(ACE_Message_Block*& data, ACE_Time_Value* timeout)
+{
+    int remaining = getq(data, timeout);
+    if (remaining != -1 && metrics_) metrics_->pendingQueueCount.store(remaining, std::memory_order_relaxed);
+    if (remaining != -1 && queuePolicy_.capacity && queuePolicy_.action == QueuePolicy::kBlock) {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        queueSpace_.notify_all();
+    }
+
+    return remaining;
+}
+
+void
+Task::shed(ACE_Message_Block* data)
+{
+    size_t channelIndex = data->msg_priority();
+    if (channelIndex < inputStats_.size()) inputStats_[channelIndex].addQueueDrop();
+    if (metrics_) metrics_->queueDrops.fetch_add(1, std::memory_order_relaxed);
+    data->release();
+}
+
+
+bool
+Task::applyCpuAffinity()
+{
+    static Logger::ProcLog log("applyCpuAffinity", Log());
+    LOGINFO << taskName_ << " cpu: " << threadParams_.cpuAffinity << std::endl;
+
+#ifdef linux
+    size_t count = thr_count();
+    if (threadParams_.cpuAffinity == -1 || !count || !thr_mgr()) return true;
+
+    std::vector<ACE_thread_t> tids(count, ACE_thread_t());
+    ssize_t found = thr_mgr()->thread_list(this, &tids[0], count);
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(threadParams_.cpuAffinity, &cpus);
+
+    bool ok = true;
+    for (ssize_t index = 0; index < found; ++index) {
+        LOGDEBUG << "tid: " << tids[index] << std::endl;
+        if (::pthread_setaffinity_np(tids[index], sizeof(cpus), &cpus)) {
+            LOGERROR << taskName_ << " failed to bind thread to cpu " << threadParams_.cpuAffinity << std::endl;
+            ok = false;
+        }
+    }
+
+    return ok;
+#else
     return true;
+#endif
 }
@@ -1,7 +1,10 @@
 #ifndef SIDECAR_IO_TASK_H // -*- C++ -*-
 #define SIDECAR_IO_TASK_H
 
+#include <atomic>
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -10,6 +13,8 @@
 #include "boost/shared_ptr.hpp"
 
 #include "IO/Channel.h"
+#include "IO/LatencyStats.h"
+#include "IO/MetricsSegment.h"
 #include "IO/ProcessingState.h"
 #include "IO/Stats.h"
 #include "IO/TaskStatus.h"
@@ -112,6 +117,35 @@ public:
         long cpuAffinity;
     };
 
+    /** Limit on the number of messages waiting in the input queue of a threaded task, and what to do with a data
+        message that arrives when the queue is full. Control messages are always queued. Install in a Task
+        object via Task::setQueuePolicy().
+    */
+    struct QueuePolicy {
+        enum Action {
+            kBlock,      ///< Make the sender wait for room
+            kDropOldest, ///< Make room by dropping the oldest queued message
+            kDropNewest, ///< Drop the new message
+            kKeepNth     ///< Only queue every Nth new message, dropping the oldest to make room
+        };
+
+        /** Obtain the action with the given name: "block", "dropOldest", "dropNewest", or "keepNth".
+
+            \param name the name to look for
+
+            \param action storage for the action found
+
+            \return true if found
+        */
+        static bool GetAction(const std::string& name, Action& action);
+
+        QueuePolicy(Action a = kBlock, size_t c = 0, size_t k = 2) : action(a), capacity(c), keepEvery(k) {}
+
+        Action action;    ///< What to do when the queue is full
+        size_t capacity;  ///< Maximum number of queued messages, or 0 for the default byte limit of the queue
+        size_t keepEvery; ///< For kKeepNth, the N
+    };
+
     /** Shared reference counter for Task objects.
      */
     using Ref = boost::shared_ptr<Task>;
@@ -183,6 +217,16 @@ public:
     */
     int put(ACE_Message_Block* data, ACE_Time_Value* timeout = 0) override;
 
+    /** Give a control message to this task alone. Unlike put(), the message does not go on to the tasks after
+        this one. Delivery goes through deliverControlMessage(), so a task with a control lane handles the
+        message before any waiting data messages.
+
+        \param msg control message to post
+
+        \return true if successful
+    */
+    bool injectControlMessage(const ControlMessage& msg);
+
     /** Record an error message. The error will remain held until clearError() is called.
 
         \param text the text describing the error
@@ -278,6 +322,22 @@ public:
     */
     void updateInputStats(size_t channelIndex, size_t byteCount, uint32_t sequenceCounter);
 
+    /** Obtain the latency statistics of the messages processed by this task. Only updated while latency
+        tracing is on (see LatencyStats::SetEnabled()).
+
+        \return LatencyStats reference
+    */
+    const LatencyStats& getLatencyStats() const { return latencyStats_; }
+
+    /** Publish live metrics for this task in a shared memory segment (see MetricsSegment). Claims a slot in the
+        segment under the given name.
+
+        \param segment the segment to publish to
+
+        \param name name to give the slot, usually the stream and task names
+    */
+    void setMetricsSegment(const MetricsSegment::Ref& segment, const std::string& name);
+
     /** Set the unique ID for this task. Used when checking whether it is a
 
         recipient of a message from another task.
@@ -432,10 +492,12 @@ public:
 
     /** Set the thread parameters that the task will use in its activateThreads() call. The task records the
         thread parameters since initialization and configuration may not immediately invoke activateThreads().
+        The CPU affinity also applies right away to any threads the task already has running, however they were
+        started.
 
         \param threadParams the new thread parameters to use.
     */
-    void setThreadParams(const ThreadParams& threadParams) { threadParams_ = threadParams; }
+    void setThreadParams(const ThreadParams& threadParams);
 
     /** Obtain the current thread parameter settings.
 
@@ -443,6 +505,25 @@ public:
     */
     const ThreadParams& getThreadParams() const { return threadParams_; }
 
+    /** Set the limit on the input queue of the task, and what to do when it is reached.
+
+        \param queuePolicy the new policy to use
+    */
+    void setQueuePolicy(const QueuePolicy& queuePolicy);
+
+    /** Obtain the current input queue policy.
+
+        \return policy
+    */
+    const QueuePolicy& getQueuePolicy() const { return queuePolicy_; }
+
+    /** Bind the running threads of the task to the processor in the cpuAffinity thread parameter. Does nothing
+        if it is -1, or on systems other than linux.
+
+        \return true if successful
+    */
+    bool applyCpuAffinity();
+
     /** Spawn count threads that will each run in the task's svc() method, which derived classes must define
         (see ACE_Task::svc()).
 
@@ -453,6 +534,13 @@ public:
     bool activateThreads(int count);
 
 protected:
+    /** Set where the task records latency statistics. By default, it times deliverDataMessage(). Tasks that
+        queue their input for processing by processMessage() should have it time that instead.
+
+        \param value true to time processMessage()
+    */
+    void setLatencyTracedOnProcess(bool value) { latencyTracedOnProcess_ = value; }
+
     /** Change the tasks processing state indicator. Invokes the appropriate processor method for the new state,
         iff the transition from the current state to the new one is valid.
 
@@ -531,6 +619,29 @@ protected:
     */
     virtual bool deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout) = 0;
 
+    /** Add a message to the input queue of the task, applying the QueuePolicy set by setQueuePolicy(). Threaded
+        tasks should use this instead of putq(). A data message dropped due to the policy counts as delivered,
+        and shows up in the queue drop count of the input Stats object of its channel.
+
+        \param data message to add
+
+        \param timeout absolute time to give up waiting for room in the queue, or NULL to wait forever
+
+        \return true if the task took ownership of the message
+    */
+    bool enqueue(ACE_Message_Block* data, ACE_Time_Value* timeout);
+
+    /** Take the next message from the input queue of the task. Threaded tasks should use this instead of getq()
+        so that senders blocked by a full queue wake up.
+
+        \param data storage for the message
+
+        \param timeout absolute time to give up waiting for a message, or NULL to wait forever
+
+        \return number of messages left in the queue, or -1 on failure
+    */
+    int dequeue(ACE_Message_Block*& data, ACE_Time_Value* timeout = 0);
+
     /** Process a message, data or control. This is a helper routine for derived classes that perform their
         message processing in a separate thread (it is not used by Task itself). Depending on the type of
         message held in the given \a data parameter, it invokes processDataMessage() or processControlMessage().
@@ -627,6 +738,29 @@ private:
     using ProcessingStateEnumDef = Parameter::Defs::Enum<ProcessingStateEnumTraits>;
     using ProcessingStateParameter = Parameter::TValue<ProcessingStateEnumDef>;
 
+    /** Drop a message from the input queue due to the queue policy.
+
+        \param data the message to drop
+    */
+    void shed(ACE_Message_Block* data);
+
+    /** Drop the oldest message in the input queue to make room for a new one. Only data messages are dropped.
+        Must hold queueMutex_.
+
+        \return true if there is now room, false if the oldest message is not a data message
+    */
+    bool shedOldest();
+
+    /** Add a message to the end of the input queue, and publish the new queue depth.
+
+        \param data the message to add
+
+        \param timeout absolute time to give up waiting for room
+
+        \return true if successful
+    */
+    bool append(ACE_Message_Block* data, ACE_Time_Value* timeout);
+
     /** Notification handler invoked when the processing state value changes.
 
         \param value new value to use
@@ -653,6 +787,14 @@ private:
     ProcessingState::Value lastProcessingState_;             ///< Last processing state set
     Parameter::BoolValue::Ref alwaysUsingData_;
     ThreadParams threadParams_;
+    QueuePolicy queuePolicy_;
+    std::atomic<size_t> overflowCount_;    ///< Messages that found the input queue full since it last had room
+    std::mutex queueMutex_;                ///< Serializes adding data messages to a bounded input queue
+    std::condition_variable queueSpace_;   ///< Signaled when a message leaves the input queue
+    LatencyStats latencyStats_;            ///< Message latency statistics when tracing
+    bool latencyTracedOnProcess_;          ///< If true, time processMessage() instead of deliverDataMessage()
+    MetricsSegment::Ref metricsSegment_;   ///< Shared memory segment holding metrics_
+    MetricsSegment::TaskMetrics* metrics_; ///< Live metrics slot, or NULL if not publishing
     bool usingData_; ///< True if the task uses data from above
 };
 
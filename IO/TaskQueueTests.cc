@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "ace/Message_Block.h"
+#include "ace/OS_NS_sys_time.h"
+
+#include "Logger/Log.h"
+#include "Messages/Video.h"
+#include "UnitTest/UnitTest.h"
+
+#include "MessageManager.h"
+#include "ProcessingStateChangeRequest.h"
+#include "Task.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+using namespace SideCar::Messages;
+
+/** Task that queues what it receives but never processes it, so that the queue fills.
+ */
+struct Queue : public Task {
+    Queue() : Task(true) {}
+
+    bool deliverControlMessage(ACE_Message_Block* data, ACE_Time_Value* timeout) { return enqueue(data, timeout); }
+
+    bool deliverDataMessage(ACE_Message_Block* data, ACE_Time_Value* timeout) { return enqueue(data, timeout); }
+
+    /** Empty the queue.
+
+        \return sequence counter of each queued PRI, with -1 for control messages
+    */
+    std::vector<int> drain()
+    {
+        std::vector<int> found;
+        ACE_Message_Block* data;
+        ACE_Time_Value now(ACE_OS::gettimeofday());
+        while (dequeue(data, &now) != -1) {
+            if (MessageManager::IsControlMessage(data)) {
+                found.push_back(-1);
+                data->release();
+            } else {
+                MessageManager mgr(data);
+                found.push_back(int(mgr.getNative<Video>()->getSequenceCounter()));
+            }
+        }
+
+        return found;
+    }
+
+    /** Take the message at the head of the queue, waiting for one if necessary.
+     */
+    void take()
+    {
+        ACE_Message_Block* data;
+        if (dequeue(data) != -1) data->release();
+    }
+
+    size_t getQueueDropCount() const { return getInputStats(0).getQueueDropCount(); }
+
+    size_t getQueued() { return msg_queue()->message_count(); }
+};
+
+/** Create a PRI message.
+
+    \param sequence sequence counter of the PRI
+
+    \return new message
+*/
+static Video::Ref
+MakePRI(uint32_t sequence)
+{
+    VMEDataMessage vme;
+    vme.header.msgDesc = (VMEHeader::kPackedReal << 16) | VMEHeader::kPRIValidMask;
+    vme.header.timeStamp = 0;
+    vme.header.azimuth = 0;
+    vme.header.pri = sequence;
+    vme.header.irigTime = 0.0;
+
+    Video::Ref msg(Video::Make("test", vme, 1));
+    msg->setMessageSequenceNumber(sequence + 1);
+    return msg;
+}
+
+struct Test : public UnitTest::TestObj {
+    Test() : TestObj("TaskQueue") {}
+
+    void test();
+
+    /** Give a task a PRI.
+
+        \param task recipient
+
+        \param sequence sequence counter of the PRI
+    */
+    void send(Queue& task, uint32_t sequence);
+
+    /** Give a task a control message.
+
+        \param task recipient
+    */
+    void sendControl(Queue& task);
+
+    void testDropOldest();
+
+    void testDropNewest();
+
+    void testKeepNth();
+
+    void testBlock();
+
+    void testConcurrentSenders();
+};
+
+void
+Test::send(Queue& task, uint32_t sequence)
+{
+    MessageManager mgr(MakePRI(sequence));
+    assertEqual(0, task.put(mgr.getMessage(), 0));
+}
+
+void
+Test::sendControl(Queue& task)
+{
+    assertEqual(0, task.put(ProcessingStateChangeRequest(ProcessingState::kRun).getWrapped(), 0));
+}
+
+void
+Test::testDropOldest()
+{
+    Queue task;
+    task.setQueuePolicy(Task::QueuePolicy(Task::QueuePolicy::kDropOldest, 3));
+    for (uint32_t index = 0; index < 5; ++index) send(task, index);
+
+    std::vector<int> found(task.drain());
+    assertEqual(size_t(3), found.size());
+    assertEqual(2, found[0]);
+    assertEqual(4, found[2]);
+    assertEqual(size_t(2), task.getQueueDropCount());
+
+    // A control message at the head of the queue stays, and the new message goes instead.
+    //
+    sendControl(task);
+    send(task, 10);
+    send(task, 11);
+    send(task, 12);
+    found = task.drain();
+    assertEqual(size_t(3), found.size());
+    assertEqual(-1, found[0]);
+    assertEqual(11, found[2]);
+    assertEqual(size_t(3), task.getQueueDropCount());
+}
+
+void
+Test::testDropNewest()
+{
+    Queue task;
+    task.setQueuePolicy(Task::QueuePolicy(Task::QueuePolicy::kDropNewest, 3));
+    for (uint32_t index = 0; index < 5; ++index) send(task, index);
+
+    // Control messages always get in.
+    //
+    sendControl(task);
+
+    std::vector<int> found(task.drain());
+    assertEqual(size_t(4), found.size());
+    assertEqual(0, found[0]);
+    assertEqual(2, found[2]);
+    assertEqual(-1, found[3]);
+    assertEqual(size_t(2), task.getQueueDropCount());
+}
+
+void
+Test::testKeepNth()
+{
+    Queue task;
+    task.setQueuePolicy(Task::QueuePolicy(Task::QueuePolicy::kKeepNth, 2, 3));
+    for (uint32_t index = 0; index < 10; ++index) send(task, index);
+
+    // Past the capacity, keep every third message, dropping the oldest to make room for it.
+    //
+    std::vector<int> found(task.drain());
+    assertEqual(size_t(2), found.size());
+    assertEqual(5, found[0]);
+    assertEqual(8, found[1]);
+    assertEqual(size_t(8), task.getQueueDropCount());
+}
+
+void
+Test::testBlock()
+{
+    Queue task;
+    task.setQueuePolicy(Task::QueuePolicy(Task::QueuePolicy::kBlock, 2));
+    send(task, 0);
+    send(task, 1);
+
+    // A sender with a timeout gives up.
+    //
+    VMEDataMessage vme;
+    vme.header.msgDesc = (VMEHeader::kPackedReal << 16) | VMEHeader::kPRIValidMask;
+    vme.header.timeStamp = 0;
+    vme.header.azimuth = 0;
+    vme.header.pri = 2;
+    vme.header.irigTime = 0.0;
+    MessageManager mgr(Video::Make("test", vme, 1));
+    ACE_Message_Block* data = mgr.getMessage();
+    ACE_Time_Value soon(ACE_OS::gettimeofday() + ACE_Time_Value(0, 50000));
+    assertEqual(-1, task.put(data, &soon));
+    data->release();
+
+    // A sender without one waits for room.
+    //
+    std::thread sender([this, &task]() { send(task, 3); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    task.take();
+    sender.join();
+
+    std::vector<int> found(task.drain());
+    assertEqual(size_t(2), found.size());
+    assertEqual(3, found[1]);
+    assertEqual(size_t(0), task.getQueueDropCount());
+}
+
+void
+Test::testConcurrentSenders()
+{
+    enum { kSenders = 4, kCount = 200 };
+
+    // Senders that all find room at once must not push the queue past its capacity.
+    //
+    Queue dropping;
+    dropping.setQueuePolicy(Task::QueuePolicy(Task::QueuePolicy::kDropOldest, 4));
+    std::atomic<int> failures(0);
+    std::vector<std::thread> senders;
+    for (int sender = 0; sender < kSenders; ++sender) {
+        senders.emplace_back([&dropping, &failures]() {
+            for (uint32_t index = 0; index < kCount; ++index) {
+                MessageManager mgr(MakePRI(index));
+                if (dropping.put(mgr.getMessage(), 0) != 0) ++failures;
+            }
+        });
+    }
+
+    for (auto& thread : senders) thread.join();
+    assertEqual(0, failures.load());
+    assertEqual(size_t(4), dropping.drain().size());
+    assertEqual(size_t(kSenders * kCount - 4), dropping.getQueueDropCount());
+
+    // Blocked senders that wake together must not either.
+    //
+    Queue blocking;
+    blocking.setQueuePolicy(Task::QueuePolicy(Task::QueuePolicy::kBlock, 2));
+    senders.clear();
+    for (int sender = 0; sender < kSenders; ++sender) {
+        senders.emplace_back([&blocking, &failures]() {
+            for (uint32_t index = 0; index < kCount; ++index) {
+                MessageManager mgr(MakePRI(index));
+                if (blocking.put(mgr.getMessage(), 0) != 0) ++failures;
+            }
+        });
+    }
+
+    size_t maxQueued = 0;
+    for (int index = 0; index < kSenders * kCount; ++index) {
+        maxQueued = std::max(maxQueued, blocking.getQueued());
+        blocking.take();
+    }
+
+    for (auto& thread : senders) thread.join();
+    assertEqual(0, failures.load());
+    assertTrue(maxQueued <= 2);
+    assertEqual(size_t(0), blocking.getQueueDropCount());
+}
+
+void
+Test::test()
+{
+    Logger::Log::Root().setPriorityLimit(Logger::Priority::kError);
+    testDropOldest();
+    testDropNewest();
+    testKeepNth();
+    testBlock();
+    testConcurrentSenders();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return Test().mainRun();
+}
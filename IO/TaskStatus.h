@@ -25,6 +25,8 @@ public:
         kPendingQueueCount,
         kHasParameters,
         kUsingData,
+        kQueueDropCount,
+        kLatencyReport,
         kNumSlots
     };
 
@@ -61,6 +63,18 @@ public:
     bool hasParameters() const { return getSlot(kHasParameters); }
 
     bool isUsingData() const { return getSlot(kUsingData); }
+
+    /** Obtain the number of messages the task shed because its input queue was full.
+
+        \return queue drop count
+    */
+    int getQueueDropCount() const { return getSlot(kQueueDropCount); }
+
+    /** Obtain the latency percentiles of the task (see LatencyStats::format()).
+
+        \return report text, empty if latency tracing is off
+    */
+    std::string getLatencyReport() const { return getSlot(kLatencyReport); }
 };
 
 } // end namespace IO
@@ -18,7 +18,7 @@ WriterDevices::MulticastSocket::Log()
     return log;
 }
 
-WriterDevices::MulticastSocket::MulticastSocket() : device_()
+WriterDevices::MulticastSocket::MulticastSocket() : device_(), fragmenter_()
 {
     ;
 }
@@ -30,7 +30,8 @@ WriterDevices::MulticastSocket::writeToDevice(const iovec* iov, int count)
 
     ACE_INET_Addr addr;
     device_.get_local_addr(addr);
-    ssize_t rc = device_.ACE_SOCK_Dgram::send(iov, count, addr);
+    ssize_t rc = fragmenter_.send(
+        iov, count, [&](const iovec* part, int parts) { return device_.ACE_SOCK_Dgram::send(part, parts, addr); });
 
     if (rc == -1) {
         LOGERROR << "writeToDevice failed - " << errno << " - " << ::strerror(errno) << std::endl;
@@ -49,7 +50,7 @@ WriterDevices::UDPSocket::Log()
     return log;
 }
 
-WriterDevices::UDPSocket::UDPSocket() : device_(), remoteAddress_()
+WriterDevices::UDPSocket::UDPSocket() : device_(), remoteAddress_(), fragmenter_()
 {
     ;
 }
@@ -59,7 +60,8 @@ WriterDevices::UDPSocket::writeToDevice(const iovec* iov, int count)
 {
     static Logger::ProcLog log("writeToDevice", Log());
 
-    ssize_t rc = device_.send(iov, count, remoteAddress_);
+    ssize_t rc = fragmenter_.send(
+        iov, count, [this](const iovec* part, int parts) { return device_.send(part, parts, remoteAddress_); });
     if (rc == -1) {
         LOGERROR << "writeToDevice failed - " << errno << " - " << ::strerror(errno) << std::endl;
         LOGERROR << "addr: " << Utils::INETAddrToString(remoteAddress_) << std::endl;
@@ -12,6 +12,8 @@
 
 #include "boost/shared_ptr.hpp"
 
+#include "IO/Fragments.h"
+
 namespace Logger {
 class Log;
 }
@@ -123,8 +125,14 @@ public:
     */
     const ACE_SOCK_Dgram_Mcast& getDevice() const { return device_; }
 
+    /** Obtain the object that splits messages too big for one datagram.
+
+        \return fragmenter
+    */
+    DatagramFragmenter& getFragmenter() { return fragmenter_; }
+
 protected:
-    /** Send data to the device.
+    /** Send data to the device. Data too big for one datagram goes out in fragments; see DatagramFragmenter.
 
         \param iov address of first iovec structure to use
 
@@ -136,6 +144,7 @@ protected:
 
 private:
     ACE_SOCK_Dgram_Mcast device_;
+    DatagramFragmenter fragmenter_;
 };
 
 /** Device that writes to a unicast socket.
@@ -166,8 +175,14 @@ public:
     */
     void setRemoteAddress(const ACE_INET_Addr& remoteAddress) { remoteAddress_ = remoteAddress; }
 
+    /** Obtain the object that splits messages too big for one datagram.
+
+        \return fragmenter
+    */
+    DatagramFragmenter& getFragmenter() { return fragmenter_; }
+
 protected:
-    /** Send data to the device.
+    /** Send data to the device. Data too big for one datagram goes out in fragments; see DatagramFragmenter.
 
         \param iov address of first iovec structure to use
 
@@ -180,6 +195,7 @@ protected:
 private:
     ACE_SOCK_Dgram device_;
     ACE_INET_Addr remoteAddress_;
+    DatagramFragmenter fragmenter_;
 };
 
 } // end namespace WriterDevices
@@ -0,0 +1,127 @@
+#include <time.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "IO/MetricsSegment.h"
+#include "IO/ProcessingState.h"
+#include "Utils/CmdLineArgs.h"
+#include "Utils/Utils.h"
+
+using namespace SideCar;
+using namespace SideCar::IO;
+
+const std::string about = "Show the live task metrics of a running runner. Reads the shared memory segment of the "
+                          "runner, and never interrupts its processing threads.";
+
+const Utils::CmdLineArgs::OptionDef options[] = {{'i', "interval", "milliseconds between updates (250)", "MSECS"},
+                                                 {'n', "count", "number of updates to show before exiting", "COUNT"},
+                                                 {'b', "batch", "do not clear the screen between updates", 0}};
+
+const Utils::CmdLineArgs::ArgumentDef args[] = {{"NAME", "name of the runner to watch"}};
+
+/** Counter values of one task from the previous update, for calculating rates.
+ */
+struct Sample {
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t processed;
+    uint64_t processingTime;
+};
+
+static Sample
+Read(const MetricsSegment::TaskMetrics& task)
+{
+    Sample sample;
+    sample.messages = task.messages.load(std::memory_order_relaxed);
+    sample.bytes = task.bytes.load(std::memory_order_relaxed);
+    sample.processed = task.processed.load(std::memory_order_relaxed);
+    sample.processingTime = task.processingTime.load(std::memory_order_relaxed);
+    return sample;
+}
+
+/** Obtain the change in a counter since the last update. A counter that went down was cleared, so count from
+    zero.
+*/
+static uint64_t
+Delta(uint64_t now, uint64_t last)
+{
+    return now >= last ? now - last : now;
+}
+
+static void
+Show(const MetricsSegment& segment, std::vector<Sample>& samples, double elapsed)
+{
+    size_t count = segment.getTaskCount();
+    std::printf("%s  pid %d%s  tasks %zu\n\n", segment.getName().c_str(), segment.getOwnerPid(),
+                segment.isOwnerAlive() ? "" : " (exited)", count);
+    std::printf("%-32s %-8s %4s %10s %10s %7s %8s %8s %10s %10s\n", "TASK", "STATE", "DATA", "MSGS/S", "KB/S",
+                "PEND", "DROPS", "SHED", "AVG US", "MAX US");
+
+    samples.resize(count, Sample());
+    for (size_t index = 0; index < count; ++index) {
+        const MetricsSegment::TaskMetrics& task(segment.getTask(index));
+        Sample now(Read(task));
+
+        Sample& last(samples[index]);
+        uint64_t processed = Delta(now.processed, last.processed);
+        double average = processed ? Delta(now.processingTime, last.processingTime) / 1000.0 / processed : 0.0;
+
+        std::printf("%-32.32s %-8.8s %4s %10.1f %10.1f %7u %8llu %8llu %10.1f %10.1f\n", task.name,
+                    ProcessingState::GetName(ProcessingState::Value(task.processingState.load())),
+                    task.usingData.load() ? "yes" : "no", Delta(now.messages, last.messages) / elapsed,
+                    Delta(now.bytes, last.bytes) / 1024.0 / elapsed, task.pendingQueueCount.load(),
+                    (unsigned long long)task.drops.load(), (unsigned long long)task.queueDrops.load(), average,
+                    task.maxProcessingTime.load() / 1000.0);
+        last = now;
+    }
+
+    std::fflush(stdout);
+}
+
+int
+main(int argc, char** argv)
+{
+    Utils::CmdLineArgs cla(argc, argv, about, options, sizeof(options), args, sizeof(args));
+    std::string value;
+
+    int interval = 250;
+    if (cla.hasOpt("interval", value))
+        if (!(value >> interval) || interval < 1) cla.usage("invalid 'interval' value");
+
+    int count = 0;
+    if (cla.hasOpt("count", value))
+        if (!(value >> count) || count < 1) cla.usage("invalid 'count' value");
+
+    bool batch = cla.hasOpt("batch");
+
+    MetricsSegment::Ref segment(MetricsSegment::Attach(MetricsSegment::MakeName(cla.arg(0))));
+    if (!segment) {
+        std::cerr << "*** no metrics found for runner " << cla.arg(0) << std::endl;
+        return 1;
+    }
+
+    // Start from the current counter values so that the first rates cover only the first interval.
+    //
+    std::vector<Sample> samples;
+    for (size_t index = 0; index < segment->getTaskCount(); ++index) samples.push_back(Read(segment->getTask(index)));
+
+    auto last = std::chrono::steady_clock::now();
+    for (int updates = 0; !count || updates < count; ++updates) {
+        timespec delay = {interval / 1000, (interval % 1000) * 1000000L};
+        ::nanosleep(&delay, 0);
+
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed(now - last);
+        last = now;
+
+        if (!batch) std::printf("\033[H\033[2J");
+        Show(*segment, samples, elapsed.count());
+        if (batch) std::printf("\n");
+        if (!segment->isOwnerAlive()) break;
+    }
+
+    return 0;
+}
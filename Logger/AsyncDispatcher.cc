@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <sstream>
+
+#include "AsyncDispatcher.h"
+#include "ClockSource.h"
+#include "Log.h"
+#include "Msg.h"
+
+using namespace Logger;
+
+/** Number of seconds the background thread waits before looking again after it finds all rings empty.
+ */
+static const double kIdleWait = 0.002;
+
+AsyncDispatcher::Ring::Ring(size_t size) :
+    entries_(), mask_(0), head_(0), reported_(0), tail_(0), dropped_(0), closed_(false)
+{
+    size_t capacity = 1;
+    while (capacity < size) capacity <<= 1;
+    entries_.resize(capacity);
+    mask_ = capacity - 1;
+}
+
+AsyncDispatcher::AsyncDispatcher(size_t ringSize) :
+    Threading::Thread(), ringSize_(ringSize), ringsMutex_(Threading::Mutex::Make()), rings_(), ringsVersion_(0),
+    draining_(), drainingVersion_(0), retiredDropped_(0), stopRunningCondition_(Threading::Condition::Make()),
+    stopRunning_(false)
+{
+    // This will spawn a new thread that runs the AsyncDispatcher::run method.
+    //
+    start();
+}
+
+AsyncDispatcher::Ring::Ref
+AsyncDispatcher::makeRing()
+{
+    Ring::Ref ring(new Ring(ringSize_));
+    Threading::Locker lock(ringsMutex_);
+    rings_.push_back(ring);
+    ringsVersion_.fetch_add(1, std::memory_order_release);
+    return ring;
+}
+
+void
+AsyncDispatcher::flush()
+{
+    // Record how far each ring has been filled and how many messages it has dropped, and then wait for the
+    // background thread to deliver and report that many.
+    //
+    struct Mark {
+        Ring::Ref ring;
+        uint64_t pushed;
+        uint64_t dropped;
+    };
+
+    std::vector<Mark> marks;
+    {
+        Threading::Locker lock(ringsMutex_);
+        for (auto& ring : rings_) marks.push_back(Mark{ring, ring->getPushed(), ring->getDropped()});
+    }
+
+    for (auto& mark : marks) {
+        while ((mark.ring->getPopped() < mark.pushed || mark.ring->getReported() < mark.dropped) && isRunning()) {
+            Threading::Thread::Sleep(0.001);
+        }
+    }
+}
+
+void
+AsyncDispatcher::stop()
+{
+    {
+        Threading::Locker lock(stopRunningCondition_);
+        stopRunning_ = true;
+        stopRunningCondition_->signal();
+    }
+
+    // Wait for the thread to deliver what is left and exit.
+    //
+    join();
+}
+
+uint64_t
+AsyncDispatcher::getDropped() const
+{
+    Threading::Locker lock(ringsMutex_);
+    uint64_t dropped = retiredDropped_;
+    for (auto& ring : rings_) dropped += ring->getDropped();
+    return dropped;
+}
+
+void
+AsyncDispatcher::run()
+{
+    Threading::Locker lock(stopRunningCondition_);
+    while (!stopRunning_) {
+        if (!drain()) stopRunningCondition_->timedWaitForSignal(kIdleWait);
+    }
+
+    drain();
+}
+
+size_t
+AsyncDispatcher::drain()
+{
+    // Only take the lock when a thread has added or removed a ring since the last pass.
+    //
+    if (ringsVersion_.load(std::memory_order_acquire) != drainingVersion_) {
+        Threading::Locker lock(ringsMutex_);
+        draining_ = rings_;
+        drainingVersion_ = ringsVersion_.load(std::memory_order_relaxed);
+    }
+
+    size_t count = 0;
+    bool sawClosed = false;
+    for (auto& ring : draining_) {
+        while (Entry* entry = ring->front()) {
+            if (entry->dropped > ring->getReported()) reportDropped(*ring, entry->dropped, entry->log, entry->when);
+            Msg msg(entry->log->fullName(), entry->message, entry->level);
+            msg.when_ = entry->when;
+            entry->log->dispatch(msg);
+            ring->pop();
+            ++count;
+        }
+
+        // Report messages dropped at the end of a burst now, instead of waiting for the next message of the
+        // thread which might never come.
+        //
+        uint64_t dropped = ring->getDropped();
+        if (dropped > ring->getReported()) {
+            ::timeval now;
+            Log::GetClockSource()->now(now);
+            reportDropped(*ring, dropped, &Log::Root(), now);
+        }
+
+        if (ring->isClosed()) sawClosed = true;
+    }
+
+    // Forget the rings of threads that have exited once they are empty.
+    //
+    if (sawClosed) {
+        Threading::Locker lock(ringsMutex_);
+        auto end = std::remove_if(rings_.begin(), rings_.end(), [this](const Ring::Ref& ring) {
+            if (!ring->isClosed() || ring->front() || ring->getDropped() != ring->getReported()) return false;
+            retiredDropped_ += ring->getReported();
+            return true;
+        });
+
+        if (end != rings_.end()) {
+            rings_.erase(end, rings_.end());
+            ringsVersion_.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    return count;
+}
+
+void
+AsyncDispatcher::reportDropped(Ring& ring, uint64_t dropped, const Log* log, const ::timeval& when)
+{
+    std::ostringstream os;
+    os << "*** dropped " << (dropped - ring.getReported()) << " log messages - queue full ***\n";
+    Msg msg(log->fullName(), os.str(), Priority::kWarning);
+    msg.when_ = when;
+    log->dispatch(msg);
+    ring.reported_.store(dropped, std::memory_order_release);
+}
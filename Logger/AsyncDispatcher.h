@@ -0,0 +1,203 @@
+#ifndef LOGGER_ASYNCDISPATCHER_H // -*- C++ -*-
+#define LOGGER_ASYNCDISPATCHER_H
+
+#ifndef _WIN32
+#include <sys/time.h> // for timeval
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "boost/shared_ptr.hpp"
+
+#include "Logger/Priority.h"
+#include "Threading/Threading.h"
+
+namespace Logger {
+
+class Log;
+
+/** Background delivery of log messages. When active, Log::post() no longer calls the writers itself. Instead,
+    it places the finished message text, its priority level, and its timestamp into a ring buffer owned by the
+    posting thread, and a single background thread takes messages out of the rings and hands them to the
+    writers. A processing thread that posts a burst of messages thus never waits on disk, syslog, or the
+    modifyMutex_ of a Log device.
+
+    Each ring has exactly one producer (the thread that owns it) and one consumer (the background thread), so
+    neither side takes a lock to add or remove a message. The messages of one thread reach the writers in the
+    order they were posted, with the timestamps taken when they were posted. When a ring is full the new
+    message is thrown away and counted; the background thread reports the count in a warning message that
+    appears in the place of the lost messages.
+*/
+class AsyncDispatcher : public Threading::Thread {
+public:
+    /** A log message waiting in a Ring.
+     */
+    struct Entry {
+        const Log* log;        ///< Log device that posted the message
+        Priority::Level level; ///< Severity level
+        ::timeval when;        ///< Time when the message was posted
+        uint64_t dropped;      ///< Number of messages of the ring dropped before this one
+        std::string message;   ///< Text of the message
+    };
+
+    /** Fixed-size queue of log messages from one thread. The Entry objects are reused, so once their strings
+        have grown to fit the messages of a thread, adding a message does not allocate memory.
+    */
+    class Ring {
+    public:
+        using Ref = boost::shared_ptr<Ring>;
+
+        /** Constructor.
+
+            \param size number of entries to hold. Rounded up to a power of two
+        */
+        Ring(size_t size);
+
+        /** Add a message to the ring. Only the owning thread may call.
+
+            \param log Log device that posted the message
+
+            \param level severity level of the message
+
+            \param when time when the message was posted
+
+            \param message text of the message
+
+            \return true if added, false if the ring was full and the message was dropped
+        */
+        bool push(const Log* log, Priority::Level level, const ::timeval& when, const std::string& message)
+        {
+            uint64_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) > mask_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            Entry& entry(entries_[tail & mask_]);
+            entry.log = log;
+            entry.level = level;
+            entry.when = when;
+            entry.dropped = dropped_.load(std::memory_order_relaxed);
+            entry.message.assign(message);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Obtain the oldest message in the ring. Only the background thread may call.
+
+            \return message, or NULL if the ring is empty
+        */
+        Entry* front()
+        {
+            uint64_t head = head_.load(std::memory_order_relaxed);
+            return head == tail_.load(std::memory_order_acquire) ? 0 : &entries_[head & mask_];
+        }
+
+        /** Release the message returned by front() so that the owning thread may reuse it.
+         */
+        void pop() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        /** \return number of messages added to the ring since it was made
+         */
+        uint64_t getPushed() const { return tail_.load(std::memory_order_acquire); }
+
+        /** \return number of messages taken out of the ring since it was made
+         */
+        uint64_t getPopped() const { return head_.load(std::memory_order_acquire); }
+
+        /** \return number of messages dropped because the ring was full
+         */
+        uint64_t getDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+        /** \return number of dropped messages reported by the background thread
+         */
+        uint64_t getReported() const { return reported_.load(std::memory_order_acquire); }
+
+        /** Note that the owning thread has exited. The background thread forgets the ring once it is empty.
+         */
+        void close() { closed_.store(true, std::memory_order_release); }
+
+        /** \return true if the owning thread has exited
+         */
+        bool isClosed() const { return closed_.load(std::memory_order_acquire); }
+
+    private:
+        std::vector<Entry> entries_;
+        uint64_t mask_;
+        std::atomic<uint64_t> head_;
+        std::atomic<uint64_t> reported_; ///< Drop count last reported by the background thread
+        char padding_[64];               ///< Keeps the counters of the two threads on separate cache lines
+        std::atomic<uint64_t> tail_;
+        std::atomic<uint64_t> dropped_;
+        std::atomic<bool> closed_;
+
+        friend class AsyncDispatcher;
+    };
+
+    /** Constructor. Starts the background thread.
+
+        \param ringSize number of messages each thread may have waiting before new ones are dropped
+    */
+    AsyncDispatcher(size_t ringSize);
+
+    /** Make a new ring for the calling thread, and add it to the set that the background thread drains.
+
+        \return new ring
+    */
+    Ring::Ref makeRing();
+
+    /** Wait until the background thread has delivered all messages posted before the call.
+     */
+    void flush();
+
+    /** Stop the background thread after it delivers all waiting messages.
+     */
+    void stop();
+
+    /** \return total number of messages dropped because a ring was full
+     */
+    uint64_t getDropped() const;
+
+private:
+    /** Implementation of Threading::Thread interface. Drains the rings until asked to stop.
+     */
+    void run() override;
+
+    /** Deliver the waiting messages of all rings.
+
+        \return number of messages delivered
+    */
+    size_t drain();
+
+    /** Post a warning with the number of messages dropped by a ring since the last report.
+
+        \param ring ring that dropped the messages
+
+        \param dropped total drop count of the ring to report up to
+
+        \param log Log device to post the report to
+
+        \param when timestamp for the report
+    */
+    void reportDropped(Ring& ring, uint64_t dropped, const Log* log, const ::timeval& when);
+
+    size_t ringSize_;
+    Threading::Mutex::Ref ringsMutex_;
+    std::vector<Ring::Ref> rings_;       ///< Rings of all threads. Protected by ringsMutex_
+    std::atomic<uint32_t> ringsVersion_; ///< Incremented with each change to rings_
+    std::vector<Ring::Ref> draining_;    ///< Copy of rings_ used by the background thread
+    uint32_t drainingVersion_;
+    uint64_t retiredDropped_;            ///< Drop count of closed rings. Protected by ringsMutex_
+    Threading::Condition::Ref stopRunningCondition_;
+    bool stopRunning_;
+};
+
+} // namespace Logger
+
+/** \file
+ */
+
+#endif
@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <atomic>
+#include <cstdlib> // for std::atexit
 #include <cstring> // for tolower
 #include <functional>
 #include <iostream>
@@ -11,6 +13,7 @@
 #include "Utils/Exception.h"
 #include "Utils/Utils.h"
 
+#include "AsyncDispatcher.h"
 #include "ClockSource.h"
 #include "Log.h"
 #include "Msg.h"
@@ -133,6 +136,10 @@ struct PerThreadInfo {
      */
     PerThreadInfo();
 
+    /** Destructor. Tell the AsyncDispatcher that the ring of the thread will get no more messages.
+     */
+    ~PerThreadInfo();
+
     /** Obtain a reference to the C++ output stream.
 
         \return std::ostream reference
@@ -145,18 +152,51 @@ struct PerThreadInfo {
     */
     std::ostream& getNullStream() const { return *null_; }
 
+    /** Post any unfinished message text.
+     */
+    void flush() { os_->flush(); }
+
+    /** Obtain the ring that holds the messages of the thread for an AsyncDispatcher, making one if the thread
+        does not have one yet.
+
+        \param async the active dispatcher
+
+        \return ring to add messages to
+    */
+    AsyncDispatcher::Ring* getRing(AsyncDispatcher* async);
+
 private:
     std::unique_ptr<LogStreamBuf> lsb_;
     std::unique_ptr<std::ostream> os_;
     std::unique_ptr<std::ostream> null_;
+    AsyncDispatcher::Ring::Ref ring_;
+    AsyncDispatcher* ringOwner_;
 };
 
 PerThreadInfo::PerThreadInfo() :
-    lsb_(new LogStreamBuf()), os_(new std::ostream(lsb_.get())), null_(new std::ostream(new NullLogStreamBuf))
+    lsb_(new LogStreamBuf()), os_(new std::ostream(lsb_.get())), null_(new std::ostream(new NullLogStreamBuf)),
+    ring_(), ringOwner_(0)
 {
     null_->setstate(std::ios_base::badbit);
 }
 
+PerThreadInfo::~PerThreadInfo()
+{
+    if (ring_) ring_->close();
+}
+
+AsyncDispatcher::Ring*
+PerThreadInfo::getRing(AsyncDispatcher* async)
+{
+    if (ringOwner_ != async) {
+        if (ring_) ring_->close();
+        ring_ = async->makeRing();
+        ringOwner_ = async;
+    }
+
+    return ring_.get();
+}
+
 std::ostream&
 PerThreadInfo::getStream(Log* log, Priority::Level level)
 {
@@ -215,11 +255,41 @@ struct RuntimeData {
     */
     ClockSource::Ref setClock(const ClockSource::Ref& obj);
 
+    /** Dispose of the PerThreadInfo object of an exiting thread. Invoked by pthreads when the thread exits.
+
+        \param pti object to delete
+    */
+    void destroyPerThreadInfo(PerThreadInfo* pti);
+
+    /** Obtain the ring of the calling thread for asynchronous message delivery.
+
+        \return ring to add messages to, or NULL if messages are delivered as they are posted
+    */
+    AsyncDispatcher::Ring* getAsyncRing();
+
+    /** Start or stop the background thread that delivers messages.
+
+        \param enabled true to start
+
+        \param ringSize number of messages each thread may have waiting
+    */
+    void setAsync(bool enabled, size_t ringSize);
+
+    /** \return active AsyncDispatcher, or NULL if there is none
+     */
+    AsyncDispatcher* getAsync() const { return async_.load(std::memory_order_acquire); }
+
+    /** \return number of messages dropped by all dispatchers, including stopped ones
+     */
+    uint64_t getDropped() const;
+
 private:
     /** Constructor. Restricted to use by Initialize() method.
      */
     RuntimeData();
 
+    PerThreadInfo* getPerThreadInfo();
+
     /** Destructor.
      */
     ~RuntimeData();
@@ -227,6 +297,12 @@ private:
     LogMap logMap_;
     ClockSource::Ref clock_;
     pthread_key_t perThreadInfoKey_;
+    std::atomic<AsyncDispatcher*> async_;
+
+    /** Stopped dispatchers. Never deleted, since a thread that raced with setAsync() may still hold a pointer
+        to one.
+    */
+    std::vector<AsyncDispatcher*> retired_;
 
     static RuntimeData* singleton_;
     static pthread_once_t onceControl_;
@@ -244,7 +320,12 @@ InitializeStub()
 static void
 DestroyPerThreadInfoStub(void* obj)
 {
-    delete static_cast<PerThreadInfo*>(obj);
+    RuntimeData::Singleton().destroyPerThreadInfo(static_cast<PerThreadInfo*>(obj));
+}
+static void
+StopAsyncStub()
+{
+    Log::SetAsynchronous(false);
 }
 }
 
@@ -264,7 +345,8 @@ RuntimeData::Singleton()
     return *singleton_;
 }
 
-RuntimeData::RuntimeData() : logMap_(), clock_(SystemClockSource::Make()), perThreadInfoKey_()
+RuntimeData::RuntimeData() :
+    logMap_(), clock_(SystemClockSource::Make()), perThreadInfoKey_(), async_(nullptr), retired_()
 {
     int rc = pthread_key_create(&perThreadInfoKey_, &DestroyPerThreadInfoStub);
     if (rc) {
@@ -284,8 +366,20 @@ RuntimeData::logMap()
     return logMap_;
 }
 
-std::ostream&
-RuntimeData::getNullStream()
+void
+RuntimeData::destroyPerThreadInfo(PerThreadInfo* pti)
+{
+    // Pthreads clears the thread's value before calling us. Put it back while posting any unfinished message so
+    // that Log::post does not make a new PerThreadInfo object for the thread.
+    //
+    pthread_setspecific(perThreadInfoKey_, pti);
+    pti->flush();
+    pthread_setspecific(perThreadInfoKey_, nullptr);
+    delete pti;
+}
+
+PerThreadInfo*
+RuntimeData::getPerThreadInfo()
 {
     PerThreadInfo* pti = static_cast<PerThreadInfo*>(pthread_getspecific(perThreadInfoKey_));
     if (!pti) {
@@ -293,7 +387,13 @@ RuntimeData::getNullStream()
         pthread_setspecific(perThreadInfoKey_, pti);
     }
 
-    return pti->getNullStream();
+    return pti;
+}
+
+std::ostream&
+RuntimeData::getNullStream()
+{
+    return getPerThreadInfo()->getNullStream();
 }
 
 std::ostream&
@@ -303,12 +403,7 @@ RuntimeData::getStream(Log* log, Priority::Level level)
 
     DBG("getStream() - log: " << log->fullName() << " level: " << level);
 
-    PerThreadInfo* pti = static_cast<PerThreadInfo*>(pthread_getspecific(perThreadInfoKey_));
-    if (!pti) {
-        pti = new PerThreadInfo();
-        pthread_setspecific(perThreadInfoKey_, pti);
-    }
-
+    PerThreadInfo* pti = getPerThreadInfo();
     DBG("getStream() - pti: " << pti);
 
     return pti->getStream(log, level);
@@ -328,6 +423,45 @@ RuntimeData::setClock(const ClockSource::Ref& clock)
     return old;
 }
 
+AsyncDispatcher::Ring*
+RuntimeData::getAsyncRing()
+{
+    AsyncDispatcher* async = getAsync();
+    return async ? getPerThreadInfo()->getRing(async) : nullptr;
+}
+
+void
+RuntimeData::setAsync(bool enabled, size_t ringSize)
+{
+    AsyncDispatcher* async = getAsync();
+    if (enabled == (async != nullptr)) return;
+
+    if (enabled) {
+        // Make sure that messages still waiting at exit reach the writers.
+        //
+        static bool registered = false;
+        if (!registered) {
+            std::atexit(&StopAsyncStub);
+            registered = true;
+        }
+
+        async_.store(new AsyncDispatcher(ringSize), std::memory_order_release);
+    } else {
+        async_.store(nullptr, std::memory_order_release);
+        async->stop();
+        retired_.push_back(async);
+    }
+}
+
+uint64_t
+RuntimeData::getDropped() const
+{
+    AsyncDispatcher* async = getAsync();
+    uint64_t dropped = async ? async->getDropped() : 0;
+    for (auto retired : retired_) dropped += retired->getDropped();
+    return dropped;
+}
+
 ClockSource::Ref
 Log::SetClockSource(const ClockSource::Ref& clock)
 {
@@ -340,6 +474,31 @@ Log::GetClockSource()
     return RuntimeData::Singleton().clock();
 }
 
+void
+Log::SetAsynchronous(bool enabled, size_t ringSize)
+{
+    RuntimeData::Singleton().setAsync(enabled, ringSize);
+}
+
+bool
+Log::IsAsynchronous()
+{
+    return RuntimeData::Singleton().getAsync() != nullptr;
+}
+
+void
+Log::FlushAsynchronous()
+{
+    AsyncDispatcher* async = RuntimeData::Singleton().getAsync();
+    if (async) async->flush();
+}
+
+uint64_t
+Log::GetDroppedCount()
+{
+    return RuntimeData::Singleton().getDropped();
+}
+
 Log&
 Log::Root()
 {
@@ -364,6 +523,8 @@ Log::GetNames(NewLogNotifier notifier)
     return RuntimeData::Singleton().logMap().getNames(notifier);
 }
 
+const Priority::Level Log::kDefaultPriorityLimit;
+
 Log*
 Log::MakeObj(const std::string& name, const std::string& fullName, Log* parent, bool hidden)
 {
@@ -377,9 +538,9 @@ Log::MakeObj(const std::string& name, const std::string& fullName, Log* parent,
     // Create new Log object and install in map.
     //
     if (parent) {
-        obj.reset(new Log(name, fullName, parent, Priority::kError, hidden));
+        obj.reset(new Log(name, fullName, parent, kDefaultPriorityLimit, hidden));
     } else {
-        obj.reset(new Log("root", "root", nullptr, Priority::kError, true));
+        obj.reset(new Log("root", "root", nullptr, kDefaultPriorityLimit, true));
         obj->addWriter(Writers::Stream::Make(Formatters::Verbose::Make(), std::cerr, true));
     }
 
@@ -450,10 +611,12 @@ Log::FindObj(const std::string& name, bool hidden)
 }
 
 Log::Log(const std::string& name, const std::string& fullName, Log* parent, Priority::Level priority, bool hidden) :
-    priorityLimit_(priority), maxPriorityLimit_(priority), parent_(parent), name_(name), fullName_(fullName),
-    propagate_(false), hidden_(hidden), writers_(), modifyMutex_(Threading::Mutex::Make()), children_()
+    priorityLimit_(priority), maxPriorityLimit_(priority), maxTreeLimit_(priority), parent_(parent), name_(name),
+    fullName_(fullName), propagate_(false), hidden_(hidden), writers_(), modifyMutex_(Threading::Mutex::Make()),
+    children_()
 {
     if (parent) { maxPriorityLimit_ = std::max(priority, parent->getMaxPriorityLimit()); }
+    maxTreeLimit_ = maxPriorityLimit_;
 }
 
 Log::~Log()
@@ -470,8 +633,14 @@ void
 Log::initialize()
 {
     if (parent_) {
-        Threading::Locker lock(parent_->modifyMutex_);
-        parent_->children_.push_back(this);
+        {
+            Threading::Locker lock(parent_->modifyMutex_);
+            parent_->children_.push_back(this);
+        }
+
+        for (Log* p = parent_; p && p->maxTreeLimit_ < maxTreeLimit_; p = p->parent_) {
+            p->maxTreeLimit_ = maxTreeLimit_;
+        }
     }
 }
 
@@ -483,6 +652,11 @@ Log::setPriorityLimit(Priority::Level priority)
     priorityLimit_ = priority;
     if (parent_) { priority = parent_->getMaxPriorityLimit(); }
     updateMaxPriorityLimit(priority);
+
+    // Our change may have raised or lowered the maxTreeLimit_ values of our descendants and ancestors.
+    //
+    updateMaxTreeLimit(true);
+    for (Log* p = parent_; p; p = p->parent_) p->updateMaxTreeLimit(false);
 }
 
 void
@@ -503,6 +677,18 @@ Log::updateMaxPriorityLimit(Priority::Level maxPriority)
     }
 }
 
+void
+Log::updateMaxTreeLimit(bool recurse)
+{
+    Priority::Level maxTree = maxPriorityLimit_;
+    for (auto child : children_) {
+        if (recurse) child->updateMaxTreeLimit(true);
+        maxTree = std::max(maxTree, child->maxTreeLimit_);
+    }
+
+    maxTreeLimit_ = maxTree;
+}
+
 void
 Log::flushWriters()
 {
@@ -550,8 +736,26 @@ void
 Log::post(Priority::Level level, const std::string& msg) const
 {
     DBG("post() - level: " << level << " msg: '" << msg << "'");
+
+    // Always take the timestamp here, even when another thread will do the writing.
+    //
+    ::timeval when;
+    GetClockSource()->now(when);
+
+    AsyncDispatcher::Ring* ring = RuntimeData::Singleton().getAsyncRing();
+    if (ring) {
+        ring->push(this, level, when, msg);
+        return;
+    }
+
     Msg m(fullName_, msg, level);
-    GetClockSource()->now(m.when_);
+    m.when_ = when;
+    dispatch(m);
+}
+
+void
+Log::dispatch(const Msg& m) const
+{
     const Log* p = this;
     while (p) {
         DBG("checking - p: " << p << " name: " << p->fullName_);
@@ -572,15 +776,19 @@ Log::postMsg(const Msg& msg) const
 {
     DBG("postMsg() - writers: " << writers_.size());
     Threading::Locker lock(modifyMutex_);
-    std::for_each(writers_.begin(), writers_.end(), [msg](auto v) { v->write(msg); });
+    std::for_each(writers_.begin(), writers_.end(), [&msg](auto v) { v->write(msg); });
 }
 
-ProcLog::ProcLog(const char* name, Log& log) : log_(Log::Find(Log::MakeFullName(log.fullName(), name), false))
+ProcLog::ProcLog(const std::string& name, Log& log) :
+    parent_(log), name_(nullptr), log_(&Log::Find(Log::MakeFullName(log.fullName(), name), false))
 {
     ;
 }
 
-ProcLog::ProcLog(const std::string& name, Log& log) : log_(Log::Find(Log::MakeFullName(log.fullName(), name), false))
+Log*
+ProcLog::resolve() const
 {
-    ;
+    Log* log = &Log::Find(Log::MakeFullName(parent_.fullName(), name_), false);
+    log_.store(log, std::memory_order_release);
+    return log;
 }
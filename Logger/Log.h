@@ -1,6 +1,8 @@
 #ifndef LOGGER_LOG_H // -*- C++ -*-
 #define LOGGER_LOG_H
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <set>
@@ -20,6 +22,7 @@ class Exception;
 }
 namespace Logger {
 
+class AsyncDispatcher;
 class ClockSource;
 class LogMap;
 class Msg;
@@ -93,6 +96,10 @@ class Msg;
 */
 class Log {
 public:
+    /** Priority limit given to new log devices.
+     */
+    static const Priority::Level kDefaultPriorityLimit = Priority::kError;
+
     /** Change the source of timestamps used in messages. NOTE: not thread-safe!
 
         \param clock ClockSource to install
@@ -109,6 +116,32 @@ public:
     */
     static ClockSourceRef GetClockSource();
 
+    /** Change how posted messages reach the writers. When asynchronous, Log::post() adds the message to a
+        lock-free queue of the calling thread, and a background thread hands it to the writers. Messages of one
+        thread keep their order and the timestamps taken when they were posted. If a thread posts messages
+        faster than the writers can take them, the excess messages are dropped, and a warning with the count
+        takes their place. Messages still waiting when asynchronous delivery stops are delivered before this
+        returns. NOTE: call only when no other thread is posting messages, such as at startup.
+
+        \param enabled true to deliver messages from a background thread
+
+        \param ringSize number of messages a thread may have waiting before new ones are dropped
+    */
+    static void SetAsynchronous(bool enabled, size_t ringSize = 1024);
+
+    /** \return true if messages are delivered from a background thread
+     */
+    static bool IsAsynchronous();
+
+    /** Wait until all messages posted before the call have reached the writers. Does nothing if messages are
+        delivered as they are posted.
+    */
+    static void FlushAsynchronous();
+
+    /** \return number of messages dropped because the queue of the posting thread was full
+     */
+    static uint64_t GetDroppedCount();
+
     /** Class method that locates/creates a Log instance under a given name. The name consists of zero or more
         parent names, separated by `.' characters. If there are no parent names, the Log instance is assigned as
         a child to the top-level `root' object.
@@ -222,6 +255,22 @@ public:
     */
     bool isAccepting(Priority::Level priority) const { return priority <= maxPriorityLimit_; }
 
+    /** Obtain the most verbose priority limit in effect for this log device or any of its descendants.
+
+        \return priority level
+    */
+    Priority::Level getMaxTreeLimit() const { return maxTreeLimit_; }
+
+    /** Determine if this Log instance or any of its descendants is accepting a given Priority level. If not,
+        then no existing child device will accept it either, and a new child device will only accept it if
+        it is at or below kDefaultPriorityLimit.
+
+        \param priority priority level to check for
+
+        \return true if accepted
+    */
+    bool isTreeAccepting(Priority::Level priority) const { return priority <= maxTreeLimit_; }
+
     /** Obtain the parent of this log device.
 
         \return parent Log object, or NULL if this is the root Log device.
@@ -417,6 +466,13 @@ private:
 
     void initialize();
 
+    /** Give a log message to the writers of this device, and to those of its parents if propagating. Used by
+        Log::post and by the AsyncDispatcher thread.
+
+        \param msg Msg instance to send
+    */
+    void dispatch(const Msg& msg) const;
+
     /** Private method used by the Log::post to send the log message to registered Writer instances.
 
         \param msg Msg instance to send
@@ -425,11 +481,21 @@ private:
 
     void updateMaxPriorityLimit(Priority::Level maxPriority);
 
+    /** Recalculate maxTreeLimit_ from our maxPriorityLimit_ value and those of our descendants.
+
+        \param recurse if true, first recalculate the values of all descendants
+    */
+    void updateMaxTreeLimit(bool recurse);
+
     /** Max level of log messages that are accepted for posting.
      */
     Priority::Level priorityLimit_;
     Priority::Level maxPriorityLimit_;
 
+    /** Max of maxPriorityLimit_ over this device and all of its descendants.
+     */
+    Priority::Level maxTreeLimit_;
+
     /** Parent of this log device. If this is the top-level device, then this will be nullptr.
      */
     Log* parent_;
@@ -485,6 +551,7 @@ private:
     */
     static Log* MakeObj(const std::string& name, const std::string& fullName, Log* parent, bool hidden);
 
+    friend class AsyncDispatcher;
     friend class LogMap;
 };
 
@@ -500,18 +567,25 @@ private:
 
     The above assumes that the class Foo defined a (class) method called Log() which returned the general log
     device to use for all Foo-related log messages.
+
+    When given a string literal, the constructor does not look up the log device for the procedure. That
+    happens the first time a message might be accepted, so a non-static instance in a routine that runs for
+    every message costs nothing while the Log() device and its children do not accept the level in use. The
+    Log::isTreeAccepting() check keeps any priority limit assigned to the procedure device itself, such as
+    from a configuration file, in effect.
 */
 class ProcLog {
 public:
-    /** Constructor.
+    /** Constructor. Does not look up the log device for the routine. The name must outlive the instance, as
+        a string literal does.
 
         \param name routine name to prepend to log messages
 
         \param log device to send log messages to
     */
-    ProcLog(const char* name, Log& log);
+    ProcLog(const char* name, Log& log) : parent_(log), name_(name), log_(nullptr) {}
 
-    /** Constructor.
+    /** Constructor. Looks up the log device for the routine immediately, since the name is not kept.
 
         \param name routine name to prepend to log messages
 
@@ -519,6 +593,28 @@ public:
     */
     ProcLog(const std::string& name, Log& log);
 
+    ProcLog(const ProcLog&) = delete;
+
+    ProcLog& operator=(const ProcLog&) = delete;
+
+    /** Determine if the log device for the routine is accepting a given Priority level. Does not look up the
+        device if neither the parent device nor any of its children would accept the level.
+
+        \param priority priority level to check for
+
+        \return true if accepted
+    */
+    bool isAccepting(Priority::Level priority) const
+    {
+        Log* log = log_.load(std::memory_order_acquire);
+        if (!log) {
+            if (priority > Log::kDefaultPriorityLimit && !parent_.isTreeAccepting(priority)) return false;
+            log = resolve();
+        }
+
+        return log->isAccepting(priority);
+    }
+
     /** Generate a `fatal' log message from an Utils::Exception object, and throw the exception object. As such,
         it will not return...
 
@@ -527,7 +623,7 @@ public:
     template <typename T>
     void thrower(const T& ex)
     {
-        log_.fatal() << ex.err() << std::endl;
+        getLog().fatal() << ex.err() << std::endl;
         throw ex;
     }
 
@@ -535,153 +631,185 @@ public:
 
         \return true if so
     */
-    bool showsFatal() const { return log_.showsFatal(); }
+    bool showsFatal() const { return isAccepting(Priority::kFatal); }
 
     /** Determine if an 'error' log message would reach a log device.
 
         \return true if so
     */
-    bool showsError() const { return log_.showsError(); }
+    bool showsError() const { return isAccepting(Priority::kError); }
 
     /** Determine if a 'warning' log message would reach a log device.
 
         \return true if so
     */
-    bool showsWarning() const { return log_.showsWarning(); }
+    bool showsWarning() const { return isAccepting(Priority::kWarning); }
 
     /** Determine if an 'info' log message would reach a log device.
 
         \return true if so
     */
-    bool showsInfo() const { return log_.showsInfo(); }
+    bool showsInfo() const { return isAccepting(Priority::kInfo); }
 
     /** Determine if a 'traceIn' log message would reach a log device.
 
         \return true if so
     */
-    bool showsTraceIn() const { return log_.showsTraceIn(); }
+    bool showsTraceIn() const { return isAccepting(Priority::kTraceIn); }
 
     /** Determine if a 'traceOut' log message would reach a log device.
 
         \return true if so
     */
-    bool showsTraceOut() const { return log_.showsTraceOut(); }
+    bool showsTraceOut() const { return isAccepting(Priority::kTraceOut); }
 
     /** Determine if a 'debug' log message would reach a log device.
 
         \return true if so
     */
-    bool showsDebug1() const { return log_.showsDebug1(); }
+    bool showsDebug1() const { return isAccepting(Priority::kDebug1); }
 
     /** Determine if a 'debug' log message would reach a log device.
 
         \return true if so
     */
-    bool showsDebug2() const { return log_.showsDebug2(); }
+    bool showsDebug2() const { return isAccepting(Priority::kDebug2); }
 
     /** Determine if a 'debug' log message would reach a log device.
 
         \return true if so
     */
-    bool showsDebug3() const { return log_.showsDebug3(); }
+    bool showsDebug3() const { return isAccepting(Priority::kDebug3); }
 
     /** Obtain output stream for `fatal' log messages.
 
         \return output stream
     */
-    std::ostream& fatal() { return log_.fatal(); }
+    std::ostream& fatal() { return getLog().fatal(); }
 
     /** Obtain output stream for `error' log messages.
 
         \return output stream
     */
-    std::ostream& error() { return log_.error(); }
+    std::ostream& error() { return getLog().error(); }
 
     /** Obtain output stream for `warning' log messages.
 
         \return output stream
     */
-    std::ostream& warning() { return log_.warning(); }
+    std::ostream& warning() { return getLog().warning(); }
 
     /** Obtain output stream for `info' log messages.
 
         \return output stream
     */
-    std::ostream& info() { return log_.info(); }
+    std::ostream& info() { return getLog().info(); }
 
     /** Obtain output stream for `trace' log messages.
 
         \return output stream
     */
-    std::ostream& traceIn() { return log_.traceIn(); }
+    std::ostream& traceIn() { return getLog().traceIn(); }
 
     /** Obtain output stream for `trace' log messages.
 
         \return output stream
     */
-    std::ostream& traceOut() { return log_.traceOut(); }
+    std::ostream& traceOut() { return getLog().traceOut(); }
 
     /** Obtain output stream for `debug1' log messages.
 
         \return output stream
     */
-    std::ostream& debug1() { return log_.debug1(); }
+    std::ostream& debug1() { return getLog().debug1(); }
 
     /** Obtain output stream for `debug2' log messages.
 
         \return output stream
     */
-    std::ostream& debug2() { return log_.debug2(); }
+    std::ostream& debug2() { return getLog().debug2(); }
 
     /** Obtain output stream for `debug3' log messages.
 
         \return output stream
     */
-    std::ostream& debug3() { return log_.debug3(); }
+    std::ostream& debug3() { return getLog().debug3(); }
 
 protected:
-    Log& log_; ///< device to use for log messages
+    /** Obtain the log device for the routine, looking it up if not yet done.
+
+        \return Log object
+    */
+    Log& getLog() const
+    {
+        Log* log = log_.load(std::memory_order_acquire);
+        return log ? *log : *resolve();
+    }
+
+private:
+    /** Look up the log device for the routine and remember it. Threads that race here find the same device.
+
+        \return Log object
+    */
+    Log* resolve() const;
+
+    Log& parent_;                   ///< device given to the constructor
+    const char* name_;              ///< routine name, or nullptr if log_ was set by the constructor
+    mutable std::atomic<Log*> log_; ///< device to use for log messages, or nullptr if not yet looked up
 };
 
+/** Most verbose priority level of the LOG* macros below that survives compilation. Statements of the LOG* macros
+    with a more verbose level become `if (false)' and the compiler removes them, along with the evaluation of
+    their arguments. The build sets this from the SIDECAR_MIN_LOG_LEVEL CMake cache variable; by default all
+    levels are kept. Direct uses of the Log and ProcLog stream methods are not affected.
+*/
+#ifndef SIDECAR_MIN_LOG_LEVEL
+#define SIDECAR_MIN_LOG_LEVEL Logger::Priority::kDebug3
+#endif
+
+/** Macro that is true if LOG* statements at the given level survive compilation.
+ */
+#define LOGGER_COMPILED(LEVEL) (Logger::Priority::LEVEL <= (SIDECAR_MIN_LOG_LEVEL))
+
 /** Macro to conditionally obtain a log stream if log device is accepting debug3 messages.
  */
-#define LOGDEBUG3 if (log.showsDebug3()) log.debug3()
+#define LOGDEBUG3 if (LOGGER_COMPILED(kDebug3) && log.showsDebug3()) log.debug3()
 
 /** Macro to conditionally obtain a log stream if log device is accepting debug2 messages.
  */
-#define LOGDEBUG2 if (log.showsDebug2()) log.debug2()
+#define LOGDEBUG2 if (LOGGER_COMPILED(kDebug2) && log.showsDebug2()) log.debug2()
 
 /** Macro to conditionally obtain a log stream if log device is accepting debug1 messages.
  */
-#define LOGDEBUG1 if (log.showsDebug1()) log.debug1()
+#define LOGDEBUG1 if (LOGGER_COMPILED(kDebug1) && log.showsDebug1()) log.debug1()
 
 /** Macro to conditionally obtain a log stream if log device is accepting debug1 messages.
  */
-#define LOGDEBUG if (log.showsDebug1()) log.debug1()
+#define LOGDEBUG if (LOGGER_COMPILED(kDebug1) && log.showsDebug1()) log.debug1()
 
 /** Macro to conditionally obtain a log stream if log device is accepting trace messages.
  */
-#define LOGTOUT if (log.showsTraceOut()) log.traceOut()
+#define LOGTOUT if (LOGGER_COMPILED(kTraceOut) && log.showsTraceOut()) log.traceOut()
 
 /** Macro to conditionally obtain a log stream if log device is accepting trace messages.
  */
-#define LOGTIN if (log.showsTraceIn()) log.traceIn()
+#define LOGTIN if (LOGGER_COMPILED(kTraceIn) && log.showsTraceIn()) log.traceIn()
 
 /** Macro to conditionally obtain a log stream if log device is accepting info messages.
  */
-#define LOGINFO if (log.showsInfo()) log.info()
+#define LOGINFO if (LOGGER_COMPILED(kInfo) && log.showsInfo()) log.info()
 
 /** Macro to conditionally obtain a log stream if log device is accepting warning messages.
  */
-#define LOGWARNING if (log.showsWarning()) log.warning()
+#define LOGWARNING if (LOGGER_COMPILED(kWarning) && log.showsWarning()) log.warning()
 
 /** Macro to conditionally obtain a log stream if log device is accepting error messages.
  */
-#define LOGERROR if (log.showsError()) log.error()
+#define LOGERROR if (LOGGER_COMPILED(kError) && log.showsError()) log.error()
 
 /** Macro to conditionally obtain a log stream if log device is accepting fatal messages.
  */
-#define LOGFATAL if (log.showsFatal()) log.fatal()
+#define LOGFATAL if (LOGGER_COMPILED(kFatal) && log.showsFatal()) log.fatal()
 
 } // namespace Logger
 
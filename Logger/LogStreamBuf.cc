@@ -13,7 +13,10 @@ int
 Logger::LogStreamBuf::sync()
 {
     int rc = std::stringbuf::sync();
-    if (log_) log_->post(level_, str());
+
+    // Nothing to post if the buffer is empty, as when a thread exits after finishing its last message.
+    //
+    if (log_ && pptr() != pbase()) log_->post(level_, str());
     str("");
     return rc;
 }
@@ -1,11 +1,15 @@
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <syslog.h>
 #include <time.h>
 #include <unistd.h>
+#include <vector>
 
 #include "ClockSource.h"
 #include "Configurator.h"
@@ -401,6 +405,9 @@ struct TestLog : public UnitTest::TestObj {
     void testPropagation();
     void testPriorityLimit();
     void testProcLog();
+    void testAsync();
+    void testProcLogLazy();
+    void testProcLogCost();
 
     static UnitTest::ProcSuite<TestLog>* Install(UnitTest::ProcSuite<TestLog>* ps)
     {
@@ -409,6 +416,9 @@ struct TestLog : public UnitTest::TestObj {
         ps->add("propagation", &TestLog::testPropagation);
         ps->add("priorityLimit", &TestLog::testPriorityLimit);
         ps->add("procLog", &TestLog::testProcLog);
+        ps->add("async", &TestLog::testAsync);
+        ps->add("procLogLazy", &TestLog::testProcLogLazy);
+        ps->add("procLogCost", &TestLog::testProcLogCost);
         return ps;
     }
 };
@@ -607,6 +617,254 @@ TestLog::testPropagation()
     assertEqual("19700101 000002.00 I - both foo and bar\n", fooBuf.str());
 }
 
+/** Writer that holds up the AsyncDispatcher thread until the test lets it go.
+ */
+struct GateWriter : public Writers::Writer {
+    GateWriter(std::ostream& os) : Writer(Formatters::Terse::Make(), false), os_(os), open_(true), entered_(0) {}
+
+    void write(const Msg& msg) override
+    {
+        ++entered_;
+        while (!open_) Threading::Thread::Sleep(0.001);
+        format(os_, msg);
+    }
+
+    std::ostream& os_;
+    std::atomic<bool> open_;
+    std::atomic<int> entered_;
+};
+
+/** Thread that posts numbered messages.
+ */
+struct Poster : public Threading::Thread {
+    Poster(Log& log, int id, int count) : log_(log), id_(id), count_(count) {}
+
+    void run() override
+    {
+        for (int index = 0; index < count_; ++index) log_.error() << 't' << id_ << ' ' << index << std::endl;
+    }
+
+    Log& log_;
+    int id_;
+    int count_;
+};
+
+void
+TestLog::testAsync()
+{
+    testClock->reset();
+    Log& a(Log::Find("testAsync"));
+    a.setPriorityLimit(Priority::kDebug1);
+    std::ostringstream os;
+    boost::shared_ptr<GateWriter> gate(new GateWriter(os));
+    a.addWriter(gate);
+    CleanUp cl(a, gate);
+
+    std::ostringstream rootOS;
+    Writers::Writer::Ref rootWriter(Writers::Stream::Make(Formatters::Terse::Make(), rootOS));
+    Log::Root().addWriter(rootWriter);
+    CleanUp rootCl(Log::Root(), rootWriter);
+
+    assertFalse(Log::IsAsynchronous());
+    Log::SetAsynchronous(true, 8);
+    assertTrue(Log::IsAsynchronous());
+    uint64_t dropped = Log::GetDroppedCount();
+
+    // Messages keep their order and the timestamps from when they were posted.
+    //
+    a.error() << "one" << std::endl;
+    a.debug1() << "two" << std::endl;
+    Log::FlushAsynchronous();
+    assertEqual("19700101 000000.00 E - one\n19700101 000001.00 D1 - two\n", os.str());
+    os.str("");
+
+    // Hold up the writer on one message, then fill the ring. The messages that do not fit are counted.
+    //
+    gate->open_ = false;
+    a.error() << "blocked" << std::endl;
+    while (gate->entered_ != 3) Threading::Thread::Sleep(0.001);
+    for (int index = 0; index < 10; ++index) a.error() << index << std::endl;
+    assertEqual(dropped + 3, Log::GetDroppedCount());
+    gate->open_ = true;
+    Log::FlushAsynchronous();
+
+    std::string expected("19700101 000002.00 E - blocked\n");
+    for (int index = 0; index < 7; ++index) {
+        std::ostringstream line;
+        line << "19700101 0000" << std::setw(2) << std::setfill('0') << (index + 3) << ".00 E - " << index << '\n';
+        expected += line.str();
+    }
+
+    assertEqual(expected, os.str());
+    assertTrue(rootOS.str().find("dropped 3 log messages") != std::string::npos);
+
+    // Messages from many threads each arrive in the order their thread posted them.
+    //
+    Log::SetAsynchronous(false);
+    Log::SetClockSource(SystemClockSource::Make());
+    Log::SetAsynchronous(true, 4096);
+    os.str("");
+
+    std::vector<Poster*> posters;
+    for (int id = 0; id < 4; ++id) posters.push_back(new Poster(a, id, 1000));
+    for (auto poster : posters) poster->start();
+    for (auto poster : posters) {
+        poster->join();
+        delete poster;
+    }
+
+    Log::FlushAsynchronous();
+    Log::SetAsynchronous(false);
+    Log::SetClockSource(testClock);
+    assertFalse(Log::IsAsynchronous());
+
+    std::vector<int> next(4, 0);
+    std::istringstream is(os.str());
+    std::string line;
+    while (std::getline(is, line)) {
+        std::string::size_type pos = line.find(" - t");
+        assertTrue(pos != std::string::npos);
+        std::istringstream fields(line.substr(pos + 4));
+        int id, index;
+        fields >> id >> index;
+        assertEqual(next[id]++, index);
+    }
+
+    for (int count : next) assertEqual(1000, count);
+}
+
+void
+TestLog::testProcLogLazy()
+{
+    Log& parent(Log::Find("testLazy"));
+    parent.setPriorityLimit(Priority::kWarning);
+    assertEqual(size_t(0), parent.getNumChildren());
+
+    // Levels that neither the parent nor any child accepts do not look up the procedure device.
+    //
+    {
+        ProcLog log("quiet", parent);
+        assertFalse(log.showsDebug1());
+        assertFalse(log.showsInfo());
+        assertEqual(size_t(0), parent.getNumChildren());
+        assertTrue(log.showsWarning());
+        assertEqual(size_t(1), parent.getNumChildren());
+        assertEqual("root.testLazy.quiet", parent.getChild(0)->fullName());
+    }
+
+    // A limit assigned to the procedure device by name takes effect before a ProcLog looks it up.
+    //
+    Log& loud(Log::Find("testLazy.loud"));
+    loud.setPriorityLimit(Priority::kDebug1);
+    assertFalse(parent.isAccepting(Priority::kDebug1));
+    assertTrue(parent.isTreeAccepting(Priority::kDebug1));
+    assertTrue(Log::Root().isTreeAccepting(Priority::kDebug1));
+    {
+        ProcLog log("loud", parent);
+        assertTrue(log.showsDebug1());
+        assertFalse(log.showsDebug2());
+    }
+
+    // Lowering the limit of the child lowers the tree limits of its ancestors.
+    //
+    loud.setPriorityLimit(Priority::kError);
+    assertFalse(parent.isTreeAccepting(Priority::kInfo));
+    assertTrue(parent.isTreeAccepting(Priority::kWarning));
+
+    // Raising the limit of the parent raises the limits of its children.
+    //
+    parent.setPriorityLimit(Priority::kDebug2);
+    assertTrue(loud.isTreeAccepting(Priority::kDebug2));
+    parent.setPriorityLimit(Priority::kError);
+    assertFalse(parent.isTreeAccepting(Priority::kWarning));
+
+    // New devices accept errors, so those always look up the procedure device.
+    //
+    {
+        ProcLog log("error", parent);
+        assertTrue(log.showsError());
+        assertEqual(size_t(3), parent.getNumChildren());
+    }
+}
+
+/** Work done by a routine with a per-message ProcLog that looks up its log device on creation, as ProcLog did
+    before it became lazy.
+*/
+static int
+EagerProcess(Log& parent, int value)
+{
+    Log& log(Log::Find(Log::MakeFullName(parent.fullName(), "eager"), false));
+    LOGINFO << "value: " << value << std::endl;
+    LOGDEBUG << "range: " << value * 2 << std::endl;
+    LOGDEBUG << "azimuth: " << value * 3 << std::endl;
+    LOGDEBUG2 << "done" << std::endl;
+    return value + 1;
+}
+
+/** Same routine with the current ProcLog.
+ */
+static int
+LazyProcess(Log& parent, int value)
+{
+    ProcLog log("lazy", parent);
+    LOGINFO << "value: " << value << std::endl;
+    LOGDEBUG << "range: " << value * 2 << std::endl;
+    LOGDEBUG << "azimuth: " << value * 3 << std::endl;
+    LOGDEBUG2 << "done" << std::endl;
+    return value + 1;
+}
+
+// Same routine built with SIDECAR_MIN_LOG_LEVEL set to warning.
+//
+#pragma push_macro("SIDECAR_MIN_LOG_LEVEL")
+#undef SIDECAR_MIN_LOG_LEVEL
+#define SIDECAR_MIN_LOG_LEVEL Logger::Priority::kWarning
+
+static int
+StrippedProcess(Log& parent, int value)
+{
+    ProcLog log("stripped", parent);
+    LOGINFO << "value: " << value << std::endl;
+    LOGDEBUG << "range: " << value * 2 << std::endl;
+    LOGDEBUG << "azimuth: " << value * 3 << std::endl;
+    LOGDEBUG2 << "done" << std::endl;
+    return value + 1;
+}
+
+#pragma pop_macro("SIDECAR_MIN_LOG_LEVEL")
+
+void
+TestLog::testProcLogCost()
+{
+    Log& parent(Log::Find("testCost"));
+    parent.setPriorityLimit(Priority::kError);
+
+    // Time one call per PRI message with every log statement disabled.
+    //
+    enum { kCount = 1000000 };
+    using Process = int (*)(Log&, int);
+    auto measure = [&parent](Process process) {
+        int value = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int index = 0; index < kCount; ++index) value = process(parent, value);
+        std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+        if (value != kCount) std::cerr << "bad value: " << value << std::endl;
+        return elapsed.count() / kCount * 1E9;
+    };
+
+    double eager = measure(EagerProcess);
+    double lazy = measure(LazyProcess);
+    double stripped = measure(StrippedProcess);
+    std::clog << "disabled logging per PRI: eager ProcLog " << eager << " ns, lazy ProcLog " << lazy
+              << " ns, compiled out " << stripped << " ns" << std::endl;
+
+    // Only the eager routine made a device.
+    //
+    assertEqual(size_t(1), parent.getNumChildren());
+    assertEqual("root.testCost.eager", parent.getChild(0)->fullName());
+    assertTrue(lazy < eager);
+}
+
 struct TestPriority : public UnitTest::TestObj {
     TestPriority() : TestObj("Priority") {}
     void test();
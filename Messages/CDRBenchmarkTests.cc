@@ -0,0 +1,351 @@
+#include <netinet/in.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "ace/CDR_Stream.h"
+#include "ace/Message_Block.h"
+
+#include "Logger/Log.h"
+#include "UnitTest/UnitTest.h"
+
+#include "BinaryVideo.h"
+#include "BugPlot.h"
+#include "Complex.h"
+#include "Extraction.h"
+#include "PRIMessage.h"
+#include "RadarConfig.h"
+#include "RawVideo.h"
+#include "Segments.h"
+#include "Track.h"
+#include "TSPI.h"
+#include "VMEHeader.h"
+#include "Video.h"
+
+using namespace SideCar;
+using namespace SideCar::Messages;
+
+struct Test : public UnitTest::TestObj {
+    enum { kGates = 4000, kIterations = 2000 };
+
+    Test() : TestObj("CDRBenchmark") {}
+
+    void test();
+
+    /** Obtain the bytes held by a CDR output stream.
+     */
+    static std::string Bytes(const ACE_OutputCDR& cdr);
+
+    static VMEDataMessage MakeVME(uint32_t format);
+
+    void testRIUInfo(int byteOrder);
+
+    void testVMEDataMessage(int byteOrder);
+
+    void testExtraction(int byteOrder);
+
+    /** Verify that a message survives a trip through CDR unchanged, and then report how long it takes to encode
+        and decode it.
+    */
+    void benchmark(const Header::Ref& msg);
+};
+
+std::string
+Test::Bytes(const ACE_OutputCDR& cdr)
+{
+    std::string bytes;
+    for (const ACE_Message_Block* block = cdr.begin(); block; block = block->cont()) {
+        bytes.append(block->rd_ptr(), block->length());
+    }
+
+    return bytes;
+}
+
+VMEDataMessage
+Test::MakeVME(uint32_t format)
+{
+    VMEDataMessage vme;
+    vme.header.msgSize = 1234;
+    vme.header.msgDesc = (format << 16) | VMEHeader::kAzimuthValidMask | VMEHeader::kIRIGValidMask |
+                         VMEHeader::kPRIValidMask;
+    vme.header.timeStamp = 0x01020304;
+    vme.header.azimuth = 4095;
+    vme.header.pri = 77;
+    vme.header.temp1 = 5;
+    vme.header.temp2 = 6;
+    vme.header.temp3 = 7;
+    vme.header.irigTime = 1234.5678;
+    vme.rangeMin = 0.25;
+    vme.rangeFactor = RadarConfig::GetRangeMax() / kGates;
+    vme.temp1 = 8;
+    vme.temp2 = 9;
+    vme.temp3 = 10;
+    vme.numSamples = 0;
+    return vme;
+}
+
+void
+Test::testRIUInfo(int byteOrder)
+{
+    PRIMessage::RIUInfo riu(MakeVME(VMEHeader::kPackedReal));
+
+    // The array writes must produce the same bytes as writing each field on its own, even when the stream
+    // does not start out aligned.
+    //
+    ACE_OutputCDR fast(size_t(0), byteOrder);
+    fast.write_octet(1);
+    riu.write(fast);
+
+    ACE_OutputCDR slow(size_t(0), byteOrder);
+    slow.write_octet(1);
+    slow << riu.msgDesc;
+    slow << riu.timeStamp;
+    slow << riu.sequenceCounter;
+    slow << riu.shaftEncoding;
+    slow << riu.prfEncoding;
+    slow << riu.irigTime;
+    slow << riu.rangeMin;
+    slow << riu.rangeFactor;
+    assertTrue(Bytes(fast) == Bytes(slow));
+
+    ACE_InputCDR input(slow);
+    ACE_CDR::Octet octet;
+    input.read_octet(octet);
+    PRIMessage::RIUInfo copy;
+    copy.load(input, 4);
+    assertTrue(input.good_bit());
+    assertEqual(riu.msgDesc, copy.msgDesc);
+    assertEqual(riu.timeStamp, copy.timeStamp);
+    assertEqual(riu.sequenceCounter, copy.sequenceCounter);
+    assertEqual(riu.shaftEncoding, copy.shaftEncoding);
+    assertEqual(riu.prfEncoding, copy.prfEncoding);
+    assertEqual(riu.irigTime, copy.irigTime);
+    assertEqual(riu.rangeMin, copy.rangeMin);
+    assertEqual(riu.rangeFactor, copy.rangeFactor);
+
+    // Older streams do not hold the range values.
+    //
+    ACE_OutputCDR old(size_t(0), byteOrder);
+    old.write_ulong_array(&riu.msgDesc, 5);
+    old << riu.irigTime;
+    ACE_InputCDR oldInput(old);
+    copy.load(oldInput, 3);
+    assertTrue(oldInput.good_bit());
+    assertEqual(riu.prfEncoding, copy.prfEncoding);
+    assertEqual(riu.irigTime, copy.irigTime);
+    assertEqual(RadarConfig::GetRangeMin_deprecated(), copy.rangeMin);
+}
+
+void
+Test::testVMEDataMessage(int byteOrder)
+{
+    VMEDataMessage vme(MakeVME(VMEHeader::kPackedIQ));
+
+    ACE_OutputCDR fast(size_t(0), byteOrder);
+    fast.write_octet(1);
+    fast << vme;
+
+    ACE_OutputCDR slow(size_t(0), byteOrder);
+    slow.write_octet(1);
+    slow << vme.header.msgSize;
+    slow << vme.header.msgDesc;
+    slow << vme.header.timeStamp;
+    slow << vme.header.azimuth;
+    slow << vme.header.pri;
+    slow << vme.header.temp1;
+    slow << vme.header.temp2;
+    slow << vme.header.temp3;
+    slow << vme.header.irigTime;
+    slow << vme.rangeMin;
+    slow << vme.rangeFactor;
+    slow << vme.temp1;
+    slow << vme.temp2;
+    slow << vme.temp3;
+    slow << vme.numSamples;
+    assertTrue(Bytes(fast) == Bytes(slow));
+
+    ACE_InputCDR input(slow);
+    ACE_CDR::Octet octet;
+    input.read_octet(octet);
+    VMEDataMessage copy;
+    input >> copy;
+    assertTrue(input.good_bit());
+    assertEqual(vme.header.msgSize, copy.header.msgSize);
+    assertEqual(vme.header.temp3, copy.header.temp3);
+    assertEqual(vme.header.irigTime, copy.header.irigTime);
+    assertEqual(vme.rangeMin, copy.rangeMin);
+    assertEqual(vme.rangeFactor, copy.rangeFactor);
+    assertEqual(vme.temp1, copy.temp1);
+    assertEqual(vme.numSamples, copy.numSamples);
+}
+
+void
+Test::testExtraction(int byteOrder)
+{
+    Extraction extraction(Time::TimeStamp(12.5), 123.456, 1.25, 0.5);
+
+    ACE_OutputCDR fast(size_t(0), byteOrder);
+    fast.write_octet(1);
+    fast << extraction;
+
+    ACE_OutputCDR slow(size_t(0), byteOrder);
+    slow.write_octet(1);
+    slow << extraction.getWhen();
+    slow << extraction.getRange();
+    slow << extraction.getAzimuth();
+    slow << extraction.getElevation();
+    slow << extraction.getX();
+    slow << extraction.getY();
+    slow << extraction.getAttributes();
+    assertTrue(Bytes(fast) == Bytes(slow));
+
+    ACE_InputCDR input(slow);
+    ACE_CDR::Octet octet;
+    input.read_octet(octet);
+    Extraction copy(input);
+    assertTrue(input.good_bit());
+    assertTrue(extraction.getWhen() == copy.getWhen());
+    assertEqual(extraction.getRange(), copy.getRange());
+    assertEqual(extraction.getAzimuth(), copy.getAzimuth());
+    assertEqual(extraction.getElevation(), copy.getElevation());
+    assertEqual(extraction.getX(), copy.getX());
+    assertEqual(extraction.getY(), copy.getY());
+}
+
+void
+Test::benchmark(const Header::Ref& msg)
+{
+    const MetaTypeInfo& metaTypeInfo(msg->getMetaTypeInfo());
+
+    // Encoding the loaded message must give back the same bytes.
+    //
+    ACE_OutputCDR output(size_t(0), ACE_CDR_BYTE_ORDER);
+    assertTrue(msg->write(output).good_bit());
+    std::string encoded(Bytes(output));
+    {
+        ACE_InputCDR input(output);
+        Header::Ref copy(metaTypeInfo.getCDRLoader()(input));
+        assertTrue(copy.get());
+        assertTrue(input.good_bit());
+        assertEqual(0, int(input.length()));
+        ACE_OutputCDR again(size_t(0), ACE_CDR_BYTE_ORDER);
+        assertTrue(copy->write(again).good_bit());
+        assertTrue(encoded == Bytes(again));
+    }
+
+    // Reuse one stream buffer for all of the encodings, as a writer would.
+    //
+    ACE_OutputCDR encoder(encoded.size() + ACE_CDR::MAX_ALIGNMENT, ACE_CDR_BYTE_ORDER);
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < kIterations; ++index) {
+        encoder.reset();
+        msg->write(encoder);
+    }
+
+    std::chrono::duration<double> encodeTime(std::chrono::steady_clock::now() - start);
+    assertTrue(encoded == Bytes(encoder));
+
+    // The encoder holds one block, which the input streams share instead of copying.
+    //
+    assertTrue(!encoder.begin()->cont());
+    start = std::chrono::steady_clock::now();
+    for (int index = 0; index < kIterations; ++index) {
+        ACE_InputCDR input(encoder.begin());
+        metaTypeInfo.getCDRLoader()(input);
+    }
+
+    std::chrono::duration<double> decodeTime(std::chrono::steady_clock::now() - start);
+
+    double encodeNS = encodeTime.count() / kIterations * 1E9;
+    double decodeNS = decodeTime.count() / kIterations * 1E9;
+    std::clog << std::setw(16) << metaTypeInfo.getName() << std::setw(8) << encoded.size() << " bytes  encode "
+              << std::setw(10) << encodeNS << " ns " << std::setw(8) << encoded.size() / encodeNS * 1E3
+              << " MB/s  decode " << std::setw(10) << decodeNS << " ns " << std::setw(8)
+              << encoded.size() / decodeNS * 1E3 << " MB/s" << std::endl;
+}
+
+void
+Test::test()
+{
+    Logger::Log::Root().setPriorityLimit(Logger::Priority::kWarning);
+
+    testRIUInfo(ACE_CDR_BYTE_ORDER);
+    testRIUInfo(!ACE_CDR_BYTE_ORDER);
+    testVMEDataMessage(ACE_CDR_BYTE_ORDER);
+    testVMEDataMessage(!ACE_CDR_BYTE_ORDER);
+    testExtraction(ACE_CDR_BYTE_ORDER);
+    testExtraction(!ACE_CDR_BYTE_ORDER);
+
+    ::srand48(271828);
+
+    // One message of each MetaTypeInfo type, sized like the ones a radar stream carries.
+    //
+    VMEDataMessage vme(MakeVME(VMEHeader::kPackedReal));
+    Video::Ref video(Video::Make("bench", vme, kGates));
+    for (int gate = 0; gate < kGates; ++gate) video->push_back(Video::DatumType(::drand48() * 8192 - 4096));
+    benchmark(video);
+
+    BinaryVideo::Ref binary(BinaryVideo::Make("bench", vme, kGates));
+    for (int gate = 0; gate < kGates; ++gate) binary->push_back(::drand48() > 0.5);
+    benchmark(binary);
+
+    Complex::Ref complex(Complex::Make("bench", MakeVME(VMEHeader::kPackedIQ), kGates));
+    for (int gate = 0; gate < kGates; ++gate) {
+        complex->push_back(Complex::DatumType(int16_t(::drand48() * 8192 - 4096), int16_t(::drand48() * 8192 - 4096)));
+    }
+    benchmark(complex);
+
+    // RawVideo messages wrap the unconverted VME data, which always has a network-order msgDesc value.
+    //
+    size_t size = sizeof(VMEDataMessage) + sizeof(int16_t) * (kGates - 1);
+    ACE_Message_Block* data = new ACE_Message_Block(size);
+    VMEDataMessage* raw = reinterpret_cast<VMEDataMessage*>(data->wr_ptr());
+    *raw = MakeVME(VMEHeader::kUnpackedReal);
+    raw->header.msgSize = size;
+    if (ACE_CDR_BYTE_ORDER == 1) raw->header.msgDesc |= VMEHeader::kEndianessMask;
+    raw->header.msgDesc = htonl(raw->header.msgDesc);
+    raw->numSamples = kGates;
+    for (int gate = 0; gate < kGates; ++gate) raw->samples[gate] = int16_t(gate);
+    data->wr_ptr(size);
+    benchmark(RawVideo::Make("bench", data));
+
+    Extractions::Ref extractions(Extractions::Make("bench", Header::Ref()));
+    for (int index = 0; index < 100; ++index) {
+        extractions->push_back(Extraction(Time::TimeStamp(index / 10.0), ::drand48() * RadarConfig::GetRangeMax(),
+                                          ::drand48() * 2.0 * M_PI, 0.0));
+    }
+    benchmark(extractions);
+
+    SegmentMessage::Ref segments(new SegmentMessage("bench", Header::Ref(), 0.0, 1.0));
+    for (int index = 0; index < 500; ++index) {
+        int start = ::lrand48() % kGates;
+        segments->data()->merge(Segment(index, start, start + ::lrand48() % 20));
+    }
+    benchmark(segments);
+
+    benchmark(TSPI::MakeLLH("bench", "tspi", 1.0, RadarConfig::GetSiteLatitude(), RadarConfig::GetSiteLongitude(),
+                            RadarConfig::GetSiteHeight() + 1000.0));
+
+    benchmark(BugPlot::Make("bench", 1.0, 1000.0, 1.0, 0.0, "bug"));
+
+    Track::Ref track(Track::Make("bench"));
+    track->setWhen(1.5);
+    track->setEstimate(Track::Coord(0.7, -1.3, 100.0));
+    track->setVelocity(Track::Coord(1.0, 2.0, 3.0));
+    track->setExtraction(Track::Coord(5000.0, 1.0, 0.1));
+    track->setExtractionNum(3);
+    track->setPrediction(Track::Coord(0.71, -1.31, 101.0));
+    track->setFlags(Track::kNew);
+    track->setType(Track::kConfirmed);
+    benchmark(track);
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return Test().mainRun();
+}
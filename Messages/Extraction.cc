@@ -28,11 +28,7 @@ Extraction::Extraction(XmlStreamReader& xsr)
 Extraction::Extraction(ACE_InputCDR& cdr)
 {
     cdr >> when_;
-    cdr >> range_;
-    cdr >> azimuth_;
-    cdr >> elevation_;
-    cdr >> x_;
-    cdr >> y_;
+    cdr.read_double_array(&range_, 5);
     cdr >> attributes_;
 }
 
@@ -40,11 +36,7 @@ ACE_OutputCDR&
 Extraction::write(ACE_OutputCDR& cdr) const
 {
     cdr << when_;
-    cdr << range_;
-    cdr << azimuth_;
-    cdr << elevation_;
-    cdr << x_;
-    cdr << y_;
+    cdr.write_double_array(&range_, 5);
     cdr << attributes_;
     return cdr;
 }
@@ -98,10 +90,7 @@ Extractions::load(ACE_InputCDR& cdr)
     uint32_t count;
     cdr >> count;
     data_.reserve(count);
-    while (count--) {
-        Extraction extraction(cdr);
-        data_.push_back(extraction);
-    }
+    while (count--) data_.emplace_back(cdr);
 
     return cdr;
 }
@@ -124,6 +124,9 @@ public:
   void loadXML(XmlStreamReader &xsr);
 
 private:
+  // NOTE: the CDR constructor and write() move range_ through y_ as one array of doubles, so those fields must
+  // stay together and in this order.
+  //
   Time::TimeStamp when_;
   double range_;     ///< Range of extracted object
   double azimuth_;   ///< Azimuth of extracted object
@@ -37,14 +37,14 @@ Header::GetMessageMetaTypeInfo(ACE_InputCDR& cdr)
 
 Header::Header(ACE_InputCDR& cdr) :
     metaTypeInfo_(*MetaTypeInfo::Find(MetaTypeInfo::Value::kVideo)), guid_(), createdTimeStamp_(), emittedTimeStamp_(),
-    basis_()
+    basis_(), traceOrigin_(0)
 {
     load(cdr);
 }
 
 Header::Header(const std::string& producer, const MetaTypeInfo& metaTypeInfo) :
     metaTypeInfo_(metaTypeInfo), guid_(producer, metaTypeInfo), createdTimeStamp_(Time::TimeStamp::Now()),
-    emittedTimeStamp_(), basis_()
+    emittedTimeStamp_(), basis_(), traceOrigin_(0)
 {
     static Logger::ProcLog log("Header(0)", Log());
     LOGTIN << std::endl;
@@ -52,7 +52,7 @@ Header::Header(const std::string& producer, const MetaTypeInfo& metaTypeInfo) :
 
 Header::Header(const std::string& producer, const MetaTypeInfo& metaTypeInfo, const Ref& basis) :
     metaTypeInfo_(metaTypeInfo), guid_(producer, metaTypeInfo), createdTimeStamp_(Time::TimeStamp::Now()),
-    emittedTimeStamp_(), basis_(basis)
+    emittedTimeStamp_(), basis_(basis), traceOrigin_(basis ? basis->traceOrigin_ : 0)
 {
     static Logger::ProcLog log("Header(1)", Log());
     LOGTIN << std::endl;
@@ -62,14 +62,14 @@ Header::Header(const std::string& producer, const MetaTypeInfo& metaTypeInfo, co
                MetaTypeInfo::SequenceType sequenceNumber) :
     metaTypeInfo_(metaTypeInfo),
     guid_(producer, metaTypeInfo, sequenceNumber), createdTimeStamp_(Time::TimeStamp::Now()), emittedTimeStamp_(),
-    basis_(basis)
+    basis_(basis), traceOrigin_(basis ? basis->traceOrigin_ : 0)
 {
     static Logger::ProcLog log("Header(2)", Log());
     LOGTIN << std::endl;
 }
 
 Header::Header(const MetaTypeInfo& metaTypeInfo) :
-    metaTypeInfo_(metaTypeInfo), guid_(), createdTimeStamp_(), emittedTimeStamp_(), basis_()
+    metaTypeInfo_(metaTypeInfo), guid_(), createdTimeStamp_(), emittedTimeStamp_(), basis_(), traceOrigin_(0)
 {
     static Logger::ProcLog log("Header(3)", Log());
     LOGTIN << std::endl;
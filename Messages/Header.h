@@ -133,6 +133,20 @@ public:
     */
     Time::TimeStamp setEmittedTimeStamp(const Time::TimeStamp& timeStamp);
 
+    /** Obtain when the data behind this message entered the process, for latency tracing (see
+        IO::LatencyStats). Messages made from a basis message inherit its value. Unlike the other time stamps,
+        this one comes from a monotonic clock, and it is not written out with the message.
+
+        \return nanoseconds since an arbitrary start, or 0 if not set
+    */
+    int64_t getTraceOrigin() const { return traceOrigin_; }
+
+    /** Set the latency tracing origin time. Done by IO::Task when it sends a message that does not have one.
+
+        \param value nanoseconds from the monotonic clock
+    */
+    void setTraceOrigin(int64_t value) { traceOrigin_ = value; }
+
     /** Obtain the C++ structure size for this object. Derived classes must override if they extend Header with
         additional members.
 
@@ -297,6 +311,7 @@ private:
     Time::TimeStamp createdTimeStamp_;         ///< When created
     mutable Time::TimeStamp emittedTimeStamp_; ///< When emitted
     Ref basis_;                                ///< Msg that is the basis for this one
+    int64_t traceOrigin_;                      ///< When the data entered the process (monotonic)
 
     /** Header v1 loader. Reads in GUID and created timestamp.
 
@@ -1,5 +1,6 @@
 #include <algorithm> // for std::transform
 #include <cmath>
+#include <cstddef>
 #include <functional> // for std::bind* and std::mem_fun*
 
 #include "boost/bind/bind.hpp"
@@ -17,6 +18,11 @@ using namespace boost::placeholders;
 using namespace SideCar;
 using namespace SideCar::Messages;
 
+static_assert(offsetof(PRIMessage::RIUInfo, prfEncoding) == offsetof(PRIMessage::RIUInfo, msgDesc) + 4 * 4,
+              "RIUInfo uint32_t fields must be contiguous");
+static_assert(offsetof(PRIMessage::RIUInfo, rangeFactor) == offsetof(PRIMessage::RIUInfo, irigTime) + 2 * 8,
+              "RIUInfo double fields must be contiguous");
+
 Logger::Log&
 PRIMessage::Log()
 {
@@ -48,16 +54,14 @@ PRIMessage::RIUInfo::RIUInfo(const VMEDataMessage& vme) :
 ACE_InputCDR&
 PRIMessage::RIUInfo::load(ACE_InputCDR& cdr, int version)
 {
-    cdr >> msgDesc;
-    cdr >> timeStamp;
-    cdr >> sequenceCounter;
-    cdr >> shaftEncoding;
-    cdr >> prfEncoding;
-    cdr >> irigTime;
+    // The array reads align once and then copy the values in one go when the byte order matches. The stream
+    // contents are the same as for separate reads of each field.
+    //
+    cdr.read_ulong_array(&msgDesc, 5);
     if (version > 3) {
-        cdr >> rangeMin;
-        cdr >> rangeFactor;
+        cdr.read_double_array(&irigTime, 3);
     } else {
+        cdr >> irigTime;
         rangeMin = RadarConfig::GetRangeMin_deprecated();
         rangeFactor = RadarConfig::GetRangeFactor_deprecated();
     }
@@ -68,18 +72,8 @@ PRIMessage::RIUInfo::load(ACE_InputCDR& cdr, int version)
 ACE_OutputCDR&
 PRIMessage::RIUInfo::write(ACE_OutputCDR& cdr) const
 {
-    static Logger::ProcLog log("RIUInfo.write", Log());
-    LOGTIN << std::endl;
-
-    cdr << msgDesc;
-    cdr << timeStamp;
-    cdr << sequenceCounter;
-    cdr << shaftEncoding;
-    cdr << prfEncoding;
-    cdr << irigTime;
-    cdr << rangeMin;
-    cdr << rangeFactor;
-    LOGTOUT << std::endl;
+    cdr.write_ulong_array(&msgDesc, 5);
+    cdr.write_double_array(&irigTime, 3);
     return cdr;
 }
 
@@ -151,6 +145,20 @@ PRIMessage::getAzimuthStart() const
     return RadarConfig::GetAzimuth(riuInfo_.shaftEncoding);
 }
 
+void
+PRIMessage::trimSamples(size_t first, size_t count, size_t stride)
+{
+    size_t available = size();
+    first = std::min(first, available);
+    count = std::min(count, available - first);
+    stride = std::max(stride, size_t(1));
+    if (first == 0 && count == available && stride == 1) return;
+
+    riuInfo_.rangeMin = getRangeAt(first);
+    riuInfo_.rangeFactor *= stride;
+    trimData(first, count, stride);
+}
+
 double
 PRIMessage::getAzimuthEnd() const
 {
@@ -76,6 +76,9 @@ public:
 
         void loadXML(XmlStreamReader& xsr);
 
+        // NOTE: load() and write() move the uint32_t and double runs below as arrays, so the fields must stay
+        // in this order and without anything between them.
+        //
         uint32_t msgDesc;         ///< Description of the raw VME data
         uint32_t timeStamp;       ///< VME timestamp value
         uint32_t sequenceCounter; ///< VME sequence counter
@@ -134,6 +137,17 @@ public:
 
     virtual size_t size() const = 0;
 
+    /** Keep every Nth sample of a span of samples, and discard the rest. Updates the range values so that
+        getRangeAt() still gives the right range for the samples that remain.
+
+        \param first index of the first sample to keep
+
+        \param count number of samples in the span, starting at first
+
+        \param stride keep every stride'th sample in the span
+    */
+    void trimSamples(size_t first, size_t count, size_t stride = 1);
+
     /** Write out the message values to a C++ text output stream.
 
         \param os stream to write to
@@ -196,6 +210,17 @@ protected:
     */
     ACE_OutputCDR& writeArray(ACE_OutputCDR& cdr, uint32_t size) const;
 
+    /** Sample container manipulation for trimSamples(). Derived classes must keep samples first, first +
+        stride, first + 2 * stride, ... that are less than first + count.
+
+        \param first index of the first sample to keep
+
+        \param count number of samples in the span
+
+        \param stride distance between samples to keep
+    */
+    virtual void trimData(size_t first, size_t count, size_t stride) = 0;
+
 private:
     RIUInfo riuInfo_; ///< VME header data
 
@@ -442,6 +467,21 @@ public:
     }
 
 protected:
+    /** Implementation of PRIMessage method. Compacts the samples to keep at the front of the container.
+
+        \param first index of the first sample to keep
+
+        \param count number of samples in the span
+
+        \param stride distance between samples to keep
+    */
+    void trimData(size_t first, size_t count, size_t stride)
+    {
+        size_t kept = 0;
+        for (size_t index = first; index < first + count; index += stride) data_[kept++] = data_[index];
+        data_.resize(kept);
+    }
+
     /** Constructor for new PRI messages created from a VME RIU message.
 
         \param producer algorithm/task creating the message
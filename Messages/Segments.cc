@@ -1,3 +1,5 @@
+#include "Threading/Threading.h"
+
 #include "Segments.h"
 
 using std::endl;
@@ -5,6 +7,186 @@ using namespace SideCar::Messages;
 
 // SegmentList
 //
+namespace {
+
+using Container = SegmentList::Container;
+
+enum { kMaxArrays = 1024, kMaxCapacity = 65536, kBatchSize = 32 };
+
+/** Segment arrays cached by one thread. SegmentList construction and destruction only use this cache, so
+    extractor threads do not contend for a lock on every list.
+*/
+struct LocalPool {
+    LocalPool() : arrays() { arrays.reserve(2 * kBatchSize); }
+
+    std::vector<Container> arrays;
+};
+
+/** Segment arrays shared by all threads. Lists are often made on one thread and dropped on another, so the
+    local caches exchange arrays with this pool kBatchSize at a time.
+*/
+struct SharedPool {
+    SharedPool() : mutex(Threading::Mutex::Make()), arrays() { arrays.reserve(kMaxArrays); }
+
+    Threading::Mutex::Ref mutex;
+    std::vector<Container> arrays;
+};
+
+LocalPool&
+GetLocalPool()
+{
+    static thread_local LocalPool pool;
+    return pool;
+}
+
+SharedPool&
+GetSharedPool()
+{
+    static SharedPool pool;
+    return pool;
+}
+
+/** Move the array at the end of one pool vector to the end of another without copying its contents.
+ */
+void
+MoveLast(std::vector<Container>& from, std::vector<Container>& to)
+{
+    to.push_back(Container());
+    to.back().swap(from.back());
+    from.pop_back();
+}
+
+} // namespace
+
+void
+SegmentList::Acquire(Container& segments)
+{
+    LocalPool& local(GetLocalPool());
+    if (local.arrays.empty()) {
+        SharedPool& shared(GetSharedPool());
+        Threading::Locker lock(shared.mutex);
+        for (size_t count = 0; count < kBatchSize && !shared.arrays.empty(); ++count) {
+            MoveLast(shared.arrays, local.arrays);
+        }
+    }
+
+    if (!local.arrays.empty()) {
+        segments.swap(local.arrays.back());
+        local.arrays.pop_back();
+    }
+}
+
+void
+SegmentList::Release(Container& segments)
+{
+    // Don't hold on to empty arrays or to the occasional huge one.
+    //
+    if (!segments.capacity() || segments.capacity() > kMaxCapacity) return;
+
+    segments.clear();
+    LocalPool& local(GetLocalPool());
+    if (local.arrays.size() == 2 * kBatchSize) {
+        // Hand half of the local cache to the shared pool, freeing any arrays that do not fit.
+        //
+        SharedPool& shared(GetSharedPool());
+        Threading::Locker lock(shared.mutex);
+        while (local.arrays.size() > kBatchSize) {
+            if (shared.arrays.size() < kMaxArrays) {
+                MoveLast(local.arrays, shared.arrays);
+            } else {
+                local.arrays.pop_back();
+            }
+        }
+    }
+
+    local.arrays.push_back(Container());
+    local.arrays.back().swap(segments);
+}
+
+size_t
+SegmentList::GetPoolSize()
+{
+    SharedPool& shared(GetSharedPool());
+    Threading::Locker lock(shared.mutex);
+    return GetLocalPool().arrays.size() + shared.arrays.size();
+}
+
+SegmentList::SegmentList() :
+    segments(), span(0), cellCount(0), peakPower(std::numeric_limits<VideoT>::min()), peakRange(0), peakAzimuth(0),
+    totalPower(0.0), centroidRange(0.0), centroidAzimuth(0.0), distMinRange(0), distMaxRange(0), distMinAzimuth(0),
+    distMaxAzimuth(0)
+{
+    Acquire(segments);
+}
+
+SegmentList::~SegmentList()
+{
+    Release(segments);
+}
+
+void
+SegmentList::merge(SegmentList& other)
+{
+    if (other.segments.empty()) {
+        if (other.span > span) span = other.span;
+        return;
+    }
+
+    size_t size = segments.size();
+    if (!size || !(other.segments.front() < segments.back())) {
+        // The other segments all follow ours (or we have none), so just append them.
+        //
+        segments.insert(segments.end(), other.segments.begin(), other.segments.end());
+    } else {
+        // Two-pointer merge from the back so that the merge happens in place, without scratch storage.
+        //
+        segments.resize(size + other.segments.size());
+        Container::iterator out = segments.end();
+        Container::iterator mine = segments.begin() + size;
+        Container::const_iterator theirs = other.segments.end();
+        while (theirs != other.segments.begin()) {
+            if (mine != segments.begin() && *(theirs - 1) < *(mine - 1)) {
+                *--out = *--mine;
+            } else {
+                *--out = *--theirs;
+            }
+        }
+    }
+
+    if (other.span > span) span = other.span;
+
+    cellCount += other.cellCount;
+    other.segments.clear();
+    other.cellCount = 0;
+}
+
+void
+SegmentList::pop(const SegmentList& other)
+{
+    // Both lists are sorted, so one pass over each finds all of the matches.
+    //
+    Container::iterator out = segments.begin();
+    Container::const_iterator theirs = other.segments.begin();
+    for (Container::const_iterator mine = segments.begin(); mine != segments.end(); ++mine) {
+        while (theirs != other.segments.end() && *theirs < *mine) ++theirs;
+        if (theirs != other.segments.end() && *theirs == *mine) {
+            cellCount -= mine->stop - mine->start + 1;
+        } else {
+            *out++ = *mine;
+        }
+    }
+
+    segments.erase(out, segments.end());
+}
+
+void
+SegmentList::pop(const Segment& s)
+{
+    std::pair<Container::iterator, Container::iterator> range = std::equal_range(segments.begin(), segments.end(), s);
+    cellCount -= (range.second - range.first) * (s.stop - s.start + 1);
+    segments.erase(range.first, range.second);
+}
+
 ACE_InputCDR&
 SegmentList::load(ACE_InputCDR& cdr)
 {
@@ -13,23 +195,30 @@ SegmentList::load(ACE_InputCDR& cdr)
     cdr >> tmp1;
     span = tmp1;
     cdr >> tmp1;
-    numSegments = tmp1;
+    size_t numSegments = tmp1;
 
     // read in the segments
+    segments.clear();
+    segments.reserve(numSegments);
     cellCount = 0;
-    size_t tmp = numSegments;
     Segment s;
-    while (tmp--) {
+    bool sorted = true;
+    while (numSegments--) {
         cdr >> tmp1;
         s.azimuth = tmp1;
         cdr >> tmp1;
         s.start = tmp1;
         cdr >> tmp1;
         s.stop = tmp1;
+        if (!segments.empty() && s < segments.back()) sorted = false;
         segments.push_back(s);
         cellCount += s.stop - s.start + 1;
     }
 
+    // Recordings made before the segments were kept sorted may have them in any order.
+    //
+    if (!sorted) std::sort(segments.begin(), segments.end());
+
     return cdr;
 }
 
@@ -38,15 +227,13 @@ SegmentList::write(ACE_OutputCDR& cdr) const
 {
     // write out the header info
     cdr << uint32_t(span);
-    cdr << uint32_t(numSegments);
+    cdr << uint32_t(segments.size());
 
     // write out the segments
-    std::list<Segment>::const_iterator s;
-    std::list<Segment>::const_iterator stop = segments.end();
-    for (s = segments.begin(); s != stop; s++) {
-        cdr << uint32_t(s->azimuth);
-        cdr << uint32_t(s->start);
-        cdr << uint32_t(s->stop);
+    for (const Segment& s : segments) {
+        cdr << uint32_t(s.azimuth);
+        cdr << uint32_t(s.start);
+        cdr << uint32_t(s.stop);
     }
 
     return cdr;
@@ -55,12 +242,9 @@ SegmentList::write(ACE_OutputCDR& cdr) const
 std::ostream&
 SegmentList::print(std::ostream& os) const
 {
-    os << "Span: " << span << endl << "Segment count: " << numSegments << endl;
-
-    std::list<Segment>::const_iterator s;
-    std::list<Segment>::const_iterator stop = segments.end();
-    for (s = segments.begin(); s != stop; s++) {
-        os << "segment(az=" << s->azimuth << ", start=" << s->start << ", stop=" << s->stop << ")" << endl;
+    os << "Span: " << span << endl << "Segment count: " << segments.size() << endl;
+    for (const Segment& s : segments) {
+        os << "segment(az=" << s.azimuth << ", start=" << s.start << ", stop=" << s.stop << ")" << endl;
     }
 
     return os;
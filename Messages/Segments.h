@@ -8,7 +8,9 @@
 
 #include "boost/shared_ptr.hpp"
 
-#include <list>
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 namespace SideCar {
 namespace Messages {
@@ -29,6 +31,14 @@ public:
         return azimuth == rhs.azimuth && start == rhs.start && stop == rhs.stop;
     }
 
+    /** Ordering used by SegmentList: by azimuth index, then by range.
+     */
+    bool operator<(const Segment& rhs) const
+    {
+        return azimuth < rhs.azimuth ||
+               (azimuth == rhs.azimuth && (start < rhs.start || (start == rhs.start && stop < rhs.stop)));
+    }
+
     /// azimuth index
     size_t azimuth;
     /// minimum range index
@@ -39,62 +49,99 @@ public:
 
 /**
    Store a bunch of segments and maintain info about their distribution.
+
+   Segments are kept in a contiguous array sorted by azimuth index and then range, so merging two lists is a
+   single two-pointer pass, and segments that arrive in PRI order (the usual case) are simply appended. The
+   arrays come from a pool and go back to it when the list is destroyed, so the per-PRI lists of the segment
+   algorithms do not allocate once the pool has warmed up. Each thread caches arrays of its own and only locks
+   the shared pool to trade them in batches.
 */
 class SegmentList {
 private:
     using VideoT = int16_t;
 
 public:
-    SegmentList() : numSegments(0), span(0), cellCount(0), peakPower(std::numeric_limits<VideoT>::min()) {}
+    using Container = std::vector<Segment>;
+    using const_iterator = Container::const_iterator;
 
-    // takes all segments from the other object -- assumes they share a common depth
-    void merge(SegmentList& other)
-    {
-        segments.splice(segments.end(), other.segments);
-        numSegments += other.numSegments;
-        other.numSegments = 0;
+    /** Constructor. Obtains segment storage from the pool.
+     */
+    SegmentList();
 
-        if (other.span > span) span = other.span;
+    /** Destructor. Returns segment storage to the pool.
+     */
+    ~SegmentList();
 
-        cellCount += other.cellCount;
-        other.cellCount = 0;
-        // boundingBox+=other.boundingBox;
-    }
+    SegmentList(const SegmentList&) = default;
+
+    SegmentList& operator=(const SegmentList&) = default;
 
+    /** Take all segments from another list, leaving it empty. Assumes that they share a common depth.
+
+        \param other list to merge
+    */
+    void merge(SegmentList& other);
+
+    /** Add a segment.
+
+        \param s segment to add
+    */
     void merge(const Segment& s)
     {
-        segments.push_back(s);
-        numSegments++;
+        if (segments.empty() || !(s < segments.back())) {
+            segments.push_back(s);
+        } else {
+            segments.insert(std::upper_bound(segments.begin(), segments.end(), s), s);
+        }
+
         cellCount += s.stop - s.start + 1;
-        // boundingBox.addX(s.azimuth()); // problems with 2pi wrap
-        // boundingBox.widenY(s);
     }
 
-    void pop(const SegmentList& other)
+    /** Replace the segments of this list with copies of those in another. The span and statistics of this list
+        are unchanged.
+
+        \param other list to copy
+    */
+    void assign(const SegmentList& other)
     {
-        std::list<Segment>::const_iterator index;
-        std::list<Segment>::const_iterator stop = other.segments.end();
-        for (index = other.segments.begin(); index != stop; index++) { pop(*index); }
+        segments.assign(other.segments.begin(), other.segments.end());
+        cellCount = other.cellCount;
     }
 
-    void pop(const Segment& s)
+    /** Remove all segments that appear in another list. Reduces the cell count by the cells of the removed
+        segments.
+
+        \param other list of segments to remove
+    */
+    void pop(const SegmentList& other);
+
+    /** Remove all copies of a segment. Reduces the cell count by the cells of the removed segments.
+
+        \param s segment to remove
+    */
+    void pop(const Segment& s);
+
+    /** Remove all segments, keeping the storage.
+     */
+    void clear()
     {
-        std::list<Segment>::iterator index;
-        std::list<Segment>::const_iterator stop = segments.end();
-        for (index = segments.begin(); index != stop; /* inc in loop */) {
-            if (s == *index) {
-                index = segments.erase(index);
-            } else {
-                index++;
-            }
-        }
+        segments.clear();
+        span = 0;
+        cellCount = 0;
     }
 
     inline size_t PRISpan() const { return span; }
     inline void setPRISpan(size_t x) { span = x; }
 
-    // what's the best way to expose the list?
-    const std::list<Segment>& data() { return segments; }
+    const Container& data() const { return segments; }
+
+    const_iterator begin() const { return segments.begin(); }
+
+    const_iterator end() const { return segments.end(); }
+
+    size_t size() const { return segments.size(); }
+
+    bool empty() const { return segments.empty(); }
 
     /// Return the number of cells in this list
     size_t getCellCount() const { return cellCount; }
@@ -103,11 +150,18 @@ public:
     ACE_OutputCDR& write(ACE_OutputCDR& cdr) const;
     std::ostream& print(std::ostream& os) const;
 
+    /** \return number of segment arrays held by the shared pool and by the cache of the calling thread
+     */
+    static size_t GetPoolSize();
+
 private:
+    static void Acquire(Container& segments);
+
+    static void Release(Container& segments);
+
     // Primary data (stored to disk)
     //
-    size_t numSegments; // so we don't have to traverse the list to find out
-    std::list<Segment> segments;
+    Container segments;
     size_t span; // number of azimuth angles spanned by this list
     // Derived data (not stored to disk?)
     //
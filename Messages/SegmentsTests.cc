@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "Logger/Log.h"
+#include "UnitTest/UnitTest.h"
+
+#include "Segments.h"
+
+using namespace SideCar;
+using namespace SideCar::Messages;
+
+// Count heap allocations so that we can verify that SegmentList storage comes from its pool.
+//
+static size_t allocations_ = 0;
+
+void*
+operator new(size_t size)
+{
+    ++allocations_;
+    void* ptr = ::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+    ::free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t) noexcept
+{
+    ::free(ptr);
+}
+
+struct Test : public UnitTest::TestObj {
+    Test() : TestObj("Segments") {}
+
+    void test();
+
+    void testMerge();
+
+    void testPop();
+
+    void testCDR();
+
+    void testAllocations();
+
+    /** Verify that a list is sorted and that its cell count matches its segments.
+     */
+    void checkList(const SegmentList& list);
+};
+
+void
+Test::checkList(const SegmentList& list)
+{
+    assertTrue(std::is_sorted(list.begin(), list.end()));
+    size_t cellCount = 0;
+    for (const Segment& s : list) cellCount += s.stop - s.start + 1;
+    assertEqual(cellCount, list.getCellCount());
+}
+
+void
+Test::testMerge()
+{
+    // Segments added out of order (as happens at the azimuth wrap) are kept sorted.
+    //
+    SegmentList a;
+    a.merge(Segment(10, 5, 8));
+    a.merge(Segment(11, 1, 2));
+    a.merge(Segment(0, 3, 4));
+    a.merge(Segment(10, 1, 2));
+    assertEqual(size_t(4), a.size());
+    assertTrue(a.data()[0] == Segment(0, 3, 4));
+    assertTrue(a.data()[1] == Segment(10, 1, 2));
+    checkList(a);
+
+    // Random lists merge into the same result as std::merge.
+    //
+    ::srand(161803);
+    for (int trial = 0; trial < 100; ++trial) {
+        SegmentList lhs, rhs;
+        std::vector<Segment> expected;
+        int count = ::rand() % 50;
+        for (int index = 0; index < count; ++index) {
+            Segment s(::rand() % 20, ::rand() % 100, 0);
+            s.stop = s.start + ::rand() % 10;
+            if (::rand() % 2) {
+                lhs.merge(s);
+            } else {
+                rhs.merge(s);
+            }
+            expected.push_back(s);
+        }
+
+        lhs.setPRISpan(trial % 7);
+        rhs.setPRISpan(3);
+        lhs.merge(rhs);
+        std::sort(expected.begin(), expected.end());
+        assertTrue(lhs.data() == expected);
+        assertEqual(size_t(std::max(trial % 7, 3)), lhs.PRISpan());
+        assertTrue(rhs.empty());
+        assertEqual(size_t(0), rhs.getCellCount());
+        checkList(lhs);
+    }
+}
+
+void
+Test::testPop()
+{
+    SegmentList list;
+    list.merge(Segment(1, 1, 4));
+    list.merge(Segment(1, 8, 9));
+    list.merge(Segment(2, 1, 4));
+    list.merge(Segment(2, 1, 4));
+    list.merge(Segment(3, 0, 0));
+
+    // All copies of a segment are removed.
+    //
+    list.pop(Segment(2, 1, 4));
+    assertEqual(size_t(3), list.size());
+    assertEqual(size_t(7), list.getCellCount());
+    checkList(list);
+
+    SegmentList other;
+    other.merge(Segment(1, 8, 9));
+    other.merge(Segment(3, 0, 0));
+    other.merge(Segment(4, 0, 0));
+    list.pop(other);
+    assertEqual(size_t(1), list.size());
+    assertTrue(list.data()[0] == Segment(1, 1, 4));
+    assertEqual(size_t(4), list.getCellCount());
+    checkList(list);
+}
+
+void
+Test::testCDR()
+{
+    // The encoding is unchanged: span, count, and then the azimuth, start, and stop of each segment.
+    //
+    SegmentList list;
+    list.setPRISpan(2);
+    list.merge(Segment(7, 10, 12));
+    list.merge(Segment(8, 11, 15));
+
+    ACE_OutputCDR output;
+    list.write(output);
+    const uint32_t* ptr = reinterpret_cast<const uint32_t*>(output.buffer());
+    assertEqual(uint32_t(2), ptr[0]);
+    assertEqual(uint32_t(2), ptr[1]);
+    assertEqual(uint32_t(7), ptr[2]);
+    assertEqual(uint32_t(10), ptr[3]);
+    assertEqual(uint32_t(12), ptr[4]);
+    assertEqual(uint32_t(8), ptr[5]);
+
+    ACE_InputCDR input(output);
+    SegmentList loaded;
+    loaded.load(input);
+    assertEqual(size_t(2), loaded.PRISpan());
+    assertTrue(loaded.data() == list.data());
+    assertEqual(list.getCellCount(), loaded.getCellCount());
+
+    // Older recordings may hold segments in any order.
+    //
+    ACE_OutputCDR unsorted;
+    unsorted << uint32_t(1);
+    unsorted << uint32_t(3);
+    const uint32_t values[] = {9, 1, 2, 3, 4, 5, 9, 0, 0};
+    for (uint32_t value : values) unsorted << value;
+
+    ACE_InputCDR unsortedInput(unsorted);
+    loaded.load(unsortedInput);
+    assertEqual(size_t(3), loaded.size());
+    assertTrue(loaded.data()[0] == Segment(3, 4, 5));
+    assertTrue(loaded.data()[1] == Segment(9, 0, 0));
+    checkList(loaded);
+}
+
+void
+Test::testAllocations()
+{
+    // Mimic the segment pipeline: each PRI creates a list of segments that is merged into a blob list, and blobs
+    // are released as they complete. Once the pool has warmed up, the lists themselves should not allocate.
+    //
+    std::vector<SegmentList> blobs(8);
+    size_t before = 0;
+    for (int pri = 0; pri < 2000; ++pri) {
+        if (pri == 1000) before = allocations_;
+        SegmentList row;
+        for (size_t gate = 0; gate < 40; ++gate) row.merge(Segment(pri, gate * 10, gate * 10 + 4));
+
+        SegmentList& blob(blobs[pri % blobs.size()]);
+        blob.merge(row);
+        if (blob.size() > 400) {
+            // Hand the segments to a new list, as SegmentConnector does when it emits a blob.
+            //
+            SegmentList done;
+            done.merge(blob);
+        }
+    }
+
+    assertEqual(size_t(0), allocations_ - before);
+    assertTrue(SegmentList::GetPoolSize() > 0);
+}
+
+void
+Test::test()
+{
+    testMerge();
+    testPop();
+    testCDR();
+    testAllocations();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return Test().mainRun();
+}
@@ -124,14 +124,10 @@ Track::loadV1(ACE_InputCDR& cdr)
     cdr >> trackNum_;
 
     // current state estimate for position
-    cdr >> llh_[GEO_LAT];
-    cdr >> llh_[GEO_LON];
-    cdr >> llh_[GEO_HGT];
+    cdr.read_double_array(llh_.tuple_, 3);
 
     // current state estimate for velocity
-    cdr >> llh_velocity_[GEO_LAT];
-    cdr >> llh_velocity_[GEO_LON];
-    cdr >> llh_velocity_[GEO_HGT];
+    cdr.read_double_array(llh_velocity_.tuple_, 3);
     cdr >> when_;
 
     // most recent measurement
@@ -142,9 +138,7 @@ Track::loadV1(ACE_InputCDR& cdr)
     cdr >> extractionNum_;
 
     // most recent prediction
-    cdr >> llh_prediction_[GEO_LAT];
-    cdr >> llh_prediction_[GEO_LON];
-    cdr >> llh_prediction_[GEO_HGT];
+    cdr.read_double_array(llh_prediction_.tuple_, 3);
     cdr >> predictionTime_;
 
     cdr >> flags_;
@@ -166,12 +160,8 @@ Track::write(ACE_OutputCDR& cdr) const
     cdr << trackNum_;
 
     // current state estimate
-    cdr << llh_[GEO_LAT];
-    cdr << llh_[GEO_LON];
-    cdr << llh_[GEO_HGT];
-    cdr << llh_velocity_[GEO_LAT];
-    cdr << llh_velocity_[GEO_LON];
-    cdr << llh_velocity_[GEO_HGT];
+    cdr.write_double_array(llh_.tuple_, 3);
+    cdr.write_double_array(llh_velocity_.tuple_, 3);
 
     cdr << when_;
 
@@ -183,9 +173,7 @@ Track::write(ACE_OutputCDR& cdr) const
     cdr << extractionNum_;
 
     // most recent prediction
-    cdr << llh_prediction_[GEO_LAT];
-    cdr << llh_prediction_[GEO_LON];
-    cdr << llh_prediction_[GEO_HGT];
+    cdr.write_double_array(llh_prediction_.tuple_, 3);
     cdr << predictionTime_;
 
     cdr << flags_;
@@ -35,7 +35,7 @@ public:
         }
         double operator[](size_t index) const { return tuple_[index]; }
         double& operator[](size_t index) { return tuple_[index]; }
-        double tuple_[3];
+        double tuple_[3]; ///< Values in GEO_LAT, GEO_LON, GEO_HGT order, streamed as one CDR array
     };
 
     enum Flags { kDropping = 1, kNew, kPromoted, kNeedsPrediction, kNeedsCorrection, kPredicted, kCorrected };
@@ -1,4 +1,5 @@
 #include <cmath>
+#include <cstddef>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -8,17 +9,19 @@
 
 using namespace SideCar::Messages;
 
+static_assert(offsetof(VMEHeader, temp3) == offsetof(VMEHeader, msgSize) + 7 * 4,
+              "VMEHeader uint32_t fields must be contiguous");
+static_assert(offsetof(VMEDataMessage, rangeFactor) == offsetof(VMEDataMessage, rangeMin) + 8,
+              "VMEDataMessage double fields must be contiguous");
+static_assert(offsetof(VMEDataMessage, numSamples) == offsetof(VMEDataMessage, temp1) + 3 * 4,
+              "VMEDataMessage uint32_t fields must be contiguous");
+
 ACE_InputCDR&
 VMEHeader::load(ACE_InputCDR& cdr)
 {
-    cdr >> msgSize;
-    cdr >> msgDesc;
-    cdr >> timeStamp;
-    cdr >> azimuth;
-    cdr >> pri;
-    cdr >> temp1;
-    cdr >> temp2;
-    cdr >> temp3;
+    // Read the run of uint32_t fields as one array, which is a single copy when the byte order matches.
+    //
+    cdr.read_ulong_array(&msgSize, 8);
     cdr >> irigTime;
     return cdr;
 }
@@ -26,14 +29,7 @@ VMEHeader::load(ACE_InputCDR& cdr)
 ACE_OutputCDR&
 VMEHeader::write(ACE_OutputCDR& cdr) const
 {
-    cdr << msgSize;
-    cdr << msgDesc;
-    cdr << timeStamp;
-    cdr << azimuth;
-    cdr << pri;
-    cdr << temp1;
-    cdr << temp2;
-    cdr << temp3;
+    cdr.write_ulong_array(&msgSize, 8);
     cdr << irigTime;
     return cdr;
 }
@@ -60,12 +56,8 @@ ACE_InputCDR&
 VMEDataMessage::load(ACE_InputCDR& cdr)
 {
     cdr >> header;
-    cdr >> rangeMin;
-    cdr >> rangeFactor;
-    cdr >> temp1;
-    cdr >> temp2;
-    cdr >> temp3;
-    cdr >> numSamples;
+    cdr.read_double_array(&rangeMin, 2);
+    cdr.read_ulong_array(&temp1, 4);
     return cdr;
 }
 
@@ -73,12 +65,8 @@ ACE_OutputCDR&
 VMEDataMessage::write(ACE_OutputCDR& cdr) const
 {
     cdr << header;
-    cdr << rangeMin;
-    cdr << rangeFactor;
-    cdr << temp1;
-    cdr << temp2;
-    cdr << temp3;
-    cdr << numSamples;
+    cdr.write_double_array(&rangeMin, 2);
+    cdr.write_ulong_array(&temp1, 4);
     return cdr;
 }
 
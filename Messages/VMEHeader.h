@@ -36,6 +36,9 @@ struct VMEHeader : public IO::CDRStreamable<VMEHeader>, public IO::Printable<VME
     ACE_OutputCDR& write(ACE_OutputCDR& cdr) const;
     std::ostream& print(std::ostream& os) const;
 
+    // NOTE: load() and write() move the uint32_t fields below as one array, so they must stay together and in
+    // this order.
+    //
     uint32_t msgSize;   // Size of the data message
     uint32_t msgDesc;   // Describes the message
     uint32_t timeStamp; // Hires timestamp from TG card if available
@@ -52,6 +55,8 @@ struct VMEDataMessage : public IO::CDRStreamable<VMEDataMessage>, public IO::Pri
     ACE_OutputCDR& write(ACE_OutputCDR& cdr) const;
     std::ostream& print(std::ostream& os) const;
 
+    // NOTE: load() and write() move the double and uint32_t runs below as arrays.
+    //
     VMEHeader header;
     double rangeMin;    // Range of first gate
     double rangeFactor; // Range change between gates
@@ -23,6 +23,8 @@
 #include "Configuration/RunnerConfig.h"
 #include "GUI/LogUtils.h"
 #include "IO/ClearStatsRequest.h"
+#include "IO/LatencyStats.h"
+#include "IO/MetricsSegment.h"
 #include "IO/ParametersChangeRequest.h"
 #include "IO/ProcessingStateChangeRequest.h"
 #include "IO/RecordingStateChangeRequest.h"
@@ -51,7 +53,9 @@ const std::string about = "SideCar application that creates and manages one or m
 
 const Utils::CmdLineArgs::OptionDef options[] = {{'d', "debug", "turn on verbose debugging", 0},
                                                  {'L', "logger", "use LOG for logging configuration", "LOG"},
-                                                 {'Q', "daq", "setup for data acquisition mode", 0}};
+                                                 {'Q', "daq", "setup for data acquisition mode", 0},
+                                                 {'l', "latency", "write message latencies to FILE at exit", "FILE"},
+                                                 {'a', "async-log", "write log messages from a background thread", 0}};
 
 const Utils::CmdLineArgs::ArgumentDef args[] = {{"NAME", "Runner to startup"}, {"CONFIG", "Configuration file"}};
 
@@ -80,7 +84,8 @@ quit(int sig)
 
 App::App(int argc, char* const* argv) :
     cla_(argc, argv, about, options, sizeof(options), args, sizeof(args)), logCollector_(LogCollector::Make()),
-    loggerConfig_(), streams_(), remoteController_(), statusEmitter_(), loader_(), runnerConfig_()
+    loggerConfig_(), streams_(), remoteController_(), statusEmitter_(), loader_(), runnerConfig_(),
+    cpuPlacer_(Utils::CpuTopology::Instance()), threadPlacement_(), latencyReportPath_()
 {
     Logger::Log::Root().addWriter(logCollector_);
     Logger::ProcLog log("App", Log());
@@ -178,6 +183,14 @@ App::initialize()
         loggerConfig_->startMonitor(10);
     }
 
+    // Keep processing threads from waiting on log writers. Must happen before the streams start their threads.
+    //
+    if (cla_.hasOpt("async-log")) Logger::Log::SetAsynchronous(true);
+
+    // Latency tracing must be on before any task sends a message.
+    //
+    if (cla_.hasOpt("latency", latencyReportPath_)) IO::LatencyStats::SetEnabled(true);
+
     // Load XML configuration file
     //
     if (!loader_.load(QString::fromStdString(cla_.arg(1)))) {
@@ -226,6 +239,12 @@ App::initialize()
     statusEmitter_ = StatusEmitter::Make(*this);
     statusEmitter_->open(THR_INHERIT_SCHED, 0);
 
+    // Publish live task metrics for tools such as sidecar-top. The runner works without them.
+    //
+    IO::MetricsSegment::Ref metrics(IO::MetricsSegment::Create(IO::MetricsSegment::MakeName(name)));
+    if (!metrics) LOGWARNING << "live task metrics are not available" << std::endl;
+    IO::MetricsSegment::SetInstance(metrics);
+
     std::string multicastAddress = runnerConfig_->getMulticastAddress().toStdString();
     foreach (QDomElement stream, runnerConfig_->getStreamNodes()) {
         streams_.push_back(StreamBuilder::Make(stream, statusEmitter_, multicastAddress));
@@ -261,8 +280,24 @@ App::run()
 
     remoteController_->stop();
 
+    if (!latencyReportPath_.empty()) writeLatencyReport();
+
     for (auto v : streams_) v->close();
     streams_.clear();
+    IO::MetricsSegment::SetInstance(IO::MetricsSegment::Ref());
+}
+
+void
+App::writeLatencyReport() const
+{
+    Logger::ProcLog log("writeLatencyReport", Log());
+    std::ofstream os(latencyReportPath_.c_str());
+    for (auto v : streams_) v->writeLatencyReport(os);
+    if (!os) {
+        LOGERROR << "failed to write latency report to " << latencyReportPath_ << std::endl;
+    } else {
+        LOGWARNING << "wrote latency report to " << latencyReportPath_ << std::endl;
+    }
 }
 
 void
@@ -353,7 +388,19 @@ App::fillStatus(XmlRpc::XmlRpcValue& status)
 #endif
 
     RunnerStatus::Make(status, *runnerConfig_, std::move(streamStatusArray), std::move(logCollector_->dump()),
-                       memoryUsed);
+                       memoryUsed, threadPlacement_);
+}
+
+void
+App::addThreadPlacement(const std::string& taskName, int cpu)
+{
+    Logger::ProcLog log("addThreadPlacement", Log());
+    LOGWARNING << taskName << " cpu: " << cpu << std::endl;
+
+    std::ostringstream os;
+    if (!threadPlacement_.empty()) os << ' ';
+    os << taskName << ':' << cpu;
+    threadPlacement_ += os.str();
 }
 
 void
@@ -395,18 +442,11 @@ App::setParameters(int streamIndex, int taskIndex, const XmlRpc::XmlRpcValue& pa
     IO::Stream::Ref stream(streams_[streamIndex]);
     IO::Task::Ref task(stream->getTask(taskIndex));
     LOGINFO << "task: " << task->getTaskName() << std::endl;
-    IO::ParametersChangeRequest request(params, false);
-    ACE_Message_Block* data = request.getWrapped();
 
-    // !!! Place the parameter change message at the front of the queue, so that it will take place before other
-    // !!! data messages.
+    // Deliver through the task's control path, so that a Controller applies the change from its control lane
+    // ahead of waiting data messages and records its latency.
     //
-    if (task->msg_queue()->enqueue_head(data) == -1) {
-        data->release();
-        return false;
-    }
-
-    return true;
+    return task->injectControlMessage(IO::ParametersChangeRequest(params, false));
 }
 
 void
@@ -10,6 +10,7 @@
 #include "IO/Stream.h"
 
 #include "Utils/CmdLineArgs.h"
+#include "Utils/CpuTopology.h"
 
 class QFile;
 
@@ -203,6 +204,21 @@ public:
     */
     size_t getStreamCount() const { return streams_.size(); }
 
+    /** Obtain the object that hands out processors to tasks of streams with automatic thread placement. Shared
+        by all of the streams so that they do not pile up on the same processors.
+
+        \return placer reference
+    */
+    Utils::CpuPlacer& getCpuPlacer() { return cpuPlacer_; }
+
+    /** Record the processor chosen for a task, for reporting in the runner status.
+
+        \param taskName name of the task
+
+        \param cpu processor the task threads are bound to
+    */
+    void addThreadPlacement(const std::string& taskName, int cpu);
+
     /** Change the runner's service name. Called when there is a naming conflict with another runner.
 
         \param name new name to use
@@ -212,6 +228,8 @@ public:
 private:
     void initializeRealTime(const QString& scheduler);
 
+    void writeLatencyReport() const;
+
     Utils::CmdLineArgs cla_;
     boost::shared_ptr<LogCollector> logCollector_;
     std::unique_ptr<Logger::ConfiguratorFile> loggerConfig_;
@@ -220,6 +238,9 @@ private:
     boost::shared_ptr<StatusEmitter> statusEmitter_;
     Configuration::Loader loader_;
     std::unique_ptr<Configuration::RunnerConfig> runnerConfig_;
+    Utils::CpuPlacer cpuPlacer_;
+    std::string threadPlacement_;
+    std::string latencyReportPath_;
 #ifdef linux
     std::string statmPath_;
 #endif
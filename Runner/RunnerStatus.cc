@@ -10,7 +10,8 @@ using namespace SideCar::Runner;
 void
 RunnerStatus::Make(XmlRpc::XmlRpcValue& status, const RunnerConfig& runnerConfig,
                    std::unique_ptr<XmlRpc::XmlRpcValue::ValueArray> streamStatus,
-                   std::unique_ptr<XmlRpc::XmlRpcValue::ValueArray> logMessages, double memoryUsed)
+                   std::unique_ptr<XmlRpc::XmlRpcValue::ValueArray> logMessages, double memoryUsed,
+                   const std::string& threadPlacement)
 {
     StatusBase::Make(status, kNumSlots, GetClassName(), runnerConfig.getRunnerName().toStdString());
     status[kConfigName] = runnerConfig.getConfigurationName().toStdString();
@@ -20,4 +21,5 @@ RunnerStatus::Make(XmlRpc::XmlRpcValue& status, const RunnerConfig& runnerConfig
     status[kStreamStatus] = streamStatus.release();
     status[kLogMessages] = logMessages.release();
     status[kMemoryUsed] = memoryUsed;
+    status[kThreadPlacement] = threadPlacement;
 }
@@ -26,6 +26,7 @@ public:
         kStreamStatus,
         kLogMessages,
         kMemoryUsed,
+        kThreadPlacement,
         kNumSlots
     };
 
@@ -33,7 +34,8 @@ public:
 
     static void Make(XmlRpc::XmlRpcValue& status, const Configuration::RunnerConfig& runnerConfig,
                      std::unique_ptr<XmlRpc::XmlRpcValue::ValueArray> streamStatus,
-                     std::unique_ptr<XmlRpc::XmlRpcValue::ValueArray> logMessages, double memoryUsed);
+                     std::unique_ptr<XmlRpc::XmlRpcValue::ValueArray> logMessages, double memoryUsed,
+                     const std::string& threadPlacement);
 
     RunnerStatus(const XmlRpc::XmlRpcValue& status) : IO::StatusBase(status) {}
 
@@ -52,6 +54,13 @@ public:
     const XmlRpc::XmlRpcValue& getLogMessages() const { return getSlot(kLogMessages); }
 
     double getMemoryUsed() const { return getSlot(kMemoryUsed); }
+
+    /** Obtain the processors chosen for tasks by automatic thread placement, as space-separated "task:cpu"
+        entries.
+
+        \return placement description, empty if no stream uses automatic placement
+    */
+    std::string getThreadPlacement() const { return getSlot(kThreadPlacement); }
 };
 
 } // end namespace Runner
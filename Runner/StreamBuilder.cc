@@ -1,16 +1,21 @@
 #include "boost/bind.hpp"
+#include <net/if.h>
 #include <unistd.h>
 
 #include "Algorithms/Controller.h"
 #include "Algorithms/ShutdownMonitor.h"
 #include "GUI/LogUtils.h"
+#include "IO/Executor.h"
 #include "IO/FileReaderTask.h"
 #include "IO/FileWriterTask.h"
+#include "IO/MetricsSegment.h"
 #include "IO/MulticastDataPublisher.h"
 #include "IO/MulticastDataSubscriber.h"
 #include "IO/MulticastVMEReaderTask.h"
 #include "IO/ParametersChangeRequest.h"
 #include "IO/ProcessingStateChangeRequest.h"
+#include "IO/ShmDataPublisher.h"
+#include "IO/ShmDataSubscriber.h"
 #include "IO/TCPDataPublisher.h"
 #include "IO/TCPDataSubscriber.h"
 #include "IO/TSPIReaderTask.h"
@@ -25,6 +30,7 @@
 
 #include "IO/UDPSocketReaderTask.h"
 #include "IO/UDPSocketWriterTask.h"
+#include "Utils/CpuTopology.h"
 #include "XMLRPC/XmlRpcValue.h"
 
 #include "App.h"
@@ -62,6 +68,17 @@ StreamBuilder::Make(const QDomElement& stream, const StatusEmitter::Ref& statusE
 
     StreamBuilder builder(name, statusEmitter, mcastAddress);
 
+    // With placement="auto", bind task threads to processors based on the host topology.
+    //
+    QString placement(stream.attribute("placement"));
+    if (placement == "auto") {
+        builder.autoPlacement_ = true;
+    } else if (!placement.isEmpty() && placement != "none") {
+        Utils::Exception ex("invalid placement for stream - ");
+        ex << placement.toStdString();
+        log.thrower(ex);
+    }
+
     QDomElement def = stream.firstChildElement();
     while (!def.isNull()) {
         QString type = def.nodeName();
@@ -107,6 +124,18 @@ StreamBuilder::release()
         needShutdownMonitor_ = false;
     }
 
+    if (autoPlacement_) placeThreads();
+
+    // Give each task a slot for its live metrics, in stream order.
+    //
+    const IO::MetricsSegment::Ref& metrics(IO::MetricsSegment::GetInstance());
+    if (metrics) {
+        for (IO::Module* module : modules_) {
+            IO::Task::Ref task = module->getTask();
+            task->setMetricsSegment(metrics, stream_->getName() + '/' + task->getTaskName());
+        }
+    }
+
     // The XML nodes for a stream appear in top-down fashion, but ACE::Stream pushes tasks in bottom-up fashion.
     //
     for (std::vector<IO::Module*>::reverse_iterator pos = modules_.rbegin(); pos != modules_.rend(); ++pos) {
@@ -134,9 +163,39 @@ StreamBuilder::addModule(const QDomElement& xml, IO::Module* module)
     LOGINFO << std::endl;
     IO::Task::Ref task(module->getTask());
     task->setTaskIndex(modules_.size());
+    setQueuePolicy(xml, *task);
     registerOutputs(xml, task);
     connectInputs(xml, task);
     modules_.push_back(module);
+    nodes_.push_back(-1);
+}
+
+void
+StreamBuilder::setInterfaceNode(uint32_t interface)
+{
+    Logger::ProcLog log("setInterfaceNode", Log());
+
+    char name[IF_NAMESIZE];
+    if (!interface || nodes_.empty() || !::if_indextoname(interface, name)) return;
+    nodes_.back() = Utils::CpuTopology::Instance().getInterfaceNode(name);
+    LOGINFO << name << " node: " << nodes_.back() << std::endl;
+}
+
+void
+StreamBuilder::placeThreads()
+{
+    Logger::ProcLog log("placeThreads", Log());
+
+    Utils::CpuPlacer& placer(App::GetApp()->getCpuPlacer());
+    for (size_t index = 0; index < modules_.size(); ++index) {
+        IO::Task::Ref task = modules_[index]->getTask();
+        if (!task->thr_count()) continue;
+        IO::Task::ThreadParams params(task->getThreadParams());
+        params.cpuAffinity = placer.next(nodes_[index]);
+        if (params.cpuAffinity == -1) break;
+        task->setThreadParams(params);
+        App::GetApp()->addThreadPlacement(stream_->getName() + '/' + task->getTaskName(), params.cpuAffinity);
+    }
 }
 
 void
@@ -307,6 +366,136 @@ StreamBuilder::getBufferSize(const QDomElement& xml, int defaultValue) const
     return bufferSize;
 }
 
+void
+StreamBuilder::setOverflowPolicy(const QDomElement& xml, IO::TCPDataPublisher& publisher) const
+{
+    Logger::ProcLog log("setOverflowPolicy", Log());
+
+    IO::ServerSocketWriterTask::OverflowPolicy policy;
+    if (xml.hasAttribute("overflowPolicy")) {
+        if (!IO::ServerSocketWriterTask::OverflowPolicy::GetAction(xml.attribute("overflowPolicy").toStdString(),
+                                                                    policy.action)) {
+            Utils::Exception ex("invalid overflowPolicy for publisher - ");
+            ex << xml.attribute("overflowPolicy").toStdString();
+            log.thrower(ex);
+        }
+    }
+
+    if (xml.hasAttribute("queueLimit")) {
+        bool ok;
+        policy.queueLimit = xml.attribute("queueLimit").toUInt(&ok);
+        if (!ok || !policy.queueLimit) {
+            Utils::Exception ex("invalid queueLimit for publisher - ");
+            ex << xml.attribute("queueLimit").toStdString();
+            log.thrower(ex);
+        }
+    }
+
+    if (xml.hasAttribute("decimation")) {
+        bool ok;
+        policy.decimation = xml.attribute("decimation").toUInt(&ok);
+        if (!ok || !policy.decimation) {
+            Utils::Exception ex("invalid decimation for publisher - ");
+            ex << xml.attribute("decimation").toStdString();
+            log.thrower(ex);
+        }
+    }
+
+    publisher.setOverflowPolicy(policy);
+}
+
+void
+StreamBuilder::setQueuePolicy(const QDomElement& xml, IO::Task& task) const
+{
+    Logger::ProcLog log("setQueuePolicy", Log());
+
+    if (!xml.hasAttribute("queuePolicy") && !xml.hasAttribute("queueCapacity")) return;
+
+    IO::Task::QueuePolicy policy;
+    if (xml.hasAttribute("queuePolicy")) {
+        if (!IO::Task::QueuePolicy::GetAction(xml.attribute("queuePolicy").toStdString(), policy.action)) {
+            Utils::Exception ex("invalid queuePolicy for task - ");
+            ex << xml.attribute("queuePolicy").toStdString();
+            log.thrower(ex);
+        }
+    }
+
+    bool ok;
+    policy.capacity = xml.attribute("queueCapacity").toUInt(&ok);
+    if (!ok || !policy.capacity) {
+        Utils::Exception ex("invalid or missing queueCapacity for task - ");
+        ex << xml.attribute("queueCapacity").toStdString();
+        log.thrower(ex);
+    }
+
+    if (xml.hasAttribute("keepEvery")) {
+        policy.keepEvery = xml.attribute("keepEvery").toUInt(&ok);
+        if (!ok || !policy.keepEvery) {
+            Utils::Exception ex("invalid keepEvery for task - ");
+            ex << xml.attribute("keepEvery").toStdString();
+            log.thrower(ex);
+        }
+    }
+
+    task.setQueuePolicy(policy);
+}
+
+IO::SubscriptionRequest
+StreamBuilder::getSubscriptionRequest(const QDomElement& xml) const
+{
+    Logger::ProcLog log("getSubscriptionRequest", Log());
+
+    IO::SubscriptionRequest request;
+    if (xml.hasAttribute("reduction") &&
+        !IO::SubscriptionRequest::Parse(xml.attribute("reduction").toStdString(), request)) {
+        Utils::Exception ex("invalid reduction for subscriber - ");
+        ex << xml.attribute("reduction").toStdString();
+        log.thrower(ex);
+    }
+
+    return request;
+}
+
+Algorithms::ReplicaConfig
+StreamBuilder::getReplicaConfig(const QDomElement& xml) const
+{
+    Logger::ProcLog log("getReplicaConfig", Log());
+
+    Algorithms::ReplicaConfig config;
+    if (xml.hasAttribute("sharding")) {
+        QString sharding(xml.attribute("sharding"));
+        if (sharding == "roundrobin") {
+            config.sharding = Algorithms::ReplicaConfig::kRoundRobin;
+        } else if (sharding == "azimuth") {
+            config.sharding = Algorithms::ReplicaConfig::kAzimuth;
+        } else {
+            Utils::Exception ex("invalid sharding for algorithm - ");
+            ex << sharding.toStdString();
+            log.thrower(ex);
+        }
+    }
+
+    auto getCount = [&](const char* name, size_t& value, bool zeroOK) {
+        if (xml.hasAttribute(name)) {
+            bool ok;
+            value = xml.attribute(name).toUInt(&ok);
+            if (!ok || (!value && !zeroOK)) {
+                Utils::Exception ex("invalid ");
+                ex << name << " for algorithm - " << xml.attribute(name).toStdString();
+                log.thrower(ex);
+            }
+        }
+    };
+
+    getCount("replicas", config.count, false);
+    getCount("block", config.blockSize, false);
+    getCount("sectors", config.sectors, false);
+    getCount("overlap", config.overlap, true);
+
+    LOGINFO << "replicas: " << config.count << std::endl;
+    return config;
+}
+
 uint32_t
 StreamBuilder::getInterfaceIndex(const QDomElement& xml) const
 {
@@ -377,10 +566,15 @@ StreamBuilder::makeAlgorithm(const QDomElement& xml)
 
     long threadFlags = getThreadFlags(xml.attribute(kScheduler));
     long threadPriority = getThreadPriority(xml.attribute(kThreadPriority));
+    // The 'threaded' attribute selects where the algorithm runs: "false" or "0" for the main thread, "pool" for
+    // the runner's shared IO::Executor, and anything else for a thread of its own.
+    //
     bool threaded = true;
+    bool pooled = false;
     if (xml.hasAttribute(kThreaded)) {
         QString tmp = xml.attribute(kThreaded);
         if (tmp == "false" || tmp == "0") threaded = false;
+        if (tmp == "pool") pooled = true;
     }
 
     Algorithms::ControllerModule* module = new Algorithms::ControllerModule(stream_);
@@ -397,6 +591,8 @@ StreamBuilder::makeAlgorithm(const QDomElement& xml)
     }
 
     controller->setXMLDefinition(xml);
+    if (pooled) controller->setExecutor(&IO::Executor::Instance());
+    controller->setReplicas(getReplicaConfig(xml));
 
     if (!controller->openAndInit(dll.toStdString(), name.toStdString(), 0, threadFlags, threadPriority, threaded)) {
         Utils::Exception ex("unable to open controller for ");
@@ -541,6 +737,8 @@ StreamBuilder::makeDataPublisher(const QDomElement& xml)
         makeMulticastDataPublisher(xml, name, type, interface);
     } else if (transport == "tcp") {
         makeTCPDataPublisher(xml, name, type, interface);
+    } else if (transport == "shm") {
+        makeShmDataPublisher(xml, name, type, interface);
     } else if (transport == "udp") {
         makeUDPWriter(xml, name, type, interface);
     } else {
@@ -573,6 +771,42 @@ StreamBuilder::makeMulticastDataPublisher(const QDomElement& xml, const std::str
         connectInput(publisher, realType, "", xml.attribute("channel").toStdString());
     }
 
+    if (xml.hasAttribute("maxDatagramSize")) {
+        bool ok;
+        size_t maxDatagramSize = xml.attribute("maxDatagramSize").toUInt(&ok);
+        if (!ok) {
+            Utils::Exception ex("invalid maxDatagramSize for 'multicast publisher' - ");
+            ex << xml.attribute("maxDatagramSize").toStdString();
+            log.thrower(ex);
+        }
+
+        publisher->setMaxDatagramSize(maxDatagramSize);
+    }
+
+    // Optional retransmission of lost messages. The attribute value is the number of messages to keep.
+    //
+    if (xml.hasAttribute("reliable")) {
+        bool ok;
+        size_t bufferCount = xml.attribute("reliable").toUInt(&ok);
+        if (!ok || !bufferCount) {
+            Utils::Exception ex("invalid reliable count for 'multicast publisher' - ");
+            ex << xml.attribute("reliable").toStdString();
+            log.thrower(ex);
+        }
+
+        size_t retransmitRate = IO::MulticastDataPublisher::kDefaultRetransmitRate;
+        if (xml.hasAttribute("retransmitRate")) {
+            retransmitRate = xml.attribute("retransmitRate").toUInt(&ok);
+            if (!ok) {
+                Utils::Exception ex("invalid retransmitRate for 'multicast publisher' - ");
+                ex << xml.attribute("retransmitRate").toStdString();
+                log.thrower(ex);
+            }
+        }
+
+        publisher->setReliable(bufferCount, retransmitRate);
+    }
+
     if (!publisher->openAndInit(realType, name, mcastAddress_, threadFlags, threadPriority)) {
         Utils::Exception ex("unable to open multicast data publisher named ");
         ex << name;
@@ -620,6 +854,8 @@ StreamBuilder::makeTCPDataPublisher(const QDomElement& xml, const std::string& n
         connectInput(publisher, realType, "", xml.attribute("channel").toStdString());
     }
 
+    setOverflowPolicy(xml, *publisher);
+
     if (!publisher->openAndInit(realType, name, port, bufferSize, threadFlags, threadPriority)) {
         Utils::Exception ex("unable to open TCP data publisher named ");
         ex << name;
@@ -627,6 +863,61 @@ StreamBuilder::makeTCPDataPublisher(const QDomElement& xml, const std::string& n
     }
 }
 
+void
+StreamBuilder::makeShmDataPublisher(const QDomElement& xml, const std::string& name, const std::string& type,
+                                    uint32_t interface)
+{
+    Logger::ProcLog log("makeShmDataPublisher", Log());
+    LOGINFO << name << ' ' << type << ' ' << interface << std::endl;
+
+    int bufferSize = getBufferSize(xml, 0);
+    long threadFlags = getThreadFlags(xml.attribute(kScheduler));
+    long threadPriority = getThreadPriority(xml.attribute(kThreadPriority));
+
+    IO::ShmDataPublisherModule* module = new IO::ShmDataPublisherModule(stream_);
+    addModule(xml, module);
+    IO::ShmDataPublisher::Ref publisher = module->getTask();
+
+    if (interface) { publisher->setInterface(interface); }
+
+    uint16_t port = 0;
+    if (xml.hasAttribute("port")) {
+        bool ok;
+        port = xml.attribute("port").toInt(&ok);
+        if (!ok) {
+            Utils::Exception ex("invalid port for 'shm publisher' - ");
+            ex << xml.attribute("port").toStdString();
+            log.thrower(ex);
+        }
+    }
+
+    size_t ringSize = IO::ShmDataPublisher::kDefaultRingSize;
+    if (xml.hasAttribute("ringSize")) {
+        bool ok;
+        ringSize = xml.attribute("ringSize").toUInt(&ok);
+        if (!ok) {
+            Utils::Exception ex("invalid ringSize for 'shm publisher' - ");
+            ex << xml.attribute("ringSize").toStdString();
+            log.thrower(ex);
+        }
+    }
+
+    // If the publisher does not define an input channel, create one for it, and link to the previous task.
+    //
+    std::string realType(type);
+    if (publisher->getNumInputChannels() == 0) {
+        connectInput(publisher, realType, "", xml.attribute("channel").toStdString());
+    }
+
+    setOverflowPolicy(xml, *publisher);
+
+    if (!publisher->openAndInit(realType, name, port, bufferSize, ringSize, threadFlags, threadPriority)) {
+        Utils::Exception ex("unable to open shm data publisher named ");
+        ex << name;
+        log.thrower(ex);
+    }
+}
+
 void
 StreamBuilder::makeDataSubscriber(const QDomElement& xml)
 {
@@ -652,7 +943,7 @@ StreamBuilder::makeDataSubscriber(const QDomElement& xml)
 
     if (transport == "multicast") {
         makeMulticastDataSubscriber(xml, name, type, interface);
-    } else if (transport == "tcp") {
+    } else if (transport == "tcp" || transport == "shm") {
         makeTCPDataSubscriber(xml, name, type, interface);
     } else if (transport == "udp") {
         makeUDPReader(xml, name, type, interface);
@@ -661,6 +952,8 @@ StreamBuilder::makeDataSubscriber(const QDomElement& xml)
         ex << transport;
         log.thrower(ex);
     }
+
+    setInterfaceNode(interface);
 }
 
 void
@@ -677,6 +970,7 @@ StreamBuilder::makeMulticastDataSubscriber(const QDomElement& xml, const std::st
     IO::MulticastDataSubscriberModule* module = new IO::MulticastDataSubscriberModule(stream_);
     addModule(xml, module);
     IO::MulticastDataSubscriber::Ref subscriber = module->getTask();
+    subscriber->setSubscriptionRequest(getSubscriptionRequest(xml));
 
     // If the subscriber does not define an output channel, create one for it,
     //
@@ -699,10 +993,16 @@ StreamBuilder::makeTCPDataSubscriber(const QDomElement& xml, const std::string&
     LOGINFO << name << ' ' << type << ' ' << interface << std::endl;
 
     int bufferSize = getBufferSize(xml, 0);
+    long threadFlags = getThreadFlags(xml.attribute(kScheduler));
+    long threadPriority = getThreadPriority(xml.attribute(kThreadPriority));
 
-    IO::TCPDataSubscriberModule* module = new IO::TCPDataSubscriberModule(stream_);
+    // A ShmDataSubscriber is a TCPDataSubscriber that switches to a shared memory ring when the publisher offers
+    // one on this host.
+    //
+    IO::ShmDataSubscriberModule* module = new IO::ShmDataSubscriberModule(stream_);
     addModule(xml, module);
-    IO::TCPDataSubscriber::Ref subscriber = module->getTask();
+    IO::ShmDataSubscriber::Ref subscriber = module->getTask();
+    subscriber->setSubscriptionRequest(getSubscriptionRequest(xml));
 
     // If the subscriber does not define an output channel, create one for it,
     //
@@ -710,7 +1010,7 @@ StreamBuilder::makeTCPDataSubscriber(const QDomElement& xml, const std::string&
         registerOutput(subscriber, type, "", xml.attribute("channel").toStdString());
     }
 
-    if (!subscriber->openAndInit(type, name, bufferSize, interface)) {
+    if (!subscriber->openAndInit(type, name, bufferSize, interface, threadFlags, threadPriority)) {
         Utils::Exception ex("unable to subscribe to ");
         ex << name;
         log.thrower(ex);
@@ -822,6 +1122,7 @@ StreamBuilder::makeVMEReader(const QDomElement& xml)
 
     IO::MulticastVMEReaderTaskModule* module = new IO::MulticastVMEReaderTaskModule(stream_);
     addModule(xml, module);
+    setInterfaceNode(getInterfaceIndex(xml));
     IO::MulticastVMEReaderTask::Ref reader = module->getTask();
 
     if (reader->getNumOutputChannels() == 0) {
@@ -857,6 +1158,7 @@ StreamBuilder::makeTSPIReader(const QDomElement& xml)
 
     IO::TSPIReaderTaskModule* module = new IO::TSPIReaderTaskModule(stream_);
     addModule(xml, module);
+    setInterfaceNode(getInterfaceIndex(xml));
     IO::TSPIReaderTask::Ref reader = module->getTask();
 
     if (reader->getNumOutputChannels() == 0) {
@@ -14,8 +14,13 @@ class Log;
 }
 
 namespace SideCar {
+namespace Algorithms {
+struct ReplicaConfig;
+}
 namespace IO {
 class Module;
+struct SubscriptionRequest;
+class TCPDataPublisher;
 }
 namespace Runner {
 
@@ -42,8 +47,8 @@ private:
         \param name the name of the stream
     */
     StreamBuilder(const std::string& name, const StatusEmitter::Ref& emitter, const std::string& mcastAddress) :
-        stream_(IO::Stream::Make(name, emitter)), modules_(), channels_(), mcastAddress_(mcastAddress),
-        needShutdownMonitor_(false)
+        stream_(IO::Stream::Make(name, emitter)), modules_(), nodes_(), channels_(), mcastAddress_(mcastAddress),
+        needShutdownMonitor_(false), autoPlacement_(false)
     {
     }
 
@@ -84,6 +89,9 @@ private:
     void makeTCPDataPublisher(const QDomElement& xml, const std::string& name, const std::string& type,
                               uint32_t interface);
 
+    void makeShmDataPublisher(const QDomElement& xml, const std::string& name, const std::string& type,
+                              uint32_t interface);
+
     /** Create a new DataSubscriber task and add to the active stream.
 
         \param xml configuration information for the task
@@ -169,6 +177,51 @@ private:
     uint32_t getInterfaceIndex(const QDomElement& xml) const;
     int getBufferSize(const QDomElement& xml, int defaultValue = 0) const;
 
+    /** Apply any 'overflowPolicy', 'queueLimit', and 'decimation' attributes to a TCP publisher.
+
+        \param xml configuration for the publisher
+
+        \param publisher the publisher to configure
+    */
+    void setOverflowPolicy(const QDomElement& xml, IO::TCPDataPublisher& publisher) const;
+
+    /** Apply any 'queuePolicy', 'queueCapacity', and 'keepEvery' attributes to the input queue of a task.
+
+        \param xml configuration for the task
+
+        \param task the task to configure
+    */
+    void setQueuePolicy(const QDomElement& xml, IO::Task& task) const;
+
+    /** Obtain the data reduction asked for by a subscriber's 'reduction' attribute.
+
+        \param xml configuration for the subscriber
+
+        \return request found in the attribute, or one for everything if there is no attribute
+    */
+    IO::SubscriptionRequest getSubscriptionRequest(const QDomElement& xml) const;
+
+    /** Obtain the replica settings from the 'replicas', 'sharding', 'block', 'sectors', and 'overlap'
+        attributes of an algorithm.
+
+        \param xml configuration for the algorithm
+
+        \return replica settings, or ones for a single copy if there is no 'replicas' attribute
+    */
+    Algorithms::ReplicaConfig getReplicaConfig(const QDomElement& xml) const;
+
+    /** Note that the last task added reads from a network interface, so that automatic thread placement puts it
+        on a processor of the NUMA node of the interface.
+
+        \param interface index of the interface, or 0 if not known
+    */
+    void setInterfaceNode(uint32_t interface);
+
+    /** Bind the threads of each task to a processor, in stream order, so that adjacent tasks share a cache (see
+        Utils::CpuPlacer). Tasks without threads of their own are skipped.
+    */
+    void placeThreads();
+
     long getThreadFlags(const QString& scheduler) const;
 
     long getThreadPriority(const QString& attribute) const;
@@ -185,9 +238,11 @@ private:
 
     IO::Stream::Ref stream_;
     std::vector<IO::Module*> modules_;
+    std::vector<int> nodes_; ///< Preferred NUMA node for each of modules_, or -1
     ChannelMap channels_;
     std::string mcastAddress_;
     bool needShutdownMonitor_;
+    bool autoPlacement_;
 };
 
 } // end namespace Runner
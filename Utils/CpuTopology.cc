@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+#include "Logger/Log.h"
+
+#include "CpuTopology.h"
+
+using namespace Utils;
+
+/** Highest NUMA node and cache index numbers to look for.
+ */
+static const int kMaxNodes = 256;
+static const int kMaxCacheIndices = 16;
+
+Logger::Log&
+CpuTopology::Log()
+{
+    static Logger::Log& log_ = Logger::Log::Find("SideCar.Utils.CpuTopology");
+    return log_;
+}
+
+const CpuTopology&
+CpuTopology::Instance()
+{
+    static CpuTopology topology;
+    return topology;
+}
+
+bool
+CpuTopology::ParseList(const std::string& text, std::vector<int>& ids)
+{
+    std::vector<int> tmp;
+    std::istringstream is(text);
+    std::string range;
+    while (std::getline(is, range, ',')) {
+        std::istringstream rs(range);
+        int first, last;
+        char dash = 0;
+        if (!(rs >> first)) {
+            if (range.find_first_not_of(" \t\n") == std::string::npos) continue;
+            return false;
+        }
+
+        last = first;
+        if (rs >> dash && (dash != '-' || !(rs >> last) || last < first)) return false;
+        for (int id = first; id <= last; ++id) tmp.push_back(id);
+    }
+
+    ids.swap(tmp);
+    return true;
+}
+
+CpuTopology::CpuTopology(const std::string& root) : root_(root), cpus_()
+{
+    static Logger::ProcLog log("CpuTopology", Log());
+
+    std::string cpuRoot(root_ + "/devices/system/cpu/");
+    std::vector<int> ids;
+    if (!readList(cpuRoot + "online", ids) || ids.empty()) {
+        LOGWARNING << "no processor list in " << cpuRoot << std::endl;
+        ids.clear();
+        for (unsigned id = 0; id < std::max(std::thread::hardware_concurrency(), 1U); ++id) ids.push_back(id);
+    }
+
+    for (size_t index = 0; index < ids.size(); ++index) {
+        int id = ids[index];
+        std::ostringstream os;
+        os << cpuRoot << "cpu" << id << '/';
+        std::string path(os.str());
+
+        Cpu cpu;
+        cpu.id = id;
+        cpu.node = 0;
+        if (!readInt(path + "topology/physical_package_id", cpu.package)) cpu.package = 0;
+        if (!readInt(path + "topology/core_id", cpu.core)) cpu.core = id;
+
+        std::vector<int> siblings;
+        cpu.sibling = readList(path + "topology/thread_siblings_list", siblings) && !siblings.empty() &&
+                      *std::min_element(siblings.begin(), siblings.end()) != id;
+
+        // The last-level cache is the one with the highest level. Identify it by the first processor that
+        // shares it.
+        //
+        cpu.cache = id;
+        int bestLevel = 0;
+        for (int cacheIndex = 0; cacheIndex < kMaxCacheIndices; ++cacheIndex) {
+            std::ostringstream cs;
+            cs << path << "cache/index" << cacheIndex << '/';
+            int level;
+            std::vector<int> shared;
+            if (!readInt(cs.str() + "level", level)) break;
+            if (level > bestLevel && readList(cs.str() + "shared_cpu_list", shared) && !shared.empty()) {
+                bestLevel = level;
+                cpu.cache = *std::min_element(shared.begin(), shared.end());
+            }
+        }
+
+        cpus_.push_back(cpu);
+    }
+
+    for (int node = 0; node < kMaxNodes; ++node) {
+        std::ostringstream os;
+        os << root_ << "/devices/system/node/node" << node << "/cpulist";
+        std::vector<int> members;
+        if (!readList(os.str(), members)) continue;
+        for (size_t index = 0; index < members.size(); ++index) {
+            for (size_t inner = 0; inner < cpus_.size(); ++inner) {
+                if (cpus_[inner].id == members[index]) cpus_[inner].node = node;
+            }
+        }
+    }
+
+    for (size_t index = 0; index < cpus_.size(); ++index) {
+        const Cpu& cpu(cpus_[index]);
+        LOGINFO << "cpu: " << cpu.id << " node: " << cpu.node << " package: " << cpu.package << " core: " << cpu.core
+                << " cache: " << cpu.cache << " sibling: " << cpu.sibling << std::endl;
+    }
+}
+
+const CpuTopology::Cpu*
+CpuTopology::find(int id) const
+{
+    for (size_t index = 0; index < cpus_.size(); ++index) {
+        if (cpus_[index].id == id) return &cpus_[index];
+    }
+
+    return 0;
+}
+
+int
+CpuTopology::getInterfaceNode(const std::string& interfaceName) const
+{
+    int node;
+    if (interfaceName.empty() || !readInt(root_ + "/class/net/" + interfaceName + "/device/numa_node", node)) {
+        return -1;
+    }
+
+    return node;
+}
+
+std::vector<int>
+CpuTopology::getPipelineOrder(int node) const
+{
+    std::vector<Cpu> sorted(cpus_);
+    std::sort(sorted.begin(), sorted.end(), [node](const Cpu& lhs, const Cpu& rhs) {
+        return std::make_tuple(lhs.node != node, lhs.node, lhs.package, lhs.cache, lhs.sibling, lhs.core, lhs.id) <
+               std::make_tuple(rhs.node != node, rhs.node, rhs.package, rhs.cache, rhs.sibling, rhs.core, rhs.id);
+    });
+
+    std::vector<int> order;
+    for (size_t index = 0; index < sorted.size(); ++index) order.push_back(sorted[index].id);
+    return order;
+}
+
+bool
+CpuTopology::readInt(const std::string& path, int& value) const
+{
+    std::ifstream is(path.c_str());
+    return bool(is >> value);
+}
+
+bool
+CpuTopology::readList(const std::string& path, std::vector<int>& ids) const
+{
+    std::ifstream is(path.c_str());
+    std::string text;
+    return std::getline(is, text) && ParseList(text, ids);
+}
+
+CpuPlacer::CpuPlacer(const CpuTopology& topology) : topology_(topology), order_(), next_(0)
+{
+    ;
+}
+
+int
+CpuPlacer::next(int node)
+{
+    // The first stage decides which node the pipeline starts on.
+    //
+    if (order_.empty()) {
+        order_ = topology_.getPipelineOrder(node);
+        if (order_.empty()) return -1;
+    }
+
+    size_t index = next_ % order_.size();
+    if (node != -1) {
+        for (size_t offset = 0; offset < order_.size(); ++offset) {
+            size_t candidate = (next_ + offset) % order_.size();
+            const CpuTopology::Cpu* cpu = topology_.find(order_[candidate]);
+            if (cpu && cpu->node == node) {
+                index = candidate;
+                break;
+            }
+        }
+    }
+
+    next_ = index + 1;
+    return order_[index];
+}
@@ -0,0 +1,130 @@
+#ifndef UTILS_CPUTOPOLOGY_H // -*- C++ -*-
+#define UTILS_CPUTOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+namespace Logger {
+class Log;
+}
+
+namespace Utils {
+
+/** Layout of the processors of the host: which NUMA node, socket, and last-level cache each one belongs to, and
+    which ones are the extra hardware threads (hyperthreads) of a core. Read from the Linux sysfs tree. On
+    systems without one, every processor looks like a core of its own on node 0.
+*/
+class CpuTopology {
+public:
+    /** Description of one processor.
+     */
+    struct Cpu {
+        int id;       ///< Processor number as used by sched_setaffinity()
+        int node;     ///< NUMA node
+        int package;  ///< Physical socket
+        int core;     ///< Core within the socket
+        int cache;    ///< Lowest numbered processor that shares the last-level cache with this one
+        bool sibling; ///< True if not the first hardware thread of its core
+    };
+
+    /** Log device for objects of this type.
+
+        \return log device
+    */
+    static Logger::Log& Log();
+
+    /** Obtain the topology of the host, read the first time it is needed.
+
+        \return topology reference
+    */
+    static const CpuTopology& Instance();
+
+    /** Parse a Linux processor list such as "0-3,8,10-11".
+
+        \param text the list to parse
+
+        \param ids storage for the processor numbers found
+
+        \return true if successful
+    */
+    static bool ParseList(const std::string& text, std::vector<int>& ids);
+
+    /** Constructor. Reads the topology from a sysfs tree.
+
+        \param root location of the sysfs tree. Something other than /sys is only useful for testing.
+    */
+    CpuTopology(const std::string& root = "/sys");
+
+    /** \return description of the processors, in processor number order
+     */
+    const std::vector<Cpu>& getCpus() const { return cpus_; }
+
+    /** Obtain the description of a processor.
+
+        \param id processor number
+
+        \return pointer to description, or NULL if there is no such processor
+    */
+    const Cpu* find(int id) const;
+
+    /** Obtain the NUMA node that a network interface is attached to.
+
+        \param interfaceName name of the interface, such as "eth0"
+
+        \return node, or -1 if unknown
+    */
+    int getInterfaceNode(const std::string& interfaceName) const;
+
+    /** Obtain an order of the processors in which neighbours share as much as possible: all of the processors of
+        a node come together, then all of those of a last-level cache within the node. Within a cache, the first
+        thread of each core comes before any of the sibling threads, so that a short pipeline gets cores of its
+        own.
+
+        \param node the NUMA node to start with, or -1 to start with the lowest one
+
+        \return processor numbers
+    */
+    std::vector<int> getPipelineOrder(int node = -1) const;
+
+private:
+    bool readInt(const std::string& path, int& value) const;
+
+    bool readList(const std::string& path, std::vector<int>& ids) const;
+
+    std::string root_;
+    std::vector<Cpu> cpus_;
+};
+
+/** Hands out processors to the threads of a processing pipeline, from the top of the pipeline to the bottom,
+    in CpuTopology::getPipelineOrder() order so that adjacent stages share a cache. A stage may ask for a
+    processor on a particular NUMA node, such as the one of the network interface it reads from. Once every
+    processor has a stage, they are handed out again from the start.
+*/
+class CpuPlacer {
+public:
+    /** Constructor.
+
+        \param topology the processors to hand out
+    */
+    CpuPlacer(const CpuTopology& topology);
+
+    /** Obtain the processor for the next stage.
+
+        \param node the NUMA node to use if possible, or -1 for no preference
+
+        \return processor number, or -1 if there are none
+    */
+    int next(int node = -1);
+
+private:
+    const CpuTopology& topology_;
+    std::vector<int> order_;
+    size_t next_;
+};
+
+} // end namespace Utils
+
+/** \file
+ */
+
+#endif
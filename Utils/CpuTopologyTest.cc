@@ -0,0 +1,228 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "CpuTopology.h"
+#include "UnitTest/UnitTest.h"
+
+using namespace Utils;
+
+/** Queue of integers passed between the stages of the benchmark pipeline.
+ */
+struct Queue {
+    Queue() : mutex(), ready(), values() {}
+
+    void push(int value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            values.push_back(value);
+        }
+
+        ready.notify_one();
+    }
+
+    int pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return !values.empty(); });
+        int value = values.front();
+        values.pop_front();
+        return value;
+    }
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<int> values;
+};
+
+struct Test : public UnitTest::TestObj {
+    Test() : UnitTest::TestObj("CpuTopology") {}
+
+    void test();
+
+    /** Write a file of the fake sysfs tree, creating directories as needed.
+     */
+    static void Write(const std::string& root, const std::string& path, const std::string& contents);
+
+    /** Pass messages down a pipeline with a thread per stage.
+
+        \param cpus the processor for each stage, or -1 to leave a stage unpinned
+
+        \return messages per second
+    */
+    static double RunPipeline(const std::vector<int>& cpus);
+
+    void testParseList();
+
+    void testTopology();
+
+    void testBenchmark();
+};
+
+void
+Test::Write(const std::string& root, const std::string& path, const std::string& contents)
+{
+    for (std::string::size_type pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        ::mkdir((root + path.substr(0, pos)).c_str(), 0755);
+    }
+
+    std::ofstream os((root + path).c_str());
+    os << contents << '\n';
+}
+
+double
+Test::RunPipeline(const std::vector<int>& cpus)
+{
+    enum { kCount = 20000 };
+    std::vector<Queue> queues(cpus.size() + 1);
+    std::vector<std::thread> threads;
+    for (size_t index = 0; index < cpus.size(); ++index) {
+        threads.emplace_back([&queues, &cpus, index]() {
+            if (cpus[index] != -1) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[index], &set);
+                ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+            }
+
+            int value;
+            do {
+                value = queues[index].pop();
+                queues[index + 1].push(value);
+            } while (value != -1);
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int value = 0; value < kCount; ++value) queues[0].push(value);
+    queues[0].push(-1);
+    while (queues.back().pop() != -1)
+        ;
+    std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+    for (auto& thread : threads) thread.join();
+    return kCount / elapsed.count();
+}
+
+void
+Test::testParseList()
+{
+    std::vector<int> ids;
+    assertTrue(CpuTopology::ParseList("0-3,8,10-11\n", ids));
+    assertEqual(size_t(7), ids.size());
+    assertEqual(3, ids[3]);
+    assertEqual(8, ids[4]);
+    assertEqual(11, ids[6]);
+
+    assertTrue(CpuTopology::ParseList("", ids));
+    assertTrue(ids.empty());
+
+    assertFalse(CpuTopology::ParseList("3-1", ids));
+    assertFalse(CpuTopology::ParseList("1,x", ids));
+    assertFalse(CpuTopology::ParseList("1:2", ids));
+}
+
+void
+Test::testTopology()
+{
+    // Two sockets, each its own node with one shared cache, and each with two cores of two threads. Processors
+    // 4 through 7 are the second threads of the cores of 0 through 3.
+    //
+    char tmp[] = "/tmp/CpuTopologyTest.XXXXXX";
+    std::string root(::mkdtemp(tmp));
+    Write(root, "/devices/system/cpu/online", "0-7");
+    for (int id = 0; id < 8; ++id) {
+        int package = (id / 2) % 2;
+        std::string cpu("/devices/system/cpu/cpu" + std::to_string(id) + "/");
+        Write(root, cpu + "topology/physical_package_id", std::to_string(package));
+        Write(root, cpu + "topology/core_id", std::to_string(id % 2));
+        Write(root, cpu + "topology/thread_siblings_list", std::to_string(id % 4) + "," + std::to_string(id % 4 + 4));
+        Write(root, cpu + "cache/index0/level", "1");
+        Write(root, cpu + "cache/index0/shared_cpu_list", std::to_string(id % 4) + "," + std::to_string(id % 4 + 4));
+        Write(root, cpu + "cache/index1/level", "3");
+        Write(root, cpu + "cache/index1/shared_cpu_list", package ? "2-3,6-7" : "0-1,4-5");
+    }
+
+    Write(root, "/devices/system/node/node0/cpulist", "0-1,4-5");
+    Write(root, "/devices/system/node/node1/cpulist", "2-3,6-7");
+    Write(root, "/class/net/eth1/device/numa_node", "1");
+
+    CpuTopology topology(root);
+    assertEqual(size_t(8), topology.getCpus().size());
+    const CpuTopology::Cpu* cpu = topology.find(6);
+    assertTrue(cpu != 0);
+    assertEqual(1, cpu->node);
+    assertEqual(1, cpu->package);
+    assertEqual(2, cpu->cache);
+    assertTrue(cpu->sibling);
+    assertFalse(topology.find(2)->sibling);
+    assertTrue(topology.find(8) == 0);
+
+    assertEqual(1, topology.getInterfaceNode("eth1"));
+    assertEqual(-1, topology.getInterfaceNode("eth0"));
+
+    // Cores first, then their siblings, one cache at a time.
+    //
+    std::vector<int> order(topology.getPipelineOrder());
+    int expected[] = {0, 1, 4, 5, 2, 3, 6, 7};
+    assertTrue(order == std::vector<int>(expected, expected + 8));
+
+    order = topology.getPipelineOrder(1);
+    int expected1[] = {2, 3, 6, 7, 0, 1, 4, 5};
+    assertTrue(order == std::vector<int>(expected1, expected1 + 8));
+
+    // A reader on node 1 starts the pipeline there. A later stage that wants node 0 skips ahead to it.
+    //
+    CpuPlacer placer(topology);
+    assertEqual(2, placer.next(1));
+    assertEqual(3, placer.next());
+    assertEqual(6, placer.next());
+    assertEqual(0, placer.next(0));
+    assertEqual(1, placer.next());
+
+    std::string command("rm -rf " + root);
+    assertEqual(0, ::system(command.c_str()));
+}
+
+void
+Test::testBenchmark()
+{
+    // Compare an 8 stage pipeline with no placement, with stages placed in pipeline order, and with adjacent
+    // stages placed as far apart as possible.
+    //
+    const CpuTopology& topology(CpuTopology::Instance());
+    std::vector<int> order(topology.getPipelineOrder());
+    size_t stages = 8;
+    std::vector<int> unpinned(stages, -1), placed, scattered;
+    for (size_t index = 0; index < stages; ++index) {
+        placed.push_back(order[index % order.size()]);
+        scattered.push_back(order[(index * (order.size() / 2 + 1)) % order.size()]);
+    }
+
+    std::clog << order.size() << " processors, " << stages << " stages\n"
+              << "unpinned: " << RunPipeline(unpinned) << " msgs/s\n"
+              << "pipeline order: " << RunPipeline(placed) << " msgs/s\n"
+              << "scattered: " << RunPipeline(scattered) << " msgs/s" << std::endl;
+}
+
+void
+Test::test()
+{
+    testParseList();
+    testTopology();
+    testBenchmark();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return Test().mainRun();
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <cmath>
+
+#include "HdrHistogram.h"
+
+using namespace Utils;
+
+HdrHistogram::HdrHistogram(int subBucketBits, int maxBits) :
+    subBucketBits_(subBucketBits), limit_((uint64_t(1) << maxBits) - 1), size_(getIndex(limit_) + 1),
+    counts_(new std::atomic<uint64_t>[size_]), total_(0), max_(0)
+{
+    reset();
+}
+
+void
+HdrHistogram::reset()
+{
+    for (size_t index = 0; index < size_; ++index) counts_[index].store(0, std::memory_order_relaxed);
+    total_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+size_t
+HdrHistogram::getIndex(uint64_t value) const
+{
+    if (value < (uint64_t(1) << subBucketBits_)) return value;
+
+    // Keep the top subBucketBits_ bits of the value. The shift is the bucket number, starting at 1.
+    //
+    int shift = 63 - __builtin_clzll(value) - (subBucketBits_ - 1);
+    size_t half = size_t(1) << (subBucketBits_ - 1);
+    return (half << 1) + (shift - 1) * half + ((value >> shift) - half);
+}
+
+uint64_t
+HdrHistogram::getHighestEquivalentValue(size_t index) const
+{
+    size_t half = size_t(1) << (subBucketBits_ - 1);
+    if (index < (half << 1)) return index;
+
+    index -= half << 1;
+    int shift = int(index / half) + 1;
+    uint64_t sub = index % half + half;
+    return ((sub + 1) << shift) - 1;
+}
+
+void
+HdrHistogram::record(int64_t value)
+{
+    if (value < 0) value = 0;
+    uint64_t clamped = std::min(uint64_t(value), limit_);
+    counts_[getIndex(clamped)].fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(1, std::memory_order_relaxed);
+
+    int64_t max = max_.load(std::memory_order_relaxed);
+    while (int64_t(clamped) > max && !max_.compare_exchange_weak(max, clamped, std::memory_order_relaxed))
+        ;
+}
+
+int64_t
+HdrHistogram::getValueAtPercentile(double percentile) const
+{
+    uint64_t total = getCount();
+    if (!total) return 0;
+
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t target = std::max(uint64_t(::ceil(percentile / 100.0 * total)), uint64_t(1));
+    uint64_t seen = 0;
+    for (size_t index = 0; index < size_; ++index) {
+        seen += counts_[index].load(std::memory_order_relaxed);
+        if (seen >= target) return std::min(int64_t(getHighestEquivalentValue(index)), getMax());
+    }
+
+    return getMax();
+}
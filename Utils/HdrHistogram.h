@@ -0,0 +1,73 @@
+#ifndef UTILS_HDRHISTOGRAM_H // -*- C++ -*-
+#define UTILS_HDRHISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Utils {
+
+/** High dynamic range histogram of non-negative integer values, such as latencies in nanoseconds. Values below
+    2^subBucketBits are counted exactly; above that, each power-of-two range is split into 2^(subBucketBits-1)
+    equal buckets, so the relative error of any percentile is at most 1 / 2^(subBucketBits-1). Recording takes a
+    few relaxed atomic operations and no locks, so any number of threads may record while another reads
+    percentiles. Readers get a snapshot good enough for reporting, not an exact one.
+*/
+class HdrHistogram {
+public:
+    /** Constructor.
+
+        \param subBucketBits number of bits of precision for each value. The default of 7 gives an error of
+        under 2%.
+
+        \param maxBits values at or above 2^maxBits count as 2^maxBits - 1. The default of 40 allows for over 18
+        minutes in nanoseconds.
+    */
+    HdrHistogram(int subBucketBits = 7, int maxBits = 40);
+
+    /** Add a value to the histogram. Negative values count as zero.
+
+        \param value the value to add
+    */
+    void record(int64_t value);
+
+    /** Forget all recorded values.
+     */
+    void reset();
+
+    /** \return number of values recorded
+     */
+    uint64_t getCount() const { return total_.load(std::memory_order_relaxed); }
+
+    /** \return largest value recorded, or 0 if none
+     */
+    int64_t getMax() const { return max_.load(std::memory_order_relaxed); }
+
+    /** Obtain the value below which a given percentage of the recorded values fall. The result is the highest
+        value that counts the same as the actual one, but never more than getMax().
+
+        \param percentile percentage to look for, from 0 to 100
+
+        \return value, or 0 if there are no values
+    */
+    int64_t getValueAtPercentile(double percentile) const;
+
+private:
+    size_t getIndex(uint64_t value) const;
+
+    uint64_t getHighestEquivalentValue(size_t index) const;
+
+    int subBucketBits_;
+    uint64_t limit_;
+    size_t size_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    std::atomic<uint64_t> total_;
+    std::atomic<int64_t> max_;
+};
+
+} // end namespace Utils
+
+/** \file
+ */
+
+#endif
@@ -0,0 +1,104 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "HdrHistogram.h"
+#include "UnitTest/UnitTest.h"
+
+using namespace Utils;
+
+struct Test : public UnitTest::TestObj {
+    Test() : UnitTest::TestObj("HdrHistogram") {}
+
+    void test();
+
+    void testExact();
+
+    void testPrecision();
+
+    void testThreads();
+};
+
+void
+Test::testExact()
+{
+    HdrHistogram histogram;
+    assertEqual(int64_t(0), histogram.getValueAtPercentile(50.0));
+
+    for (int value = 1; value <= 100; ++value) histogram.record(value);
+    assertEqual(uint64_t(100), histogram.getCount());
+    assertEqual(int64_t(100), histogram.getMax());
+    assertEqual(int64_t(1), histogram.getValueAtPercentile(0.0));
+    assertEqual(int64_t(50), histogram.getValueAtPercentile(50.0));
+    assertEqual(int64_t(99), histogram.getValueAtPercentile(99.0));
+    assertEqual(int64_t(100), histogram.getValueAtPercentile(100.0));
+
+    histogram.record(-5);
+    assertEqual(int64_t(0), histogram.getValueAtPercentile(0.0));
+
+    histogram.reset();
+    assertEqual(uint64_t(0), histogram.getCount());
+    assertEqual(int64_t(0), histogram.getMax());
+}
+
+void
+Test::testPrecision()
+{
+    // One value per microsecond up to a second, in nanoseconds. Every percentile is within 1/64 of the truth.
+    //
+    HdrHistogram histogram;
+    for (int64_t value = 1000; value <= 1000000000; value += 1000) histogram.record(value);
+
+    double percentiles[] = {50.0, 90.0, 99.0, 99.9};
+    for (double percentile : percentiles) {
+        double expected = percentile / 100.0 * 1000000000;
+        double found = histogram.getValueAtPercentile(percentile);
+        assertTrue(found >= expected - 1000);
+        assertTrue(found <= expected * (1.0 + 1.0 / 64));
+    }
+
+    assertEqual(int64_t(1000000000), histogram.getValueAtPercentile(100.0));
+
+    // Values past the limit count as the largest one.
+    //
+    HdrHistogram small(7, 20);
+    small.record(int64_t(1) << 30);
+    assertEqual(int64_t((1 << 20) - 1), small.getMax());
+}
+
+void
+Test::testThreads()
+{
+    enum { kThreads = 4, kCount = 250000 };
+    HdrHistogram histogram;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < kThreads; ++index) {
+        threads.emplace_back([&histogram, index]() {
+            for (int value = 0; value < kCount; ++value) histogram.record(value * (index + 1));
+        });
+    }
+
+    for (auto& thread : threads) thread.join();
+    std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+
+    assertEqual(uint64_t(kThreads * kCount), histogram.getCount());
+    assertEqual(int64_t((kCount - 1) * kThreads), histogram.getMax());
+    std::clog << "record: " << elapsed.count() / (kThreads * kCount) * 1E9 << " ns with " << kThreads << " threads"
+              << std::endl;
+}
+
+void
+Test::test()
+{
+    testExact();
+    testPrecision();
+    testThreads();
+}
+
+int
+main(int argc, const char* argv[])
+{
+    return Test().mainRun();
+}